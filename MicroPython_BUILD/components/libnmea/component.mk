@@ -12,6 +12,7 @@ PARSER_OBJS := $(addprefix src/parsers/,\
 COMPONENT_OBJS := $(addprefix src/,\
 		nmea/nmea.o \
 		nmea/parser_static.o \
+		nmea/nmea_stream.o \
 		parsers/parse.o \
 	) \
 	$(PARSER_OBJS)
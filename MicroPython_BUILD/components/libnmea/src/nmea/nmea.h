@@ -12,7 +12,9 @@ typedef enum {
 	NMEA_GLL,
 	NMEA_RMC,
 	NMEA_GST,
-	NMEA_VTG
+	NMEA_VTG,
+	NMEA_GSA,
+	NMEA_GSV
 } nmea_t;
 
 /* NMEA cardinal direction types */
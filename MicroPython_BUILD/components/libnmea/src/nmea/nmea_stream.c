@@ -0,0 +1,652 @@
+/*
+ * Streaming NMEA parser, LoBo (https://github.com/loboris)
+ *
+ * Parses NMEA sentences byte by byte into the fixed gps_data_t structure,
+ * without memory allocation and without building the sentence string.
+ */
+
+#include <string.h>
+#include "nmea_stream.h"
+
+/* Parser states */
+#define NMEA_ST_IDLE	0	// waiting for '$'
+#define NMEA_ST_DATA	1	// receiving sentence fields
+#define NMEA_ST_CHK1	2	// receiving 1st checksum digit
+#define NMEA_ST_CHK2	3	// receiving 2nd checksum digit
+#define NMEA_ST_END		4	// waiting for sentence end
+
+/* Sentence types known to the streaming parser */
+typedef struct {
+	const char *word;
+	nmea_t type;
+} nmea_stream_type_t;
+
+static const nmea_stream_type_t stream_types[] = {
+	{ "GGA", NMEA_GGA },
+	{ "RMC", NMEA_RMC },
+	{ "GLL", NMEA_GLL },
+	{ "VTG", NMEA_VTG },
+	{ "GST", NMEA_GST },
+	{ "GSA", NMEA_GSA },
+	{ "GSV", NMEA_GSV },
+};
+
+/* Days before the month, non leap year */
+static const uint16_t days_before_month[12] = {0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334};
+
+
+/**
+ * Parse unsigned decimal number with optional fractional part.
+ * Only the digits are accepted, no exponent.
+ *
+ * Returns 0 on success, otherwise -1.
+ */
+//--------------------------------------------------------------------------
+static int _parse_decimal(const char *s, uint32_t *ip, uint32_t *fp, uint32_t *div)
+{
+	int digits = 0;
+
+	*ip = 0;
+	*fp = 0;
+	*div = 1;
+	while ((*s >= '0') && (*s <= '9')) {
+		*ip = (*ip * 10) + (*s++ - '0');
+		digits++;
+	}
+	if (*s == '.') {
+		s++;
+		while ((*s >= '0') && (*s <= '9')) {
+			// ignore the digits which do not fit
+			if (*div < 100000000) {
+				*fp = (*fp * 10) + (*s - '0');
+				*div *= 10;
+			}
+			s++;
+			digits++;
+		}
+	}
+	if ((*s != '\0') || (digits == 0)) return -1;
+	return 0;
+}
+
+//--------------------------------------------------
+static int _parse_float(const char *s, float *value)
+{
+	uint32_t ip, fp, div;
+	int neg = 0;
+
+	if (*s == '-') {
+		neg = 1;
+		s++;
+	}
+	if (_parse_decimal(s, &ip, &fp, &div) < 0) return -1;
+	*value = (float)ip + ((float)fp / (float)div);
+	if (neg) *value = -*value;
+	return 0;
+}
+
+//----------------------------------------------
+static int _parse_int(const char *s, int *value)
+{
+	uint32_t ip, fp, div;
+	int neg = 0;
+
+	if (*s == '-') {
+		neg = 1;
+		s++;
+	}
+	if (_parse_decimal(s, &ip, &fp, &div) < 0) return -1;
+	*value = (neg) ? -(int)ip : (int)ip;
+	return 0;
+}
+
+/**
+ * Parse position in NMEA format (dddmm.mmmm) to degrees
+ */
+//--------------------------------------------------------
+static int _parse_position(const char *s, double *degrees)
+{
+	uint32_t ip, fp, div;
+
+	if (_parse_decimal(s, &ip, &fp, &div) < 0) return -1;
+	// minutes are the last two integer digits and the fractional part
+	*degrees = (double)(ip / 100) + (((double)(ip % 100) + ((double)fp / (double)div)) / 60.0);
+	return 0;
+}
+
+/**
+ * Parse two decimal digits
+ */
+//-------------------------------
+static int _two_digits(const char *s)
+{
+	if ((s[0] < '0') || (s[0] > '9') || (s[1] < '0') || (s[1] > '9')) return -1;
+	return ((s[0] - '0') * 10) + (s[1] - '0');
+}
+
+/**
+ * Parse time "hhmmss[.sss]"
+ */
+//-----------------------------------------------------
+static int _parse_time(const char *s, struct tm *time)
+{
+	int h = _two_digits(s);
+	if (h < 0) return -1;
+	int m = _two_digits(s+2);
+	if (m < 0) return -1;
+	int sec = _two_digits(s+4);
+	if (sec < 0) return -1;
+	if ((h > 23) || (m > 59) || (sec > 60)) return -1;
+
+	time->tm_hour = h;
+	time->tm_min = m;
+	time->tm_sec = sec;
+	return 0;
+}
+
+/**
+ * Parse date "ddmmyy", also sets day of week and day of year
+ */
+//-----------------------------------------------------
+static int _parse_date(const char *s, struct tm *time)
+{
+	static const int wday_offset[12] = {0, 3, 2, 5, 0, 3, 5, 1, 4, 6, 2, 4};
+
+	int d = _two_digits(s);
+	if (d < 1) return -1;
+	int m = _two_digits(s+2);
+	if ((m < 1) || (m > 12)) return -1;
+	int y = _two_digits(s+4);
+	if ((y < 0) || (s[6] != '\0')) return -1;
+
+	// the same rule as strptime's %y: 69-99 -> 19xx, 00-68 -> 20xx
+	y += (y < 69) ? 2000 : 1900;
+	int leap = (((y % 4) == 0) && ((y % 100) != 0)) || ((y % 400) == 0);
+
+	time->tm_mday = d;
+	time->tm_mon = m - 1;
+	time->tm_year = y - 1900;
+	time->tm_yday = days_before_month[m-1] + d - 1 + (((m > 2) && leap) ? 1 : 0);
+	if (m < 3) y--;
+	time->tm_wday = (y + y/4 - y/100 + y/400 + wday_offset[m-1] + d) % 7;
+	return 0;
+}
+
+//---------------------------------
+static int _hex_digit(char c)
+{
+	if ((c >= '0') && (c <= '9')) return c - '0';
+	if ((c >= 'A') && (c <= 'F')) return c - 'A' + 10;
+	if ((c >= 'a') && (c <= 'f')) return c - 'a' + 10;
+	return -1;
+}
+
+/**
+ * Get the satellite system from the talker id
+ */
+//-----------------------------------------------
+static uint8_t _get_system(const char *talker)
+{
+	if (talker[0] == 'G') {
+		if (talker[1] == 'P') return NMEA_SYSTEM_GPS;
+		if (talker[1] == 'L') return NMEA_SYSTEM_GLONASS;
+		if (talker[1] == 'A') return NMEA_SYSTEM_GALILEO;
+		if (talker[1] == 'B') return NMEA_SYSTEM_BEIDOU;
+	}
+	else if ((talker[0] == 'B') && (talker[1] == 'D')) return NMEA_SYSTEM_BEIDOU;
+	// GN (combined) and others
+	return NMEA_SYSTEM_UNKNOWN;
+}
+
+/**
+ * Parse the address field, returns the sentence type
+ */
+//-----------------------------------------------------
+static nmea_t _parse_address(nmea_stream_t *st)
+{
+	if (st->flen != 5) return NMEA_UNKNOWN;
+
+	for (size_t i=0; i<(sizeof(stream_types) / sizeof(stream_types[0])); i++) {
+		if (memcmp(st->field+2, stream_types[i].word, 3) == 0) {
+			st->system = _get_system(st->field);
+			return stream_types[i].type;
+		}
+	}
+	return NMEA_UNKNOWN;
+}
+
+/**
+ * Parse the received field into the pending values
+ *
+ * Returns 0 on success, otherwise -1.
+ */
+//--------------------------------------------
+static int _parse_field(nmea_stream_t *st)
+{
+	nmea_pending_t *p = &st->p;
+	const char *s = st->field;
+	int idx = st->field_idx;
+	int ival;
+
+	// empty field, keep the default
+	if (st->flen == 0) return 0;
+
+	switch (st->type) {
+	case NMEA_GGA:
+		switch (idx) {
+		case 1: if (_parse_time(s, &p->time) < 0) return -1; p->has_time = 1; break;
+		case 2: if (_parse_position(s, &p->latitude) < 0) return -1; p->has_position |= 1; break;
+		case 3: p->lat_cardinal = *s; break;
+		case 4: if (_parse_position(s, &p->longitude) < 0) return -1; p->has_position |= 2; break;
+		case 5: p->lon_cardinal = *s; break;
+		case 6: if (_parse_int(s, &ival) < 0) return -1; p->quality = ival; break;
+		case 7: if (_parse_int(s, &ival) < 0) return -1; p->nsat = ival; break;
+		case 8: return _parse_float(s, &p->hdop);
+		case 9: return _parse_float(s, &p->altitude);
+		case 11: return _parse_float(s, &p->geoid_sep);
+		default: break;
+		}
+		break;
+
+	case NMEA_RMC:
+		switch (idx) {
+		case 1: if (_parse_time(s, &p->time) < 0) return -1; p->has_time = 1; break;
+		case 2: p->status = *s; break;
+		case 3: if (_parse_position(s, &p->latitude) < 0) return -1; p->has_position |= 1; break;
+		case 4: p->lat_cardinal = *s; break;
+		case 5: if (_parse_position(s, &p->longitude) < 0) return -1; p->has_position |= 2; break;
+		case 6: p->lon_cardinal = *s; break;
+		case 7: return _parse_float(s, &p->speed_kn);
+		case 8: return _parse_float(s, &p->course);
+		case 9: if (_parse_date(s, &p->time) < 0) return -1; p->has_date = 1; break;
+		default: break;
+		}
+		break;
+
+	case NMEA_GLL:
+		switch (idx) {
+		case 1: if (_parse_position(s, &p->latitude) < 0) return -1; p->has_position |= 1; break;
+		case 2: p->lat_cardinal = *s; break;
+		case 3: if (_parse_position(s, &p->longitude) < 0) return -1; p->has_position |= 2; break;
+		case 4: p->lon_cardinal = *s; break;
+		case 5: if (_parse_time(s, &p->time) < 0) return -1; p->has_time = 1; break;
+		case 6: p->status = *s; break;
+		default: break;
+		}
+		break;
+
+	case NMEA_VTG:
+		switch (idx) {
+		case 1: return _parse_float(s, &p->course);
+		case 5: return _parse_float(s, &p->speed_kn);
+		case 7: return _parse_float(s, &p->speed_kmh);
+		default: break;
+		}
+		break;
+
+	case NMEA_GST:
+		if (idx == 1) {
+			if (_parse_time(s, &p->time) < 0) return -1;
+			p->has_time = 1;
+		}
+		else if ((idx >= 2) && (idx <= 8)) return _parse_float(s, &p->gst[idx-2]);
+		break;
+
+	case NMEA_GSA:
+		if (idx == 2) {
+			if (_parse_int(s, &ival) < 0) return -1;
+			p->fix_type = ival;
+		}
+		else if ((idx >= 3) && (idx <= 14)) {
+			if (_parse_int(s, &ival) < 0) return -1;
+			if (p->n_prn < NMEA_MAX_SATS_USED) p->prn[p->n_prn++] = ival;
+		}
+		else if (idx == 15) return _parse_float(s, &p->pdop);
+		else if (idx == 16) return _parse_float(s, &p->hdop);
+		else if (idx == 17) return _parse_float(s, &p->vdop);
+		else if (idx == 18) {
+			// NMEA 4.10 system id: 1 GPS, 2 GLONASS, 3 Galileo, 4 BeiDou
+			if (_parse_int(s, &ival) < 0) return -1;
+			if ((ival >= 1) && (ival <= NMEA_SYSTEMS)) p->gsa_system = ival - 1;
+		}
+		break;
+
+	case NMEA_GSV:
+		if (_parse_int(s, &ival) < 0) return -1;
+		if (idx == 1) p->gsv_total = ival;
+		else if (idx == 2) p->gsv_num = ival;
+		else if (idx == 3) p->gsv_in_view = ival;
+		else if (idx >= 4) {
+			int n = (idx - 4) / 4;
+			if (n >= 4) break;
+			nmea_sat_t *sat = &p->gsv[n];
+			switch ((idx - 4) % 4) {
+			case 0:
+				sat->prn = ival;
+				sat->elevation = 0;
+				sat->azimuth = 0;
+				sat->snr = -1;
+				if (p->gsv_n <= n) p->gsv_n = n + 1;
+				break;
+			case 1: sat->elevation = ival; break;
+			case 2: sat->azimuth = ival; break;
+			case 3: sat->snr = ival; break;
+			}
+		}
+		break;
+
+	default:
+		break;
+	}
+	return 0;
+}
+
+/**
+ * Field received, parse it
+ */
+//------------------------------------------
+static void _field_end(nmea_stream_t *st)
+{
+	st->field[st->flen] = '\0';
+	if (st->field_idx == 0) {
+		st->type = _parse_address(st);
+	}
+	else if (st->field_err == 0) {
+		if (_parse_field(st) < 0) st->field_err = 1;
+	}
+	st->field_idx++;
+	st->flen = 0;
+}
+
+//--------------------------------------------------------
+static void _set_position(nmea_stream_t *st, gps_data_t *d)
+{
+	nmea_pending_t *p = &st->p;
+
+	if (p->has_position & 1) {
+		d->latitude = (float)((p->lat_cardinal == NMEA_CARDINAL_DIR_SOUTH) ? -p->latitude : p->latitude);
+	}
+	if (p->has_position & 2) {
+		d->longitude = (float)((p->lon_cardinal == NMEA_CARDINAL_DIR_WEST) ? -p->longitude : p->longitude);
+	}
+}
+
+//----------------------------------------------------
+static void _set_time(nmea_stream_t *st, gps_data_t *d)
+{
+	if (st->p.has_time) {
+		d->datetime.tm_hour = st->p.time.tm_hour;
+		d->datetime.tm_min = st->p.time.tm_min;
+		d->datetime.tm_sec = st->p.time.tm_sec;
+	}
+}
+
+/**
+ * Valid sentence received, store the pending values to gps data
+ *
+ * Returns 0 if the values were stored, -1 if the sentence was ignored.
+ */
+//-------------------------------------------
+static int _commit(nmea_stream_t *st)
+{
+	nmea_pending_t *p = &st->p;
+	gps_data_t *d = st->data;
+
+	switch (st->type) {
+	case NMEA_GGA:
+		d->nsat = p->nsat;
+		d->quality = p->quality;
+		if ((p->nsat > 0) && (p->quality > 0)) {
+			d->altitude = p->altitude;
+			d->geoid_sep = p->geoid_sep;
+			d->dop = p->hdop;
+			_set_position(st, d);
+			_set_time(st, d);
+		}
+		break;
+
+	case NMEA_RMC:
+		d->valid = (p->status == 'A');
+		if (d->valid) {
+			d->speed = p->speed_kn * 1.85200; // knots -> km/h
+			d->course = p->course;
+			_set_position(st, d);
+			if (p->has_date) {
+				if (!p->has_time) {
+					p->time.tm_hour = d->datetime.tm_hour;
+					p->time.tm_min = d->datetime.tm_min;
+					p->time.tm_sec = d->datetime.tm_sec;
+				}
+				memcpy(&d->datetime, &p->time, sizeof(struct tm));
+			}
+			else _set_time(st, d);
+		}
+		break;
+
+	case NMEA_GLL:
+		d->valid = (p->status == 'A');
+		if (d->valid) {
+			_set_position(st, d);
+			_set_time(st, d);
+		}
+		break;
+
+	case NMEA_VTG:
+		d->speed = p->speed_kmh;
+		d->course = p->course;
+		break;
+
+	case NMEA_GST:
+		d->rms = p->gst[0];
+		d->sd_major = p->gst[1];
+		d->sd_minor = p->gst[2];
+		d->orient = p->gst[3];
+		d->lat_sd = p->gst[4];
+		d->lon_sd = p->gst[5];
+		d->alt_sd = p->gst[6];
+		break;
+
+	case NMEA_GSA: {
+			uint8_t sys = (p->gsa_system >= 0) ? p->gsa_system : st->system;
+			d->fix_type = p->fix_type;
+			d->pdop = p->pdop;
+			d->vdop = p->vdop;
+			if (sys == NMEA_SYSTEM_UNKNOWN) {
+				d->n_used_unknown = p->n_prn;
+				memcpy(d->used_unknown, p->prn, p->n_prn);
+			}
+			else {
+				d->n_used[sys] = p->n_prn;
+				memcpy(d->used[sys], p->prn, p->n_prn);
+			}
+		}
+		break;
+
+	case NMEA_GSV: {
+			uint8_t sys = st->system;
+			// satellites are stored per system
+			if (sys == NMEA_SYSTEM_UNKNOWN) return -1;
+			if ((p->gsv_num == 0) || (p->gsv_num > p->gsv_total)) return -1;
+			if (p->gsv_num == 1) {
+				// start of the new GSV sequence
+				st->gsv_count[sys] = 0;
+				st->gsv_next[sys] = 1;
+			}
+			if (p->gsv_num != st->gsv_next[sys]) {
+				// message missed, wait for the next sequence
+				st->gsv_next[sys] = 0;
+				return -1;
+			}
+			// the last field may be the NMEA 4.10 signal id, not a satellite
+			int expected = p->gsv_in_view - ((p->gsv_num - 1) * 4);
+			if (expected > 4) expected = 4;
+			if (p->gsv_n > expected) p->gsv_n = (expected > 0) ? expected : 0;
+			for (int i=0; i<p->gsv_n; i++) {
+				if (st->gsv_count[sys] >= NMEA_MAX_SATS) break;
+				st->gsv_sats[sys][st->gsv_count[sys]++] = p->gsv[i];
+			}
+			st->gsv_next[sys]++;
+			if (p->gsv_num < p->gsv_total) return -1;
+			// last message, store the complete list
+			d->in_view[sys] = p->gsv_in_view;
+			d->n_sats[sys] = st->gsv_count[sys];
+			memcpy(d->sats[sys], st->gsv_sats[sys], st->gsv_count[sys] * sizeof(nmea_sat_t));
+			st->gsv_next[sys] = 0;
+		}
+		break;
+
+	default:
+		return -1;
+	}
+
+	d->updated |= (1 << st->type);
+	return 0;
+}
+
+/**
+ * Sentence end received
+ */
+//----------------------------------------------
+static nmea_t _sentence_end(nmea_stream_t *st)
+{
+	st->state = NMEA_ST_IDLE;
+
+	if ((st->check_checksum) && (st->has_chk) && (st->chk != st->rx_chk)) {
+		st->chk_errors++;
+		return NMEA_UNKNOWN;
+	}
+	if (st->field_err) {
+		st->errors++;
+		return NMEA_UNKNOWN;
+	}
+	st->sentences++;
+	if (_commit(st) < 0) return NMEA_UNKNOWN;
+	return st->type;
+}
+
+//---------------------------------------------------------------------------
+void nmea_stream_init(nmea_stream_t *st, gps_data_t *data, int check_checksum)
+{
+	memset(st, 0, sizeof(nmea_stream_t));
+	st->data = data;
+	st->check_checksum = check_checksum;
+	st->state = NMEA_ST_IDLE;
+}
+
+//-----------------------------------------------------
+nmea_t nmea_stream_putc(nmea_stream_t *st, char c)
+{
+	int hex;
+
+	if (c == '$') {
+		if (st->state != NMEA_ST_IDLE) st->errors++;	// previous sentence not finished
+		// start of the new sentence
+		st->state = NMEA_ST_DATA;
+		st->chk = 0;
+		st->has_chk = 0;
+		st->len = 1;
+		st->flen = 0;
+		st->field_idx = 0;
+		st->field_err = 0;
+		st->type = NMEA_UNKNOWN;
+		memset(&st->p, 0, sizeof(nmea_pending_t));
+		st->p.gsa_system = -1;
+		return NMEA_UNKNOWN;
+	}
+
+	switch (st->state) {
+	case NMEA_ST_DATA:
+		if ((c == NMEA_END_CHAR_1) || (c == NMEA_END_CHAR_2)) {
+			// sentence without checksum
+			_field_end(st);
+			if (st->type == NMEA_UNKNOWN) {
+				st->state = NMEA_ST_IDLE;
+				st->ignored++;
+				return NMEA_UNKNOWN;
+			}
+			return _sentence_end(st);
+		}
+		if (++st->len > NMEA_MAX_LENGTH) {
+			// sentence too long
+			st->state = NMEA_ST_IDLE;
+			st->errors++;
+			return NMEA_UNKNOWN;
+		}
+		if (c == '*') {
+			_field_end(st);
+			st->state = NMEA_ST_CHK1;
+			return NMEA_UNKNOWN;
+		}
+		if ((c < ' ') || (c > '~')) {
+			// not allowed character
+			st->state = NMEA_ST_IDLE;
+			st->errors++;
+			return NMEA_UNKNOWN;
+		}
+		st->chk ^= (uint8_t)c;
+		if (c == ',') {
+			_field_end(st);
+			if ((st->field_idx == 1) && (st->type == NMEA_UNKNOWN)) {
+				// not supported sentence, skip it
+				st->state = NMEA_ST_IDLE;
+				st->ignored++;
+			}
+		}
+		else if (st->flen < NMEA_FIELD_MAX) st->field[st->flen++] = c;
+		else st->field_err = 1;
+		break;
+
+	case NMEA_ST_CHK1:
+		hex = _hex_digit(c);
+		if (hex < 0) {
+			st->state = NMEA_ST_IDLE;
+			st->errors++;
+			break;
+		}
+		st->rx_chk = hex << 4;
+		st->state = NMEA_ST_CHK2;
+		break;
+
+	case NMEA_ST_CHK2:
+		hex = _hex_digit(c);
+		if (hex < 0) {
+			st->state = NMEA_ST_IDLE;
+			st->errors++;
+			break;
+		}
+		st->rx_chk |= hex;
+		st->has_chk = 1;
+		st->state = NMEA_ST_END;
+		break;
+
+	case NMEA_ST_END:
+		if ((c == NMEA_END_CHAR_1) || (c == NMEA_END_CHAR_2)) {
+			if (st->type == NMEA_UNKNOWN) {
+				st->state = NMEA_ST_IDLE;
+				st->ignored++;
+				return NMEA_UNKNOWN;
+			}
+			return _sentence_end(st);
+		}
+		// garbage after the checksum
+		st->state = NMEA_ST_IDLE;
+		st->errors++;
+		break;
+
+	default:
+		break;
+	}
+	return NMEA_UNKNOWN;
+}
+
+//---------------------------------------------------------------------------
+uint32_t nmea_stream_feed(nmea_stream_t *st, const uint8_t *buf, size_t len)
+{
+	uint32_t mask = 0;
+
+	for (size_t i=0; i<len; i++) {
+		nmea_t type = nmea_stream_putc(st, (char)buf[i]);
+		if (type != NMEA_UNKNOWN) mask |= (1 << type);
+	}
+	return mask;
+}
@@ -0,0 +1,174 @@
+#ifndef INC_NMEA_STREAM_H
+#define INC_NMEA_STREAM_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <time.h>
+#include "nmea.h"
+
+/*
+ * Streaming NMEA parser
+ *
+ * The received bytes are fed to the parser one at a time (or in chunks),
+ * the sentence is parsed field by field while it is received and the
+ * checksum is calculated on the fly. When a complete sentence with the
+ * valid checksum is received, the parsed values are stored into the
+ * gps_data_t structure. No memory is allocated.
+ */
+
+/* Satellite systems, used to index GSA/GSV data */
+#define NMEA_SYSTEM_GPS		0
+#define NMEA_SYSTEM_GLONASS	1
+#define NMEA_SYSTEM_GALILEO	2
+#define NMEA_SYSTEM_BEIDOU	3
+#define NMEA_SYSTEMS		4
+/* Combined (GN) or other talker, the system is not known */
+#define NMEA_SYSTEM_UNKNOWN	0xff
+
+/* Maximum number of satellites in view stored per system */
+#define NMEA_MAX_SATS		20
+/* Maximum number of satellites used in fix (GSA) */
+#define NMEA_MAX_SATS_USED	12
+/* Maximum length of the single sentence field */
+#define NMEA_FIELD_MAX		15
+
+/* Satellite in view (GSV) */
+typedef struct {
+	uint8_t prn;
+	int8_t elevation;	// degrees
+	uint16_t azimuth;	// degrees
+	int8_t snr;			// dB, -1 if not tracked
+} nmea_sat_t;
+
+/* Parsed GPS data */
+typedef struct {
+	struct tm datetime;
+	float latitude;		// degrees, negative for South
+	float longitude;	// degrees, negative for West
+	float altitude;		// meters above mean sea level
+	float geoid_sep;	// height of geoid above WGS84 ellipsoid
+	float speed;		// km/h
+	float course;		// degrees, true
+	float dop;			// horizontal dilution of precision
+	float pdop;
+	float vdop;
+	uint8_t quality;	// GGA fix quality
+	uint8_t nsat;		// number of satellites used (GGA)
+	uint8_t fix_type;	// GSA fix type, 1: no fix, 2: 2D, 3: 3D
+	uint8_t valid;		// RMC/GLL status
+	/* GST, position error statistics */
+	float rms;
+	float sd_major;
+	float sd_minor;
+	float orient;
+	float lat_sd;
+	float lon_sd;
+	float alt_sd;
+	/* GSA, satellites used in fix */
+	uint8_t n_used[NMEA_SYSTEMS];
+	uint8_t used[NMEA_SYSTEMS][NMEA_MAX_SATS_USED];
+	/* GSA of the unknown system (GN talker without system id) */
+	uint8_t n_used_unknown;
+	uint8_t used_unknown[NMEA_MAX_SATS_USED];
+	/* GSV, satellites in view */
+	uint8_t in_view[NMEA_SYSTEMS];
+	uint8_t n_sats[NMEA_SYSTEMS];
+	nmea_sat_t sats[NMEA_SYSTEMS][NMEA_MAX_SATS];
+	/* bit mask (1 << nmea_t) of the sentence types received */
+	uint32_t updated;
+} gps_data_t;
+
+/* Values of the sentence being received, committed on valid checksum */
+typedef struct {
+	double latitude;
+	double longitude;
+	struct tm time;
+	uint8_t has_time;
+	uint8_t has_date;
+	uint8_t has_position;
+	char lat_cardinal;
+	char lon_cardinal;
+	char status;
+	uint8_t quality;
+	uint8_t nsat;
+	float altitude;
+	float geoid_sep;
+	float speed_kn;
+	float speed_kmh;
+	float course;
+	float hdop;
+	float pdop;
+	float vdop;
+	float gst[7];		// rms, sd_major, sd_minor, orient, lat_sd, lon_sd, alt_sd
+	/* GSA */
+	uint8_t fix_type;
+	uint8_t n_prn;
+	uint8_t prn[NMEA_MAX_SATS_USED];
+	int8_t gsa_system;
+	/* GSV */
+	uint8_t gsv_total;
+	uint8_t gsv_num;
+	uint8_t gsv_in_view;
+	uint8_t gsv_n;
+	nmea_sat_t gsv[4];
+} nmea_pending_t;
+
+/* Parser state */
+typedef struct {
+	gps_data_t *data;
+	int check_checksum;
+	uint8_t state;
+	uint8_t chk;			// calculated checksum
+	uint8_t rx_chk;			// received checksum
+	uint8_t has_chk;
+	uint8_t len;			// sentence length
+	uint8_t flen;			// current field length
+	uint8_t field_idx;		// current field index, 0 is the address field
+	uint8_t field_err;
+	nmea_t type;
+	uint8_t system;
+	char field[NMEA_FIELD_MAX+1];
+	nmea_pending_t p;
+	/* GSV sequence in progress, committed after the last message */
+	uint8_t gsv_next[NMEA_SYSTEMS];
+	uint8_t gsv_count[NMEA_SYSTEMS];
+	nmea_sat_t gsv_sats[NMEA_SYSTEMS][NMEA_MAX_SATS];
+	/* Statistics */
+	uint32_t sentences;		// valid sentences parsed
+	uint32_t chk_errors;	// sentences with wrong checksum
+	uint32_t errors;		// malformed sentences
+	uint32_t ignored;		// valid, but unsupported sentences
+} nmea_stream_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Initialize the streaming parser.
+ *
+ * data is the structure the parsed values will be stored to.
+ * check_checksum, if 1 and the sentence has a checksum, validate it.
+ */
+extern void nmea_stream_init(nmea_stream_t *st, gps_data_t *data, int check_checksum);
+
+/**
+ * Feed one character to the parser.
+ *
+ * Returns the type of the sentence stored to gps data (nmea_t) when the
+ * sentence is completed, otherwise NMEA_UNKNOWN.
+ */
+extern nmea_t nmea_stream_putc(nmea_stream_t *st, char c);
+
+/**
+ * Feed the buffer to the parser.
+ *
+ * Returns the bit mask (1 << nmea_t) of the sentence types stored to gps data.
+ */
+extern uint32_t nmea_stream_feed(nmea_stream_t *st, const uint8_t *buf, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* INC_NMEA_STREAM_H */
@@ -182,6 +182,7 @@ SRC_C =  $(addprefix esp32/,\
 	machine_neopixel.c \
 	machine_dht.c \
 	machine_ow.c \
+	machine_sensors.c \
 	)
 
 ifdef CONFIG_MICROPY_USE_DISPLAY
@@ -235,6 +236,8 @@ endif
 
 EXTMOD_SRC_C = $(addprefix extmod/,\
 	modbtree.c \
+	framebuf_blit.c \
+	timerwheel.c \
 	)
 
 LIB_SRC_C = $(addprefix lib/,\
@@ -249,6 +252,7 @@ LIB_SRC_C = $(addprefix lib/,\
 LIBS_SRC_C = $(addprefix esp32/libs/,\
 	espcurl.c \
 	neopixel.c \
+	np_encode.c \
 	esp_rmt.c \
 	telnet.c \
 	ftp.c \
@@ -259,6 +263,10 @@ LIBS_SRC_C = $(addprefix esp32/libs/,\
 	ow/owb.c \
 	ow/ds18b20.c \
 	littleflash.c \
+	uart_ringbuf.c \
+	adc_stream.c \
+	sensor_sched.c \
+	spi_queue.c \
 	)
 
 ifdef CONFIG_MICROPY_USE_TFT
@@ -266,6 +274,7 @@ LIBS_SRC_C += \
 	esp32/moddisplay_tft.c \
 	esp32/libs/tft/tftspi.c \
 	esp32/libs/tft/tft.c \
+	esp32/libs/tft/tft_geom.c \
 	esp32/libs/tft/comic24.c \
 	esp32/libs/tft/DefaultFont.c \
 	esp32/libs/tft/DejaVuSans18.c \
@@ -280,6 +289,7 @@ endif
 ifdef CONFIG_MICROPY_USE_EVE
 LIBS_SRC_C += \
 	esp32/libs/eve/FT8_commands.c \
+	esp32/libs/eve/eve_dlist.c \
 	esp32/moddisplay_eve.c
 endif
 
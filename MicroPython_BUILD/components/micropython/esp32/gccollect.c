@@ -37,6 +37,60 @@
 #include "gccollect.h"
 #include "soc/cpu.h"
 #include "xtensa/hal.h"
+#include "esp_heap_caps.h"
+
+#if MICROPY_EMIT_NATIVE
+// Native code is executed from IRAM, which can only be accessed with 32-bit loads and stores.
+// The raw code and the function objects keep the IRAM address of the code and the pointer
+// to its heap copy, from which the data embedded in the code (the prelude, constant table)
+// is read and which keeps the objects the code refers to alive. The IRAM block is owned by
+// the heap copy and is freed by gc_collect when the heap copy is no longer reachable.
+typedef struct _native_code_block_t {
+    struct _native_code_block_t *next;
+    const void *data;
+    uint32_t code[];
+} native_code_block_t;
+
+static native_code_block_t *native_code_blocks = NULL;
+
+//-------------------------------------------------
+void *esp_native_code_commit(void *buf, size_t len)
+{
+    size_t n_words = (len + 3) / 4;
+    native_code_block_t *blk = heap_caps_malloc(sizeof(native_code_block_t) + n_words * 4, MALLOC_CAP_EXEC | MALLOC_CAP_32BIT);
+    if (blk == NULL) {
+        m_malloc_fail(len);
+    }
+    const byte *src = buf;
+    for (size_t i = 0; i < n_words; i++, src += 4) {
+        uint32_t w = 0;
+        for (size_t j = 0; (j < 4) && ((i * 4 + j) < len); j++) {
+            w |= (uint32_t)src[j] << (j * 8);
+        }
+        blk->code[i] = w;
+    }
+    blk->data = buf;
+    blk->next = native_code_blocks;
+    native_code_blocks = blk;
+    return blk->code;
+}
+
+// Free the IRAM blocks whose heap copies are about to be swept
+//-----------------------------------------
+static void esp_native_code_collect(void)
+{
+    native_code_block_t **prev = &native_code_blocks;
+    while (*prev != NULL) {
+        native_code_block_t *blk = *prev;
+        if (gc_collect_is_marked(blk->data)) {
+            prev = &blk->next;
+        } else {
+            *prev = blk->next;
+            heap_caps_free(blk);
+        }
+    }
+}
+#endif
 
 static int n_marked;
 
@@ -92,6 +146,11 @@ void gc_collect(int flag)
 		mp_thread_mutex_lock(&(mp_state_ctx.mem.gc_mutex), 1);
     }
 
+	#if MICROPY_EMIT_NATIVE
+	// All roots are traced, release the native code which is no longer used
+	esp_native_code_collect();
+	#endif
+
 	n_marked = MP_STATE_MEM(gc_marked);
 
 	gc_collect_end();
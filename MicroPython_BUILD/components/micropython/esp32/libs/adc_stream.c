@@ -0,0 +1,171 @@
+/*
+ * This file is part of the MicroPython ESP32 project, https://github.com/loboris/MicroPython_ESP32_psRAM_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <string.h>
+
+#include "adc_stream.h"
+
+// Block index to the ring slot
+//-----------------------------------------------------------------
+static inline uint32_t _slot(adc_stream_t *st, uint32_t idx)
+{
+    return (idx >= st->nblocks) ? idx - st->nblocks : idx;
+}
+
+// Next block index, modulo 2*nblocks
+//-----------------------------------------------------------------
+static inline uint32_t _next(adc_stream_t *st, uint32_t idx)
+{
+    return (++idx >= (2 * st->nblocks)) ? 0 : idx;
+}
+
+//-------------------------------------------------------------------------------------------------------------------
+int adc_stream_init(adc_stream_t *st, uint8_t *mem, adc_block_info_t *info, uint32_t nblocks, uint32_t block_len,
+                    uint8_t sample_size, uint8_t val_shift, uint16_t decimate, uint8_t average)
+{
+    if ((mem == NULL) || (info == NULL) || (nblocks < 2) || (nblocks > (UINT32_MAX / 2)) || (block_len == 0)) return -1;
+    if ((sample_size != 1) && (sample_size != 2)) return -1;
+    if (decimate == 0) decimate = 1;
+
+    memset(st, 0, sizeof(adc_stream_t));
+    st->mem = mem;
+    st->info = info;
+    st->nblocks = nblocks;
+    st->block_len = block_len;
+    st->sample_mask = 0x0fff;
+    st->sample_size = sample_size;
+    st->val_shift = val_shift;
+    st->decimate = decimate;
+    st->average = (average && (decimate > 1)) ? 1 : 0;
+    return 0;
+}
+
+// Commit the block being filled
+//------------------------------------------------------
+static void _commit_block(adc_stream_t *st, uint32_t len)
+{
+    uint32_t iput = st->iput;
+    adc_block_info_t *info = st->info + _slot(st, iput);
+    info->seq = st->seq;
+    info->len = len;
+    info->timestamp = st->block_ts;
+    __atomic_store_n(&st->iput, _next(st, iput), __ATOMIC_RELEASE);
+    st->seq++;
+    st->blocks++;
+    st->fill = 0;
+}
+
+// Store one output sample, returns 1 if the block was completed
+//-------------------------------------------------------------------
+static int _store_sample(adc_stream_t *st, uint32_t val, uint64_t ts)
+{
+    if (st->skip) {
+        // overrun, dropping the block
+        st->skip--;
+        st->dropped++;
+        return 0;
+    }
+    if (st->fill == 0) {
+        // starting new block, check if the free one is available
+        if (adc_stream_pending(st) >= st->nblocks) {
+            st->overruns++;
+            st->seq++;
+            st->skip = st->block_len - 1;
+            st->dropped++;
+            return 0;
+        }
+        st->block_ts = ts;
+    }
+
+    uint32_t offset = _slot(st, st->iput) * st->block_len + st->fill;
+    val >>= st->val_shift;
+    if (st->sample_size == 1) st->mem[offset] = (uint8_t)val;
+    else ((uint16_t *)st->mem)[offset] = (uint16_t)val;
+
+    if (++st->fill >= st->block_len) {
+        _commit_block(st, st->block_len);
+        return 1;
+    }
+    return 0;
+}
+
+//------------------------------------------------------------------------------------------------
+int adc_stream_put(adc_stream_t *st, const uint16_t *raw, uint32_t n, uint64_t ts, uint32_t period_ns)
+{
+    int completed = 0;
+    uint16_t mask = st->sample_mask;
+
+    if (st->decimate == 1) {
+        for (uint32_t i=0; i<n; i++) {
+            completed += _store_sample(st, raw[i] & mask, ts + (((uint64_t)i * period_ns) / 1000));
+        }
+        return completed;
+    }
+
+    for (uint32_t i=0; i<n; i++) {
+        uint32_t val = raw[i] & mask;
+        if (st->acc_n == 0) {
+            // first sample of the decimation group, its time is used as the output sample time
+            if (st->fill == 0) st->block_ts = ts + (((uint64_t)i * period_ns) / 1000);
+            st->acc = val;
+        }
+        else if (st->average) st->acc += val;
+        if (++st->acc_n >= st->decimate) {
+            if (st->average) val = st->acc / st->decimate;
+            else val = st->acc;
+            st->acc_n = 0;
+            completed += _store_sample(st, val, st->block_ts);
+        }
+    }
+    return completed;
+}
+
+//-----------------------------------------
+int adc_stream_finish(adc_stream_t *st)
+{
+    st->acc_n = 0;
+    st->skip = 0;
+    if (st->fill == 0) return 0;
+    _commit_block(st, st->fill);
+    return 1;
+}
+
+//--------------------------------------------------------------------
+uint8_t *adc_stream_get(adc_stream_t *st, adc_block_info_t *info)
+{
+    if (adc_stream_pending(st) == 0) return NULL;
+
+    uint32_t idx = _slot(st, st->iget);
+    if (info) *info = st->info[idx];
+    return st->mem + ((size_t)idx * st->block_len * st->sample_size);
+}
+
+//------------------------------------------
+void adc_stream_release(adc_stream_t *st)
+{
+    if (adc_stream_pending(st) == 0) return;
+    __atomic_store_n(&st->iget, _next(st, st->iget), __ATOMIC_RELEASE);
+}
@@ -0,0 +1,114 @@
+/*
+ * This file is part of the MicroPython ESP32 project, https://github.com/loboris/MicroPython_ESP32_psRAM_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Continuous ADC streaming into the ring of sample blocks.
+ *
+ * The producer (ADC task) stores the raw samples into the block being filled,
+ * optionally decimating/averaging them. When the block is full, it is time stamped
+ * and made available to the consumer. The consumer gets the oldest full block,
+ * uses the samples in place and releases the block.
+ * 'iput' and 'iget' are block indexes kept modulo 2*nblocks, so the full and the empty
+ * ring can be told apart for any number of blocks. Only the producer writes 'iput',
+ * only the consumer writes 'iget', so no locking is needed between them.
+ *
+ * If no free block is available when a new block has to be started, the whole
+ * block worth of samples is dropped and the overrun is counted. The block sequence
+ * number is still incremented, so the consumer can detect the gap.
+ *
+ * This module has no ESP-IDF or MicroPython dependencies and can be compiled on host.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef struct _adc_block_info_t {
+    uint32_t seq;               // block sequence number
+    uint32_t len;               // number of samples in the block
+    uint64_t timestamp;         // time of the first block sample (us)
+} adc_block_info_t;
+
+typedef struct _adc_stream_t {
+    uint8_t *mem;               // nblocks * block_len * sample_size bytes
+    adc_block_info_t *info;     // per block info, nblocks entries
+    uint32_t nblocks;
+    uint32_t block_len;         // samples per block
+    uint16_t sample_mask;       // applied to the raw sample
+    uint8_t sample_size;        // 1: 8-bit, 2: 16-bit samples
+    uint8_t val_shift;          // right shift applied to the (averaged) sample
+    uint16_t decimate;          // one output sample per 'decimate' raw samples
+    uint8_t average;            // 1: average the decimated samples, 0: take the first one
+    // producer state
+    uint32_t acc;               // averaging accumulator
+    uint16_t acc_n;             // raw samples accumulated
+    uint32_t fill;              // samples stored into the block being filled
+    uint32_t skip;              // samples left to drop on overrun
+    uint64_t block_ts;
+    uint32_t seq;               // sequence number of the block being filled
+    volatile uint32_t iput;     // block indexes, 0 ... 2*nblocks-1
+    volatile uint32_t iget;
+    // statistics
+    uint32_t blocks;            // blocks completed
+    uint32_t overruns;          // blocks lost because no free block was available
+    uint32_t dropped;           // output samples lost on overruns
+} adc_stream_t;
+
+// Memory needed for the sample blocks
+static inline size_t adc_stream_mem_size(uint32_t nblocks, uint32_t block_len, uint8_t sample_size) {
+    return (size_t)nblocks * block_len * sample_size;
+}
+
+// Initialize the stream using the provided memory
+// Returns -1 on invalid arguments
+int adc_stream_init(adc_stream_t *st, uint8_t *mem, adc_block_info_t *info, uint32_t nblocks, uint32_t block_len,
+                    uint8_t sample_size, uint8_t val_shift, uint16_t decimate, uint8_t average);
+
+// Number of full blocks waiting for the consumer
+static inline uint32_t adc_stream_pending(adc_stream_t *st) {
+    uint32_t iput = __atomic_load_n(&st->iput, __ATOMIC_ACQUIRE);
+    uint32_t iget = __atomic_load_n(&st->iget, __ATOMIC_ACQUIRE);
+    return (iput >= iget) ? iput - iget : iput + 2 * st->nblocks - iget;
+}
+
+// === Producer side ===
+
+// Store 'n' raw samples, 'ts' is the time of the first sample (us),
+// 'period_ns' is the raw sample period in nanoseconds.
+// Returns the number of blocks completed
+int adc_stream_put(adc_stream_t *st, const uint16_t *raw, uint32_t n, uint64_t ts, uint32_t period_ns);
+// Complete the partially filled block, if any
+// Returns 1 if the block was completed, 0 otherwise
+int adc_stream_finish(adc_stream_t *st);
+
+// === Consumer side ===
+
+// Get the oldest full block, the block info is copied to 'info' if not NULL
+// Returns NULL if no full block is available
+uint8_t *adc_stream_get(adc_stream_t *st, adc_block_info_t *info);
+// Release the block returned by 'adc_stream_get'
+void adc_stream_release(adc_stream_t *st);
@@ -58,6 +58,8 @@ static const char TAG[] = "[EveDrv]";
 
 uint16_t eve_cmdOffset = 0x0000;	// used to navigate command ring buffer
 static uint8_t cmd_burst = 0;		// flag to indicate cmd-burst is active
+static eve_dlist_t *eve_rec = NULL;	// if set, the co-processor commands are recorded to it instead of sent
+static uint8_t rec_cmd_burst = 0;	// cmd-burst state when the recording was started
 
 uint8_t eve_spibus_is_init = 0;
 uint8_t spi_is_init = 0;
@@ -502,6 +504,12 @@ void FT8_memWrite32(uint32_t ftAddress, uint32_t ftData32)
 //-----------------------------------------------------------------------
 static int FT8_send_data(uint8_t *data, int data_len, bool check_padding)
 {
+    if (eve_rec) {
+        // recorded data is always padded, the command offset is not changed
+        eve_dlist_data(eve_rec, data, data_len);
+        return 0;
+    }
+
     uint8_t padding = 0;
     if (check_padding) {
         // ensure 4-byte alignment
@@ -686,6 +694,69 @@ void FT8_end_cmd_burst(void)
     eve_deselect();
 }
 
+// ==== Recording the co-processor commands =================================================================
+/*
+While recording, the FT8_cmd_xxx functions append the commands to the display list buffer
+instead of sending them to EVE. The recorded list is later sent with FT8_cmd_write_buffer().
+Only the commands writing to the command-fifo can be recorded, not the ones reading the results back.
+*/
+//----------------------------------------
+void FT8_record_start(eve_dlist_t *dlist)
+{
+    // the caller's burst state is restored when the recording is stopped
+    if (eve_rec == NULL) rec_cmd_burst = cmd_burst;
+    eve_rec = dlist;
+    cmd_burst = 42;     // no chip-select handling while recording
+}
+
+//--------------------------
+void FT8_record_stop(void)
+{
+    if (eve_rec == NULL) return;
+    eve_rec = NULL;
+    cmd_burst = rec_cmd_burst;
+}
+
+// Write the buffer of encoded commands to the command-fifo
+// Each part is written in one SPI transfer, as much as the fifo free space allows,
+// the co-processor is started after each part so it can execute the commands while the next part is sent.
+// Returns false on co-processor fault or timeout
+//-----------------------------------------------------------------------
+bool FT8_cmd_write_buffer(const uint8_t *data, uint32_t len, int tmo_ms)
+{
+    uint64_t tmo = mp_hal_ticks_ms();
+    while (len > 0) {
+        uint16_t cmd_read = FT8_memRead16(REG_CMD_READ);
+        if (cmd_read == 0xFFF) {
+            FT8_CP_reset();
+            ESP_LOGE(TAG, "EVE co-processor fault");
+            return false;
+        }
+        // free space in the fifo, one word is always left free
+        uint32_t fifo_free = (FT8_CMDFIFO_SIZE - 4) - ((eve_cmdOffset - cmd_read) & (FT8_CMDFIFO_SIZE - 1));
+        if (fifo_free < 4) {
+            if ((mp_hal_ticks_ms()-tmo) > tmo_ms) {
+                FT8_CP_reset();
+                return false;
+            }
+            mp_hal_reset_wdt();
+            continue;
+        }
+        uint32_t part = len;
+        if (part > fifo_free) part = fifo_free & ~3UL;
+        // do not write past the end of the fifo memory, wrap to the fifo start
+        if (part > (FT8_CMDFIFO_SIZE - eve_cmdOffset)) part = FT8_CMDFIFO_SIZE - eve_cmdOffset;
+
+        if (FT8_memWrite_flash_buffer(FT8_RAM_CMD + eve_cmdOffset, data, part, false) != (int)part) return false;
+        FT8_inc_cmdoffset(part);
+        FT8_cmd_start();
+        data += part;
+        len -= part;
+        tmo = mp_hal_ticks_ms();
+    }
+    return true;
+}
+
 // Write a string to coprocessor memory in context of a command
 // no chip-select, just plain spi-transfers
 //-------------------------------------
@@ -703,7 +774,11 @@ void FT8_write_string(const char *text)
 void FT8_start_cmd(uint32_t command)
 {
 	uint32_t ftAddress;
-	
+
+	if (eve_rec) {
+	    eve_dlist_word(eve_rec, command);
+	    return;
+	}
     if (eve_select()) return;
 
     if (cmd_burst == 0)	{
@@ -747,6 +822,12 @@ void FT8_cmd_dl(uint32_t command)
 //-------------------------------------------------------------------------------------------------------------------------------------------
 static void FT8_send_params(int16_t p1, int16_t p2, int16_t p3, uint16_t p4, uint16_t p5, uint16_t p6, uint16_t p7, uint16_t p8, uint8_t len)
 {
+    if (eve_rec) {
+        uint16_t params[8] = {p1, p2, p3, p4, p5, p6, p7, p8};
+        eve_dlist_params16(eve_rec, params, len);
+        return;
+    }
+
 	eve_spi->handle->host->hw->data_buf[0] = ((uint32_t)p1 | (uint32_t)p2 << 16);
 	if (len < 4) goto send;
 
@@ -769,6 +850,12 @@ send:
 //--------------------------------------------------------------------------
 void FT8_send_long(uint32_t val1, uint32_t val2, uint32_t val3, uint8_t len)
 {
+    if (eve_rec) {
+        uint32_t words[3] = {val1, val2, val3};
+        eve_dlist_words(eve_rec, words, len);
+        return;
+    }
+
 	eve_spi->handle->host->hw->data_buf[0] = val1;
 	if (len < 2) goto send;
 
@@ -40,6 +40,7 @@
 #include "esp_err.h"
 //#include "tft/tftspi.h"
 #include "driver/spi_master_utils.h"
+#include "eve_dlist.h"
 
 
 #define MAX_USER_FONTS          15
@@ -176,6 +177,10 @@ void FT8_start_cmd_burst(void);
 void FT8_end_cmd_burst(void);
 void FT8_start_cmd(uint32_t command);
 
+void FT8_record_start(eve_dlist_t *dlist);
+void FT8_record_stop(void);
+bool FT8_cmd_write_buffer(const uint8_t *data, uint32_t len, int tmo_ms);
+
 
 /* commands to draw graphics objects: */
 void FT8_cmd_text(int16_t x0, int16_t y0, int16_t font, uint16_t options, const char* text);
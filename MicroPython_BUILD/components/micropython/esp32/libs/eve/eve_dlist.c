@@ -0,0 +1,358 @@
+/*
+ * This file is part of the MicroPython ESP32 project, https://github.com/loboris/MicroPython_ESP32_psRAM_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <string.h>
+
+#include "eve_dlist.h"
+
+// Co-processor command table, indexed by the command low byte
+// low nibble: number of 32-bit parameters, high nibble: what follows the parameters
+#define T_FIX       0x00    // nothing
+#define T_STR       0x10    // zero terminated string
+#define T_DATA      0x20    // data, the length is the 2nd parameter (CMD_MEMWRITE)
+#define T_OPTDATA   0x30    // data of unknown length, unless OPT_MEDIAFIFO is set in the last parameter
+#define T_NONE      0xFF    // unknown or internal command
+
+#define OPT_MEDIAFIFO   16UL
+
+static const uint8_t cmd_table[] = {
+    T_FIX | 0,      // 0x00 CMD_DLSTART
+    T_FIX | 0,      // 0x01 CMD_SWAP
+    T_FIX | 1,      // 0x02 CMD_INTERRUPT
+    T_NONE,         // 0x03
+    T_NONE,         // 0x04
+    T_NONE,         // 0x05
+    T_NONE,         // 0x06
+    T_NONE,         // 0x07
+    T_NONE,         // 0x08
+    T_FIX | 1,      // 0x09 CMD_BGCOLOR
+    T_FIX | 1,      // 0x0A CMD_FGCOLOR
+    T_FIX | 4,      // 0x0B CMD_GRADIENT
+    T_STR | 2,      // 0x0C CMD_TEXT
+    T_STR | 3,      // 0x0D CMD_BUTTON
+    T_STR | 3,      // 0x0E CMD_KEYS
+    T_FIX | 4,      // 0x0F CMD_PROGRESS
+    T_FIX | 4,      // 0x10 CMD_SLIDER
+    T_FIX | 4,      // 0x11 CMD_SCROLLBAR
+    T_STR | 3,      // 0x12 CMD_TOGGLE
+    T_FIX | 4,      // 0x13 CMD_GAUGE
+    T_FIX | 4,      // 0x14 CMD_CLOCK
+    T_FIX | 1,      // 0x15 CMD_CALIBRATE
+    T_FIX | 2,      // 0x16 CMD_SPINNER
+    T_FIX | 0,      // 0x17 CMD_STOP
+    T_FIX | 3,      // 0x18 CMD_MEMCRC
+    T_FIX | 2,      // 0x19 CMD_REGREAD
+    T_DATA | 2,     // 0x1A CMD_MEMWRITE
+    T_FIX | 3,      // 0x1B CMD_MEMSET
+    T_FIX | 2,      // 0x1C CMD_MEMZERO
+    T_FIX | 3,      // 0x1D CMD_MEMCPY
+    T_FIX | 2,      // 0x1E CMD_APPEND
+    T_FIX | 1,      // 0x1F CMD_SNAPSHOT
+    T_NONE,         // 0x20
+    T_NONE,         // 0x21
+    T_NONE,         // 0x22 CMD_INFLATE, compressed data length is not known
+    T_FIX | 1,      // 0x23 CMD_GETPTR
+    T_OPTDATA | 2,  // 0x24 CMD_LOADIMAGE
+    T_FIX | 3,      // 0x25 CMD_GETPROPS
+    T_FIX | 0,      // 0x26 CMD_LOADIDENTITY
+    T_FIX | 2,      // 0x27 CMD_TRANSLATE
+    T_FIX | 2,      // 0x28 CMD_SCALE
+    T_FIX | 1,      // 0x29 CMD_ROTATE
+    T_FIX | 0,      // 0x2A CMD_SETMATRIX
+    T_FIX | 2,      // 0x2B CMD_SETFONT
+    T_FIX | 3,      // 0x2C CMD_TRACK
+    T_FIX | 3,      // 0x2D CMD_DIAL
+    T_FIX | 3,      // 0x2E CMD_NUMBER
+    T_FIX | 0,      // 0x2F CMD_SCREENSAVER
+    T_FIX | 4,      // 0x30 CMD_SKETCH
+    T_FIX | 0,      // 0x31 CMD_LOGO
+    T_FIX | 0,      // 0x32 CMD_COLDSTART
+    T_FIX | 6,      // 0x33 CMD_GETMATRIX
+    T_FIX | 1,      // 0x34 CMD_GRADCOLOR
+    T_FIX | 4,      // 0x35 CMD_CSKETCH
+    T_FIX | 1,      // 0x36 CMD_SETROTATE
+    T_FIX | 4,      // 0x37 CMD_SNAPSHOT2
+    T_FIX | 1,      // 0x38 CMD_SETBASE
+    T_FIX | 2,      // 0x39 CMD_MEDIAFIFO
+    T_OPTDATA | 1,  // 0x3A CMD_PLAYVIDEO
+    T_FIX | 3,      // 0x3B CMD_SETFONT2
+    T_FIX | 1,      // 0x3C CMD_SETSCRATCH
+    T_NONE,         // 0x3D
+    T_NONE,         // 0x3E
+    T_FIX | 2,      // 0x3F CMD_ROMFONT
+    T_FIX | 0,      // 0x40 CMD_VIDEOSTART
+    T_FIX | 2,      // 0x41 CMD_VIDEOFRAME
+    T_FIX | 0,      // 0x42 CMD_SYNC
+    T_FIX | 3,      // 0x43 CMD_SETBITMAP
+};
+
+//--------------------------------------------------------------
+static inline void _put_word(uint8_t *p, uint32_t word)
+{
+    p[0] = word & 0xFF;
+    p[1] = (word >> 8) & 0xFF;
+    p[2] = (word >> 16) & 0xFF;
+    p[3] = (word >> 24) & 0xFF;
+}
+
+//--------------------------------------------------
+static inline uint32_t _get_word(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+//----------------------------------------------------------
+static int _check_space(eve_dlist_t *dl, uint32_t len)
+{
+    if ((dl->size - dl->len) < len) {
+        dl->overflow = 1;
+        return -1;
+    }
+    return 0;
+}
+
+//--------------------------------------------------------------------
+void eve_dlist_init(eve_dlist_t *dl, uint8_t *buf, uint32_t size)
+{
+    dl->buf = buf;
+    dl->size = size & ~3UL;
+    eve_dlist_clear(dl);
+}
+
+//-------------------------------------
+void eve_dlist_clear(eve_dlist_t *dl)
+{
+    dl->len = 0;
+    dl->nseg = 0;
+    dl->overflow = 0;
+    memset(dl->seg, 0, sizeof(dl->seg));
+}
+
+//------------------------------------------------
+int eve_dlist_word(eve_dlist_t *dl, uint32_t word)
+{
+    if (_check_space(dl, 4) < 0) return -1;
+    _put_word(dl->buf + dl->len, word);
+    dl->len += 4;
+    return 0;
+}
+
+//---------------------------------------------------------------------
+int eve_dlist_words(eve_dlist_t *dl, const uint32_t *words, int count)
+{
+    if (_check_space(dl, count * 4) < 0) return -1;
+    for (int i=0; i<count; i++) {
+        _put_word(dl->buf + dl->len, words[i]);
+        dl->len += 4;
+    }
+    return 0;
+}
+
+//------------------------------------------------------------------------
+int eve_dlist_params16(eve_dlist_t *dl, const uint16_t *params, int count)
+{
+    if (_check_space(dl, ((count + 1) / 2) * 4) < 0) return -1;
+    for (int i=0; i<count; i+=2) {
+        uint32_t word = params[i];
+        if ((i + 1) < count) word |= (uint32_t)params[i+1] << 16;
+        _put_word(dl->buf + dl->len, word);
+        dl->len += 4;
+    }
+    return 0;
+}
+
+//-----------------------------------------------------------------------
+int eve_dlist_data(eve_dlist_t *dl, const uint8_t *data, uint32_t len)
+{
+    uint32_t padded = (len + 3) & ~3UL;
+    if (_check_space(dl, padded) < 0) return -1;
+    memcpy(dl->buf + dl->len, data, len);
+    memset(dl->buf + dl->len + len, 0, padded - len);
+    dl->len += padded;
+    return 0;
+}
+
+//--------------------------------------------------------
+int eve_dlist_string(eve_dlist_t *dl, const char *str)
+{
+    return eve_dlist_data(dl, (const uint8_t *)str, strlen(str) + 1);
+}
+
+//------------------------------------------------------------------------
+int eve_dlist_append(eve_dlist_t *dl, uint32_t addr, uint32_t num)
+{
+    uint32_t words[3] = {EVE_DLIST_CMD_APPEND, addr, num};
+    return eve_dlist_words(dl, words, 3);
+}
+
+//----------------------------------------------------
+int eve_dlist_find(eve_dlist_t *dl, int32_t id)
+{
+    for (int i=0; i<dl->nseg; i++) {
+        if (dl->seg[i].id == id) return i;
+    }
+    return -1;
+}
+
+//----------------------------------------------------
+int eve_dlist_mark(eve_dlist_t *dl, int32_t id)
+{
+    if ((dl->nseg > 0) && (dl->seg[dl->nseg-1].open)) {
+        eve_dlist_seg_t *seg = &dl->seg[dl->nseg-1];
+        seg->len = dl->len - seg->start;
+        seg->open = 0;
+    }
+    if (id < 0) return -1;
+    if ((dl->nseg >= EVE_DLIST_MAX_SEGMENTS) || (eve_dlist_find(dl, id) >= 0)) return -1;
+
+    eve_dlist_seg_t *seg = &dl->seg[dl->nseg];
+    seg->start = dl->len;
+    seg->len = 0;
+    seg->id = id;
+    seg->open = 1;
+    seg->cached = 0;
+    return dl->nseg++;
+}
+
+//---------------------------------------------------------------------------------------
+int eve_dlist_replace(eve_dlist_t *dl, int idx, const uint8_t *data, uint32_t len)
+{
+    if ((idx < 0) || (idx >= dl->nseg) || (len & 3)) return -1;
+    eve_dlist_seg_t *seg = &dl->seg[idx];
+    if (seg->open) return -1;
+
+    if (len > seg->len) {
+        if ((dl->size - dl->len) < (len - seg->len)) return -1;
+    }
+    // move the rest of the list
+    uint32_t tail = seg->start + seg->len;
+    if (len != seg->len) {
+        memmove(dl->buf + seg->start + len, dl->buf + tail, dl->len - tail);
+        dl->len = dl->len - seg->len + len;
+        for (int i=idx+1; i<dl->nseg; i++) {
+            dl->seg[i].start = dl->seg[i].start - seg->len + len;
+        }
+    }
+    if (len) memcpy(dl->buf + seg->start, data, len);
+    seg->len = len;
+    seg->cached = 0;
+    return 0;
+}
+
+//-------------------------------------------------------------------------------
+int eve_dlist_cache(eve_dlist_t *dl, int idx, uint32_t addr, uint32_t num)
+{
+    uint8_t cmd[12];
+    _put_word(cmd, EVE_DLIST_CMD_APPEND);
+    _put_word(cmd+4, addr);
+    _put_word(cmd+8, num);
+    if (eve_dlist_replace(dl, idx, cmd, 12) < 0) return -1;
+    dl->seg[idx].cached = 1;
+    return 0;
+}
+
+//-----------------------------------------------------------------------------------------------
+int eve_dlist_next(const uint8_t *buf, uint32_t len, uint32_t *pos, eve_dlist_item_t *item)
+{
+    uint32_t p = *pos;
+    if (p >= len) return 0;
+    if ((p & 3) || (len & 3)) return EVE_DLIST_ERR_ALIGN;
+
+    memset(item, 0, sizeof(eve_dlist_item_t));
+    item->offset = p;
+    item->cmd = _get_word(buf + p);
+    p += 4;
+
+    if ((item->cmd & EVE_DLIST_CMD_MASK) != EVE_DLIST_CMD_MASK) {
+        // display list word
+        item->type = EVE_DLIST_ITEM_DL;
+        item->size = 4;
+        *pos = p;
+        return 1;
+    }
+
+    uint8_t code = item->cmd & 0xFF;
+    if (code >= sizeof(cmd_table)) return EVE_DLIST_ERR_CMD;
+    uint8_t desc = cmd_table[code];
+    if (desc == T_NONE) return EVE_DLIST_ERR_CMD;
+
+    item->nparams = desc & 0x0F;
+    if ((len - p) < (item->nparams * 4UL)) return EVE_DLIST_ERR_TRUNC;
+    for (int i=0; i<item->nparams; i++) {
+        item->params[i] = _get_word(buf + p);
+        p += 4;
+    }
+
+    uint32_t data_len = 0;
+    switch (desc & 0xF0) {
+        case T_FIX:
+            item->type = EVE_DLIST_ITEM_CMD;
+            break;
+        case T_STR: {
+            item->type = EVE_DLIST_ITEM_STR;
+            const uint8_t *end = memchr(buf + p, 0, len - p);
+            if (end == NULL) return EVE_DLIST_ERR_TRUNC;
+            data_len = (end - (buf + p)) + 1;
+            break;
+        }
+        case T_DATA:
+            item->type = EVE_DLIST_ITEM_DATA;
+            data_len = item->params[1];
+            if (data_len > (len - p)) return EVE_DLIST_ERR_TRUNC;
+            break;
+        default:
+            // T_OPTDATA, the data can be followed only if taken from the media fifo
+            if ((item->params[item->nparams-1] & OPT_MEDIAFIFO) == 0) return EVE_DLIST_ERR_CMD;
+            item->type = EVE_DLIST_ITEM_CMD;
+            break;
+    }
+
+    if (data_len) {
+        uint32_t padded = (data_len + 3) & ~3UL;
+        if (padded > (len - p)) return EVE_DLIST_ERR_TRUNC;
+        for (uint32_t i=data_len; i<padded; i++) {
+            if (buf[p+i] != 0) return EVE_DLIST_ERR_ALIGN;
+        }
+        item->data = buf + p;
+        item->data_len = data_len;
+        p += padded;
+    }
+    item->size = p - item->offset;
+    *pos = p;
+    return 1;
+}
+
+//------------------------------------------------------
+int eve_dlist_count(const uint8_t *buf, uint32_t len)
+{
+    eve_dlist_item_t item;
+    uint32_t pos = 0;
+    int count = 0;
+    int res;
+    while ((res = eve_dlist_next(buf, len, &pos, &item)) > 0) count++;
+    if (res < 0) return res;
+    return count;
+}
@@ -0,0 +1,132 @@
+/*
+ * This file is part of the MicroPython ESP32 project, https://github.com/loboris/MicroPython_ESP32_psRAM_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Recorded FT8xx co-processor command list.
+ *
+ * The co-processor commands and display list words are encoded into the RAM
+ * buffer exactly as they would be written to the EVE command FIFO (little endian
+ * 32-bit words, strings and data zero padded to 4 bytes), so the whole list can
+ * be sent to the FIFO with burst SPI writes.
+ * Parts of the list can be marked as segments, identified by the user given id.
+ * The segment content can be replaced without rebuilding the whole list
+ * (e.g. only the changing values), or, for static parts, with the single
+ * CMD_APPEND referencing the display list words cached in RAM_G.
+ *
+ * The decoder splits the recorded stream back into commands and is used
+ * to verify the generated command stream.
+ *
+ * This module has no ESP-IDF or MicroPython dependencies and can be compiled on host.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define EVE_DLIST_MAX_SEGMENTS  16
+#define EVE_DLIST_MAX_PARAMS    6
+
+#define EVE_DLIST_CMD_MASK      0xFFFFFF00UL    // co-processor commands are 0xFFFFFFxx
+#define EVE_DLIST_CMD_APPEND    0xFFFFFF1EUL
+
+// decoder item types
+#define EVE_DLIST_ITEM_DL       0   // display list word
+#define EVE_DLIST_ITEM_CMD      1   // co-processor command with fixed parameters
+#define EVE_DLIST_ITEM_STR      2   // co-processor command followed by the string
+#define EVE_DLIST_ITEM_DATA     3   // co-processor command followed by the data
+
+// decoder errors
+#define EVE_DLIST_ERR_TRUNC     -1  // stream ends inside the command
+#define EVE_DLIST_ERR_CMD       -2  // unknown command or command with unknown data length
+#define EVE_DLIST_ERR_ALIGN     -3  // stream length or string/data padding not valid
+
+typedef struct _eve_dlist_seg_t {
+    uint32_t start;             // segment start offset in the buffer
+    uint32_t len;               // segment length in bytes
+    int32_t id;                 // user given segment id
+    uint8_t open;               // segment is being recorded
+    uint8_t cached;             // the content is CMD_APPEND of the list cached in RAM_G
+} eve_dlist_seg_t;
+
+typedef struct _eve_dlist_t {
+    uint8_t *buf;
+    uint32_t size;              // buffer size
+    uint32_t len;               // used bytes, always multiple of 4
+    eve_dlist_seg_t seg[EVE_DLIST_MAX_SEGMENTS];
+    uint8_t nseg;               // segments are ordered by start offset
+    uint8_t overflow;           // set if something could not be stored
+} eve_dlist_t;
+
+typedef struct _eve_dlist_item_t {
+    uint32_t offset;            // command offset in the stream
+    uint32_t size;              // total command size in bytes, including padding
+    uint32_t cmd;               // command or display list word
+    uint32_t params[EVE_DLIST_MAX_PARAMS];
+    uint8_t nparams;
+    uint8_t type;               // EVE_DLIST_ITEM_xxx
+    const uint8_t *data;        // string (including terminating 0) or data following the command
+    uint32_t data_len;          // without padding
+} eve_dlist_item_t;
+
+// === Builder ===
+
+void eve_dlist_init(eve_dlist_t *dl, uint8_t *buf, uint32_t size);
+// Remove all commands and segments
+void eve_dlist_clear(eve_dlist_t *dl);
+// Append one 32-bit word (command, display list word or parameter)
+// All append functions return 0 on success, -1 (and set 'overflow') if there is no space
+int eve_dlist_word(eve_dlist_t *dl, uint32_t word);
+int eve_dlist_words(eve_dlist_t *dl, const uint32_t *words, int count);
+// Append 16-bit parameters, two per word; odd count is zero padded
+int eve_dlist_params16(eve_dlist_t *dl, const uint16_t *params, int count);
+// Append the data zero padded to 4 bytes
+int eve_dlist_data(eve_dlist_t *dl, const uint8_t *data, uint32_t len);
+// Append the string including the terminating zero, padded to 4 bytes
+int eve_dlist_string(eve_dlist_t *dl, const char *str);
+// Append CMD_APPEND(addr, num)
+int eve_dlist_append(eve_dlist_t *dl, uint32_t addr, uint32_t num);
+
+// === Segments ===
+
+// Close the open segment (if any) and, if 'id' >= 0, start the new segment at the current position
+// Returns the segment index, -1 if the id is already used or no more segments are available
+int eve_dlist_mark(eve_dlist_t *dl, int32_t id);
+// Get the segment index for the given id, -1 if not found
+int eve_dlist_find(eve_dlist_t *dl, int32_t id);
+// Replace the segment content, the rest of the list is moved as needed
+// 'len' must be multiple of 4, returns -1 if there is no space
+int eve_dlist_replace(eve_dlist_t *dl, int idx, const uint8_t *data, uint32_t len);
+// Replace the segment content with CMD_APPEND(addr, num) and mark it as cached
+int eve_dlist_cache(eve_dlist_t *dl, int idx, uint32_t addr, uint32_t num);
+
+// === Decoder ===
+
+// Decode the command at '*pos', '*pos' is advanced to the next command
+// Returns 1 if the item was decoded, 0 at the end of the stream or EVE_DLIST_ERR_xxx
+int eve_dlist_next(const uint8_t *buf, uint32_t len, uint32_t *pos, eve_dlist_item_t *item);
+// Check the whole stream, returns the number of commands or EVE_DLIST_ERR_xxx
+int eve_dlist_count(const uint8_t *buf, uint32_t len);
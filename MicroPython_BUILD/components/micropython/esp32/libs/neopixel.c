@@ -31,6 +31,7 @@
 #include "driver/rmt.h"
 
 #include "libs/neopixel.h"
+#include "libs/np_encode.h"
 #include "esp_log.h"
 
 static xSemaphoreHandle neopixel_sem = NULL;
@@ -39,8 +40,8 @@ static rmt_channel_t RMTchannel = RMT_CHANNEL_0;
 static uint16_t neopixel_pos, neopixel_half, neopixel_bufIsDirty, neopixel_termsent;
 static uint16_t neopixel_buf_len = 0;
 static pixel_settings_t *neopixel_px;
-static uint8_t *neopixel_buffer = NULL;
-static uint8_t neopixel_brightness = 255;
+static uint8_t *neopixel_buffer = NULL;	// frame being sent, 'px->pixels' can be drawn meanwhile
+static np_encoder_t neopixel_enc;
 
 static uint8_t used_channels[RMT_CHANNEL_MAX] = {0};
 
@@ -115,44 +116,16 @@ uint32_t np_get_pixel_color(pixel_settings_t *px, uint16_t idx, uint8_t *white)
 	return color;
 }
 
-// Set two levels of RMT output to the Neopixel value for bit value "1".
-//--------------------------------------------------------------------
-static void neopixel_mark(rmt_item32_t *pItem, pixel_settings_t *px) {
-	pItem->level0    = px->timings.mark.level0;
-	pItem->duration0 = px->timings.mark.duration0;
-	pItem->level1    = px->timings.mark.level1;
-	pItem->duration1 = px->timings.mark.duration1;
-}
-
-// Set two levels of RMT output to the Neopixel value for bit value "0".
-//---------------------------------------------------------------------
-static void neopixel_space(rmt_item32_t *pItem, pixel_settings_t *px) {
-	pItem->level0    = px->timings.space.level0;
-	pItem->duration0 = px->timings.space.duration0;
-	pItem->level1    = px->timings.space.level1;
-	pItem->duration1 = px->timings.space.duration1;
-}
-
-// Set levels and duration of RMT output to the Neopixel value for Reset.
-//--------------------------------------------------------------------
-static void rmt_terminate(rmt_item32_t *pItem, pixel_settings_t *px) {
-	pItem->level0    = px->timings.reset.level0;
-	pItem->duration0 = px->timings.reset.duration0;
-	pItem->level1    = px->timings.reset.level1;
-	pItem->duration1 = px->timings.reset.duration1;
-}
-
 // Transfer pixels from buffer to Neopixel strip
 //-------------------------------
 static void copyToRmtBlock_half()
 {
 	// This fills half an RMT block
 	// When wrap around is happening, we want to keep the inactive half of the RMT block filled
-	uint16_t i, offset, len, byteval;
-	rmt_item32_t CurrentItem;
+	uint16_t i, offset, len;
 	offset = neopixel_half * MAX_PULSES;
 	neopixel_half = !neopixel_half;  // for next offset calculation
-	int j;
+	uint32_t *dst = (uint32_t *)&RMTMEM.chan[RMTchannel].data32[offset].val;
 
 	len = neopixel_buf_len - neopixel_pos; // remaining bytes in buffer
 	if (len > (MAX_PULSES / 8)) len = (MAX_PULSES / 8);
@@ -160,50 +133,29 @@ static void copyToRmtBlock_half()
 	if (!len) {
 		if (!neopixel_bufIsDirty) return;
 		// Clear the channel's data block and return
-		j = 0;
+		i = 0;
 		if (!neopixel_termsent) {
-			i++;
-			rmt_terminate(&CurrentItem, neopixel_px);
-			RMTMEM.chan[RMTchannel].data32[0].val = CurrentItem.val;
+			dst[i++] = neopixel_enc.reset;
 			neopixel_termsent = 1;
-			j++;
-		}
-		for (i = j; i < MAX_PULSES; i++) {
-			RMTMEM.chan[RMTchannel].data32[i + offset].val = 0;
 		}
+		for (; i < MAX_PULSES; i++) dst[i] = 0;
 		neopixel_bufIsDirty = 0;
 		return;
 	}
 	neopixel_bufIsDirty = 1;
 
 	// Populate RMT bit buffer from 'neopixel_buffer' containing one byte for each RGB(W) value
-	for (i = 0; i < len; i++) {
-		byteval = (uint16_t)neopixel_buffer[i+neopixel_pos];
-		// Correct by brightness factor
-		byteval = (byteval * neopixel_brightness) / 255;
-
-		// Shift bits out, MSB first, setting RMTMEM.chan[n].data32[x] to the rmtPulsePair value corresponding to the buffered bit value
-		for (j=7; j>=0; j--) {
-			if (byteval & (1<<j)) neopixel_mark(&CurrentItem, neopixel_px);
-			else neopixel_space(&CurrentItem, neopixel_px);
+	// using the precomputed RMT items, brightness and gamma correction are applied by the encoder
+	np_encode_bytes(&neopixel_enc, neopixel_buffer + neopixel_pos, dst, len);
+	i = len * 8;
+	neopixel_pos += len;
 
-			RMTMEM.chan[RMTchannel].data32[(i * 8) + offset + (7-j)].val = CurrentItem.val;
-		}
-		if ((i < ((MAX_PULSES / 8)-1)) && (i + neopixel_pos == neopixel_buf_len - 1)) {
-			i++;
-			rmt_terminate(&CurrentItem, neopixel_px);
-			RMTMEM.chan[RMTchannel].data32[(i * 8) + offset + 7].val = CurrentItem.val;
-			neopixel_termsent = 1;
-			break;
-		}
+	if ((i < MAX_PULSES) && (neopixel_pos == neopixel_buf_len)) {
+		dst[i++] = neopixel_enc.reset;
+		neopixel_termsent = 1;
 	}
 	// Clear the remainder of the channel's data not set above
-	for (i *= 8; i < MAX_PULSES; i++) {
-		RMTMEM.chan[RMTchannel].data32[i + offset].val = 0;
-	}
-
-	neopixel_pos += len;
-	return;
+	for (; i < MAX_PULSES; i++) dst[i] = 0;
 }
 
 // RMT interrupt handler
@@ -321,42 +273,46 @@ void neopixel_deinit(rmt_channel_t channel)
 }
 
 // Start the transfer of Neopixel color bytes from buffer
+// The pixels are copied to the transfer buffer and the function returns
+// while the frame is sent, the next frame can be drawn meanwhile.
 //=======================================================
 void np_show(pixel_settings_t *px, rmt_channel_t channel)
 {
-	// Wait for previous operation to finish
+	// Wait for previous frame to be sent
 	xSemaphoreTake(neopixel_sem, portMAX_DELAY);
 
+	uint16_t blen = px->pixel_count * (px->nbits / 8);
+
+	// Allocate or resize neopixel buffer if needed
+	if ((neopixel_buffer == NULL) || (neopixel_buf_len < blen)) {
+		if (neopixel_buffer) free(neopixel_buffer);
+		neopixel_buffer = (uint8_t *)malloc(blen);
+		if (neopixel_buffer == NULL) {
+			neopixel_buf_len = 0;
+			xSemaphoreGive(neopixel_sem);
+			return;
+		}
+	}
+	memcpy(neopixel_buffer, px->pixels, blen);
+
 	RMTchannel = channel;
 	// Enable interrupt for neopixel RMT channel
 	uint32_t tx_thr_event_mask = 0x01000000 << channel;
 	uint32_t tx_end_event_mask = 1 << (channel*3);
 	RMT.int_ena.val = tx_thr_event_mask | tx_end_event_mask;
 
-	uint16_t blen = px->pixel_count * (px->nbits / 8);
-
-	// Allocate neopixel buffer if needed
-	if (neopixel_buffer == NULL) {
-		neopixel_buffer = (uint8_t *)malloc(blen);
-		if (neopixel_buffer == NULL) return;
-		neopixel_buf_len = blen;
-	}
-	// Resize neopixel buffer if needed
-	if (neopixel_buf_len < blen) {
-		// larger buffer needed
-		free(neopixel_buffer);
-		neopixel_buffer = (uint8_t *)malloc(blen);
-		if (neopixel_buffer == NULL) return;
-	}
-	memcpy(neopixel_buffer, px->pixels, blen);
+	// Precompute the RMT items for the current timings and the correction table
+	np_encode_init(&neopixel_enc,
+			np_rmt_item(px->timings.mark.level0, px->timings.mark.duration0, px->timings.mark.level1, px->timings.mark.duration1),
+			np_rmt_item(px->timings.space.level0, px->timings.space.duration0, px->timings.space.level1, px->timings.space.duration1),
+			np_rmt_item(px->timings.reset.level0, px->timings.reset.duration0, px->timings.reset.level1, px->timings.reset.duration1));
+	np_encode_lut(&neopixel_enc, px->gamma, px->brightness);
 
 	neopixel_buf_len = blen;
 	neopixel_pos = 0;
 	neopixel_half = 0;
 	neopixel_px = px;
-	neopixel_half = 0;
 	neopixel_termsent = 0;
-	neopixel_brightness = px->brightness;
 
 	copyToRmtBlock_half();
 
@@ -365,14 +321,17 @@ void np_show(pixel_settings_t *px, rmt_channel_t channel)
 		copyToRmtBlock_half();
 	}
 
-	// Start sending
+	// Start sending, the semaphore is given by the interrupt handler when finished
 	RMT.conf_ch[RMTchannel].conf1.mem_rd_rst = 1;
 	RMT.conf_ch[RMTchannel].conf1.tx_start = 1;
+}
 
-	// Wait for operation to finish
-	if (xSemaphoreTake(neopixel_sem, 0) == pdTRUE) {
-		xSemaphoreTake(neopixel_sem, portMAX_DELAY);
-	}
+// Wait until the frame is sent
+//=================
+void np_wait(void)
+{
+	if (neopixel_sem == NULL) return;
+	xSemaphoreTake(neopixel_sem, portMAX_DELAY);
 	xSemaphoreGive(neopixel_sem);
 }
 
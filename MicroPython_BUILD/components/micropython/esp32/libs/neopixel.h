@@ -53,6 +53,7 @@ typedef struct pixel_settings {
 	pixel_timing_t timings;	// timing data from which the pixels BIT data are formed
 	uint16_t pixel_count;	// number of used pixels
 	uint8_t brightness;		// brightness factor applied to pixel color
+	float gamma;			// gamma correction applied to pixel color, 1.0: no correction
 	char color_order[5];
 	uint8_t nbits;			// number of bits used (24 for RGB devices, 32 for RGBW devices)
 } pixel_settings_t;
@@ -61,6 +62,7 @@ void np_set_pixel_color(pixel_settings_t *px, uint16_t idx, uint32_t color);
 void np_set_pixel_color_hsb(pixel_settings_t *px, uint16_t idx, float hue, float saturation, float brightness);
 uint32_t np_get_pixel_color(pixel_settings_t *px, uint16_t idx, uint8_t *white);
 void np_show(pixel_settings_t *px, rmt_channel_t channel);
+void np_wait(void);
 void np_clear(pixel_settings_t *px);
 
 int neopixel_init(int gpioNum, rmt_channel_t channel);
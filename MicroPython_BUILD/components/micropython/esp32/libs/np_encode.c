@@ -0,0 +1,129 @@
+/*
+ * This file is part of the MicroPython ESP32 project, https://github.com/loboris/MicroPython_ESP32_psRAM_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "np_encode.h"
+
+
+//==========================================================================================
+void np_encode_init(np_encoder_t *enc, uint32_t mark, uint32_t space, uint32_t reset)
+{
+	enc->mark = mark;
+	enc->space = space;
+	enc->reset = reset;
+	for (int n=0; n<16; n++) {
+		for (int b=0; b<4; b++) {
+			enc->nibble[n][b] = (n & (0x08 >> b)) ? mark : space;
+		}
+	}
+}
+
+//================================================================
+void np_encode_lut(np_encoder_t *enc, float gamma, uint8_t brightness)
+{
+	if ((enc->lut_gamma == gamma) && (enc->lut_brightness == brightness)) return;
+
+	for (int i=0; i<256; i++) {
+		uint32_t v = i;
+		if ((gamma > 0.0) && (gamma != 1.0)) v = (uint32_t)(powf((float)i / 255.0, gamma) * 255.0 + 0.5);
+		enc->lut[i] = (uint8_t)((v * brightness) / 255);
+	}
+	enc->lut_gamma = gamma;
+	enc->lut_brightness = brightness;
+}
+
+//=============================================================================================
+void np_encode_bytes(const np_encoder_t *enc, const uint8_t *src, uint32_t *dst, uint32_t len)
+{
+	for (uint32_t i=0; i<len; i++) {
+		uint8_t val = enc->lut[src[i]];
+		const uint32_t *hi = enc->nibble[val >> 4];
+		const uint32_t *lo = enc->nibble[val & 0x0F];
+		// RMT memory must be written with 32-bit accesses, so no memcpy
+		dst[0] = hi[0]; dst[1] = hi[1]; dst[2] = hi[2]; dst[3] = hi[3];
+		dst[4] = lo[0]; dst[5] = lo[1]; dst[6] = lo[2]; dst[7] = lo[3];
+		dst += 8;
+	}
+}
+
+//======================================================
+int np_order_map(const char *order, uint8_t bpp, uint8_t *map)
+{
+	static const char rgbw[] = "RGBW";
+	if ((bpp != 3) && (bpp != 4)) return -1;
+	for (int i=0; i<bpp; i++) {
+		const char *p = strchr(rgbw, order[i]);
+		if ((order[i] == '\0') || (p == NULL) || ((p - rgbw) >= bpp)) return -1;
+		map[i] = p - rgbw;
+	}
+	return 0;
+}
+
+//===============================================================================================
+void np_reorder(uint8_t *dst, const uint8_t *src, uint32_t npix, uint8_t bpp, const uint8_t *map)
+{
+	if (bpp == 3) {
+		uint8_t m0 = map[0], m1 = map[1], m2 = map[2];
+		for (uint32_t i=0; i<npix; i++) {
+			dst[0] = src[m0]; dst[1] = src[m1]; dst[2] = src[m2];
+			dst += 3;
+			src += 3;
+		}
+	}
+	else {
+		uint8_t m0 = map[0], m1 = map[1], m2 = map[2], m3 = map[3];
+		for (uint32_t i=0; i<npix; i++) {
+			dst[0] = src[m0]; dst[1] = src[m1]; dst[2] = src[m2]; dst[3] = src[m3];
+			dst += 4;
+			src += 4;
+		}
+	}
+}
+
+//=============================================================
+uint32_t np_hsv_to_rgb(uint16_t hue, uint8_t sat, uint8_t val)
+{
+	uint32_t r, g, b;
+	hue %= 1536;
+	uint32_t sector = hue >> 8;
+	uint32_t frac = hue & 0xFF;
+
+	uint32_t p = (val * (255 - sat)) / 255;
+	uint32_t q = (val * (255 - ((sat * frac) / 255))) / 255;
+	uint32_t t = (val * (255 - ((sat * (255 - frac)) / 255))) / 255;
+
+	switch (sector) {
+		case 0: r = val; g = t; b = p; break;
+		case 1: r = q; g = val; b = p; break;
+		case 2: r = p; g = val; b = t; break;
+		case 3: r = p; g = q; b = val; break;
+		case 4: r = t; g = p; b = val; break;
+		default: r = val; g = p; b = q; break;
+	}
+	return (r << 16) | (g << 8) | b;
+}
@@ -0,0 +1,79 @@
+/*
+ * This file is part of the MicroPython ESP32 project, https://github.com/loboris/MicroPython_ESP32_psRAM_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Table driven Neopixel pixel data to RMT items encoder.
+ *
+ * The RMT items for the bit values "1" and "0" are precomputed for every 4-bit nibble,
+ * so encoding a byte is two table lookups and eight 32-bit copies.
+ * Gamma correction and brightness are combined into the single 256 entries lookup table
+ * applied to each color byte while encoding.
+ *
+ * This module has no ESP-IDF dependencies and can be compiled on host.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef struct _np_encoder_t {
+	uint32_t nibble[16][4];		// RMT items for each nibble value, MSB first
+	uint32_t mark;				// RMT item for bit "1"
+	uint32_t space;				// RMT item for bit "0"
+	uint32_t reset;				// RMT item for reset (latch)
+	uint8_t lut[256];			// gamma and brightness correction
+	uint8_t lut_brightness;
+	float lut_gamma;
+} np_encoder_t;
+
+// Compose the RMT item value (same layout as rmt_item32_t)
+static inline uint32_t np_rmt_item(uint8_t level0, uint16_t duration0, uint8_t level1, uint16_t duration1) {
+	return ((uint32_t)(duration0 & 0x7FFF)) | ((uint32_t)(level0 & 1) << 15) |
+		   ((uint32_t)(duration1 & 0x7FFF) << 16) | ((uint32_t)(level1 & 1) << 31);
+}
+
+// Build the nibble table from the mark, space and reset RMT items
+void np_encode_init(np_encoder_t *enc, uint32_t mark, uint32_t space, uint32_t reset);
+
+// Build the correction table, only if gamma or brightness was changed
+// gamma 1.0 means no gamma correction
+void np_encode_lut(np_encoder_t *enc, float gamma, uint8_t brightness);
+
+// Encode 'len' color bytes into 'len' * 8 RMT items
+void np_encode_bytes(const np_encoder_t *enc, const uint8_t *src, uint32_t *dst, uint32_t len);
+
+// Build the map of the color order string ("GRB", "GRBW", ...), map[i] is the index of
+// the pixel's i-th byte color component in RGB(W) order
+// Returns -1 on invalid color order
+int np_order_map(const char *order, uint8_t bpp, uint8_t *map);
+
+// Copy 'npix' RGB(W) ordered pixels from 'src' into the pixel buffer in device color order
+void np_reorder(uint8_t *dst, const uint8_t *src, uint32_t npix, uint8_t bpp, const uint8_t *map);
+
+// Integer HSV to 24-bit RGB color conversion
+// hue: 0 ~ 1535 (6 * 256 steps), sat: 0 ~ 255, val: 0 ~ 255
+uint32_t np_hsv_to_rgb(uint16_t hue, uint8_t sat, uint8_t val);
@@ -515,6 +515,18 @@ int16_t ds18b20_read_raw_temp(const DS18B20_Info * ds18b20_info)
     return temp;
 }
 
+// Returns false if the device is not responding or the CRC check failed
+bool ds18b20_read_raw_temp_checked(const DS18B20_Info * ds18b20_info, int16_t *temp)
+{
+    int temper = _ds18b20_read_raw_temp(ds18b20_info);
+    if ((temper == -99999) || ((ds18b20_info->use_crc) && (temper == 0x8000))) {
+        *temp = 0;
+        return false;
+    }
+    *temp = _decode_temp_int((uint8_t)(temper & 0xFF), (uint8_t)(temper >> 8), ds18b20_info->resolution);
+    return true;
+}
+
 float ds18b20_read_temp(const DS18B20_Info * ds18b20_info)
 {
     float temp = 0.0f;
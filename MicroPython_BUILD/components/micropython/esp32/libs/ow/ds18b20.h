@@ -180,6 +180,7 @@ uint32_t _wait_for_conversion(DS18B20_RESOLUTION resolution);
  */
 float ds18b20_read_temp(const DS18B20_Info * ds18b20_info);
 int16_t ds18b20_read_raw_temp(const DS18B20_Info * ds18b20_info);
+bool ds18b20_read_raw_temp_checked(const DS18B20_Info * ds18b20_info, int16_t *temp);
 
 /**
  * @brief Convert, wait and read current temperature from device.
@@ -0,0 +1,150 @@
+/*
+ * This file is part of the MicroPython ESP32 project, https://github.com/loboris/MicroPython_ESP32_psRAM_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <string.h>
+
+#include "sensor_sched.h"
+
+#define PHASE_IDLE      0
+#define PHASE_CONVERT   1
+#define PHASE_BATCH     2
+#define PHASE_DONE      3
+
+
+//-------------------------------------------------------------------------------------------------------------------------------
+void sensor_sched_init(sensor_sched_t *s, sensor_dev_t *devs, uint16_t max, uint64_t (*now_us)(void), void (*delay_us)(uint32_t us))
+{
+    memset(s, 0, sizeof(sensor_sched_t));
+    s->devs = devs;
+    s->max = max;
+    s->now_us = now_us;
+    s->delay_us = delay_us;
+}
+
+//------------------------------------------------------------
+int sensor_sched_add(sensor_sched_t *s, const sensor_dev_t *tmpl)
+{
+    if (s->ndevs >= s->max) return -1;
+    if ((tmpl->start_len > SENSOR_CMD_MAX) || (tmpl->rcmd_len > SENSOR_CMD_MAX)) return -1;
+    if ((tmpl->ops == NULL) || (tmpl->ops->xfer == NULL)) return -1;
+    if ((tmpl->flags & SENSOR_FLAG_BROADCAST) && (tmpl->ops->broadcast == NULL)) return -1;
+    if (((uint32_t)s->size + tmpl->read_len) > 0xFFFF) return -1;
+
+    sensor_dev_t *d = s->devs + s->ndevs;
+    *d = *tmpl;
+    d->offset = s->size;
+    d->status = 0;
+    d->phase = PHASE_IDLE;
+    s->size += d->read_len;
+    s->ndevs++;
+    return d->offset;
+}
+
+// Execute the batch on the bus, the devices in 'from' phase are moved to PHASE_DONE
+// or to 'to' phase; on batch failure the status of all batch devices is set
+//--------------------------------------------------------------------------------------------------
+static void _end_batch(sensor_sched_t *s, sensor_dev_t *first, int batched, uint8_t from, uint8_t to)
+{
+    int res = 0;
+    if ((batched) && (first->ops->end)) {
+        res = first->ops->end(first->bus);
+        s->batches++;
+    }
+    for (sensor_dev_t *d = s->devs; d < (s->devs + s->ndevs); d++) {
+        if ((d->bus != first->bus) || (d->phase != from)) continue;
+        if ((res) && (d->status == 0)) d->status = res;
+        d->phase = (d->status) ? PHASE_DONE : to;
+    }
+}
+
+//-----------------------------------------------------
+int sensor_sched_run(sensor_sched_t *s, uint8_t *result)
+{
+    sensor_dev_t *d, *e;
+    sensor_dev_t *end = s->devs + s->ndevs;
+    uint64_t t, t_start = s->now_us();
+    int failed = 0;
+
+    for (d = s->devs; d < end; d++) {
+        d->phase = PHASE_IDLE;
+        d->status = 0;
+    }
+
+    // === Start the conversions, bus by bus ===
+    for (d = s->devs; d < end; d++) {
+        if (d->phase != PHASE_IDLE) continue;
+        int batched = (d->ops->begin) ? (d->ops->begin(d->bus) == 0) : 0;
+        int bcast = 1; // broadcast not yet issued
+        for (e = d; e < end; e++) {
+            if (e->bus != d->bus) continue;
+            if (e->flags & SENSOR_FLAG_BROADCAST) {
+                if (bcast == 1) bcast = (e->ops->broadcast(e->bus) == 0) ? 0 : -1;
+                if (bcast) e->status = -1;
+            }
+            else if (e->start_len) e->status = e->ops->xfer(e->bus, e, e->start, e->start_len, NULL, 0);
+            e->phase = PHASE_BATCH;
+        }
+        _end_batch(s, d, batched, PHASE_BATCH, PHASE_CONVERT);
+        // conversions are started when the batch is executed
+        t = s->now_us();
+        for (e = d; e < end; e++) {
+            if ((e->bus == d->bus) && (e->phase == PHASE_CONVERT)) e->ready = t + e->wait_us;
+        }
+    }
+
+    // === Read the devices in the order they become ready ===
+    for (;;) {
+        sensor_dev_t *next = NULL;
+        for (d = s->devs; d < end; d++) {
+            if ((d->phase == PHASE_CONVERT) && ((next == NULL) || (d->ready < next->ready))) next = d;
+        }
+        if (next == NULL) break;
+
+        t = s->now_us();
+        if (next->ready > t) {
+            s->delay_us((uint32_t)(next->ready - t));
+            t = s->now_us();
+        }
+        // read all ready devices on the same bus in one batch
+        int batched = (next->ops->begin) ? (next->ops->begin(next->bus) == 0) : 0;
+        for (d = s->devs; d < end; d++) {
+            if ((d->bus != next->bus) || (d->phase != PHASE_CONVERT) || (d->ready > t)) continue;
+            if ((d->rcmd_len) || (d->read_len)) {
+                d->status = d->ops->xfer(d->bus, d, d->rcmd, d->rcmd_len, result + d->offset, d->read_len);
+            }
+            d->phase = PHASE_BATCH;
+        }
+        _end_batch(s, next, batched, PHASE_BATCH, PHASE_DONE);
+    }
+
+    for (d = s->devs; d < end; d++) {
+        if (d->status) failed++;
+    }
+    s->cycles++;
+    s->errors += failed;
+    s->last_us = (uint32_t)(s->now_us() - t_start);
+    return failed;
+}
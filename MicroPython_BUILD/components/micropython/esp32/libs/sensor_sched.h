@@ -0,0 +1,113 @@
+/*
+ * This file is part of the MicroPython ESP32 project, https://github.com/loboris/MicroPython_ESP32_psRAM_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Batched multi-device sensor acquisition scheduler.
+ *
+ * Each device is described by the transaction template:
+ *   write 'start' command (starts the conversion), wait 'wait_us',
+ *   write 'rcmd' command (usually the register address) and read 'read_len' bytes.
+ * Devices with SENSOR_FLAG_BROADCAST have the conversion started by a single
+ * bus broadcast (e.g. 1-Wire SKIP_ROM + CONVERT_T) for all such devices on the bus.
+ *
+ * The acquisition cycle first starts the conversions on all devices, bus by bus,
+ * then reads the devices in the order they become ready, so the total cycle time is
+ * close to the longest conversion time instead of the sum of all conversion times.
+ * Transactions issued to the same bus at the same time are grouped between the
+ * bus 'begin' and 'end' calls, so the bus backend can execute them as one batch
+ * (e.g. single I2C command link).
+ * The results are stored into the caller provided buffer at each device's offset.
+ *
+ * Bus access and timing are provided by the caller, this module has no ESP-IDF or
+ * MicroPython dependencies and is tested on host with a simulated bus (tests/host/test_sensor_sched.c).
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define SENSOR_CMD_MAX          8
+#define SENSOR_FLAG_BROADCAST   0x01
+
+struct _sensor_dev_t;
+
+typedef struct _sensor_bus_ops_t {
+    // Start the batch of transactions, optional
+    int (*begin)(void *bus);
+    // Write 'wlen' bytes, then read 'rlen' bytes; with batching the read data
+    // may only be valid after 'end'. Returns 0 on success
+    int (*xfer)(void *bus, struct _sensor_dev_t *dev, const uint8_t *wbuf, uint8_t wlen, uint8_t *rbuf, uint8_t rlen);
+    // Execute the batch of transactions, optional. Returns 0 on success
+    int (*end)(void *bus);
+    // Start the conversion on all broadcast devices on the bus. Returns 0 on success
+    int (*broadcast)(void *bus);
+} sensor_bus_ops_t;
+
+typedef struct _sensor_dev_t {
+    const sensor_bus_ops_t *ops;
+    void *bus;                          // bus handle, devices with the same handle share the bus
+    void *dev;                          // backend specific device handle
+    void *obj;                          // owner object, not used by the scheduler
+    uint32_t addr;                      // device address
+    uint32_t wait_us;                   // conversion time
+    uint8_t start[SENSOR_CMD_MAX];      // command starting the conversion
+    uint8_t rcmd[SENSOR_CMD_MAX];       // command written before reading
+    uint8_t start_len;
+    uint8_t rcmd_len;
+    uint8_t read_len;
+    uint8_t flags;
+    uint16_t offset;                    // result offset
+    int16_t status;                     // status of the last acquisition, 0: OK
+    // acquisition state
+    uint8_t phase;
+    uint64_t ready;
+} sensor_dev_t;
+
+typedef struct _sensor_sched_t {
+    sensor_dev_t *devs;
+    uint16_t ndevs;
+    uint16_t max;
+    uint16_t size;                      // result buffer size needed
+    uint64_t (*now_us)(void);
+    void (*delay_us)(uint32_t us);
+    // statistics
+    uint32_t cycles;
+    uint32_t errors;                    // total failed device reads
+    uint32_t batches;                   // total bus batches executed
+    uint32_t last_us;                   // duration of the last acquisition cycle
+} sensor_sched_t;
+
+// Initialize the scheduler using the provided device array
+void sensor_sched_init(sensor_sched_t *s, sensor_dev_t *devs, uint16_t max, uint64_t (*now_us)(void), void (*delay_us)(uint32_t us));
+
+// Add the device, the template is copied
+// Returns the device's result offset or -1 if no more devices can be added
+int sensor_sched_add(sensor_sched_t *s, const sensor_dev_t *tmpl);
+
+// Run one acquisition cycle, 'result' must be at least 's->size' bytes
+// Returns the number of devices which failed
+int sensor_sched_run(sensor_sched_t *s, uint8_t *result);
@@ -0,0 +1,193 @@
+/*
+ * This file is part of the MicroPython ESP32 project, https://github.com/loboris/MicroPython_ESP32_psRAM_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <string.h>
+
+#include "spi_queue.h"
+
+#define ALIGN4(x)   (((x) + 3) & ~3UL)
+
+//--------------------------------------------------------------------------------------------------------------------
+void spi_queue_init(spi_queue_t *q, const spi_queue_ops_t *ops, void *bus, spi_queue_desc_t *desc, uint16_t max_desc,
+                    uint8_t *mem, uint32_t mem_size, uint32_t max_xfer, uint8_t depth)
+{
+    memset(q, 0, sizeof(spi_queue_t));
+    q->ops = ops;
+    q->bus = bus;
+    q->desc = desc;
+    q->max_desc = max_desc;
+    q->mem = mem;
+    q->mem_size = mem_size;
+    q->max_xfer = max_xfer;
+    q->depth = (depth) ? depth : 1;
+    q->state = SPI_QUEUE_IDLE;
+}
+
+//------------------------------------
+int spi_queue_clear(spi_queue_t *q)
+{
+    if (q->state == SPI_QUEUE_RUNNING) return SPI_QUEUE_ERR_BUSY;
+    q->ndesc = 0;
+    q->mem_used = 0;
+    q->completed = 0;
+    q->state = SPI_QUEUE_IDLE;
+    return 0;
+}
+
+//--------------------------------------------------------------------------------------------------------------
+int spi_queue_add(spi_queue_t *q, int cs, const uint8_t *tx, uint32_t tx_len, uint32_t rx_len, uint8_t flags)
+{
+    if (q->state == SPI_QUEUE_RUNNING) return SPI_QUEUE_ERR_BUSY;
+    if ((tx_len == 0) && (rx_len == 0)) return SPI_QUEUE_ERR_ARG;
+    if ((tx_len > q->max_xfer) || (rx_len > q->max_xfer)) return SPI_QUEUE_ERR_ARG;
+    if ((tx_len) && (tx == NULL)) return SPI_QUEUE_ERR_ARG;
+    if ((cs < SPI_QUEUE_CS_DEFAULT) || (cs > INT16_MAX)) return SPI_QUEUE_ERR_ARG;
+
+    if ((q->ndesc > 0) && (rx_len == 0)) {
+        // merge with the previous send-only transaction in the same CS frame
+        spi_queue_desc_t *prev = &q->desc[q->ndesc-1];
+        if ((prev->flags & SPI_QUEUE_KEEP_CS) && (prev->cs == cs) && (prev->rx_len == 0) &&
+                ((prev->tx_off + prev->tx_len) == q->mem_used) && ((prev->tx_len + tx_len) <= q->max_xfer) &&
+                (tx_len <= (q->mem_size - q->mem_used))) {
+            memcpy(q->mem + q->mem_used, tx, tx_len);
+            q->mem_used += tx_len;
+            prev->tx_len += tx_len;
+            prev->flags = flags;
+            prev->merged++;
+            return q->ndesc-1;
+        }
+    }
+    if (q->ndesc >= q->max_desc) return SPI_QUEUE_ERR_FULL;
+
+    // DMA buffers start at word boundary
+    uint32_t tx_off = ALIGN4(q->mem_used);
+    uint32_t rx_off = ALIGN4(tx_off + tx_len);
+    uint32_t end = (rx_len) ? ALIGN4(rx_off + rx_len) : tx_off + tx_len;
+    if (end > q->mem_size) return SPI_QUEUE_ERR_NOMEM;
+
+    spi_queue_desc_t *d = &q->desc[q->ndesc];
+    d->tx_off = tx_off;
+    d->tx_len = tx_len;
+    d->rx_off = rx_off;
+    d->rx_len = rx_len;
+    d->cs = cs;
+    d->flags = flags;
+    d->merged = 0;
+    if (tx_len) memcpy(q->mem + tx_off, tx, tx_len);
+    if (rx_len) memset(q->mem + rx_off, 0, rx_len);
+    q->mem_used = end;
+    return q->ndesc++;
+}
+
+//-------------------------------------------------------------
+uint8_t *spi_queue_rx(spi_queue_t *q, int idx, uint32_t *len)
+{
+    if ((idx < 0) || (idx >= q->ndesc) || (q->desc[idx].rx_len == 0)) {
+        *len = 0;
+        return NULL;
+    }
+    *len = q->desc[idx].rx_len;
+    return q->mem + q->desc[idx].rx_off;
+}
+
+// Wait for the oldest started transfer and account it
+//-------------------------------------------
+static int _wait_one(spi_queue_t *q)
+{
+    if (q->ops->wait(q->bus) != 0) return SPI_QUEUE_ERR_BUS;
+    spi_queue_desc_t *d = &q->desc[q->completed];
+    if (q->stats) {
+        q->stats->transactions++;
+        q->stats->bytes_tx += d->tx_len;
+        q->stats->bytes_rx += d->rx_len;
+    }
+    q->completed++;
+    return 0;
+}
+
+//----------------------------------
+int spi_queue_run(spi_queue_t *q)
+{
+    if (q->state == SPI_QUEUE_RUNNING) return SPI_QUEUE_ERR_BUSY;
+    q->state = SPI_QUEUE_RUNNING;
+    q->completed = 0;
+
+    uint64_t t_start = (q->ops->time_us) ? q->ops->time_us() : 0;
+    int res = 0;
+    int active = 0;         // CS is active
+    int outstanding = 0;    // started, not completed transfers
+    spi_queue_desc_t *d = NULL;
+
+    for (int i=0; i<q->ndesc; i++) {
+        d = &q->desc[i];
+        if (!active) {
+            if (q->ops->select(q->bus, d->cs) != 0) {
+                res = SPI_QUEUE_ERR_BUS;
+                break;
+            }
+            active = 1;
+        }
+        if (outstanding >= q->depth) {
+            if ((res = _wait_one(q)) != 0) break;
+            outstanding--;
+        }
+        if (q->ops->start(q->bus, (d->tx_len) ? q->mem + d->tx_off : NULL, d->tx_len,
+                                  (d->rx_len) ? q->mem + d->rx_off : NULL, d->rx_len) != 0) {
+            res = SPI_QUEUE_ERR_BUS;
+            break;
+        }
+        outstanding++;
+
+        // the frame ends unless the next transaction continues it
+        if ((d->flags & SPI_QUEUE_KEEP_CS) && ((i+1) < q->ndesc) && (q->desc[i+1].cs == d->cs)) continue;
+        while (outstanding > 0) {
+            if ((res = _wait_one(q)) != 0) break;
+            outstanding--;
+        }
+        if (res != 0) break;
+        q->ops->deselect(q->bus, d->cs);
+        active = 0;
+    }
+
+    if (res != 0) {
+        // complete the already started transfers, release the bus
+        while (outstanding > 0) {
+            if (_wait_one(q) != 0) break;
+            outstanding--;
+        }
+        if ((active) && (d)) q->ops->deselect(q->bus, d->cs);
+    }
+
+    q->run_us = (q->ops->time_us) ? (uint32_t)(q->ops->time_us() - t_start) : 0;
+    if (q->stats) {
+        q->stats->batches++;
+        q->stats->busy_us += q->run_us;
+        if (res != 0) q->stats->errors++;
+    }
+    q->result = res;
+    q->state = SPI_QUEUE_DONE;
+    return res;
+}
@@ -0,0 +1,130 @@
+/*
+ * This file is part of the MicroPython ESP32 project, https://github.com/loboris/MicroPython_ESP32_psRAM_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Queue of SPI transactions executed back to back.
+ *
+ * Each transaction descriptor has the CS pin, the data to send and the number
+ * of bytes to receive. The send data is copied into the queue's data buffer
+ * (allocated by the caller from DMA capable memory), the received data is stored
+ * in the same buffer, so the transactions can be executed with DMA without
+ * any further copying.
+ * By default each transaction is framed by its own CS activation. With
+ * SPI_QUEUE_KEEP_CS the next transaction on the same CS continues the frame;
+ * the transactions in the frame are started without waiting for the previous
+ * one to complete (up to 'depth' outstanding), and the consecutive send-only
+ * transactions are merged into one transfer when added.
+ *
+ * Bus access is provided by the caller, this module has no ESP-IDF or
+ * MicroPython dependencies and is tested on host with a simulated bus
+ * (tests/host/test_spi_queue.c).
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define SPI_QUEUE_CS_DEFAULT    -1      // use the device's CS pin
+#define SPI_QUEUE_KEEP_CS       0x01    // keep CS active for the next transaction
+
+#define SPI_QUEUE_ERR_ARG       -1      // invalid descriptor
+#define SPI_QUEUE_ERR_FULL      -2      // no free descriptor
+#define SPI_QUEUE_ERR_NOMEM     -3      // no space in the data buffer
+#define SPI_QUEUE_ERR_BUSY      -4      // the queue is being executed
+#define SPI_QUEUE_ERR_BUS       -5      // bus error while executing
+
+#define SPI_QUEUE_IDLE          0
+#define SPI_QUEUE_RUNNING       1
+#define SPI_QUEUE_DONE          2
+
+typedef struct _spi_queue_ops_t {
+    // Activate/deactivate the CS pin (and take/release the bus). Return 0 on success
+    int (*select)(void *bus, int cs);
+    int (*deselect)(void *bus, int cs);
+    // Start the transfer, send 'txlen' bytes then receive 'rxlen' bytes, may return before
+    // the transfer is completed. Returns 0 on success
+    int (*start)(void *bus, const uint8_t *tx, uint32_t txlen, uint8_t *rx, uint32_t rxlen);
+    // Wait for the oldest started transfer to complete. Returns 0 on success
+    int (*wait)(void *bus);
+    uint64_t (*time_us)(void);
+} spi_queue_ops_t;
+
+// Bus throughput counters, can be shared by several queues on the same bus
+typedef struct _spi_queue_stats_t {
+    uint32_t transactions;      // transfers executed
+    uint32_t batches;           // queue runs
+    uint32_t errors;
+    uint64_t bytes_tx;
+    uint64_t bytes_rx;
+    uint64_t busy_us;           // total time spent executing the queues
+} spi_queue_stats_t;
+
+typedef struct _spi_queue_desc_t {
+    uint32_t tx_off;            // send data offset in the data buffer
+    uint32_t tx_len;
+    uint32_t rx_off;            // receive data offset in the data buffer
+    uint32_t rx_len;
+    int16_t cs;
+    uint8_t flags;
+    uint8_t merged;             // number of transactions merged into this one
+} spi_queue_desc_t;
+
+typedef struct _spi_queue_t {
+    const spi_queue_ops_t *ops;
+    void *bus;
+    spi_queue_desc_t *desc;
+    uint16_t max_desc;
+    uint16_t ndesc;
+    uint8_t *mem;               // data buffer
+    uint32_t mem_size;
+    uint32_t mem_used;
+    uint32_t max_xfer;          // maximal single transfer length
+    uint8_t depth;              // maximal number of started, not completed transfers
+    volatile uint8_t state;     // SPI_QUEUE_xxx
+    volatile uint16_t completed;// completed descriptors in the current run
+    int result;                 // result of the last run, 0 or SPI_QUEUE_ERR_BUS
+    uint32_t run_us;            // duration of the last run
+    spi_queue_stats_t *stats;   // optional
+} spi_queue_t;
+
+// Initialize the queue using the provided descriptor array and data buffer
+void spi_queue_init(spi_queue_t *q, const spi_queue_ops_t *ops, void *bus, spi_queue_desc_t *desc, uint16_t max_desc,
+                    uint8_t *mem, uint32_t mem_size, uint32_t max_xfer, uint8_t depth);
+
+// Remove all transactions
+int spi_queue_clear(spi_queue_t *q);
+
+// Add the transaction, 'tx' is copied into the data buffer
+// Returns the descriptor index or SPI_QUEUE_ERR_xxx
+int spi_queue_add(spi_queue_t *q, int cs, const uint8_t *tx, uint32_t tx_len, uint32_t rx_len, uint8_t flags);
+
+// Get the received data of the descriptor, NULL if the descriptor does not receive
+uint8_t *spi_queue_rx(spi_queue_t *q, int idx, uint32_t *len);
+
+// Execute all transactions, returns 0 or SPI_QUEUE_ERR_xxx
+// On error, 'completed' is the number of descriptors executed successfully
+int spi_queue_run(spi_queue_t *q);
@@ -49,6 +49,7 @@
 #include "rom/tjpgd.h"
 #include "esp_heap_caps.h"
 #include "tftspi.h"
+#include "tft_geom.h"
 
 #if CONFIG_MICROPY_USE_EVE
 #include "eve/FT8.h"
@@ -590,6 +591,73 @@ void TFT_fillWindow(color_t color) {
 			color, (uint32_t)((dispWin.x2-dispWin.x1+1) * (dispWin.y2-dispWin.y1+1)));
 }
 
+// ==== Span filling ====
+// Adjacent spans or rectangles of the same size are merged and sent as one rectangle
+
+typedef struct {
+	int x;
+	int y;
+	int w;
+	int h;
+} fill_rect_t;
+
+//----------------------------------------------------------
+static void _fill_rect_flush(fill_rect_t *r, color_t color)
+{
+	if ((r->w <= 0) || (r->h <= 0)) {
+		r->w = 0;
+		return;
+	}
+	int x1 = r->x;
+	int y1 = r->y;
+	int x2 = r->x + r->w - 1;
+	int y2 = r->y + r->h - 1;
+	r->w = 0;
+
+	// clipping
+	if (x1 < dispWin.x1) x1 = dispWin.x1;
+	if (y1 < dispWin.y1) y1 = dispWin.y1;
+	if (x2 > dispWin.x2) x2 = dispWin.x2;
+	if (y2 > dispWin.y2) y2 = dispWin.y2;
+	if ((x1 > x2) || (y1 > y2)) return;
+
+	TFT_EPD_pushColorRep(x1, y1, x2, y2, color, (uint32_t)((x2-x1+1) * (y2-y1+1)));
+}
+
+//------------------------------------------------------------------------------------
+static void _fill_rect_add(fill_rect_t *r, int x, int y, int w, int h, color_t color)
+{
+	if (r->w > 0) {
+		if ((r->x == x) && (r->w == w)) {
+			if (y == (r->y + r->h)) {
+				r->h += h;
+				return;
+			}
+			if ((y + h) == r->y) {
+				r->y = y;
+				r->h += h;
+				return;
+			}
+		}
+		if ((r->y == y) && (r->h == h)) {
+			if (x == (r->x + r->w)) {
+				r->w += w;
+				return;
+			}
+			if ((x + w) == r->x) {
+				r->x = x;
+				r->w += w;
+				return;
+			}
+		}
+		_fill_rect_flush(r, color);
+	}
+	r->x = x;
+	r->y = y;
+	r->w = w;
+	r->h = h;
+}
+
 // ^^^============= Basics drawing functions ================================^^^
 
 
@@ -719,21 +787,25 @@ void TFT_fillRoundRect(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t r,
 //-----------------------------------------------------------------------------------------------
 static void _drawLineByAngle(int16_t x, int16_t y, int16_t angle, uint16_t length, color_t color)
 {
+	int32_t a = (angle * TFT_ANGLE_ONE) + tft_angle(_angleOffset);
 	_drawLine(
 		x,
 		y,
-		x + length * cos((angle + _angleOffset) * DEG_TO_RAD),
-		y + length * sin((angle + _angleOffset) * DEG_TO_RAD), color);
+		tft_fix_pos(x, length, tft_cos(a)),
+		tft_fix_pos(y, length, tft_sin(a)), color);
 }
 
 //---------------------------------------------------------------------------------------------------------------
 static void _DrawLineByAngle(int16_t x, int16_t y, int16_t angle, uint16_t start, uint16_t length, color_t color)
 {
+	int32_t a = (angle * TFT_ANGLE_ONE) + tft_angle(_angleOffset);
+	int32_t ca = tft_cos(a);
+	int32_t sa = tft_sin(a);
 	_drawLine(
-		x + start * cos((angle + _angleOffset) * DEG_TO_RAD),
-		y + start * sin((angle + _angleOffset) * DEG_TO_RAD),
-		x + (start + length) * cos((angle + _angleOffset) * DEG_TO_RAD),
-		y + (start + length) * sin((angle + _angleOffset) * DEG_TO_RAD), color);
+		tft_fix_pos(x, start, ca),
+		tft_fix_pos(y, start, sa),
+		tft_fix_pos(x, start + length, ca),
+		tft_fix_pos(y, start + length, sa), color);
 }
 
 //===========================================================================================================
@@ -895,13 +967,41 @@ void TFT_drawCircle(int16_t x, int16_t y, int radius, color_t color) {
   TFT_EPD_disp_deselect();
 }
 
+// The circle is filled by rows, the rows of the same width are merged
 //====================================================================
 void TFT_fillCircle(int16_t x, int16_t y, int radius, color_t color) {
 	x += dispWin.x1;
 	y += dispWin.y1;
 
-	_drawFastVLine(x, y-radius, 2*radius+1, color);
-	fillCircleHelper(x, y, radius, 3, 0, color);
+	// upper/lower rows near the center, upper/lower rows near the top and bottom
+	fill_rect_t rect[4] = { { 0 } };
+	int f = 1 - radius;
+	int ddF_x = 1;
+	int ddF_y = -2 * radius;
+	int x1 = 0;
+	int y1 = radius;
+	int ylm = radius;
+
+	_fill_rect_add(&rect[0], x - radius, y, 2 * radius + 1, 1, color);
+	while (x1 < y1) {
+		if (f >= 0) {
+			_fill_rect_add(&rect[2], x - x1, y - y1, 2 * x1 + 1, 1, color);
+			_fill_rect_add(&rect[3], x - x1, y + y1, 2 * x1 + 1, 1, color);
+			ylm = y1;
+			y1--;
+			ddF_y += 2;
+			f += ddF_y;
+		}
+		x1++;
+		ddF_x += 2;
+		f += ddF_x;
+
+		if (x1 < ylm) {
+			_fill_rect_add(&rect[0], x - y1, y - x1, 2 * y1 + 1, 1, color);
+			_fill_rect_add(&rect[1], x - y1, y + x1, 2 * y1 + 1, 1, color);
+		}
+	}
+	for (int i=0; i<4; i++) _fill_rect_flush(&rect[i], color);
 }
 
 //----------------------------------------------------------------------------------------------------------------
@@ -1006,19 +1106,26 @@ void TFT_drawEllipse(uint16_t x0, uint16_t y0, uint16_t rx, uint16_t ry, color_t
 	}
 }
 
-//-----------------------------------------------------------------------------------------------------------------------
-static void _draw_filled_ellipse_section(uint16_t x, uint16_t y, uint16_t x0, uint16_t y0, color_t color, uint8_t option)
+// Add the ellipse row 'y' (relative to the center) of half width 'x'
+//----------------------------------------------------------------------------------------------------------------------
+static void _fill_ellipse_row(fill_rect_t *rect, int x, int y, int x0, int y0, color_t color, uint8_t left, uint8_t right)
 {
-    // upper right
-    if ( option & TFT_ELLIPSE_UPPER_RIGHT ) _drawFastVLine(x0+x, y0-y, y+1, color);
-    // upper left
-    if ( option & TFT_ELLIPSE_UPPER_LEFT ) _drawFastVLine(x0-x, y0-y, y+1, color);
-    // lower right
-    if ( option & TFT_ELLIPSE_LOWER_RIGHT ) _drawFastVLine(x0+x, y0, y+1, color);
-    // lower left
-    if ( option & TFT_ELLIPSE_LOWER_LEFT ) _drawFastVLine(x0-x, y0, y+1, color);
+	if ((left) && (right)) _fill_rect_add(rect, x0 - x, y0 + y, 2 * x + 1, 1, color);
+	else if (right) _fill_rect_add(rect, x0, y0 + y, x + 1, 1, color);
+	else if (left) _fill_rect_add(rect, x0 - x, y0 + y, x + 1, 1, color);
+}
+
+// Add the ellipse column 'x' (relative to the center) of half height 'y'
+//----------------------------------------------------------------------------------------------------------------------
+static void _fill_ellipse_col(fill_rect_t *rect, int x, int y, int x0, int y0, color_t color, uint8_t upper, uint8_t lower)
+{
+	if ((upper) && (lower)) _fill_rect_add(rect, x0 + x, y0 - y, 1, 2 * y + 1, color);
+	else if (upper) _fill_rect_add(rect, x0 + x, y0 - y, 1, y + 1, color);
+	else if (lower) _fill_rect_add(rect, x0 + x, y0, 1, y + 1, color);
 }
 
+// The ellipse is filled by rows where it is steep and by columns where it is flat,
+// the rows or columns of the same size are merged
 //=====================================================================================================
 void TFT_fillEllipse(uint16_t x0, uint16_t y0, uint16_t rx, uint16_t ry, color_t color, uint8_t option)
 {
@@ -1031,6 +1138,8 @@ void TFT_fillEllipse(uint16_t x0, uint16_t y0, uint16_t rx, uint16_t ry, color_t
 	int32_t rxrx2;
 	int32_t ryry2;
 	int32_t stopx, stopy;
+	// upper rows, lower rows, right columns, left columns
+	fill_rect_t rect[4] = { { 0 } };
 
 	rxrx2 = rx;
 	rxrx2 *= rx;
@@ -1059,7 +1168,8 @@ void TFT_fillEllipse(uint16_t x0, uint16_t y0, uint16_t rx, uint16_t ry, color_t
 	stopy = 0;
 
 	while( stopx >= stopy ) {
-		_draw_filled_ellipse_section(x, y, x0, y0, color, option);
+		_fill_ellipse_row(&rect[0], x, -y, x0, y0, color, option & TFT_ELLIPSE_UPPER_LEFT, option & TFT_ELLIPSE_UPPER_RIGHT);
+		_fill_ellipse_row(&rect[1], x, y, x0, y0, color, option & TFT_ELLIPSE_LOWER_LEFT, option & TFT_ELLIPSE_LOWER_RIGHT);
 		y++;
 		stopy += rxrx2;
 		err += ychg;
@@ -1092,7 +1202,15 @@ void TFT_fillEllipse(uint16_t x0, uint16_t y0, uint16_t rx, uint16_t ry, color_t
 	stopy *= ry;
 
 	while( stopx <= stopy ) {
-		_draw_filled_ellipse_section(x, y, x0, y0, color, option);
+		if (x == 0) {
+			// the center column belongs to both sides
+			_fill_ellipse_col(&rect[2], 0, y, x0, y0, color, option & (TFT_ELLIPSE_UPPER_RIGHT | TFT_ELLIPSE_UPPER_LEFT),
+					option & (TFT_ELLIPSE_LOWER_RIGHT | TFT_ELLIPSE_LOWER_LEFT));
+		}
+		else {
+			_fill_ellipse_col(&rect[2], x, y, x0, y0, color, option & TFT_ELLIPSE_UPPER_RIGHT, option & TFT_ELLIPSE_LOWER_RIGHT);
+			_fill_ellipse_col(&rect[3], -x, y, x0, y0, color, option & TFT_ELLIPSE_UPPER_LEFT, option & TFT_ELLIPSE_LOWER_LEFT);
+		}
 		x++;
 		stopx += ryry2;
 		err += xchg;
@@ -1104,51 +1222,31 @@ void TFT_fillEllipse(uint16_t x0, uint16_t y0, uint16_t rx, uint16_t ry, color_t
 			ychg += rxrx2;
 		}
 	}
+	for (int i=0; i<4; i++) _fill_rect_flush(&rect[i], color);
 }
 
 
 // ==== ARC DRAWING ===================================================================
 
-//---------------------------------------------------------------------------------------------------------------------------------
-static void _fillArcOffsetted(uint16_t cx, uint16_t cy, uint16_t radius, uint16_t thickness, float start, float end, color_t color)
+// The arc is filled by rows, 'start' and 'end' are given in 1/256 degree units
+//-------------------------------------------------------------------------------------------------------------------------------------
+static void _fillArcOffsetted(uint16_t cx, uint16_t cy, uint16_t radius, uint16_t thickness, int32_t start, int32_t end, color_t color)
 {
-	//float sslope = (float)cos_lookup(start) / (float)sin_lookup(start);
-	//float eslope = (float)cos_lookup(end) / (float)sin_lookup(end);
-	float sslope = (cos(start/_arcAngleMax * 2 * PI) * _arcAngleMax) / (sin(start/_arcAngleMax * 2 * PI) * _arcAngleMax) ;
-	float eslope = (cos(end/_arcAngleMax * 2 * PI) * _arcAngleMax) / (sin(end/_arcAngleMax * 2 * PI) * _arcAngleMax);
-
-	if (end == 360) eslope = -1000000;
+	tft_arc_t arc;
+	int spans[4];
+	// left and right side spans
+	fill_rect_t rect[2] = { { 0 } };
 
-	int ir2 = (radius - thickness) * (radius - thickness);
-	int or2 = radius * radius;
+	tft_arc_init(&arc, radius, thickness, start, end);
 
-	TFT_EPD_disp_select();
-	for (int x = -radius; x <= radius; x++) {
-		for (int y = -radius; y <= radius; y++) {
-			int x2 = x * x;
-			int y2 = y * y;
-
-			if (
-				(x2 + y2 < or2 && x2 + y2 >= ir2) &&
-				(
-				(y > 0 && start < 180 && x <= y * sslope) ||
-				(y < 0 && start > 180 && x >= y * sslope) ||
-				(y < 0 && start <= 180) ||
-				(y == 0 && start <= 180 && x < 0) ||
-				(y == 0 && start == 0 && x > 0)
-				) &&
-				(
-				(y > 0 && end < 180 && x >= y * eslope) ||
-				(y < 0 && end > 180 && x <= y * eslope) ||
-				(y > 0 && end >= 180) ||
-				(y == 0 && end >= 180 && x < 0) ||
-				(y == 0 && start == 0 && x > 0)
-				)
-				)
-				TFT_EPD_drawPixe(cx+x, cy+y, color, 0);
+	for (int y = -radius; y <= radius; y++) {
+		int n = tft_arc_row(&arc, y, spans);
+		for (int i=0; i<n; i++) {
+			_fill_rect_add(&rect[(spans[i*2] < 0) ? 0 : 1], cx + spans[i*2], cy + y, spans[i*2+1] - spans[i*2] + 1, 1, color);
 		}
 	}
-	TFT_EPD_disp_deselect();
+	_fill_rect_flush(&rect[0], color);
+	_fill_rect_flush(&rect[1], color);
 }
 
 
@@ -1174,28 +1272,36 @@ void TFT_drawArc(uint16_t cx, uint16_t cy, uint16_t r, uint16_t th, float start,
 
 	if (aend == 0) aend = (float)360;
 
+	int32_t as = tft_angle(astart);
+	int32_t ae = tft_angle(aend);
+	int32_t amax = tft_angle(_arcAngleMax);
+
 	if (astart > aend) {
-		_fillArcOffsetted(cx, cy, r, th, astart, _arcAngleMax, fillcolor);
-		_fillArcOffsetted(cx, cy, r, th, 0, aend, fillcolor);
+		_fillArcOffsetted(cx, cy, r, th, as, amax, fillcolor);
+		_fillArcOffsetted(cx, cy, r, th, 0, ae, fillcolor);
 		if (f) {
-			_fillArcOffsetted(cx, cy, r, 1, astart, _arcAngleMax, color);
-			_fillArcOffsetted(cx, cy, r, 1, 0, aend, color);
-			_fillArcOffsetted(cx, cy, r-th, 1, astart, _arcAngleMax, color);
-			_fillArcOffsetted(cx, cy, r-th, 1, 0, aend, color);
+			_fillArcOffsetted(cx, cy, r, 1, as, amax, color);
+			_fillArcOffsetted(cx, cy, r, 1, 0, ae, color);
+			_fillArcOffsetted(cx, cy, r-th, 1, as, amax, color);
+			_fillArcOffsetted(cx, cy, r-th, 1, 0, ae, color);
 		}
 	}
 	else {
-		_fillArcOffsetted(cx, cy, r, th, astart, aend, fillcolor);
+		_fillArcOffsetted(cx, cy, r, th, as, ae, fillcolor);
 		if (f) {
-			_fillArcOffsetted(cx, cy, r, 1, astart, aend, color);
-			_fillArcOffsetted(cx, cy, r-th, 1, astart, aend, color);
+			_fillArcOffsetted(cx, cy, r, 1, as, ae, color);
+			_fillArcOffsetted(cx, cy, r-th, 1, as, ae, color);
 		}
 	}
 	if (f) {
-		_drawLine(cx + (r-th) * cos(astart * DEG_TO_RAD), cy + (r-th) * sin(astart * DEG_TO_RAD),
-			cx + (r-1) * cos(astart * DEG_TO_RAD), cy + (r-1) * sin(astart * DEG_TO_RAD), color);
-		_drawLine(cx + (r-th) * cos(aend * DEG_TO_RAD), cy + (r-th) * sin(aend * DEG_TO_RAD),
-			cx + (r-1) * cos(aend * DEG_TO_RAD), cy + (r-1) * sin(aend * DEG_TO_RAD), color);
+		int32_t cs = tft_cos(as);
+		int32_t ss = tft_sin(as);
+		int32_t ce = tft_cos(ae);
+		int32_t se = tft_sin(ae);
+		_drawLine(tft_fix_pos(cx, r-th, cs), tft_fix_pos(cy, r-th, ss),
+			tft_fix_pos(cx, r-1, cs), tft_fix_pos(cy, r-1, ss), color);
+		_drawLine(tft_fix_pos(cx, r-th, ce), tft_fix_pos(cy, r-th, se),
+			tft_fix_pos(cx, r-1, ce), tft_fix_pos(cy, r-1, se), color);
 	}
 }
 
@@ -1212,11 +1318,15 @@ void TFT_drawPolygon(int cx, int cy, int sides, int diameter, color_t color, col
 	if (sides > MAX_POLIGON_SIDES) sides = MAX_POLIGON_SIDES;	// This ensures the maximum side number
 
 	int Xpoints[sides], Ypoints[sides];							// Set the arrays based on the number of sides entered
+	int32_t Xsin[sides], Ycos[sides];
 	int rads = 360 / sides;										// This equally spaces the points.
 
+	// vertex directions, rotated by 180 degrees (as with 'deg_to_rad')
 	for (int idx = 0; idx < sides; idx++) {
-		Xpoints[idx] = cx + sin((float)(idx*rads + deg) * deg_to_rad) * diameter;
-		Ypoints[idx] = cy + cos((float)(idx*rads + deg) * deg_to_rad) * diameter;
+		Xsin[idx] = tft_sin((idx*rads + deg + 180) * TFT_ANGLE_ONE);
+		Ycos[idx] = tft_cos((idx*rads + deg + 180) * TFT_ANGLE_ONE);
+		Xpoints[idx] = tft_fix_pos(cx, diameter, Xsin[idx]);
+		Ypoints[idx] = tft_fix_pos(cy, diameter, Ycos[idx]);
 	}
 
 	// Draw the polygon on the screen.
@@ -1231,8 +1341,8 @@ void TFT_drawPolygon(int cx, int cy, int sides, int diameter, color_t color, col
 		for (int n=0; n<th; n++) {
 			if (n > 0) {
 				for (int idx = 0; idx < sides; idx++) {
-					Xpoints[idx] = cx + sin((float)(idx*rads + deg) * deg_to_rad) * (diameter-n);
-					Ypoints[idx] = cy + cos((float)(idx*rads + deg) * deg_to_rad) * (diameter-n);
+					Xpoints[idx] = tft_fix_pos(cx, diameter-n, Xsin[idx]);
+					Ypoints[idx] = tft_fix_pos(cy, diameter-n, Ycos[idx]);
 				}
 			}
 			for(int idx = 0; idx < sides; idx++) {
@@ -2378,71 +2488,15 @@ void TFT_setGammaCurve(uint8_t gm) {
 
 //===========================================================
 color_t HSBtoRGB(float _hue, float _sat, float _brightness) {
- float red = 0.0;
- float green = 0.0;
- float blue = 0.0;
-
- if (_sat == 0.0) {
-   red = _brightness;
-   green = _brightness;
-   blue = _brightness;
- } else {
-   if (_hue == 360.0) {
-     _hue = 0;
-   }
-
-   int slice = (int)(_hue / 60.0);
-   float hue_frac = (_hue / 60.0) - slice;
-
-   float aa = _brightness * (1.0 - _sat);
-   float bb = _brightness * (1.0 - _sat * hue_frac);
-   float cc = _brightness * (1.0 - _sat * (1.0 - hue_frac));
-
-   switch(slice) {
-     case 0:
-         red = _brightness;
-         green = cc;
-         blue = aa;
-         break;
-     case 1:
-         red = bb;
-         green = _brightness;
-         blue = aa;
-         break;
-     case 2:
-         red = aa;
-         green = _brightness;
-         blue = cc;
-         break;
-     case 3:
-         red = aa;
-         green = bb;
-         blue = _brightness;
-         break;
-     case 4:
-         red = cc;
-         green = aa;
-         blue = _brightness;
-         break;
-     case 5:
-         red = _brightness;
-         green = aa;
-         blue = bb;
-         break;
-     default:
-         red = 0.0;
-         green = 0.0;
-         blue = 0.0;
-         break;
-   }
- }
-
- color_t color;
- color.r = ((uint8_t)(red * 255.0)) & 0xFC;
- color.g = ((uint8_t)(green * 255.0)) & 0xFC;
- color.b = ((uint8_t)(blue * 255.0)) & 0xFC;
-
- return color;
+	uint8_t rgb[3];
+	color_t color;
+
+	tft_hsb_to_rgb(tft_angle(_hue), (int32_t)(_sat * TFT_FIX_ONE), (int32_t)(_brightness * TFT_FIX_ONE), rgb);
+	color.r = rgb[0];
+	color.g = rgb[1];
+	color.b = rgb[2];
+
+	return color;
 }
 //=====================================================================
 void TFT_setclipwin(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2)
@@ -2531,6 +2585,135 @@ void TFT_restoreClipWin()
 }
 
 
+// ================ FRAME BUFFER BLIT ==========================================
+
+#define TFT_BLIT_BUF_PIXELS	8192
+
+// Send the opaque pixels of the display line as runs of consecutive pixels
+//------------------------------------------------------------------------------------------
+static void _blit_send_runs(int x, int y, int w, color_t *cbuf, uint8_t *mask)
+{
+	int start = 0;
+	while (start < w) {
+		if ((mask) && (mask[start] == 0)) {
+			start++;
+			continue;
+		}
+		int end = start + 1;
+		while ((end < w) && ((mask == NULL) || (mask[end]))) end++;
+		TFT_EPD_send_data(x+start, y, x+end-1, y, end-start, cbuf+start, 0);
+		start = end;
+	}
+}
+
+//======================================================================================
+int TFT_blit(const fb_surface_t *fb, int x, int y, int32_t key, int alpha, int scale)
+{
+	if ((scale < 1) || (scale > FB_BLIT_MAX_SCALE) || (fb->format >= FRAMEBUF_FORMATS)) return -1;
+	if (alpha <= 0) return 0;
+	if (alpha > 255) alpha = 255;
+	if (tft_active_mode != TFT_MODE_TFT) alpha = 255;
+
+	// ** Clip to the display window
+	x += dispWin.x1;
+	y += dispWin.y1;
+	int x1 = (x < dispWin.x1) ? dispWin.x1 : x;
+	int y1 = (y < dispWin.y1) ? dispWin.y1 : y;
+	int x2 = x + (fb->width * scale) - 1;
+	int y2 = y + (fb->height * scale) - 1;
+	if (x2 > dispWin.x2) x2 = dispWin.x2;
+	if (y2 > dispWin.y2) y2 = dispWin.y2;
+	if ((x1 > x2) || (y1 > y2)) return 0;
+	int w = x2 - x1 + 1;
+	int h = y2 - y1 + 1;
+
+	// ** Number of lines converted and sent at once, only opaque blit is sent in strips
+	int lines = 1;
+	if ((key < 0) && (alpha == 255)) {
+		lines = TFT_BLIT_BUF_PIXELS / w;
+		if (lines < 1) lines = 1;
+		if (lines > h) lines = h;
+	}
+
+	int err = -2;
+	uint32_t *rgb = malloc(w * sizeof(uint32_t));
+	uint8_t *mask = (key >= 0) ? malloc(w) : NULL;
+	uint8_t *rdbuf = (alpha < 255) ? malloc((w * sizeof(color_t)) + 1) : NULL;
+	color_t *cbuf = malloc(w * lines * sizeof(color_t));
+	if ((rgb == NULL) || (cbuf == NULL) || ((key >= 0) && (mask == NULL)) || ((alpha < 255) && (rdbuf == NULL))) goto exit;
+	err = 0;
+
+	if (tft_active_mode == TFT_MODE_EPD) {
+		// ** No window transfers on EPD, draw the opaque pixels as gray scale or mono luminance
+		int epd_format = (_gs) ? FRAMEBUF_GS4_HMSB : FRAMEBUF_MVLSB;
+		for (int dy = y1; dy <= y2; dy++) {
+			fb_blit_row_rgb(fb, x1 - x, dy - y, w, scale, key, rgb, mask);
+			for (int i = 0; i < w; i++) {
+				if ((mask) && (mask[i] == 0)) continue;
+				EPD_drawPixel(x1 + i, dy, fb_color_from_rgb(epd_format, rgb[i]));
+			}
+		}
+		goto exit;
+	}
+
+	for (int dy = y1; dy <= y2; dy += lines) {
+		int nlines = ((y2 - dy + 1) < lines) ? (y2 - dy + 1) : lines;
+		int opaque = 0;
+
+		// ** Convert the frame buffer lines to display colors
+		for (int ln = 0; ln < nlines; ln++) {
+			color_t *cline = cbuf + (ln * w);
+			opaque = fb_blit_row_rgb(fb, x1 - x, dy + ln - y, w, scale, key, rgb, mask);
+			for (int i = 0; i < w; i++) {
+				cline[i].r = rgb[i] >> 16;
+				cline[i].g = rgb[i] >> 8;
+				cline[i].b = rgb[i];
+			}
+		}
+		if (opaque == 0) continue;
+
+		if (alpha < 255) {
+			// ** Read the display line and blend
+			if (read_data(x1, dy, x2, dy, w, rdbuf, 1) != ESP_OK) {
+				err = -3;
+				break;
+			}
+			color_t *back = (color_t *)(rdbuf + 1);
+			uint32_t ialpha = 255 - alpha;
+			for (int i = 0; i < w; i++) {
+				uint32_t t;
+				t = (cbuf[i].r * alpha) + (back[i].r * ialpha) + 128;
+				cbuf[i].r = (t + (t >> 8)) >> 8;
+				t = (cbuf[i].g * alpha) + (back[i].g * ialpha) + 128;
+				cbuf[i].g = (t + (t >> 8)) >> 8;
+				t = (cbuf[i].b * alpha) + (back[i].b * ialpha) + 128;
+				cbuf[i].b = (t + (t >> 8)) >> 8;
+			}
+		}
+
+		if (TFT_EPD_disp_select() != ESP_OK) {
+			err = -3;
+			break;
+		}
+		if ((mask) && (opaque < w)) _blit_send_runs(x1, dy, w, cbuf, mask);
+		else if (alpha < 255) _blit_send_runs(x1, dy, w, cbuf, NULL);
+		else {
+			// ** all strip lines in one transfer
+			TFT_EPD_send_data(x1, dy, x2, dy+nlines-1, w*nlines, cbuf, 0);
+		}
+		wait_trans_finish(1);
+		TFT_EPD_disp_deselect();
+	}
+
+exit:
+	if (rgb) free(rgb);
+	if (mask) free(mask);
+	if (rdbuf) free(rdbuf);
+	if (cbuf) free(cbuf);
+	return err;
+}
+
+
 // ================ JPG SUPPORT ================================================
 // User defined device identifier
 typedef struct {
@@ -39,6 +39,7 @@
 #include <stdlib.h>
 #include "tftspi.h"
 #include "py/obj.h"
+#include "extmod/framebuf_blit.h"
 
 #define TFT_MODE_TFT    0
 #define TFT_MODE_EPD    1
@@ -609,6 +610,25 @@ void TFT_saveClipWin();
 //------------------------
 void TFT_restoreClipWin();
 
+/*
+ * Draw the frame buffer surface to the display
+ * The surface is converted to display colors in strips of up to TFT_BLIT_BUF_PIXELS pixels
+ * and each strip is sent to the display window in one SPI transfer
+ *
+ * Params:
+ *       fb:	pointer to the surface of the 'framebuf.FrameBuffer' object (any format)
+ *     x, y:	top left position, relative to the clip window; negative values are accepted
+ *      key:	frame buffer color value not drawn; -1 for no transparent color
+ *    alpha:	0~255; if less than 255, the frame buffer is blended with the display content
+ *    		the display must support reading, not supported on EPD and EVE
+ *    scale:	1~8, integer scale factor
+ *
+ * Returns:
+ * 		0 on success, -1 if the arguments are not valid, -2 on memory allocation error
+ */
+//------------------------------------------------------------------------------------
+int TFT_blit(const fb_surface_t *fb, int x, int y, int32_t key, int alpha, int scale);
+
 /*
  * Set the screen rotation
  * Also resets the clip window and clears the screen with current background color
@@ -0,0 +1,228 @@
+/*
+ * This file is part of the MicroPython ESP32 project, https://github.com/loboris/MicroPython_ESP32_psRAM_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "tft_geom.h"
+
+// sin(0 ~ 90 degrees) * 65536
+static const int32_t sin_table[91] = {
+        0,  1144,  2287,  3430,  4572,  5712,  6850,  7987,  9121, 10252,
+    11380, 12505, 13626, 14742, 15855, 16962, 18064, 19161, 20252, 21336,
+    22415, 23486, 24550, 25607, 26656, 27697, 28729, 29753, 30767, 31772,
+    32768, 33754, 34729, 35693, 36647, 37590, 38521, 39441, 40348, 41243,
+    42126, 42995, 43852, 44695, 45525, 46341, 47143, 47930, 48703, 49461,
+    50203, 50931, 51643, 52339, 53020, 53684, 54332, 54963, 55578, 56175,
+    56756, 57319, 57865, 58393, 58903, 59396, 59870, 60326, 60764, 61183,
+    61584, 61966, 62328, 62672, 62997, 63303, 63589, 63856, 64104, 64332,
+    64540, 64729, 64898, 65048, 65177, 65287, 65376, 65446, 65496, 65526,
+    65536
+};
+
+//-------------------------------
+int32_t tft_sin(int32_t angle)
+{
+    int neg = 0;
+
+    angle %= TFT_ANGLE_FULL;
+    if (angle < 0) angle += TFT_ANGLE_FULL;
+    if (angle >= (180 * TFT_ANGLE_ONE)) {
+        angle -= 180 * TFT_ANGLE_ONE;
+        neg = 1;
+    }
+    if (angle > (90 * TFT_ANGLE_ONE)) angle = (180 * TFT_ANGLE_ONE) - angle;
+
+    int idx = angle / TFT_ANGLE_ONE;
+    int frac = angle % TFT_ANGLE_ONE;
+    int32_t val = sin_table[idx];
+    if (frac) val += ((sin_table[idx+1] - val) * frac) / TFT_ANGLE_ONE;
+
+    return (neg) ? -val : val;
+}
+
+//-------------------------------
+int32_t tft_cos(int32_t angle)
+{
+    return tft_sin(angle + (90 * TFT_ANGLE_ONE));
+}
+
+// Largest integer not greater than a/b
+//----------------------------------------------
+static int64_t _floor_div(int64_t a, int64_t b)
+{
+    int64_t q = a / b;
+    if (((a % b) != 0) && ((a < 0) != (b < 0))) q--;
+    return q;
+}
+
+// Integer square root, rounded down
+//--------------------------------
+static int32_t _isqrt(int64_t v)
+{
+    if (v <= 0) return 0;
+    int64_t res = 0;
+    int64_t bit = (int64_t)1 << 62;
+    while (bit > v) bit >>= 2;
+    while (bit) {
+        if (v >= (res + bit)) {
+            v -= res + bit;
+            res = (res >> 1) + bit;
+        }
+        else res >>= 1;
+        bit >>= 2;
+    }
+    return (int32_t)res;
+}
+
+#define X_MIN   (-0x7FFFFFFF)
+#define X_MAX   0x7FFFFFFF
+
+// Limit [*lo, *hi] to the x values satisfying x * a <= b
+//----------------------------------------------------------------------
+static void _half_plane(int64_t a, int64_t b, int32_t *lo, int32_t *hi)
+{
+    if (a > 0) {
+        int64_t lim = _floor_div(b, a);
+        if (lim < *hi) *hi = (lim < X_MIN) ? X_MIN : (int32_t)lim;
+    }
+    else if (a < 0) {
+        int64_t lim = -_floor_div(-b, a);   // ceil(b / a)
+        if (lim > *lo) *lo = (lim > X_MAX) ? X_MAX : (int32_t)lim;
+    }
+    else if (b < 0) {
+        *lo = X_MAX;
+        *hi = X_MIN;
+    }
+}
+
+//-------------------------------------------------------------------------------------------
+void tft_arc_init(tft_arc_t *arc, int radius, int thickness, int32_t start, int32_t end)
+{
+    arc->start = start;
+    arc->end = end;
+    arc->ssin = tft_sin(start);
+    arc->scos = tft_cos(start);
+    arc->esin = tft_sin(end);
+    arc->ecos = tft_cos(end);
+    arc->or2 = radius * radius;
+    arc->ir2 = (radius - thickness) * (radius - thickness);
+}
+
+// The pixel (x, y) belongs to the arc if x^2 + y^2 is in [ir2, or2) and it is
+// on the proper side of the start and the end line (x * sin(a) <= y * cos(a) for the start,
+// x * sin(a) >= y * cos(a) for the end); the half plane x < 0 or x > 0 is used in row 0
+//------------------------------------------------------
+int tft_arc_row(const tft_arc_t *arc, int y, int *spans)
+{
+    int64_t y2 = (int64_t)y * y;
+    if (y2 >= arc->or2) return 0;
+
+    // ring, x^2 < or2 - y^2 and x^2 >= ir2 - y^2
+    int32_t xo = _isqrt(arc->or2 - y2 - 1);
+    int32_t xi = -1;
+    if (arc->ir2 > y2) {
+        xi = _isqrt(arc->ir2 - y2);
+        if (((int64_t)xi * xi) < (arc->ir2 - y2)) xi++;
+        if (xi > xo) return 0;
+    }
+
+    // angle limits
+    int32_t lo = X_MIN;
+    int32_t hi = X_MAX;
+    if (y == 0) {
+        int neg = (arc->start <= (180 * TFT_ANGLE_ONE)) && (arc->end >= (180 * TFT_ANGLE_ONE));
+        int pos = (arc->start == 0);
+        if ((!neg) && (!pos)) return 0;
+        if (!neg) lo = 1;
+        if (!pos) hi = -1;
+    }
+    else if (y > 0) {
+        if (arc->start >= (180 * TFT_ANGLE_ONE)) return 0;
+        _half_plane(arc->ssin, (int64_t)y * arc->scos, &lo, &hi);
+        if (arc->end < (180 * TFT_ANGLE_ONE)) _half_plane(-arc->esin, -(int64_t)y * arc->ecos, &lo, &hi);
+    }
+    else {
+        if (arc->end <= (180 * TFT_ANGLE_ONE)) return 0;
+        if (arc->start > (180 * TFT_ANGLE_ONE)) _half_plane(arc->ssin, (int64_t)y * arc->scos, &lo, &hi);
+        _half_plane(-arc->esin, -(int64_t)y * arc->ecos, &lo, &hi);
+    }
+    if (lo > hi) return 0;
+
+    // intersect the angle limits with the ring spans
+    int n = 0;
+    int32_t rs[4];
+    int nr;
+    if (xi <= 0) {
+        rs[0] = -xo; rs[1] = xo;
+        nr = 1;
+    }
+    else {
+        rs[0] = -xo; rs[1] = -xi;
+        rs[2] = xi;  rs[3] = xo;
+        nr = 2;
+    }
+    for (int i=0; i<nr; i++) {
+        int32_t x1 = (rs[i*2] > lo) ? rs[i*2] : lo;
+        int32_t x2 = (rs[i*2+1] < hi) ? rs[i*2+1] : hi;
+        if (x1 > x2) continue;
+        spans[n*2] = x1;
+        spans[n*2+1] = x2;
+        n++;
+    }
+    return n;
+}
+
+//------------------------------------------------------------------------
+void tft_hsb_to_rgb(int32_t hue, int32_t sat, int32_t bri, uint8_t *rgb)
+{
+    int32_t val[3];
+
+    if (sat == 0) {
+        val[0] = bri;
+        val[1] = bri;
+        val[2] = bri;
+    }
+    else {
+        if (hue == TFT_ANGLE_FULL) hue = 0;
+        int slice = hue / (60 * TFT_ANGLE_ONE);
+        int32_t frac = (int32_t)(((int64_t)(hue % (60 * TFT_ANGLE_ONE)) << TFT_FIX_SHIFT) / (60 * TFT_ANGLE_ONE));
+
+        int32_t aa = tft_fix_mul(bri, TFT_FIX_ONE - sat);
+        int32_t bb = tft_fix_mul(bri, TFT_FIX_ONE - tft_fix_mul(sat, frac));
+        int32_t cc = tft_fix_mul(bri, TFT_FIX_ONE - tft_fix_mul(sat, TFT_FIX_ONE - frac));
+
+        switch ((hue < 0) ? -1 : slice) {
+            case 0: val[0] = bri; val[1] = cc;  val[2] = aa;  break;
+            case 1: val[0] = bb;  val[1] = bri; val[2] = aa;  break;
+            case 2: val[0] = aa;  val[1] = bri; val[2] = cc;  break;
+            case 3: val[0] = aa;  val[1] = bb;  val[2] = bri; break;
+            case 4: val[0] = cc;  val[1] = aa;  val[2] = bri; break;
+            case 5: val[0] = bri; val[1] = aa;  val[2] = bb;  break;
+            default: val[0] = 0;  val[1] = 0;   val[2] = 0;   break;
+        }
+    }
+    for (int i=0; i<3; i++) {
+        rgb[i] = ((uint8_t)(((int64_t)val[i] * 255) >> TFT_FIX_SHIFT)) & 0xFC;
+    }
+}
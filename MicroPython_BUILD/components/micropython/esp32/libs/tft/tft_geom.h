@@ -0,0 +1,95 @@
+/*
+ * This file is part of the MicroPython ESP32 project, https://github.com/loboris/MicroPython_ESP32_psRAM_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Integer geometry helpers for the TFT drawing functions.
+ *
+ * Angles are given in 1/256 degree units (TFT_ANGLE_ONE is one degree),
+ * sine and cosine are returned as 16.16 fixed point numbers and taken from
+ * the quarter wave table with linear interpolation between whole degrees.
+ * The arc ring is rasterized by rows, the horizontal spans covered in each
+ * row are calculated directly instead of testing every pixel.
+ *
+ * This module has no ESP-IDF or MicroPython dependencies and can be compiled on host.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define TFT_FIX_SHIFT   16
+#define TFT_FIX_ONE     (1 << TFT_FIX_SHIFT)
+#define TFT_ANGLE_ONE   256                     // one degree
+#define TFT_ANGLE_FULL  (360 * TFT_ANGLE_ONE)
+
+typedef struct _tft_arc_t {
+    int32_t start;      // start angle, 0 ~ 360 degrees
+    int32_t end;        // end angle, 0 ~ 360 degrees
+    int32_t ssin;       // start and end angle sine and cosine
+    int32_t scos;
+    int32_t esin;
+    int32_t ecos;
+    int32_t or2;        // outer radius squared
+    int32_t ir2;        // inner radius squared
+} tft_arc_t;
+
+// Convert the angle in degrees to 1/256 degree units
+static inline int32_t tft_angle(float deg) {
+    return (int32_t)((deg * TFT_ANGLE_ONE) + ((deg < 0) ? -0.5f : 0.5f));
+}
+
+// Round the 16.16 fixed point value toward zero, as the float to integer conversion
+static inline int32_t tft_fix_trunc(int64_t v) {
+    return (int32_t)((v < 0) ? -((-v) >> TFT_FIX_SHIFT) : (v >> TFT_FIX_SHIFT));
+}
+
+// Multiply the integer by 16.16 fixed point value, the result is rounded toward zero
+static inline int32_t tft_fix_mul(int32_t v, int32_t f) {
+    return tft_fix_trunc((int64_t)v * f);
+}
+
+// Coordinate 'pos' moved by 'v' times 16.16 fixed point value; like the float
+// expression 'pos + v * f' converted to integer, the sum is rounded toward zero
+static inline int32_t tft_fix_pos(int32_t pos, int32_t v, int32_t f) {
+    return tft_fix_trunc(((int64_t)pos * TFT_FIX_ONE) + ((int64_t)v * f));
+}
+
+int32_t tft_sin(int32_t angle);
+int32_t tft_cos(int32_t angle);
+
+// Prepare the arc ring of the given radius and thickness from 'start' to 'end' angle
+// The angles are measured clockwise from the positive x axis, start <= end
+void tft_arc_init(tft_arc_t *arc, int radius, int thickness, int32_t start, int32_t end);
+
+// Calculate the spans covered by the arc in row 'y' (relative to the arc center)
+// Up to two spans are returned in 'spans' as x1, x2 pairs (inclusive, relative to the center)
+// Returns the number of spans
+int tft_arc_row(const tft_arc_t *arc, int y, int *spans);
+
+// Convert hue (1/256 degree units), saturation and brightness (16.16 fixed point, 0 ~ 1.0)
+// to 8-bit R, G, B components
+void tft_hsb_to_rgb(int32_t hue, int32_t sat, int32_t bri, uint8_t *rgb);
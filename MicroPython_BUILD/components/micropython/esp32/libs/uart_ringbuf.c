@@ -0,0 +1,218 @@
+/*
+ * This file is part of the MicroPython ESP32 project, https://github.com/loboris/MicroPython_ESP32_psRAM_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <string.h>
+
+#include "uart_ringbuf.h"
+
+
+//-------------------------------------------
+uint32_t uart_buf_size_pow2(uint32_t size)
+{
+    uint32_t sz = 1;
+    while (sz < size) sz <<= 1;
+    return sz;
+}
+
+//-----------------------------------------------------------------
+int uart_buf_init(uart_ringbuf_t *r, uint8_t *buf, uint32_t size)
+{
+    if ((size == 0) || (size & (size - 1))) return -1;
+
+    r->buf = buf;
+    r->size = size;
+    r->mask = size - 1;
+    r->iput = 0;
+    r->iget = 0;
+    memset(r->scan, 0, sizeof(r->scan));
+    r->scan_next = 0;
+    r->received = 0;
+    r->dropped = 0;
+    r->overflows = 0;
+    return 0;
+}
+
+//-----------------------------------------------------------------------
+int uart_buf_put(uart_ringbuf_t *r, const uint8_t *source, uint32_t len)
+{
+    uint32_t iput = r->iput;
+    uint32_t n = uart_buf_free(r);
+    if (n > len) n = len;
+
+    // copy in max. two parts, up to the buffer end and from the buffer start
+    uint32_t idx = iput & r->mask;
+    uint32_t first = r->size - idx;
+    if (first > n) first = n;
+    memcpy(r->buf + idx, source, first);
+    if (n > first) memcpy(r->buf, source + first, n - first);
+
+    __atomic_store_n(&r->iput, iput + n, __ATOMIC_RELEASE);
+    r->received += n;
+
+    if (n < len) uart_buf_put_dropped(r, len - n);
+    return len - n;
+}
+
+//-------------------------------------------------------------
+uint8_t *uart_buf_put_ptr(uart_ringbuf_t *r, uint32_t *len)
+{
+    uint32_t idx = r->iput & r->mask;
+    uint32_t n = uart_buf_free(r);
+    if (n > (r->size - idx)) n = r->size - idx;
+    *len = n;
+    return r->buf + idx;
+}
+
+//-------------------------------------------------------
+void uart_buf_put_commit(uart_ringbuf_t *r, uint32_t len)
+{
+    __atomic_store_n(&r->iput, r->iput + len, __ATOMIC_RELEASE);
+    r->received += len;
+}
+
+//--------------------------------------------------------
+void uart_buf_put_dropped(uart_ringbuf_t *r, uint32_t len)
+{
+    if (len == 0) return;
+    r->received += len;
+    r->dropped += len;
+    r->overflows++;
+}
+
+//-------------------------------------------------------------------------------------------
+int uart_buf_peek(uart_ringbuf_t *r, uint8_t *dest, uint32_t offset, uint32_t len)
+{
+    uint32_t count = uart_buf_count(r);
+    if (offset >= count) return 0;
+    if (len > (count - offset)) len = count - offset;
+
+    uint32_t idx = (r->iget + offset) & r->mask;
+    uint32_t first = r->size - idx;
+    if (first > len) first = len;
+    memcpy(dest, r->buf + idx, first);
+    if (len > first) memcpy(dest + first, r->buf, len - first);
+    return len;
+}
+
+// Move the read position, the search positions of consumed data
+// are moved to the new read position
+//---------------------------------------------------------
+static void uart_buf_consume(uart_ringbuf_t *r, uint32_t iget)
+{
+    __atomic_store_n(&r->iget, iget, __ATOMIC_RELEASE);
+    for (int i = 0; i < UART_BUF_SCAN_SLOTS; i++) {
+        if ((int32_t)(r->scan[i].pos - iget) < 0) r->scan[i].pos = iget;
+    }
+}
+
+//-------------------------------------------------------
+void uart_buf_drop(uart_ringbuf_t *r, uint32_t len)
+{
+    uint32_t count = uart_buf_count(r);
+    if (len > count) len = count;
+    uart_buf_consume(r, r->iget + len);
+}
+
+//---------------------------------------
+void uart_buf_flush(uart_ringbuf_t *r)
+{
+    uart_buf_consume(r, __atomic_load_n(&r->iput, __ATOMIC_ACQUIRE));
+}
+
+//------------------------------------------------------------------
+int uart_buf_get(uart_ringbuf_t *r, uint8_t *dest, uint32_t len)
+{
+    if (uart_buf_count(r) == 0) return -1; // input buffer empty
+
+    int res = uart_buf_peek(r, dest, 0, len);
+    uart_buf_consume(r, r->iget + res);
+    return res;
+}
+
+// Get the search slot of the pattern, a new pattern replaces the oldest one
+// and is searched from the read position.
+// Returns NULL if the pattern is too long to be remembered.
+//--------------------------------------------------------------------------------------------------
+static uart_buf_scan_t *uart_buf_scan_slot(uart_ringbuf_t *r, const uint8_t *pattern, uint32_t pattern_len)
+{
+    if (pattern_len > UART_BUF_SCAN_PATTERN) return NULL;
+
+    for (int i = 0; i < UART_BUF_SCAN_SLOTS; i++) {
+        uart_buf_scan_t *s = &r->scan[i];
+        if ((s->len == pattern_len) && (memcmp(s->pattern, pattern, pattern_len) == 0)) return s;
+    }
+    uart_buf_scan_t *s = &r->scan[r->scan_next];
+    r->scan_next = (r->scan_next + 1) % UART_BUF_SCAN_SLOTS;
+    s->len = pattern_len;
+    memcpy(s->pattern, pattern, pattern_len);
+    s->pos = r->iget;
+    return s;
+}
+
+//-------------------------------------------------------------------------------------
+int uart_buf_find(uart_ringbuf_t *r, const uint8_t *pattern, uint32_t pattern_len)
+{
+    if (pattern_len == 0) return -1;
+
+    uint32_t iget = r->iget;
+    uint32_t iput = __atomic_load_n(&r->iput, __ATOMIC_ACQUIRE);
+    uart_buf_scan_t *slot = uart_buf_scan_slot(r, pattern, pattern_len);
+    uint32_t pos = (slot) ? slot->pos : iget;
+    // data before the read position was consumed, start from the read position
+    if ((int32_t)(pos - iget) < 0) pos = iget;
+
+    if ((iput - iget) < pattern_len) {
+        if (slot) slot->pos = pos;
+        return -1;
+    }
+
+    uint32_t last = iput - pattern_len; // last possible pattern start
+    while ((int32_t)(last - pos) >= 0) {
+        // search for the first pattern byte in the contiguous part of the buffer
+        uint32_t idx = pos & r->mask;
+        uint32_t n = r->size - idx;
+        if (n > (last - pos + 1)) n = last - pos + 1;
+        uint8_t *p = memchr(r->buf + idx, pattern[0], n);
+        if (p == NULL) {
+            pos += n;
+            continue;
+        }
+        pos += p - (r->buf + idx);
+        // check the rest of the pattern
+        uint32_t i;
+        for (i = 1; i < pattern_len; i++) {
+            if (r->buf[(pos + i) & r->mask] != pattern[i]) break;
+        }
+        if (i == pattern_len) {
+            if (slot) slot->pos = pos;
+            return pos - iget;
+        }
+        pos++;
+    }
+    // not found, the next search continues where the pattern can still start
+    if (slot) slot->pos = pos;
+    return -1;
+}
@@ -0,0 +1,112 @@
+/*
+ * This file is part of the MicroPython ESP32 project, https://github.com/loboris/MicroPython_ESP32_psRAM_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Single producer / single consumer byte ring buffer used for UART receive.
+ *
+ * The buffer size must be a power of two. 'iput' and 'iget' are free running
+ * indexes, the buffer position is obtained by masking, so the buffer can be
+ * completely filled and no byte is wasted to distinguish full from empty.
+ * Only the producer writes 'iput', only the consumer writes 'iget' and 'scan',
+ * so no locking is needed between one writer and one reader.
+ *
+ * Pattern searches remember, for each of the last UART_BUF_SCAN_SLOTS patterns,
+ * where the search stopped, so different patterns (line end, callback pattern)
+ * don't skip data checked only for another pattern.
+ *
+ * This module has no ESP-IDF or MicroPython dependencies and can be compiled on host.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define UART_BUF_SCAN_SLOTS     4
+#define UART_BUF_SCAN_PATTERN   16  // longer patterns are always searched from the read position
+
+typedef struct _uart_buf_scan_t {
+    uint32_t pos;               // search resume position (absolute index)
+    uint8_t len;                // pattern length, 0 if the slot is not used
+    uint8_t pattern[UART_BUF_SCAN_PATTERN];
+} uart_buf_scan_t;
+
+typedef struct _uart_ringbuf_t {
+    uint8_t *buf;
+    uint32_t size;              // buffer size, power of two
+    uint32_t mask;              // size - 1
+    volatile uint32_t iput;     // free running write index, written by producer only
+    volatile uint32_t iget;     // free running read index, written by consumer only
+    uart_buf_scan_t scan[UART_BUF_SCAN_SLOTS]; // pattern search resume positions
+    uint8_t scan_next;          // slot to reuse for a new pattern
+    uint32_t received;          // total bytes received (producer statistics)
+    uint32_t dropped;           // bytes dropped because the buffer was full
+    uint32_t overflows;         // number of overflow events
+} uart_ringbuf_t;
+
+// Round the requested size up to the nearest power of two
+uint32_t uart_buf_size_pow2(uint32_t size);
+
+// Initialize the ring buffer using the provided memory
+// Returns -1 if the size is not a power of two
+int uart_buf_init(uart_ringbuf_t *r, uint8_t *buf, uint32_t size);
+
+// Number of bytes available for reading
+static inline uint32_t uart_buf_count(uart_ringbuf_t *r) {
+    return __atomic_load_n(&r->iput, __ATOMIC_ACQUIRE) - r->iget;
+}
+
+// Number of free bytes
+static inline uint32_t uart_buf_free(uart_ringbuf_t *r) {
+    return r->size - (r->iput - __atomic_load_n(&r->iget, __ATOMIC_ACQUIRE));
+}
+
+// === Producer side ===
+
+// Store up to 'len' bytes, returns the number of bytes NOT stored (0 on success)
+int uart_buf_put(uart_ringbuf_t *r, const uint8_t *source, uint32_t len);
+// Get the pointer to the contiguous free space, its length is returned in 'len'
+uint8_t *uart_buf_put_ptr(uart_ringbuf_t *r, uint32_t *len);
+// Make 'len' bytes written to the space returned by 'uart_buf_put_ptr' available to the consumer
+void uart_buf_put_commit(uart_ringbuf_t *r, uint32_t len);
+// Account the bytes which could not be stored
+void uart_buf_put_dropped(uart_ringbuf_t *r, uint32_t len);
+
+// === Consumer side ===
+
+// Read up to 'len' bytes into 'dest', returns -1 if the buffer is empty
+int uart_buf_get(uart_ringbuf_t *r, uint8_t *dest, uint32_t len);
+// Copy up to 'len' bytes starting at 'offset' without removing them from the buffer
+int uart_buf_peek(uart_ringbuf_t *r, uint8_t *dest, uint32_t offset, uint32_t len);
+// Remove up to 'len' bytes from the buffer
+void uart_buf_drop(uart_ringbuf_t *r, uint32_t len);
+// Remove all bytes from the buffer
+void uart_buf_flush(uart_ringbuf_t *r);
+// Search the buffer for the pattern
+// The search resumes from the position where the previous search for the same
+// pattern stopped, so the already checked data is not scanned again.
+// Returns the offset (from the read position) of the pattern start or -1 if not found
+int uart_buf_find(uart_ringbuf_t *r, const uint8_t *pattern, uint32_t pattern_len);
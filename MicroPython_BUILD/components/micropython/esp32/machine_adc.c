@@ -45,6 +45,7 @@
 #include "modmachine.h"
 #include "py/objarray.h"
 #include "extmod/vfs_native.h"
+#include "libs/adc_stream.h"
 
 #define ADC1_CHANNEL_HALL	ADC1_CHANNEL_MAX
 #define ADC_TIMER_DIVIDER	80		// 1 us per tick, 1 MHz
@@ -69,6 +70,8 @@ typedef struct _madc_obj_t {
     int min;
     int max;
     uint8_t cal_read;
+    adc_stream_t stream;
+    bool stream_held;
 } madc_obj_t;
 
 extern int MainTaskCore;
@@ -91,6 +94,7 @@ static uint64_t collect_start_time = 0;
 static uint64_t collect_end_time = 0;
 static bool task_running = false;
 static bool task_stop = false;
+static uint32_t stream_period_ns = 0;
 
 static const uint8_t adc1_gpios[ADC1_CHANNEL_MAX] = {36, 37, 38, 39, 32, 33, 34, 35};
 static const uint8_t adc2_gpios[ADC2_CHANNEL_MAX] = {4, 0, 2, 15, 13, 12, 14, 27, 25, 26};
@@ -235,6 +239,86 @@ exit:
     vTaskDelete(NULL);
 }
 
+// Continuous streaming into the ring of sample blocks
+//=============================================
+static void adc_stream_task(void *pvParameters)
+{
+    // 'task_running' is set by the caller before the task is created
+    madc_obj_t *self = (madc_obj_t *)pvParameters;
+    adc_stream_t *st = &self->stream;
+    uint16_t *i2s_read_buff = NULL;
+    adc_block_info_t info;
+    size_t bytes_read;
+    uint8_t *block;
+    uint32_t period_ns = stream_period_ns;
+
+    // allocate i2s read buffer
+    i2s_read_buff = calloc(I2S_RD_BUF_SIZE, 1);
+    if (i2s_read_buff == NULL) {
+        if (self->fhndl) {
+            fclose(self->fhndl);
+            self->fhndl = NULL;
+        }
+        ESP_LOGE("ADC", "Error allocating i2s read buffer");
+        goto exit;
+    }
+
+    self->buf_ptr = 0;
+    collect_start_time = mp_hal_ticks_us();
+    collect_end_time = collect_start_time;
+
+    while (!task_stop) {
+        i2s_read(0, (void *)i2s_read_buff, I2S_RD_BUF_SIZE, &bytes_read, 1000);
+        if (bytes_read == 0) {
+            ESP_LOGE("ADC", "I2S error reading");
+            break;
+        }
+        // sample time is derived from the sample count, not from the read time
+        uint64_t ts = collect_start_time + (((uint64_t)self->buf_ptr * period_ns) / 1000);
+        int completed = adc_stream_put(st, i2s_read_buff, bytes_read/2, ts, period_ns);
+        self->buf_ptr += bytes_read/2;
+        if (completed == 0) continue;
+
+        if (self->fhndl) {
+            // file sink, write and release the completed blocks
+            while ((block = adc_stream_get(st, &info)) != NULL) {
+                if (fwrite(block, st->sample_size, info.len, self->fhndl) != info.len) {
+                    ESP_LOGE("ADC", "Error writing to file, block %u", info.seq);
+                    task_stop = true;
+                    break;
+                }
+                adc_stream_release(st);
+            }
+        }
+        if (self->callback) mp_sched_schedule(self->callback, self, NULL);
+    }
+    collect_end_time = mp_hal_ticks_us();
+
+    // make the partially filled block available
+    adc_stream_finish(st);
+    if (self->fhndl) {
+        while ((block = adc_stream_get(st, &info)) != NULL) {
+            if (fwrite(block, st->sample_size, info.len, self->fhndl) != info.len) break;
+            adc_stream_release(st);
+        }
+        fclose(self->fhndl);
+        self->fhndl = NULL;
+    }
+
+exit:
+    // i2s cleanup
+    i2s_adc_disable(0);
+    i2s_driver_uninstall(0);
+    i2s_driver_installed = false;
+    if (i2s_read_buff) free(i2s_read_buff);
+
+    esp_log_level_set("I2S", CONFIG_LOG_DEFAULT_LEVEL);
+    task_stop = false;
+    task_running = false;
+
+    vTaskDelete(NULL);
+}
+
 //======================================
 // ADC Timer interrupt function
 //======================================
@@ -434,6 +518,9 @@ STATIC mp_obj_t madc_make_new(const mp_obj_type_t *type, size_t n_args, size_t n
     self->interval = 0;
     self->cal_read = 0;
     self->callback = NULL;
+    self->fhndl = NULL;
+    self->stream.mem = NULL;
+    self->stream_held = false;
 
     self->adc_num = args[ARG_unit].u_int;
     if ((self->adc_num != 0) && (self->adc_num != ADC_UNIT_1) && (self->adc_num != ADC_UNIT_2)) {
@@ -520,6 +607,10 @@ STATIC mp_obj_t madc_deinit(mp_obj_t self_in)
 
     if (self->gpio_id < 0) return mp_const_none;
 
+    self->stream.mem = NULL;
+    self->stream.info = NULL;
+    self->stream_held = false;
+
     if (self->adc_num == ADC_UNIT_1) {
         if (self->adc_chan == ADC1_CHANNEL_HALL) {
             adc1_chan_used &= 0x00FF;
@@ -938,6 +1029,204 @@ STATIC mp_obj_t madc_read_timed(mp_uint_t n_args, const mp_obj_t *pos_args, mp_m
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_KW(madc_read_timed_obj, 0, madc_read_timed);
 
+//-----------------------------------------------------------------------------------------
+STATIC mp_obj_t madc_stream(mp_uint_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    enum { ARG_freq, ARG_block, ARG_nblocks, ARG_decimate, ARG_average, ARG_byte, ARG_callback, ARG_file };
+    const mp_arg_t allowed_args[] = {
+            { MP_QSTR_freq,     MP_ARG_REQUIRED | MP_ARG_INT,  {.u_int = 0} },
+            { MP_QSTR_block,    MP_ARG_KW_ONLY  | MP_ARG_INT,  {.u_int = 1024} },
+            { MP_QSTR_nblocks,  MP_ARG_KW_ONLY  | MP_ARG_INT,  {.u_int = 4} },
+            { MP_QSTR_decimate, MP_ARG_KW_ONLY  | MP_ARG_INT,  {.u_int = 1} },
+            { MP_QSTR_average,  MP_ARG_KW_ONLY  | MP_ARG_BOOL, {.u_bool = false} },
+            { MP_QSTR_byte,     MP_ARG_KW_ONLY  | MP_ARG_BOOL, {.u_bool = false} },
+            { MP_QSTR_callback, MP_ARG_KW_ONLY  | MP_ARG_OBJ,  {.u_obj = mp_const_none} },
+            { MP_QSTR_file,     MP_ARG_KW_ONLY  | MP_ARG_OBJ,  {.u_obj = mp_const_none} },
+    };
+
+    madc_obj_t *self = MP_OBJ_TO_PTR(pos_args[0]);
+
+    _is_init(self, true, true);
+
+    if (self->gpio_id == GPIO_NUM_MAX) {
+        mp_raise_ValueError("streaming for hall sensor not allowed");
+    }
+    if (i2s_driver_installed) {
+        mp_raise_ValueError("Error: i2s used by other module");
+    }
+
+    // Get arguments
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args-1, pos_args+1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    int freq = args[ARG_freq].u_int;
+    if ((freq < 5000) || (freq > 500000)) {
+        mp_raise_ValueError("frequency out of range (5000 - 500000 Hz)");
+    }
+    int block_len = args[ARG_block].u_int;
+    int nblocks = args[ARG_nblocks].u_int;
+    int decimate = args[ARG_decimate].u_int;
+    if ((block_len < 16) || (block_len > 16384)) {
+        mp_raise_ValueError("block length out of range (16 - 16384)");
+    }
+    if ((nblocks < 2) || (nblocks > 64)) {
+        mp_raise_ValueError("number of blocks out of range (2 - 64)");
+    }
+    if ((decimate < 1) || (decimate > 1024)) {
+        mp_raise_ValueError("decimate out of range (1 - 1024)");
+    }
+
+    self->callback = NULL;
+    if (args[ARG_callback].u_obj != mp_const_none) {
+        if ((!MP_OBJ_IS_FUN(args[ARG_callback].u_obj)) && (!MP_OBJ_IS_METH(args[ARG_callback].u_obj))) {
+            mp_raise_ValueError("callback function expected");
+        }
+        self->callback = args[ARG_callback].u_obj;
+    }
+
+    uint8_t sample_size = 2;
+    self->val_shift = 0;
+    if (args[ARG_byte].u_bool) {
+        sample_size = 1;
+        self->val_shift = self->width + 1;
+    }
+
+    // Allocate the sample blocks on MicroPython heap, so the memoryviews returned to Python remain valid
+    self->stream.mem = NULL;
+    self->stream_held = false;
+    uint8_t *mem = m_new(uint8_t, adc_stream_mem_size(nblocks, block_len, sample_size));
+    adc_block_info_t *info = m_new(adc_block_info_t, nblocks);
+    adc_stream_init(&self->stream, mem, info, nblocks, block_len, sample_size, self->val_shift, decimate, args[ARG_average].u_bool);
+
+    self->fhndl = NULL;
+    if (args[ARG_file].u_obj != mp_const_none) {
+        // stream to file
+        char fullname[128] = {'\0'};
+        const char *fname = mp_obj_str_get_str(args[ARG_file].u_obj);
+        int res = physicalPath(fname, fullname);
+        if ((res != 0) || (strlen(fullname) == 0)) {
+            mp_raise_ValueError("Error resolving file name");
+        }
+        self->fhndl = fopen(fullname, "wb");
+        if (self->fhndl == NULL) {
+            mp_raise_ValueError("Error opening file");
+        }
+    }
+
+    self->buffer = NULL;
+    self->buf_ptr = 0;
+    self->buf_len = 0;
+    self->cal_read = false;
+    stream_period_ns = 1000000000 / freq;
+
+    // configure i2s, more DMA buffers are used than for 'read_timed' to tolerate the consumer latency
+    i2s_config_t i2s_config = {
+        .mode = I2S_MODE_MASTER | I2S_MODE_RX | I2S_MODE_ADC_BUILT_IN, // Only RX, ADC input
+        .sample_rate = freq,
+        .bits_per_sample = 16,
+        .channel_format = I2S_CHANNEL_FMT_RIGHT_LEFT,
+        .communication_format = I2S_COMM_FORMAT_I2S_MSB,
+        .dma_buf_count = 4,
+        .dma_buf_len = 1024,
+        .use_apll = false,
+        .intr_alloc_flags = ESP_INTR_FLAG_LEVEL1,
+        .fixed_mclk = 0
+    };
+
+    // install and start i2s driver
+    i2s_driver_install(0, &i2s_config, 0, NULL);
+    i2s_driver_installed = true;
+    // init ADC pad
+    i2s_set_adc_mode(self->adc_num, self->adc_chan);
+    i2s_adc_enable(0);
+
+    task_stop = false;
+    esp_log_level_set("I2S", ESP_LOG_ERROR);
+    // set before the task is started, so 'readblock' called immediately after sees it running
+    task_running = true;
+    BaseType_t res;
+    #if CONFIG_MICROPY_USE_BOTH_CORES
+    res = xTaskCreate(adc_stream_task, "ADC_stream_task", 2560, (void *)self, CONFIG_MICROPY_TASK_PRIORITY, NULL);
+    #else
+    res = xTaskCreatePinnedToCore(adc_stream_task, "ADC_stream_task", 2560, (void *)self, CONFIG_MICROPY_TASK_PRIORITY, NULL, MainTaskCore);
+    #endif
+    if (res != pdPASS) {
+        task_running = false;
+        i2s_adc_disable(0);
+        i2s_driver_uninstall(0);
+        i2s_driver_installed = false;
+        esp_log_level_set("I2S", CONFIG_LOG_DEFAULT_LEVEL);
+        if (self->fhndl) {
+            fclose(self->fhndl);
+            self->fhndl = NULL;
+        }
+        mp_raise_msg(&mp_type_OSError, "error starting ADC stream task");
+    }
+
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(madc_stream_obj, 0, madc_stream);
+
+// Returns the next block as (seq, timestamp, memoryview) or None on timeout.
+// The memoryview is valid until the next 'readblock' call,
+// the block is then returned to the stream.
+//------------------------------------------------------------------------
+STATIC mp_obj_t madc_readblock(size_t n_args, const mp_obj_t *args) {
+    madc_obj_t *self = args[0];
+    _is_init(self, true, false);
+
+    adc_stream_t *st = &self->stream;
+    if (st->mem == NULL) {
+        mp_raise_ValueError("streaming not started");
+    }
+    if (self->fhndl) {
+        mp_raise_ValueError("streaming to file");
+    }
+    int timeout = -1;
+    if (n_args > 1) timeout = mp_obj_get_int(args[1]);
+
+    if (self->stream_held) {
+        adc_stream_release(st);
+        self->stream_held = false;
+    }
+
+    adc_block_info_t info;
+    uint8_t *block;
+    mp_uint_t start = mp_hal_ticks_ms();
+    while ((block = adc_stream_get(st, &info)) == NULL) {
+        if (!task_running) return mp_const_none;
+        if ((timeout >= 0) && ((mp_hal_ticks_ms() - start) >= (mp_uint_t)timeout)) return mp_const_none;
+        mp_hal_delay_ms(1);
+    }
+    self->stream_held = true;
+
+    mp_obj_t tuple[3];
+    tuple[0] = mp_obj_new_int_from_uint(info.seq);
+    tuple[1] = mp_obj_new_int_from_ull(info.timestamp);
+    tuple[2] = mp_obj_new_memoryview((st->sample_size == 1) ? 'B' : 'H', info.len, block);
+
+    return mp_obj_new_tuple(3, tuple);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(madc_readblock_obj, 1, 2, madc_readblock);
+
+//------------------------------------------------
+STATIC mp_obj_t madc_streamstats(mp_obj_t self_in) {
+    madc_obj_t *self = self_in;
+    _is_init(self, true, false);
+
+    adc_stream_t *st = &self->stream;
+    if (st->mem == NULL) {
+        mp_raise_ValueError("streaming not started");
+    }
+    mp_obj_t tuple[4];
+    tuple[0] = mp_obj_new_int_from_uint(st->blocks);
+    tuple[1] = mp_obj_new_int_from_uint(st->overruns);
+    tuple[2] = mp_obj_new_int_from_uint(st->dropped);
+    tuple[3] = mp_obj_new_int(adc_stream_pending(st));
+
+    return mp_obj_new_tuple(4, tuple);
+}
+MP_DEFINE_CONST_FUN_OBJ_1(madc_streamstats_obj, madc_streamstats);
+
 //----------------------------------------------------
 STATIC mp_obj_t madc_get_collected(mp_obj_t self_in) {
     madc_obj_t *self = self_in;
@@ -1017,6 +1306,9 @@ STATIC const mp_rom_map_elem_t madc_locals_dict_table[] = {
         { MP_ROM_QSTR(MP_QSTR_collected),	MP_ROM_PTR(&madc_get_collected_obj) },
         { MP_ROM_QSTR(MP_QSTR_stopcollect), MP_ROM_PTR(&madc_stop_collect_obj) },
         { MP_ROM_QSTR(MP_QSTR_progress),	MP_ROM_PTR(&madc_progress_obj) },
+        { MP_ROM_QSTR(MP_QSTR_stream),		MP_ROM_PTR(&madc_stream_obj) },
+        { MP_ROM_QSTR(MP_QSTR_readblock),	MP_ROM_PTR(&madc_readblock_obj) },
+        { MP_ROM_QSTR(MP_QSTR_streamstats),	MP_ROM_PTR(&madc_streamstats_obj) },
         { MP_ROM_QSTR(MP_QSTR_atten),		MP_ROM_PTR(&madc_atten_obj) },
         { MP_ROM_QSTR(MP_QSTR_width),		MP_ROM_PTR(&madc_width_obj) },
         { MP_ROM_QSTR(MP_QSTR_vref),		MP_ROM_PTR(&madc_vref_togpio_obj) },
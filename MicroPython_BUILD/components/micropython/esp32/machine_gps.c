@@ -47,6 +47,7 @@
 #include "machine_uart.h"
 #include "modmachine.h"
 #include "nmea.h"
+#include "nmea_stream.h"
 #include "gpgll.h"
 #include "gpgga.h"
 #include "gprmc.h"
@@ -58,18 +59,6 @@
 
 const char *GPS_TAG = "MODGPS";
 
-typedef struct {
-	struct tm datetime;
-	float latitude;
-	float longitude;
-	float altitude;
-	float speed;
-	float course;
-	float dop;
-	uint8_t quality;
-	uint8_t nsat;
-} gps_data_t;
-
 typedef struct {
 	void *cb_func;
 	uint8_t type;
@@ -99,7 +88,7 @@ typedef struct _machine_gps_obj_t {
     bool task_stop;
     uint32_t sent_read;
     gps_data_t gps_data;
-    gps_data_t last_gps_data;
+    nmea_stream_t stream;
     cb_func_coord_t cb_latitude;
     cb_func_coord_t cb_longitude;
 } machine_gps_obj_t;
@@ -205,7 +194,7 @@ static nmea_s *get_nmea_data(uart_port_t uart_num, char *sent_type, int timeout,
 }
 
 //-----------------------------------------------------------------------------------------------------
-static mp_obj_t nmea_data(nmea_s *data, bool settuple, gps_data_t *gps_data, gps_data_t *gps_last_data)
+static mp_obj_t nmea_data(nmea_s *data, bool settuple, gps_data_t *gps_data)
 {
 	mp_obj_t res_tuple = mp_const_none;
 
@@ -223,10 +212,6 @@ static mp_obj_t nmea_data(nmea_s *data, bool settuple, gps_data_t *gps_data, gps
 		return res_tuple;
 	}
 
-	if ((gps_data) && (gps_last_data)) {
-		memcpy(gps_last_data, gps_data, sizeof(gps_data_t));
-	}
-
 	if (NMEA_GGA == data->type) {
 		nmea_gpgga_s *gpgga = (nmea_gpgga_s *) data;
 		if (gps_data) {
@@ -407,8 +392,8 @@ static void gps_task(void *pv)
 	if (gps_mutex) xSemaphoreGive(gps_mutex);
     machine_uart_obj_t *uart = (machine_uart_obj_t *)gps_obj->uart;
 
-	nmea_s *data;
-	char *sentence;
+	uint8_t rxbuf[64];
+	int rxlen;
 
 	while (true) {
 		if (gps_mutex) xSemaphoreTake(gps_mutex, 200 / portTICK_PERIOD_MS);
@@ -418,18 +403,14 @@ static void gps_task(void *pv)
 			break;
 		}
 		if (gps_mutex) xSemaphoreGive(gps_mutex);
-		sentence = _uart_read(uart->uart_num, 2000, "\r\n", "$G");
-		if (sentence) {
+		// Feed the received bytes to the streaming parser,
+		// the sentences are parsed directly into gps_data
+		rxlen = _uart_read_bytes(uart->uart_num, rxbuf, sizeof(rxbuf), 100);
+		if (rxlen > 0) {
 			if (gps_mutex) xSemaphoreTake(gps_mutex, 200 / portTICK_PERIOD_MS);
-			data = nmea_parse(sentence, strlen(sentence), gps_obj->use_crc);
-			if (data != NULL) gps_obj->sent_read++;
+			nmea_stream_feed(&gps_obj->stream, rxbuf, rxlen);
+			gps_obj->sent_read = gps_obj->stream.sentences;
 			if (gps_mutex) xSemaphoreGive(gps_mutex);
-			if (data != NULL) {
-				// store to gps_data only
-				nmea_data(data, false, &gps_obj->gps_data, &gps_obj->last_gps_data);
-				nmea_free(data);
-			}
-			free(sentence);
 			// Check callbacks
 			if (gps_obj->cb_latitude.cb_func) {
 
@@ -458,6 +439,7 @@ static bool _check_task(machine_gps_obj_t *self, bool start)
 		esp_log_level_set(GPS_TAG, ESP_LOG_ERROR);
 		esp_log_level_set(NMEA_TAG, ESP_LOG_ERROR);
 		self->sent_read = 0;
+		nmea_stream_init(&self->stream, &self->gps_data, self->use_crc);
 		#if CONFIG_MICROPY_USE_BOTH_CORES
     	int tres = xTaskCreate(gps_task, "gps_task", CONFIG_MICROPY_GPS_SERVICE_STACK, self, CONFIG_MICROPY_TASK_PRIORITY, NULL);
 		#else
@@ -482,10 +464,12 @@ STATIC void machine_gps_print(const mp_print_t *print, mp_obj_t self_in, mp_prin
 	if (gps_mutex) xSemaphoreTake(gps_mutex, 200 / portTICK_PERIOD_MS);
     bool task_running = self->task_running;
     uint32_t sent_read = self->sent_read;
+    uint32_t chk_errors = self->stream.chk_errors;
+    uint32_t errors = self->stream.errors;
 	if (gps_mutex) xSemaphoreGive(gps_mutex);
 
-    mp_printf(print, "GPS(default_timeout=%u, use_crc=%s, task_running=%s, read_sentences=%u)",
-        self->timeout, self->use_crc ? "True" : "False", task_running ? "True" : "False", sent_read);
+    mp_printf(print, "GPS(default_timeout=%u, use_crc=%s, task_running=%s, read_sentences=%u, crc_errors=%u, errors=%u)",
+        self->timeout, self->use_crc ? "True" : "False", task_running ? "True" : "False", sent_read, chk_errors, errors);
 }
 
 //--------------------------------------
@@ -503,7 +487,10 @@ STATIC void machine_gps_init_helper(machine_gps_obj_t *self, size_t n_args, cons
     mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
 
     if (args[ARG_timeout].u_int > 0) self->timeout = args[ARG_timeout].u_int;
-    if (args[ARG_crc].u_int >= 0) self->use_crc = (args[ARG_crc].u_int != 0);
+    if (args[ARG_crc].u_int >= 0) {
+    	self->use_crc = (args[ARG_crc].u_int != 0);
+    	self->stream.check_checksum = self->use_crc;
+    }
     if (args[ARG_service].u_bool) {
     	_check_task(self, true);
     }
@@ -606,7 +593,7 @@ STATIC mp_obj_t machine_gps_parse(mp_obj_t self_in, mp_obj_t sent_in)
 		nmea_s *data = nmea_parse(sent, strlen(sent), self->use_crc);
 		if (data != NULL) {
 			// store to dict only
-			res = nmea_data(data, true, NULL, NULL);
+			res = nmea_data(data, true, NULL);
 			nmea_free(data);
 		}
 		free(sent);
@@ -648,7 +635,7 @@ STATIC mp_obj_t machine_gps_read_parse(size_t n_args, const mp_obj_t *args)
 
 	if (data != NULL) {
 		// store to dict and gps_data
-		res = nmea_data(data, true, &self->gps_data, NULL);
+		res = nmea_data(data, true, &self->gps_data);
 		nmea_free(data);
 	}
 
@@ -679,6 +666,60 @@ STATIC mp_obj_t machine_gps_getdata(mp_obj_t self_in)
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_1(machine_gps_getdata_obj, machine_gps_getdata);
 
+// Returns the fix accuracy data from GSA & GST sentences
+//----------------------------------------------------
+STATIC mp_obj_t machine_gps_accuracy(mp_obj_t self_in)
+{
+    machine_gps_obj_t *self = MP_OBJ_TO_PTR(self_in);
+
+	if (gps_mutex) xSemaphoreTake(gps_mutex, 200 / portTICK_PERIOD_MS);
+	mp_obj_t tuple[8] = {
+		mp_obj_new_int(self->gps_data.fix_type),
+		mp_obj_new_float(self->gps_data.pdop),
+		mp_obj_new_float(self->gps_data.dop),
+		mp_obj_new_float(self->gps_data.vdop),
+		mp_obj_new_float(self->gps_data.rms),
+		mp_obj_new_float(self->gps_data.lat_sd),
+		mp_obj_new_float(self->gps_data.lon_sd),
+		mp_obj_new_float(self->gps_data.alt_sd)
+	};
+    if (gps_mutex) xSemaphoreGive(gps_mutex);
+
+    return mp_obj_new_tuple(8, tuple);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(machine_gps_accuracy_obj, machine_gps_accuracy);
+
+// Returns the list of satellites in view from GSV sentences:
+// (system, prn, elevation, azimuth, snr, used)
+//------------------------------------------------------
+STATIC mp_obj_t machine_gps_satellites(mp_obj_t self_in)
+{
+    machine_gps_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    mp_obj_t sat_list = mp_obj_new_list(0, NULL);
+
+	if (gps_mutex) xSemaphoreTake(gps_mutex, 200 / portTICK_PERIOD_MS);
+	for (int sys=0; sys<NMEA_SYSTEMS; sys++) {
+		for (int i=0; i<self->gps_data.n_sats[sys]; i++) {
+			nmea_sat_t *sat = &self->gps_data.sats[sys][i];
+			bool used = (memchr(self->gps_data.used[sys], sat->prn, self->gps_data.n_used[sys]) != NULL) ||
+						(memchr(self->gps_data.used_unknown, sat->prn, self->gps_data.n_used_unknown) != NULL);
+			mp_obj_t tuple[6] = {
+				mp_obj_new_int(sys),
+				mp_obj_new_int(sat->prn),
+				mp_obj_new_int(sat->elevation),
+				mp_obj_new_int(sat->azimuth),
+				mp_obj_new_int(sat->snr),
+				mp_obj_new_bool(used)
+			};
+			mp_obj_list_append(sat_list, mp_obj_new_tuple(6, tuple));
+		}
+	}
+    if (gps_mutex) xSemaphoreGive(gps_mutex);
+
+    return sat_list;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(machine_gps_satellites_obj, machine_gps_satellites);
+
 //--------------------------------------------------------
 STATIC mp_obj_t machine_gps_startservice(mp_obj_t self_in)
 {
@@ -734,6 +775,8 @@ STATIC const mp_rom_map_elem_t machine_gps_locals_dict_table[] = {
 	{ MP_ROM_QSTR(MP_QSTR_read),			MP_ROM_PTR(&machine_gps_readsentence_obj) },
 	{ MP_ROM_QSTR(MP_QSTR_read_parse),		MP_ROM_PTR(&machine_gps_read_parse_obj) },
 	{ MP_ROM_QSTR(MP_QSTR_getdata),			MP_ROM_PTR(&machine_gps_getdata_obj) },
+	{ MP_ROM_QSTR(MP_QSTR_accuracy),		MP_ROM_PTR(&machine_gps_accuracy_obj) },
+	{ MP_ROM_QSTR(MP_QSTR_satellites),		MP_ROM_PTR(&machine_gps_satellites_obj) },
 	{ MP_ROM_QSTR(MP_QSTR_startservice),	MP_ROM_PTR(&machine_gps_startservice_obj) },
 	{ MP_ROM_QSTR(MP_QSTR_stopservice),		MP_ROM_PTR(&machine_gps_stopservice_obj) },
 	{ MP_ROM_QSTR(MP_QSTR_service),			MP_ROM_PTR(&machine_gps_taskrunning_obj) },
@@ -40,6 +40,7 @@
 #include "py/obj.h"
 
 #include "modmachine.h"
+#include "libs/sensor_sched.h"
 
 #define I2C_ACK_CHECK_EN            (1)
 #define I2C_RX_MAX_BUFF_LEN			2048	// maximum low level commands receive buffer length
@@ -81,6 +82,7 @@ static int i2c_used[I2C_MODE_MAX] = { -1, -1 };
 static QueueHandle_t slave_mutex[I2C_MODE_MAX] = { NULL, NULL };
 static TaskHandle_t i2c_slave_task_handle = NULL;
 static i2c_slave_state_t slave_state;
+static i2c_cmd_handle_t sensor_cmd[I2C_MODE_MAX] = { NULL, NULL };
 
 
 // ============================================================================================
@@ -973,6 +975,97 @@ STATIC mp_obj_t mp_machine_i2c_deinit(mp_obj_t self_in) {
 STATIC MP_DEFINE_CONST_FUN_OBJ_1(mp_machine_i2c_deinit_obj, mp_machine_i2c_deinit);
 
 
+// ============================================================================================
+// ==== Sensor acquisition scheduler bus backend ==============================================
+// ============================================================================================
+
+// All transactions between 'begin' and 'end' are added to the single command link
+
+//-------------------------------------------------------------------------------------------------------------------------
+static esp_err_t _sensor_add_cmd(i2c_cmd_handle_t cmd, uint8_t addr, const uint8_t *wbuf, uint8_t wlen, uint8_t *rbuf, uint8_t rlen)
+{
+    if (wlen) {
+        if (i2c_master_start(cmd) != ESP_OK) return 1;
+        if (i2c_master_write_byte(cmd, (addr << 1) | I2C_MASTER_WRITE, I2C_ACK_CHECK_EN) != ESP_OK) return 2;
+        if (i2c_master_write(cmd, (uint8_t *)wbuf, wlen, I2C_ACK_CHECK_EN) != ESP_OK) return 3;
+    }
+    if (rlen) {
+        // repeated start if the command was written
+        if (i2c_master_start(cmd) != ESP_OK) return 4;
+        if (i2c_master_write_byte(cmd, (addr << 1) | I2C_MASTER_READ, I2C_ACK_CHECK_EN) != ESP_OK) return 8;
+        if (rlen > 1) {
+            if (i2c_master_read(cmd, rbuf, rlen - 1, I2C_MASTER_ACK) != ESP_OK) return 9;
+        }
+        if (i2c_master_read_byte(cmd, rbuf + rlen - 1, I2C_MASTER_NACK) != ESP_OK) return 10;
+    }
+    if (i2c_master_stop(cmd) != ESP_OK) return 11;
+    return ESP_OK;
+}
+
+//----------------------------------------
+static int i2c_sensor_begin(void *bus)
+{
+    mp_machine_i2c_obj_t *self = (mp_machine_i2c_obj_t *)bus;
+    if (sensor_cmd[self->bus_id]) return -1;
+    sensor_cmd[self->bus_id] = i2c_cmd_link_create();
+    return (sensor_cmd[self->bus_id]) ? 0 : -1;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+static int i2c_sensor_xfer(void *bus, sensor_dev_t *dev, const uint8_t *wbuf, uint8_t wlen, uint8_t *rbuf, uint8_t rlen)
+{
+    mp_machine_i2c_obj_t *self = (mp_machine_i2c_obj_t *)bus;
+    if ((wlen == 0) && (rlen == 0)) return 0;
+    if (rlen) memset(rbuf, 0xFF, rlen);
+
+    if (sensor_cmd[self->bus_id]) return _sensor_add_cmd(sensor_cmd[self->bus_id], dev->addr, wbuf, wlen, rbuf, rlen);
+
+    // not batched, execute immediately
+    i2c_cmd_handle_t cmd = i2c_cmd_link_create();
+    esp_err_t ret = _sensor_add_cmd(cmd, dev->addr, wbuf, wlen, rbuf, rlen);
+    if (ret == ESP_OK) ret = i2c_master_cmd_begin(self->bus_id, cmd, (5000 + (1000 * rlen)) / portTICK_RATE_MS);
+    i2c_cmd_link_delete(cmd);
+    return ret;
+}
+
+//--------------------------------------
+static int i2c_sensor_end(void *bus)
+{
+    mp_machine_i2c_obj_t *self = (mp_machine_i2c_obj_t *)bus;
+    i2c_cmd_handle_t cmd = sensor_cmd[self->bus_id];
+    if (cmd == NULL) return -1;
+    sensor_cmd[self->bus_id] = NULL;
+
+    esp_err_t ret = i2c_master_cmd_begin(self->bus_id, cmd, 5000 / portTICK_RATE_MS);
+    i2c_cmd_link_delete(cmd);
+    return ret;
+}
+
+static const sensor_bus_ops_t i2c_sensor_ops = {
+    .begin = i2c_sensor_begin,
+    .xfer = i2c_sensor_xfer,
+    .end = i2c_sensor_end,
+    .broadcast = NULL,
+};
+
+// Set the I2C bus backend for the scheduler device
+//-------------------------------------------------------------------------
+void machine_hw_i2c_sensor_dev(mp_obj_t i2c_in, int addr, sensor_dev_t *dev)
+{
+    if (!MP_OBJ_IS_TYPE(i2c_in, &machine_hw_i2c_type)) {
+        mp_raise_ValueError("I2C object expected");
+    }
+    mp_machine_i2c_obj_t *self = MP_OBJ_TO_PTR(i2c_in);
+    _checkMaster(self);
+    _checkAddr(addr);
+
+    dev->ops = &i2c_sensor_ops;
+    dev->bus = self;
+    dev->dev = NULL;
+    dev->addr = addr;
+}
+
+
 // ============================================================================================
 // ==== Low level MicroPython I2C commands ====================================================
 // ============================================================================================
@@ -32,14 +32,28 @@
 #include <string.h>
 #include <stdbool.h>
 #include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 
 //#include "py/runtime.h"
 #include "py/stream.h"
 #include "py/mphal.h"
+#include "py/mpstate.h"
 #include "modmachine.h"
 #include "py/objstr.h"
 
 #include "machine_hw_spi.h"
+#include "libs/sensor_sched.h"
+#include "libs/spi_queue.h"
+
+#define SPI_QUEUE_DEPTH     4       // transactions queued to the driver at once, also the device queue size
+#define SPI_QUEUE_MAX_XFER  4092    // maximal DMA transfer length
+
+extern int MainTaskCore;
+
+// Throughput counters of the queued transactions, per SPI host
+static spi_queue_stats_t spi_bus_stats[3] = { 0 };
 
 /*
  * There are two SPI hosts on ESP32 available to the user, HSPI_HOST & VSPI_HOST
@@ -280,7 +294,7 @@ mp_obj_t machine_hw_spi_make_new(const mp_obj_type_t *type, size_t n_args, size_
         machine_pin_get_gpio(args[ARG_miso].u_obj),
     	cs,
         args[ARG_duplex].u_bool,
-		1,
+		SPI_QUEUE_DEPTH,
 		1);
 
     return MP_OBJ_FROM_PTR(self);
@@ -454,6 +468,51 @@ STATIC mp_obj_t mp_machine_spi_read_from_mem(mp_uint_t n_args, const mp_obj_t *p
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_KW(mp_machine_spi_read_from_mem_obj, 0, mp_machine_spi_read_from_mem);
 
+// ==== Sensor acquisition scheduler bus backend ====
+// Each SPI object is a single device (CS pin), the transaction is executed immediately
+
+//--------------------------------------------------------------------------------------------------------------------
+static int spi_sensor_xfer(void *bus, sensor_dev_t *dev, const uint8_t *wbuf, uint8_t wlen, uint8_t *rbuf, uint8_t rlen)
+{
+    machine_hw_spi_obj_t *self = (machine_hw_spi_obj_t *)bus;
+    if ((wlen == 0) && (rlen == 0)) return 0;
+    if (self->state != MACHINE_HW_SPI_STATE_INIT) return -1;
+
+	spi_transaction_t t;
+    memset(&t, 0, sizeof(t));  //Zero out the transaction
+
+    t.tx_buffer = wbuf;
+    t.length = wlen * 8;
+    t.rxlength = rlen * 8;
+    t.rx_buffer = rbuf;
+
+	return spi_transfer_data_nodma(&self->spi, &t);
+}
+
+static const sensor_bus_ops_t spi_sensor_ops = {
+    .begin = NULL,
+    .xfer = spi_sensor_xfer,
+    .end = NULL,
+    .broadcast = NULL,
+};
+
+// Set the SPI bus backend for the scheduler device
+//------------------------------------------------------------
+void machine_hw_spi_sensor_dev(mp_obj_t spi_in, sensor_dev_t *dev)
+{
+    if (!MP_OBJ_IS_TYPE(spi_in, &machine_hw_spi_type)) {
+        mp_raise_ValueError("SPI object expected");
+    }
+    machine_hw_spi_obj_t *self = MP_OBJ_TO_PTR(spi_in);
+    checkSPI(self);
+
+    dev->ops = &spi_sensor_ops;
+    dev->bus = self;
+    dev->dev = NULL;
+    dev->addr = 0;
+}
+
+
 //-----------------------------------------------------
 STATIC mp_obj_t mp_machine_spi_select(mp_obj_t self_in)
 {
@@ -481,6 +540,550 @@ STATIC mp_obj_t mp_machine_spi_deselect(mp_obj_t self_in)
 STATIC MP_DEFINE_CONST_FUN_OBJ_1(mp_machine_spi_deselect_obj, mp_machine_spi_deselect);
 
 
+// ==== Transaction queue ====
+// Send-only transfers are queued to the driver and executed with DMA,
+// transfers which receive data are executed in direct mode after the queued ones complete.
+
+typedef struct _spi_queue_slot_t {
+    spi_transaction_t t;
+    int8_t pending;         // queued to the driver, result not yet collected
+    int8_t result;
+} spi_queue_slot_t;
+
+typedef struct _machine_spi_queue_obj_t {
+    mp_obj_base_t base;
+    machine_hw_spi_obj_t *spi;
+    spi_queue_t queue;
+    spi_queue_slot_t slot[SPI_QUEUE_DEPTH];
+    uint8_t slot_put;
+    uint8_t slot_get;
+    int8_t saved_cs;
+    uint8_t finished;       // the received data was copied to the user buffers
+    volatile uint8_t task_running;
+    volatile uint8_t finish_pending;    // the finish function could not be scheduled
+    mp_obj_t rx_bufs;       // list of the user receive buffers (or None), one per descriptor
+    mp_obj_t callback;
+    struct _machine_spi_queue_obj_t *next_active;
+} machine_spi_queue_obj_t;
+
+const mp_obj_type_t machine_spi_queue_type;
+
+//------------------------------------
+static int spiq_select(void *bus, int cs)
+{
+    machine_spi_queue_obj_t *self = (machine_spi_queue_obj_t *)bus;
+    if (cs >= 0) {
+        self->saved_cs = self->spi->spi.cs;
+        self->spi->spi.cs = cs;
+    }
+    if (spi_device_select(&self->spi->spi, 0) == ESP_OK) return 0;
+    if (cs >= 0) self->spi->spi.cs = self->saved_cs;
+    return -1;
+}
+
+//--------------------------------------
+static int spiq_deselect(void *bus, int cs)
+{
+    machine_spi_queue_obj_t *self = (machine_spi_queue_obj_t *)bus;
+    esp_err_t ret = spi_device_deselect(&self->spi->spi);
+    if (cs >= 0) self->spi->spi.cs = self->saved_cs;
+    return (ret == ESP_OK) ? 0 : -1;
+}
+
+// Collect the results of all transfers queued to the driver
+//----------------------------------------------------
+static void spiq_drain(machine_spi_queue_obj_t *self)
+{
+    spi_transaction_t *rt;
+    for (uint8_t i=self->slot_get; i!=self->slot_put; i=(i+1) % SPI_QUEUE_DEPTH) {
+        if (self->slot[i].pending) {
+            self->slot[i].result = (spi_device_get_trans_result(self->spi->spi.handle, &rt, portMAX_DELAY) == ESP_OK) ? 0 : -1;
+            self->slot[i].pending = 0;
+        }
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+static int spiq_start(void *bus, const uint8_t *tx, uint32_t txlen, uint8_t *rx, uint32_t rxlen)
+{
+    machine_spi_queue_obj_t *self = (machine_spi_queue_obj_t *)bus;
+    spi_queue_slot_t *slot = &self->slot[self->slot_put];
+
+    memset(&slot->t, 0, sizeof(spi_transaction_t));
+    slot->t.length = txlen * 8;
+    slot->t.tx_buffer = tx;
+    slot->t.rxlength = rxlen * 8;
+    slot->t.rx_buffer = rx;
+    slot->result = 0;
+
+    if (rxlen == 0) {
+        // send only, queue the DMA transfer
+        if (spi_device_queue_trans(self->spi->spi.handle, &slot->t, portMAX_DELAY) != ESP_OK) return -1;
+        slot->pending = 1;
+    }
+    else {
+        spiq_drain(self);
+        slot->pending = 0;
+        slot->result = (spi_transfer_data_nodma(&self->spi->spi, &slot->t) == ESP_OK) ? 0 : -1;
+    }
+    self->slot_put = (self->slot_put + 1) % SPI_QUEUE_DEPTH;
+    return 0;
+}
+
+//--------------------------
+static int spiq_wait(void *bus)
+{
+    machine_spi_queue_obj_t *self = (machine_spi_queue_obj_t *)bus;
+    spi_queue_slot_t *slot = &self->slot[self->slot_get];
+    spi_transaction_t *rt;
+
+    if (slot->pending) {
+        slot->result = (spi_device_get_trans_result(self->spi->spi.handle, &rt, portMAX_DELAY) == ESP_OK) ? 0 : -1;
+        slot->pending = 0;
+    }
+    self->slot_get = (self->slot_get + 1) % SPI_QUEUE_DEPTH;
+    return slot->result;
+}
+
+//----------------------------
+static uint64_t spiq_time_us()
+{
+    return (uint64_t)esp_timer_get_time();
+}
+
+static const spi_queue_ops_t spiq_ops = {
+    .select = spiq_select,
+    .deselect = spiq_deselect,
+    .start = spiq_start,
+    .wait = spiq_wait,
+    .time_us = spiq_time_us,
+};
+
+//--------------------------------------------------------------
+STATIC void spi_queue_check(machine_spi_queue_obj_t *self, bool idle)
+{
+    if (self->queue.mem == NULL) {
+        mp_raise_msg(&mp_type_OSError, "SPI queue deinitialized");
+    }
+    if ((idle) && ((self->task_running) || (self->queue.state == SPI_QUEUE_RUNNING))) {
+        mp_raise_msg(&mp_type_OSError, "SPI queue running");
+    }
+}
+
+// A queue run in background is kept in the list of active queues until its finish
+// function runs, so it is not collected while the task or the scheduler uses it
+//--------------------------------------------------------------
+STATIC void spi_queue_set_active(machine_spi_queue_obj_t *self, bool active)
+{
+    machine_spi_queue_obj_t **prev = &MP_STATE_PORT(spi_queue_active);
+    while ((*prev != NULL) && (*prev != self)) prev = &(*prev)->next_active;
+    if (*prev == self) *prev = self->next_active;
+    self->next_active = NULL;
+    if (active) {
+        self->next_active = MP_STATE_PORT(spi_queue_active);
+        MP_STATE_PORT(spi_queue_active) = self;
+    }
+}
+
+// Copy the received data to the user buffers, once per run
+//--------------------------------------------------------
+STATIC void spi_queue_copy_rx(machine_spi_queue_obj_t *self)
+{
+    if ((self->finished) || (self->queue.state != SPI_QUEUE_DONE)) return;
+    self->finished = 1;
+
+    size_t nbufs;
+    mp_obj_t *bufs;
+    mp_obj_list_get(self->rx_bufs, &nbufs, &bufs);
+    for (int i=0; i<nbufs; i++) {
+        if ((i >= self->queue.completed) || (bufs[i] == mp_const_none)) continue;
+        mp_buffer_info_t dest;
+        uint32_t len;
+        uint8_t *rx = spi_queue_rx(&self->queue, i, &len);
+        mp_get_buffer_raise(bufs[i], &dest, MP_BUFFER_WRITE);
+        if (len > dest.len) len = dest.len;
+        if (rx) memcpy(dest.buf, rx, len);
+    }
+}
+
+// Scheduled when the background run is finished
+//-----------------------------------------------------
+STATIC mp_obj_t spi_queue_finish(mp_obj_t self_in)
+{
+    machine_spi_queue_obj_t *self = MP_OBJ_TO_PTR(self_in);
+
+    // the task clears 'task_running' right after scheduling this function,
+    // wait for it so the callback can start the next run
+    while (self->task_running) {
+        vTaskDelay(1);
+    }
+    spi_queue_set_active(self, false);
+    if (self->queue.mem == NULL) return mp_const_none;
+    spi_queue_copy_rx(self);
+    if (self->callback != mp_const_none) {
+        mp_obj_t cb = self->callback;
+        self->callback = mp_const_none;
+        mp_call_function_1(cb, self_in);
+    }
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(spi_queue_finish_obj, spi_queue_finish);
+
+// Run the finish function of the background run which could not be scheduled
+//------------------------------------------------------------
+STATIC void spi_queue_finish_pending(machine_spi_queue_obj_t *self)
+{
+    if ((self->finish_pending) && (!self->task_running)) {
+        self->finish_pending = 0;
+        spi_queue_finish(MP_OBJ_FROM_PTR(self));
+    }
+}
+
+//=============================================
+static void spi_queue_task(void *pvParameters)
+{
+    machine_spi_queue_obj_t *self = (machine_spi_queue_obj_t *)pvParameters;
+
+    spi_queue_run(&self->queue);
+    // if the scheduler queue stays full, the finish function is run by the next 'done' or 'run'
+    int retry = 10;
+    while (!mp_sched_schedule((mp_obj_t)&spi_queue_finish_obj, MP_OBJ_FROM_PTR(self), NULL)) {
+        if (--retry == 0) {
+            self->finish_pending = 1;
+            break;
+        }
+        vTaskDelay(10 / portTICK_PERIOD_MS);
+    }
+    self->task_running = 0;
+
+    vTaskDelete(NULL);
+}
+
+//---------------------------------------------------------------------------------------------
+STATIC mp_obj_t mp_machine_spi_queue(mp_uint_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args)
+{
+    enum { ARG_n, ARG_size };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_n,    MP_ARG_INT, {.u_int = 16} },
+        { MP_QSTR_size, MP_ARG_INT, {.u_int = 4096} },
+    };
+
+    machine_hw_spi_obj_t *spi = pos_args[0];
+    checkSPI(spi);
+
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args-1, pos_args+1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    if ((args[ARG_n].u_int < 1) || (args[ARG_n].u_int > 1024)) {
+        mp_raise_ValueError("number of transactions must be 1 ~ 1024");
+    }
+    if ((args[ARG_size].u_int < 4) || (args[ARG_size].u_int > 65536)) {
+        mp_raise_ValueError("data buffer size must be 4 ~ 65536");
+    }
+    int size = (args[ARG_size].u_int + 3) & ~3;
+
+    // descriptors and data are used by the driver, allocate outside of the MicroPython heap
+    spi_queue_desc_t *desc = heap_caps_malloc(args[ARG_n].u_int * sizeof(spi_queue_desc_t), MALLOC_CAP_8BIT | MALLOC_CAP_INTERNAL);
+    uint8_t *mem = heap_caps_malloc(size, MALLOC_CAP_DMA);
+    if ((desc == NULL) || (mem == NULL)) {
+        if (desc) free(desc);
+        if (mem) free(mem);
+        mp_raise_msg(&mp_type_OSError, "error allocating SPI queue buffers");
+    }
+
+    machine_spi_queue_obj_t *self = m_new_obj_with_finaliser(machine_spi_queue_obj_t);
+    memset(self, 0, sizeof(machine_spi_queue_obj_t));
+    self->base.type = &machine_spi_queue_type;
+    self->spi = spi;
+    self->rx_bufs = mp_obj_new_list(0, NULL);
+    self->callback = mp_const_none;
+    spi_queue_init(&self->queue, &spiq_ops, self, desc, args[ARG_n].u_int, mem, size, SPI_QUEUE_MAX_XFER, SPI_QUEUE_DEPTH);
+    self->queue.stats = &spi_bus_stats[spi->spi.spihost];
+
+    return MP_OBJ_FROM_PTR(self);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(mp_machine_spi_queue_obj, 0, mp_machine_spi_queue);
+
+//---------------------------------------------------------------------------
+STATIC mp_obj_t mp_machine_spi_stats(size_t n_args, const mp_obj_t *args)
+{
+    machine_hw_spi_obj_t *self = args[0];
+    spi_queue_stats_t *st = &spi_bus_stats[self->spi.spihost];
+
+    mp_obj_t tuple[6];
+    tuple[0] = mp_obj_new_int_from_uint(st->transactions);
+    tuple[1] = mp_obj_new_int_from_uint(st->batches);
+    tuple[2] = mp_obj_new_int_from_uint(st->errors);
+    tuple[3] = mp_obj_new_int_from_ull(st->bytes_tx);
+    tuple[4] = mp_obj_new_int_from_ull(st->bytes_rx);
+    tuple[5] = mp_obj_new_int_from_ull(st->busy_us);
+
+    if ((n_args > 1) && (mp_obj_is_true(args[1]))) memset(st, 0, sizeof(spi_queue_stats_t));
+
+    return mp_obj_new_tuple(6, tuple);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(mp_machine_spi_stats_obj, 1, 2, mp_machine_spi_stats);
+
+//---------------------------------------------------------------------------------------------
+STATIC mp_obj_t spi_queue_add_trans(mp_uint_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args)
+{
+    enum { ARG_tx, ARG_rx, ARG_cs, ARG_keep };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_tx,                     MP_ARG_OBJ,  {.u_obj = mp_const_none} },
+        { MP_QSTR_rx,                     MP_ARG_OBJ,  {.u_obj = mp_const_none} },
+        { MP_QSTR_cs,   MP_ARG_KW_ONLY  | MP_ARG_OBJ,  {.u_obj = mp_const_none} },
+        { MP_QSTR_keep, MP_ARG_KW_ONLY  | MP_ARG_BOOL, {.u_bool = false} },
+    };
+
+    machine_spi_queue_obj_t *self = MP_OBJ_TO_PTR(pos_args[0]);
+    spi_queue_check(self, true);
+
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args-1, pos_args+1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    mp_buffer_info_t src = { .buf = NULL, .len = 0 };
+    if (args[ARG_tx].u_obj != mp_const_none) mp_get_buffer_raise(args[ARG_tx].u_obj, &src, MP_BUFFER_READ);
+
+    // rx can be the number of bytes to receive or the buffer to receive into
+    uint32_t rxlen = 0;
+    mp_obj_t rxbuf = mp_const_none;
+    if (MP_OBJ_IS_INT(args[ARG_rx].u_obj)) {
+        if (mp_obj_get_int(args[ARG_rx].u_obj) < 0) mp_raise_ValueError("negative receive length");
+        rxlen = mp_obj_get_int(args[ARG_rx].u_obj);
+    }
+    else if (args[ARG_rx].u_obj != mp_const_none) {
+        mp_buffer_info_t dest;
+        mp_get_buffer_raise(args[ARG_rx].u_obj, &dest, MP_BUFFER_WRITE);
+        rxlen = dest.len;
+        rxbuf = args[ARG_rx].u_obj;
+    }
+
+    int cs = SPI_QUEUE_CS_DEFAULT;
+    if (args[ARG_cs].u_obj != mp_const_none) {
+        cs = machine_pin_get_gpio(args[ARG_cs].u_obj);
+        if (cs != self->spi->spi.cs) {
+            gpio_pad_select_gpio(cs);
+            gpio_set_direction(cs, GPIO_MODE_OUTPUT);
+            gpio_set_level(cs, 1);
+        }
+        else cs = SPI_QUEUE_CS_DEFAULT;
+    }
+
+    int idx = spi_queue_add(&self->queue, cs, src.buf, src.len, rxlen, (args[ARG_keep].u_bool) ? SPI_QUEUE_KEEP_CS : 0);
+    switch (idx) {
+        case SPI_QUEUE_ERR_ARG:
+            mp_raise_ValueError("invalid transaction length");
+            break;
+        case SPI_QUEUE_ERR_FULL:
+            mp_raise_msg(&mp_type_OSError, "no free transaction descriptor");
+            break;
+        case SPI_QUEUE_ERR_NOMEM:
+            mp_raise_msg(&mp_type_OSError, "no space in the data buffer");
+            break;
+        default:
+            break;
+    }
+    if (idx == mp_obj_get_int(mp_obj_len(self->rx_bufs))) mp_obj_list_append(self->rx_bufs, rxbuf);
+
+    return mp_obj_new_int(idx);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(spi_queue_add_obj, 0, spi_queue_add_trans);
+
+//---------------------------------------------------------------------------------------------
+STATIC mp_obj_t spi_queue_execute(mp_uint_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args)
+{
+    enum { ARG_wait, ARG_callback };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_wait,     MP_ARG_BOOL, {.u_bool = true} },
+        { MP_QSTR_callback, MP_ARG_OBJ,  {.u_obj = mp_const_none} },
+    };
+
+    machine_spi_queue_obj_t *self = MP_OBJ_TO_PTR(pos_args[0]);
+    spi_queue_check(self, true);
+    checkSPI(self->spi);
+    // deliver the result of the previous run first
+    spi_queue_finish_pending(self);
+
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args-1, pos_args+1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    if ((args[ARG_callback].u_obj != mp_const_none) && (!mp_obj_is_callable(args[ARG_callback].u_obj))) {
+        mp_raise_ValueError("callback must be a function");
+    }
+    self->finished = 0;
+    self->slot_put = 0;
+    self->slot_get = 0;
+
+    if (args[ARG_wait].u_bool) {
+        int res;
+        MP_THREAD_GIL_EXIT();
+        res = spi_queue_run(&self->queue);
+        MP_THREAD_GIL_ENTER();
+        spi_queue_copy_rx(self);
+        if (args[ARG_callback].u_obj != mp_const_none) mp_call_function_1(args[ARG_callback].u_obj, MP_OBJ_FROM_PTR(self));
+        return (res == 0) ? mp_const_true : mp_const_false;
+    }
+
+    // run in background
+    self->callback = args[ARG_callback].u_obj;
+    self->finish_pending = 0;
+    self->task_running = 1;
+    spi_queue_set_active(self, true);
+    BaseType_t res;
+    #if CONFIG_MICROPY_USE_BOTH_CORES
+    res = xTaskCreate(spi_queue_task, "SPI_queue_task", 2048, (void *)self, CONFIG_MICROPY_TASK_PRIORITY, NULL);
+    #else
+    res = xTaskCreatePinnedToCore(spi_queue_task, "SPI_queue_task", 2048, (void *)self, CONFIG_MICROPY_TASK_PRIORITY, NULL, MainTaskCore);
+    #endif
+    if (res != pdPASS) {
+        self->task_running = 0;
+        spi_queue_set_active(self, false);
+        self->callback = mp_const_none;
+        mp_raise_msg(&mp_type_OSError, "error starting SPI queue task");
+    }
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(spi_queue_run_obj, 0, spi_queue_execute);
+
+//-----------------------------------------------
+STATIC mp_obj_t spi_queue_done(mp_obj_t self_in)
+{
+    machine_spi_queue_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    spi_queue_check(self, false);
+
+    if ((self->task_running) || (self->queue.state == SPI_QUEUE_RUNNING)) return mp_const_false;
+
+    spi_queue_finish_pending(self);
+    spi_queue_copy_rx(self);
+    return mp_const_true;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(spi_queue_done_obj, spi_queue_done);
+
+// Returns the tuple: (number of transactions, completed, last run result, last run duration in us)
+//-------------------------------------------------
+STATIC mp_obj_t spi_queue_status(mp_obj_t self_in)
+{
+    machine_spi_queue_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    spi_queue_check(self, false);
+
+    mp_obj_t tuple[4];
+    tuple[0] = mp_obj_new_int(self->queue.ndesc);
+    tuple[1] = mp_obj_new_int(self->queue.completed);
+    tuple[2] = mp_obj_new_int(self->queue.result);
+    tuple[3] = mp_obj_new_int_from_uint(self->queue.run_us);
+    return mp_obj_new_tuple(4, tuple);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(spi_queue_status_obj, spi_queue_status);
+
+//------------------------------------------------------------
+STATIC mp_obj_t spi_queue_result(mp_obj_t self_in, mp_obj_t idx_in)
+{
+    machine_spi_queue_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    spi_queue_check(self, true);
+
+    int idx = mp_obj_get_int(idx_in);
+    if ((idx < 0) || (idx >= self->queue.ndesc)) mp_raise_ValueError("transaction index out of range");
+    if (idx >= self->queue.completed) return mp_const_none;
+
+    uint32_t len;
+    uint8_t *rx = spi_queue_rx(&self->queue, idx, &len);
+    if (rx == NULL) return mp_obj_new_str_of_type(&mp_type_bytes, (byte *)"", 0);
+    return mp_obj_new_str_of_type(&mp_type_bytes, rx, len);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(spi_queue_result_obj, spi_queue_result);
+
+//------------------------------------------------
+STATIC mp_obj_t spi_queue_clear_trans(mp_obj_t self_in)
+{
+    machine_spi_queue_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    spi_queue_check(self, true);
+
+    spi_queue_clear(&self->queue);
+    self->rx_bufs = mp_obj_new_list(0, NULL);
+    self->finished = 0;
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(spi_queue_clear_obj, spi_queue_clear_trans);
+
+//-----------------------------------------------------
+STATIC void spi_queue_free(machine_spi_queue_obj_t *self)
+{
+    free(self->queue.desc);
+    free(self->queue.mem);
+    self->queue.desc = NULL;
+    self->queue.mem = NULL;
+    self->queue.ndesc = 0;
+    self->callback = mp_const_none;
+}
+
+//------------------------------------------------
+STATIC mp_obj_t spi_queue_deinit(mp_obj_t self_in)
+{
+    machine_spi_queue_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    if (self->queue.mem == NULL) return mp_const_none;
+
+    // the buffers are used by the background task until it finishes
+    while ((self->task_running) || (self->queue.state == SPI_QUEUE_RUNNING)) {
+        vTaskDelay(1);
+    }
+    // the result of the run is dropped, a scheduled finish function only releases the queue
+    if (self->finish_pending) {
+        self->finish_pending = 0;
+        spi_queue_set_active(self, false);
+    }
+    spi_queue_free(self);
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(spi_queue_deinit_obj, spi_queue_deinit);
+
+// The finaliser never waits: a queue running in background is in the list of
+// active queues, so it is not collected before its finish function runs
+//------------------------------------------------
+STATIC mp_obj_t spi_queue_del(mp_obj_t self_in)
+{
+    machine_spi_queue_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    if ((self->queue.mem != NULL) && (!self->task_running) && (self->queue.state != SPI_QUEUE_RUNNING)) {
+        spi_queue_free(self);
+    }
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(spi_queue_del_obj, spi_queue_del);
+
+//-----------------------------------------------------------------------------------------------
+STATIC void spi_queue_print(const mp_print_t *print, mp_obj_t self_in, mp_print_kind_t kind)
+{
+    machine_spi_queue_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    if (self->queue.mem == NULL) {
+        mp_printf(print, "SPIQueue( DEINITIALIZED )");
+        return;
+    }
+    mp_printf(print, "SPIQueue( transactions=%u/%u, data=%u/%u, state=%s, completed=%u, last run %u us )",
+            self->queue.ndesc, self->queue.max_desc, self->queue.mem_used, self->queue.mem_size,
+            (self->queue.state == SPI_QUEUE_RUNNING) ? "Running" : ((self->queue.state == SPI_QUEUE_DONE) ? "Done" : "Idle"),
+            self->queue.completed, self->queue.run_us);
+}
+
+//================================================================
+STATIC const mp_rom_map_elem_t spi_queue_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_add),				(mp_obj_t)&spi_queue_add_obj },
+    { MP_ROM_QSTR(MP_QSTR_run),				(mp_obj_t)&spi_queue_run_obj },
+    { MP_ROM_QSTR(MP_QSTR_done),			(mp_obj_t)&spi_queue_done_obj },
+    { MP_ROM_QSTR(MP_QSTR_status),			(mp_obj_t)&spi_queue_status_obj },
+    { MP_ROM_QSTR(MP_QSTR_result),			(mp_obj_t)&spi_queue_result_obj },
+    { MP_ROM_QSTR(MP_QSTR_clear),			(mp_obj_t)&spi_queue_clear_obj },
+    { MP_ROM_QSTR(MP_QSTR_deinit),			(mp_obj_t)&spi_queue_deinit_obj },
+    { MP_ROM_QSTR(MP_QSTR___del__),			(mp_obj_t)&spi_queue_del_obj },
+};
+STATIC MP_DEFINE_CONST_DICT(spi_queue_locals_dict, spi_queue_locals_dict_table);
+
+//=========================================
+const mp_obj_type_t machine_spi_queue_type = {
+    { &mp_type_type },
+    .name = MP_QSTR_SPIQueue,
+    .print = spi_queue_print,
+    .locals_dict = (mp_obj_dict_t *)&spi_queue_locals_dict,
+};
+
 //================================================================
 STATIC const mp_rom_map_elem_t machine_spi_locals_dict_table[] = {
     { MP_ROM_QSTR(MP_QSTR_init),			(mp_obj_t)&machine_hw_spi_init_obj },
@@ -492,6 +1095,8 @@ STATIC const mp_rom_map_elem_t machine_spi_locals_dict_table[] = {
     { MP_ROM_QSTR(MP_QSTR_write_readinto),	(mp_obj_t)&mp_machine_spi_write_readinto_obj },
     { MP_ROM_QSTR(MP_QSTR_select),			(mp_obj_t)&mp_machine_spi_select_obj },
     { MP_ROM_QSTR(MP_QSTR_deselect),		(mp_obj_t)&mp_machine_spi_deselect_obj },
+    { MP_ROM_QSTR(MP_QSTR_queue),			(mp_obj_t)&mp_machine_spi_queue_obj },
+    { MP_ROM_QSTR(MP_QSTR_stats),			(mp_obj_t)&mp_machine_spi_stats_obj },
 
     { MP_ROM_QSTR(MP_QSTR_MSB),				MP_ROM_INT(MICROPY_PY_MACHINE_SPI_MSB) },
     { MP_ROM_QSTR(MP_QSTR_LSB),				MP_ROM_INT(MICROPY_PY_MACHINE_SPI_LSB) },
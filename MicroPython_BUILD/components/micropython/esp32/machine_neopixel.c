@@ -35,6 +35,7 @@
 
 #include "libs/esp_rmt.h"
 #include "libs/neopixel.h"
+#include "libs/np_encode.h"
 
 #include "py/nlr.h"
 #include "py/runtime.h"
@@ -125,6 +126,7 @@ STATIC mp_obj_t machine_neopixel_make_new(const mp_obj_type_t *type, size_t n_ar
 
     // Set defaults
     self->px.brightness = 255;
+    self->px.gamma = 1.0;
     sprintf(self->px.color_order, "GRBW");
 
 	self->px.timings.mark.level0 = 1;
@@ -477,6 +479,141 @@ STATIC mp_obj_t machine_neopixel_brightness(size_t n_args, const mp_obj_t *pos_a
 }
 MP_DEFINE_CONST_FUN_OBJ_KW(machine_neopixel_brightness_obj, 0, machine_neopixel_brightness);
 
+//-----------------------------------------------------------------------------------------------
+STATIC mp_obj_t machine_neopixel_gamma(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args)
+{
+	const mp_arg_t allowed_args[] = {
+	    { MP_QSTR_gamma,   MP_ARG_OBJ,  {.u_obj = mp_const_none} },
+	    { MP_QSTR_update,  MP_ARG_BOOL, {.u_bool = true} },
+	};
+	machine_neopixel_obj_t *self = pos_args[0];
+    np_check(self);
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    if (args[0].u_obj != mp_const_none) {
+    	float gamma = mp_obj_get_float(args[0].u_obj);
+    	if ((gamma < 0.1) || (gamma > 5.0)) {
+        	mp_raise_ValueError("gamma out of range (0.1 ~ 5.0)");
+    	}
+    	self->px.gamma = gamma;
+    	if (args[1].u_bool) {
+    	   	MP_THREAD_GIL_EXIT();
+    		np_show(&self->px, self->channel);
+    	   	MP_THREAD_GIL_ENTER();
+    	}
+    }
+    return mp_obj_new_float(self->px.gamma);
+}
+MP_DEFINE_CONST_FUN_OBJ_KW(machine_neopixel_gamma_obj, 0, machine_neopixel_gamma);
+
+// Set the pixels starting at 'pos' from the list, tuple or array of RGB colors
+//---------------------------------------------------------------------------------------------------
+STATIC mp_obj_t machine_neopixel_set_range(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args)
+{
+	const mp_arg_t allowed_args[] = {
+	    { MP_QSTR_pos,     MP_ARG_REQUIRED | MP_ARG_INT,  {.u_int = 1} },
+	    { MP_QSTR_colors,  MP_ARG_REQUIRED | MP_ARG_OBJ,  {.u_obj = mp_const_none} },
+	    { MP_QSTR_update,                    MP_ARG_BOOL, {.u_bool = true} },
+	};
+	machine_neopixel_obj_t *self = pos_args[0];
+    np_check(self);
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    int pos = args[0].u_int;
+    if ((pos < 1) || (pos > self->px.pixel_count)) {
+    	mp_raise_ValueError("position out of range");
+    }
+
+    mp_buffer_info_t bufinfo;
+    if ((!MP_OBJ_IS_TYPE(args[1].u_obj, &mp_type_list)) && (!MP_OBJ_IS_TYPE(args[1].u_obj, &mp_type_tuple)) &&
+    		(mp_get_buffer(args[1].u_obj, &bufinfo, MP_BUFFER_READ))) {
+    	// array of 32-bit colors
+    	if ((bufinfo.typecode != 'I') && (bufinfo.typecode != 'L') && (bufinfo.typecode != 'i') && (bufinfo.typecode != 'l')) {
+        	mp_raise_ValueError("array of type 'I' or 'L' expected");
+    	}
+    	const uint32_t *colors = (const uint32_t *)bufinfo.buf;
+    	int cnt = bufinfo.len / 4;
+    	if ((cnt + pos - 1) > self->px.pixel_count) cnt = self->px.pixel_count - pos + 1;
+		for (int i = 0; i < cnt; i++) {
+			np_set_pixel_color(&self->px, i+pos-1, colors[i] << 8);
+		}
+    }
+    else {
+		size_t len;
+		mp_obj_t *items;
+		mp_obj_get_array(args[1].u_obj, &len, &items);
+    	int cnt = len;
+    	if ((cnt + pos - 1) > self->px.pixel_count) cnt = self->px.pixel_count - pos + 1;
+		for (int i = 0; i < cnt; i++) {
+			np_set_pixel_color(&self->px, i+pos-1, (uint32_t)mp_obj_get_int(items[i]) << 8);
+		}
+    }
+
+	if (args[2].u_bool) {
+	   	MP_THREAD_GIL_EXIT();
+		np_show(&self->px, self->channel);
+	   	MP_THREAD_GIL_ENTER();
+	}
+	return mp_const_none;
+}
+MP_DEFINE_CONST_FUN_OBJ_KW(machine_neopixel_set_range_obj, 3, machine_neopixel_set_range);
+
+// Set the pixels starting at 'pos' from the buffer containing R,G,B(,W) bytes for each pixel
+//---------------------------------------------------------------------------------------------------
+STATIC mp_obj_t machine_neopixel_fill_from(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args)
+{
+	const mp_arg_t allowed_args[] = {
+	    { MP_QSTR_buffer,  MP_ARG_REQUIRED | MP_ARG_OBJ,  {.u_obj = mp_const_none} },
+	    { MP_QSTR_pos,                       MP_ARG_INT,  {.u_int = 1} },
+	    { MP_QSTR_update,                    MP_ARG_BOOL, {.u_bool = true} },
+	};
+	machine_neopixel_obj_t *self = pos_args[0];
+    np_check(self);
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    int pos = args[1].u_int;
+    if ((pos < 1) || (pos > self->px.pixel_count)) {
+    	mp_raise_ValueError("position out of range");
+    }
+
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(args[0].u_obj, &bufinfo, MP_BUFFER_READ);
+
+    uint8_t bpp = self->px.nbits / 8;
+    uint8_t map[4];
+    if (np_order_map(self->px.color_order, bpp, map) < 0) {
+    	mp_raise_ValueError("Wrong color order string");
+    }
+	int cnt = bufinfo.len / bpp;
+	if ((cnt + pos - 1) > self->px.pixel_count) cnt = self->px.pixel_count - pos + 1;
+    np_reorder(self->px.pixels + ((pos-1) * bpp), (const uint8_t *)bufinfo.buf, cnt, bpp, map);
+
+	if (args[2].u_bool) {
+	   	MP_THREAD_GIL_EXIT();
+		np_show(&self->px, self->channel);
+	   	MP_THREAD_GIL_ENTER();
+	}
+	return mp_const_none;
+}
+MP_DEFINE_CONST_FUN_OBJ_KW(machine_neopixel_fill_from_obj, 2, machine_neopixel_fill_from);
+
+// Wait until the last shown frame is sent
+//-----------------------------------------------------
+STATIC mp_obj_t machine_neopixel_wait(mp_obj_t self_in)
+{
+    machine_neopixel_obj_t *self = self_in;
+    np_check(self);
+
+   	MP_THREAD_GIL_EXIT();
+	np_wait();
+   	MP_THREAD_GIL_ENTER();
+    return mp_const_none;
+}
+MP_DEFINE_CONST_FUN_OBJ_1(machine_neopixel_wait_obj, machine_neopixel_wait);
+
 //-----------------------------------------------------------------------------------------------------
 STATIC mp_obj_t machine_neopixel_HSBtoRGB(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
 
@@ -676,13 +813,13 @@ STATIC mp_obj_t machine_neopixel_rainbow(mp_obj_t self_in, mp_obj_t pos_in, mp_o
     uint32_t color;
     int pos = mp_obj_get_int(pos_in);
     int fact = mp_obj_get_int(fact_in);
-    float hue;
-    float dHue = 360.0 * fact / (float)self->px.pixel_count;
-    float bri = (float)self->px.brightness / 255.0;
+    int hue;
 
+    // integer HSV conversion, hue in 1536 steps
     for (int i=0; i<self->px.pixel_count; i++) {
-        hue = fmod((dHue * (pos+i)), 360.0);
-        color = hsb_to_rgb(hue, 1.0, bri) << 8;
+        hue = ((int64_t)1536 * fact * (pos+i) / self->px.pixel_count) % 1536;
+        if (hue < 0) hue += 1536;
+        color = np_hsv_to_rgb(hue, 255, self->px.brightness) << 8;
 		np_set_pixel_color(&self->px, i, color);
     }
    	MP_THREAD_GIL_EXIT();
@@ -727,6 +864,10 @@ STATIC const mp_rom_map_elem_t machine_neopixel_locals_dict_table[] = {
     { MP_ROM_QSTR(MP_QSTR_get),        (mp_obj_t)&machine_neopixel_get_obj },
     { MP_ROM_QSTR(MP_QSTR_show),       (mp_obj_t)&machine_neopixel_show_obj },
     { MP_ROM_QSTR(MP_QSTR_brightness), (mp_obj_t)&machine_neopixel_brightness_obj },
+    { MP_ROM_QSTR(MP_QSTR_gamma),      (mp_obj_t)&machine_neopixel_gamma_obj },
+    { MP_ROM_QSTR(MP_QSTR_set_range),  (mp_obj_t)&machine_neopixel_set_range_obj },
+    { MP_ROM_QSTR(MP_QSTR_fill_from),  (mp_obj_t)&machine_neopixel_fill_from_obj },
+    { MP_ROM_QSTR(MP_QSTR_wait),       (mp_obj_t)&machine_neopixel_wait_obj },
     { MP_ROM_QSTR(MP_QSTR_HSBtoRGB),   (mp_obj_t)&machine_neopixel_HSBtoRGB_obj },
     { MP_ROM_QSTR(MP_QSTR_HSBtoRGBint),(mp_obj_t)&machine_neopixel_HSBtoRGBint_obj },
     { MP_ROM_QSTR(MP_QSTR_RGBtoHSB),   (mp_obj_t)&machine_neopixel_RGBtoHSB_obj },
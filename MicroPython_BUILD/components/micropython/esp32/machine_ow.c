@@ -36,6 +36,7 @@
 #include "libs/ow/owb.h"
 #include "libs/ow/owb_rmt.h"
 #include "libs/ow/ds18b20.h"
+#include "libs/sensor_sched.h"
 
 #include "py/nlr.h"
 #include "py/runtime.h"
@@ -601,6 +602,71 @@ STATIC mp_obj_t machine_ds18x20_rom_code(mp_obj_t self_in) {
 STATIC MP_DEFINE_CONST_FUN_OBJ_1(machine_ds18x20_rom_code_obj, machine_ds18x20_rom_code);
 
 
+// ==== Sensor acquisition scheduler bus backend ====
+// The conversion is started on all devices by a single broadcast,
+// the raw temperature is read as 16-bit little endian value
+
+//------------------------------------------
+static int ow_sensor_broadcast(void *bus)
+{
+    onewire_obj_t *ow = (onewire_obj_t *)bus;
+    if (ow->owb == NULL) return -1;
+
+    for (int i=0; i<MAX_DEVICES; i++) {
+        if ((ow->used_by[i] != NULL) && (MP_OBJ_IS_TYPE((mp_obj_t)ow->used_by[i], &machine_ds18x20_type))) {
+            ds18x20_obj_t *ds_obj = ow->used_by[i];
+            if (ds_obj->info == NULL) continue;
+            ds18b20_convert_all(ds_obj->info);
+            conv_end_time = 0;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+//-------------------------------------------------------------------------------------------------------------------
+static int ow_sensor_xfer(void *bus, sensor_dev_t *dev, const uint8_t *wbuf, uint8_t wlen, uint8_t *rbuf, uint8_t rlen)
+{
+    ds18x20_obj_t *ds_obj = (ds18x20_obj_t *)dev->dev;
+    int16_t temper = 0;
+    if ((ds_obj->info == NULL) || (ds_obj->owb_obj->owb == NULL)) return -1;
+    if (rlen < 2) return 0;
+
+    if (!ds18b20_read_raw_temp_checked(ds_obj->info, &temper)) return -2;
+    rbuf[0] = temper & 0xFF;
+    rbuf[1] = (temper >> 8) & 0xFF;
+    return 0;
+}
+
+static const sensor_bus_ops_t ow_sensor_ops = {
+    .begin = NULL,
+    .xfer = ow_sensor_xfer,
+    .end = NULL,
+    .broadcast = ow_sensor_broadcast,
+};
+
+// Set the 1-wire bus backend for the scheduler device
+//----------------------------------------------------------------
+void machine_ds18x20_sensor_dev(mp_obj_t ds_in, sensor_dev_t *dev)
+{
+    if (!MP_OBJ_IS_TYPE(ds_in, &machine_ds18x20_type)) {
+        mp_raise_ValueError("DS18X20 object expected");
+    }
+    ds18x20_obj_t *self = MP_OBJ_TO_PTR(ds_in);
+    _check_ow_conversion(self);
+
+    dev->ops = &ow_sensor_ops;
+    dev->bus = self->owb_obj;
+    dev->dev = self;
+    dev->addr = self->device;
+    dev->flags |= SENSOR_FLAG_BROADCAST;
+    dev->start_len = 0;
+    dev->rcmd_len = 0;
+    dev->read_len = 2;
+    dev->wait_us = ((T_CONV >> (DS18B20_RESOLUTION_12_BIT - self->info->resolution)) + 2) * 1000;
+}
+
+
 //====================================================================
 STATIC const mp_rom_map_elem_t machine_ds18x20_locals_dict_table[] = {
 	{ MP_ROM_QSTR(MP_QSTR_read_temp),		(mp_obj_t)&machine_ds18x20_readtemp_obj },
@@ -0,0 +1,294 @@
+/*
+ * This file is part of the MicroPython ESP32 project, https://github.com/loboris/MicroPython_ESP32_psRAM_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Batched multi-device sensor acquisition
+ *
+ * The devices on I2C, SPI and 1-Wire buses are described by transaction templates,
+ * the acquisition cycle starts the conversions on all devices, waits only as long as
+ * needed and reads the results into the provided buffer.
+ * The scheduling is done in 'libs/sensor_sched.c', the bus backends are implemented
+ * in the bus modules (machine_hw_i2c.c, machine_hw_spi.c, machine_ow.c).
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "rom/ets_sys.h"
+
+#include "py/runtime.h"
+#include "py/objtuple.h"
+#include "py/mphal.h"
+#include "modmachine.h"
+#include "libs/sensor_sched.h"
+
+#define SENSORS_ALLOC_STEP  4
+
+typedef struct _machine_sensors_obj_t {
+    mp_obj_base_t base;
+    sensor_sched_t sched;
+} machine_sensors_obj_t;
+
+
+//--------------------------------
+static uint64_t _sensors_now_us(void)
+{
+    return mp_hal_ticks_us();
+}
+
+//---------------------------------------
+static void _sensors_delay_us(uint32_t us)
+{
+    if (us >= 1000) mp_hal_delay_ms(us / 1000);
+    if (us % 1000) ets_delay_us(us % 1000);
+}
+
+//------------------------------------------------------------------------------------------------
+STATIC void machine_sensors_print(const mp_print_t *print, mp_obj_t self_in, mp_print_kind_t kind)
+{
+    machine_sensors_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    mp_printf(print, "Sensors(devices=%u, size=%u, cycles=%u, errors=%u, last_time=%u us)",
+            self->sched.ndevs, self->sched.size, self->sched.cycles, self->sched.errors, self->sched.last_us);
+}
+
+//-------------------------------------------------------------------------------------------------------------------
+STATIC mp_obj_t machine_sensors_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *args)
+{
+    mp_arg_check_num(n_args, n_kw, 0, 0, false);
+
+    machine_sensors_obj_t *self = m_new_obj(machine_sensors_obj_t);
+    self->base.type = &machine_sensors_type;
+    sensor_dev_t *devs = m_new0(sensor_dev_t, SENSORS_ALLOC_STEP);
+    sensor_sched_init(&self->sched, devs, SENSORS_ALLOC_STEP, _sensors_now_us, _sensors_delay_us);
+
+    return MP_OBJ_FROM_PTR(self);
+}
+
+// Set the command from the bytes-like object
+//------------------------------------------------------------------------------
+static void _set_cmd(mp_obj_t cmd_in, uint8_t *cmd, uint8_t *cmd_len, const char *msg)
+{
+    *cmd_len = 0;
+    if (cmd_in == mp_const_none) return;
+
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(cmd_in, &bufinfo, MP_BUFFER_READ);
+    if (bufinfo.len > SENSOR_CMD_MAX) {
+        mp_raise_ValueError(msg);
+    }
+    memcpy(cmd, bufinfo.buf, bufinfo.len);
+    *cmd_len = bufinfo.len;
+}
+
+// Add the device to the scheduler, the devices array is expanded as needed
+// Returns the device's result offset
+//-------------------------------------------------------------------------
+static mp_obj_t _add_device(machine_sensors_obj_t *self, sensor_dev_t *dev)
+{
+    sensor_sched_t *s = &self->sched;
+    if (s->ndevs >= s->max) {
+        if (s->max > (0xFFFF - SENSORS_ALLOC_STEP)) {
+            mp_raise_ValueError("too many devices");
+        }
+        s->devs = m_renew(sensor_dev_t, s->devs, s->max, s->max + SENSORS_ALLOC_STEP);
+        s->max += SENSORS_ALLOC_STEP;
+    }
+    int offset = sensor_sched_add(s, dev);
+    if (offset < 0) {
+        mp_raise_ValueError("Error adding device");
+    }
+    return MP_OBJ_NEW_SMALL_INT(offset);
+}
+
+// Template arguments, common to all bus types
+enum { ARG_start, ARG_wait, ARG_reg, ARG_read };
+
+//-----------------------------------------------------------------
+static void _parse_template(sensor_dev_t *dev, mp_arg_val_t *args)
+{
+    _set_cmd(args[ARG_start].u_obj, dev->start, &dev->start_len, "start command too long");
+    _set_cmd(args[ARG_reg].u_obj, dev->rcmd, &dev->rcmd_len, "read command too long");
+    if ((args[ARG_wait].u_int < 0) || (args[ARG_read].u_int < 0) || (args[ARG_read].u_int > 255)) {
+        mp_raise_ValueError("wait or read length out of range");
+    }
+    dev->wait_us = args[ARG_wait].u_int;
+    dev->read_len = args[ARG_read].u_int;
+}
+
+//---------------------------------------------------------------------------------------------------
+STATIC mp_obj_t machine_sensors_add_i2c(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args)
+{
+    const mp_arg_t allowed_args[] = {
+            { MP_QSTR_i2c,      MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+            { MP_QSTR_addr,     MP_ARG_REQUIRED | MP_ARG_INT, {.u_int = 0} },
+            { MP_QSTR_start,    MP_ARG_KW_ONLY  | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+            { MP_QSTR_wait_us,  MP_ARG_KW_ONLY  | MP_ARG_INT, {.u_int = 0} },
+            { MP_QSTR_reg,      MP_ARG_KW_ONLY  | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+            { MP_QSTR_read,     MP_ARG_KW_ONLY  | MP_ARG_INT, {.u_int = 0} },
+    };
+    machine_sensors_obj_t *self = MP_OBJ_TO_PTR(pos_args[0]);
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args-1, pos_args+1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    sensor_dev_t dev;
+    memset(&dev, 0, sizeof(sensor_dev_t));
+    machine_hw_i2c_sensor_dev(args[0].u_obj, args[1].u_int, &dev);
+    _parse_template(&dev, args+2);
+    dev.obj = args[0].u_obj;
+
+    return _add_device(self, &dev);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(machine_sensors_add_i2c_obj, 3, machine_sensors_add_i2c);
+
+//---------------------------------------------------------------------------------------------------
+STATIC mp_obj_t machine_sensors_add_spi(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args)
+{
+    const mp_arg_t allowed_args[] = {
+            { MP_QSTR_spi,      MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+            { MP_QSTR_start,    MP_ARG_KW_ONLY  | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+            { MP_QSTR_wait_us,  MP_ARG_KW_ONLY  | MP_ARG_INT, {.u_int = 0} },
+            { MP_QSTR_reg,      MP_ARG_KW_ONLY  | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+            { MP_QSTR_read,     MP_ARG_KW_ONLY  | MP_ARG_INT, {.u_int = 0} },
+    };
+    machine_sensors_obj_t *self = MP_OBJ_TO_PTR(pos_args[0]);
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args-1, pos_args+1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    sensor_dev_t dev;
+    memset(&dev, 0, sizeof(sensor_dev_t));
+    machine_hw_spi_sensor_dev(args[0].u_obj, &dev);
+    _parse_template(&dev, args+1);
+    dev.obj = args[0].u_obj;
+
+    return _add_device(self, &dev);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(machine_sensors_add_spi_obj, 2, machine_sensors_add_spi);
+
+//--------------------------------------------------------------------------------
+STATIC mp_obj_t machine_sensors_add_ds18x20(mp_obj_t self_in, mp_obj_t ds_in)
+{
+    machine_sensors_obj_t *self = MP_OBJ_TO_PTR(self_in);
+
+    sensor_dev_t dev;
+    memset(&dev, 0, sizeof(sensor_dev_t));
+    machine_ds18x20_sensor_dev(ds_in, &dev);
+    dev.obj = ds_in;
+
+    return _add_device(self, &dev);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(machine_sensors_add_ds18x20_obj, machine_sensors_add_ds18x20);
+
+//------------------------------------------------------
+STATIC mp_obj_t machine_sensors_size(mp_obj_t self_in)
+{
+    machine_sensors_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    return MP_OBJ_NEW_SMALL_INT(self->sched.size);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(machine_sensors_size_obj, machine_sensors_size);
+
+//-------------------------------------------------------------------------
+STATIC mp_obj_t machine_sensors_acquire(mp_obj_t self_in, mp_obj_t buf_in)
+{
+    machine_sensors_obj_t *self = MP_OBJ_TO_PTR(self_in);
+
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(buf_in, &bufinfo, MP_BUFFER_WRITE);
+    if (bufinfo.len < self->sched.size) {
+        mp_raise_ValueError("buffer too small");
+    }
+
+    int failed = sensor_sched_run(&self->sched, (uint8_t *)bufinfo.buf);
+    return MP_OBJ_NEW_SMALL_INT(failed);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(machine_sensors_acquire_obj, machine_sensors_acquire);
+
+//--------------------------------------------------------
+STATIC mp_obj_t machine_sensors_status(mp_obj_t self_in)
+{
+    machine_sensors_obj_t *self = MP_OBJ_TO_PTR(self_in);
+
+    mp_obj_t tuple = mp_obj_new_tuple(self->sched.ndevs, NULL);
+    mp_obj_tuple_t *t = MP_OBJ_TO_PTR(tuple);
+    for (int i=0; i<self->sched.ndevs; i++) {
+        t->items[i] = MP_OBJ_NEW_SMALL_INT(self->sched.devs[i].status);
+    }
+    return tuple;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(machine_sensors_status_obj, machine_sensors_status);
+
+//-------------------------------------------------------
+STATIC mp_obj_t machine_sensors_stats(mp_obj_t self_in)
+{
+    machine_sensors_obj_t *self = MP_OBJ_TO_PTR(self_in);
+
+    mp_obj_t tuple[4];
+    tuple[0] = mp_obj_new_int_from_uint(self->sched.cycles);
+    tuple[1] = mp_obj_new_int_from_uint(self->sched.errors);
+    tuple[2] = mp_obj_new_int_from_uint(self->sched.batches);
+    tuple[3] = mp_obj_new_int_from_uint(self->sched.last_us);
+
+    return mp_obj_new_tuple(4, tuple);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(machine_sensors_stats_obj, machine_sensors_stats);
+
+//-------------------------------------------------------
+STATIC mp_obj_t machine_sensors_clear(mp_obj_t self_in)
+{
+    machine_sensors_obj_t *self = MP_OBJ_TO_PTR(self_in);
+
+    sensor_dev_t *devs = self->sched.devs;
+    uint16_t max = self->sched.max;
+    memset(devs, 0, max * sizeof(sensor_dev_t));
+    sensor_sched_init(&self->sched, devs, max, _sensors_now_us, _sensors_delay_us);
+
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(machine_sensors_clear_obj, machine_sensors_clear);
+
+
+//=================================================================
+STATIC const mp_rom_map_elem_t machine_sensors_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_add_i2c),         MP_ROM_PTR(&machine_sensors_add_i2c_obj) },
+    { MP_ROM_QSTR(MP_QSTR_add_spi),         MP_ROM_PTR(&machine_sensors_add_spi_obj) },
+    { MP_ROM_QSTR(MP_QSTR_add_ds18x20),     MP_ROM_PTR(&machine_sensors_add_ds18x20_obj) },
+    { MP_ROM_QSTR(MP_QSTR_size),            MP_ROM_PTR(&machine_sensors_size_obj) },
+    { MP_ROM_QSTR(MP_QSTR_acquire),         MP_ROM_PTR(&machine_sensors_acquire_obj) },
+    { MP_ROM_QSTR(MP_QSTR_status),          MP_ROM_PTR(&machine_sensors_status_obj) },
+    { MP_ROM_QSTR(MP_QSTR_stats),           MP_ROM_PTR(&machine_sensors_stats_obj) },
+    { MP_ROM_QSTR(MP_QSTR_clear),           MP_ROM_PTR(&machine_sensors_clear_obj) },
+};
+STATIC MP_DEFINE_CONST_DICT(machine_sensors_locals_dict, machine_sensors_locals_dict_table);
+
+//=========================================
+const mp_obj_type_t machine_sensors_type = {
+    { &mp_type_type },
+    .name = MP_QSTR_Sensors,
+    .print = machine_sensors_print,
+    .make_new = machine_sensors_make_new,
+    .locals_dict = (mp_obj_dict_t*)&machine_sensors_locals_dict,
+};
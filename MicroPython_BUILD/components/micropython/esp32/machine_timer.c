@@ -32,6 +32,7 @@
 
 #include "driver/timer.h"
 #include "py/runtime.h"
+#include "py/mphal.h"
 #include "modmachine.h"
 
 #define TIMER_INTR_SEL		TIMER_INTR_LEVEL
@@ -51,8 +52,31 @@
 #define TIMER_TYPE_MAX		5
 
 #define TIMER_EXT_NUM		8
+#define TIMER_EXT_ANY		0xFF	// id of the extended timers created with Timer(-1)
 #define TIMER_FLAGS			0
 
+#define TIMER_FIRED_DUE		1		// the callback has to be run
+#define TIMER_FIRED_QUEUED	2		// the timer is in the callback batch
+#define TIMER_WHEEL_TICK_US	1000
+
+// Extended timers are kept in a timer wheel advanced by the extended base timer interrupt every 1 ms.
+// The callbacks of all timers expired since the last run are executed by one scheduled function.
+typedef struct _machine_timer_wheel_t {
+    tw_wheel_t wheel;
+    machine_timer_obj_t *fired_head;	// timers with the callback pending, in expiry order
+    machine_timer_obj_t *fired_tail;
+    bool batch_scheduled;
+    uint64_t start_us;					// time at which the base timer was started
+    uint64_t tick_us;					// time at which the current tick was due
+    // statistics
+    uint32_t expired;					// timer expiries
+    uint32_t batches;					// scheduled callback batches
+    uint32_t callbacks;					// callbacks executed
+    uint32_t missed;					// expiries while the previous callback was still pending
+    uint32_t coalesced;					// expiries delayed to coalesce with other timers
+    int64_t late_sum;					// delay of the callbacks from the expiry time, us
+    int32_t late_max;
+} machine_timer_wheel_t;
 
 const mp_obj_type_t machine_timer_type;
 
@@ -74,7 +98,7 @@ STATIC void machine_timer_print(const mp_print_t *print, mp_obj_t self_in, mp_pr
 {
     machine_timer_obj_t *self = self_in;
 
-    mp_printf(print, "Timer(%d) ", self->id);
+    mp_printf(print, "Timer(%d) ", (self->id == TIMER_EXT_ANY) ? -1 : self->id);
 
     if (self->type >= TIMER_TYPE_MAX) {
         mp_printf(print, "Not initialized");
@@ -94,6 +118,7 @@ STATIC void machine_timer_print(const mp_print_t *print, mp_obj_t self_in, mp_pr
     }
     else if (self->type == TIMER_TYPE_EXT) {
     	mp_printf(print, "Period: %d ms; ", self->period);
+    	if (self->slack) mp_printf(print, "Slack: %d ms; ", self->slack);
     }
     else {
     	mp_printf(print, "Period: %d ms; ", self->period / 2);
@@ -113,6 +138,8 @@ STATIC void machine_timer_print(const mp_print_t *print, mp_obj_t self_in, mp_pr
     }
     if (self->type == TIMER_TYPE_EXTBASE) {
         machine_timer_obj_t *extmr;
+        machine_timer_wheel_t *tw = MP_STATE_PORT(machine_timer_wheel);
+        mp_printf(print, "  Running extended timers: %u\n", (tw) ? tw->wheel.count : 0);
         mp_printf(print, "  Handled extended timers:\n");
 		for (int i=0; i < TIMER_EXT_NUM; i++) {
 			extmr = ext_timers[i];
@@ -138,12 +165,19 @@ STATIC mp_obj_t machine_timer_make_new(const mp_obj_type_t *type, size_t n_args,
     self->debug_pin = -1;
 	self->state = TIMER_PAUSED;
 	self->type = TIMER_TYPE_MAX;
+    self->node.next = NULL;
+    self->node.pprev = NULL;
+    self->counter = 0;
+    self->alarm = 0;
+    self->slack = 0;
+    self->fired = 0;
+    self->fired_next = NULL;
 
     int tmr = mp_obj_get_int(args[0]);
-    if ((tmr < 0) || (tmr > 11)) {
-    	mp_raise_ValueError("Only base timers 0~3 and extended timers 4~11 can be used.");
+    if ((tmr < -1) || (tmr > 11)) {
+    	mp_raise_ValueError("Only base timers 0~3 and extended timers 4~11 or -1 can be used.");
     }
-    if (tmr < 4) {
+    if ((tmr != -1) && (tmr < 4)) {
     	// Base hardware timer
     	if ((tmr == ADC_TIMER_NUM) && (adc_timer_active)) {
         	mp_raise_ValueError("Timer used by ADC module.");
@@ -158,16 +192,76 @@ STATIC mp_obj_t machine_timer_make_new(const mp_obj_type_t *type, size_t n_args,
     	if ((mpy_timers_used[0] == NULL) || (mpy_timers_used[0]->type != TIMER_TYPE_EXTBASE)) {
 			mp_raise_ValueError("Timer 0 not configured as extended timer.");
     	}
-    	if (ext_timers[(tmr-4)] != NULL) {
-        	mp_raise_ValueError("Extended Timer already in use.");
+    	if (tmr == -1) {
+    		// Any number of anonymous extended timers can be created
+    		tmr = TIMER_EXT_ANY;
+    	}
+    	else {
+			if (ext_timers[(tmr-4)] != NULL) {
+				mp_raise_ValueError("Extended Timer already in use.");
+			}
+			ext_timers[(tmr-4)] = self;
     	}
-    	ext_timers[(tmr-4)] = self;
     }
     self->id = tmr;
 
     return self;
 }
 
+// Number of ticks after which the extended timer expires
+//---------------------------------------------------------------
+STATIC uint32_t machine_ext_timer_remaining(machine_timer_obj_t *self)
+{
+    machine_timer_wheel_t *tw = MP_STATE_PORT(machine_timer_wheel);
+
+    if ((tw == NULL) || (!tw_pending(&self->node))) return self->counter;
+    return (uint32_t)self->alarm - tw->wheel.now + 1;
+}
+
+// Add the extended timer to the wheel, to expire at its alarm tick
+// delayed by up to 'slack' ticks to share the tick with other timers
+//-----------------------------------------------------------------------------------------
+STATIC void machine_ext_timer_arm(machine_timer_wheel_t *tw, machine_timer_obj_t *self)
+{
+    uint32_t expires = tw_coalesce((uint32_t)self->alarm, self->slack);
+
+    if (expires != (uint32_t)self->alarm) tw->coalesced++;
+    tw_add(&tw->wheel, &self->node, expires);
+}
+
+// (Re)start the extended timer to expire after 'ticks' ms
+//------------------------------------------------------------------------------
+STATIC void machine_ext_timer_start(machine_timer_obj_t *self, uint32_t ticks)
+{
+    machine_timer_wheel_t *tw = MP_STATE_PORT(machine_timer_wheel);
+    if (tw == NULL) {
+		mp_raise_ValueError("Timer 0 not configured as extended timer.");
+    }
+
+    mp_uint_t atomic_state = MICROPY_BEGIN_ATOMIC_SECTION();
+    tw_del(&tw->wheel, &self->node);
+    self->fired &= ~TIMER_FIRED_DUE;
+    self->alarm = tw->wheel.now + ticks - 1;
+    machine_ext_timer_arm(tw, self);
+    self->state = TIMER_RUNNING;
+    MICROPY_END_ATOMIC_SECTION(atomic_state);
+}
+
+// Stop the extended timer and cancel its pending callback,
+// the remaining time is saved in 'counter'
+//-------------------------------------------------------------
+STATIC void machine_ext_timer_stop(machine_timer_obj_t *self)
+{
+    machine_timer_wheel_t *tw = MP_STATE_PORT(machine_timer_wheel);
+
+    mp_uint_t atomic_state = MICROPY_BEGIN_ATOMIC_SECTION();
+    self->counter = machine_ext_timer_remaining(self);
+    if (tw) tw_del(&tw->wheel, &self->node);
+    self->fired &= ~TIMER_FIRED_DUE;
+    self->state = TIMER_PAUSED;
+    MICROPY_END_ATOMIC_SECTION(atomic_state);
+}
+
 //----------------------------------------------------------
 STATIC void machine_timer_disable(machine_timer_obj_t *self)
 {
@@ -175,8 +269,12 @@ STATIC void machine_timer_disable(machine_timer_obj_t *self)
         timer_pause((self->id >> 1) & 1, self->id & 1);
         if (self->type != TIMER_TYPE_CHRONO) esp_intr_free(self->handle);
         mpy_timers_used[self->id] = NULL;
+        if (self->type == TIMER_TYPE_EXTBASE) MP_STATE_PORT(machine_timer_wheel) = NULL;
+    }
+    else if (self->id >= 4) {
+    	machine_ext_timer_stop(self);
+    	if (self->id != TIMER_EXT_ANY) ext_timers[(self->id-4)] = NULL;
     }
-    else ext_timers[(self->id-4)] = NULL;
     self->callback = NULL;
     self->handle = NULL;
     self->event_num = 0;
@@ -211,39 +309,111 @@ STATIC void machine_timer_isr(void *self_in)
     if ((self->callback) && (mp_sched_schedule(self->callback, self, NULL))) self->cb_num++;
 }
 
+// Run the callbacks of the expired extended timers, scheduled from the extended base timer interrupt
+//------------------------------------------------------
+STATIC mp_obj_t machine_ext_timer_run(mp_obj_t base_in)
+{
+    machine_timer_wheel_t *tw = MP_STATE_PORT(machine_timer_wheel);
+    machine_timer_obj_t *extmr;
+    mp_obj_t callback;
+    uint64_t fired_us;
+    uint8_t fired;
+    int32_t late;
+
+    while (tw) {
+        mp_uint_t atomic_state = MICROPY_BEGIN_ATOMIC_SECTION();
+        extmr = tw->fired_head;
+        if (extmr == NULL) {
+            // timers expiring from now on are handled by a new batch
+            tw->batch_scheduled = false;
+            MICROPY_END_ATOMIC_SECTION(atomic_state);
+            break;
+        }
+        tw->fired_head = extmr->fired_next;
+        if (tw->fired_head == NULL) tw->fired_tail = NULL;
+        extmr->fired_next = NULL;
+        fired = extmr->fired;
+        extmr->fired = 0;
+        callback = extmr->callback;
+        fired_us = extmr->fired_us;
+        MICROPY_END_ATOMIC_SECTION(atomic_state);
+
+        // the timer may have been stopped after it expired
+        if ((!(fired & TIMER_FIRED_DUE)) || (callback == NULL)) continue;
+
+        late = (int32_t)(mp_hal_ticks_us() - fired_us);
+        tw->late_sum += late;
+        if (late > tw->late_max) tw->late_max = late;
+        tw->callbacks++;
+        extmr->cb_num++;
+        mp_call_function_1_protected(callback, extmr);
+    }
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(machine_ext_timer_run_obj, machine_ext_timer_run);
+
+// Called from the interrupt for each expired extended timer
+//---------------------------------------------------------------
+STATIC void machine_ext_timer_expire(tw_node_t *node, void *arg)
+{
+    machine_timer_wheel_t *tw = (machine_timer_wheel_t *)arg;
+    machine_timer_obj_t *extmr = (machine_timer_obj_t *)((uint8_t *)node - offsetof(machine_timer_obj_t, node));
+    // ticks by which the expiry was delayed to coalesce it with other timers
+    uint32_t delay = (tw->wheel.now - 1) - (uint32_t)extmr->alarm;
+
+    extmr->event_num++;
+    tw->expired++;
+    if (extmr->repeat) {
+        // the next period starts at the exact expiry time, so the delays do not accumulate
+        extmr->alarm += extmr->period;
+        machine_ext_timer_arm(tw, extmr);
+    }
+    else {
+        extmr->counter = 0;
+        extmr->state = TIMER_PAUSED;
+    }
+
+    if (extmr->callback == NULL) return;
+    if (extmr->fired & TIMER_FIRED_DUE) {
+        // the previous callback was not executed yet
+        tw->missed++;
+        return;
+    }
+    extmr->fired |= TIMER_FIRED_DUE;
+    extmr->fired_us = tw->tick_us - (uint64_t)delay * TIMER_WHEEL_TICK_US;
+    if (!(extmr->fired & TIMER_FIRED_QUEUED)) {
+        extmr->fired |= TIMER_FIRED_QUEUED;
+        extmr->fired_next = NULL;
+        if (tw->fired_tail) tw->fired_tail->fired_next = extmr;
+        else tw->fired_head = extmr;
+        tw->fired_tail = extmr;
+    }
+}
+
 //----------------------------------------------
 STATIC void machine_ext_timer_isr(void *self_in)
 {
 	// extended timer interrupt is fired every 1 ms
     machine_timer_obj_t *self = (machine_timer_obj_t *)self_in;
-    machine_timer_obj_t *extmr;
+    machine_timer_wheel_t *tw = MP_STATE_PORT(machine_timer_wheel);
 
     TIMERG0.int_clr_timers.t0 = 1;
     TIMERG0.hw_timer[0].config.alarm_en = 1;
 
     self->event_num++;
-    // test extended timers
-    for (int i=0; i < TIMER_EXT_NUM; i++) {
-		extmr = ext_timers[i];
-    	if (extmr) {
-    		// Extended timer exists
-    		if (extmr->state == TIMER_RUNNING) {
-    			// Timer is running, increment extended timer's counter
-				extmr->counter++;
-				if ((extmr->counter % extmr->period) == 0) {
-					// Extended timer's period elapsed, increment events number
-				    extmr->event_num++;
-					if (extmr->counter == extmr->alarm) {
-						// Schedule the callback execution
-						if ((extmr->callback) && (mp_sched_schedule(extmr->callback, extmr, NULL))) {
-							extmr->cb_num++;
-							self->cb_num++;
-						}
-						if (extmr->repeat) extmr->counter = 0x00000000ULL;
-					}
-				}
-    		}
-    	}
+    if (tw == NULL) return;
+
+    tw->tick_us = tw->start_us + (self->event_num * TIMER_WHEEL_TICK_US);
+    tw_tick(&tw->wheel, machine_ext_timer_expire, tw);
+
+    if ((tw->fired_head) && (!tw->batch_scheduled)) {
+        // One scheduled function runs the callbacks of all expired timers,
+        // if the scheduler queue is full it is retried on the next tick
+        if (mp_sched_schedule((mp_obj_t)&machine_ext_timer_run_obj, self, NULL)) {
+            tw->batch_scheduled = true;
+            tw->batches++;
+            self->cb_num++;
+        }
     }
 }
 
@@ -251,7 +421,8 @@ STATIC void machine_ext_timer_isr(void *self_in)
 STATIC void machine_timer_enable(machine_timer_obj_t *self)
 {
 	if (self->id >= 4) {
-		ext_timers[(self->id-4)] = self;
+		if (self->id != TIMER_EXT_ANY) ext_timers[(self->id-4)] = self;
+		machine_ext_timer_start(self, self->period);
 		return;
 	}
 
@@ -285,7 +456,11 @@ STATIC void machine_timer_enable(machine_timer_obj_t *self)
 		check_esp_err(timer_enable_intr((self->id >> 1) & 1, self->id & 1));
 		// Register interrupt callback
 		if (self->type == TIMER_TYPE_EXTBASE) {
+			machine_timer_wheel_t *tw = m_new0(machine_timer_wheel_t, 1);
+			tw_init(&tw->wheel, 0);
+			MP_STATE_PORT(machine_timer_wheel) = tw;
 			check_esp_err(timer_isr_register((self->id >> 1) & 1, self->id & 1, machine_ext_timer_isr, (void*)self, TIMER_FLAGS, &self->handle));
+			tw->start_us = mp_hal_ticks_us();
 		}
 		else {
 			check_esp_err(timer_isr_register((self->id >> 1) & 1, self->id & 1, machine_timer_isr, (void*)self, TIMER_FLAGS, &self->handle));
@@ -304,8 +479,12 @@ STATIC mp_obj_t machine_timer_init_helper(machine_timer_obj_t *self, mp_uint_t n
         { MP_QSTR_callback,     MP_ARG_KW_ONLY | MP_ARG_OBJ, {.u_obj = mp_const_none} },
         { MP_QSTR_dbgpin,       MP_ARG_KW_ONLY | MP_ARG_INT, {.u_int = -1} },
         { MP_QSTR_dbgpinmode,   MP_ARG_KW_ONLY | MP_ARG_INT, {.u_int = -1} },
+        { MP_QSTR_slack,        MP_ARG_KW_ONLY | MP_ARG_INT, {.u_int = 0} },
     };
 
+    if ((self->type == TIMER_TYPE_EXTBASE) && (MP_STATE_PORT(machine_timer_wheel)) && (MP_STATE_PORT(machine_timer_wheel)->wheel.count)) {
+    	mp_raise_msg(&mp_type_OSError, "Can't reinit extended base timer, some timers running.");
+    }
     machine_timer_disable(self);
 
     mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
@@ -369,9 +548,10 @@ STATIC mp_obj_t machine_timer_init_helper(machine_timer_obj_t *self, mp_uint_t n
 		else self->period = args[0].u_int;
 		self->repeat = args[1].u_int & 1;
 		if (args[2].u_obj != mp_const_none) self->callback = args[2].u_obj;
-		self->counter = 0x00000000ULL;
-		self->alarm = self->period;
-		self->state = TIMER_RUNNING;
+		// the expiry can be delayed by up to 'slack' ms to run together with other timers
+		if (args[5].u_int < 0) self->slack = 0;
+		else if (args[5].u_int >= self->period) self->slack = self->period - 1;
+		else self->slack = args[5].u_int;
 
 		machine_timer_enable(self);
     }
@@ -392,10 +572,11 @@ STATIC mp_obj_t machine_timer_deinit(mp_obj_t self_in)
     machine_timer_obj_t *self = self_in;
     if ((self->id < 4) && (self->type == TIMER_TYPE_EXTBASE)) {
     	// Check if any extended timer exists
-    	uint8_t num_ext = 0;
+    	uint32_t num_ext = 0;
         for (int i=0; i < TIMER_EXT_NUM; i++) {
         	if (ext_timers[i] != NULL) num_ext++;
         }
+        if (MP_STATE_PORT(machine_timer_wheel)) num_ext += MP_STATE_PORT(machine_timer_wheel)->wheel.count;
         if (num_ext) {
         	mp_raise_msg(&mp_type_OSError, "Can't deinit extended base timer, some timers running.");
         }
@@ -421,8 +602,9 @@ STATIC mp_obj_t machine_timer_value(mp_obj_t self_in)
 		}
     }
     else {
-    	// Extended timer
-    	result = self->counter;  // value in ms
+    	// Extended timer, time elapsed in the current period
+    	uint32_t remaining = machine_ext_timer_remaining(self);
+    	result = (remaining < self->period) ? self->period - remaining : 0;  // value in ms
     }
     return mp_obj_new_int_from_ull(result);
 }
@@ -437,11 +619,7 @@ STATIC mp_obj_t machine_timer_pause(mp_obj_t self_in)
     	// Base hardware timer
         if (self->type == TIMER_TYPE_EXTBASE) {
         	// Check if any extended timer is running
-        	uint8_t num_ext = 0;
-            for (int i=0; i < TIMER_EXT_NUM; i++) {
-            	if ((ext_timers[i] != NULL) && (ext_timers[i]->state == TIMER_RUNNING))  num_ext++;
-            }
-            if (num_ext) {
+            if ((MP_STATE_PORT(machine_timer_wheel)) && (MP_STATE_PORT(machine_timer_wheel)->wheel.count)) {
             	mp_raise_msg(&mp_type_OSError, "Can't pause extended base timer, some timers running.");
             }
         }
@@ -450,7 +628,7 @@ STATIC mp_obj_t machine_timer_pause(mp_obj_t self_in)
 			self->state = TIMER_PAUSED;
 		}
     }
-    else self->state = TIMER_PAUSED;
+    else if (self->state == TIMER_RUNNING) machine_ext_timer_stop(self);
     return mp_const_none;
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_1(machine_timer_pause_obj, machine_timer_pause);
@@ -465,11 +643,17 @@ STATIC mp_obj_t machine_timer_resume(mp_obj_t self_in)
 		if (self->state == TIMER_PAUSED) {
 			check_esp_err(timer_start((self->id >> 1) & 1, self->id & 1));
 			self->state = TIMER_RUNNING;
+			if ((self->type == TIMER_TYPE_EXTBASE) && (MP_STATE_PORT(machine_timer_wheel))) {
+				// keep the expiry times used for the delay statistics in sync with the ticks
+				MP_STATE_PORT(machine_timer_wheel)->start_us = mp_hal_ticks_us() - (self->event_num * TIMER_WHEEL_TICK_US);
+			}
 		}
     }
-    else {
-		if ((mpy_timers_used[0] != NULL) && (mpy_timers_used[0]->state == TIMER_RUNNING)) self->state = TIMER_RUNNING;
-		else self->state = TIMER_PAUSED;
+    else if (self->state == TIMER_PAUSED) {
+		if ((mpy_timers_used[0] != NULL) && (mpy_timers_used[0]->state == TIMER_RUNNING)) {
+			// continue with the time remaining when the timer was paused
+			machine_ext_timer_start(self, (self->counter) ? self->counter : self->period);
+		}
     }
     return mp_const_none;
 }
@@ -498,6 +682,14 @@ STATIC mp_obj_t machine_timer_shot(size_t n_args, const mp_obj_t *args)
 {
     machine_timer_obj_t *self = args[0];
 
+    if ((self->type == TIMER_TYPE_EXT) && (!self->repeat)) {
+    	// Extended one shot timer, restart it
+        int tmo = self->period;
+        if (n_args > 1) tmo = mp_obj_get_int(args[1]);
+        if (tmo < 1) tmo = self->period;
+        machine_ext_timer_start(self, tmo);
+        return mp_const_none;
+    }
     if (self->type != TIMER_TYPE_ONESHOT) {
     	mp_raise_ValueError("Timer is not one_shot timer.");
     }
@@ -527,6 +719,7 @@ STATIC mp_obj_t machine_timer_id(mp_obj_t self_in)
 {
     machine_timer_obj_t *self = self_in;
 
+    if (self->id == TIMER_EXT_ANY) return MP_OBJ_NEW_SMALL_INT(-1);
     return MP_OBJ_NEW_SMALL_INT(self->id);
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_1(machine_timer_id_obj, machine_timer_id);
@@ -561,6 +754,16 @@ STATIC mp_obj_t machine_timer_period(size_t n_args, const mp_obj_t *args)
 
     if (n_args > 1) {
 		if (self->type == TIMER_TYPE_EXTBASE) return MP_OBJ_NEW_SMALL_INT(1);
+		if (self->type == TIMER_TYPE_EXT) {
+			// Set new period, restart the timer if running
+			period = mp_obj_get_int(args[1]);
+			if (period < 1) period = 1;
+			self->period = period;
+			if (self->slack >= period) self->slack = period - 1;
+			if (self->state == TIMER_RUNNING) machine_ext_timer_start(self, period);
+			else self->counter = period;
+			return MP_OBJ_NEW_SMALL_INT(period);
+		}
 
 		uint8_t old_state = self->state;
 		// Pause timer
@@ -578,11 +781,6 @@ STATIC mp_obj_t machine_timer_period(size_t n_args, const mp_obj_t *args)
 			if (period < 10) period = 1;
 			else period /= 10;
 		}
-		else if (self->type == TIMER_TYPE_EXT) {
-			if (period < 1) period = 1;
-			self->counter = 0x00000000ULL;
-			self->alarm = period;
-		}
 		else {
 			if (period < 1) period = 2;
 			else period *= 2;
@@ -620,6 +818,14 @@ STATIC mp_obj_t machine_timer_callback(size_t n_args, const mp_obj_t *args)
 
     if ((self->type == TIMER_TYPE_EXTBASE) || (self->type == TIMER_TYPE_CHRONO)) return mp_const_false;
 
+    if (self->type == TIMER_TYPE_EXT) {
+    	// Set new callback, restart the timer if running
+        if ((MP_OBJ_IS_FUN(args[1])) || (MP_OBJ_IS_METH(args[1]))) self->callback = args[1];
+        else self->callback = NULL;
+        if (self->state == TIMER_RUNNING) machine_ext_timer_start(self, self->period);
+        return mp_const_none;
+    }
+
     uint8_t old_state = self->state;
     // Pause timer
     if (self->id < 4) {
@@ -632,8 +838,6 @@ STATIC mp_obj_t machine_timer_callback(size_t n_args, const mp_obj_t *args)
 
     if ((MP_OBJ_IS_FUN(args[1])) || (MP_OBJ_IS_METH(args[1]))) {
 		// Set new callback
-		self->counter = 0x00000000ULL;
-		self->alarm = self->period;
 		self->callback = args[1];
     }
     else self->callback = NULL;
@@ -649,6 +853,48 @@ STATIC mp_obj_t machine_timer_callback(size_t n_args, const mp_obj_t *args)
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(machine_timer_callback_obj, 1, 2, machine_timer_callback);
 
+// Return the statistics of the extended timers as tuple:
+// (running, expired, batches, callbacks, missed, coalesced, avg_delay_us, max_delay_us)
+// the delay is the time from the expiry to the execution of the callback
+//----------------------------------------------------------------------
+STATIC mp_obj_t machine_timer_stats(size_t n_args, const mp_obj_t *args)
+{
+    machine_timer_obj_t *self = args[0];
+    machine_timer_wheel_t *tw = MP_STATE_PORT(machine_timer_wheel);
+
+    if ((self->type != TIMER_TYPE_EXTBASE) || (tw == NULL)) {
+    	mp_raise_ValueError("Timer is not extended base timer.");
+    }
+
+    bool reset = (n_args > 1) && (mp_obj_is_true(args[1]));
+
+    // copy the statistics consistently, objects are created outside of the atomic section
+    mp_uint_t atomic_state = MICROPY_BEGIN_ATOMIC_SECTION();
+    uint32_t stats[6] = {tw->wheel.count, tw->expired, tw->batches, tw->callbacks, tw->missed, tw->coalesced};
+    int64_t late_sum = tw->late_sum;
+    int32_t late_max = tw->late_max;
+    if (reset) {
+    	// reset statistics
+    	tw->expired = 0;
+    	tw->batches = 0;
+    	tw->callbacks = 0;
+    	tw->missed = 0;
+    	tw->coalesced = 0;
+    	tw->late_sum = 0;
+    	tw->late_max = 0;
+    }
+    MICROPY_END_ATOMIC_SECTION(atomic_state);
+
+    mp_obj_t tuple[8];
+    for (int i=0; i < 6; i++) {
+    	tuple[i] = mp_obj_new_int_from_uint(stats[i]);
+    }
+    tuple[6] = mp_obj_new_int((stats[3]) ? (mp_int_t)(late_sum / stats[3]) : 0);
+    tuple[7] = mp_obj_new_int(late_max);
+    return mp_obj_new_tuple(8, tuple);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(machine_timer_stats_obj, 1, 2, machine_timer_stats);
+
 //==============================================================
 STATIC const mp_map_elem_t machine_timer_locals_dict_table[] = {
     { MP_ROM_QSTR(MP_QSTR___del__),		(mp_obj_t)&machine_timer_deinit_obj },
@@ -665,6 +911,7 @@ STATIC const mp_map_elem_t machine_timer_locals_dict_table[] = {
     { MP_ROM_QSTR(MP_QSTR_period),		(mp_obj_t)&machine_timer_period_obj },
     { MP_ROM_QSTR(MP_QSTR_callback),	(mp_obj_t)&machine_timer_callback_obj },
     { MP_ROM_QSTR(MP_QSTR_isrunning),	(mp_obj_t)&machine_timer_isrunning_obj },
+    { MP_ROM_QSTR(MP_QSTR_stats),		(mp_obj_t)&machine_timer_stats_obj },
 
 	{ MP_ROM_QSTR(MP_QSTR_ONE_SHOT),	MP_ROM_INT(TIMER_TYPE_ONESHOT) },
     { MP_ROM_QSTR(MP_QSTR_PERIODIC),	MP_ROM_INT(TIMER_TYPE_PERIODIC) },
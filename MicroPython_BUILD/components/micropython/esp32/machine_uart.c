@@ -51,46 +51,17 @@ static TaskHandle_t task_id[2] = {NULL};
 static uart_ringbuf_t uart_buffer[2];
 static uart_ringbuf_t *uart_buf[2] = {NULL};
 
+// Allocate the MPy ring buffer, the size is rounded up to the power of 2
 //-----------------------------------------------------------
-static void uart_ringbuf_alloc(uint8_t uart_num, uint16_t sz)
+static void uart_ringbuf_alloc(uint8_t uart_num, uint32_t sz)
 {
-	uart_buffer[uart_num].buf = malloc(sz);
-	uart_buffer[uart_num].size = sz;
-	uart_buffer[uart_num].iget = 0;
-	uart_buffer[uart_num].iput = 0;
+	sz = uart_buf_size_pow2(sz);
+	uint8_t *buf = malloc(sz);
+	if (buf == NULL) return;
+	uart_buf_init(&uart_buffer[uart_num], buf, sz);
 	uart_buf[uart_num] = &uart_buffer[uart_num];
 }
 
-//--------------------------------------------------------------
-int uart_buf_get(uart_ringbuf_t *r, uint8_t *dest, uint16_t len)
-{
-    if (r->iget == r->iput) return -1; // input buffer empty
-
-    int res = 0;
-	for (int i=0; i<len; i++) {
-		dest[i] = r->buf[r->iget++];
-		res++;
-	    if (r->iget == r->iput) break;
-	}
-	// move the buffer and adjust the pointers
-	memmove(r->buf, r->buf+res, r->iput - res);
-	r->iget -= res;
-	r->iput -= res;
-
-    return res;
-}
-
-//----------------------------------------------------------------
-int uart_buf_put(uart_ringbuf_t *r, uint8_t *source, uint16_t len)
-{
-	int res = 0;
-	for (int i=0; i<len; i++) {
-	    if (r->iput >= r->size) return 1; // overflow
-	    r->buf[r->iput++] = source[i];
-	}
-	return res;
-}
-
 //-------------------------------------------------------------------------------------
 int match_pattern(uint8_t *text, int text_length, uint8_t *pattern, int pattern_length)
 {
@@ -131,10 +102,13 @@ static void _sched_callback(mp_obj_t function, int uart, int type, int iarglen,
 static void uart_event_task(void *pvParameters)
 {
 	machine_uart_obj_t *self = (machine_uart_obj_t *)pvParameters;
+	uart_ringbuf_t *rbuf = uart_buf[self->uart_num];
     uart_event_t event;
     size_t datasize;
     int res;
-    uint8_t* dtmp = (uint8_t*) malloc(UART_BUFF_SIZE);
+    bool overflow;
+    // Temporary buffer for callback data and discarded bytes
+    uint8_t* dtmp = (uint8_t*) malloc(rbuf->size);
 
     for(;;) {
     	if (self->end_task) break;
@@ -144,41 +118,53 @@ static void uart_event_task(void *pvParameters)
     	}
         //Waiting for UART event.
         if (xQueueReceive(UART_QUEUE[self->uart_num], (void * )&event, 1000 / portTICK_PERIOD_MS)) {
-        	if (uart_mutex) xSemaphoreTake(uart_mutex, 200 / portTICK_PERIOD_MS);
-            bzero(dtmp, UART_BUFF_SIZE);
             switch(event.type) {
                 //Event of UART receiving data
                 case UART_DATA:
-                	// move UART data to MPy buffer
+                	// move UART data directly into the MPy ring buffer,
+                	// the buffer is only written here, no locking is needed
                     uart_get_buffered_data_len(self->uart_num+1, &datasize);
-                    if (datasize > 0) {
-                    	// read data from UART buffer
-						if (uart_read_bytes(self->uart_num+1, dtmp, datasize, 0) > 0) {
-							res = uart_buf_put(uart_buf[self->uart_num], dtmp, datasize);
-							if (res) {
-								// MPy buffer full
-								if (self->error_cb) {
-									_sched_callback(self->error_cb, self->uart_num+1, UART_CB_TYPE_ERROR, UART_BUFFER_FULL, NULL);
-								}
-							}
-							else {
-								if ((self->data_cb) && (self->data_cb_size > 0) && (uart_buf[self->uart_num]->iput >= self->data_cb_size)) {
-									// ** callback on data length received
-									uart_buf_get(uart_buf[self->uart_num], dtmp, self->data_cb_size);
-									_sched_callback(self->data_cb, self->uart_num+1, UART_CB_TYPE_DATA, self->data_cb_size, dtmp);
-								}
-								else if (self->pattern_cb) {
-									// ** callback on pattern received
-									res = match_pattern(uart_buf[self->uart_num]->buf, uart_buf[self->uart_num]->iput, self->pattern, self->pattern_len);
-									if (res >= 0) {
-										// found, pull data, including pattern from buffer
-										uart_buf_get(uart_buf[self->uart_num], dtmp, res+self->pattern_len);
-										_sched_callback(self->pattern_cb, self->uart_num+1, UART_CB_TYPE_PATTERN, res, dtmp);
-									}
-								}
+                    overflow = false;
+                    while (datasize > 0) {
+                    	uint32_t space;
+                    	uint8_t *dest = uart_buf_put_ptr(rbuf, &space);
+                    	if (space == 0) {
+                    		// MPy buffer full, discard the received data
+                    		dest = dtmp;
+                    		space = rbuf->size;
+                    		overflow = true;
+                    	}
+                    	if (space > datasize) space = datasize;
+						res = uart_read_bytes(self->uart_num+1, dest, space, 0);
+						if (res <= 0) break;
+						if (dest == dtmp) uart_buf_put_dropped(rbuf, res);
+						else uart_buf_put_commit(rbuf, res);
+						datasize -= res;
+                    }
+					if (overflow) {
+						if (self->error_cb) {
+							_sched_callback(self->error_cb, self->uart_num+1, UART_CB_TYPE_ERROR, UART_BUFFER_FULL, NULL);
+						}
+					}
+					else if ((self->data_cb) || (self->pattern_cb)) {
+						// The callbacks consume the data, lock against the readers
+			        	if (uart_mutex) xSemaphoreTake(uart_mutex, 200 / portTICK_PERIOD_MS);
+						if ((self->data_cb) && (self->data_cb_size > 0) && (uart_buf_count(rbuf) >= self->data_cb_size)) {
+							// ** callback on data length received
+							uart_buf_get(rbuf, dtmp, self->data_cb_size);
+							_sched_callback(self->data_cb, self->uart_num+1, UART_CB_TYPE_DATA, self->data_cb_size, dtmp);
+						}
+						else if (self->pattern_cb) {
+							// ** callback on pattern received
+							res = uart_buf_find(rbuf, self->pattern, self->pattern_len);
+							if (res >= 0) {
+								// found, pull data, including pattern from buffer
+								uart_buf_get(rbuf, dtmp, res+self->pattern_len);
+								_sched_callback(self->pattern_cb, self->uart_num+1, UART_CB_TYPE_PATTERN, res, dtmp);
 							}
 						}
-                    }
+			        	if (uart_mutex) xSemaphoreGive(uart_mutex);
+					}
                     break;
                 //Event of HW FIFO overflow detected
                 case UART_FIFO_OVF:
@@ -224,8 +210,6 @@ static void uart_event_task(void *pvParameters)
                     //ESP_LOGI(TAG, "uart event type: %d", event.type);
                     break;
             }
-
-        	if (uart_mutex) xSemaphoreGive(uart_mutex);
         }
     }
     free(dtmp);
@@ -234,143 +218,104 @@ static void uart_event_task(void *pvParameters)
     vTaskDelete(NULL);
 }
 
-//-----------------------------------------------------------------------------
-char *_uart_read(uart_port_t uart_num, int timeout, char *lnend, char *lnstart)
+// Pull the line ending with 'lnend' from the buffer.
+// If 'lnstart' is given, the returned string starts with it,
+// the lines not containing 'lnstart' are discarded.
+// Must be called with uart_mutex taken.
+//---------------------------------------------------------------------------------------------
+static char *_uart_get_line(uart_ringbuf_t *rbuf, char *lnend, char *lnstart, bool *nomem)
 {
     char *rdstr = NULL;
-    int rdlen = -1;
-    int minlen = strlen(lnend);
-    if (lnstart) minlen += strlen(lnstart);
+    int lnend_len = strlen(lnend);
 
-	if (timeout == 0) {
-		if (uart_mutex) {
-			if (xSemaphoreTake(uart_mutex, 200 / portTICK_PERIOD_MS) != pdTRUE) {
-				return NULL;
-			}
-		}
-    	// check for minimal length
-		if (uart_buf[uart_num]->iput < minlen) {
-	    	if (uart_mutex) xSemaphoreGive(uart_mutex);
-	    	return NULL;
-		}
-		while (1) {
-			rdlen = match_pattern(uart_buf[uart_num]->buf, uart_buf[uart_num]->iput, (uint8_t *)lnend, strlen(lnend));
-			if (rdlen >= 0) {
-				// found, pull data, including pattern from buffer
-				rdlen += 2;
-				rdstr = calloc(rdlen+1, 1);
-				if (rdstr) {
-					uart_buf_get(uart_buf[uart_num], (uint8_t *)rdstr, rdlen);
-					rdstr[rdlen] = 0;
-					if (lnstart) {
-						// Match beginning string
-						char *start_ptr = strstr(rdstr, lnstart);
-						if (start_ptr) {
-							if (start_ptr != rdstr) {
-								char *new_rdstr = strdup(start_ptr);
-								free(rdstr);
-								rdstr = new_rdstr;
-							}
-							break;
-						}
-						else {
-							free(rdstr);
-							rdstr = NULL;
-							rdlen = -1;
-							break;
-						}
-					}
-					else break;
-				}
-				else {
-					rdlen = -1;
-					break;
-				}
-			}
-			else break;
+	while (rdstr == NULL) {
+		int rdlen = uart_buf_find(rbuf, (uint8_t *)lnend, lnend_len);
+		if (rdlen < 0) break;
+
+		// found, pull data, including pattern from buffer
+		rdlen += lnend_len;
+		rdstr = malloc(rdlen+1);
+		if (rdstr == NULL) {
+			*nomem = true;
+			break;
 		}
-    	if (uart_mutex) xSemaphoreGive(uart_mutex);
-    	if (rdlen < 0) return NULL;
-    }
-    else {
-    	// wait until lnend received or timeout
-    	int wait = timeout;
-        int buflen = 0;
-    	mp_hal_set_wdt_tmo();
-		while (wait > 0) {
-			if (uart_mutex) {
-				if (xSemaphoreTake(uart_mutex, 200 / portTICK_PERIOD_MS) != pdTRUE) {
-					vTaskDelay(10 / portTICK_PERIOD_MS);
-					wait -= 10;
-					mp_hal_reset_wdt();
-					continue;
-				}
-			}
-			if (buflen < uart_buf[uart_num]->iput) {
-				// ** new data received, reset timeout
-				buflen = uart_buf[uart_num]->iput;
-				wait = timeout;
+		uart_buf_get(rbuf, (uint8_t *)rdstr, rdlen);
+		rdstr[rdlen] = 0;
+		if (lnstart) {
+			// * Find beginning of the sentence
+			char *start_ptr = strstr(rdstr, lnstart);
+			if (start_ptr == NULL) {
+				// not the requested line, discard it and check the next one
+				free(rdstr);
+				rdstr = NULL;
 			}
-			if (uart_buf[uart_num]->iput < minlen) {
-				// ** too few characters received
-		    	if (uart_mutex) xSemaphoreGive(uart_mutex);
-	    		vTaskDelay(10 / portTICK_PERIOD_MS);
-				wait -= 10;
-				mp_hal_reset_wdt();
-				continue;
+			else if (start_ptr != rdstr) {
+				memmove(rdstr, start_ptr, strlen(start_ptr)+1);
 			}
+		}
+	}
+	return rdstr;
+}
 
-			while (1) {
-				// * Check if lineend pattern is received
-				rdlen = match_pattern(uart_buf[uart_num]->buf, uart_buf[uart_num]->iput, (uint8_t *)lnend, strlen(lnend));
-				if (rdlen >= 0) {
-					rdlen += 2;
-					// * found, pull data, including pattern from buffer
-					rdstr = calloc(rdlen+1, 1);
-					if (rdstr) {
-						uart_buf_get(uart_buf[uart_num], (uint8_t *)rdstr, rdlen);
-						rdstr[rdlen] = 0;
-						if (lnstart) {
-							// * Find beginning of the sentence
-							char *start_ptr = strstr(rdstr, lnstart);
-							if (start_ptr) {
-								// === received string ending with lnend and starting with lnstart
-								if (start_ptr != rdstr) {
-									char *new_rdstr = strdup(start_ptr);
-									free(rdstr);
-									rdstr = new_rdstr;
-								}
-								break;
-							}
-							else {
-								free(rdstr);
-								rdstr = NULL;
-								break;
-							}
-						}
-						else break;	// === received string ending with lineend
-					}
-					else {
-						// error allocating buffer, finish
-						wait = 0;
-						break;
-					}
-				}
-				else break;
+//-----------------------------------------------------------------------------
+char *_uart_read(uart_port_t uart_num, int timeout, char *lnend, char *lnstart)
+{
+    char *rdstr = NULL;
+    uart_ringbuf_t *rbuf = uart_buf[uart_num];
+    uint32_t minlen = strlen(lnend);
+    if (lnstart) minlen += strlen(lnstart);
+
+	// wait until lnend received or timeout
+	int wait = timeout;
+	uint32_t rxcount = rbuf->received;
+	if (timeout > 0) mp_hal_set_wdt_tmo();
+	while (1) {
+		if (uart_buf_count(rbuf) >= minlen) {
+			if ((uart_mutex == NULL) || (xSemaphoreTake(uart_mutex, 200 / portTICK_PERIOD_MS) == pdTRUE)) {
+				bool nomem = false;
+				rdstr = _uart_get_line(rbuf, lnend, lnstart, &nomem);
+				if (uart_mutex) xSemaphoreGive(uart_mutex);
+				// received string ending with lnend (and starting with lnstart) or error allocating buffer
+				if ((rdstr) || (nomem)) break;
 			}
-	    	if (uart_mutex) xSemaphoreGive(uart_mutex);
-
-	    	if (rdstr) break;
-	    	if (wait > 0) {
-				vTaskDelay(10 / portTICK_PERIOD_MS);
-				wait -= 10;
-				mp_hal_reset_wdt();
-	    	}
 		}
-    }
+		if (wait <= 0) break;
+		if (rbuf->received != rxcount) {
+			// ** new data received, reset timeout
+			rxcount = rbuf->received;
+			wait = timeout;
+		}
+		vTaskDelay(10 / portTICK_PERIOD_MS);
+		wait -= 10;
+		mp_hal_reset_wdt();
+	}
 	return rdstr;
 }
 
+// Read the available bytes into the caller's buffer,
+// wait up to 'timeout' ms for the data to arrive.
+// Returns the number of bytes read.
+//--------------------------------------------------------------------------
+int _uart_read_bytes(uart_port_t uart_num, uint8_t *buf, int len, int timeout)
+{
+    uart_ringbuf_t *rbuf = uart_buf[uart_num];
+	int wait = timeout;
+
+	while ((uart_buf_count(rbuf) == 0) && (wait > 0)) {
+		vTaskDelay(10 / portTICK_PERIOD_MS);
+		wait -= 10;
+	}
+	if (uart_buf_count(rbuf) == 0) return 0;
+
+	if (uart_mutex) {
+		if (xSemaphoreTake(uart_mutex, 200 / portTICK_PERIOD_MS) != pdTRUE) return 0;
+	}
+	int res = uart_buf_get(rbuf, buf, len);
+	if (uart_mutex) xSemaphoreGive(uart_mutex);
+
+	return (res < 0) ? 0 : res;
+}
+
 
 /******************************************************************************/
 // MicroPython bindings for UART
@@ -678,7 +623,6 @@ STATIC mp_obj_t machine_uart_make_new(const mp_obj_type_t *type, size_t n_args,
     int bufsize = kargs[ARG_buffer_size].u_int;
     if (bufsize < 512) bufsize = 512;
     if (bufsize > 8192) bufsize = 8192;
-    self->buffer_size = bufsize;
 
 	if (uart_buf[self->uart_num] == NULL) {
 		// First time, create ring buffer
@@ -687,6 +631,7 @@ STATIC mp_obj_t machine_uart_make_new(const mp_obj_type_t *type, size_t n_args,
 	        nlr_raise(mp_obj_new_exception_msg_varg(&mp_type_ValueError, "UART(%d) Error allocating ring buffer", uart_num));
 		}
 	}
+    self->buffer_size = uart_buf[self->uart_num]->size;
 
 	// Remove any existing configuration
     uart_driver_delete(uart_num);
@@ -748,14 +693,15 @@ STATIC mp_obj_t machine_uart_deinit(mp_obj_t self_in) {
     		vTaskDelay(100 / portTICK_PERIOD_MS);
     		tmo--;
 		}
-		if (tmo) {
+		if (tmo == 0) {
 			mp_raise_ValueError("Cannot stop UART task!");
 		}
 		// delete uart driver
-		uart_driver_delete(self->uart_num);
+		uart_driver_delete(self->uart_num+1);
 		// free the uart buffer
-		if (uart_buf[self->uart_num] == NULL) {
+		if (uart_buf[self->uart_num] != NULL) {
 			if (uart_buf[self->uart_num]->buf) free(uart_buf[self->uart_num]->buf);
+			uart_buf[self->uart_num] = NULL;
 		}
     }
 
@@ -769,9 +715,7 @@ STATIC mp_obj_t machine_uart_any(mp_obj_t self_in) {
 
     _check_uart(self);
 
-	if (uart_mutex) xSemaphoreTake(uart_mutex, 200 / portTICK_PERIOD_MS);
-	int res = uart_buf[self->uart_num]->iput;
-	if (uart_mutex) xSemaphoreGive(uart_mutex);
+	int res = uart_buf_count(uart_buf[self->uart_num]);
 
     return MP_OBJ_NEW_SMALL_INT(res);
 }
@@ -785,14 +729,30 @@ STATIC mp_obj_t machine_uart_flush(mp_obj_t self_in) {
 
 	if (uart_mutex) xSemaphoreTake(uart_mutex, 200 / portTICK_PERIOD_MS);
 	uart_flush_input(self->uart_num+1);
-	uart_buf[self->uart_num]->iput = 0;
-	uart_buf[self->uart_num]->iget = 0;
+	uart_buf_flush(uart_buf[self->uart_num]);
 	if (uart_mutex) xSemaphoreGive(uart_mutex);
 
 	return mp_const_none;
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_1(machine_uart_flush_obj, machine_uart_flush);
 
+// Returns the receive statistics tuple: (received, dropped, overflows)
+//-----------------------------------------------------
+STATIC mp_obj_t machine_uart_stats(mp_obj_t self_in) {
+    machine_uart_obj_t *self = MP_OBJ_TO_PTR(self_in);
+
+    _check_uart(self);
+
+    uart_ringbuf_t *rbuf = uart_buf[self->uart_num];
+    mp_obj_t tuple[3];
+    tuple[0] = mp_obj_new_int_from_uint(rbuf->received);
+    tuple[1] = mp_obj_new_int_from_uint(rbuf->dropped);
+    tuple[2] = mp_obj_new_int_from_uint(rbuf->overflows);
+
+    return mp_obj_new_tuple(3, tuple);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(machine_uart_stats_obj, machine_uart_stats);
+
 //-----------------------------------------------------------------
 mp_obj_t machine_uart_readln(size_t n_args, const mp_obj_t *args) {
     machine_uart_obj_t *self = MP_OBJ_TO_PTR(args[0]);
@@ -955,6 +915,7 @@ STATIC const mp_rom_map_elem_t machine_uart_locals_dict_table[] = {
     { MP_ROM_QSTR(MP_QSTR_write_break),		MP_ROM_PTR(&machine_uart_write_break_obj) },
     { MP_ROM_QSTR(MP_QSTR_readln),			MP_ROM_PTR(&machine_uart_readln_obj) },
     { MP_ROM_QSTR(MP_QSTR_flush),			MP_ROM_PTR(&machine_uart_flush_obj) },
+    { MP_ROM_QSTR(MP_QSTR_stats),			MP_ROM_PTR(&machine_uart_stats_obj) },
     { MP_ROM_QSTR(MP_QSTR_callback),		MP_ROM_PTR(&machine_uart_callback_obj) },
 
 	// class constants
@@ -985,50 +946,30 @@ STATIC mp_uint_t machine_uart_read(mp_obj_t self_in, void *buf_in, mp_uint_t siz
     // make sure we want at least 1 char
     if (size == 0) return 0;
 
-    int bytes_read = 0;
-    if (self->timeout == 0) {
-    	// just return the buffer content
-		if (uart_mutex) {
-			if (xSemaphoreTake(uart_mutex, 200 / portTICK_PERIOD_MS) != pdTRUE) {
-				return 0;
-			}
-		}
-    	bytes_read = uart_buf_get(uart_buf[self->uart_num], (uint8_t *)buf_in, size);
-    	if (uart_mutex) xSemaphoreGive(uart_mutex);
-    	if (bytes_read < 0) bytes_read = 0;
-    }
-    else {
-    	// wait until data received or timeout
+    uart_ringbuf_t *rbuf = uart_buf[self->uart_num];
+    uint32_t wait_size = (size < rbuf->size) ? size : rbuf->size;
+    if ((self->timeout > 0) && (uart_buf_count(rbuf) < wait_size)) {
+    	// wait until requested data received or timeout
     	mp_hal_set_wdt_tmo();
 		int wait = self->timeout;
 		MP_THREAD_GIL_EXIT();
-		while (wait > 0) {
-			if (uart_mutex) {
-				if (xSemaphoreTake(uart_mutex, 200 / portTICK_PERIOD_MS) != pdTRUE) {
-		    		vTaskDelay(2 / portTICK_PERIOD_MS);
-					wait -= 2;
-					mp_hal_reset_wdt();
-					continue;
-				}
-			}
-			if (uart_buf[self->uart_num]->iput < size) {
-		    	if (uart_mutex) xSemaphoreGive(uart_mutex);
-	    		vTaskDelay(2 / portTICK_PERIOD_MS);
-				wait -= 2;
-				mp_hal_reset_wdt();
-				continue;
-			}
-	    	bytes_read = uart_buf_get(uart_buf[self->uart_num], (uint8_t *)buf_in, size);
-	    	if (uart_mutex) xSemaphoreGive(uart_mutex);
-			break;
+		while ((wait > 0) && (uart_buf_count(rbuf) < wait_size)) {
+    		vTaskDelay(2 / portTICK_PERIOD_MS);
+			wait -= 2;
+			mp_hal_reset_wdt();
 		}
 		MP_THREAD_GIL_ENTER();
     }
 
-    if (bytes_read < 0) {
-        *errcode = MP_EAGAIN;
-        return MP_STREAM_ERROR;
-    }
+    // copy the available data directly into the caller's buffer
+	if (uart_mutex) {
+		if (xSemaphoreTake(uart_mutex, 200 / portTICK_PERIOD_MS) != pdTRUE) {
+			return 0;
+		}
+	}
+	int bytes_read = uart_buf_get(rbuf, (uint8_t *)buf_in, size);
+	if (uart_mutex) xSemaphoreGive(uart_mutex);
+	if (bytes_read < 0) bytes_read = 0;
 
     return bytes_read;
 }
@@ -1067,9 +1008,7 @@ STATIC mp_uint_t machine_uart_ioctl(mp_obj_t self_in, mp_uint_t request, mp_uint
         mp_uint_t flags = arg;
         ret = 0;
         size_t rxbufsize;
-    	if (uart_mutex) xSemaphoreTake(uart_mutex, 200 / portTICK_PERIOD_MS);
-        rxbufsize = uart_buf[self->uart_num]->iput;
-    	if (uart_mutex) xSemaphoreGive(uart_mutex);
+        rxbufsize = uart_buf_count(uart_buf[self->uart_num]);
 
         if ((flags & MP_STREAM_POLL_RD) && rxbufsize > 0) {
             ret |= MP_STREAM_POLL_RD;
@@ -3,6 +3,7 @@
 
 #include "driver/uart.h"
 #include "py/runtime.h"
+#include "libs/uart_ringbuf.h"
 
 #define UART_CB_TYPE_DATA		1
 #define UART_CB_TYPE_PATTERN	2
@@ -32,17 +33,9 @@ typedef struct _machine_uart_obj_t {
     uint8_t lineend[3];
 } machine_uart_obj_t;
 
-typedef struct _uart_ringbuf_t {
-    uint8_t *buf;
-    uint16_t size;
-    uint16_t iget;
-    uint16_t iput;
-} uart_ringbuf_t;
-
 
 char *_uart_read(uart_port_t uart_num, int timeout, char *lnend, char *lnstart);
+int _uart_read_bytes(uart_port_t uart_num, uint8_t *buf, int len, int timeout);
 int match_pattern(uint8_t *text, int text_length, uint8_t *pattern, int pattern_length);
-int uart_buf_get(uart_ringbuf_t *r, uint8_t *dest, uint16_t len);
-int uart_buf_put(uart_ringbuf_t *r, uint8_t *source, uint16_t len);
 
 #endif
@@ -48,6 +48,7 @@
 #include "py/repl.h"
 #include "py/gc.h"
 #include "py/mphal.h"
+#include "py/boottrace.h"
 #include "extmod/vfs.h"
 #include "extmod/vfs_native.h"
 #include "lib/mp-readline/readline.h"
@@ -82,6 +83,10 @@ static StackType_t *mp_task_stack;
 static StackType_t *mp_task_stack_end;
 static int mp_task_stack_len = 4096;
 static uint8_t *mp_task_heap = NULL;
+#if MICROPY_GC_MULTI_HEAP
+static uint8_t *mp_task_fast_heap = NULL;
+static int mp_fast_heap_size = 0;
+#endif
 
 //STATIC StackType_t mp_task_stack[MP_TASK_STACK_LEN] __attribute__((aligned (8)));
 
@@ -92,6 +97,10 @@ void mp_task(void *pvParameter)
 {
     volatile uint32_t sp = (uint32_t)get_sp();
     //mp_task_stack_len -= ((uint32_t)mp_task_stack_end - sp);
+    #if MICROPY_BOOT_TRACE
+    mp_boot_trace_span_t trace_span;
+    mp_boot_trace_mark(MP_QSTR_mp_task);
+    #endif
 
 	#ifdef CONFIG_MICROPY_USE_TASK_WDT
 	// Enable watchdog for MicroPython main task
@@ -124,8 +133,18 @@ void mp_task(void *pvParameter)
     mp_stack_set_top((void *)sp);
     mp_stack_set_limit(mp_task_stack_len - 1024);
 
+    #if MICROPY_BOOT_TRACE
+    mp_boot_trace_begin(&trace_span);
+    #endif
     // Initialize the MicroPython heap
     gc_init(mp_task_heap, mp_task_heap + mpy_heap_size);
+    #if MICROPY_GC_MULTI_HEAP
+    if (mp_task_fast_heap != NULL) {
+        // SPIRAM is accessed through the cache, relative access cost is set for the statistics
+        gc_set_area(0, 0, 4);
+        gc_add_area(mp_task_fast_heap, mp_task_fast_heap + mp_fast_heap_size, GC_AREA_FAST, 1);
+    }
+    #endif
 
     // Initialize MicroPython environment
     mp_init();
@@ -135,25 +154,52 @@ void mp_task(void *pvParameter)
     mp_obj_list_init(mp_sys_argv, 0);
 
     readline_init0();
+    // the SPI queues running in background belonged to the previous heap
+    MP_STATE_PORT(spi_queue_active) = NULL;
+    #if MICROPY_BOOT_TRACE
+    mp_boot_trace_end(&trace_span, MP_BOOT_TRACE_INIT, MP_QSTR_mp_init);
+    mp_boot_trace_begin(&trace_span);
+    #endif
 
 	// Initialize peripherals
     machine_pins_init();
+    #if MICROPY_BOOT_TRACE
+    mp_boot_trace_end(&trace_span, MP_BOOT_TRACE_INIT, MP_QSTR_machine_pins_init);
+    #endif
 
     ESP_LOGI("MicroPython", "[=== MicroPython FreeRTOS task started (sp=%08x) ===]\n", sp);
 
     // === Mount internal flash file system ===
+    #if MICROPY_BOOT_TRACE
+    mp_boot_trace_begin(&trace_span);
+    #endif
     int res = mount_vfs(VFS_NATIVE_TYPE_SPIFLASH, VFS_NATIVE_INTERNAL_MP);
+    #if MICROPY_BOOT_TRACE
+    mp_boot_trace_end(&trace_span, MP_BOOT_TRACE_INIT, MP_QSTR_mount_vfs);
+    #endif
 
     if (res == 0) {
     	// run boot-up script 'boot.py'
+        #if MICROPY_BOOT_TRACE
+        mp_boot_trace_begin(&trace_span);
+        #endif
         pyexec_file("boot.py");
+        #if MICROPY_BOOT_TRACE
+        mp_boot_trace_end(&trace_span, MP_BOOT_TRACE_SCRIPT, MP_QSTR_boot_dot_py);
+        #endif
         if (pyexec_mode_kind == PYEXEC_MODE_FRIENDLY_REPL) {
         	// Check if 'main.py' exists and run it
         	FILE *fd;
         	fd = fopen(VFS_NATIVE_MOUNT_POINT"/main.py", "rb");
             if (fd) {
             	fclose(fd);
+                #if MICROPY_BOOT_TRACE
+                mp_boot_trace_begin(&trace_span);
+                #endif
             	pyexec_file("main.py");
+                #if MICROPY_BOOT_TRACE
+                mp_boot_trace_end(&trace_span, MP_BOOT_TRACE_SCRIPT, MP_QSTR_main_dot_py);
+                #endif
             }
         }
     }
@@ -211,6 +257,9 @@ void mp_task(void *pvParameter)
             #else
             printf("     uPY heap: %u/%u/%u bytes (in SPIRAM using malloc)\n\n", info.total, info.used, info.free);
             #endif
+            #if MICROPY_GC_MULTI_HEAP
+            if (mp_task_fast_heap != NULL) printf("uPY fast heap: %d bytes in internal RAM\n\n", mp_fast_heap_size);
+            #endif
         }
         else {
             // ## USING DRAM FOR HEAP ##
@@ -218,6 +267,12 @@ void mp_task(void *pvParameter)
         }
     }
 
+    #if MICROPY_BOOT_TRACE
+    // boot is done, keep the trace for micropython.boottrace()
+    mp_boot_trace_mark(MP_QSTR_repl);
+    mp_boot_trace_enable(false);
+    #endif
+
 	// === Main loop ==================================
 	MP_THREAD_GIL_EXIT();
 
@@ -408,6 +463,18 @@ void micropython_entry(void)
     	ESP_LOGE("MicroPython", "Error allocating heap, HALTED.");
         return;
     }
+
+    #if MICROPY_GC_MULTI_HEAP
+    // ## Fast heap area in internal RAM for small objects ##
+    if ((mpy_use_spiram) && (CONFIG_MICROPY_FAST_HEAP_SIZE > 0)) {
+        mp_fast_heap_size = CONFIG_MICROPY_FAST_HEAP_SIZE * 1024;
+        mp_task_fast_heap = heap_caps_malloc(mp_fast_heap_size, MALLOC_CAP_8BIT | MALLOC_CAP_INTERNAL);
+        if (mp_task_fast_heap == NULL) {
+            ESP_LOGW("MicroPython", "Error allocating fast heap, using SPIRAM heap only");
+        }
+        else ESP_LOGD("MicroPython", "MPy fast heap: %p - %p", mp_task_fast_heap, mp_task_fast_heap+mp_fast_heap_size);
+    }
+    #endif
 	ESP_LOGD("MicroPython", "MPy heap: %p - %p", mp_task_heap, mp_task_heap+mpy_heap_size+64);
 
     // Workaround for possible bug in i2c driver !?
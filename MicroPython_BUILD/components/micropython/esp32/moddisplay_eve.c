@@ -74,6 +74,7 @@ typedef struct _display_eve_obj_t {
     uint16_t width;
     uint16_t height;
     uint8_t in_list;
+    void *recording;            // DList object the commands are recorded to
 } display_eve_obj_t;
 
 typedef struct _eve_font_metrics_t {
@@ -138,6 +139,12 @@ typedef struct _list_eve_obj_t {
     uint8_t loaded;
 } list_eve_obj_t;
 
+typedef struct _dlist_eve_obj_t {
+    mp_obj_base_t base;
+    eve_dlist_t dlist;
+    list_eve_obj_t *cached[EVE_DLIST_MAX_SEGMENTS]; // RAM_G lists of the cached segments
+} dlist_eve_obj_t;
+
 typedef struct _ramg_objects_t {
     uint16_t count;
     uint16_t size;
@@ -148,6 +155,7 @@ const mp_obj_type_t display_eve_type;
 const mp_obj_type_t font_eve_type;
 const mp_obj_type_t image_eve_type;
 const mp_obj_type_t list_eve_type;
+const mp_obj_type_t dlist_eve_type;
 const mp_obj_type_t console_eve_type;
 const mp_obj_type_t tft_eve_type;
 
@@ -158,6 +166,8 @@ static uint16_t eve_cmd_start_addr = 0;
 static int16_t loaded_lists = 0;
 static int16_t loaded_images = 0;
 static int16_t loaded_fonts = 0;
+static const uint32_t eve_dl_start[1] = {CMD_DLSTART};
+static const uint32_t eve_dl_end[2] = {DL_DISPLAY, CMD_SWAP};
 
 extern uint8_t disp_used_spi_host;
 
@@ -884,12 +894,97 @@ STATIC mp_obj_t EVE_rotate(mp_obj_t self_in, mp_obj_t rot_in)
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_2(EVE_rotate_obj, EVE_rotate);
 
+// Copy the display list generated by the co-processor to RAM_G
+// Returns the new LIST object or NULL if the copy failed
+//----------------------------------------------
+static list_eve_obj_t *_copy_dl_to_ramg()
+{
+    uint32_t list_size = FT8_memRead32(REG_CMD_DL) & 0x1FFF;
+    if (!check_ramg(list_size)) {
+        mp_raise_ValueError("No place to append list");
+    }
+    FT8_cmd_memcpy(ft8_ramg_ptr, FT8_RAM_DL, list_size);
+    if (!FT8_cmd_execute(250)) return NULL;
+
+    // Create LIST instance object
+    list_eve_obj_t *list_obj = m_new_obj(list_eve_obj_t);
+    memset(list_obj, 0, sizeof(list_eve_obj_t));
+    list_obj->base.type = &list_eve_type;
+
+    list_obj->addr = ft8_ramg_ptr;
+    list_obj->size = list_size;
+    list_obj->loaded = 1;
+
+    if (!add_ramg_object((void *)list_obj)) {
+        mp_raise_ValueError("Error adding ramg object");
+    }
+    ft8_ramg_ptr += list_size;
+    loaded_lists++;
+
+    return list_obj;
+}
+
+// Free the list from RAM_G and move the following RAM_G objects
+//---------------------------------------------
+static bool _free_list(list_eve_obj_t *list)
+{
+    if (list->loaded == 0) return true;
+
+    FT8_cmd_memcpy(list->addr, list->addr + list->size, ft8_ramg_ptr - (list->addr+list->size));
+    bool res = FT8_cmd_execute(250);
+    ft8_ramg_ptr -= list->size;
+    loaded_lists--;
+    list->loaded = 0;
+
+    adjust_ramg_objects((void *)list, list->addr, list->size);
+    return res;
+}
+
+// Free RAM_G lists of the DList cached segments
+//-------------------------------------------------
+static void _dlist_free_cached(dlist_eve_obj_t *dl)
+{
+    for (int i=0; i<EVE_DLIST_MAX_SEGMENTS; i++) {
+        if (dl->cached[i]) _free_list(dl->cached[i]);
+        dl->cached[i] = NULL;
+    }
+}
+
+// Update CMD_APPEND of the cached segments, the lists could be moved in RAM_G
+//--------------------------------------------------
+static void _dlist_check_cached(dlist_eve_obj_t *dl)
+{
+    for (int i=0; i<dl->dlist.nseg; i++) {
+        if (dl->dlist.seg[i].cached == 0) continue;
+        list_eve_obj_t *list = dl->cached[i];
+        if ((list == NULL) || (list->loaded == 0)) {
+            mp_raise_ValueError("Cached segment list freed");
+        }
+        eve_dlist_cache(&dl->dlist, i, list->addr, list->size);
+    }
+}
+
 // Start creating display list
-// --------------------------------------------
-STATIC mp_obj_t EVE_startlist(mp_obj_t self_in)
+// If the DList object is given, the commands are recorded to it instead of sent to EVE
+// --------------------------------------------------------------
+STATIC mp_obj_t EVE_startlist(size_t n_args, const mp_obj_t *args)
 {
-    display_eve_obj_t *self = self_in;
+    display_eve_obj_t *self = args[0];
     _check_inlist(self, 0);
+
+    if (n_args > 1) {
+        if (mp_obj_get_type(args[1]) != &dlist_eve_type) {
+            mp_raise_ValueError("DList object expected");
+        }
+        dlist_eve_obj_t *dl = (dlist_eve_obj_t *)args[1];
+        _dlist_free_cached(dl);
+        eve_dlist_clear(&dl->dlist);
+        self->recording = dl;
+        FT8_record_start(&dl->dlist);
+        self->in_list = 1;
+        return mp_const_none;
+    }
+
     FT8_CP_reset();
     FT8_memWrite32(REG_CMD_DL, 0);
 
@@ -901,14 +996,26 @@ STATIC mp_obj_t EVE_startlist(mp_obj_t self_in)
 
     return mp_const_none;
 }
-STATIC MP_DEFINE_CONST_FUN_OBJ_1(EVE_startlist_obj, EVE_startlist);
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(EVE_startlist_obj, 1, 2, EVE_startlist);
 
 // End display list, make it active and show on display
+// If recording, only stop recording
 // -----------------------------------------
 STATIC mp_obj_t EVE_endlist(mp_obj_t self_in)
 {
     display_eve_obj_t *self = self_in;
     _check_inlist(self, 1);
+    if (self->recording) {
+        dlist_eve_obj_t *dl = (dlist_eve_obj_t *)self->recording;
+        FT8_record_stop();
+        eve_dlist_mark(&dl->dlist, -1); // close the last segment
+        self->recording = NULL;
+        self->in_list = 0;
+        if (dl->dlist.overflow) {
+            mp_raise_ValueError("DList buffer full");
+        }
+        return mp_const_true;
+    }
     FT8_cmd_dl(DL_DISPLAY); // End the display list. FT81X will ignore all the commands following this command.
     FT8_cmd_dl(CMD_SWAP);   // make this list active
 
@@ -928,35 +1035,17 @@ STATIC mp_obj_t EVE_savelist(mp_obj_t self_in)
 {
     display_eve_obj_t *self = self_in;
     _check_inlist(self, 1);
+    if (self->recording) {
+        mp_raise_ValueError("Not available while recording");
+    }
     // Execute current list
     FT8_end_cmd_burst(); // stop writing to the cmd-fifo
     bool res = FT8_cmd_execute(250);
     self->in_list = 0;
     if (!res) return mp_const_false;
 
-    // Copy to static list
-    uint32_t list_size = FT8_memRead32(REG_CMD_DL) & 0x1FFF;
-    if (!check_ramg(list_size)) {
-        mp_raise_ValueError("No place to append list");
-    }
-    FT8_cmd_memcpy(ft8_ramg_ptr, FT8_RAM_DL, list_size);
-    res = FT8_cmd_execute(250);
-    if (!res) return mp_const_false;
-
-    // Create LIST instance object
-    list_eve_obj_t *list_obj = m_new_obj(list_eve_obj_t);
-    memset(list_obj, 0, sizeof(list_eve_obj_t));
-    list_obj->base.type = &list_eve_type;
-
-    list_obj->addr = ft8_ramg_ptr;
-    list_obj->size = list_size;
-    list_obj->loaded = 1;
-
-    if (!add_ramg_object((void *)list_obj)) {
-        mp_raise_ValueError("Error adding ramg object");
-    }
-    ft8_ramg_ptr += list_size;
-    loaded_lists++;
+    list_eve_obj_t *list_obj = _copy_dl_to_ramg();
+    if (list_obj == NULL) return mp_const_false;
 
     return MP_OBJ_FROM_PTR(list_obj);
 }
@@ -983,6 +1072,29 @@ STATIC mp_obj_t EVE_appendlist(mp_obj_t self_in, mp_obj_t list_in)
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_2(EVE_appendlist_obj, EVE_appendlist);
 
+// Send the recorded DList to EVE, make it active and show on display
+// The whole list is written to the cmd-fifo using burst SPI transfers
+// ---------------------------------------------------------------
+STATIC mp_obj_t EVE_showlist(mp_obj_t self_in, mp_obj_t dlist_in)
+{
+    display_eve_obj_t *self = self_in;
+    _check_inlist(self, 0);
+    if (mp_obj_get_type(dlist_in) != &dlist_eve_type) {
+        mp_raise_ValueError("DList object expected");
+    }
+    dlist_eve_obj_t *dl = (dlist_eve_obj_t *)dlist_in;
+    _dlist_check_cached(dl);
+
+    bool res = FT8_cmd_write_buffer((const uint8_t *)eve_dl_start, sizeof(eve_dl_start), 250);
+    if (res) res = FT8_cmd_write_buffer(dl->dlist.buf, dl->dlist.len, 250);
+    if (res) res = FT8_cmd_write_buffer((const uint8_t *)eve_dl_end, sizeof(eve_dl_end), 250);
+    if (res) res = FT8_cmd_execute(250);
+
+    if (res) return mp_const_true;
+    return mp_const_false;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(EVE_showlist_obj, EVE_showlist);
+
 // -----------------------------------------------------------
 STATIC mp_obj_t EVE_clear(size_t n_args, const mp_obj_t *args)
 {
@@ -3337,18 +3449,9 @@ STATIC mp_obj_t LIST_eve_make_new(const mp_obj_type_t *type, size_t n_args, size
 STATIC mp_obj_t LIST_EVE_free(mp_obj_t self_in)
 {
     _check_inlist(eve_obj, 0);
-    image_eve_obj_t *self = (image_eve_obj_t *)self_in;
-    if (self->loaded == 0) return mp_const_true;
-
-    FT8_cmd_memcpy(self->addr, self->addr + self->size, ft8_ramg_ptr - (self->addr+self->size));
-    bool res = FT8_cmd_execute(250);
-    ft8_ramg_ptr -= self->size;
-    loaded_lists--;
-    self->loaded = 0;
-
-    adjust_ramg_objects((void *)self, self->addr, self->size);
+    list_eve_obj_t *self = (list_eve_obj_t *)self_in;
 
-    if (res) return mp_const_true;
+    if (_free_list(self)) return mp_const_true;
     return mp_const_false;
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_1(LIST_EVE_free_obj, LIST_EVE_free);
@@ -3398,6 +3501,251 @@ const mp_obj_type_t list_eve_type = {
 // ^^^^ IMAGE object end ^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^
 
 
+// ==== DList object ===========================================
+
+//------------------------------------------------------------------------------------------------
+STATIC void dlist_eve_printinfo(const mp_print_t *print, mp_obj_t self_in, mp_print_kind_t kind)
+{
+    dlist_eve_obj_t *self = self_in;
+    mp_printf(print, "DList(size=%u, used=%u, segments=%u)", self->dlist.size, self->dlist.len, self->dlist.nseg);
+    for (int i=0; i<self->dlist.nseg; i++) {
+        eve_dlist_seg_t *seg = &self->dlist.seg[i];
+        mp_printf(print, "\n    %2d: id=%d, offset=%u, size=%u%s", i, seg->id, seg->start, seg->len, (seg->cached) ? ", cached" : "");
+    }
+}
+
+// constructor
+//-----------------------------------------------------------------------------------------------------------------
+STATIC mp_obj_t DLIST_eve_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *all_args)
+{
+    enum { ARG_size };
+    const mp_arg_t allowed_args[] = {
+        { MP_QSTR_size, MP_ARG_INT, { .u_int = FT8_CMDFIFO_SIZE } },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all_kw_array(n_args, n_kw, all_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    int size = args[ARG_size].u_int;
+    if ((size < 64) || (size > (64*1024))) {
+        mp_raise_ValueError("DList size must be 64 ~ 65536");
+    }
+
+    dlist_eve_obj_t *self = m_new_obj(dlist_eve_obj_t);
+    memset(self, 0, sizeof(dlist_eve_obj_t));
+    self->base.type = &dlist_eve_type;
+    // allocated on MicroPython heap, referenced from the object
+    eve_dlist_init(&self->dlist, m_new(uint8_t, size), size);
+
+    return MP_OBJ_FROM_PTR(self);
+}
+
+//-------------------------------------------------------------
+static int _dlist_get_segment(dlist_eve_obj_t *self, mp_obj_t id_in)
+{
+    int idx = eve_dlist_find(&self->dlist, mp_obj_get_int(id_in));
+    if (idx < 0) {
+        mp_raise_ValueError("Segment not found");
+    }
+    if ((eve_obj) && (eve_obj->recording == self)) {
+        mp_raise_ValueError("DList is recording");
+    }
+    return idx;
+}
+
+// Start the new segment at the current recording position
+// -------------------------------------------------------------
+STATIC mp_obj_t DLIST_EVE_mark(mp_obj_t self_in, mp_obj_t id_in)
+{
+    dlist_eve_obj_t *self = (dlist_eve_obj_t *)self_in;
+    if ((eve_obj == NULL) || (eve_obj->recording != self)) {
+        mp_raise_ValueError("DList is not recording");
+    }
+    int id = mp_obj_get_int(id_in);
+    if (id < 0) {
+        mp_raise_ValueError("Segment id must be >= 0");
+    }
+    if (eve_dlist_mark(&self->dlist, id) < 0) {
+        mp_raise_ValueError("Segment id already used or too many segments");
+    }
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(DLIST_EVE_mark_obj, DLIST_EVE_mark);
+
+// Execute the segment commands and cache the generated display list in RAM_G
+// The segment is replaced with CMD_APPEND of the cached list.
+// Only the display list output is cached, the segment should not change the co-processor state
+// used by the rest of the list (colors, fonts, ...)
+// --------------------------------------------------------------
+STATIC mp_obj_t DLIST_EVE_cache(mp_obj_t self_in, mp_obj_t id_in)
+{
+    dlist_eve_obj_t *self = (dlist_eve_obj_t *)self_in;
+    int idx = _dlist_get_segment(self, id_in);
+    _check_inlist(eve_obj, 0);
+
+    eve_dlist_seg_t *seg = &self->dlist.seg[idx];
+    if (seg->cached) return mp_const_true;
+
+    FT8_CP_reset();
+    FT8_memWrite32(REG_CMD_DL, 0);
+    bool res = FT8_cmd_write_buffer((const uint8_t *)eve_dl_start, sizeof(eve_dl_start), 250);
+    if (res) res = FT8_cmd_write_buffer(self->dlist.buf + seg->start, seg->len, 250);
+    if (res) res = FT8_cmd_execute(250);
+    if (!res) return mp_const_false;
+
+    list_eve_obj_t *list = _copy_dl_to_ramg();
+    if (list == NULL) return mp_const_false;
+
+    if (eve_dlist_cache(&self->dlist, idx, list->addr, list->size) < 0) {
+        _free_list(list);
+        mp_raise_ValueError("DList buffer full");
+    }
+    self->cached[idx] = list;
+
+    return mp_const_true;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(DLIST_EVE_cache_obj, DLIST_EVE_cache);
+
+// Replace the segment content with the content of another DList or buffer
+// --------------------------------------------------------------------------------
+STATIC mp_obj_t DLIST_EVE_update(mp_obj_t self_in, mp_obj_t id_in, mp_obj_t src_in)
+{
+    dlist_eve_obj_t *self = (dlist_eve_obj_t *)self_in;
+    int idx = _dlist_get_segment(self, id_in);
+
+    const uint8_t *data;
+    uint32_t len;
+    if (mp_obj_get_type(src_in) == &dlist_eve_type) {
+        dlist_eve_obj_t *src = (dlist_eve_obj_t *)src_in;
+        if ((src == self) || (eve_obj && (eve_obj->recording == src))) {
+            mp_raise_ValueError("Invalid source DList");
+        }
+        data = src->dlist.buf;
+        len = src->dlist.len;
+    }
+    else {
+        mp_buffer_info_t bufinfo;
+        mp_get_buffer_raise(src_in, &bufinfo, MP_BUFFER_READ);
+        data = bufinfo.buf;
+        len = bufinfo.len;
+        if (eve_dlist_count(data, len) < 0) {
+            mp_raise_ValueError("Invalid command stream");
+        }
+    }
+
+    list_eve_obj_t *list = self->cached[idx];
+    if (list) _check_inlist(eve_obj, 0);
+
+    if (eve_dlist_replace(&self->dlist, idx, data, len) < 0) {
+        mp_raise_ValueError("DList buffer full");
+    }
+    if (list) {
+        // the segment is not cached anymore
+        self->cached[idx] = NULL;
+        _free_list(list);
+    }
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_3(DLIST_EVE_update_obj, DLIST_EVE_update);
+
+// Returns the list of segments (id, offset, size, cached)
+// ---------------------------------------------------
+STATIC mp_obj_t DLIST_EVE_segments(mp_obj_t self_in)
+{
+    dlist_eve_obj_t *self = (dlist_eve_obj_t *)self_in;
+    mp_obj_t list = mp_obj_new_list(0, NULL);
+    for (int i=0; i<self->dlist.nseg; i++) {
+        eve_dlist_seg_t *seg = &self->dlist.seg[i];
+        mp_obj_t tuple[4];
+        tuple[0] = mp_obj_new_int(seg->id);
+        tuple[1] = mp_obj_new_int(seg->start);
+        tuple[2] = mp_obj_new_int(seg->len);
+        tuple[3] = mp_obj_new_bool(seg->cached);
+        mp_obj_list_append(list, mp_obj_new_tuple(4, tuple));
+    }
+    return list;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(DLIST_EVE_segments_obj, DLIST_EVE_segments);
+
+// Returns the recorded command stream, as it is sent to EVE
+// ---------------------------------------------------
+STATIC mp_obj_t DLIST_EVE_buffer(mp_obj_t self_in)
+{
+    dlist_eve_obj_t *self = (dlist_eve_obj_t *)self_in;
+    return mp_obj_new_bytearray_by_ref(self->dlist.len, self->dlist.buf);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(DLIST_EVE_buffer_obj, DLIST_EVE_buffer);
+
+// Returns the number of recorded commands
+// ---------------------------------------------------
+STATIC mp_obj_t DLIST_EVE_count(mp_obj_t self_in)
+{
+    dlist_eve_obj_t *self = (dlist_eve_obj_t *)self_in;
+    int count = eve_dlist_count(self->dlist.buf, self->dlist.len);
+    if (count < 0) {
+        mp_raise_ValueError("Invalid command stream");
+    }
+    return mp_obj_new_int(count);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(DLIST_EVE_count_obj, DLIST_EVE_count);
+
+// Returns tuple (used, size)
+// ---------------------------------------------------
+STATIC mp_obj_t DLIST_EVE_size(mp_obj_t self_in)
+{
+    dlist_eve_obj_t *self = (dlist_eve_obj_t *)self_in;
+    mp_obj_t tuple[2];
+    tuple[0] = mp_obj_new_int(self->dlist.len);
+    tuple[1] = mp_obj_new_int(self->dlist.size);
+    return mp_obj_new_tuple(2, tuple);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(DLIST_EVE_size_obj, DLIST_EVE_size);
+
+// Remove all commands and segments, free the cached lists
+// ---------------------------------------------------
+STATIC mp_obj_t DLIST_EVE_clear(mp_obj_t self_in)
+{
+    dlist_eve_obj_t *self = (dlist_eve_obj_t *)self_in;
+    if ((eve_obj) && (eve_obj->recording == self)) {
+        mp_raise_ValueError("DList is recording");
+    }
+    for (int i=0; i<EVE_DLIST_MAX_SEGMENTS; i++) {
+        if (self->cached[i]) {
+            _check_inlist(eve_obj, 0);
+            break;
+        }
+    }
+    _dlist_free_cached(self);
+    eve_dlist_clear(&self->dlist);
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(DLIST_EVE_clear_obj, DLIST_EVE_clear);
+
+//--------------------------------------------------------------
+STATIC const mp_rom_map_elem_t dlist_eve_locals_dict_table[] = {
+    // instance methods
+    { MP_ROM_QSTR(MP_QSTR_mark),        MP_ROM_PTR(&DLIST_EVE_mark_obj) },
+    { MP_ROM_QSTR(MP_QSTR_cache),       MP_ROM_PTR(&DLIST_EVE_cache_obj) },
+    { MP_ROM_QSTR(MP_QSTR_update),      MP_ROM_PTR(&DLIST_EVE_update_obj) },
+    { MP_ROM_QSTR(MP_QSTR_segments),    MP_ROM_PTR(&DLIST_EVE_segments_obj) },
+    { MP_ROM_QSTR(MP_QSTR_buffer),      MP_ROM_PTR(&DLIST_EVE_buffer_obj) },
+    { MP_ROM_QSTR(MP_QSTR_count),       MP_ROM_PTR(&DLIST_EVE_count_obj) },
+    { MP_ROM_QSTR(MP_QSTR_size),        MP_ROM_PTR(&DLIST_EVE_size_obj) },
+    { MP_ROM_QSTR(MP_QSTR_clear),       MP_ROM_PTR(&DLIST_EVE_clear_obj) },
+};
+STATIC MP_DEFINE_CONST_DICT(dlist_eve_locals_dict, dlist_eve_locals_dict_table);
+
+//------------------------------------
+const mp_obj_type_t dlist_eve_type = {
+    { &mp_type_type },
+    .name = MP_QSTR_DList,
+    .print = dlist_eve_printinfo,
+    .make_new = DLIST_eve_make_new,
+    .locals_dict = (mp_obj_t)&dlist_eve_locals_dict,
+};
+
+// ^^^^ DList object end ^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^
+
+
 // ==== CONSOLE object ===========================================
 
 
@@ -4231,6 +4579,7 @@ STATIC const mp_rom_map_elem_t display_eve_locals_dict_table[] = {
     { MP_ROM_QSTR(MP_QSTR_endlist),             MP_ROM_PTR(&EVE_endlist_obj) },
     { MP_ROM_QSTR(MP_QSTR_savelist),            MP_ROM_PTR(&EVE_savelist_obj) },
     { MP_ROM_QSTR(MP_QSTR_appendlist),          MP_ROM_PTR(&EVE_appendlist_obj) },
+    { MP_ROM_QSTR(MP_QSTR_showlist),            MP_ROM_PTR(&EVE_showlist_obj) },
     { MP_ROM_QSTR(MP_QSTR_dumplist),            MP_ROM_PTR(&EVE_dumplist_obj) },
     { MP_ROM_QSTR(MP_QSTR_dumpcmd),             MP_ROM_PTR(&EVE_dumpcmd_obj) },
     { MP_ROM_QSTR(MP_QSTR_point),               MP_ROM_PTR(&EVE_point_obj) },
@@ -4295,6 +4644,7 @@ STATIC const mp_rom_map_elem_t display_eve_locals_dict_table[] = {
     { MP_OBJ_NEW_QSTR(MP_QSTR_Image),           MP_ROM_PTR(&image_eve_type) },
     { MP_OBJ_NEW_QSTR(MP_QSTR_Console),         MP_ROM_PTR(&console_eve_type) },
     { MP_OBJ_NEW_QSTR(MP_QSTR_Tft),             MP_ROM_PTR(&tft_eve_type) },
+    { MP_OBJ_NEW_QSTR(MP_QSTR_DList),           MP_ROM_PTR(&dlist_eve_type) },
 
     // SPI bus constants
     { MP_ROM_QSTR(MP_QSTR_HSPI),                MP_ROM_INT(HSPI_HOST) },
@@ -1104,6 +1104,42 @@ STATIC mp_obj_t display_tft_Image(size_t n_args, const mp_obj_t *pos_args, mp_ma
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_KW(display_tft_Image_obj, 3, display_tft_Image);
 
+#if MICROPY_PY_FRAMEBUF
+//----------------------------------------------------------------------------------------------
+STATIC mp_obj_t display_tft_blit(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+
+    const mp_arg_t allowed_args[] = {
+        { MP_QSTR_fbuf,  MP_ARG_REQUIRED | MP_ARG_OBJ, { .u_obj = mp_const_none } },
+        { MP_QSTR_x,     MP_ARG_REQUIRED | MP_ARG_INT, { .u_int = 0 } },
+        { MP_QSTR_y,     MP_ARG_REQUIRED | MP_ARG_INT, { .u_int = 0 } },
+        { MP_QSTR_key,                     MP_ARG_INT, { .u_int = -1 } },
+        { MP_QSTR_alpha,                   MP_ARG_INT, { .u_int = 255 } },
+        { MP_QSTR_scale,                   MP_ARG_INT, { .u_int = 1 } },
+    };
+    display_tft_obj_t *self = MP_OBJ_TO_PTR(pos_args[0]);
+    if (setupDevice(self)) return mp_const_none;
+
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    fb_surface_t fb;
+    if (mp_framebuf_get_surface(args[0].u_obj, &fb) != 0) {
+        mp_raise_TypeError("FrameBuffer expected");
+    }
+    if ((args[5].u_int < 1) || (args[5].u_int > FB_BLIT_MAX_SCALE)) {
+        mp_raise_ValueError("Scale must be 1 ~ 8");
+    }
+
+    int res = TFT_blit(&fb, args[1].u_int, args[2].u_int, args[3].u_int, args[4].u_int, args[5].u_int);
+    if (res == -2) {
+        mp_raise_msg(&mp_type_OSError, "Error allocating blit buffers");
+    }
+    if (res < 0) return mp_const_false;
+    return mp_const_true;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(display_tft_blit_obj, 3, display_tft_blit);
+#endif
+
 //------------------------------------------------------------------------------------------------
 STATIC mp_obj_t display_tft_getTouch(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
 
@@ -1599,6 +1635,9 @@ STATIC const mp_rom_map_elem_t display_tft_locals_dict_table[] = {
     { MP_ROM_QSTR(MP_QSTR_textClear),           MP_ROM_PTR(&display_tft_clearStringRect_obj) },
     { MP_ROM_QSTR(MP_QSTR_attrib7seg),          MP_ROM_PTR(&display_tft_7segAttrib_obj) },
     { MP_ROM_QSTR(MP_QSTR_image),               MP_ROM_PTR(&display_tft_Image_obj) },
+    #if MICROPY_PY_FRAMEBUF
+    { MP_ROM_QSTR(MP_QSTR_blit),                MP_ROM_PTR(&display_tft_blit_obj) },
+    #endif
     { MP_ROM_QSTR(MP_QSTR_gettouch),            MP_ROM_PTR(&display_tft_getTouch_obj) },
     { MP_ROM_QSTR(MP_QSTR_compileFont),         MP_ROM_PTR(&display_tft_compileFont_obj) },
     { MP_ROM_QSTR(MP_QSTR_hsb2rgb),             MP_ROM_PTR(&display_tft_HSBtoRGB_obj) },
@@ -1020,6 +1020,7 @@ STATIC const mp_rom_map_elem_t machine_module_globals_table[] = {
         { MP_OBJ_NEW_QSTR(MP_QSTR_Neopixel),			MP_ROM_PTR(&machine_neopixel_type) },
         { MP_OBJ_NEW_QSTR(MP_QSTR_DHT),					MP_ROM_PTR(&machine_dht_type) },
         { MP_OBJ_NEW_QSTR(MP_QSTR_Onewire),				MP_ROM_PTR(&machine_onewire_type) },
+        { MP_ROM_QSTR(MP_QSTR_Sensors),					MP_ROM_PTR(&machine_sensors_type) },
 #ifdef CONFIG_MICROPY_USE_GPS
         { MP_OBJ_NEW_QSTR(MP_QSTR_GPS),					MP_ROM_PTR(&machine_gps_type) },
 #endif
@@ -36,6 +36,7 @@
 #include "nvs.h"
 #include "py/obj.h"
 #include "driver/rtc_io.h"
+#include "extmod/timerwheel.h"
 
 #define MPY_MIN_STACK_SIZE	(6*1024)
 #define EXT1_WAKEUP_ALL_HIGH	2    //!< Wake the chip when all selected GPIOs go high
@@ -77,6 +78,9 @@ typedef struct _machine_pin_obj_t {
 
 typedef struct _machine_timer_obj_t {
     mp_obj_base_t base;
+    // Extended timers are linked into the timer wheel through 'node', it is kept at the start
+    // of the object so that the links point into its first GC block and keep the timer alive
+    tw_node_t node;
     uint8_t id;
     uint8_t state;
     uint8_t type;
@@ -90,6 +94,11 @@ typedef struct _machine_timer_obj_t {
     intr_handle_t handle;
     uint64_t counter;
     uint64_t alarm;
+    // extended timers only
+    uint32_t slack;                             // ticks the expiry can be delayed to coalesce it with others
+    uint8_t fired;                              // TIMER_FIRED_xxx
+    uint64_t fired_us;                          // time at which the pending callback was due
+    struct _machine_timer_obj_t *fired_next;    // next timer in the wheel's callback batch
 } machine_timer_obj_t;
 
 extern bool mpy_use_spiram;
@@ -121,6 +130,7 @@ extern const mp_obj_type_t machine_neopixel_type;
 extern const mp_obj_type_t machine_dht_type;
 extern const mp_obj_type_t machine_onewire_type;
 extern const mp_obj_type_t machine_ds18x20_type;
+extern const mp_obj_type_t machine_sensors_type;
 #ifdef CONFIG_MICROPY_USE_RFCOMM
 extern const mp_obj_type_t machine_rfcomm_type;
 #endif
@@ -136,4 +146,10 @@ void prepareSleepReset(uint8_t hrst, char *msg);
 int machine_pin_get_gpio(mp_obj_t pin_in);
 uint64_t random_at_most(uint32_t max);
 
+// Sensor acquisition scheduler bus backends
+struct _sensor_dev_t;
+void machine_hw_i2c_sensor_dev(mp_obj_t i2c_in, int addr, struct _sensor_dev_t *dev);
+void machine_hw_spi_sensor_dev(mp_obj_t spi_in, struct _sensor_dev_t *dev);
+void machine_ds18x20_sensor_dev(mp_obj_t ds_in, struct _sensor_dev_t *dev);
+
 #endif // MICROPY_INCLUDED_ESP32_MODMACHINE_H
@@ -46,6 +46,7 @@
 #include "py/runtime.h"
 #include "py/mphal.h"
 #include "py/mperrno.h"
+#include "py/boottrace.h"
 #include "netutils.h"
 #include "esp_wifi.h"
 #include "esp_log.h"
@@ -441,6 +442,10 @@ STATIC void require_if(mp_obj_t wlan_if, int if_no) {
 STATIC mp_obj_t esp_initialize() {
     if (wifi_network_state < WIFI_STATE_INIT) {
     	// This is executed only once
+        #if MICROPY_BOOT_TRACE
+        mp_boot_trace_span_t trace_span;
+        mp_boot_trace_begin(&trace_span);
+        #endif
         ESP_LOGD(MODNETTWORK_TAG, "Initializing TCP/IP");
         tcpip_adapter_init();
         ESP_LOGD(MODNETTWORK_TAG, "Initializing Event Loop");
@@ -454,6 +459,9 @@ STATIC mp_obj_t esp_initialize() {
         esp_wifi_set_sta_rx_probe_req(processPROBEREQRECVED);
 
         wifi_network_state = WIFI_STATE_INIT;
+        #if MICROPY_BOOT_TRACE
+        mp_boot_trace_end(&trace_span, MP_BOOT_TRACE_NETWORK, MP_QSTR_tcpip);
+        #endif
     }
     return mp_const_none;
 }
@@ -512,6 +520,10 @@ static void _init_wifi()
 //------------------------------------------------------
 static void _wifi_init(wifi_mode_t mode, bool reconnect)
 {
+    #if MICROPY_BOOT_TRACE
+    mp_boot_trace_span_t trace_span;
+    mp_boot_trace_begin(&trace_span);
+    #endif
 	if (wifi_network_state < WIFI_STATE_STOPPED) _init_wifi();
 
     esp_err_t ret = 0;
@@ -547,6 +559,9 @@ static void _wifi_init(wifi_mode_t mode, bool reconnect)
 
     wifi_network_state = WIFI_STATE_STARTED;
     ESP_LOGD(MODNETTWORK_TAG, "WiFi Started, mode %d", mode);
+    #if MICROPY_BOOT_TRACE
+    mp_boot_trace_end(&trace_span, MP_BOOT_TRACE_NETWORK, MP_QSTR_wifi);
+    #endif
     return;
 
 exit_error:
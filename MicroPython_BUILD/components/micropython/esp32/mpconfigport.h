@@ -28,6 +28,7 @@
 // overriding defaults in py/mpconfig.h.
 
 #include <stdint.h>
+#include <stddef.h>
 #include <alloca.h>
 #include "rom/ets_sys.h"
 #include "sdkconfig.h"
@@ -50,6 +51,7 @@
 //   mp_bytecode_print
 //   mp_parse_node_print
 #define MICROPY_DEBUG_PRINTERS              (0)
+#define MICROPY_BOOT_TRACE                  (1)
 // ------------------------------------------------------------
 
 // object representation and NLR handling
@@ -61,11 +63,19 @@
 
 // emitters
 #define MICROPY_PERSISTENT_CODE_LOAD        (1)
+#define MICROPY_PERSISTENT_CODE_SAVE        (1)
 #define MICROPY_EMIT_XTENSA					(0)
+#define MICROPY_EMIT_XTENSAWIN              (1)
 
 // compiler configuration
 #define MICROPY_COMP_MODULE_CONST           (1)
 #define MICROPY_COMP_TRIPLE_TUPLE_ASSIGN    (1)
+// without SPIRAM the heap is too small to hold the parse tree of a large script
+#if CONFIG_SPIRAM_SUPPORT
+#define MICROPY_COMP_STREAM                 (0)
+#else
+#define MICROPY_COMP_STREAM                 (1)
+#endif
 
 // optimizations
 #define MICROPY_OPT_COMPUTED_GOTO           (1)
@@ -79,11 +89,18 @@
 #define MICROPY_PY_GC_COLLECT_RETVAL        (0)
 #endif
 #define MICROPY_READER_VFS                  (1)
+#define MICROPY_MODULE_IMPORT_CACHE         (1)
 #define MICROPY_ENABLE_GC                   (1)
 // Be conservative and always clear to zero newly (re)allocated memory in the GC.
 // This helps eliminate stray pointers that hold on to memory that's no longer used.
 // It decreases performance due to unnecessary memory clearing.
 #define MICROPY_GC_CONSERVATIVE_CLEAR       (1)
+// With SPIRAM the heap consists of two areas, the main heap in SPIRAM
+// and the small, fast heap in internal RAM for the small, frequently used objects
+#if CONFIG_SPIRAM_SUPPORT
+#define MICROPY_GC_MAX_AREAS                (2)
+#define MICROPY_GC_FAST_MAX_BYTES           (CONFIG_MICROPY_FAST_HEAP_MAX_ALLOC)
+#endif
 // Whether to enable finalisers in the garbage collector (ie call __del__)
 #ifdef CONFIG_MICROPY_ENABLE_FINALISER
 #define MICROPY_ENABLE_FINALISER            (1)
@@ -110,6 +127,7 @@
 #define MICROPY_MODULE_WEAK_LINKS           (1)
 #define MICROPY_MODULE_FROZEN_STR           (0) // do not support frozen str modules
 #define MICROPY_MODULE_FROZEN_MPY           (1)
+#define MICROPY_MODULE_FROZEN_ROM           (1)
 #define MICROPY_QSTR_EXTRA_POOL             mp_qstr_frozen_const_pool
 #define MICROPY_CAN_OVERRIDE_BUILTINS       (1)
 #define MICROPY_USE_INTERNAL_ERRNO          (1)
@@ -156,11 +174,16 @@
 #define MICROPY_PY_BUILTINS_HELP_MODULES    (1)
 #define MICROPY_PY___FILE__                 (1)
 #define MICROPY_PY_MICROPYTHON_MEM_INFO     (1)
+#define MICROPY_PY_MICROPYTHON_PROFILE      (1)
+#define MICROPY_PY_MICROPYTHON_ALLOC_TRACE  (1)
+// Xtensa keeps the call window size in the top bits of return addresses
+#define MP_ALLOC_TRACE_CALLER() ((void*)(((uintptr_t)__builtin_return_address(0) & 0x3fffffff) | 0x40000000))
 #define MICROPY_PY_ARRAY                    (1)
 #define MICROPY_PY_ARRAY_SLICE_ASSIGN       (1)
 #define MICROPY_PY_ATTRTUPLE                (1)
 #define MICROPY_PY_COLLECTIONS              (1)
 #define MICROPY_PY_COLLECTIONS_DEQUE        (1)
+#define MICROPY_PY_COLLECTIONS_DEQUE_TYPED  (1)
 #define MICROPY_PY_COLLECTIONS_ORDEREDDICT  (1)
 #define MICROPY_PY_MATH                     (1)
 #define MICROPY_PY_MATH_SPECIAL_FUNCTIONS   (1)
@@ -190,7 +213,12 @@
 #define MICROPY_PY_UZLIB                    (1)
 #define MICROPY_PY_UJSON                    (1)
 #define MICROPY_PY_URE                      (1)
+#define MICROPY_PY_URE_PIKEVM               (1)
+#define MICROPY_PY_URE_SUB                  (1)
+#define MICROPY_PY_URE_FINDITER             (1)
+#define MICROPY_PY_URE_CACHE_SIZE           (8)
 #define MICROPY_PY_UHEAPQ                   (1)
+#define MICROPY_PY_UITERTOOLS               (1)
 #define MICROPY_PY_UTIMEQ                   (1)
 #define MICROPY_PY_UBINASCII                (1)
 #define MICROPY_PY_UBINASCII_CRC32          (1)
@@ -354,6 +382,7 @@ extern const struct _mp_obj_module_t mp_module_bluetooth;
     { MP_OBJ_NEW_QSTR(MP_QSTR_hashlib), (mp_obj_t)&mp_module_uhashlib }, \
     { MP_OBJ_NEW_QSTR(MP_QSTR_heapq), (mp_obj_t)&mp_module_uheapq }, \
     { MP_OBJ_NEW_QSTR(MP_QSTR_io), (mp_obj_t)&mp_module_io }, \
+    { MP_OBJ_NEW_QSTR(MP_QSTR_itertools), (mp_obj_t)&mp_module_uitertools }, \
     { MP_OBJ_NEW_QSTR(MP_QSTR_json), (mp_obj_t)&mp_module_ujson }, \
     { MP_OBJ_NEW_QSTR(MP_QSTR_os), (mp_obj_t)&uos_module }, \
     { MP_OBJ_NEW_QSTR(MP_QSTR_random), (mp_obj_t)&mp_module_urandom }, \
@@ -369,10 +398,13 @@ extern const struct _mp_obj_module_t mp_module_bluetooth;
 
 #define MICROPY_PORT_ROOT_POINTERS \
     const char *readline_hist[20]; \
+    struct _machine_timer_wheel_t *machine_timer_wheel; \
+    struct _machine_spi_queue_obj_t *spi_queue_active; \
 
 // type definitions for the specific machine
 #define BYTES_PER_WORD (4)
-#define MICROPY_MAKE_POINTER_CALLABLE(p) ((void*)((mp_uint_t)(p)))
+void *esp_native_code_commit(void*, size_t);
+#define MP_PLAT_COMMIT_EXEC(buf, len) esp_native_code_commit(buf, len)
 #define MP_PLAT_PRINT_STRN(str, len) mp_hal_stdout_tx_strn_cooked(str, len)
 #define MP_SSIZE_MAX (0x7fffffff)
 
@@ -39,10 +39,13 @@
 #include "driver/uart.h"
 #include "esp_task_wdt.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 
 #include "py/obj.h"
 #include "py/mpstate.h"
+#include "py/runtime.h"
 #include "py/mphal.h"
+#include "py/profile.h"
 #include "extmod/misc.h"
 #include "lib/utils/pyexec.h"
 #include "uart.h"
@@ -413,3 +416,38 @@ void mp_hal_delay_us(uint32_t us) {
 void mp_hal_delay_us_fast(uint32_t us) {
     ets_delay_us(us);
 }
+
+#if MICROPY_PY_MICROPYTHON_PROFILE
+// The profiler uses a high resolution esp_timer, so none of the hardware
+// timers used by machine.Timer is taken
+static esp_timer_handle_t profile_timer = NULL;
+
+//-----------------------------------------
+static void profile_timer_cb(void *arg)
+{
+    mp_profile_tick();
+}
+
+//-----------------------------------------
+void mp_hal_profile_timer(mp_uint_t hz)
+{
+    if (profile_timer == NULL) {
+        if (hz == 0) return;
+        esp_timer_create_args_t args = {
+            .callback = &profile_timer_cb,
+            .arg = NULL,
+            .dispatch_method = ESP_TIMER_TASK,
+            .name = "mpy_profile",
+        };
+        if (esp_timer_create(&args, &profile_timer) != ESP_OK) {
+            mp_raise_msg(&mp_type_OSError, "Error creating profile timer");
+        }
+    }
+    else esp_timer_stop(profile_timer);
+    if (hz > 0) {
+        uint64_t period = 1000000 / hz;
+        if (period < 100) period = 100;
+        esp_timer_start_periodic(profile_timer, period);
+    }
+}
+#endif
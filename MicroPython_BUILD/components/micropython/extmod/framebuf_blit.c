@@ -0,0 +1,523 @@
+/*
+ * This file is part of the MicroPython ESP32 project, https://github.com/loboris/MicroPython_ESP32_psRAM_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <string.h>
+
+#include "framebuf_blit.h"
+
+typedef void (*fb_fetch_t)(const fb_surface_t *s, int x, int y, int n, uint32_t *out);
+typedef void (*fb_store_t)(const fb_surface_t *s, int x, int y, int n, const uint32_t *in, const uint8_t *mask);
+
+// ==== Row fetch functions, one per source format ====
+
+//-------------------------------------------------------------------------------
+static void fetch_mvlsb(const fb_surface_t *s, int x, int y, int n, uint32_t *out)
+{
+    const uint8_t *p = s->buf + (y >> 3) * s->stride + x;
+    int shift = y & 7;
+    for (int i = 0; i < n; i++) out[i] = (p[i] >> shift) & 1;
+}
+
+//-------------------------------------------------------------------------------
+static void fetch_mhlsb(const fb_surface_t *s, int x, int y, int n, uint32_t *out)
+{
+    size_t idx = x + y * s->stride;
+    const uint8_t *p = s->buf + (idx >> 3);
+    int bit = 7 - (idx & 7);
+    for (int i = 0; i < n; i++) {
+        out[i] = (*p >> bit) & 1;
+        if (bit == 0) {
+            bit = 7;
+            p++;
+        }
+        else bit--;
+    }
+}
+
+//-------------------------------------------------------------------------------
+static void fetch_mhmsb(const fb_surface_t *s, int x, int y, int n, uint32_t *out)
+{
+    size_t idx = x + y * s->stride;
+    const uint8_t *p = s->buf + (idx >> 3);
+    int bit = idx & 7;
+    for (int i = 0; i < n; i++) {
+        out[i] = (*p >> bit) & 1;
+        if (bit == 7) {
+            bit = 0;
+            p++;
+        }
+        else bit++;
+    }
+}
+
+//-----------------------------------------------------------------------------
+static void fetch_gs2(const fb_surface_t *s, int x, int y, int n, uint32_t *out)
+{
+    size_t idx = x + y * s->stride;
+    const uint8_t *p = s->buf + (idx >> 2);
+    int shift = (idx & 3) << 1;
+    for (int i = 0; i < n; i++) {
+        out[i] = (*p >> shift) & 3;
+        shift += 2;
+        if (shift == 8) {
+            shift = 0;
+            p++;
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+static void fetch_gs4(const fb_surface_t *s, int x, int y, int n, uint32_t *out)
+{
+    size_t idx = x + y * s->stride;
+    const uint8_t *p = s->buf + (idx >> 1);
+    int i = 0;
+    if ((idx & 1) && (n > 0)) out[i++] = *p++ & 0x0f;
+    for (; i < (n - 1); i += 2) {
+        out[i] = *p >> 4;
+        out[i+1] = *p++ & 0x0f;
+    }
+    if (i < n) out[i] = *p >> 4;
+}
+
+//-----------------------------------------------------------------------------
+static void fetch_gs8(const fb_surface_t *s, int x, int y, int n, uint32_t *out)
+{
+    const uint8_t *p = s->buf + x + y * s->stride;
+    for (int i = 0; i < n; i++) out[i] = p[i];
+}
+
+//--------------------------------------------------------------------------------
+static void fetch_rgb565(const fb_surface_t *s, int x, int y, int n, uint32_t *out)
+{
+    const uint16_t *p = (const uint16_t *)s->buf + x + y * s->stride;
+    for (int i = 0; i < n; i++) out[i] = p[i];
+}
+
+//--------------------------------------------------------------------------------
+static void fetch_rgb888(const fb_surface_t *s, int x, int y, int n, uint32_t *out)
+{
+    const uint8_t *p = s->buf + (x + y * s->stride) * 3;
+    for (int i = 0; i < n; i++, p += 3) out[i] = ((uint32_t)p[0] << 16) | ((uint32_t)p[1] << 8) | p[2];
+}
+
+// ==== Row store functions, one per destination format ====
+// Pixels with 'mask' entry 0 are not stored, 'mask' can be NULL
+
+//----------------------------------------------------------------------------------------------------------
+static void store_mvlsb(const fb_surface_t *s, int x, int y, int n, const uint32_t *in, const uint8_t *mask)
+{
+    uint8_t *p = s->buf + (y >> 3) * s->stride + x;
+    int shift = y & 7;
+    uint8_t bit = 1 << shift;
+    if (mask == NULL) {
+        for (int i = 0; i < n; i++) p[i] = (p[i] & ~bit) | ((in[i] != 0) << shift);
+        return;
+    }
+    for (int i = 0; i < n; i++) {
+        if (mask[i] == 0) continue;
+        if (in[i]) p[i] |= bit;
+        else p[i] &= ~bit;
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------
+static void store_mhlsb(const fb_surface_t *s, int x, int y, int n, const uint32_t *in, const uint8_t *mask)
+{
+    size_t idx = x + y * s->stride;
+    uint8_t *p = s->buf + (idx >> 3);
+    int bit = 7 - (idx & 7);
+    for (int i = 0; i < n; i++) {
+        if ((mask == NULL) || (mask[i])) {
+            if (in[i]) *p |= (1 << bit);
+            else *p &= ~(1 << bit);
+        }
+        if (bit == 0) {
+            bit = 7;
+            p++;
+        }
+        else bit--;
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------
+static void store_mhmsb(const fb_surface_t *s, int x, int y, int n, const uint32_t *in, const uint8_t *mask)
+{
+    size_t idx = x + y * s->stride;
+    uint8_t *p = s->buf + (idx >> 3);
+    int bit = idx & 7;
+    for (int i = 0; i < n; i++) {
+        if ((mask == NULL) || (mask[i])) {
+            if (in[i]) *p |= (1 << bit);
+            else *p &= ~(1 << bit);
+        }
+        if (bit == 7) {
+            bit = 0;
+            p++;
+        }
+        else bit++;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------------
+static void store_gs2(const fb_surface_t *s, int x, int y, int n, const uint32_t *in, const uint8_t *mask)
+{
+    size_t idx = x + y * s->stride;
+    uint8_t *p = s->buf + (idx >> 2);
+    int shift = (idx & 3) << 1;
+    for (int i = 0; i < n; i++) {
+        if ((mask == NULL) || (mask[i])) *p = (*p & ~(3 << shift)) | ((in[i] & 3) << shift);
+        shift += 2;
+        if (shift == 8) {
+            shift = 0;
+            p++;
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------------------------
+static void store_gs4(const fb_surface_t *s, int x, int y, int n, const uint32_t *in, const uint8_t *mask)
+{
+    size_t idx = x + y * s->stride;
+    uint8_t *p = s->buf + (idx >> 1);
+    int odd = idx & 1;
+    for (int i = 0; i < n; i++) {
+        if ((mask == NULL) || (mask[i])) {
+            if (odd) *p = (*p & 0xf0) | (in[i] & 0x0f);
+            else *p = (*p & 0x0f) | ((in[i] & 0x0f) << 4);
+        }
+        if (odd) p++;
+        odd ^= 1;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------------
+static void store_gs8(const fb_surface_t *s, int x, int y, int n, const uint32_t *in, const uint8_t *mask)
+{
+    uint8_t *p = s->buf + x + y * s->stride;
+    if (mask) {
+        for (int i = 0; i < n; i++) {
+            if (mask[i]) p[i] = in[i];
+        }
+    }
+    else {
+        for (int i = 0; i < n; i++) p[i] = in[i];
+    }
+}
+
+//-----------------------------------------------------------------------------------------------------------
+static void store_rgb565(const fb_surface_t *s, int x, int y, int n, const uint32_t *in, const uint8_t *mask)
+{
+    uint16_t *p = (uint16_t *)s->buf + x + y * s->stride;
+    if (mask) {
+        for (int i = 0; i < n; i++) {
+            if (mask[i]) p[i] = in[i];
+        }
+    }
+    else {
+        for (int i = 0; i < n; i++) p[i] = in[i];
+    }
+}
+
+//-----------------------------------------------------------------------------------------------------------
+static void store_rgb888(const fb_surface_t *s, int x, int y, int n, const uint32_t *in, const uint8_t *mask)
+{
+    uint8_t *p = s->buf + (x + y * s->stride) * 3;
+    for (int i = 0; i < n; i++, p += 3) {
+        if ((mask) && (mask[i] == 0)) continue;
+        p[0] = in[i] >> 16;
+        p[1] = in[i] >> 8;
+        p[2] = in[i];
+    }
+}
+
+static const fb_fetch_t fb_fetch[FRAMEBUF_FORMATS] = {
+    [FRAMEBUF_MVLSB] = fetch_mvlsb,
+    [FRAMEBUF_RGB565] = fetch_rgb565,
+    [FRAMEBUF_GS2_HMSB] = fetch_gs2,
+    [FRAMEBUF_GS4_HMSB] = fetch_gs4,
+    [FRAMEBUF_GS8] = fetch_gs8,
+    [FRAMEBUF_MHLSB] = fetch_mhlsb,
+    [FRAMEBUF_MHMSB] = fetch_mhmsb,
+    [FRAMEBUF_RGB888] = fetch_rgb888,
+};
+
+static const fb_store_t fb_store[FRAMEBUF_FORMATS] = {
+    [FRAMEBUF_MVLSB] = store_mvlsb,
+    [FRAMEBUF_RGB565] = store_rgb565,
+    [FRAMEBUF_GS2_HMSB] = store_gs2,
+    [FRAMEBUF_GS4_HMSB] = store_gs4,
+    [FRAMEBUF_GS8] = store_gs8,
+    [FRAMEBUF_MHLSB] = store_mhlsb,
+    [FRAMEBUF_MHMSB] = store_mhmsb,
+    [FRAMEBUF_RGB888] = store_rgb888,
+};
+
+// ==== Color conversion ====
+
+// All monochrome formats have the same pixel values
+//-------------------------------------
+static int _color_type(int format)
+{
+    if ((format == FRAMEBUF_MHLSB) || (format == FRAMEBUF_MHMSB)) return FRAMEBUF_MVLSB;
+    return format;
+}
+
+// Bytes per pixel of the byte aligned formats, 0 for bit packed formats
+//-----------------------------------
+static int _byte_size(int format)
+{
+    switch (format) {
+        case FRAMEBUF_GS8: return 1;
+        case FRAMEBUF_RGB565: return 2;
+        case FRAMEBUF_RGB888: return 3;
+        default: return 0;
+    }
+}
+
+//-----------------------------------------------------
+uint32_t fb_color_to_rgb(int format, uint32_t col)
+{
+    uint32_t gray;
+    switch (format) {
+        case FRAMEBUF_RGB565: {
+            uint32_t r = (col >> 11) & 0x1f;
+            uint32_t g = (col >> 5) & 0x3f;
+            uint32_t b = col & 0x1f;
+            return (((r << 3) | (r >> 2)) << 16) | (((g << 2) | (g >> 4)) << 8) | ((b << 3) | (b >> 2));
+        }
+        case FRAMEBUF_RGB888:
+            return col & 0xffffff;
+        case FRAMEBUF_GS8:
+            gray = col & 0xff;
+            break;
+        case FRAMEBUF_GS4_HMSB:
+            gray = (col & 0x0f) * 17;
+            break;
+        case FRAMEBUF_GS2_HMSB:
+            gray = (col & 0x03) * 85;
+            break;
+        default:
+            gray = (col) ? 0xff : 0;
+            break;
+    }
+    return gray * 0x010101;
+}
+
+//-------------------------------------------------------
+uint32_t fb_color_from_rgb(int format, uint32_t rgb)
+{
+    uint32_t r = (rgb >> 16) & 0xff;
+    uint32_t g = (rgb >> 8) & 0xff;
+    uint32_t b = rgb & 0xff;
+    if (format == FRAMEBUF_RGB565) return ((r & 0xf8) << 8) | ((g & 0xfc) << 3) | (b >> 3);
+    if (format == FRAMEBUF_RGB888) return rgb & 0xffffff;
+
+    uint32_t lum = ((r * 77) + (g * 150) + (b * 29)) >> 8;
+    switch (format) {
+        case FRAMEBUF_GS8: return lum;
+        case FRAMEBUF_GS4_HMSB: return lum >> 4;
+        case FRAMEBUF_GS2_HMSB: return lum >> 6;
+        default: return lum >> 7;
+    }
+}
+
+//----------------------------------------------------------
+static void _row_to_rgb(int format, uint32_t *buf, int n)
+{
+    switch (format) {
+        case FRAMEBUF_RGB888:
+            break;
+        case FRAMEBUF_RGB565:
+            for (int i = 0; i < n; i++) buf[i] = fb_color_to_rgb(FRAMEBUF_RGB565, buf[i]);
+            break;
+        case FRAMEBUF_GS8:
+            for (int i = 0; i < n; i++) buf[i] = (buf[i] & 0xff) * 0x010101;
+            break;
+        case FRAMEBUF_GS4_HMSB:
+            for (int i = 0; i < n; i++) buf[i] = (buf[i] & 0x0f) * (17 * 0x010101);
+            break;
+        case FRAMEBUF_GS2_HMSB:
+            for (int i = 0; i < n; i++) buf[i] = (buf[i] & 0x03) * (85 * 0x010101);
+            break;
+        default:
+            for (int i = 0; i < n; i++) buf[i] = (buf[i]) ? 0xffffff : 0;
+            break;
+    }
+}
+
+//------------------------------------------------------------
+static void _row_from_rgb(int format, uint32_t *buf, int n)
+{
+    if (format == FRAMEBUF_RGB888) return;
+    if (format == FRAMEBUF_RGB565) {
+        for (int i = 0; i < n; i++) {
+            uint32_t c = buf[i];
+            buf[i] = ((c >> 8) & 0xf800) | ((c >> 5) & 0x07e0) | ((c >> 3) & 0x001f);
+        }
+        return;
+    }
+    // gray scale and mono formats, luminance scaled to the format's bits
+    int shift = (format == FRAMEBUF_GS8) ? 0 : (format == FRAMEBUF_GS4_HMSB) ? 4 : (format == FRAMEBUF_GS2_HMSB) ? 6 : 7;
+    for (int i = 0; i < n; i++) {
+        uint32_t c = buf[i];
+        buf[i] = ((((c >> 16) & 0xff) * 77) + (((c >> 8) & 0xff) * 150) + ((c & 0xff) * 29)) >> (8 + shift);
+    }
+}
+
+// Blend 'src' over 'dst', both 0xRRGGBB; rounded division by 255
+//------------------------------------------------------------------------------
+static void _row_blend(uint32_t *src, const uint32_t *dst, int n, uint32_t alpha)
+{
+    uint32_t ialpha = 255 - alpha;
+    for (int i = 0; i < n; i++) {
+        uint32_t res = 0;
+        for (int sh = 0; sh < 24; sh += 8) {
+            uint32_t t = (((src[i] >> sh) & 0xff) * alpha) + (((dst[i] >> sh) & 0xff) * ialpha) + 128;
+            res |= ((t + (t >> 8)) >> 8) << sh;
+        }
+        src[i] = res;
+    }
+}
+
+// Fetch 'n' source pixels starting at the scaled position (sx, sy), translate them through the palette
+// and mark the pixels equal to 'key'
+// Returns the number of opaque pixels
+//------------------------------------------------------------------------------------------------------------------
+static int _fetch_scaled(const fb_surface_t *src, const fb_surface_t *palette, int sx, int sy, int n, int scale,
+                         int32_t key, uint32_t *out, uint8_t *mask)
+{
+    fb_fetch_t fetch = fb_fetch[src->format];
+    if (scale == 1) fetch(src, sx, sy, n, out);
+    else {
+        // fetch the covered source pixels and repeat each one 'scale' times
+        uint32_t tmp[FB_BLIT_CHUNK];
+        int first = sx / scale;
+        int count = ((sx + n - 1) / scale) - first + 1;
+        fetch(src, first, sy / scale, count, tmp);
+        int rep = sx - (first * scale);
+        int j = 0;
+        for (int i = 0; i < n; i++) {
+            out[i] = tmp[j];
+            if (++rep == scale) {
+                rep = 0;
+                j++;
+            }
+        }
+    }
+    if (palette) {
+        fb_fetch_t fetch_pal = fb_fetch[palette->format];
+        for (int i = 0; i < n; i++) {
+            if (out[i] < (uint32_t)palette->width) fetch_pal(palette, out[i], 0, 1, &out[i]);
+        }
+    }
+    if (key < 0) return n;
+
+    int opaque = 0;
+    for (int i = 0; i < n; i++) {
+        mask[i] = (out[i] != (uint32_t)key);
+        opaque += mask[i];
+    }
+    return opaque;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+int fb_blit_row_rgb(const fb_surface_t *src, int sx, int sy, int n, int scale, int32_t key, uint32_t *rgb, uint8_t *mask)
+{
+    if ((scale < 1) || (scale > FB_BLIT_MAX_SCALE) || (src->format >= FRAMEBUF_FORMATS)) return 0;
+    if (mask == NULL) key = -1;
+
+    int opaque = 0;
+    for (int pos = 0; pos < n; pos += FB_BLIT_CHUNK) {
+        int len = ((n - pos) > FB_BLIT_CHUNK) ? FB_BLIT_CHUNK : (n - pos);
+        opaque += _fetch_scaled(src, NULL, sx + pos, sy, len, scale, key, rgb + pos, (mask) ? (mask + pos) : NULL);
+        _row_to_rgb(src->format, rgb + pos, len);
+    }
+    return opaque;
+}
+
+//---------------------------------------------------------------------------------------------------------------
+int fb_blit(const fb_surface_t *dst, const fb_surface_t *src, const fb_surface_t *palette, int x, int y,
+            int32_t key, int alpha, int scale, int convert)
+{
+    if ((src->format >= FRAMEBUF_FORMATS) || (dst->format >= FRAMEBUF_FORMATS)) return 0;
+    if ((palette) && ((palette->format >= FRAMEBUF_FORMATS) || (palette->width < 1) || (palette->height < 1))) return 0;
+    if ((scale < 1) || (scale > FB_BLIT_MAX_SCALE) || (alpha <= 0)) return 0;
+    if (alpha > 255) alpha = 255;
+
+    // Clip the scaled source image to the destination
+    int x0 = (x < 0) ? 0 : x;
+    int y0 = (y < 0) ? 0 : y;
+    int x1 = x + (src->width * scale);
+    int y1 = y + (src->height * scale);
+    if (x1 > dst->width) x1 = dst->width;
+    if (y1 > dst->height) y1 = dst->height;
+    if ((x0 >= x1) || (y0 >= y1)) return 0;
+
+    // the translated pixels have the palette's format,
+    // without conversion the source values are destination colours
+    int src_format = (palette) ? palette->format : src->format;
+    if (!convert) src_format = dst->format;
+    int same = (_color_type(src_format) == _color_type(dst->format));
+    int bsize = _byte_size(src->format);
+
+    if ((palette == NULL) && (src->format == dst->format) && (bsize) && (key < 0) && (alpha == 255) && (scale == 1)) {
+        // Same byte aligned format, copy the rows
+        for (int dy = y0; dy < y1; dy++) {
+            memmove(dst->buf + ((x0 + (dy * dst->stride)) * bsize),
+                    src->buf + (((x0 - x) + ((dy - y) * src->stride)) * bsize), (x1 - x0) * bsize);
+        }
+        return (x1 - x0) * (y1 - y0);
+    }
+
+    fb_fetch_t fetch_dst = fb_fetch[dst->format];
+    fb_store_t store = fb_store[dst->format];
+    uint32_t pix[FB_BLIT_CHUNK];
+    uint32_t back[FB_BLIT_CHUNK];
+    uint8_t mask[FB_BLIT_CHUNK];
+
+    for (int dy = y0; dy < y1; dy++) {
+        for (int dx = x0; dx < x1; dx += FB_BLIT_CHUNK) {
+            int n = ((x1 - dx) > FB_BLIT_CHUNK) ? FB_BLIT_CHUNK : (x1 - dx);
+            int opaque = _fetch_scaled(src, palette, dx - x, dy - y, n, scale, key, pix, mask);
+            if (opaque == 0) continue;
+
+            if (alpha < 255) {
+                _row_to_rgb(src_format, pix, n);
+                fetch_dst(dst, dx, dy, n, back);
+                _row_to_rgb(dst->format, back, n);
+                _row_blend(pix, back, n, alpha);
+                _row_from_rgb(dst->format, pix, n);
+            }
+            else if (!same) {
+                _row_to_rgb(src_format, pix, n);
+                _row_from_rgb(dst->format, pix, n);
+            }
+            store(dst, dx, dy, n, pix, (opaque < n) ? mask : NULL);
+        }
+    }
+    return (x1 - x0) * (y1 - y0);
+}
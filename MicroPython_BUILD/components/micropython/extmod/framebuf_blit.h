@@ -0,0 +1,91 @@
+/*
+ * This file is part of the MicroPython ESP32 project, https://github.com/loboris/MicroPython_ESP32_psRAM_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Format specialised bitmap blitter used by 'framebuf' and the display module.
+ *
+ * The blit is processed row by row in chunks of FB_BLIT_CHUNK pixels:
+ * source pixels are fetched with the source format loop, tested against the
+ * colour key, optionally converted to the destination format (through RGB888
+ * if the formats differ), alpha blended with the destination pixels and
+ * scaled, and stored with the destination format loop.
+ * Rows of the same format without key, alpha or scaling are copied with memcpy.
+ *
+ * This module has no ESP-IDF or MicroPython dependencies and can be compiled on host.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Pixel formats, the values are the 'framebuf' module constants
+#define FRAMEBUF_MVLSB    (0)
+#define FRAMEBUF_RGB565   (1)
+#define FRAMEBUF_GS2_HMSB (5)
+#define FRAMEBUF_GS4_HMSB (2)
+#define FRAMEBUF_GS8      (6)
+#define FRAMEBUF_MHLSB    (3)
+#define FRAMEBUF_MHMSB    (4)
+#define FRAMEBUF_RGB888   (7)
+#define FRAMEBUF_FORMATS  (8)
+
+#define FB_BLIT_CHUNK     (32)
+#define FB_BLIT_MAX_SCALE (8)
+
+typedef struct _fb_surface_t {
+    uint8_t *buf;
+    int width;
+    int height;
+    int stride;     // in pixels
+    int format;
+} fb_surface_t;
+
+// Blit 'src' to 'dst' at (x, y), clipped to the destination
+// palette: if not NULL, the source pixel value is the index of the pixel in the palette's first row,
+//          the palette pixel is used as the source color; values outside the palette are used unchanged
+// key:     source pixel value (after palette translation) not drawn, -1 for no colour key
+// alpha:   0 (transparent) ~ 255 (opaque)
+// scale:   integer scale factor 1 ~ FB_BLIT_MAX_SCALE
+// convert: if 0, the source pixel values are stored unchanged (as destination colours),
+//          otherwise the colours are converted between the formats (luminance for gray and mono)
+// Returns the number of destination pixels processed
+int fb_blit(const fb_surface_t *dst, const fb_surface_t *src, const fb_surface_t *palette, int x, int y,
+            int32_t key, int alpha, int scale, int convert);
+
+// Get 'n' pixels of the scaled source image as 0xRRGGBB values
+// The pixels start at the scaled position (sx, sy) and must be inside the scaled source image.
+// If 'mask' is not NULL, pixels equal to 'key' are marked with 0, others with 1.
+// Returns the number of opaque pixels.
+int fb_blit_row_rgb(const fb_surface_t *src, int sx, int sy, int n, int scale, int32_t key, uint32_t *rgb, uint8_t *mask);
+
+// Convert between the raw pixel value and 0xRRGGBB
+uint32_t fb_color_to_rgb(int format, uint32_t col);
+uint32_t fb_color_from_rgb(int format, uint32_t rgb);
+
+// Get the surface of the 'framebuf.FrameBuffer' object, returns -1 if the object is not a FrameBuffer
+// Implemented in modframebuf.c
+int mp_framebuf_get_surface(const void *obj, fb_surface_t *surface);
@@ -26,13 +26,16 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "py/runtime.h"
+#include "py/binary.h"
 
 #if MICROPY_PY_FRAMEBUF
 
 #include "font_petme128_8x8.h"
+#include "framebuf_blit.h"
 
 typedef struct _mp_obj_framebuf_t {
     mp_obj_base_t base;
@@ -42,24 +45,25 @@ typedef struct _mp_obj_framebuf_t {
     uint8_t format;
 } mp_obj_framebuf_t;
 
+STATIC const mp_obj_type_t mp_type_framebuf;
+
 typedef void (*setpixel_t)(const mp_obj_framebuf_t*, int, int, uint32_t);
 typedef uint32_t (*getpixel_t)(const mp_obj_framebuf_t*, int, int);
 typedef void (*fill_rect_t)(const mp_obj_framebuf_t *, int, int, int, int, uint32_t);
+typedef void (*line_t)(const mp_obj_framebuf_t *, int, int, int, int, uint32_t);
+typedef void (*glyph_t)(const mp_obj_framebuf_t *, int, int, const uint8_t *, uint32_t);
+typedef void (*scroll_t)(const mp_obj_framebuf_t *, int, int);
 
 typedef struct _mp_framebuf_p_t {
     setpixel_t setpixel;
     getpixel_t getpixel;
     fill_rect_t fill_rect;
+    line_t line;
+    glyph_t glyph;
+    scroll_t scroll;
 } mp_framebuf_p_t;
 
-// constants for formats
-#define FRAMEBUF_MVLSB    (0)
-#define FRAMEBUF_RGB565   (1)
-#define FRAMEBUF_GS2_HMSB (5)
-#define FRAMEBUF_GS4_HMSB (2)
-#define FRAMEBUF_GS8      (6)
-#define FRAMEBUF_MHLSB    (3)
-#define FRAMEBUF_MHMSB    (4)
+// constants for formats are defined in framebuf_blit.h
 
 // Functions for MHLSB and MHMSB
 
@@ -76,16 +80,30 @@ STATIC uint32_t mono_horiz_getpixel(const mp_obj_framebuf_t *fb, int x, int y) {
 }
 
 STATIC void mono_horiz_fill_rect(const mp_obj_framebuf_t *fb, int x, int y, int w, int h, uint32_t col) {
-    int reverse = fb->format == FRAMEBUF_MHMSB;
+    // the partial bytes at the span ends are masked, the whole bytes are set with memset
     int advance = fb->stride >> 3;
-    while (w--) {
-        uint8_t *b = &((uint8_t*)fb->buf)[(x >> 3) + y * advance];
-        int offset = reverse ?  x & 7 : 7 - (x & 7);
-        for (int hh = h; hh; --hh) {
-            *b = (*b & ~(0x01 << offset)) | ((col != 0) << offset);
-            b += advance;
+    int first = x >> 3;
+    int last = (x + w - 1) >> 3;
+    uint8_t lmask, rmask;
+    if (fb->format == FRAMEBUF_MHMSB) {
+        lmask = 0xff << (x & 7);
+        rmask = 0xff >> (7 - ((x + w - 1) & 7));
+    } else {
+        lmask = 0xff >> (x & 7);
+        rmask = 0xff << (7 - ((x + w - 1) & 7));
+    }
+    if (first == last) {
+        lmask &= rmask;
+    }
+    uint8_t fill = (col != 0) ? 0xff : 0x00;
+    uint8_t *b = &((uint8_t*)fb->buf)[first + y * advance];
+    while (h--) {
+        b[0] = (b[0] & ~lmask) | (fill & lmask);
+        if (last > first) {
+            memset(b + 1, fill, last - first - 1);
+            b[last - first] = (b[last - first] & ~rmask) | (fill & rmask);
         }
-        ++x;
+        b += advance;
     }
 }
 
@@ -102,14 +120,23 @@ STATIC uint32_t mvlsb_getpixel(const mp_obj_framebuf_t *fb, int x, int y) {
 }
 
 STATIC void mvlsb_fill_rect(const mp_obj_framebuf_t *fb, int x, int y, int w, int h, uint32_t col) {
-    while (h--) {
+    // fill up to 8 rows (one byte row) at once
+    uint8_t fill = (col != 0) ? 0xff : 0x00;
+    while (h > 0) {
+        int offset = y & 0x07;
+        int rows = MIN(8 - offset, h);
+        uint8_t mask = ((1 << rows) - 1) << offset;
         uint8_t *b = &((uint8_t*)fb->buf)[(y >> 3) * fb->stride + x];
-        uint8_t offset = y & 0x07;
-        for (int ww = w; ww; --ww) {
-            *b = (*b & ~(0x01 << offset)) | ((col != 0) << offset);
-            ++b;
+        if (mask == 0xff) {
+            memset(b, fill, w);
+        } else {
+            for (int ww = w; ww; --ww) {
+                *b = (*b & ~mask) | (fill & mask);
+                ++b;
+            }
         }
-        ++y;
+        y += rows;
+        h -= rows;
     }
 }
 
@@ -150,9 +177,28 @@ STATIC uint32_t gs2_hmsb_getpixel(const mp_obj_framebuf_t *fb, int x, int y) {
 }
 
 STATIC void gs2_hmsb_fill_rect(const mp_obj_framebuf_t *fb, int x, int y, int w, int h, uint32_t col) {
-    for (int xx=x; xx < x+w; xx++) {
-        for (int yy=y; yy < y+h; yy++) {
-            gs2_hmsb_setpixel(fb, xx, yy, col);
+    // 4 pixels per byte, the partial bytes at the span ends are set by pixel
+    col &= 0x3;
+    uint8_t fill = col * 0x55;
+    if (w < 8) {
+        for (int xx = x; xx < x + w; xx++) {
+            for (int yy = y; yy < y + h; yy++) {
+                gs2_hmsb_setpixel(fb, xx, yy, col);
+            }
+        }
+        return;
+    }
+    for (int yy = y; yy < y + h; yy++) {
+        int xx = x;
+        int xend = x + w;
+        while ((xx & 0x3) && (xx < xend)) {
+            gs2_hmsb_setpixel(fb, xx++, yy, col);
+        }
+        int nbytes = (xend - xx) >> 2;
+        memset(&((uint8_t*)fb->buf)[(xx + yy * fb->stride) >> 2], fill, nbytes);
+        xx += nbytes << 2;
+        while (xx < xend) {
+            gs2_hmsb_setpixel(fb, xx++, yy, col);
         }
     }
 }
@@ -227,14 +273,226 @@ STATIC void gs8_fill_rect(const mp_obj_framebuf_t *fb, int x, int y, int w, int
     }
 }
 
+// Functions for RGB888 format, 3 bytes per pixel: R, G, B
+
+STATIC void rgb888_setpixel(const mp_obj_framebuf_t *fb, int x, int y, uint32_t col) {
+    uint8_t *pixel = &((uint8_t*)fb->buf)[(x + y * fb->stride) * 3];
+    pixel[0] = col >> 16;
+    pixel[1] = col >> 8;
+    pixel[2] = col;
+}
+
+STATIC uint32_t rgb888_getpixel(const mp_obj_framebuf_t *fb, int x, int y) {
+    uint8_t *pixel = &((uint8_t*)fb->buf)[(x + y * fb->stride) * 3];
+    return (pixel[0] << 16) | (pixel[1] << 8) | pixel[2];
+}
+
+STATIC void rgb888_fill_rect(const mp_obj_framebuf_t *fb, int x, int y, int w, int h, uint32_t col) {
+    uint8_t *line = &((uint8_t*)fb->buf)[(x + y * fb->stride) * 3];
+    // fill the first line, copy it to the other lines
+    for (int ww = 0; ww < w; ww++) {
+        line[ww * 3] = col >> 16;
+        line[ww * 3 + 1] = col >> 8;
+        line[ww * 3 + 2] = col;
+    }
+    uint8_t *pixel = line;
+    while (--h > 0) {
+        pixel += fb->stride * 3;
+        memcpy(pixel, line, w * 3);
+    }
+}
+
+// Format specialised kernels
+// The kernels are generated for each format, so the format's setpixel/getpixel
+// functions are inlined instead of being called through the function pointer for every pixel.
+
+// Line, the end points are included; horizontal and vertical lines are drawn with fill_rect
+#define FRAMEBUF_LINE_KERNEL(fmt) \
+STATIC void fmt##_line(const mp_obj_framebuf_t *fb, int x1, int y1, int x2, int y2, uint32_t col) { \
+    int dx = x2 - x1; \
+    int sx = (dx > 0) ? 1 : -1; \
+    if (dx < 0) dx = -dx; \
+    int dy = y2 - y1; \
+    int sy = (dy > 0) ? 1 : -1; \
+    if (dy < 0) dy = -dy; \
+    int e; \
+    if (dy > dx) { \
+        /* steep, step in y */ \
+        e = 2 * dx - dy; \
+        for (int i = 0; i < dy; ++i) { \
+            if (0 <= x1 && x1 < fb->width && 0 <= y1 && y1 < fb->height) { \
+                fmt##_setpixel(fb, x1, y1, col); \
+            } \
+            while (e >= 0) { \
+                x1 += sx; \
+                e -= 2 * dy; \
+            } \
+            y1 += sy; \
+            e += 2 * dx; \
+        } \
+    } else { \
+        e = 2 * dy - dx; \
+        for (int i = 0; i < dx; ++i) { \
+            if (0 <= x1 && x1 < fb->width && 0 <= y1 && y1 < fb->height) { \
+                fmt##_setpixel(fb, x1, y1, col); \
+            } \
+            while (e >= 0) { \
+                y1 += sy; \
+                e -= 2 * dx; \
+            } \
+            x1 += sx; \
+            e += 2 * dy; \
+        } \
+    } \
+    if (0 <= x2 && x2 < fb->width && 0 <= y2 && y2 < fb->height) { \
+        fmt##_setpixel(fb, x2, y2, col); \
+    } \
+}
+
+// 8x8 font character, each byte of 'chr_data' is a column of 8 pixels, LSB at top
+#define FRAMEBUF_GLYPH_KERNEL(fmt) \
+STATIC void fmt##_glyph(const mp_obj_framebuf_t *fb, int x0, int y0, const uint8_t *chr_data, uint32_t col) { \
+    for (int j = 0; j < 8; j++, x0++) { \
+        if (0 <= x0 && x0 < fb->width) { \
+            uint vline_data = chr_data[j]; \
+            for (int y = y0; vline_data; vline_data >>= 1, y++) { \
+                if ((vline_data & 1) && 0 <= y && y < fb->height) { \
+                    fmt##_setpixel(fb, x0, y, col); \
+                } \
+            } \
+        } \
+    } \
+}
+
+// Scroll by pixel, used if the scroll can't be done by moving whole bytes
+// The steps are less than the frame buffer dimensions
+#define FRAMEBUF_SCROLL_KERNEL(fmt) \
+STATIC void fmt##_scroll(const mp_obj_framebuf_t *fb, int xstep, int ystep) { \
+    int sx, y, xend, yend, dx, dy; \
+    if (xstep < 0) { \
+        sx = 0; \
+        xend = fb->width + xstep; \
+        dx = 1; \
+    } else { \
+        sx = fb->width - 1; \
+        xend = xstep - 1; \
+        dx = -1; \
+    } \
+    if (ystep < 0) { \
+        y = 0; \
+        yend = fb->height + ystep; \
+        dy = 1; \
+    } else { \
+        y = fb->height - 1; \
+        yend = ystep - 1; \
+        dy = -1; \
+    } \
+    for (; y != yend; y += dy) { \
+        for (int x = sx; x != xend; x += dx) { \
+            fmt##_setpixel(fb, x, y, fmt##_getpixel(fb, x - xstep, y - ystep)); \
+        } \
+    } \
+}
+
+#define FRAMEBUF_KERNELS(fmt) \
+    FRAMEBUF_LINE_KERNEL(fmt) \
+    FRAMEBUF_SCROLL_KERNEL(fmt)
+
+FRAMEBUF_KERNELS(mvlsb)
+FRAMEBUF_KERNELS(mono_horiz)
+FRAMEBUF_KERNELS(rgb565)
+FRAMEBUF_KERNELS(gs2_hmsb)
+FRAMEBUF_KERNELS(gs4_hmsb)
+FRAMEBUF_KERNELS(gs8)
+FRAMEBUF_KERNELS(rgb888)
+FRAMEBUF_GLYPH_KERNEL(rgb565)
+FRAMEBUF_GLYPH_KERNEL(gs2_hmsb)
+FRAMEBUF_GLYPH_KERNEL(gs4_hmsb)
+FRAMEBUF_GLYPH_KERNEL(gs8)
+FRAMEBUF_GLYPH_KERNEL(rgb888)
+
+// The font column is a byte column of the MVLSB format, set up to 2 bytes per column
+STATIC void mvlsb_glyph(const mp_obj_framebuf_t *fb, int x0, int y0, const uint8_t *chr_data, uint32_t col) {
+    // mask of the glyph rows inside the frame buffer
+    uint32_t rows = 0xff;
+    if (y0 < 0) {
+        rows = (y0 > -8) ? (rows << -y0) & 0xff : 0;
+    }
+    if (y0 + 8 > fb->height) {
+        rows &= (fb->height > y0) ? (0xff >> (y0 + 8 - fb->height)) : 0;
+    }
+    // first byte row (can be -1) and the bit offset in it
+    int brow = (y0 >= 0) ? (y0 >> 3) : -((7 - y0) >> 3);
+    int offset = y0 - (brow * 8);
+    uint8_t *b = (uint8_t*)fb->buf + brow * fb->stride;
+    for (int j = 0; j < 8; j++, x0++) {
+        if (x0 < 0 || x0 >= fb->width) {
+            continue;
+        }
+        uint32_t bits = (chr_data[j] & rows) << offset;
+        if (bits & 0xff) {
+            if (col) b[x0] |= bits;
+            else b[x0] &= ~bits;
+        }
+        if (bits >> 8) {
+            if (col) b[x0 + fb->stride] |= bits >> 8;
+            else b[x0 + fb->stride] &= ~(bits >> 8);
+        }
+    }
+}
+
+// The font columns are transposed to 8 pixel rows, set up to 2 bytes per row
+STATIC void mono_horiz_glyph(const mp_obj_framebuf_t *fb, int x0, int y0, const uint8_t *chr_data, uint32_t col) {
+    int lsb = fb->format == FRAMEBUF_MHLSB;
+    // pixel rows, for MHLSB column 0 is at bit 7, for MHMSB at bit 0
+    uint8_t rows[8] = {0};
+    for (int j = 0; j < 8; j++) {
+        if ((x0 + j < 0) || (x0 + j >= fb->width)) {
+            continue;
+        }
+        uint8_t colbit = lsb ? (0x80 >> j) : (0x01 << j);
+        for (uint vline_data = chr_data[j], i = 0; vline_data; vline_data >>= 1, i++) {
+            if (vline_data & 1) {
+                rows[i] |= colbit;
+            }
+        }
+    }
+    int offset = x0 & 7;
+    int first = (x0 - offset) >> 3; // first byte in the row, can be -1
+    for (int i = 0; i < 8; i++) {
+        int y = y0 + i;
+        if ((rows[i] == 0) || (y < 0) || (y >= fb->height)) {
+            continue;
+        }
+        uint8_t *b = (uint8_t*)fb->buf + y * (fb->stride >> 3) + first;
+        uint8_t bits0, bits1;
+        if (lsb) {
+            bits0 = rows[i] >> offset;
+            bits1 = (rows[i] << (8 - offset)) & 0xff;
+        } else {
+            bits0 = (rows[i] << offset) & 0xff;
+            bits1 = rows[i] >> (8 - offset);
+        }
+        if (bits0) {
+            if (col) b[0] |= bits0;
+            else b[0] &= ~bits0;
+        }
+        if (bits1) {
+            if (col) b[1] |= bits1;
+            else b[1] &= ~bits1;
+        }
+    }
+}
+
 STATIC mp_framebuf_p_t formats[] = {
-    [FRAMEBUF_MVLSB] = {mvlsb_setpixel, mvlsb_getpixel, mvlsb_fill_rect},
-    [FRAMEBUF_RGB565] = {rgb565_setpixel, rgb565_getpixel, rgb565_fill_rect},
-    [FRAMEBUF_GS2_HMSB] = {gs2_hmsb_setpixel, gs2_hmsb_getpixel, gs2_hmsb_fill_rect},
-    [FRAMEBUF_GS4_HMSB] = {gs4_hmsb_setpixel, gs4_hmsb_getpixel, gs4_hmsb_fill_rect},
-    [FRAMEBUF_GS8] = {gs8_setpixel, gs8_getpixel, gs8_fill_rect},
-    [FRAMEBUF_MHLSB] = {mono_horiz_setpixel, mono_horiz_getpixel, mono_horiz_fill_rect},
-    [FRAMEBUF_MHMSB] = {mono_horiz_setpixel, mono_horiz_getpixel, mono_horiz_fill_rect},
+    [FRAMEBUF_MVLSB] = {mvlsb_setpixel, mvlsb_getpixel, mvlsb_fill_rect, mvlsb_line, mvlsb_glyph, mvlsb_scroll},
+    [FRAMEBUF_RGB565] = {rgb565_setpixel, rgb565_getpixel, rgb565_fill_rect, rgb565_line, rgb565_glyph, rgb565_scroll},
+    [FRAMEBUF_GS2_HMSB] = {gs2_hmsb_setpixel, gs2_hmsb_getpixel, gs2_hmsb_fill_rect, gs2_hmsb_line, gs2_hmsb_glyph, gs2_hmsb_scroll},
+    [FRAMEBUF_GS4_HMSB] = {gs4_hmsb_setpixel, gs4_hmsb_getpixel, gs4_hmsb_fill_rect, gs4_hmsb_line, gs4_hmsb_glyph, gs4_hmsb_scroll},
+    [FRAMEBUF_GS8] = {gs8_setpixel, gs8_getpixel, gs8_fill_rect, gs8_line, gs8_glyph, gs8_scroll},
+    [FRAMEBUF_MHLSB] = {mono_horiz_setpixel, mono_horiz_getpixel, mono_horiz_fill_rect, mono_horiz_line, mono_horiz_glyph, mono_horiz_scroll},
+    [FRAMEBUF_MHMSB] = {mono_horiz_setpixel, mono_horiz_getpixel, mono_horiz_fill_rect, mono_horiz_line, mono_horiz_glyph, mono_horiz_scroll},
+    [FRAMEBUF_RGB888] = {rgb888_setpixel, rgb888_getpixel, rgb888_fill_rect, rgb888_line, rgb888_glyph, rgb888_scroll},
 };
 
 static inline void setpixel(const mp_obj_framebuf_t *fb, int x, int y, uint32_t col) {
@@ -260,6 +518,16 @@ STATIC void fill_rect(const mp_obj_framebuf_t *fb, int x, int y, int w, int h, u
     formats[fb->format].fill_rect(fb, x, y, xend - x, yend - y, col);
 }
 
+STATIC void line(const mp_obj_framebuf_t *fb, int x1, int y1, int x2, int y2, uint32_t col) {
+    if (y1 == y2) {
+        fill_rect(fb, MIN(x1, x2), y1, abs(x2 - x1) + 1, 1, col);
+    } else if (x1 == x2) {
+        fill_rect(fb, x1, MIN(y1, y2), 1, abs(y2 - y1) + 1, col);
+    } else {
+        formats[fb->format].line(fb, x1, y1, x2, y2, col);
+    }
+}
+
 STATIC mp_obj_t framebuf_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *args) {
     mp_arg_check_num(n_args, n_kw, 4, 5, false);
 
@@ -295,6 +563,7 @@ STATIC mp_obj_t framebuf_make_new(const mp_obj_type_t *type, size_t n_args, size
             o->stride = (o->stride + 1) & ~1;
             break;
         case FRAMEBUF_GS8:
+        case FRAMEBUF_RGB888:
             break;
         default:
             mp_raise_ValueError("invalid format");
@@ -307,7 +576,7 @@ STATIC mp_int_t framebuf_get_buffer(mp_obj_t self_in, mp_buffer_info_t *bufinfo,
     (void)flags;
     mp_obj_framebuf_t *self = MP_OBJ_TO_PTR(self_in);
     bufinfo->buf = self->buf;
-    bufinfo->len = self->stride * self->height * (self->format == FRAMEBUF_RGB565 ? 2 : 1);
+    bufinfo->len = self->stride * self->height * (self->format == FRAMEBUF_RGB565 ? 2 : (self->format == FRAMEBUF_RGB888 ? 3 : 1));
     bufinfo->typecode = 'B'; // view framebuf as bytes
     return 0;
 }
@@ -412,132 +681,351 @@ STATIC mp_obj_t framebuf_line(size_t n_args, const mp_obj_t *args) {
     mp_int_t y2 = mp_obj_get_int(args[4]);
     mp_int_t col = mp_obj_get_int(args[5]);
 
-    mp_int_t dx = x2 - x1;
-    mp_int_t sx;
-    if (dx > 0) {
-        sx = 1;
-    } else {
-        dx = -dx;
-        sx = -1;
+    line(self, x1, y1, x2, y2, col);
+
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(framebuf_line_obj, 6, 6, framebuf_line);
+
+// Ellipse quadrants, Q2 Q1
+//                    Q3 Q4
+#define ELLIPSE_MASK_FILL (0x10)
+#define ELLIPSE_MASK_ALL  (0x0f)
+#define ELLIPSE_MASK_Q1   (0x01)
+#define ELLIPSE_MASK_Q2   (0x02)
+#define ELLIPSE_MASK_Q3   (0x04)
+#define ELLIPSE_MASK_Q4   (0x08)
+
+STATIC void setpixel_checked(const mp_obj_framebuf_t *fb, int x, int y, uint32_t col, int mask) {
+    if (mask && 0 <= x && x < fb->width && 0 <= y && y < fb->height) {
+        setpixel(fb, x, y, col);
     }
+}
 
-    mp_int_t dy = y2 - y1;
-    mp_int_t sy;
-    if (dy > 0) {
-        sy = 1;
+STATIC void draw_ellipse_points(const mp_obj_framebuf_t *fb, int cx, int cy, int x, int y, uint32_t col, int mask) {
+    if (mask & ELLIPSE_MASK_FILL) {
+        // the left and right quadrant spans are merged into one span
+        if (y == 0) {
+            // the center row is shared by all quadrants, drawn once
+            if (mask & ELLIPSE_MASK_ALL) {
+                int xs = (mask & (ELLIPSE_MASK_Q2 | ELLIPSE_MASK_Q3)) ? cx - x : cx;
+                int xe = (mask & (ELLIPSE_MASK_Q1 | ELLIPSE_MASK_Q4)) ? cx + x : cx;
+                fill_rect(fb, xs, cy, xe - xs + 1, 1, col);
+            }
+            return;
+        }
+        if (mask & (ELLIPSE_MASK_Q1 | ELLIPSE_MASK_Q2)) {
+            int xs = (mask & ELLIPSE_MASK_Q2) ? cx - x : cx;
+            int xe = (mask & ELLIPSE_MASK_Q1) ? cx + x : cx;
+            fill_rect(fb, xs, cy - y, xe - xs + 1, 1, col);
+        }
+        if (mask & (ELLIPSE_MASK_Q3 | ELLIPSE_MASK_Q4)) {
+            int xs = (mask & ELLIPSE_MASK_Q3) ? cx - x : cx;
+            int xe = (mask & ELLIPSE_MASK_Q4) ? cx + x : cx;
+            fill_rect(fb, xs, cy + y, xe - xs + 1, 1, col);
+        }
     } else {
-        dy = -dy;
-        sy = -1;
+        setpixel_checked(fb, cx + x, cy - y, col, mask & ELLIPSE_MASK_Q1);
+        setpixel_checked(fb, cx - x, cy - y, col, mask & ELLIPSE_MASK_Q2);
+        setpixel_checked(fb, cx - x, cy + y, col, mask & ELLIPSE_MASK_Q3);
+        setpixel_checked(fb, cx + x, cy + y, col, mask & ELLIPSE_MASK_Q4);
     }
+}
 
-    bool steep;
-    if (dy > dx) {
-        mp_int_t temp;
-        temp = x1; x1 = y1; y1 = temp;
-        temp = dx; dx = dy; dy = temp;
-        temp = sx; sx = sy; sy = temp;
-        steep = true;
+STATIC mp_obj_t framebuf_ellipse(size_t n_args, const mp_obj_t *args) {
+    mp_obj_framebuf_t *self = MP_OBJ_TO_PTR(args[0]);
+    mp_int_t cx = mp_obj_get_int(args[1]);
+    mp_int_t cy = mp_obj_get_int(args[2]);
+    mp_int_t xr = mp_obj_get_int(args[3]);
+    mp_int_t yr = mp_obj_get_int(args[4]);
+    mp_int_t col = mp_obj_get_int(args[5]);
+    int mask = (n_args > 6 && mp_obj_is_true(args[6])) ? ELLIPSE_MASK_FILL : 0;
+    if (n_args > 7) {
+        mask |= mp_obj_get_int(args[7]) & ELLIPSE_MASK_ALL;
     } else {
-        steep = false;
+        mask |= ELLIPSE_MASK_ALL;
+    }
+    if ((xr < 0) || (yr < 0)) {
+        return mp_const_none;
+    }
+    if ((xr == 0) && (yr == 0)) {
+        // single pixel, the midpoint loops below would never terminate
+        draw_ellipse_points(self, cx, cy, 0, 0, col, mask);
+        return mp_const_none;
     }
 
-    mp_int_t e = 2 * dy - dx;
-    for (mp_int_t i = 0; i < dx; ++i) {
-        if (steep) {
-            if (0 <= y1 && y1 < self->width && 0 <= x1 && x1 < self->height) {
-                setpixel(self, y1, x1, col);
-            }
-        } else {
-            if (0 <= x1 && x1 < self->width && 0 <= y1 && y1 < self->height) {
-                setpixel(self, x1, y1, col);
-            }
+    // midpoint algorithm, the first region steps in y, the second in x
+    mp_int_t two_asquare = 2 * xr * xr;
+    mp_int_t two_bsquare = 2 * yr * yr;
+    mp_int_t x = xr;
+    mp_int_t y = 0;
+    mp_int_t xchange = yr * yr * (1 - 2 * xr);
+    mp_int_t ychange = xr * xr;
+    mp_int_t ellipse_error = 0;
+    mp_int_t stoppingx = two_bsquare * xr;
+    mp_int_t stoppingy = 0;
+    while (stoppingx >= stoppingy) {
+        draw_ellipse_points(self, cx, cy, x, y, col, mask);
+        y += 1;
+        stoppingy += two_asquare;
+        ellipse_error += ychange;
+        ychange += two_asquare;
+        if ((2 * ellipse_error + xchange) > 0) {
+            x -= 1;
+            stoppingx -= two_bsquare;
+            ellipse_error += xchange;
+            xchange += two_bsquare;
         }
-        while (e >= 0) {
-            y1 += sy;
-            e -= 2 * dx;
+    }
+    x = 0;
+    y = yr;
+    xchange = yr * yr;
+    ychange = xr * xr * (1 - 2 * yr);
+    ellipse_error = 0;
+    stoppingx = 0;
+    stoppingy = two_asquare * yr;
+    while (stoppingx <= stoppingy) {
+        draw_ellipse_points(self, cx, cy, x, y, col, mask);
+        x += 1;
+        stoppingx += two_bsquare;
+        ellipse_error += xchange;
+        xchange += two_bsquare;
+        if ((2 * ellipse_error + ychange) > 0) {
+            y -= 1;
+            stoppingy -= two_asquare;
+            ellipse_error += ychange;
+            ychange += two_asquare;
         }
-        x1 += sx;
-        e += 2 * dy;
     }
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(framebuf_ellipse_obj, 6, 8, framebuf_ellipse);
 
-    if (0 <= x2 && x2 < self->width && 0 <= y2 && y2 < self->height) {
-        setpixel(self, x2, y2, col);
+// Get the polygon vertex coordinate from the array (buffer protocol) or the list/tuple of integers
+STATIC mp_int_t poly_get_coord(mp_obj_t coords, mp_buffer_info_t *bufinfo, size_t idx) {
+    if (bufinfo->buf != NULL) {
+        return mp_obj_get_int(mp_binary_get_val_array(bufinfo->typecode, bufinfo->buf, idx));
     }
+    size_t len;
+    mp_obj_t *items;
+    mp_obj_get_array(coords, &len, &items);
+    return mp_obj_get_int(items[idx]);
+}
 
-    return mp_const_none;
+// Integer x of the edge (x1, y1) - (x2, y2) at y, rounded to nearest, y2 > y1
+STATIC int poly_edge_x(int x1, int y1, int x2, int y2, int y) {
+    int num = 2 * (x2 - x1) * (y - y1) + (y2 - y1);
+    int den = 2 * (y2 - y1);
+    // floor division
+    int q = num / den;
+    if ((num % den != 0) && (num < 0)) {
+        q--;
+    }
+    return x1 + q;
 }
-STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(framebuf_line_obj, 6, 6, framebuf_line);
 
-STATIC mp_obj_t framebuf_blit(size_t n_args, const mp_obj_t *args) {
+STATIC mp_obj_t framebuf_poly(size_t n_args, const mp_obj_t *args) {
     mp_obj_framebuf_t *self = MP_OBJ_TO_PTR(args[0]);
-    mp_obj_framebuf_t *source = MP_OBJ_TO_PTR(args[1]);
-    mp_int_t x = mp_obj_get_int(args[2]);
-    mp_int_t y = mp_obj_get_int(args[3]);
-    mp_int_t key = -1;
-    if (n_args > 4) {
-        key = mp_obj_get_int(args[4]);
-    }
-
-    if (
-        (x >= self->width) ||
-        (y >= self->height) ||
-        (-x >= source->width) ||
-        (-y >= source->height)
-    ) {
-        // Out of bounds, no-op.
+    mp_int_t x = mp_obj_get_int(args[1]);
+    mp_int_t y = mp_obj_get_int(args[2]);
+    mp_obj_t coords = args[3];
+    mp_int_t col = mp_obj_get_int(args[4]);
+    bool fill = (n_args > 5) && mp_obj_is_true(args[5]);
+
+    mp_buffer_info_t bufinfo = { .buf = NULL };
+    size_t n_coords;
+    if (mp_get_buffer(coords, &bufinfo, MP_BUFFER_READ)) {
+        n_coords = bufinfo.len / mp_binary_get_size('@', bufinfo.typecode, NULL);
+    } else {
+        mp_obj_t *items;
+        mp_obj_get_array(coords, &n_coords, &items);
+    }
+    size_t n_poly = n_coords / 2;
+    if (n_poly == 0) {
         return mp_const_none;
     }
 
-    // Clip.
-    int x0 = MAX(0, x);
-    int y0 = MAX(0, y);
-    int x1 = MAX(0, -x);
-    int y1 = MAX(0, -y);
-    int x0end = MIN(self->width, x + source->width);
-    int y0end = MIN(self->height, y + source->height);
-
-    for (; y0 < y0end; ++y0) {
-        int cx1 = x1;
-        for (int cx0 = x0; cx0 < x0end; ++cx0) {
-            uint32_t col = getpixel(source, cx1, y1);
-            if (col != (uint32_t)key) {
-                setpixel(self, cx0, y0, col);
+    // the vertices are copied to simplify the access
+    int *pts = m_new(int, n_poly * 2);
+    int y_min = INT_MAX, y_max = INT_MIN;
+    for (size_t i = 0; i < n_poly; i++) {
+        pts[i * 2] = x + poly_get_coord(coords, &bufinfo, i * 2);
+        pts[i * 2 + 1] = y + poly_get_coord(coords, &bufinfo, i * 2 + 1);
+        y_min = MIN(y_min, pts[i * 2 + 1]);
+        y_max = MAX(y_max, pts[i * 2 + 1]);
+    }
+
+    if (fill) {
+        // scan line fill, even-odd rule; the edges include the upper and exclude the lower end point
+        y_min = MAX(y_min, 0);
+        y_max = MIN(y_max, self->height - 1);
+        int *nodes = m_new(int, n_poly);
+        for (int row = y_min; row <= y_max; row++) {
+            int n_nodes = 0;
+            for (size_t i = 0; i < n_poly; i++) {
+                size_t j = (i + 1) % n_poly;
+                int x1 = pts[i * 2], y1 = pts[i * 2 + 1];
+                int x2 = pts[j * 2], y2 = pts[j * 2 + 1];
+                if (y1 > y2) {
+                    int t = x1; x1 = x2; x2 = t;
+                    t = y1; y1 = y2; y2 = t;
+                }
+                if ((y1 <= row) && (row < y2)) {
+                    // insert sorted
+                    int node = poly_edge_x(x1, y1, x2, y2, row);
+                    int k = n_nodes++;
+                    while ((k > 0) && (nodes[k - 1] > node)) {
+                        nodes[k] = nodes[k - 1];
+                        k--;
+                    }
+                    nodes[k] = node;
+                }
+            }
+            for (int i = 0; i + 1 < n_nodes; i += 2) {
+                fill_rect(self, nodes[i], row, nodes[i + 1] - nodes[i] + 1, 1, col);
             }
-            ++cx1;
         }
-        ++y1;
+        m_del(int, nodes, n_poly);
+    }
+
+    // the outline, also drawn when filled so the fill covers the same pixels as the outline
+    for (size_t i = 0; i < n_poly; i++) {
+        size_t j = (i + 1) % n_poly;
+        line(self, pts[i * 2], pts[i * 2 + 1], pts[j * 2], pts[j * 2 + 1], col);
+    }
+    m_del(int, pts, n_poly * 2);
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(framebuf_poly_obj, 5, 6, framebuf_poly);
+
+// Get the blitter surface of the FrameBuffer object, returns -1 if the object is not a FrameBuffer
+int mp_framebuf_get_surface(const void *obj, fb_surface_t *surface) {
+    mp_obj_t fb_obj = (mp_obj_t)obj;
+    if (!MP_OBJ_IS_TYPE(fb_obj, &mp_type_framebuf)) {
+        // FrameBuffer subclass (display drivers)
+        fb_obj = mp_instance_cast_to_native_base(fb_obj, MP_OBJ_FROM_PTR(&mp_type_framebuf));
+        if (fb_obj == MP_OBJ_NULL) {
+            return -1;
+        }
     }
+    const mp_obj_framebuf_t *fb = MP_OBJ_TO_PTR(fb_obj);
+    surface->buf = fb->buf;
+    surface->width = fb->width;
+    surface->height = fb->height;
+    surface->stride = fb->stride;
+    surface->format = fb->format;
+    return 0;
+}
+
+STATIC mp_obj_t framebuf_blit(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    enum { ARG_fbuf, ARG_x, ARG_y, ARG_key, ARG_palette, ARG_alpha, ARG_scale, ARG_convert };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_fbuf,    MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+        { MP_QSTR_x,       MP_ARG_REQUIRED | MP_ARG_INT, {.u_int = 0} },
+        { MP_QSTR_y,       MP_ARG_REQUIRED | MP_ARG_INT, {.u_int = 0} },
+        { MP_QSTR_key,                       MP_ARG_INT, {.u_int = -1} },
+        { MP_QSTR_palette,                   MP_ARG_OBJ, {.u_obj = mp_const_none} },
+        { MP_QSTR_alpha,                     MP_ARG_INT, {.u_int = 255} },
+        { MP_QSTR_scale,                     MP_ARG_INT, {.u_int = 1} },
+        { MP_QSTR_convert,  MP_ARG_KW_ONLY | MP_ARG_BOOL, {.u_bool = false} },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    fb_surface_t dst, src, palette;
+    mp_framebuf_get_surface(pos_args[0], &dst);
+    if (mp_framebuf_get_surface(args[ARG_fbuf].u_obj, &src) != 0) {
+        mp_raise_TypeError("FrameBuffer expected");
+    }
+    // the source pixel values are the palette indexes, the palette pixels (of the first row) are drawn
+    if ((args[ARG_palette].u_obj != mp_const_none) && (mp_framebuf_get_surface(args[ARG_palette].u_obj, &palette) != 0)) {
+        mp_raise_TypeError("FrameBuffer expected");
+    }
+    if ((args[ARG_scale].u_int < 1) || (args[ARG_scale].u_int > FB_BLIT_MAX_SCALE)) {
+        mp_raise_ValueError("invalid scale");
+    }
+
+    // the source is processed in format specialised row chunks, see framebuf_blit.c
+    fb_blit(&dst, &src, (args[ARG_palette].u_obj != mp_const_none) ? &palette : NULL,
+            args[ARG_x].u_int, args[ARG_y].u_int, args[ARG_key].u_int, args[ARG_alpha].u_int, args[ARG_scale].u_int,
+            args[ARG_convert].u_bool);
     return mp_const_none;
 }
-STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(framebuf_blit_obj, 4, 5, framebuf_blit);
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(framebuf_blit_obj, 4, framebuf_blit);
+
+// Bits per pixel of the formats with pixels stored in rows
+STATIC const uint8_t row_bits[] = {
+    [FRAMEBUF_MVLSB] = 0,
+    [FRAMEBUF_RGB565] = 16,
+    [FRAMEBUF_GS2_HMSB] = 2,
+    [FRAMEBUF_GS4_HMSB] = 4,
+    [FRAMEBUF_GS8] = 8,
+    [FRAMEBUF_MHLSB] = 1,
+    [FRAMEBUF_MHMSB] = 1,
+    [FRAMEBUF_RGB888] = 24,
+};
 
 STATIC mp_obj_t framebuf_scroll(mp_obj_t self_in, mp_obj_t xstep_in, mp_obj_t ystep_in) {
     mp_obj_framebuf_t *self = MP_OBJ_TO_PTR(self_in);
     mp_int_t xstep = mp_obj_get_int(xstep_in);
     mp_int_t ystep = mp_obj_get_int(ystep_in);
-    int sx, y, xend, yend, dx, dy;
-    if (xstep < 0) {
-        sx = 0;
-        xend = self->width + xstep;
-        dx = 1;
-    } else {
-        sx = self->width - 1;
-        xend = xstep - 1;
-        dx = -1;
-    }
-    if (ystep < 0) {
-        y = 0;
-        yend = self->height + ystep;
-        dy = 1;
-    } else {
-        y = self->height - 1;
-        yend = ystep - 1;
-        dy = -1;
+    if ((xstep <= -self->width) || (xstep >= self->width) || (ystep <= -self->height) || (ystep >= self->height)) {
+        // no pixel is moved inside the frame buffer
+        return mp_const_none;
     }
-    for (; y != yend; y += dy) {
-        for (int x = sx; x != xend; x += dx) {
-            setpixel(self, x, y, getpixel(self, x - xstep, y - ystep));
+    int bits = row_bits[self->format];
+    uint8_t *buf = (uint8_t*)self->buf;
+    // the rows are processed in the direction which reads each row before it is overwritten
+    int y = (ystep > 0) ? self->height - 1 : 0;
+    int yend = (ystep > 0) ? ystep - 1 : self->height + ystep;
+    int dy = (ystep > 0) ? -1 : 1;
+    int dst_x = MAX(xstep, 0);
+    int len = self->width - abs(xstep);
+
+    if ((bits) && (((xstep * bits) & 7) == 0)) {
+        // the row moves by whole bytes: move the bytes, the pixels of a partial last byte by pixel
+        int row_bytes = (self->stride * bits) >> 3;
+        int nbytes = (len * bits) >> 3;
+        int tail = len - ((nbytes << 3) / bits);
+        for (; y != yend; y += dy) {
+            uint8_t *row = buf + (y * row_bytes);
+            // when moving right, the tail pixels must be moved before their source is overwritten
+            for (int x = dst_x + len - 1; (xstep > 0) && (x >= dst_x + len - tail); x--) {
+                setpixel(self, x, y, getpixel(self, x - xstep, y - ystep));
+            }
+            memmove(row + ((dst_x * bits) >> 3), row - (ystep * row_bytes) + (((dst_x - xstep) * bits) >> 3), nbytes);
+            for (int x = dst_x + len - tail; (xstep <= 0) && (x < dst_x + len); x++) {
+                setpixel(self, x, y, getpixel(self, x - xstep, y - ystep));
+            }
         }
+    } else if ((self->format == FRAMEBUF_MVLSB) && ((ystep & 7) == 0)) {
+        // 8 rows are stored in a byte row, move the byte rows
+        // only the last byte row can be partially inside the moved area
+        int brows = (self->height + 7) >> 3;
+        int br = (ystep > 0) ? brows - 1 : 0;
+        int brend = (ystep > 0) ? (ystep >> 3) - 1 : brows + (ystep >> 3);
+        int yhi = self->height + MIN(ystep, 0);
+        for (; br != brend; br += dy) {
+            uint8_t *row = buf + (br * self->stride) + dst_x;
+            uint8_t *src = row - ((ystep >> 3) * self->stride) - xstep;
+            uint8_t mask = 0xff;
+            if ((br * 8 + 8) > yhi) {
+                mask >>= (br * 8 + 8) - yhi;
+            }
+            if (mask == 0xff) {
+                memmove(row, src, len);
+            } else if (xstep > 0) {
+                for (int i = len - 1; i >= 0; i--) {
+                    row[i] = (row[i] & ~mask) | (src[i] & mask);
+                }
+            } else {
+                for (int i = 0; i < len; i++) {
+                    row[i] = (row[i] & ~mask) | (src[i] & mask);
+                }
+            }
+        }
+    } else {
+        formats[self->format].scroll(self, xstep, ystep);
     }
     return mp_const_none;
 }
@@ -561,21 +1049,11 @@ STATIC mp_obj_t framebuf_text(size_t n_args, const mp_obj_t *args) {
         if (chr < 32 || chr > 127) {
             chr = 127;
         }
-        // get char data
-        const uint8_t *chr_data = &font_petme128_8x8[(chr - 32) * 8];
-        // loop over char data
-        for (int j = 0; j < 8; j++, x0++) {
-            if (0 <= x0 && x0 < self->width) { // clip x
-                uint vline_data = chr_data[j]; // each byte is a column of 8 pixels, LSB at top
-                for (int y = y0; vline_data; vline_data >>= 1, y++) { // scan over vertical column
-                    if (vline_data & 1) { // only draw if pixel set
-                        if (0 <= y && y < self->height) { // clip y
-                            setpixel(self, x0, y, col);
-                        }
-                    }
-                }
-            }
+        // draw the char if it is in the frame buffer
+        if ((x0 > -8) && (x0 < self->width) && (y0 > -8) && (y0 < self->height)) {
+            formats[self->format].glyph(self, x0, y0, &font_petme128_8x8[(chr - 32) * 8], col);
         }
+        x0 += 8;
     }
     return mp_const_none;
 }
@@ -589,6 +1067,8 @@ STATIC const mp_rom_map_elem_t framebuf_locals_dict_table[] = {
     { MP_ROM_QSTR(MP_QSTR_vline), MP_ROM_PTR(&framebuf_vline_obj) },
     { MP_ROM_QSTR(MP_QSTR_rect), MP_ROM_PTR(&framebuf_rect_obj) },
     { MP_ROM_QSTR(MP_QSTR_line), MP_ROM_PTR(&framebuf_line_obj) },
+    { MP_ROM_QSTR(MP_QSTR_ellipse), MP_ROM_PTR(&framebuf_ellipse_obj) },
+    { MP_ROM_QSTR(MP_QSTR_poly), MP_ROM_PTR(&framebuf_poly_obj) },
     { MP_ROM_QSTR(MP_QSTR_blit), MP_ROM_PTR(&framebuf_blit_obj) },
     { MP_ROM_QSTR(MP_QSTR_scroll), MP_ROM_PTR(&framebuf_scroll_obj) },
     { MP_ROM_QSTR(MP_QSTR_text), MP_ROM_PTR(&framebuf_text_obj) },
@@ -637,6 +1117,7 @@ STATIC const mp_rom_map_elem_t framebuf_module_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR_GS8), MP_ROM_INT(FRAMEBUF_GS8) },
     { MP_ROM_QSTR(MP_QSTR_MONO_HLSB), MP_ROM_INT(FRAMEBUF_MHLSB) },
     { MP_ROM_QSTR(MP_QSTR_MONO_HMSB), MP_ROM_INT(FRAMEBUF_MHMSB) },
+    { MP_ROM_QSTR(MP_QSTR_RGB888), MP_ROM_INT(FRAMEBUF_RGB888) },
 };
 
 STATIC MP_DEFINE_CONST_DICT(framebuf_module_globals, framebuf_module_globals_table);
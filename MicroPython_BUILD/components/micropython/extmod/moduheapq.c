@@ -4,6 +4,7 @@
  * The MIT License (MIT)
  *
  * Copyright (c) 2014 Damien P. George
+ * Copyright (c) 2018 LoBo (https://github.com/loboris)
  *
  * Permission is hereby granted, free of charge, to any person obtaining a copy
  * of this software and associated documentation files (the "Software"), to deal
@@ -24,13 +25,86 @@
  * THE SOFTWARE.
  */
 
+#include <string.h>
+
 #include "py/objlist.h"
+#include "py/objtuple.h"
 #include "py/runtime.h"
 
 #if MICROPY_PY_UHEAPQ
 
 // the algorithm here is modelled on CPython's heapq.py
 
+#if MICROPY_PY_BUILTINS_FLOAT
+STATIC bool heap_get_float(mp_obj_t o, mp_float_t *f) {
+    if (MP_OBJ_IS_SMALL_INT(o)) {
+        *f = (mp_float_t)MP_OBJ_SMALL_INT_VALUE(o);
+    } else if (mp_obj_is_float(o)) {
+        *f = mp_obj_float_get(o);
+    } else {
+        return false;
+    }
+    return true;
+}
+#endif
+
+// Compare small ints and floats without mp_binary_op.  Returns -1, 0 or 1,
+// or 2 if a or b is not such a number or they are unordered (nan).
+STATIC int heap_num_cmp(mp_obj_t a, mp_obj_t b) {
+    if (MP_OBJ_IS_SMALL_INT(a) && MP_OBJ_IS_SMALL_INT(b)) {
+        mp_int_t x = MP_OBJ_SMALL_INT_VALUE(a);
+        mp_int_t y = MP_OBJ_SMALL_INT_VALUE(b);
+        return (x > y) - (x < y);
+    }
+    #if MICROPY_PY_BUILTINS_FLOAT
+    mp_float_t x, y;
+    if (heap_get_float(a, &x) && heap_get_float(b, &y)) {
+        if (x < y) {
+            return -1;
+        } else if (x > y) {
+            return 1;
+        } else if (x == y) {
+            return 0;
+        }
+    }
+    #endif
+    return 2;
+}
+
+STATIC bool heap_lt(mp_obj_t a, mp_obj_t b) {
+    int c = heap_num_cmp(a, b);
+    if (c != 2) {
+        return c < 0;
+    }
+    // heap entries are usually (priority, ...) tuples or lists, if the
+    // priorities are different numbers they decide
+    if ((MP_OBJ_IS_TYPE(a, &mp_type_tuple) && MP_OBJ_IS_TYPE(b, &mp_type_tuple))
+        || (MP_OBJ_IS_TYPE(a, &mp_type_list) && MP_OBJ_IS_TYPE(b, &mp_type_list))) {
+        size_t a_len, b_len;
+        mp_obj_t *a_items, *b_items;
+        mp_obj_get_array(a, &a_len, &a_items);
+        mp_obj_get_array(b, &b_len, &b_items);
+        if (a_len && b_len) {
+            c = heap_num_cmp(a_items[0], b_items[0]);
+            if (c == -1 || c == 1) {
+                return c < 0;
+            }
+        }
+    }
+    return mp_obj_is_true(mp_binary_op(MP_BINARY_OP_LESS, a, b));
+}
+
+STATIC int heap_cmp(mp_obj_t a, mp_obj_t b) {
+    int c = heap_num_cmp(a, b);
+    if (c != 2) {
+        return c;
+    }
+    if (heap_lt(a, b)) {
+        return -1;
+    }
+    return heap_lt(b, a);
+}
+
 STATIC mp_obj_list_t *get_heap(mp_obj_t heap_in) {
     if (!MP_OBJ_IS_TYPE(heap_in, &mp_type_list)) {
         mp_raise_TypeError("heap must be a list");
@@ -43,7 +117,7 @@ STATIC void heap_siftdown(mp_obj_list_t *heap, mp_uint_t start_pos, mp_uint_t po
     while (pos > start_pos) {
         mp_uint_t parent_pos = (pos - 1) >> 1;
         mp_obj_t parent = heap->items[parent_pos];
-        if (mp_binary_op(MP_BINARY_OP_LESS, item, parent) == mp_const_true) {
+        if (heap_lt(item, parent)) {
             heap->items[pos] = parent;
             pos = parent_pos;
         } else {
@@ -59,7 +133,7 @@ STATIC void heap_siftup(mp_obj_list_t *heap, mp_uint_t pos) {
     mp_obj_t item = heap->items[pos];
     for (mp_uint_t child_pos = 2 * pos + 1; child_pos < end_pos; child_pos = 2 * pos + 1) {
         // choose right child if it's <= left child
-        if (child_pos + 1 < end_pos && mp_binary_op(MP_BINARY_OP_LESS, heap->items[child_pos], heap->items[child_pos + 1]) == mp_const_false) {
+        if (child_pos + 1 < end_pos && !heap_lt(heap->items[child_pos], heap->items[child_pos + 1])) {
             child_pos += 1;
         }
         // bubble up the smaller child
@@ -94,6 +168,32 @@ STATIC mp_obj_t mod_uheapq_heappop(mp_obj_t heap_in) {
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_1(mod_uheapq_heappop_obj, mod_uheapq_heappop);
 
+// pop and return the smallest item, then push item; the heap size doesn't change
+STATIC mp_obj_t mod_uheapq_heapreplace(mp_obj_t heap_in, mp_obj_t item) {
+    mp_obj_list_t *heap = get_heap(heap_in);
+    if (heap->len == 0) {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_IndexError, "empty heap"));
+    }
+    mp_obj_t ret = heap->items[0];
+    heap->items[0] = item;
+    heap_siftup(heap, 0);
+    return ret;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(mod_uheapq_heapreplace_obj, mod_uheapq_heapreplace);
+
+// push item, then pop and return the smallest item
+STATIC mp_obj_t mod_uheapq_heappushpop(mp_obj_t heap_in, mp_obj_t item) {
+    mp_obj_list_t *heap = get_heap(heap_in);
+    if (heap->len && heap_lt(heap->items[0], item)) {
+        mp_obj_t ret = heap->items[0];
+        heap->items[0] = item;
+        heap_siftup(heap, 0);
+        return ret;
+    }
+    return item;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(mod_uheapq_heappushpop_obj, mod_uheapq_heappushpop);
+
 STATIC mp_obj_t mod_uheapq_heapify(mp_obj_t heap_in) {
     mp_obj_list_t *heap = get_heap(heap_in);
     for (mp_uint_t i = heap->len / 2; i > 0;) {
@@ -103,11 +203,225 @@ STATIC mp_obj_t mod_uheapq_heapify(mp_obj_t heap_in) {
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_1(mod_uheapq_heapify_obj, mod_uheapq_heapify);
 
+/******************************************************************************/
+// Heaps of (key, value) entries for nsmallest, nlargest and merge.
+// The order number of an entry decides between equal keys, so the results
+// are stable like those of sorted().
+
+#define ENTRY_KEY_DESC      (1)
+#define ENTRY_ORDER_DESC    (2)
+
+typedef struct _heap_entry_t {
+    mp_obj_t key;
+    mp_obj_t value;
+    mp_obj_t iter;
+    size_t order;
+} heap_entry_t;
+
+STATIC bool entry_lt(const heap_entry_t *a, const heap_entry_t *b, unsigned flags) {
+    int c = heap_cmp(a->key, b->key);
+    if (c == 0) {
+        return (flags & ENTRY_ORDER_DESC) ? a->order > b->order : a->order < b->order;
+    }
+    return (flags & ENTRY_KEY_DESC) ? c > 0 : c < 0;
+}
+
+STATIC void entry_siftdown(heap_entry_t *heap, size_t pos, unsigned flags) {
+    heap_entry_t item = heap[pos];
+    while (pos > 0) {
+        size_t parent_pos = (pos - 1) >> 1;
+        if (!entry_lt(&item, &heap[parent_pos], flags)) {
+            break;
+        }
+        heap[pos] = heap[parent_pos];
+        pos = parent_pos;
+    }
+    heap[pos] = item;
+}
+
+STATIC void entry_siftup(heap_entry_t *heap, size_t len, size_t pos, unsigned flags) {
+    heap_entry_t item = heap[pos];
+    for (size_t child_pos = 2 * pos + 1; child_pos < len; child_pos = 2 * pos + 1) {
+        if (child_pos + 1 < len && entry_lt(&heap[child_pos + 1], &heap[child_pos], flags)) {
+            child_pos += 1;
+        }
+        if (!entry_lt(&heap[child_pos], &item, flags)) {
+            break;
+        }
+        heap[pos] = heap[child_pos];
+        pos = child_pos;
+    }
+    heap[pos] = item;
+}
+
+// The n best items are kept in a heap with the worst one at the top, which
+// is replaced by every better item; at the end the heap is emptied from the
+// top into the result list, from its end.
+STATIC mp_obj_t heap_nbest(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args, unsigned flags) {
+    enum { ARG_n, ARG_iterable, ARG_key };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_n, MP_ARG_REQUIRED | MP_ARG_INT, {.u_int = 0} },
+        { MP_QSTR_iterable, MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+        { MP_QSTR_key, MP_ARG_OBJ, {.u_obj = mp_const_none} },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    mp_obj_t key_fn = args[ARG_key].u_obj;
+    mp_int_t n = args[ARG_n].u_int;
+    if (n <= 0) {
+        return mp_obj_new_list(0, NULL);
+    }
+    mp_obj_t len_in = mp_obj_len_maybe(args[ARG_iterable].u_obj);
+    if (len_in != MP_OBJ_NULL && MP_OBJ_SMALL_INT_VALUE(len_in) < n) {
+        n = MP_OBJ_SMALL_INT_VALUE(len_in);
+    }
+    // grow the heap as items come, n may be much more than there are
+    size_t alloc = n < 16 ? n : 16;
+    heap_entry_t *heap = m_new(heap_entry_t, alloc);
+    size_t len = 0;
+    size_t order = 0;
+
+    mp_obj_iter_buf_t iter_buf;
+    mp_obj_t iterable = mp_getiter(args[ARG_iterable].u_obj, &iter_buf);
+    mp_obj_t item;
+    while ((item = mp_iternext(iterable)) != MP_OBJ_STOP_ITERATION) {
+        heap_entry_t e = {
+            .key = (key_fn == mp_const_none) ? item : mp_call_function_1(key_fn, item),
+            .value = item,
+            .iter = MP_OBJ_NULL,
+            .order = order++,
+        };
+        if (len < (size_t)n) {
+            if (len == alloc) {
+                size_t new_alloc = (alloc * 2 < (size_t)n) ? alloc * 2 : (size_t)n;
+                heap = m_renew(heap_entry_t, heap, alloc, new_alloc);
+                alloc = new_alloc;
+            }
+            heap[len] = e;
+            entry_siftdown(heap, len++, flags);
+        } else if (entry_lt(&heap[0], &e, flags)) {
+            heap[0] = e;
+            entry_siftup(heap, len, 0, flags);
+        }
+    }
+
+    mp_obj_list_t *res = MP_OBJ_TO_PTR(mp_obj_new_list(len, NULL));
+    while (len) {
+        res->items[len - 1] = heap[0].value;
+        heap[0] = heap[--len];
+        entry_siftup(heap, len, 0, flags);
+    }
+    m_del(heap_entry_t, heap, alloc);
+    return MP_OBJ_FROM_PTR(res);
+}
+
+// same as sorted(iterable, key=key)[:n]
+STATIC mp_obj_t mod_uheapq_nsmallest(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    return heap_nbest(n_args, pos_args, kw_args, ENTRY_KEY_DESC | ENTRY_ORDER_DESC);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(mod_uheapq_nsmallest_obj, 2, mod_uheapq_nsmallest);
+
+// same as sorted(iterable, key=key, reverse=True)[:n]
+STATIC mp_obj_t mod_uheapq_nlargest(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    return heap_nbest(n_args, pos_args, kw_args, ENTRY_ORDER_DESC);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(mod_uheapq_nlargest_obj, 2, mod_uheapq_nlargest);
+
+// merge iterator, the heap holds the next item of every iterable that is not exhausted
+typedef struct _mp_obj_heap_merge_t {
+    mp_obj_base_t base;
+    mp_fun_1_t iternext;
+    mp_obj_t key;
+    unsigned flags;
+    bool started;
+    size_t len;
+    heap_entry_t heap[];
+} mp_obj_heap_merge_t;
+
+STATIC mp_obj_t heap_merge_key(mp_obj_heap_merge_t *self, mp_obj_t item) {
+    return (self->key == mp_const_none) ? item : mp_call_function_1(self->key, item);
+}
+
+STATIC mp_obj_t heap_merge_iternext(mp_obj_t self_in) {
+    mp_obj_heap_merge_t *self = MP_OBJ_TO_PTR(self_in);
+    if (!self->started) {
+        // the iterables are read from the first call, like a generator does;
+        // if this raises the iterator is exhausted
+        size_t n_iter = self->len;
+        size_t n = 0;
+        self->started = true;
+        self->len = 0;
+        for (size_t i = 0; i < n_iter; i++) {
+            heap_entry_t *e = &self->heap[i];
+            mp_obj_t item = mp_iternext(e->iter);
+            if (item != MP_OBJ_STOP_ITERATION) {
+                self->heap[n].key = heap_merge_key(self, item);
+                self->heap[n].value = item;
+                self->heap[n].iter = e->iter;
+                self->heap[n].order = e->order;
+                n++;
+            }
+        }
+        for (size_t i = n / 2; i > 0;) {
+            entry_siftup(self->heap, n, --i, self->flags);
+        }
+        self->len = n;
+    }
+    if (self->len == 0) {
+        return MP_OBJ_STOP_ITERATION;
+    }
+    heap_entry_t *top = &self->heap[0];
+    mp_obj_t ret = top->value;
+    mp_obj_t item = mp_iternext(top->iter);
+    if (item == MP_OBJ_STOP_ITERATION) {
+        *top = self->heap[--self->len];
+        // so we don't retain the pointers
+        memset(&self->heap[self->len], 0, sizeof(heap_entry_t));
+    } else {
+        top->key = heap_merge_key(self, item);
+        top->value = item;
+    }
+    entry_siftup(self->heap, self->len, 0, self->flags);
+    return ret;
+}
+
+STATIC mp_obj_t mod_uheapq_merge(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    enum { ARG_key, ARG_reverse };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_key, MP_ARG_KW_ONLY | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+        { MP_QSTR_reverse, MP_ARG_KW_ONLY | MP_ARG_BOOL, {.u_bool = false} },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(0, NULL, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    mp_obj_heap_merge_t *o = m_new_obj_var(mp_obj_heap_merge_t, heap_entry_t, n_args);
+    o->base.type = &mp_type_polymorph_iter;
+    o->iternext = heap_merge_iternext;
+    o->key = args[ARG_key].u_obj;
+    o->flags = args[ARG_reverse].u_bool ? ENTRY_KEY_DESC : 0;
+    o->started = false;
+    o->len = n_args;
+    for (size_t i = 0; i < n_args; i++) {
+        o->heap[i].key = MP_OBJ_NULL;
+        o->heap[i].value = MP_OBJ_NULL;
+        o->heap[i].iter = mp_getiter(pos_args[i], NULL);
+        o->heap[i].order = i;
+    }
+    return MP_OBJ_FROM_PTR(o);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(mod_uheapq_merge_obj, 0, mod_uheapq_merge);
+
 STATIC const mp_rom_map_elem_t mp_module_uheapq_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR___name__), MP_ROM_QSTR(MP_QSTR_uheapq) },
     { MP_ROM_QSTR(MP_QSTR_heappush), MP_ROM_PTR(&mod_uheapq_heappush_obj) },
     { MP_ROM_QSTR(MP_QSTR_heappop), MP_ROM_PTR(&mod_uheapq_heappop_obj) },
     { MP_ROM_QSTR(MP_QSTR_heapify), MP_ROM_PTR(&mod_uheapq_heapify_obj) },
+    { MP_ROM_QSTR(MP_QSTR_heapreplace), MP_ROM_PTR(&mod_uheapq_heapreplace_obj) },
+    { MP_ROM_QSTR(MP_QSTR_heappushpop), MP_ROM_PTR(&mod_uheapq_heappushpop_obj) },
+    { MP_ROM_QSTR(MP_QSTR_nsmallest), MP_ROM_PTR(&mod_uheapq_nsmallest_obj) },
+    { MP_ROM_QSTR(MP_QSTR_nlargest), MP_ROM_PTR(&mod_uheapq_nlargest_obj) },
+    { MP_ROM_QSTR(MP_QSTR_merge), MP_ROM_PTR(&mod_uheapq_merge_obj) },
 };
 
 STATIC MP_DEFINE_CONST_DICT(mp_module_uheapq_globals, mp_module_uheapq_globals_table);
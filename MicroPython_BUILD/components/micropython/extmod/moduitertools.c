@@ -0,0 +1,689 @@
+/*
+ * This file is part of the MicroPython ESP32 project, https://github.com/loboris/MicroPython_ESP32_psRAM_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "py/objlist.h"
+#include "py/objtuple.h"
+#include "py/runtime.h"
+
+#if MICROPY_PY_UITERTOOLS
+
+// The iterators keep the iterator of their source in an iter_buf inside the
+// object, so iterating over a list, tuple, str or range doesn't allocate
+// a separate iterator object.
+
+#define ITER_UNBOUNDED ((size_t)-1)
+
+STATIC size_t get_index(mp_obj_t o, size_t none_value) {
+    if (o == mp_const_none) {
+        return none_value;
+    }
+    mp_int_t i = mp_obj_get_int(o);
+    if (i < 0) {
+        mp_raise_ValueError("index must be None or non-negative int");
+    }
+    return i;
+}
+
+/******************************************************************************/
+// count(start=0, step=1)
+
+typedef struct _mp_obj_count_t {
+    mp_obj_base_t base;
+    mp_obj_t cur;
+    mp_obj_t step;
+} mp_obj_count_t;
+
+STATIC mp_obj_t count_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *args) {
+    mp_arg_check_num(n_args, n_kw, 0, 2, false);
+    mp_obj_count_t *o = m_new_obj(mp_obj_count_t);
+    o->base.type = type;
+    o->cur = n_args > 0 ? args[0] : MP_OBJ_NEW_SMALL_INT(0);
+    o->step = n_args > 1 ? args[1] : MP_OBJ_NEW_SMALL_INT(1);
+    return MP_OBJ_FROM_PTR(o);
+}
+
+STATIC mp_obj_t count_iternext(mp_obj_t self_in) {
+    mp_obj_count_t *self = MP_OBJ_TO_PTR(self_in);
+    mp_obj_t ret = self->cur;
+    self->cur = mp_binary_op(MP_BINARY_OP_ADD, self->cur, self->step);
+    return ret;
+}
+
+STATIC const mp_obj_type_t itertools_count_type = {
+    { &mp_type_type },
+    .name = MP_QSTR_count,
+    .make_new = count_make_new,
+    .getiter = mp_identity_getiter,
+    .iternext = count_iternext,
+};
+
+/******************************************************************************/
+// cycle(iterable), the items of the first pass are saved for the next ones
+
+typedef struct _mp_obj_cycle_t {
+    mp_obj_base_t base;
+    mp_obj_t iter;
+    mp_obj_t saved;
+    size_t index;
+    mp_obj_iter_buf_t iter_buf;
+} mp_obj_cycle_t;
+
+STATIC mp_obj_t cycle_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *args) {
+    mp_arg_check_num(n_args, n_kw, 1, 1, false);
+    mp_obj_cycle_t *o = m_new_obj(mp_obj_cycle_t);
+    o->base.type = type;
+    o->iter = mp_getiter(args[0], &o->iter_buf);
+    o->saved = mp_obj_new_list(0, NULL);
+    o->index = 0;
+    return MP_OBJ_FROM_PTR(o);
+}
+
+STATIC mp_obj_t cycle_iternext(mp_obj_t self_in) {
+    mp_obj_cycle_t *self = MP_OBJ_TO_PTR(self_in);
+    if (self->iter != MP_OBJ_NULL) {
+        mp_obj_t item = mp_iternext(self->iter);
+        if (item != MP_OBJ_STOP_ITERATION) {
+            mp_obj_list_append(self->saved, item);
+            return item;
+        }
+        self->iter = MP_OBJ_NULL;
+    }
+    mp_obj_list_t *saved = MP_OBJ_TO_PTR(self->saved);
+    if (saved->len == 0) {
+        return MP_OBJ_STOP_ITERATION;
+    }
+    if (self->index >= saved->len) {
+        self->index = 0;
+    }
+    return saved->items[self->index++];
+}
+
+STATIC const mp_obj_type_t itertools_cycle_type = {
+    { &mp_type_type },
+    .name = MP_QSTR_cycle,
+    .make_new = cycle_make_new,
+    .getiter = mp_identity_getiter,
+    .iternext = cycle_iternext,
+};
+
+/******************************************************************************/
+// chain(*iterables), chain.from_iterable(iterable)
+
+typedef struct _mp_obj_chain_t {
+    mp_obj_base_t base;
+    mp_obj_t source;    // iterator over the iterables
+    mp_obj_t cur;       // iterator of the current iterable, MP_OBJ_NULL between them
+    mp_obj_iter_buf_t source_buf;
+    mp_obj_iter_buf_t cur_buf;
+} mp_obj_chain_t;
+
+STATIC mp_obj_t chain_new(const mp_obj_type_t *type, mp_obj_t iterables) {
+    mp_obj_chain_t *o = m_new_obj(mp_obj_chain_t);
+    o->base.type = type;
+    o->source = mp_getiter(iterables, &o->source_buf);
+    o->cur = MP_OBJ_NULL;
+    return MP_OBJ_FROM_PTR(o);
+}
+
+STATIC mp_obj_t chain_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *args) {
+    mp_arg_check_num(n_args, n_kw, 0, MP_OBJ_FUN_ARGS_MAX, false);
+    return chain_new(type, mp_obj_new_tuple(n_args, args));
+}
+
+STATIC mp_obj_t chain_iternext(mp_obj_t self_in) {
+    mp_obj_chain_t *self = MP_OBJ_TO_PTR(self_in);
+    for (;;) {
+        if (self->cur == MP_OBJ_NULL) {
+            mp_obj_t iterable = mp_iternext(self->source);
+            if (iterable == MP_OBJ_STOP_ITERATION) {
+                return MP_OBJ_STOP_ITERATION;
+            }
+            self->cur = mp_getiter(iterable, &self->cur_buf);
+        }
+        mp_obj_t item = mp_iternext(self->cur);
+        if (item != MP_OBJ_STOP_ITERATION) {
+            return item;
+        }
+        self->cur = MP_OBJ_NULL;
+    }
+}
+
+STATIC mp_obj_t chain_from_iterable(mp_obj_t type_in, mp_obj_t iterable) {
+    return chain_new(MP_OBJ_TO_PTR(type_in), iterable);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(chain_from_iterable_fun_obj, chain_from_iterable);
+STATIC MP_DEFINE_CONST_CLASSMETHOD_OBJ(chain_from_iterable_obj, MP_ROM_PTR(&chain_from_iterable_fun_obj));
+
+STATIC const mp_rom_map_elem_t chain_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_from_iterable), MP_ROM_PTR(&chain_from_iterable_obj) },
+};
+
+STATIC MP_DEFINE_CONST_DICT(chain_locals_dict, chain_locals_dict_table);
+
+STATIC const mp_obj_type_t itertools_chain_type = {
+    { &mp_type_type },
+    .name = MP_QSTR_chain,
+    .make_new = chain_make_new,
+    .getiter = mp_identity_getiter,
+    .iternext = chain_iternext,
+    .locals_dict = (mp_obj_dict_t*)&chain_locals_dict,
+};
+
+/******************************************************************************/
+// islice(iterable, stop), islice(iterable, start, stop[, step])
+
+typedef struct _mp_obj_islice_t {
+    mp_obj_base_t base;
+    mp_obj_t iter;
+    size_t pos;         // number of items taken from iter
+    size_t next;        // position of the next item to return
+    size_t stop;
+    size_t step;
+    mp_obj_iter_buf_t iter_buf;
+} mp_obj_islice_t;
+
+STATIC mp_obj_t islice_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *args) {
+    mp_arg_check_num(n_args, n_kw, 2, 4, false);
+    mp_obj_islice_t *o = m_new_obj(mp_obj_islice_t);
+    o->base.type = type;
+    o->pos = 0;
+    if (n_args == 2) {
+        o->next = 0;
+        o->stop = get_index(args[1], ITER_UNBOUNDED);
+        o->step = 1;
+    } else {
+        o->next = get_index(args[1], 0);
+        o->stop = get_index(args[2], ITER_UNBOUNDED);
+        o->step = n_args > 3 ? get_index(args[3], 1) : 1;
+        if (o->step == 0) {
+            mp_raise_ValueError("step must be positive");
+        }
+    }
+    o->iter = mp_getiter(args[0], &o->iter_buf);
+    return MP_OBJ_FROM_PTR(o);
+}
+
+STATIC mp_obj_t islice_iternext(mp_obj_t self_in) {
+    mp_obj_islice_t *self = MP_OBJ_TO_PTR(self_in);
+    // the items are read up to stop, like CPython does
+    while (self->pos < self->stop) {
+        mp_obj_t item = mp_iternext(self->iter);
+        if (item == MP_OBJ_STOP_ITERATION) {
+            self->stop = 0;
+            break;
+        }
+        if (self->pos++ == self->next) {
+            self->next = (ITER_UNBOUNDED - self->next > self->step) ? self->next + self->step : ITER_UNBOUNDED;
+            return item;
+        }
+    }
+    return MP_OBJ_STOP_ITERATION;
+}
+
+STATIC const mp_obj_type_t itertools_islice_type = {
+    { &mp_type_type },
+    .name = MP_QSTR_islice,
+    .make_new = islice_make_new,
+    .getiter = mp_identity_getiter,
+    .iternext = islice_iternext,
+};
+
+/******************************************************************************/
+// takewhile(predicate, iterable)
+
+typedef struct _mp_obj_takewhile_t {
+    mp_obj_base_t base;
+    mp_obj_t pred;
+    mp_obj_t iter;
+    mp_obj_iter_buf_t iter_buf;
+} mp_obj_takewhile_t;
+
+STATIC mp_obj_t takewhile_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *args) {
+    mp_arg_check_num(n_args, n_kw, 2, 2, false);
+    mp_obj_takewhile_t *o = m_new_obj(mp_obj_takewhile_t);
+    o->base.type = type;
+    o->pred = args[0];
+    o->iter = mp_getiter(args[1], &o->iter_buf);
+    return MP_OBJ_FROM_PTR(o);
+}
+
+STATIC mp_obj_t takewhile_iternext(mp_obj_t self_in) {
+    mp_obj_takewhile_t *self = MP_OBJ_TO_PTR(self_in);
+    if (self->iter == MP_OBJ_NULL) {
+        return MP_OBJ_STOP_ITERATION;
+    }
+    mp_obj_t item = mp_iternext(self->iter);
+    if (item != MP_OBJ_STOP_ITERATION && mp_obj_is_true(mp_call_function_1(self->pred, item))) {
+        return item;
+    }
+    self->iter = MP_OBJ_NULL;
+    return MP_OBJ_STOP_ITERATION;
+}
+
+STATIC const mp_obj_type_t itertools_takewhile_type = {
+    { &mp_type_type },
+    .name = MP_QSTR_takewhile,
+    .make_new = takewhile_make_new,
+    .getiter = mp_identity_getiter,
+    .iternext = takewhile_iternext,
+};
+
+/******************************************************************************/
+// accumulate(iterable, func=None, *, initial=None)
+
+typedef struct _mp_obj_accumulate_t {
+    mp_obj_base_t base;
+    mp_obj_t iter;
+    mp_obj_t func;
+    mp_obj_t total;     // MP_OBJ_NULL before the first item
+    bool initial;       // total is the initial value, not returned yet
+    mp_obj_iter_buf_t iter_buf;
+} mp_obj_accumulate_t;
+
+STATIC mp_obj_t accumulate_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *args) {
+    enum { ARG_iterable, ARG_func, ARG_initial };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_iterable, MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+        { MP_QSTR_func, MP_ARG_OBJ, {.u_obj = mp_const_none} },
+        { MP_QSTR_initial, MP_ARG_KW_ONLY | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+    };
+    mp_arg_val_t vals[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all_kw_array(n_args, n_kw, args, MP_ARRAY_SIZE(allowed_args), allowed_args, vals);
+
+    mp_obj_accumulate_t *o = m_new_obj(mp_obj_accumulate_t);
+    o->base.type = type;
+    o->iter = mp_getiter(vals[ARG_iterable].u_obj, &o->iter_buf);
+    o->func = vals[ARG_func].u_obj;
+    o->initial = (vals[ARG_initial].u_obj != mp_const_none);
+    o->total = o->initial ? vals[ARG_initial].u_obj : MP_OBJ_NULL;
+    return MP_OBJ_FROM_PTR(o);
+}
+
+STATIC mp_obj_t accumulate_iternext(mp_obj_t self_in) {
+    mp_obj_accumulate_t *self = MP_OBJ_TO_PTR(self_in);
+    if (self->initial) {
+        self->initial = false;
+        return self->total;
+    }
+    mp_obj_t item = mp_iternext(self->iter);
+    if (item == MP_OBJ_STOP_ITERATION) {
+        return MP_OBJ_STOP_ITERATION;
+    }
+    if (self->total == MP_OBJ_NULL) {
+        self->total = item;
+    } else if (self->func == mp_const_none) {
+        self->total = mp_binary_op(MP_BINARY_OP_ADD, self->total, item);
+    } else {
+        self->total = mp_call_function_2(self->func, self->total, item);
+    }
+    return self->total;
+}
+
+STATIC const mp_obj_type_t itertools_accumulate_type = {
+    { &mp_type_type },
+    .name = MP_QSTR_accumulate,
+    .make_new = accumulate_make_new,
+    .getiter = mp_identity_getiter,
+    .iternext = accumulate_iternext,
+};
+
+/******************************************************************************/
+// groupby(iterable, key=None)
+//
+// The groups read the items from the groupby iterator; when it advances to
+// the next group the previous one is exhausted.
+
+typedef struct _mp_obj_groupby_t {
+    mp_obj_base_t base;
+    mp_obj_t iter;
+    mp_obj_t key;
+    mp_obj_t tgtkey;    // key of the current group
+    mp_obj_t currkey;   // key of the last item read, MP_OBJ_NULL at the start
+    mp_obj_t currvalue;
+    size_t id;          // number of the current group
+    mp_obj_iter_buf_t iter_buf;
+} mp_obj_groupby_t;
+
+typedef struct _mp_obj_grouper_t {
+    mp_obj_base_t base;
+    mp_obj_groupby_t *parent;
+    mp_obj_t tgtkey;
+    size_t id;
+    bool started;
+} mp_obj_grouper_t;
+
+STATIC const mp_obj_type_t itertools_grouper_type;
+
+STATIC bool groupby_key_equal(mp_obj_t a, mp_obj_t b) {
+    if (a == MP_OBJ_NULL || b == MP_OBJ_NULL) {
+        return a == b;
+    }
+    return mp_obj_equal(a, b);
+}
+
+// read the next item, return false at the end
+STATIC bool groupby_step(mp_obj_groupby_t *self) {
+    mp_obj_t item = mp_iternext(self->iter);
+    if (item == MP_OBJ_STOP_ITERATION) {
+        return false;
+    }
+    self->currvalue = item;
+    self->currkey = (self->key == mp_const_none) ? item : mp_call_function_1(self->key, item);
+    return true;
+}
+
+STATIC mp_obj_t groupby_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *args) {
+    enum { ARG_iterable, ARG_key };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_iterable, MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+        { MP_QSTR_key, MP_ARG_OBJ, {.u_obj = mp_const_none} },
+    };
+    mp_arg_val_t vals[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all_kw_array(n_args, n_kw, args, MP_ARRAY_SIZE(allowed_args), allowed_args, vals);
+
+    mp_obj_groupby_t *o = m_new_obj(mp_obj_groupby_t);
+    o->base.type = type;
+    o->iter = mp_getiter(vals[ARG_iterable].u_obj, &o->iter_buf);
+    o->key = vals[ARG_key].u_obj;
+    o->tgtkey = MP_OBJ_NULL;
+    o->currkey = MP_OBJ_NULL;
+    o->currvalue = MP_OBJ_NULL;
+    o->id = 0;
+    return MP_OBJ_FROM_PTR(o);
+}
+
+STATIC mp_obj_t groupby_iternext(mp_obj_t self_in) {
+    mp_obj_groupby_t *self = MP_OBJ_TO_PTR(self_in);
+    self->id++;
+    // skip the rest of the current group
+    while (groupby_key_equal(self->currkey, self->tgtkey)) {
+        if (!groupby_step(self)) {
+            return MP_OBJ_STOP_ITERATION;
+        }
+    }
+    self->tgtkey = self->currkey;
+
+    mp_obj_grouper_t *g = m_new_obj(mp_obj_grouper_t);
+    g->base.type = &itertools_grouper_type;
+    g->parent = self;
+    g->tgtkey = self->tgtkey;
+    g->id = self->id;
+    g->started = false;
+    mp_obj_t tuple[2] = { self->currkey, MP_OBJ_FROM_PTR(g) };
+    return mp_obj_new_tuple(2, tuple);
+}
+
+STATIC mp_obj_t grouper_iternext(mp_obj_t self_in) {
+    mp_obj_grouper_t *self = MP_OBJ_TO_PTR(self_in);
+    mp_obj_groupby_t *parent = self->parent;
+    if (parent == NULL || parent->id != self->id) {
+        return MP_OBJ_STOP_ITERATION;
+    }
+    // the first item of the group was read by groupby
+    if (self->started && !groupby_step(parent)) {
+        self->parent = NULL;
+        return MP_OBJ_STOP_ITERATION;
+    }
+    self->started = true;
+    if (!groupby_key_equal(parent->currkey, self->tgtkey)) {
+        self->parent = NULL;
+        return MP_OBJ_STOP_ITERATION;
+    }
+    return parent->currvalue;
+}
+
+STATIC const mp_obj_type_t itertools_groupby_type = {
+    { &mp_type_type },
+    .name = MP_QSTR_groupby,
+    .make_new = groupby_make_new,
+    .getiter = mp_identity_getiter,
+    .iternext = groupby_iternext,
+};
+
+STATIC const mp_obj_type_t itertools_grouper_type = {
+    { &mp_type_type },
+    .name = MP_QSTR__grouper,
+    .getiter = mp_identity_getiter,
+    .iternext = grouper_iternext,
+};
+
+/******************************************************************************/
+// tee(iterable, n=2, *, maxlen=None)
+//
+// The items read from the source by the leading iterator are kept in a ring
+// buffer until all the iterators have returned them.  With maxlen the buffer
+// can't grow beyond maxlen items, the leading iterator raises IndexError
+// instead of reading more.
+
+typedef struct _mp_obj_tee_t mp_obj_tee_t;
+
+typedef struct _tee_data_t {
+    mp_obj_t iter;
+    mp_obj_t *items;
+    size_t alloc;
+    size_t start;       // ring index of the oldest buffered item
+    size_t len;
+    size_t first;       // position of the oldest buffered item in the source
+    size_t maxlen;
+    size_t n;
+    mp_obj_iter_buf_t iter_buf;
+    mp_obj_tee_t *its[];
+} tee_data_t;
+
+struct _mp_obj_tee_t {
+    mp_obj_base_t base;
+    tee_data_t *data;
+    size_t pos;         // position of the next item in the source
+};
+
+STATIC const mp_obj_type_t itertools_tee_type;
+
+// drop the items returned by all the iterators
+STATIC void tee_trim(tee_data_t *d) {
+    size_t min_pos = d->first + d->len;
+    for (size_t i = 0; i < d->n; i++) {
+        if (d->its[i]->pos < min_pos) {
+            min_pos = d->its[i]->pos;
+        }
+    }
+    while (d->first < min_pos) {
+        d->items[d->start] = MP_OBJ_NULL; // so we don't retain a pointer
+        d->start = (d->start + 1) % d->alloc;
+        d->first++;
+        d->len--;
+    }
+}
+
+STATIC mp_obj_t tee_iternext(mp_obj_t self_in) {
+    mp_obj_tee_t *self = MP_OBJ_TO_PTR(self_in);
+    tee_data_t *d = self->data;
+
+    if (self->pos < d->first + d->len) {
+        mp_obj_t item = d->items[(d->start + self->pos - d->first) % d->alloc];
+        if (self->pos++ == d->first) {
+            tee_trim(d);
+        }
+        return item;
+    }
+
+    // the leading iterator, the others need the new item later
+    if (d->n > 1 && d->len == d->alloc) {
+        if (d->len == d->maxlen) {
+            mp_raise_msg(&mp_type_IndexError, "tee buffer full");
+        }
+        size_t new_alloc = d->alloc ? d->alloc * 2 : 4;
+        if (new_alloc > d->maxlen) {
+            new_alloc = d->maxlen;
+        }
+        mp_obj_t *items = m_new(mp_obj_t, new_alloc);
+        for (size_t i = 0; i < d->len; i++) {
+            items[i] = d->items[(d->start + i) % d->alloc];
+        }
+        m_del(mp_obj_t, d->items, d->alloc);
+        d->items = items;
+        d->alloc = new_alloc;
+        d->start = 0;
+    }
+    mp_obj_t item = mp_iternext(d->iter);
+    if (item == MP_OBJ_STOP_ITERATION) {
+        return MP_OBJ_STOP_ITERATION;
+    }
+    self->pos++;
+    if (d->n > 1) {
+        d->items[(d->start + d->len++) % d->alloc] = item;
+    } else {
+        d->first++;
+    }
+    return item;
+}
+
+STATIC const mp_obj_type_t itertools_tee_type = {
+    { &mp_type_type },
+    .name = MP_QSTR__tee,
+    .getiter = mp_identity_getiter,
+    .iternext = tee_iternext,
+};
+
+STATIC mp_obj_t itertools_tee(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    enum { ARG_iterable, ARG_n, ARG_maxlen };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_iterable, MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+        { MP_QSTR_n, MP_ARG_INT, {.u_int = 2} },
+        { MP_QSTR_maxlen, MP_ARG_KW_ONLY | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    mp_int_t n = args[ARG_n].u_int;
+    if (n < 0) {
+        mp_raise_ValueError("n must be >= 0");
+    }
+    size_t maxlen = get_index(args[ARG_maxlen].u_obj, ITER_UNBOUNDED);
+    if (maxlen == 0 && n > 1) {
+        mp_raise_ValueError("maxlen must be positive");
+    }
+
+    tee_data_t *d = m_new_obj_var(tee_data_t, mp_obj_tee_t*, n);
+    d->iter = mp_getiter(args[ARG_iterable].u_obj, &d->iter_buf);
+    d->items = NULL;
+    d->alloc = 0;
+    d->start = 0;
+    d->len = 0;
+    d->first = 0;
+    d->maxlen = maxlen;
+    d->n = n;
+    mp_obj_tuple_t *res = MP_OBJ_TO_PTR(mp_obj_new_tuple(n, NULL));
+    for (mp_int_t i = 0; i < n; i++) {
+        mp_obj_tee_t *it = m_new_obj(mp_obj_tee_t);
+        it->base.type = &itertools_tee_type;
+        it->data = d;
+        it->pos = 0;
+        d->its[i] = it;
+        res->items[i] = MP_OBJ_FROM_PTR(it);
+    }
+    return MP_OBJ_FROM_PTR(res);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(itertools_tee_obj, 1, itertools_tee);
+
+/******************************************************************************/
+// batched(iterable, n), tuples of n items, the last one may be shorter
+
+typedef struct _mp_obj_batched_t {
+    mp_obj_base_t base;
+    mp_obj_t iter;
+    size_t n;
+    mp_obj_iter_buf_t iter_buf;
+} mp_obj_batched_t;
+
+STATIC mp_obj_t batched_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *args) {
+    mp_arg_check_num(n_args, n_kw, 2, 2, false);
+    mp_int_t n = mp_obj_get_int(args[1]);
+    if (n < 1) {
+        mp_raise_ValueError("n must be at least one");
+    }
+    mp_obj_batched_t *o = m_new_obj(mp_obj_batched_t);
+    o->base.type = type;
+    o->iter = mp_getiter(args[0], &o->iter_buf);
+    o->n = n;
+    return MP_OBJ_FROM_PTR(o);
+}
+
+STATIC mp_obj_t batched_iternext(mp_obj_t self_in) {
+    mp_obj_batched_t *self = MP_OBJ_TO_PTR(self_in);
+    if (self->iter == MP_OBJ_NULL) {
+        return MP_OBJ_STOP_ITERATION;
+    }
+    mp_obj_t item = mp_iternext(self->iter);
+    if (item == MP_OBJ_STOP_ITERATION) {
+        self->iter = MP_OBJ_NULL;
+        return MP_OBJ_STOP_ITERATION;
+    }
+    mp_obj_tuple_t *t = MP_OBJ_TO_PTR(mp_obj_new_tuple(self->n, NULL));
+    t->items[0] = item;
+    for (size_t i = 1; i < self->n; i++) {
+        item = mp_iternext(self->iter);
+        if (item == MP_OBJ_STOP_ITERATION) {
+            // the last batch is shorter, release the unused slots
+            self->iter = MP_OBJ_NULL;
+            (void)m_renew_maybe(byte, t, sizeof(mp_obj_tuple_t) + self->n * sizeof(mp_obj_t),
+                sizeof(mp_obj_tuple_t) + i * sizeof(mp_obj_t), false);
+            t->len = i;
+            break;
+        }
+        t->items[i] = item;
+    }
+    return MP_OBJ_FROM_PTR(t);
+}
+
+STATIC const mp_obj_type_t itertools_batched_type = {
+    { &mp_type_type },
+    .name = MP_QSTR_batched,
+    .make_new = batched_make_new,
+    .getiter = mp_identity_getiter,
+    .iternext = batched_iternext,
+};
+
+STATIC const mp_rom_map_elem_t mp_module_uitertools_globals_table[] = {
+    { MP_ROM_QSTR(MP_QSTR___name__), MP_ROM_QSTR(MP_QSTR_uitertools) },
+    { MP_ROM_QSTR(MP_QSTR_count), MP_ROM_PTR(&itertools_count_type) },
+    { MP_ROM_QSTR(MP_QSTR_cycle), MP_ROM_PTR(&itertools_cycle_type) },
+    { MP_ROM_QSTR(MP_QSTR_chain), MP_ROM_PTR(&itertools_chain_type) },
+    { MP_ROM_QSTR(MP_QSTR_islice), MP_ROM_PTR(&itertools_islice_type) },
+    { MP_ROM_QSTR(MP_QSTR_takewhile), MP_ROM_PTR(&itertools_takewhile_type) },
+    { MP_ROM_QSTR(MP_QSTR_accumulate), MP_ROM_PTR(&itertools_accumulate_type) },
+    { MP_ROM_QSTR(MP_QSTR_groupby), MP_ROM_PTR(&itertools_groupby_type) },
+    { MP_ROM_QSTR(MP_QSTR_tee), MP_ROM_PTR(&itertools_tee_obj) },
+    { MP_ROM_QSTR(MP_QSTR_batched), MP_ROM_PTR(&itertools_batched_type) },
+};
+
+STATIC MP_DEFINE_CONST_DICT(mp_module_uitertools_globals, mp_module_uitertools_globals_table);
+
+const mp_obj_module_t mp_module_uitertools = {
+    .base = { &mp_type_module },
+    .globals = (mp_obj_dict_t*)&mp_module_uitertools_globals,
+};
+
+#endif //MICROPY_PY_UITERTOOLS
@@ -40,9 +40,15 @@
 #include "re1.5/re1.5.h"
 
 #define FLAG_DEBUG 0x1000
+#define FLAG_PIKEVM 0x2000
 
 typedef struct _mp_obj_re_t {
     mp_obj_base_t base;
+    mp_obj_t pattern;
+    uint16_t flags;
+    bool has_first;
+    // bitmap of the bytes a match can start with, valid if has_first
+    unsigned char first[32];
     ByteProg re;
 } mp_obj_re_t;
 
@@ -96,18 +102,36 @@ STATIC void re_print(const mp_print_t *print, mp_obj_t self_in, mp_print_kind_t
     mp_printf(print, "<re %p>", self);
 }
 
-STATIC mp_obj_t ure_exec(bool is_anchored, uint n_args, const mp_obj_t *args) {
-    (void)n_args;
-    mp_obj_re_t *self = MP_OBJ_TO_PTR(args[0]);
+// Match the compiled pattern at sp, or search for it from sp if not anchored,
+// with the matcher selected for the pattern.
+STATIC int ure_run(mp_obj_re_t *self, Subject *subj, const char *sp, const char **caps, int caps_num, bool is_anchored) {
+    const unsigned char *first = (self->has_first && !is_anchored) ? self->first : NULL;
+    #if MICROPY_PY_URE_PIKEVM
+    if (self->flags & FLAG_PIKEVM) {
+        // thread lists of small patterns fit on the C stack
+        const char *stack_mem[64];
+        size_t size = re1_5_pikevm_memsize(&self->re, caps_num);
+        void *mem = size <= sizeof(stack_mem) ? stack_mem : m_new(byte, size);
+        int res = re1_5_pikevm(&self->re, subj, sp, caps, caps_num, is_anchored, first, mem);
+        if (mem != stack_mem) {
+            m_del(byte, mem, size);
+        }
+        return res;
+    }
+    #endif
+    return re1_5_recursiveloopsearch(&self->re, subj, sp, caps, caps_num, is_anchored, first);
+}
+
+STATIC mp_obj_t ure_exec_at(mp_obj_re_t *self, mp_obj_t str, const char *sp, bool is_anchored) {
     Subject subj;
     size_t len;
-    subj.begin = mp_obj_str_get_data(args[1], &len);
+    subj.begin = mp_obj_str_get_data(str, &len);
     subj.end = subj.begin + len;
     int caps_num = (self->re.sub + 1) * 2;
     mp_obj_match_t *match = m_new_obj_var(mp_obj_match_t, char*, caps_num);
     // cast is a workaround for a bug in msvc: it treats const char** as a const pointer instead of a pointer to pointer to const char
     memset((char*)match->caps, 0, caps_num * sizeof(char*));
-    int res = re1_5_recursiveloopprog(&self->re, &subj, match->caps, caps_num, is_anchored);
+    int res = ure_run(self, &subj, sp != NULL ? sp : subj.begin, match->caps, caps_num, is_anchored);
     if (res == 0) {
         m_del_var(mp_obj_match_t, char*, caps_num, match);
         return mp_const_none;
@@ -115,10 +139,15 @@ STATIC mp_obj_t ure_exec(bool is_anchored, uint n_args, const mp_obj_t *args) {
 
     match->base.type = &match_type;
     match->num_matches = caps_num / 2; // caps_num counts start and end pointers
-    match->str = args[1];
+    match->str = str;
     return MP_OBJ_FROM_PTR(match);
 }
 
+STATIC mp_obj_t ure_exec(bool is_anchored, uint n_args, const mp_obj_t *args) {
+    (void)n_args;
+    return ure_exec_at(MP_OBJ_TO_PTR(args[0]), args[1], NULL, is_anchored);
+}
+
 STATIC mp_obj_t re_match(size_t n_args, const mp_obj_t *args) {
     return ure_exec(true, n_args, args);
 }
@@ -148,7 +177,7 @@ STATIC mp_obj_t re_split(size_t n_args, const mp_obj_t *args) {
     while (true) {
         // cast is a workaround for a bug in msvc: it treats const char** as a const pointer instead of a pointer to pointer to const char
         memset((char**)caps, 0, caps_num * sizeof(char*));
-        int res = re1_5_recursiveloopprog(&self->re, &subj, caps, caps_num, false);
+        int res = ure_run(self, &subj, subj.begin, caps, caps_num, false);
 
         // if we didn't have a match, or had an empty match, it's time to stop
         if (!res || caps[0] == caps[1]) {
@@ -174,10 +203,178 @@ STATIC mp_obj_t re_split(size_t n_args, const mp_obj_t *args) {
 }
 MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(re_split_obj, 2, 3, re_split);
 
+#if MICROPY_PY_URE_SUB
+STATIC mp_obj_t re_sub_helper(mp_obj_re_t *self, mp_obj_t replace, mp_obj_t where, mp_int_t count) {
+    Subject subj;
+    size_t len;
+    subj.begin = mp_obj_str_get_data(where, &len);
+    subj.end = subj.begin + len;
+    int caps_num = (self->re.sub + 1) * 2;
+
+    vstr_t vstr;
+    vstr.buf = NULL; // initialised at the first match
+    bool repl_fun = mp_obj_is_callable(replace);
+    mp_obj_match_t *match = NULL;
+    const char *sp = subj.begin;
+    const char *copied = subj.begin;
+    while (sp <= subj.end) {
+        if (match == NULL) {
+            // the match is passed to a replacement function, so it is on the heap
+            match = m_new_obj_var(mp_obj_match_t, char*, caps_num);
+            match->base.type = &match_type;
+            match->num_matches = caps_num / 2;
+            match->str = where;
+        }
+        memset((char**)match->caps, 0, caps_num * sizeof(char*));
+        if (!ure_run(self, &subj, sp, match->caps, caps_num, false)) {
+            break;
+        }
+        if (vstr.buf == NULL) {
+            vstr_init(&vstr, len + 16);
+        }
+        vstr_add_strn(&vstr, copied, match->caps[0] - copied);
+
+        if (repl_fun) {
+            // the string returned by a replacement function is used as is
+            size_t repl_len;
+            const char *repl = mp_obj_str_get_data(mp_call_function_1(replace, MP_OBJ_FROM_PTR(match)), &repl_len);
+            vstr_add_strn(&vstr, repl, repl_len);
+        } else {
+            size_t repl_len;
+            const char *repl = mp_obj_str_get_data(replace, &repl_len);
+            const char *repl_end = repl + repl_len;
+            // append the replacement, substituting \N and \g<N> with the groups
+            while (repl < repl_end) {
+                if (*repl != '\\') {
+                    vstr_add_byte(&vstr, *repl++);
+                    continue;
+                }
+                const char *esc = ++repl;
+                bool is_g_format = false;
+                if (repl + 1 < repl_end && repl[0] == 'g' && repl[1] == '<') {
+                    repl += 2;
+                    is_g_format = true;
+                }
+                if (repl == repl_end || *repl < '0' || *repl > '9') {
+                    // not a group reference, keep the backslash
+                    vstr_add_byte(&vstr, '\\');
+                    repl = esc;
+                    continue;
+                }
+                mp_uint_t no = 0;
+                while (repl < repl_end && *repl >= '0' && *repl <= '9') {
+                    no = no * 10 + (*repl++ - '0');
+                }
+                if (is_g_format && repl < repl_end && *repl == '>') {
+                    repl++;
+                }
+                if (no >= (mp_uint_t)match->num_matches) {
+                    nlr_raise(mp_obj_new_exception_arg1(&mp_type_IndexError, MP_OBJ_NEW_SMALL_INT(no)));
+                }
+                const char *start = match->caps[no * 2];
+                if (start != NULL) {
+                    vstr_add_strn(&vstr, start, match->caps[no * 2 + 1] - start);
+                }
+            }
+        }
+
+        copied = match->caps[1];
+        sp = match->caps[1];
+        if (match->caps[0] == match->caps[1]) {
+            // an empty match, the next one must start further on
+            if (sp < subj.end) {
+                vstr_add_byte(&vstr, *sp);
+            }
+            copied = ++sp;
+        }
+        if (repl_fun) {
+            // the replacement function may keep the match, the next one is a new object
+            match = NULL;
+        }
+        if (count > 0 && --count == 0) {
+            break;
+        }
+    }
+    if (match != NULL) {
+        m_del_var(mp_obj_match_t, char*, caps_num, match);
+    }
+
+    if (vstr.buf == NULL) {
+        // nothing was replaced
+        return where;
+    }
+    if (copied < subj.end) {
+        vstr_add_strn(&vstr, copied, subj.end - copied);
+    }
+    return mp_obj_new_str_from_vstr(mp_obj_get_type(where), &vstr);
+}
+
+STATIC mp_obj_t re_sub(size_t n_args, const mp_obj_t *args) {
+    mp_int_t count = n_args > 3 ? mp_obj_get_int(args[3]) : 0;
+    return re_sub_helper(MP_OBJ_TO_PTR(args[0]), args[1], args[2], count);
+}
+MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(re_sub_obj, 3, 4, re_sub);
+#endif
+
+#if MICROPY_PY_URE_FINDITER
+typedef struct _mp_obj_re_iter_t {
+    mp_obj_base_t base;
+    mp_obj_re_t *re;
+    mp_obj_t str;
+    size_t pos; // where the next search starts, past the end when done
+} mp_obj_re_iter_t;
+
+STATIC mp_obj_t re_iter_iternext(mp_obj_t self_in) {
+    mp_obj_re_iter_t *self = MP_OBJ_TO_PTR(self_in);
+    size_t len;
+    const char *data = mp_obj_str_get_data(self->str, &len);
+    if (self->pos > len) {
+        return MP_OBJ_STOP_ITERATION;
+    }
+    mp_obj_t match_obj = ure_exec_at(self->re, self->str, data + self->pos, false);
+    if (match_obj == mp_const_none) {
+        self->pos = len + 1;
+        return MP_OBJ_STOP_ITERATION;
+    }
+    mp_obj_match_t *match = MP_OBJ_TO_PTR(match_obj);
+    self->pos = match->caps[1] - data;
+    if (match->caps[0] == match->caps[1]) {
+        // an empty match, the next one must start further on
+        self->pos++;
+    }
+    return match_obj;
+}
+
+STATIC const mp_obj_type_t re_iter_type = {
+    { &mp_type_type },
+    .name = MP_QSTR_iterator,
+    .getiter = mp_identity_getiter,
+    .iternext = re_iter_iternext,
+};
+
+STATIC mp_obj_t re_finditer(mp_obj_t self_in, mp_obj_t str) {
+    mp_obj_re_iter_t *o = m_new_obj(mp_obj_re_iter_t);
+    o->base.type = &re_iter_type;
+    o->re = MP_OBJ_TO_PTR(self_in);
+    o->str = str;
+    o->pos = 0;
+    // check the type now rather than at the first iteration
+    mp_obj_str_get_str(str);
+    return MP_OBJ_FROM_PTR(o);
+}
+MP_DEFINE_CONST_FUN_OBJ_2(re_finditer_obj, re_finditer);
+#endif
+
 STATIC const mp_rom_map_elem_t re_locals_dict_table[] = {
     { MP_ROM_QSTR(MP_QSTR_match), MP_ROM_PTR(&re_match_obj) },
     { MP_ROM_QSTR(MP_QSTR_search), MP_ROM_PTR(&re_search_obj) },
     { MP_ROM_QSTR(MP_QSTR_split), MP_ROM_PTR(&re_split_obj) },
+    #if MICROPY_PY_URE_SUB
+    { MP_ROM_QSTR(MP_QSTR_sub), MP_ROM_PTR(&re_sub_obj) },
+    #endif
+    #if MICROPY_PY_URE_FINDITER
+    { MP_ROM_QSTR(MP_QSTR_finditer), MP_ROM_PTR(&re_finditer_obj) },
+    #endif
 };
 
 STATIC MP_DEFINE_CONST_DICT(re_locals_dict, re_locals_dict_table);
@@ -189,55 +386,112 @@ STATIC const mp_obj_type_t re_type = {
     .locals_dict = (void*)&re_locals_dict,
 };
 
-STATIC mp_obj_t mod_re_compile(size_t n_args, const mp_obj_t *args) {
-    const char *re_str = mp_obj_str_get_str(args[0]);
+STATIC mp_obj_t ure_compile(mp_obj_t pattern, int flags) {
+    const char *re_str = mp_obj_str_get_str(pattern);
     int size = re1_5_sizecode(re_str);
     if (size == -1) {
         goto error;
     }
     mp_obj_re_t *o = m_new_obj_var(mp_obj_re_t, char, size);
     o->base.type = &re_type;
-    int flags = 0;
-    if (n_args > 1) {
-        flags = mp_obj_get_int(args[1]);
-    }
+    o->pattern = pattern;
+    o->flags = flags;
     int error = re1_5_compilecode(&o->re, re_str);
     if (error != 0) {
 error:
         mp_raise_ValueError("Error in regex");
     }
+    o->has_first = re1_5_firstset(&o->re, o->first);
     if (flags & FLAG_DEBUG) {
         re1_5_dumpcode(&o->re);
     }
     return MP_OBJ_FROM_PTR(o);
 }
-MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(mod_re_compile_obj, 1, 2, mod_re_compile);
 
-STATIC mp_obj_t mod_re_exec(bool is_anchored, uint n_args, const mp_obj_t *args) {
-    (void)n_args;
-    mp_obj_t self = mod_re_compile(1, args);
+STATIC mp_obj_t mod_re_compile(size_t n_args, const mp_obj_t *args) {
+    int flags = 0;
+    if (n_args > 1) {
+        flags = mp_obj_get_int(args[1]);
+    }
+    return ure_compile(args[0], flags);
+}
+MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(mod_re_compile_obj, 1, 2, mod_re_compile);
 
-    const mp_obj_t args2[] = {self, args[1]};
-    mp_obj_t match = ure_exec(is_anchored, 2, args2);
-    return match;
+// Return the compiled pattern for a module-level function.  The most recently
+// used patterns are kept, so a pattern used in a loop is compiled only once.
+STATIC mp_obj_re_t *ure_get(mp_obj_t pattern, mp_obj_t flags_in) {
+    int flags = flags_in == MP_OBJ_NULL ? 0 : mp_obj_get_int(flags_in);
+    #if MICROPY_PY_URE_CACHE_SIZE
+    mp_obj_t *cache = MP_STATE_VM(ure_cache);
+    size_t i = 0;
+    for (; i < MICROPY_PY_URE_CACHE_SIZE && cache[i] != MP_OBJ_NULL; i++) {
+        mp_obj_re_t *o = MP_OBJ_TO_PTR(cache[i]);
+        if (o->flags == flags && (o->pattern == pattern || mp_obj_equal(o->pattern, pattern))) {
+            break;
+        }
+    }
+    mp_obj_t re;
+    if (i < MICROPY_PY_URE_CACHE_SIZE && cache[i] != MP_OBJ_NULL) {
+        re = cache[i];
+    } else {
+        re = ure_compile(pattern, flags);
+        if (i == MICROPY_PY_URE_CACHE_SIZE) {
+            // drop the least recently used pattern
+            i--;
+        }
+    }
+    memmove(cache + 1, cache, i * sizeof(mp_obj_t));
+    cache[0] = re;
+    return MP_OBJ_TO_PTR(re);
+    #else
+    return MP_OBJ_TO_PTR(ure_compile(pattern, flags));
+    #endif
 }
 
 STATIC mp_obj_t mod_re_match(size_t n_args, const mp_obj_t *args) {
-    return mod_re_exec(true, n_args, args);
+    mp_obj_re_t *self = ure_get(args[0], n_args > 2 ? args[2] : MP_OBJ_NULL);
+    return ure_exec_at(self, args[1], NULL, true);
 }
 MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(mod_re_match_obj, 2, 4, mod_re_match);
 
 STATIC mp_obj_t mod_re_search(size_t n_args, const mp_obj_t *args) {
-    return mod_re_exec(false, n_args, args);
+    mp_obj_re_t *self = ure_get(args[0], n_args > 2 ? args[2] : MP_OBJ_NULL);
+    return ure_exec_at(self, args[1], NULL, false);
 }
 MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(mod_re_search_obj, 2, 4, mod_re_search);
 
+#if MICROPY_PY_URE_SUB
+STATIC mp_obj_t mod_re_sub(size_t n_args, const mp_obj_t *args) {
+    mp_obj_re_t *self = ure_get(args[0], n_args > 4 ? args[4] : MP_OBJ_NULL);
+    mp_int_t count = n_args > 3 ? mp_obj_get_int(args[3]) : 0;
+    return re_sub_helper(self, args[1], args[2], count);
+}
+MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(mod_re_sub_obj, 3, 5, mod_re_sub);
+#endif
+
+#if MICROPY_PY_URE_FINDITER
+STATIC mp_obj_t mod_re_finditer(size_t n_args, const mp_obj_t *args) {
+    mp_obj_re_t *self = ure_get(args[0], n_args > 2 ? args[2] : MP_OBJ_NULL);
+    return re_finditer(MP_OBJ_FROM_PTR(self), args[1]);
+}
+MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(mod_re_finditer_obj, 2, 3, mod_re_finditer);
+#endif
+
 STATIC const mp_rom_map_elem_t mp_module_re_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR___name__), MP_ROM_QSTR(MP_QSTR_ure) },
     { MP_ROM_QSTR(MP_QSTR_compile), MP_ROM_PTR(&mod_re_compile_obj) },
     { MP_ROM_QSTR(MP_QSTR_match), MP_ROM_PTR(&mod_re_match_obj) },
     { MP_ROM_QSTR(MP_QSTR_search), MP_ROM_PTR(&mod_re_search_obj) },
+    #if MICROPY_PY_URE_SUB
+    { MP_ROM_QSTR(MP_QSTR_sub), MP_ROM_PTR(&mod_re_sub_obj) },
+    #endif
+    #if MICROPY_PY_URE_FINDITER
+    { MP_ROM_QSTR(MP_QSTR_finditer), MP_ROM_PTR(&mod_re_finditer_obj) },
+    #endif
     { MP_ROM_QSTR(MP_QSTR_DEBUG), MP_ROM_INT(FLAG_DEBUG) },
+    #if MICROPY_PY_URE_PIKEVM
+    { MP_ROM_QSTR(MP_QSTR_PIKEVM), MP_ROM_INT(FLAG_PIKEVM) },
+    #endif
 };
 
 STATIC MP_DEFINE_CONST_DICT(mp_module_re_globals, mp_module_re_globals_table);
@@ -254,6 +508,9 @@ const mp_obj_module_t mp_module_ure = {
 #include "re1.5/compilecode.c"
 #include "re1.5/dumpcode.c"
 #include "re1.5/recursiveloop.c"
+#if MICROPY_PY_URE_PIKEVM
+#include "re1.5/pike.c"
+#endif
 #include "re1.5/charclass.c"
 
 #endif //MICROPY_PY_URE
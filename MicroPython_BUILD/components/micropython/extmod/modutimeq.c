@@ -32,11 +32,24 @@
 #include "py/runtime.h"
 #include "py/smallint.h"
 
+
 #if MICROPY_PY_UTIMEQ
 
+// The queue is a binary heap ordered by time, then by push order.
+// Every entry also owns a slot, which holds the entry's position in the heap,
+// so an entry can be found and removed by its handle in O(log n).
+// The handle returned by push() is the slot number, with the low bits of
+// the push counter above it, so a stale handle does not match a new entry
+// that reuses the slot.
+
+#define UTIMEQ_SLOT_BITS (20)
+#define UTIMEQ_SLOT_MASK ((1 << UTIMEQ_SLOT_BITS) - 1)
+#define UTIMEQ_SLOT_FREE ((mp_uint_t)1 << (8 * sizeof(mp_uint_t) - 1))
+
 struct qentry {
     int64_t time;
-    mp_uint_t id;
+    mp_uint_t id;       // push counter, orders entries with equal times
+    mp_uint_t handle;
     mp_obj_t callback;
     mp_obj_t args;
 };
@@ -45,11 +58,15 @@ typedef struct _mp_obj_utimeq_t {
     mp_obj_base_t base;
     mp_uint_t alloc;
     mp_uint_t len;
+    mp_uint_t next_id;
+    mp_uint_t free_slot;    // first free slot, the free slots are chained
     bool ascending;
-    struct qentry items[];
+    struct qentry *items;
+    // heap position of the entry owning each slot, or the next free slot
+    // with UTIMEQ_SLOT_FREE set
+    mp_uint_t *slots;
 } mp_obj_utimeq_t;
 
-STATIC mp_uint_t utimeq_id = 0;
 STATIC bool sort_asc = true;
 
 //--------------------------------------------------
@@ -57,23 +74,165 @@ STATIC mp_obj_utimeq_t *get_heap(mp_obj_t heap_in) {
     return MP_OBJ_TO_PTR(heap_in);
 }
 
+// Return true if entry a comes out of the queue before entry b
+//--------------------------------------------------------------------------------------
+static inline bool entry_before(const struct qentry *a, const struct qentry *b, bool asc) {
+    if (a->time != b->time) {
+        return (a->time < b->time) == asc;
+    }
+    // the difference is signed so that the order survives the counter wrapping
+    return ((mp_int_t)(a->id - b->id) < 0) == asc;
+}
+
 //----------------------------------------------------------------
 STATIC int compare_times(const void * item, const void * parent) {
-    int ret = 0;
-    int64_t res = ((struct qentry *)parent)->time - ((struct qentry *)item)->time;
-	ret = (res < 0) ? -1 : 1;
-    if (res == 0) {
-    	ret = (((struct qentry *)parent)->id - ((struct qentry *)item)->id);
+    if (entry_before((const struct qentry *)item, (const struct qentry *)parent, sort_asc)) {
+        return -1;
     }
-	if (sort_asc) ret *= -1;
+    return 1;
+}
 
-	return ret;
+//---------------------------------------------------------------------------------------
+static inline void heap_set(mp_obj_utimeq_t *heap, mp_uint_t pos, const struct qentry *item) {
+    heap->items[pos] = *item;
+    heap->slots[item->handle & UTIMEQ_SLOT_MASK] = pos;
 }
 
-//---------------------------------------------
-STATIC void sort_items(mp_obj_utimeq_t *heap) {
-	sort_asc = heap->ascending;
-    qsort(&heap->items, heap->len, sizeof(struct qentry), compare_times);
+// Move the entry at pos up or down to its place in the heap
+//-----------------------------------------------------------------
+STATIC void heap_sift(mp_obj_utimeq_t *heap, mp_uint_t pos) {
+    struct qentry item = heap->items[pos];
+    bool asc = heap->ascending;
+    while (pos > 0) {
+        mp_uint_t parent = (pos - 1) >> 1;
+        if (!entry_before(&item, &heap->items[parent], asc)) {
+            break;
+        }
+        heap_set(heap, pos, &heap->items[parent]);
+        pos = parent;
+    }
+    for (;;) {
+        mp_uint_t child = 2 * pos + 1;
+        if (child >= heap->len) {
+            break;
+        }
+        if (child + 1 < heap->len && entry_before(&heap->items[child + 1], &heap->items[child], asc)) {
+            child++;
+        }
+        if (!entry_before(&heap->items[child], &item, asc)) {
+            break;
+        }
+        heap_set(heap, pos, &heap->items[child]);
+        pos = child;
+    }
+    heap_set(heap, pos, &item);
+}
+
+// Remove the entry at heap position pos and free its slot
+//----------------------------------------------------------------------
+STATIC void heap_remove(mp_obj_utimeq_t *heap, mp_uint_t pos) {
+    mp_uint_t slot = heap->items[pos].handle & UTIMEQ_SLOT_MASK;
+    heap->slots[slot] = heap->free_slot | UTIMEQ_SLOT_FREE;
+    heap->free_slot = slot;
+
+    heap->len -= 1;
+    if (pos != heap->len) {
+        heap->items[pos] = heap->items[heap->len];
+        heap_sift(heap, pos);
+    }
+    // we don't want to retain a pointers !
+    memset(&heap->items[heap->len], 0, sizeof(struct qentry));
+}
+
+// Make room for alloc entries, the queue must be full
+//---------------------------------------------------------------
+STATIC void heap_grow(mp_obj_utimeq_t *heap, mp_uint_t alloc) {
+    if (alloc > UTIMEQ_SLOT_MASK + 1) {
+        alloc = UTIMEQ_SLOT_MASK + 1;
+        if (alloc == heap->alloc) {
+            mp_raise_msg(&mp_type_IndexError, "queue overflow");
+        }
+    }
+    heap->items = m_renew(struct qentry, heap->items, heap->alloc, alloc);
+    heap->slots = m_renew(mp_uint_t, heap->slots, heap->alloc, alloc);
+    memset(&heap->items[heap->alloc], 0, sizeof(struct qentry) * (alloc - heap->alloc));
+    // chain the new slots in front of the free list, which is empty
+    for (mp_uint_t i = heap->alloc; i < alloc; i++) {
+        heap->slots[i] = (i + 1 < alloc ? i + 1 : 0) | UTIMEQ_SLOT_FREE;
+    }
+    heap->free_slot = heap->alloc;
+    heap->alloc = alloc;
+}
+
+// The candidates for heap_nth() are kept in a small heap of their own
+//--------------------------------------------------------------------------------------------------
+STATIC void cand_push(mp_obj_utimeq_t *heap, mp_uint_t *cand, mp_uint_t *ncand, mp_uint_t pos) {
+    mp_uint_t i = (*ncand)++;
+    while (i > 0) {
+        mp_uint_t parent = (i - 1) >> 1;
+        if (!entry_before(&heap->items[pos], &heap->items[cand[parent]], heap->ascending)) {
+            break;
+        }
+        cand[i] = cand[parent];
+        i = parent;
+    }
+    cand[i] = pos;
+}
+
+//--------------------------------------------------------------------------------------
+STATIC mp_uint_t cand_pop(mp_obj_utimeq_t *heap, mp_uint_t *cand, mp_uint_t *ncand) {
+    mp_uint_t top = cand[0];
+    mp_uint_t n = --(*ncand);
+    if (n == 0) {
+        return top;
+    }
+    mp_uint_t last = cand[n];
+    mp_uint_t i = 0;
+    for (;;) {
+        mp_uint_t child = 2 * i + 1;
+        if (child >= n) {
+            break;
+        }
+        if (child + 1 < n && entry_before(&heap->items[cand[child + 1]], &heap->items[cand[child]], heap->ascending)) {
+            child++;
+        }
+        if (!entry_before(&heap->items[cand[child]], &heap->items[last], heap->ascending)) {
+            break;
+        }
+        cand[i] = cand[child];
+        i = child;
+    }
+    cand[i] = last;
+    return top;
+}
+
+// Return the heap position of the entry that is n-th in the queue order.
+// The next entry in order is always a child of an entry already passed,
+// so this takes O(n log n) whatever the length of the queue.
+//--------------------------------------------------------------
+STATIC mp_uint_t heap_nth(mp_obj_utimeq_t *heap, mp_uint_t n) {
+    if (n == 0) {
+        return 0;
+    }
+    mp_uint_t size = n + 2;
+    mp_uint_t *cand = m_new(mp_uint_t, size);
+    mp_uint_t ncand = 0;
+    mp_uint_t pos;
+    cand_push(heap, cand, &ncand, 0);
+    for (;;) {
+        pos = cand_pop(heap, cand, &ncand);
+        if (n-- == 0) {
+            break;
+        }
+        if (2 * pos + 1 < heap->len) {
+            cand_push(heap, cand, &ncand, 2 * pos + 1);
+        }
+        if (2 * pos + 2 < heap->len) {
+            cand_push(heap, cand, &ncand, 2 * pos + 2);
+        }
+    }
+    m_del(mp_uint_t, cand, size);
+    return pos;
 }
 
 //----------------------------------------------------------------------------------------------------------------
@@ -89,26 +248,33 @@ STATIC mp_obj_t utimeq_make_new(const mp_obj_type_t *type, size_t n_args, size_t
 
     mp_arg_check_num(n_args, n_kw, 1, 1, true);
 
-    mp_uint_t alloc = mp_obj_get_int(args[ARG_size].u_obj);
-    mp_obj_utimeq_t *o = m_new_obj_var(mp_obj_utimeq_t, struct qentry, alloc);
+    // size is the initial capacity, the queue grows when it is full
+    mp_int_t alloc = mp_obj_get_int(args[ARG_size].u_obj);
+    if (alloc < 0) {
+        mp_raise_ValueError(NULL);
+    }
+    mp_obj_utimeq_t *o = m_new_obj(mp_obj_utimeq_t);
     o->base.type = type;
-    memset(o->items, 0, sizeof(*o->items) * alloc);
-    o->alloc = alloc;
+    o->alloc = 0;
     o->len = 0;
+    o->next_id = 0;
+    o->free_slot = 0;
     o->ascending = args[ARG_sort].u_bool;
+    o->items = NULL;
+    o->slots = NULL;
+    if (alloc > 0) {
+        heap_grow(o, alloc);
+    }
 
     return MP_OBJ_FROM_PTR(o);
 }
 
+// push(time, callback, args), returns a handle for cancel()
 //------------------------------------------------------------------------
 STATIC mp_obj_t mod_utimeq_heappush(size_t n_args, const mp_obj_t *args) {
     (void)n_args;
     mp_obj_t heap_in = args[0];
     mp_obj_utimeq_t *heap = get_heap(heap_in);
-    if (heap->len == heap->alloc) {
-        mp_raise_msg(&mp_type_IndexError, "queue overflow");
-    }
-    mp_uint_t l = heap->len;
     // time argument can be float or integer
     // if float, convert it to 64-bit integer
     int64_t itime;
@@ -118,15 +284,23 @@ STATIC mp_obj_t mod_utimeq_heappush(size_t n_args, const mp_obj_t *args) {
     }
     else itime = mp_obj_get_int64(args[1]);
 
-    heap->items[l].time = itime;
-    heap->items[l].id = utimeq_id++;
-    heap->items[l].callback = args[2];
-    heap->items[l].args = args[3];
+    if (heap->len == heap->alloc) {
+        heap_grow(heap, heap->alloc < 4 ? 8 : heap->alloc * 2);
+    }
+    mp_uint_t slot = heap->free_slot;
+    heap->free_slot = heap->slots[slot] & ~UTIMEQ_SLOT_FREE;
+
+    struct qentry *item = &heap->items[heap->len];
+    item->time = itime;
+    item->id = heap->next_id++;
+    item->handle = ((item->id << UTIMEQ_SLOT_BITS) | slot) & MP_SMALL_INT_POSITIVE_MASK;
+    item->callback = args[2];
+    item->args = args[3];
+    mp_uint_t handle = item->handle;
     heap->len++;
+    heap_sift(heap, heap->len - 1);
 
-    sort_items(heap);
-
-    return mp_const_none;
+    return MP_OBJ_NEW_SMALL_INT(handle);
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(mod_utimeq_heappush_obj, 4, 4, mod_utimeq_heappush);
 
@@ -146,19 +320,32 @@ STATIC mp_obj_t mod_utimeq_heappop(mp_obj_t heap_in, mp_obj_t list_ref) {
     ret->items[1] = item->callback;
     ret->items[2] = item->args;
 
-    heap->len -= 1;
-
-    if (heap->len) {
-    	memmove(&heap->items[0], &heap->items[1], sizeof(struct qentry) * heap->len);
-        //sort_items(heap);
-        // we don't want to retain a pointers !
-        memset(&heap->items[heap->len], 0, sizeof(struct qentry));
-    }
+    heap_remove(heap, 0);
 
     return mp_const_none;
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_2(mod_utimeq_heappop_obj, mod_utimeq_heappop);
 
+// cancel(handle), remove the entry pushed with the given handle
+// Returns False if it is no longer in the queue.
+//---------------------------------------------------------------------
+STATIC mp_obj_t mod_utimeq_cancel(mp_obj_t heap_in, mp_obj_t handle_in) {
+    mp_obj_utimeq_t *heap = get_heap(heap_in);
+    mp_uint_t handle = mp_obj_get_int(handle_in);
+    mp_uint_t slot = handle & UTIMEQ_SLOT_MASK;
+    if (slot >= heap->alloc || (heap->slots[slot] & UTIMEQ_SLOT_FREE)) {
+        return mp_const_false;
+    }
+    mp_uint_t pos = heap->slots[slot];
+    if (heap->items[pos].handle != handle) {
+        // the slot was reused by a later entry
+        return mp_const_false;
+    }
+    heap_remove(heap, pos);
+    return mp_const_true;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(mod_utimeq_cancel_obj, mod_utimeq_cancel);
+
 //-----------------------------------------------------------------------------------------
 STATIC mp_obj_t mod_utimeq_heappeek(mp_obj_t heap_in, mp_obj_t idx_in, mp_obj_t list_ref) {
     mp_obj_utimeq_t *heap = get_heap(heap_in);
@@ -174,7 +361,7 @@ STATIC mp_obj_t mod_utimeq_heappeek(mp_obj_t heap_in, mp_obj_t idx_in, mp_obj_t
         mp_raise_TypeError(NULL);
     }
 
-    struct qentry *item = &heap->items[pos];
+    struct qentry *item = &heap->items[heap_nth(heap, pos)];
     ret->items[0] = mp_obj_new_int_from_ll(item->time);
     ret->items[1] = item->callback;
     ret->items[2] = item->args;
@@ -197,7 +384,7 @@ STATIC mp_obj_t mod_utimeq_peektime(size_t n_args, const mp_obj_t *args) {
             nlr_raise(mp_obj_new_exception_msg(&mp_type_IndexError, "wrong heap index"));
     	}
     }
-    struct qentry *item = &heap->items[pos];
+    struct qentry *item = &heap->items[heap_nth(heap, pos)];
     return mp_obj_new_int_from_ll(item->time);
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(mod_utimeq_peektime_obj, 1, 2, mod_utimeq_peektime);
@@ -222,15 +409,24 @@ STATIC mp_obj_t mod_utimeq_dump(size_t n_args, const mp_obj_t *args) {
     if (n_args == 2) {
     	if ( mp_obj_is_true(args[1])) maxlen = heap->alloc;
     }
+    // print the entries in queue order
+    struct qentry *items = m_new(struct qentry, heap->len);
+    memcpy(items, heap->items, sizeof(struct qentry) * heap->len);
+	sort_asc = heap->ascending;
+    qsort(items, heap->len, sizeof(struct qentry), compare_times);
+
     printf("%4s%21s%10s%12s%12s\n", "Idx", "Time", "ID", "Callback", "Arg");
     printf("-----------------------------------------------------------\n");
     for (int i = 0; i < maxlen; i++) {
-        printf("%4d%21lld%10u%12p%12p", i, heap->items[i].time, heap->items[i].id,
-            MP_OBJ_TO_PTR(heap->items[i].callback), MP_OBJ_TO_PTR(heap->items[i].args));
-        if (i >= heap->len) printf("  (empty)\n");
-        else printf("\n");
+        if (i >= heap->len) {
+            printf("%4d  (empty)\n", i);
+            continue;
+        }
+        printf("%4d%21lld%10u%12p%12p\n", i, items[i].time, items[i].handle,
+            MP_OBJ_TO_PTR(items[i].callback), MP_OBJ_TO_PTR(items[i].args));
     }
     printf("-----------------------------------------------------------\n");
+    m_del(struct qentry, items, heap->len);
     return mp_const_none;
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(mod_utimeq_dump_obj, 1, 2, mod_utimeq_dump);
@@ -249,6 +445,7 @@ STATIC mp_obj_t utimeq_unary_op(mp_unary_op_t op, mp_obj_t self_in) {
 STATIC const mp_rom_map_elem_t utimeq_locals_dict_table[] = {
     { MP_ROM_QSTR(MP_QSTR_push),     MP_ROM_PTR(&mod_utimeq_heappush_obj) },
     { MP_ROM_QSTR(MP_QSTR_pop),      MP_ROM_PTR(&mod_utimeq_heappop_obj) },
+    { MP_ROM_QSTR(MP_QSTR_cancel),   MP_ROM_PTR(&mod_utimeq_cancel_obj) },
     { MP_ROM_QSTR(MP_QSTR_peek),     MP_ROM_PTR(&mod_utimeq_heappeek_obj) },
     { MP_ROM_QSTR(MP_QSTR_peektime), MP_ROM_PTR(&mod_utimeq_peektime_obj) },
     { MP_ROM_QSTR(MP_QSTR_len),      MP_ROM_PTR(&mod_utimeq_len_obj) },
@@ -206,6 +206,55 @@ int re1_5_compilecode(ByteProg *prog, const char *re)
     return 0;
 }
 
+static int _firstset(const char *pc, unsigned char *set, int *budget)
+{
+    for (;;) {
+        if (--*budget < 0) return 0;
+        switch (*pc) {
+        case Char:
+            set[(unsigned char)pc[1] >> 3] |= 1 << (pc[1] & 7);
+            return 1;
+        case Class:
+        case ClassNot:
+        case NamedClass:
+            for (int c = 0; c < 256; c++) {
+                char ch = c;
+                if (*pc == NamedClass ? _re1_5_namedclassmatch(pc + 1, &ch) : _re1_5_classmatch(pc + 1, &ch)) {
+                    set[c >> 3] |= 1 << (c & 7);
+                }
+            }
+            return 1;
+        case Jmp:
+            pc += 2 + (signed char)pc[1];
+            break;
+        case Split:
+        case RSplit:
+            re1_5_stack_chk();
+            if (!_firstset(pc + 2 + (signed char)pc[1], set, budget)) return 0;
+            pc += 2;
+            break;
+        case Save:
+            pc += 2;
+            break;
+        default:
+            // Any, an assertion or Match: a match can start with any byte,
+            // or with none
+            return 0;
+        }
+    }
+}
+
+// Work out the set of bytes that a match of prog can start with, as a bitmap
+// of 256 bits.  Return 0 if there is no such set, because the pattern can
+// match an empty string, starts with an assertion or the program is too
+// complex to follow.
+int re1_5_firstset(ByteProg *prog, unsigned char *set)
+{
+    int budget = 4 * prog->len;
+    memset(set, 0, 32);
+    return _firstset(prog->insts + NON_ANCHORED_PREFIX, set, &budget);
+}
+
 #if 0
 int main(int argc, char *argv[])
 {
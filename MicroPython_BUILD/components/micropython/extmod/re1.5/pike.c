@@ -0,0 +1,190 @@
+// Copyright 2007-2009 Russ Cox.  All Rights Reserved.
+// Copyright 2018 LoBo (https://github.com/loboris)
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+
+#include "re1.5.h"
+
+// Pike VM: all alternatives of the program run in lock step over the
+// subject, so matching time is linear in the subject length, whatever the
+// pattern.  A thread is a program counter followed by its nsubp capture
+// pointers.  A thread list holds at most one thread per instruction, in
+// priority order, so the result is the same as the backtracking matcher.
+
+typedef struct ThreadList ThreadList;
+typedef struct PikeVM PikeVM;
+
+struct ThreadList
+{
+	int n;
+	const char **t;
+};
+
+struct PikeVM
+{
+	ByteProg *prog;
+	Subject *input;
+	int nsubp;
+	unsigned *mark;		// step at which each instruction was added
+	unsigned step;
+};
+
+int
+re1_5_pikevm_memsize(ByteProg *prog, int nsubp)
+{
+	// two thread lists, the captures of a new thread and the marks
+	return (2 * prog->len * (1 + nsubp) + nsubp) * sizeof(const char*)
+		+ prog->bytelen * sizeof(unsigned);
+}
+
+static void
+addthread(PikeVM *vm, ThreadList *l, char *pc, const char *sp, const char **subp)
+{
+	const char *old;
+	const char **t;
+	int off;
+
+	re1_5_stack_chk();
+
+	if(vm->mark[pc - vm->prog->insts] == vm->step)
+		return;
+	vm->mark[pc - vm->prog->insts] = vm->step;
+
+	switch(*pc) {
+	case Jmp:
+		off = (signed char)pc[1];
+		addthread(vm, l, pc + 2 + off, sp, subp);
+		return;
+	case Split:
+		off = (signed char)pc[1];
+		addthread(vm, l, pc + 2, sp, subp);
+		addthread(vm, l, pc + 2 + off, sp, subp);
+		return;
+	case RSplit:
+		off = (signed char)pc[1];
+		addthread(vm, l, pc + 2 + off, sp, subp);
+		addthread(vm, l, pc + 2, sp, subp);
+		return;
+	case Save:
+		off = (unsigned char)pc[1];
+		if(off >= vm->nsubp) {
+			addthread(vm, l, pc + 2, sp, subp);
+			return;
+		}
+		old = subp[off];
+		subp[off] = sp;
+		addthread(vm, l, pc + 2, sp, subp);
+		subp[off] = old;
+		return;
+	case Bol:
+		if(sp == vm->input->begin)
+			addthread(vm, l, pc + 1, sp, subp);
+		return;
+	case Eol:
+		if(sp == vm->input->end)
+			addthread(vm, l, pc + 1, sp, subp);
+		return;
+	}
+
+	// a consumer or Match, the thread waits in the list
+	t = l->t + l->n++ * (1 + vm->nsubp);
+	t[0] = pc;
+	memcpy(t + 1, subp, vm->nsubp * sizeof(const char*));
+}
+
+// Match starting at sp, or at the first position from sp if not anchored.
+// first, if not nil, is a bitmap of the bytes a match can start with, used
+// to skip ahead while no thread is running.  mem must hold
+// re1_5_pikevm_memsize() bytes.
+int
+re1_5_pikevm(ByteProg *prog, Subject *input, const char *sp, const char **subp, int nsubp,
+	int is_anchored, const unsigned char *first, void *mem)
+{
+	PikeVM vm;
+	ThreadList clist, nlist, tmp;
+	char *start, *pc;
+	const char **t, **newsub;
+	int i, matched, seed, stride;
+
+	stride = 1 + nsubp;
+	clist.t = mem;
+	nlist.t = clist.t + prog->len * stride;
+	newsub = nlist.t + prog->len * stride;
+	vm.prog = prog;
+	vm.input = input;
+	vm.nsubp = nsubp;
+	vm.mark = (unsigned*)(newsub + nsubp);
+	vm.step = 1;
+	memset(vm.mark, 0, prog->bytelen * sizeof(unsigned));
+	memset(newsub, 0, nsubp * sizeof(const char*));
+
+	start = prog->insts + NON_ANCHORED_PREFIX;
+	matched = 0;
+	seed = 1;
+	clist.n = 0;
+	for(;; sp++) {
+		// start a new thread at this position, with the lowest priority
+		if(seed && !matched) {
+			if(clist.n == 0 && first != nil && !is_anchored) {
+				while(sp < input->end && !(first[(unsigned char)*sp >> 3] & (1 << (*sp & 7))))
+					sp++;
+				if(sp >= input->end)
+					break;
+			}
+			addthread(&vm, &clist, start, sp, newsub);
+			seed = !is_anchored;
+		}
+		if(clist.n == 0) {
+			if(!seed || matched || sp >= input->end)
+				break;
+			// nothing runs, try the next position
+			vm.step++;
+			continue;
+		}
+
+		vm.step++;
+		nlist.n = 0;
+		for(i = 0; i < clist.n; i++) {
+			t = clist.t + i * stride;
+			pc = (char*)t[0];
+			if(*pc == Match) {
+				// threads after this one have a lower priority, drop them
+				memcpy(subp, t + 1, nsubp * sizeof(const char*));
+				matched = 1;
+				break;
+			}
+			if(sp >= input->end)
+				continue;
+			switch(*pc) {
+			case Char:
+				if(*sp != pc[1])
+					continue;
+				pc += 2;
+				break;
+			case Any:
+				pc++;
+				break;
+			case Class:
+			case ClassNot:
+				if(!_re1_5_classmatch(pc + 1, sp))
+					continue;
+				pc += (unsigned char)pc[1] * 2 + 2;
+				break;
+			case NamedClass:
+				if(!_re1_5_namedclassmatch(pc + 1, sp))
+					continue;
+				pc += 2;
+				break;
+			default:
+				re1_5_fatal("pikevm");
+			}
+			addthread(&vm, &nlist, pc, sp + 1, t + 1);
+		}
+		tmp = clist;
+		clist = nlist;
+		nlist = tmp;
+		if(sp >= input->end)
+			break;
+	}
+	return matched;
+}
@@ -84,3 +84,27 @@ re1_5_recursiveloopprog(ByteProg *prog, Subject *input, const char **subp, int n
 {
 	return recursiveloop(HANDLE_ANCHORED(prog->insts, is_anchored), input->begin, input, subp, nsubp);
 }
+
+// Match starting at sp, or at the first position from sp if not anchored.
+// first, if not nil, is a bitmap of the bytes a match can start with, the
+// positions starting with other bytes are not tried.
+int
+re1_5_recursiveloopsearch(ByteProg *prog, Subject *input, const char *sp, const char **subp, int nsubp, int is_anchored, const unsigned char *first)
+{
+	char *pc = prog->insts + NON_ANCHORED_PREFIX;
+
+	if(is_anchored)
+		return recursiveloop(pc, sp, input, subp, nsubp);
+	for(;; sp++) {
+		if(first != nil) {
+			while(sp < input->end && !(first[(unsigned char)*sp >> 3] & (1 << (*sp & 7))))
+				sp++;
+			if(sp >= input->end)
+				return 0;
+		}
+		if(recursiveloop(pc, sp, input, subp, nsubp))
+			return 1;
+		if(sp >= input->end)
+			return 0;
+	}
+}
@@ -0,0 +1,165 @@
+/*
+ * This file is part of the MicroPython ESP32 project, https://github.com/loboris/MicroPython_ESP32_psRAM_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <string.h>
+
+#include "timerwheel.h"
+
+//-----------------------------------------------------------------------------------
+static void tw_link(tw_wheel_t *w, tw_node_t *node)
+{
+    uint32_t delta = node->expires - w->now;
+    uint32_t expires = node->expires;
+    tw_node_t **head;
+    int level;
+
+    if ((int32_t)delta < 0) {
+        // already expired, run it on the next tick
+        expires = w->now;
+        delta = 0;
+    }
+    else if (delta > TW_MAX_DELTA) {
+        expires = w->now + TW_MAX_DELTA;
+        delta = TW_MAX_DELTA;
+    }
+    for (level = 0; level < TW_LEVELS - 1; level++) {
+        if (delta < (1UL << (TW_LEVEL_BITS * (level + 1)))) break;
+    }
+    head = &w->slot[level][(expires >> (TW_LEVEL_BITS * level)) & TW_SLOT_MASK];
+
+    node->next = *head;
+    if (node->next) node->next->pprev = &node->next;
+    node->pprev = head;
+    *head = node;
+}
+
+//-------------------------------------------------------------
+static void tw_unlink(tw_node_t *node)
+{
+    *node->pprev = node->next;
+    if (node->next) node->next->pprev = node->pprev;
+    node->next = NULL;
+    node->pprev = NULL;
+}
+
+// Move the timers of the given slot to the lower levels,
+// return the slot index, 0 if the next level has to be cascaded too
+//-------------------------------------------------------------
+static int tw_cascade(tw_wheel_t *w, int level)
+{
+    int idx = (w->now >> (TW_LEVEL_BITS * level)) & TW_SLOT_MASK;
+    tw_node_t *node = w->slot[level][idx];
+    tw_node_t *next;
+
+    w->slot[level][idx] = NULL;
+    while (node) {
+        next = node->next;
+        tw_link(w, node);
+        w->cascaded++;
+        node = next;
+    }
+    return idx;
+}
+
+//----------------------------------------------
+void tw_init(tw_wheel_t *w, uint32_t now)
+{
+    memset(w, 0, sizeof(tw_wheel_t));
+    w->now = now;
+}
+
+// Add the timer to expire at the tick 'expires', the node must not be in the wheel
+//----------------------------------------------------------------
+void tw_add(tw_wheel_t *w, tw_node_t *node, uint32_t expires)
+{
+    node->expires = expires;
+    tw_link(w, node);
+    w->count++;
+}
+
+//----------------------------------------------
+void tw_del(tw_wheel_t *w, tw_node_t *node)
+{
+    if (node->pprev == NULL) return;
+    tw_unlink(node);
+    w->count--;
+}
+
+// Process the tick w->now, return the number of expired timers
+//-------------------------------------------------------------
+int tw_tick(tw_wheel_t *w, tw_expire_t expire, void *arg)
+{
+    int idx = w->now & TW_SLOT_MASK;
+    tw_node_t *node, *list;
+    int n = 0;
+
+    if (idx == 0) {
+        for (int level = 1; (level < TW_LEVELS) && (tw_cascade(w, level) == 0); level++) ;
+    }
+    // move the expired timers to a local list, they can still be removed
+    // by the expire function while it is processed
+    list = w->slot[0][idx];
+    w->slot[0][idx] = NULL;
+    if (list) list->pprev = &list;
+    w->now++;
+
+    while ((node = list) != NULL) {
+        tw_unlink(node);
+        w->count--;
+        n++;
+        expire(node, arg);
+    }
+    return n;
+}
+
+// Process 'ticks' ticks, used to run the wheel from a virtual clock
+//-------------------------------------------------------------------------------
+int tw_advance(tw_wheel_t *w, uint32_t ticks, tw_expire_t expire, void *arg)
+{
+    int n = 0;
+    while (ticks--) {
+        if (w->count == 0) {
+            // nothing to expire or cascade
+            w->now += ticks + 1;
+            break;
+        }
+        n += tw_tick(w, expire, arg);
+    }
+    return n;
+}
+
+// Return the tick in [expires, expires + slack] aligned to the largest
+// power of two not above slack, so that timers with close expiry times
+// expire on the same tick
+//-------------------------------------------------
+uint32_t tw_coalesce(uint32_t expires, uint32_t slack)
+{
+    uint32_t align = 1;
+
+    if (slack == 0) return expires;
+    while (align <= (slack >> 1)) align <<= 1;
+    return (expires + align - 1) & ~(align - 1);
+}
@@ -0,0 +1,83 @@
+/*
+ * This file is part of the MicroPython ESP32 project, https://github.com/loboris/MicroPython_ESP32_psRAM_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Hierarchical timer wheel.
+ *
+ * Timers are kept in TW_LEVELS levels of TW_SLOTS slots. Level 0 has one slot per
+ * tick, each slot of level n covers TW_SLOTS^n ticks. A timer is put into the level
+ * which covers its distance from the current tick, when the lower level wraps around,
+ * the timers of the next slot of the upper level are cascaded down.
+ * Adding and removing a timer is O(1), a tick is O(1) amortized.
+ * The wheel has no clock of its own, it is advanced by tw_tick(), one call per tick,
+ * from a hardware timer interrupt or from a virtual clock.
+ *
+ * This module has no ESP-IDF or MicroPython dependencies and can be compiled on host.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifndef TW_LEVEL_BITS
+#define TW_LEVEL_BITS   (6)
+#endif
+#ifndef TW_LEVELS
+#define TW_LEVELS       (4)
+#endif
+#define TW_SLOTS        (1 << TW_LEVEL_BITS)
+#define TW_SLOT_MASK    (TW_SLOTS - 1)
+// Timers which expire later are parked at the end of the top level and cascaded again
+#define TW_MAX_DELTA    ((1UL << (TW_LEVEL_BITS * TW_LEVELS)) - 1)
+
+typedef struct _tw_node_t {
+    struct _tw_node_t *next;
+    struct _tw_node_t **pprev;  // NULL if the timer is not in the wheel
+    uint32_t expires;           // tick at which the timer expires
+} tw_node_t;
+
+typedef struct _tw_wheel_t {
+    uint32_t now;               // next tick to be processed
+    uint32_t count;             // number of timers in the wheel
+    uint32_t cascaded;          // number of timers moved to a lower level
+    tw_node_t *slot[TW_LEVELS][TW_SLOTS];
+} tw_wheel_t;
+
+// Called for each expired timer, the node is already removed from the wheel
+// and can be added again (periodic timers)
+typedef void (*tw_expire_t)(tw_node_t *node, void *arg);
+
+void tw_init(tw_wheel_t *w, uint32_t now);
+void tw_add(tw_wheel_t *w, tw_node_t *node, uint32_t expires);
+void tw_del(tw_wheel_t *w, tw_node_t *node);
+int tw_tick(tw_wheel_t *w, tw_expire_t expire, void *arg);
+int tw_advance(tw_wheel_t *w, uint32_t ticks, tw_expire_t expire, void *arg);
+uint32_t tw_coalesce(uint32_t expires, uint32_t slack);
+
+static inline int tw_pending(const tw_node_t *node) {
+    return node->pprev != NULL;
+}
@@ -88,19 +88,32 @@ STATIC int parse_compile_execute(const void *source, mp_parse_input_kind_t input
             } else {
                 lex = (mp_lexer_t*)source;
             }
-            // source is a lexer, parse and compile the script
-            qstr source_name = lex->source_name;
-            mp_parse_tree_t parse_tree = mp_parse(lex, input_kind);
-            module_fun = mp_compile(&parse_tree, source_name, MP_EMIT_OPT_NONE, exec_flags & EXEC_FLAG_IS_REPL);
+            #if MICROPY_COMP_STREAM
+            if (input_kind == MP_PARSE_FILE_INPUT && !(exec_flags & EXEC_FLAG_IS_REPL)) {
+                // the script is executed while it is compiled, one statement at a time
+                mp_hal_set_interrupt_char(CHAR_CTRL_C); // allow ctrl-C to interrupt us
+                start = mp_hal_ticks_ms();
+                mp_compile_execute_stream(lex, MP_EMIT_OPT_NONE);
+                module_fun = MP_OBJ_NULL;
+            } else
+            #endif
+            {
+                // source is a lexer, parse and compile the script
+                qstr source_name = lex->source_name;
+                mp_parse_tree_t parse_tree = mp_parse(lex, input_kind);
+                module_fun = mp_compile(&parse_tree, source_name, MP_EMIT_OPT_NONE, exec_flags & EXEC_FLAG_IS_REPL);
+            }
             #else
             mp_raise_msg(&mp_type_RuntimeError, "script compilation not supported");
             #endif
         }
 
         // execute code
-        mp_hal_set_interrupt_char(CHAR_CTRL_C); // allow ctrl-C to interrupt us
-        start = mp_hal_ticks_ms();
-        mp_call_function_0(module_fun);
+        if (module_fun != MP_OBJ_NULL) {
+            mp_hal_set_interrupt_char(CHAR_CTRL_C); // allow ctrl-C to interrupt us
+            start = mp_hal_ticks_ms();
+            mp_call_function_0(module_fun);
+        }
         mp_hal_set_interrupt_char(-1); // disable interrupt
         nlr_pop();
         ret = 1;
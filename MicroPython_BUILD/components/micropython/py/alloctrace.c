@@ -0,0 +1,209 @@
+/*
+ * This file is part of the MicroPython ESP32 project, https://github.com/loboris/MicroPython_ESP32_psRAM_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <string.h>
+
+#include "py/runtime.h"
+#include "py/bc.h"
+#include "py/gc.h"
+#include "py/builtin.h"
+#include "py/alloctrace.h"
+
+#if MICROPY_PY_MICROPYTHON_ALLOC_TRACE
+
+typedef struct _alloc_trace_entry_t {
+    void *caller;       // C function that called the allocator
+    uint32_t bytes;
+    uint32_t count;     // 0 if the entry is free
+    uint16_t file;      // qstr of the Python source file, MP_QSTR_NULL outside Python code
+    uint16_t line;
+    uint16_t type;      // qstr of the type name, MP_QSTR_NULL if not an object of a known type
+} alloc_trace_entry_t;
+
+// Allocations are counted in a static table so tracing never allocates.  The
+// newest allocation is held back until the next one, by when its constructor
+// has set the object type.
+STATIC alloc_trace_entry_t alloc_trace_table[MICROPY_PY_MICROPYTHON_ALLOC_TRACE_ENTRIES];
+STATIC alloc_trace_entry_t alloc_trace_pending;
+STATIC void *alloc_trace_pending_ptr;
+STATIC uint32_t alloc_trace_dropped_bytes;
+STATIC uint32_t alloc_trace_dropped_count;
+
+// object types that are not in the builtins module
+STATIC const mp_obj_type_t *const alloc_trace_types[] = {
+    &mp_type_fun_bc,
+    &mp_type_closure,
+    &mp_type_cell,
+    &mp_type_gen_instance,
+    &mp_type_module,
+    #if MICROPY_PY_BUILTINS_SLICE
+    &mp_type_slice,
+    #endif
+};
+
+STATIC qstr alloc_trace_type_name(void *ptr) {
+    const mp_obj_type_t *type = ((mp_obj_base_t*)ptr)->type;
+    if (type == NULL) {
+        return MP_QSTR_NULL;
+    }
+    // The first word of raw memory is arbitrary, so it is only dereferenced if
+    // it points into the heap, where the classes defined in Python live;
+    // otherwise it must be one of the known builtin types.
+    if (gc_nbytes(type) != 0) {
+        return type->base.type == &mp_type_type ? type->name : MP_QSTR_NULL;
+    }
+    for (size_t i = 0; i < MP_ARRAY_SIZE(alloc_trace_types); i++) {
+        if (type == alloc_trace_types[i]) {
+            return type->name;
+        }
+    }
+    const mp_map_t *map = &mp_module_builtins.globals->map;
+    for (size_t i = 0; i < map->alloc; i++) {
+        if (map->table[i].value == MP_OBJ_FROM_PTR(type)) {
+            return type->name;
+        }
+    }
+    return MP_QSTR_NULL;
+}
+
+STATIC void alloc_trace_flush(void) {
+    if (alloc_trace_pending_ptr == NULL) {
+        return;
+    }
+    alloc_trace_entry_t *p = &alloc_trace_pending;
+    p->type = alloc_trace_type_name(alloc_trace_pending_ptr);
+    alloc_trace_pending_ptr = NULL;
+
+    size_t h = ((uintptr_t)p->caller >> 1) ^ (p->file * 31) ^ (p->line * 257) ^ (p->type * 8191);
+    for (size_t i = 0; i < MICROPY_PY_MICROPYTHON_ALLOC_TRACE_ENTRIES; i++) {
+        alloc_trace_entry_t *e = &alloc_trace_table[(h + i) % MICROPY_PY_MICROPYTHON_ALLOC_TRACE_ENTRIES];
+        if (e->count == 0) {
+            *e = *p;
+            return;
+        }
+        if (e->caller == p->caller && e->file == p->file && e->line == p->line && e->type == p->type) {
+            e->bytes += p->bytes;
+            e->count += 1;
+            return;
+        }
+    }
+    alloc_trace_dropped_bytes += p->bytes;
+    alloc_trace_dropped_count += 1;
+}
+
+void mp_alloc_trace(void *ptr, size_t n_bytes, void *caller) {
+    alloc_trace_flush();
+    alloc_trace_entry_t *p = &alloc_trace_pending;
+    p->caller = caller;
+    p->bytes = n_bytes;
+    p->count = 1;
+    p->file = MP_QSTR_NULL;
+    p->line = 0;
+    const mp_code_state_t *code_state = MP_STATE_THREAD(current_code_state);
+    if (code_state != NULL) {
+        qstr block, file;
+        size_t line = mp_code_state_get_location(code_state, &block, &file);
+        p->file = file;
+        p->line = line > 0xffff ? 0xffff : line;
+    }
+    alloc_trace_pending_ptr = ptr;
+}
+
+void mp_alloc_trace_set_caller(void *caller) {
+    alloc_trace_pending.caller = caller;
+}
+
+void mp_alloc_trace_enable(bool enable) {
+    if (enable) {
+        memset(alloc_trace_table, 0, sizeof(alloc_trace_table));
+        alloc_trace_pending_ptr = NULL;
+        alloc_trace_dropped_bytes = 0;
+        alloc_trace_dropped_count = 0;
+    } else {
+        alloc_trace_flush();
+    }
+    MP_STATE_MEM(alloc_trace_enabled) = enable;
+}
+
+// Return a list of (bytes, count, type, file, line, caller) tuples, the sites
+// that allocated the most bytes first.  The allocations that did not fit in
+// the table are counted in a last tuple with all other items None.
+mp_obj_t mp_alloc_trace_get(size_t max_entries) {
+    alloc_trace_flush();
+
+    // sort the used entries by bytes allocated
+    uint16_t order[MICROPY_PY_MICROPYTHON_ALLOC_TRACE_ENTRIES];
+    size_t n = 0;
+    for (size_t i = 0; i < MICROPY_PY_MICROPYTHON_ALLOC_TRACE_ENTRIES; i++) {
+        const alloc_trace_entry_t *e = &alloc_trace_table[i];
+        if (e->count == 0) {
+            continue;
+        }
+        size_t j = n++;
+        for (; j > 0 && alloc_trace_table[order[j - 1]].bytes < e->bytes; j--) {
+            order[j] = order[j - 1];
+        }
+        order[j] = i;
+    }
+    if (n > max_entries) {
+        n = max_entries;
+    }
+
+    // the result is not traced itself
+    bool enabled = MP_STATE_MEM(alloc_trace_enabled);
+    MP_STATE_MEM(alloc_trace_enabled) = false;
+    nlr_buf_t nlr;
+    if (nlr_push(&nlr) != 0) {
+        MP_STATE_MEM(alloc_trace_enabled) = enabled;
+        nlr_jump(nlr.ret_val);
+    }
+    mp_obj_t list = mp_obj_new_list(0, NULL);
+    for (size_t i = 0; i < n; i++) {
+        const alloc_trace_entry_t *e = &alloc_trace_table[order[i]];
+        mp_obj_t items[6] = {
+            mp_obj_new_int_from_uint(e->bytes),
+            mp_obj_new_int_from_uint(e->count),
+            e->type == MP_QSTR_NULL ? mp_const_none : MP_OBJ_NEW_QSTR(e->type),
+            e->file == MP_QSTR_NULL ? mp_const_none : MP_OBJ_NEW_QSTR(e->file),
+            e->file == MP_QSTR_NULL ? mp_const_none : MP_OBJ_NEW_SMALL_INT(e->line),
+            mp_obj_new_int_from_uint((uintptr_t)e->caller),
+        };
+        mp_obj_list_append(list, mp_obj_new_tuple(6, items));
+    }
+    if (alloc_trace_dropped_count != 0) {
+        mp_obj_t items[6] = {
+            mp_obj_new_int_from_uint(alloc_trace_dropped_bytes),
+            mp_obj_new_int_from_uint(alloc_trace_dropped_count),
+            mp_const_none, mp_const_none, mp_const_none, mp_const_none,
+        };
+        mp_obj_list_append(list, mp_obj_new_tuple(6, items));
+    }
+    nlr_pop();
+    MP_STATE_MEM(alloc_trace_enabled) = enabled;
+    return list;
+}
+
+#endif // MICROPY_PY_MICROPYTHON_ALLOC_TRACE
@@ -0,0 +1,49 @@
+/*
+ * This file is part of the MicroPython ESP32 project, https://github.com/loboris/MicroPython_ESP32_psRAM_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef MICROPY_INCLUDED_PY_ALLOCTRACE_H
+#define MICROPY_INCLUDED_PY_ALLOCTRACE_H
+
+#include "py/obj.h"
+
+#if MICROPY_PY_MICROPYTHON_ALLOC_TRACE
+
+// The address in the function that called the allocator, a port may override
+// this if its return addresses need fixing up.
+#ifndef MP_ALLOC_TRACE_CALLER
+#define MP_ALLOC_TRACE_CALLER() __builtin_return_address(0)
+#endif
+
+// Count an allocation; called by the m_malloc functions while tracing is on.
+void mp_alloc_trace(void *ptr, size_t n_bytes, void *caller);
+// Change the C caller of the allocation just counted, for allocator wrappers.
+void mp_alloc_trace_set_caller(void *caller);
+
+void mp_alloc_trace_enable(bool enable);
+mp_obj_t mp_alloc_trace_get(size_t max_entries);
+
+#endif // MICROPY_PY_MICROPYTHON_ALLOC_TRACE
+
+#endif // MICROPY_INCLUDED_PY_ALLOCTRACE_H
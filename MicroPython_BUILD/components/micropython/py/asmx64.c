@@ -362,12 +362,14 @@ void asm_x64_mov_i64_to_r64_optimised(asm_x64_t *as, int64_t src_i64, int dest_r
 }
 
 // src_i64 is stored as a full word in the code, and aligned to machine-word boundary
-void asm_x64_mov_i64_to_r64_aligned(asm_x64_t *as, int64_t src_i64, int dest_r64) {
+// returns the offset of the stored word in the code
+size_t asm_x64_mov_i64_to_r64_aligned(asm_x64_t *as, int64_t src_i64, int dest_r64) {
     // mov instruction uses 2 bytes for the instruction, before the i64
     while (((as->base.code_offset + 2) & (WORD_SIZE - 1)) != 0) {
         asm_x64_nop(as);
     }
     asm_x64_mov_i64_to_r64(as, src_i64, dest_r64);
+    return as->base.code_offset - WORD_SIZE;
 }
 
 void asm_x64_and_r64_r64(asm_x64_t *as, int dest_r64, int src_r64) {
@@ -610,6 +612,11 @@ void asm_x64_call_i1(asm_x64_t *as, void* func, int i1) {
 }
 */
 
+void asm_x64_call_r64(asm_x64_t *as, int src_r64) {
+    assert(src_r64 < 8);
+    asm_x64_write_byte_2(as, OPCODE_CALL_RM32, MODRM_R64(2) | MODRM_RM_REG | MODRM_RM_R64(src_r64));
+}
+
 void asm_x64_call_ind(asm_x64_t *as, void *ptr, int temp_r64) {
     assert(temp_r64 < 8);
 #ifdef __LP64__
@@ -618,7 +625,7 @@ void asm_x64_call_ind(asm_x64_t *as, void *ptr, int temp_r64) {
     // If we get here, sizeof(int) == sizeof(void*).
     asm_x64_mov_i64_to_r64_optimised(as, (int64_t)(unsigned int)ptr, temp_r64);
 #endif
-    asm_x64_write_byte_2(as, OPCODE_CALL_RM32, MODRM_R64(2) | MODRM_RM_REG | MODRM_RM_R64(temp_r64));
+    asm_x64_call_r64(as, temp_r64);
     // this reduces code size by 2 bytes per call, but doesn't seem to speed it up at all
     // doesn't work anymore because calls are 64 bits away
     /*
@@ -284,6 +284,32 @@ continue2:;
     dump_args(code_state->state, n_state);
 }
 
+#if MICROPY_CODE_STATE_CHAIN
+// Return the source line that the given code state is executing, and the
+// qstrs of its function name and source file
+size_t mp_code_state_get_location(const mp_code_state_t *code_state, qstr *block_name, qstr *source_file) {
+    const byte *ip = code_state->fun_bc->bytecode;
+    ip = mp_decode_uint_skip(ip); // skip n_state
+    ip = mp_decode_uint_skip(ip); // skip n_exc_stack
+    ip += 4; // skip scope_params, n_pos_args, n_kwonly_args, n_def_pos_args
+    size_t bc = code_state->ip - ip;
+    size_t code_info_size = mp_decode_uint_value(ip);
+    ip = mp_decode_uint_skip(ip); // skip code_info_size
+    bc -= code_info_size;
+    #if MICROPY_PERSISTENT_CODE
+    *block_name = ip[0] | (ip[1] << 8);
+    *source_file = ip[2] | (ip[3] << 8);
+    ip += 4;
+    #else
+    *block_name = mp_decode_uint_value(ip);
+    ip = mp_decode_uint_skip(ip);
+    *source_file = mp_decode_uint_value(ip);
+    ip = mp_decode_uint_skip(ip);
+    #endif
+    return mp_bytecode_get_source_line(ip, bc);
+}
+#endif
+
 #if MICROPY_PERSISTENT_CODE_LOAD || MICROPY_PERSISTENT_CODE_SAVE
 
 // The following table encodes the number of bytes that a specific opcode
@@ -297,6 +323,11 @@ continue2:;
 //     MP_BC_LOAD_GLOBAL
 //     MP_BC_LOAD_ATTR
 //     MP_BC_STORE_ATTR
+// The superinstructions carry extra operand bytes after their encoded argument:
+//     MP_BC_LOAD_FAST_ATTR                 1 byte (local number)
+//     MP_BC_BINARY_OP_POP_JUMP_IF_TRUE     1 byte (binary op)
+//     MP_BC_BINARY_OP_POP_JUMP_IF_FALSE    1 byte (binary op)
+//     MP_BC_LOAD_FAST_CONST_BINARY_OP      3 bytes (local, small int, binary op)
 #define OC4(a, b, c, d) (a | (b << 2) | (c << 4) | (d << 6))
 #define U (0) // undefined opcode
 #define B (MP_OPCODE_BYTE) // single byte
@@ -315,10 +346,10 @@ STATIC const byte opcode_format_table[64] = {
     OC4(B, B, V, V), // 0x20-0x23
     OC4(Q, Q, Q, B), // 0x24-0x27
     OC4(V, V, Q, Q), // 0x28-0x2b
-    OC4(U, U, U, U), // 0x2c-0x2f
+    OC4(Q, B, U, U), // 0x2c-0x2f
     OC4(B, B, B, B), // 0x30-0x33
     OC4(B, O, O, O), // 0x34-0x37
-    OC4(O, O, U, U), // 0x38-0x3b
+    OC4(O, O, O, O), // 0x38-0x3b
     OC4(U, O, B, O), // 0x3c-0x3f
     OC4(O, B, B, O), // 0x40-0x43
     OC4(B, B, O, B), // 0x44-0x47
@@ -386,12 +417,14 @@ uint mp_opcode_format(const byte *ip, size_t *opcode_size) {
     uint f = (opcode_format_table[*ip >> 2] >> (2 * (*ip & 3))) & 3;
     const byte *ip_start = ip;
     if (f == MP_OPCODE_QSTR) {
-        ip += 3;
+        ip += 3 + (*ip == MP_BC_LOAD_FAST_ATTR);
     } else {
         int extra_byte = (
             *ip == MP_BC_RAISE_VARARGS
             || *ip == MP_BC_MAKE_CLOSURE
             || *ip == MP_BC_MAKE_CLOSURE_DEFARGS
+            || *ip == MP_BC_BINARY_OP_POP_JUMP_IF_TRUE
+            || *ip == MP_BC_BINARY_OP_POP_JUMP_IF_FALSE
             #if MICROPY_OPT_CACHE_MAP_LOOKUP_IN_BYTECODE
             || *ip == MP_BC_LOAD_NAME
             || *ip == MP_BC_LOAD_GLOBAL
@@ -399,6 +432,9 @@ uint mp_opcode_format(const byte *ip, size_t *opcode_size) {
             || *ip == MP_BC_STORE_ATTR
             #endif
         );
+        if (*ip == MP_BC_LOAD_FAST_CONST_BINARY_OP) {
+            extra_byte = 3;
+        }
         ip += 1;
         if (f == MP_OPCODE_VAR_UINT) {
             while ((*ip++ & 0x80) != 0) {
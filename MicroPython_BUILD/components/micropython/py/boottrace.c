@@ -0,0 +1,151 @@
+/*
+ * This file is part of the MicroPython ESP32 project, https://github.com/loboris/MicroPython_ESP32_psRAM_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "py/mpstate.h"
+#include "py/mphal.h"
+#include "py/boottrace.h"
+
+#if MICROPY_BOOT_TRACE
+
+// The trace lives outside the MicroPython state so it can be recorded before
+// the heap and the runtime are set up.  Events are stored when they end, so
+// an enclosing event comes after the events nested in it.
+STATIC mp_boot_trace_entry_t boot_trace[MICROPY_BOOT_TRACE_ENTRIES];
+STATIC uint32_t boot_trace_count; // number of events recorded, including the dropped ones
+STATIC uint8_t boot_trace_depth;
+STATIC bool boot_trace_disabled;
+
+STATIC const char *const boot_trace_kind_str[] = {
+    [MP_BOOT_TRACE_MARK] = "mark",
+    [MP_BOOT_TRACE_INIT] = "init",
+    [MP_BOOT_TRACE_SCRIPT] = "script",
+    [MP_BOOT_TRACE_IMPORT_PY] = "py",
+    [MP_BOOT_TRACE_IMPORT_MPY] = "mpy",
+    [MP_BOOT_TRACE_IMPORT_FROZEN] = "frozen",
+    [MP_BOOT_TRACE_IMPORT_ROM] = "rom",
+    [MP_BOOT_TRACE_GC] = "gc",
+    [MP_BOOT_TRACE_NETWORK] = "net",
+};
+
+void mp_boot_trace_enable(bool enable) {
+    if (enable) {
+        boot_trace_count = 0;
+        boot_trace_depth = 0;
+    }
+    boot_trace_disabled = !enable;
+}
+
+bool mp_boot_trace_enabled(void) {
+    return !boot_trace_disabled;
+}
+
+// depth of a span begun while recording was stopped, its end is ignored
+#define BOOT_TRACE_NO_DEPTH (0xff)
+
+void mp_boot_trace_begin(mp_boot_trace_span_t *span) {
+    if (boot_trace_disabled) {
+        span->depth = BOOT_TRACE_NO_DEPTH;
+        return;
+    }
+    span->start = mp_hal_ticks_us();
+    span->alloc = MP_STATE_MEM(gc_alloc_total);
+    span->depth = boot_trace_depth++;
+}
+
+void mp_boot_trace_end(mp_boot_trace_span_t *span, mp_boot_trace_kind_t kind, qstr name) {
+    if (span->depth == BOOT_TRACE_NO_DEPTH) {
+        return;
+    }
+    // restoring the depth also recovers from nested spans ended by an exception
+    boot_trace_depth = span->depth;
+    mp_boot_trace_add(kind, name, span->start, MP_STATE_MEM(gc_alloc_total) - span->alloc);
+}
+
+void mp_boot_trace_cancel(mp_boot_trace_span_t *span) {
+    if (span->depth != BOOT_TRACE_NO_DEPTH) {
+        boot_trace_depth = span->depth;
+    }
+}
+
+void mp_boot_trace_add(mp_boot_trace_kind_t kind, qstr name, uint32_t start, uint32_t size) {
+    if (boot_trace_disabled) {
+        return;
+    }
+    mp_boot_trace_entry_t *e = &boot_trace[boot_trace_count++ % MICROPY_BOOT_TRACE_ENTRIES];
+    e->start = start;
+    e->duration = (uint32_t)mp_hal_ticks_us() - start;
+    e->size = size;
+    e->name = name;
+    e->kind = kind;
+    e->depth = boot_trace_depth;
+}
+
+void mp_boot_trace_mark(qstr name) {
+    mp_boot_trace_add(MP_BOOT_TRACE_MARK, name, mp_hal_ticks_us(), 0);
+}
+
+void mp_boot_trace_print(const mp_print_t *print) {
+    size_t n = boot_trace_count;
+    size_t first = 0;
+    if (n > MICROPY_BOOT_TRACE_ENTRIES) {
+        first = n % MICROPY_BOOT_TRACE_ENTRIES;
+        n = MICROPY_BOOT_TRACE_ENTRIES;
+    }
+
+    // list the events in the order they began, enclosing events first
+    uint16_t order[MICROPY_BOOT_TRACE_ENTRIES];
+    for (size_t i = 0; i < n; i++) {
+        const mp_boot_trace_entry_t *e = &boot_trace[(first + i) % MICROPY_BOOT_TRACE_ENTRIES];
+        size_t j = i;
+        for (; j > 0; j--) {
+            const mp_boot_trace_entry_t *o = &boot_trace[order[j - 1]];
+            int32_t diff = (int32_t)(e->start - o->start);
+            if (diff > 0 || (diff == 0 && e->depth >= o->depth)) {
+                break;
+            }
+            order[j] = order[j - 1];
+        }
+        order[j] = (first + i) % MICROPY_BOOT_TRACE_ENTRIES;
+    }
+
+    mp_printf(print, "boot trace: %u events, %u dropped\n", (uint)n, (uint)(boot_trace_count - n));
+    mp_print_str(print, "  start us     time us    size  event\n");
+    for (size_t i = 0; i < n; i++) {
+        const mp_boot_trace_entry_t *e = &boot_trace[order[i]];
+        mp_printf(print, "%10u  %10u  ", (uint)e->start, (uint)e->duration);
+        if (e->kind == MP_BOOT_TRACE_MARK) {
+            mp_print_str(print, "      ");
+        } else {
+            mp_printf(print, "%6u", (uint)e->size);
+        }
+        for (int d = 0; d <= e->depth; d++) {
+            mp_print_str(print, "  ");
+        }
+        mp_printf(print, "%-6s %q\n", boot_trace_kind_str[e->kind], (qstr)e->name);
+    }
+}
+
+#endif // MICROPY_BOOT_TRACE
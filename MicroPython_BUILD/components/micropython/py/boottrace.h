@@ -0,0 +1,77 @@
+/*
+ * This file is part of the MicroPython ESP32 project, https://github.com/loboris/MicroPython_ESP32_psRAM_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef MICROPY_INCLUDED_PY_BOOTTRACE_H
+#define MICROPY_INCLUDED_PY_BOOTTRACE_H
+
+#include "py/mpprint.h"
+#include "py/qstr.h"
+
+#if MICROPY_BOOT_TRACE
+
+typedef enum {
+    MP_BOOT_TRACE_MARK,         // a point in time
+    MP_BOOT_TRACE_INIT,         // a port initialisation step
+    MP_BOOT_TRACE_SCRIPT,       // boot.py, main.py
+    MP_BOOT_TRACE_IMPORT_PY,    // import of a .py file
+    MP_BOOT_TRACE_IMPORT_MPY,   // import of a .mpy file
+    MP_BOOT_TRACE_IMPORT_FROZEN, // import of a frozen module that runs its code
+    MP_BOOT_TRACE_IMPORT_ROM,   // import of a frozen module laid out in ROM
+    MP_BOOT_TRACE_GC,           // garbage collection
+    MP_BOOT_TRACE_NETWORK,      // network interface initialisation
+} mp_boot_trace_kind_t;
+
+// An event that takes time; size is the heap bytes allocated while it ran,
+// except for a collection where it is the number of objects freed.
+typedef struct _mp_boot_trace_entry_t {
+    uint32_t start;     // mp_hal_ticks_us() when the event began
+    uint32_t duration;  // in microseconds
+    uint32_t size;
+    uint16_t name;      // qstr
+    uint8_t kind;
+    uint8_t depth;      // number of enclosing events
+} mp_boot_trace_entry_t;
+
+typedef struct _mp_boot_trace_span_t {
+    uint32_t start;
+    size_t alloc;
+    uint8_t depth;
+} mp_boot_trace_span_t;
+
+// Events are recorded from power-up until mp_boot_trace_enable(false); spans
+// are begun and ended in pairs.  A span left by an exception is cancelled,
+// which restores the depth without recording the event.
+void mp_boot_trace_enable(bool enable);
+bool mp_boot_trace_enabled(void);
+void mp_boot_trace_begin(mp_boot_trace_span_t *span);
+void mp_boot_trace_end(mp_boot_trace_span_t *span, mp_boot_trace_kind_t kind, qstr name);
+void mp_boot_trace_cancel(mp_boot_trace_span_t *span);
+void mp_boot_trace_add(mp_boot_trace_kind_t kind, qstr name, uint32_t start, uint32_t size);
+void mp_boot_trace_mark(qstr name);
+void mp_boot_trace_print(const mp_print_t *print);
+
+#endif // MICROPY_BOOT_TRACE
+
+#endif // MICROPY_INCLUDED_PY_BOOTTRACE_H
@@ -35,6 +35,7 @@
 #include "py/runtime.h"
 #include "py/builtin.h"
 #include "py/frozenmod.h"
+#include "py/boottrace.h"
 
 #if MICROPY_DEBUG_VERBOSE // print debugging info
 #define DEBUG_PRINT (1)
@@ -181,6 +182,220 @@ STATIC void do_execute_raw_code(mp_obj_t module_obj, mp_raw_code_t *raw_code) {
 }
 #endif
 
+#if MICROPY_MODULE_IMPORT_CACHE
+
+#include "py/reader.h"
+
+#include "mpversion.h"
+
+// A cache file is the header followed by the .mpy data.  The entry is valid if the
+// source has the same length and hash and the firmware has the same version and
+// configuration; the length and hash of the .mpy data guard against a partially
+// written file.
+#define IMPORT_CACHE_MAGIC (0x4359504d) // "MPYC"
+
+STATIC const char import_cache_version[] = MICROPY_GIT_TAG " " MICROPY_BUILD_DATE;
+
+// The options which change the compiled code
+#define IMPORT_CACHE_CONFIG ( \
+    MICROPY_OPT_CACHE_MAP_LOOKUP_IN_BYTECODE \
+    | MICROPY_PY_BUILTINS_STR_UNICODE << 1 \
+    | MICROPY_OPT_BC_PEEPHOLE << 2 \
+    | MICROPY_COMP_CONST_FOLDING << 3 \
+    | MICROPY_COMP_MODULE_CONST << 4 \
+    | MICROPY_COMP_CONST << 5 \
+    | MICROPY_COMP_DOUBLE_TUPLE_ASSIGN << 6 \
+    | MICROPY_COMP_TRIPLE_TUPLE_ASSIGN << 7 \
+    | MICROPY_COMP_RETURN_IF_EXPR << 8 \
+    | MICROPY_ENABLE_SOURCE_LINE << 9 \
+    | MICROPY_EMIT_NATIVE << 10 \
+    | MICROPY_CODE_STATE_CHAIN << 11 \
+    | MICROPY_LONGINT_IMPL << 12 \
+    | MICROPY_FLOAT_IMPL << 14 \
+    )
+
+enum {
+    IMPORT_CACHE_HDR_MAGIC,
+    IMPORT_CACHE_HDR_FIRMWARE,
+    IMPORT_CACHE_HDR_SRC_LEN,
+    IMPORT_CACHE_HDR_SRC_HASH,
+    IMPORT_CACHE_HDR_MPY_LEN,
+    IMPORT_CACHE_HDR_MPY_HASH,
+    IMPORT_CACHE_HDR_NUM,
+};
+
+typedef struct _import_cache_sum_t {
+    uint32_t len;
+    uint32_t hash;
+} import_cache_sum_t;
+
+STATIC void import_cache_sum_add(import_cache_sum_t *sum, const byte *data, size_t len) {
+    // djb2, as used for qstrs
+    uint32_t hash = sum->hash;
+    for (const byte *top = data + len; data < top; data++) {
+        hash = ((hash << 5) + hash) ^ *data;
+    }
+    sum->hash = hash;
+    sum->len += len;
+}
+
+STATIC void import_cache_sum_print_strn(void *env, const char *str, size_t len) {
+    import_cache_sum_add(env, (const byte*)str, len);
+}
+
+STATIC uint32_t import_cache_read_word(mp_reader_t *reader) {
+    uint32_t w = 0;
+    for (int i = 0; i < 4; i++) {
+        mp_uint_t b = reader->readbyte(reader->data);
+        if (b == MP_READER_EOF) {
+            return 0;
+        }
+        w |= (uint32_t)b << (i * 8);
+    }
+    return w;
+}
+
+// The cache file name is derived from the full path of the source, so modules
+// with the same name in different directories don't share an entry.
+STATIC void import_cache_path(vstr_t *path, const char *file_str, size_t file_len) {
+    const char *name = file_str + file_len - 3; // strip ".py"
+    size_t name_len = 0;
+    while (name > file_str && name[-1] != PATH_SEP_CHAR && name_len < 12) {
+        --name;
+        ++name_len;
+    }
+    import_cache_sum_t sum = {0, 5381};
+    import_cache_sum_add(&sum, (const byte*)file_str, file_len);
+    vstr_add_str(path, mp_obj_str_get_str(MP_STATE_VM(import_cache_dir)));
+    vstr_printf(path, "%c%.*s.%08x.mpy", PATH_SEP_CHAR, (int)name_len, name, (unsigned int)sum.hash);
+}
+
+// Check the header and the .mpy data of the cache file, leaving the reader at the
+// start of the .mpy data if the entry is valid
+STATIC bool import_cache_check(mp_reader_t *reader, const uint32_t *hdr, bool check_data) {
+    for (int i = 0; i < IMPORT_CACHE_HDR_MPY_LEN; i++) {
+        if (import_cache_read_word(reader) != hdr[i]) {
+            return false;
+        }
+    }
+    uint32_t len = import_cache_read_word(reader);
+    uint32_t hash = import_cache_read_word(reader);
+    if (!check_data) {
+        return true;
+    }
+    import_cache_sum_t sum = {0, 5381};
+    for (mp_uint_t b; (b = reader->readbyte(reader->data)) != MP_READER_EOF;) {
+        byte c = b;
+        import_cache_sum_add(&sum, &c, 1);
+    }
+    return len > 0 && sum.len == len && sum.hash == hash;
+}
+
+// Load the cached raw code, returns NULL if there is no valid entry
+STATIC mp_raw_code_t *import_cache_load(const char *cache_str, const uint32_t *hdr) {
+    if (mp_import_stat(cache_str) != MP_IMPORT_STAT_FILE) {
+        return NULL;
+    }
+    mp_raw_code_t *rc = NULL;
+    mp_reader_t reader;
+    volatile bool reader_open = false;
+    nlr_buf_t nlr;
+    if (nlr_push(&nlr) == 0) {
+        // the whole file is checked first so that a partially written entry is never
+        // loaded, then it is read again and loaded without buffering the .mpy data
+        mp_reader_new_file(&reader, cache_str);
+        reader_open = true;
+        bool valid = import_cache_check(&reader, hdr, true);
+        reader_open = false;
+        reader.close(reader.data);
+        if (valid) {
+            mp_reader_new_file(&reader, cache_str);
+            reader_open = true;
+            import_cache_check(&reader, hdr, false);
+            rc = mp_raw_code_load(&reader); // closes the reader
+            reader_open = false;
+        }
+        nlr_pop();
+    } else {
+        // unreadable or incompatible entry, the module is compiled again
+        if (reader_open) {
+            reader.close(reader.data);
+        }
+        rc = NULL;
+    }
+    return rc;
+}
+
+STATIC void do_load_cached(mp_obj_t module_obj, vstr_t *file) {
+    const char *file_str = vstr_null_terminated_str(file);
+
+    // the cache key is the length and hash of the source
+    uint32_t hdr[IMPORT_CACHE_HDR_NUM];
+    // the firmware is identified by its version and the options the compiled code depends on
+    uint32_t config = IMPORT_CACHE_CONFIG;
+    import_cache_sum_t sum = {0, 5381};
+    import_cache_sum_add(&sum, (const byte*)import_cache_version, sizeof(import_cache_version) - 1);
+    import_cache_sum_add(&sum, (const byte*)&config, sizeof(config));
+    hdr[IMPORT_CACHE_HDR_MAGIC] = IMPORT_CACHE_MAGIC;
+    hdr[IMPORT_CACHE_HDR_FIRMWARE] = sum.hash;
+    {
+        mp_reader_t reader;
+        mp_reader_new_file(&reader, file_str);
+        sum.len = 0;
+        sum.hash = 5381;
+        for (mp_uint_t b; (b = reader.readbyte(reader.data)) != MP_READER_EOF;) {
+            byte c = b;
+            import_cache_sum_add(&sum, &c, 1);
+        }
+        reader.close(reader.data);
+        hdr[IMPORT_CACHE_HDR_SRC_LEN] = sum.len;
+        hdr[IMPORT_CACHE_HDR_SRC_HASH] = sum.hash;
+    }
+
+    vstr_t cache_path;
+    vstr_init(&cache_path, MICROPY_ALLOC_PATH_MAX);
+    import_cache_path(&cache_path, file_str, file->len);
+    const char *cache_str = vstr_null_terminated_str(&cache_path);
+
+    mp_raw_code_t *rc = import_cache_load(cache_str, hdr);
+    if (rc == NULL) {
+        DEBUG_printf("import cache miss: %s\n", file_str);
+        mp_lexer_t *lex = mp_lexer_new_from_file(file_str);
+        qstr source_name = lex->source_name;
+        mp_parse_tree_t parse_tree = mp_parse(lex, MP_PARSE_FILE_INPUT);
+        rc = mp_compile_to_raw_code(&parse_tree, source_name, MP_EMIT_OPT_NONE, false);
+
+        // measure the .mpy data, then write the entry; a failure to write it
+        // (read-only or full filesystem) doesn't fail the import
+        nlr_buf_t nlr;
+        if (nlr_push(&nlr) == 0) {
+            sum.len = 0;
+            sum.hash = 5381;
+            mp_print_t sum_print = {&sum, import_cache_sum_print_strn};
+            mp_raw_code_save(rc, &sum_print);
+            hdr[IMPORT_CACHE_HDR_MPY_LEN] = sum.len;
+            hdr[IMPORT_CACHE_HDR_MPY_HASH] = sum.hash;
+            byte hdr_bytes[sizeof(hdr)];
+            for (size_t i = 0; i < sizeof(hdr); i++) {
+                hdr_bytes[i] = hdr[i / 4] >> (8 * (i % 4));
+            }
+            mp_raw_code_save_file_with_header(rc, cache_str, hdr_bytes, sizeof(hdr_bytes));
+            nlr_pop();
+        } else {
+            DEBUG_printf("import cache: can't write %s\n", cache_str);
+        }
+    }
+    vstr_clear(&cache_path);
+
+    #if MICROPY_PY___FILE__
+    mp_store_attr(module_obj, MP_QSTR___file__, MP_OBJ_NEW_QSTR(qstr_from_str(file_str)));
+    #endif
+
+    do_execute_raw_code(module_obj, rc);
+}
+
+#endif // MICROPY_MODULE_IMPORT_CACHE
+
 STATIC void do_load(mp_obj_t module_obj, vstr_t *file) {
     #if MICROPY_MODULE_FROZEN || MICROPY_PERSISTENT_CODE_LOAD || MICROPY_ENABLE_COMPILER
     char *file_str = vstr_null_terminated_str(file);
@@ -221,6 +436,15 @@ STATIC void do_load(mp_obj_t module_obj, vstr_t *file) {
     }
     #endif
 
+    // If the import cache is enabled then load the compiled module from it, or
+    // compile the file and store the result.
+    #if MICROPY_MODULE_IMPORT_CACHE
+    if (MP_STATE_VM(import_cache_dir) != MP_OBJ_NULL) {
+        do_load_cached(module_obj, file);
+        return;
+    }
+    #endif
+
     // If we can compile scripts then load the file and compile and execute it.
     #if MICROPY_ENABLE_COMPILER
     {
@@ -235,6 +459,21 @@ STATIC void do_load(mp_obj_t module_obj, vstr_t *file) {
     #endif
 }
 
+#if MICROPY_BOOT_TRACE
+// the kind of import that do_load performed for the given file
+STATIC mp_boot_trace_kind_t import_trace_kind(vstr_t *file) {
+    #if MICROPY_MODULE_FROZEN
+    if (mp_frozen_stat(vstr_null_terminated_str(file)) == MP_IMPORT_STAT_FILE) {
+        return MP_BOOT_TRACE_IMPORT_FROZEN;
+    }
+    #endif
+    if (file->len > 3 && vstr_str(file)[file->len - 3] == 'm') {
+        return MP_BOOT_TRACE_IMPORT_MPY;
+    }
+    return MP_BOOT_TRACE_IMPORT_PY;
+}
+#endif
+
 STATIC void chop_component(const char *start, const char **end) {
     const char *p = *end;
     while (p > start) {
@@ -410,6 +649,32 @@ mp_obj_t mp_builtin___import__(size_t n_args, const mp_obj_t *args) {
                 module_obj = mp_module_get(mod_name);
             }
 
+            #if MICROPY_BOOT_TRACE
+            bool trace_import = module_obj == MP_OBJ_NULL;
+            mp_boot_trace_kind_t trace_kind = MP_BOOT_TRACE_IMPORT_PY;
+            mp_boot_trace_span_t trace_span;
+            nlr_buf_t trace_nlr;
+            if (trace_import) {
+                mp_boot_trace_begin(&trace_span);
+                if (nlr_push(&trace_nlr) != 0) {
+                    // the import failed, the events that follow are not nested in it
+                    mp_boot_trace_cancel(&trace_span);
+                    nlr_jump(trace_nlr.ret_val);
+                }
+            }
+            #endif
+
+            #if MICROPY_MODULE_FROZEN_ROM
+            if (module_obj == MP_OBJ_NULL && stat == MP_IMPORT_STAT_FILE && fromtuple != mp_const_false) {
+                // a module frozen with its namespace laid out in ROM is set up
+                // without executing any of its code
+                module_obj = mp_frozen_rom_import(mod_name, vstr_str(&path), vstr_len(&path));
+                #if MICROPY_BOOT_TRACE
+                trace_kind = MP_BOOT_TRACE_IMPORT_ROM;
+                #endif
+            }
+            #endif
+
             if (module_obj == MP_OBJ_NULL) {
                 // module not already loaded, so load it!
 
@@ -446,16 +711,28 @@ mp_obj_t mp_builtin___import__(size_t n_args, const mp_obj_t *args) {
                         //mp_warning("%s is imported as namespace package", vstr_str(&path));
                     } else {
                         do_load(module_obj, &path);
+                        #if MICROPY_BOOT_TRACE
+                        trace_kind = import_trace_kind(&path);
+                        #endif
                     }
                     path.len = orig_path_len;
                 } else { // MP_IMPORT_STAT_FILE
                     do_load(module_obj, &path);
+                    #if MICROPY_BOOT_TRACE
+                    trace_kind = import_trace_kind(&path);
+                    #endif
                     // This should be the last component in the import path.  If there are
                     // remaining components then it's an ImportError because the current path
                     // (the module that was just loaded) is not a package.  This will be caught
                     // on the next iteration because the file will not exist.
                 }
             }
+            #if MICROPY_BOOT_TRACE
+            if (trace_import) {
+                nlr_pop();
+                mp_boot_trace_end(&trace_span, trace_kind, mod_name);
+            }
+            #endif
             if (outer_module_obj != MP_OBJ_NULL) {
                 qstr s = qstr_from_strn(mod_str + last, i - last);
                 mp_store_attr(outer_module_obj, s, module_obj);
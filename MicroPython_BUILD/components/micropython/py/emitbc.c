@@ -39,6 +39,18 @@
 #define BYTES_FOR_INT ((BYTES_PER_WORD * 8 + 6) / 7)
 #define DUMMY_DATA_SIZE (BYTES_FOR_INT)
 
+#if MICROPY_OPT_BC_PEEPHOLE
+// Instructions remembered by the peephole optimiser
+enum {
+    PEEP_NONE,
+    PEEP_LOAD_FAST,
+    PEEP_SMALL_INT,
+    PEEP_BINARY_OP,
+    PEEP_JUMP,
+};
+#define PEEP_MAX_LABELS (4)
+#endif
+
 struct _emit_t {
     // Accessed as mp_obj_t, so must be aligned as such, and we rely on the
     // memory allocator returning a suitably aligned pointer.
@@ -70,6 +82,25 @@ struct _emit_t {
     uint16_t ct_cur_raw_code;
     #endif
     mp_uint_t *const_table;
+
+    #if MICROPY_OPT_BC_PEEPHOLE
+    // The last two instructions ([0] is the most recent), they are only
+    // valid if nothing else was emitted after them (peep_end).
+    byte peep_kind[2];
+    byte peep_n_labels;
+    size_t peep_start[2];
+    size_t peep_end;
+    mp_uint_t peep_arg[2];
+    // furthest offsets written before a rewind, the buffer must have room for them
+    size_t peep_bytecode_max;
+    size_t peep_code_info_max;
+    // labels assigned just after a pending PEEP_JUMP, and the line number
+    // state to go back to if the jump is removed
+    mp_uint_t peep_labels[PEEP_MAX_LABELS];
+    size_t peep_code_info_offset;
+    mp_uint_t peep_source_line_offset;
+    mp_uint_t peep_source_line;
+    #endif
 };
 
 emit_t *emit_bc_new(void) {
@@ -306,6 +337,77 @@ STATIC void emit_write_bytecode_byte_signed_label(emit_t *emit, byte b1, mp_uint
     c[2] = bytecode_offset >> 8;
 }
 
+#if MICROPY_OPT_BC_PEEPHOLE
+// signed label followed by an extra byte, the label is relative to ip following the extra byte
+STATIC void emit_write_bytecode_byte_signed_label_byte(emit_t *emit, byte b1, mp_uint_t label, byte b2) {
+    int bytecode_offset;
+    if (emit->pass < MP_PASS_EMIT) {
+        bytecode_offset = 0;
+    } else {
+        bytecode_offset = emit->label_offsets[label] - emit->bytecode_offset - 4 + 0x8000;
+    }
+    byte *c = emit_get_cur_to_write_bytecode(emit, 4);
+    c[0] = b1;
+    c[1] = bytecode_offset;
+    c[2] = bytecode_offset >> 8;
+    c[3] = b2;
+}
+
+// The peephole optimiser works while the bytecode is emitted: the emitter
+// functions record candidate instructions and, when the next instruction
+// completes a known sequence, the candidates are rewound and replaced by a
+// superinstruction.  All passes see the same sequence of emit calls and so
+// make the same decisions, which keeps label offsets and code size stable.
+
+STATIC void emit_bc_peep_reset(emit_t *emit) {
+    emit->peep_kind[0] = PEEP_NONE;
+    emit->peep_kind[1] = PEEP_NONE;
+    emit->peep_n_labels = 0;
+}
+
+// Move back to the start of the instructions being replaced
+STATIC void emit_bc_peep_rewind(emit_t *emit, size_t start) {
+    emit->peep_bytecode_max = MAX(emit->peep_bytecode_max, emit->bytecode_offset);
+    emit->bytecode_offset = start;
+}
+
+// Record the instruction just written, starting at bytecode offset start
+STATIC void emit_bc_peep_push(emit_t *emit, byte kind, mp_uint_t arg, size_t start) {
+    if (emit->peep_end != start) {
+        emit->peep_kind[0] = PEEP_NONE;
+    }
+    emit->peep_kind[1] = emit->peep_kind[0];
+    emit->peep_start[1] = emit->peep_start[0];
+    emit->peep_arg[1] = emit->peep_arg[0];
+    emit->peep_kind[0] = kind;
+    emit->peep_start[0] = start;
+    emit->peep_arg[0] = arg;
+    emit->peep_end = emit->bytecode_offset;
+    emit->peep_n_labels = 0;
+}
+
+// Check that the most recent instruction is of kind0 and, if kind1 is given,
+// that the one before it is of kind1.  Return the offset where the matched
+// instructions start, or -1 if they can't be merged (something was emitted
+// after them or a line number entry points inside the sequence).
+STATIC size_t emit_bc_peep_match(emit_t *emit, byte kind0, byte kind1) {
+    if (emit->peep_end != emit->bytecode_offset || emit->peep_kind[0] != kind0) {
+        return (size_t)-1;
+    }
+    size_t start = emit->peep_start[0];
+    if (kind1 != PEEP_NONE) {
+        if (emit->peep_kind[1] != kind1) {
+            return (size_t)-1;
+        }
+        start = emit->peep_start[1];
+    }
+    if (emit->last_source_line_offset > start) {
+        return (size_t)-1;
+    }
+    return start;
+}
+#endif
+
 void mp_emit_bc_start_pass(emit_t *emit, pass_kind_t pass, scope_t *scope) {
     emit->pass = pass;
     emit->stack_size = 0;
@@ -321,6 +423,11 @@ void mp_emit_bc_start_pass(emit_t *emit, pass_kind_t pass, scope_t *scope) {
     #endif
     emit->bytecode_offset = 0;
     emit->code_info_offset = 0;
+    #if MICROPY_OPT_BC_PEEPHOLE
+    emit_bc_peep_reset(emit);
+    emit->peep_bytecode_max = 0;
+    emit->peep_code_info_max = 0;
+    #endif
 
     // Write local state size and exception stack size.
     {
@@ -422,6 +529,12 @@ void mp_emit_bc_end_pass(emit_t *emit) {
         #endif
 
         // calculate size of total code-info + bytecode, in bytes
+        #if MICROPY_OPT_BC_PEEPHOLE
+        // the code rewound by the peephole optimiser may have gone further than its end
+        emit->code_info_offset = MAX(emit->code_info_offset, emit->peep_code_info_max);
+        emit->bytecode_offset = MAX(emit->bytecode_offset, emit->peep_bytecode_max);
+        #endif
+
         emit->code_info_size = emit->code_info_offset;
         emit->bytecode_size = emit->bytecode_offset;
         emit->code_base = m_new0(byte, emit->code_info_size + emit->bytecode_size);
@@ -494,14 +607,46 @@ void mp_emit_bc_label_assign(emit_t *emit, mp_uint_t l) {
         return;
     }
     assert(l < emit->max_num_labels);
+    bool jump_pending = false;
+    #if MICROPY_OPT_BC_PEEPHOLE
+    size_t start = (size_t)-1;
+    if (emit->peep_kind[0] == PEEP_JUMP && emit->peep_end == emit->bytecode_offset) {
+        start = emit->peep_start[0];
+    }
+    if (start != (size_t)-1 && emit->peep_arg[0] == l) {
+        // Remove the jump to the next instruction, together with the labels
+        // and line number entries which were assigned after it.
+        mp_uint_t source_line = emit->last_source_line;
+        emit_bc_peep_rewind(emit, start);
+        emit->peep_code_info_max = MAX(emit->peep_code_info_max, emit->code_info_offset);
+        emit->code_info_offset = emit->peep_code_info_offset;
+        emit->last_source_line_offset = emit->peep_source_line_offset;
+        emit->last_source_line = emit->peep_source_line;
+        mp_emit_bc_set_source_line(emit, source_line);
+        if (emit->pass < MP_PASS_EMIT) {
+            for (size_t i = 0; i < emit->peep_n_labels; ++i) {
+                emit->label_offsets[emit->peep_labels[i]] = start;
+            }
+        }
+        emit_bc_peep_reset(emit);
+    } else if (start != (size_t)-1 && emit->peep_n_labels < PEEP_MAX_LABELS) {
+        // Keep the jump as a candidate, its target may follow.
+        emit->peep_labels[emit->peep_n_labels++] = l;
+        jump_pending = true;
+    } else {
+        emit_bc_peep_reset(emit);
+    }
+    #endif
     if (emit->pass < MP_PASS_EMIT) {
         // assign label offset
         assert(emit->label_offsets[l] == (mp_uint_t)-1);
         emit->label_offsets[l] = emit->bytecode_offset;
     } else {
-        // ensure label offset has not changed from MP_PASS_CODE_SIZE to MP_PASS_EMIT
-        assert(emit->label_offsets[l] == emit->bytecode_offset);
+        // ensure label offset has not changed from MP_PASS_CODE_SIZE to MP_PASS_EMIT,
+        // a label following a pending jump may have been moved back over it
+        assert(emit->label_offsets[l] == emit->bytecode_offset || jump_pending);
     }
+    (void)jump_pending;
 }
 
 void mp_emit_bc_import_name(emit_t *emit, qstr qst) {
@@ -534,11 +679,19 @@ void mp_emit_bc_load_const_tok(emit_t *emit, mp_token_kind_t tok) {
 
 void mp_emit_bc_load_const_small_int(emit_t *emit, mp_int_t arg) {
     emit_bc_pre(emit, 1);
+    #if MICROPY_OPT_BC_PEEPHOLE
+    size_t start = emit->bytecode_offset;
+    #endif
     if (-16 <= arg && arg <= 47) {
         emit_write_bytecode_byte(emit, MP_BC_LOAD_CONST_SMALL_INT_MULTI + 16 + arg);
     } else {
         emit_write_bytecode_byte_int(emit, MP_BC_LOAD_CONST_SMALL_INT, arg);
     }
+    #if MICROPY_OPT_BC_PEEPHOLE
+    if (-128 <= arg && arg <= 127) {
+        emit_bc_peep_push(emit, PEEP_SMALL_INT, arg, start);
+    }
+    #endif
 }
 
 void mp_emit_bc_load_const_str(emit_t *emit, qstr qst) {
@@ -559,11 +712,19 @@ void mp_emit_bc_load_null(emit_t *emit) {
 void mp_emit_bc_load_fast(emit_t *emit, qstr qst, mp_uint_t local_num) {
     (void)qst;
     emit_bc_pre(emit, 1);
+    #if MICROPY_OPT_BC_PEEPHOLE
+    size_t start = emit->bytecode_offset;
+    #endif
     if (local_num <= 15) {
         emit_write_bytecode_byte(emit, MP_BC_LOAD_FAST_MULTI + local_num);
     } else {
         emit_write_bytecode_byte_uint(emit, MP_BC_LOAD_FAST_N, local_num);
     }
+    #if MICROPY_OPT_BC_PEEPHOLE
+    if (local_num <= 255) {
+        emit_bc_peep_push(emit, PEEP_LOAD_FAST, local_num, start);
+    }
+    #endif
 }
 
 void mp_emit_bc_load_deref(emit_t *emit, qstr qst, mp_uint_t local_num) {
@@ -592,6 +753,20 @@ void mp_emit_bc_load_global(emit_t *emit, qstr qst) {
 
 void mp_emit_bc_load_attr(emit_t *emit, qstr qst) {
     emit_bc_pre(emit, 0);
+    #if MICROPY_OPT_BC_PEEPHOLE
+    if (!MICROPY_OPT_CACHE_MAP_LOOKUP_IN_BYTECODE_DYNAMIC) {
+        size_t start = emit_bc_peep_match(emit, PEEP_LOAD_FAST, PEEP_NONE);
+        if (start != (size_t)-1) {
+            // LOAD_FAST + LOAD_ATTR
+            mp_uint_t local_num = emit->peep_arg[0];
+            emit_bc_peep_rewind(emit, start);
+            emit_write_bytecode_byte_qstr(emit, MP_BC_LOAD_FAST_ATTR, qst);
+            emit_write_bytecode_byte(emit, local_num);
+            emit_bc_peep_reset(emit);
+            return;
+        }
+    }
+    #endif
     emit_write_bytecode_byte_qstr(emit, MP_BC_LOAD_ATTR, qst);
     if (MICROPY_OPT_CACHE_MAP_LOOKUP_IN_BYTECODE_DYNAMIC) {
         emit_write_bytecode_byte(emit, 0);
@@ -711,11 +886,32 @@ void mp_emit_bc_rot_three(emit_t *emit) {
 
 void mp_emit_bc_jump(emit_t *emit, mp_uint_t label) {
     emit_bc_pre(emit, 0);
+    #if MICROPY_OPT_BC_PEEPHOLE
+    size_t start = emit->bytecode_offset;
+    #endif
     emit_write_bytecode_byte_signed_label(emit, MP_BC_JUMP, label);
+    #if MICROPY_OPT_BC_PEEPHOLE
+    emit_bc_peep_push(emit, PEEP_JUMP, label, start);
+    emit->peep_code_info_offset = emit->code_info_offset;
+    emit->peep_source_line_offset = emit->last_source_line_offset;
+    emit->peep_source_line = emit->last_source_line;
+    #endif
 }
 
 void mp_emit_bc_pop_jump_if(emit_t *emit, bool cond, mp_uint_t label) {
     emit_bc_pre(emit, -1);
+    #if MICROPY_OPT_BC_PEEPHOLE
+    size_t start = emit_bc_peep_match(emit, PEEP_BINARY_OP, PEEP_NONE);
+    if (start != (size_t)-1) {
+        // BINARY_OP + POP_JUMP_IF
+        byte op = emit->peep_arg[0];
+        emit_bc_peep_rewind(emit, start);
+        emit_write_bytecode_byte_signed_label_byte(emit,
+            cond ? MP_BC_BINARY_OP_POP_JUMP_IF_TRUE : MP_BC_BINARY_OP_POP_JUMP_IF_FALSE, label, op);
+        emit_bc_peep_reset(emit);
+        return;
+    }
+    #endif
     if (cond) {
         emit_write_bytecode_byte_signed_label(emit, MP_BC_POP_JUMP_IF_TRUE, label);
     } else {
@@ -820,7 +1016,31 @@ void mp_emit_bc_binary_op(emit_t *emit, mp_binary_op_t op) {
         op = MP_BINARY_OP_IS;
     }
     emit_bc_pre(emit, -1);
+    #if MICROPY_OPT_BC_PEEPHOLE
+    size_t start = emit_bc_peep_match(emit, PEEP_SMALL_INT, PEEP_LOAD_FAST);
+    if (start != (size_t)-1) {
+        // LOAD_FAST + LOAD_CONST_SMALL_INT + BINARY_OP
+        byte *c;
+        mp_uint_t local_num = emit->peep_arg[1];
+        mp_int_t arg = emit->peep_arg[0];
+        emit_bc_peep_rewind(emit, start);
+        c = emit_get_cur_to_write_bytecode(emit, 4);
+        c[0] = MP_BC_LOAD_FAST_CONST_BINARY_OP;
+        c[1] = local_num;
+        c[2] = arg;
+        c[3] = op;
+        emit_bc_peep_reset(emit);
+    } else {
+        start = emit->bytecode_offset;
+        emit_write_bytecode_byte(emit, MP_BC_BINARY_OP_MULTI + op);
+        if (!invert && op <= MP_BINARY_OP_NOT_EQUAL) {
+            // comparison, may be merged with the following conditional jump
+            emit_bc_peep_push(emit, PEEP_BINARY_OP, op, start);
+        }
+    }
+    #else
     emit_write_bytecode_byte(emit, MP_BC_BINARY_OP_MULTI + op);
+    #endif
     if (invert) {
         emit_bc_pre(emit, 0);
         emit_write_bytecode_byte(emit, MP_BC_UNARY_OP_MULTI + MP_UNARY_OP_NOT);
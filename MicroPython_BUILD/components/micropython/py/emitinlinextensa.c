@@ -280,7 +280,7 @@ STATIC void emit_inline_xtensa_op(emit_inline_asm_t *emit, qstr op, mp_uint_t n_
         } else if (op == MP_QSTR_movi) {
             // for convenience we emit l32r if the integer doesn't fit in movi
             uint32_t imm = get_arg_i(emit, op_str, pn_args[1], 0, 0);
-            asm_xtensa_mov_reg_i32(&emit->as, r0, imm);
+            asm_xtensa_mov_reg_i32_optimised(&emit->as, r0, imm);
         } else {
             goto unknown_op;
         }
@@ -62,6 +62,7 @@
     || (MICROPY_EMIT_THUMB && N_THUMB) \
     || (MICROPY_EMIT_ARM && N_ARM) \
     || (MICROPY_EMIT_XTENSA && N_XTENSA) \
+    || (MICROPY_EMIT_XTENSAWIN && N_XTENSAWIN) \
 
 // define additional generic helper macros
 #define ASM_MOV_LOCAL_IMM_VIA(as, local_num, imm, reg_temp) \
@@ -70,6 +71,44 @@
         ASM_MOV_LOCAL_REG((as), (local_num), (reg_temp)); \
     } while (false)
 
+// Values which depend on the running firmware (runtime functions, qstrs and
+// constant objects) are recorded so native code can be saved to a .mpy file
+// and linked when it is loaded.  This needs the assembler to be able to store
+// an immediate as a full word at a known offset in the code.  Only mpy-cross
+// and the import cache save native code.
+#if MICROPY_PERSISTENT_CODE_SAVE && (MICROPY_DYNAMIC_COMPILER || MICROPY_MODULE_IMPORT_CACHE) && defined(ASM_MOV_REG_IMM_FIX_WORD)
+#define N_LINK (1)
+#else
+#define N_LINK (0)
+#endif
+
+// The firmware records the values only while the import cache is in use, as
+// the code compiled then may be written to the cache.
+#if MICROPY_DYNAMIC_COMPILER
+#define N_LINK_IN_USE() (true)
+#else
+#define N_LINK_IN_USE() (MP_STATE_VM(import_cache_dir) != MP_OBJ_NULL)
+#endif
+
+// With setjmp based nlr the native code calls nlr_push_tail, and then setjmp
+// itself so that the jmp_buf captures the context of the native function.
+#if N_XTENSAWIN || (!MICROPY_DYNAMIC_COMPILER && MICROPY_NLR_SETJMP)
+#define N_NLR_SETJMP (1)
+#else
+#define N_NLR_SETJMP (0)
+#endif
+
+// Size of nlr_buf_t in words; when cross compiling it is the size on the target
+#if MICROPY_DYNAMIC_COMPILER && N_X64
+#define NLR_BUF_NSLOTS (2 + 8)
+#elif MICROPY_DYNAMIC_COMPILER && N_XTENSA
+#define NLR_BUF_NSLOTS (2 + 10)
+#elif MICROPY_DYNAMIC_COMPILER && N_XTENSAWIN
+#define NLR_BUF_NSLOTS (2 + 17) // jmp_buf of the windowed ABI
+#else
+#define NLR_BUF_NSLOTS (sizeof(nlr_buf_t) / sizeof(uintptr_t))
+#endif
+
 #define EMIT_NATIVE_VIPER_TYPE_ERROR(emit, ...) do { \
         *emit->error_slot = mp_obj_new_exception_msg_varg(&mp_type_ViperTypeError, __VA_ARGS__); \
     } while (0)
@@ -146,6 +185,13 @@ struct _emit_t {
 
     scope_t *scope;
 
+    #if N_LINK
+    bool do_link;
+    size_t link_alloc;
+    size_t link_len;
+    mp_native_link_t *link;
+    #endif
+
     ASM_T *as;
 };
 
@@ -162,9 +208,29 @@ void EXPORT_FUN(free)(emit_t *emit) {
     m_del_obj(ASM_T, emit->as);
     m_del(vtype_kind_t, emit->local_vtype, emit->local_vtype_alloc);
     m_del(stack_info_t, emit->stack_info, emit->stack_info_alloc);
+    #if N_LINK
+    m_del(mp_native_link_t, emit->link, emit->link_alloc);
+    #endif
     m_del_obj(emit_t, emit);
 }
 
+#if N_LINK
+// record a value at the given offset in the code which is linked at load time
+STATIC void emit_native_link(emit_t *emit, size_t offset, mp_native_link_kind_t kind, mp_uint_t arg) {
+    if (!emit->do_link || emit->pass != MP_PASS_EMIT) {
+        return;
+    }
+    if (emit->link_len >= emit->link_alloc) {
+        emit->link = m_renew(mp_native_link_t, emit->link, emit->link_alloc, emit->link_alloc + 16);
+        emit->link_alloc += 16;
+    }
+    mp_native_link_t *link = &emit->link[emit->link_len++];
+    link->offset = offset;
+    link->kind = kind;
+    link->arg = arg;
+}
+#endif
+
 STATIC void emit_native_set_native_type(emit_t *emit, mp_uint_t op, mp_uint_t arg1, qstr arg2) {
     switch (op) {
         case MP_EMIT_NATIVE_TYPE_ENABLE:
@@ -197,6 +263,8 @@ STATIC void emit_native_set_native_type(emit_t *emit, mp_uint_t op, mp_uint_t ar
 
 STATIC void emit_pre_pop_reg(emit_t *emit, vtype_kind_t *vtype, int reg_dest);
 STATIC void emit_post_push_reg(emit_t *emit, vtype_kind_t vtype, int reg);
+STATIC void emit_native_call_ind(emit_t *emit, mp_fun_kind_t fun_kind);
+STATIC void emit_native_mov_reg_linked(emit_t *emit, int reg_dest, mp_native_link_kind_t kind, mp_uint_t arg, mp_uint_t val);
 STATIC void emit_native_load_fast(emit_t *emit, qstr qst, mp_uint_t local_num);
 STATIC void emit_native_store_fast(emit_t *emit, qstr qst, mp_uint_t local_num);
 
@@ -210,6 +278,10 @@ STATIC void emit_native_start_pass(emit_t *emit, pass_kind_t pass, scope_t *scop
     emit->stack_size = 0;
     emit->last_emit_was_return_value = false;
     emit->scope = scope;
+    #if N_LINK
+    emit->do_link = N_LINK_IN_USE();
+    emit->link_len = 0;
+    #endif
 
     // allocate memory for keeping track of the types of locals
     if (emit->local_vtype_alloc < scope->num_locals) {
@@ -295,6 +367,21 @@ STATIC void emit_native_start_pass(emit_t *emit, pass_kind_t pass, scope_t *scop
                 asm_x86_mov_r32_to_local(emit->as, REG_TEMP0, i - REG_LOCAL_NUM);
             }
         }
+        #elif N_XTENSAWIN
+        // the incoming arguments overlap the local registers, so move them
+        // from the last one
+        for (int i = scope->num_pos_args - 1; i >= 0; i--) {
+            if (i == 0) {
+                ASM_MOV_REG_REG(emit->as, REG_LOCAL_1, REG_PARENT_ARG_1);
+            } else if (i == 1) {
+                ASM_MOV_REG_REG(emit->as, REG_LOCAL_2, REG_PARENT_ARG_2);
+            } else if (i == 2) {
+                ASM_MOV_REG_REG(emit->as, REG_LOCAL_3, REG_PARENT_ARG_3);
+            } else {
+                assert(i == 3); // should be true; max 4 args is checked above
+                ASM_MOV_LOCAL_REG(emit->as, i - REG_LOCAL_NUM, REG_PARENT_ARG_4);
+            }
+        }
         #else
         for (int i = 0; i < scope->num_pos_args; i++) {
             if (i == 0) {
@@ -333,12 +420,27 @@ STATIC void emit_native_start_pass(emit_t *emit, pass_kind_t pass, scope_t *scop
         asm_x86_mov_arg_to_r32(emit->as, 3, REG_ARG_4);
         #endif
 
+        #if N_XTENSAWIN
+        // set code_state.fun_bc, and pass on the other incoming arguments
+        ASM_MOV_LOCAL_REG(emit->as, offsetof(mp_code_state_t, fun_bc) / sizeof(uintptr_t), REG_PARENT_ARG_1);
+        ASM_MOV_REG_REG(emit->as, REG_ARG_2, REG_PARENT_ARG_2);
+        ASM_MOV_REG_REG(emit->as, REG_ARG_3, REG_PARENT_ARG_3);
+        ASM_MOV_REG_REG(emit->as, REG_ARG_4, REG_PARENT_ARG_4);
+        #else
         // set code_state.fun_bc
         ASM_MOV_LOCAL_REG(emit->as, offsetof(mp_code_state_t, fun_bc) / sizeof(uintptr_t), REG_ARG_1);
+        #endif
 
         // set code_state.ip (offset from start of this function to prelude info)
+        #if N_XTENSA || N_XTENSAWIN
+        // the offset changes between passes so it must always use the same
+        // encoding, otherwise the size of the constant table would change
+        ASM_MOV_REG_IMM_FIX_WORD(emit->as, REG_ARG_1, emit->prelude_offset);
+        ASM_MOV_LOCAL_REG(emit->as, offsetof(mp_code_state_t, ip) / sizeof(uintptr_t), REG_ARG_1);
+        #else
         // XXX this encoding may change size
         ASM_MOV_LOCAL_IMM_VIA(emit->as, offsetof(mp_code_state_t, ip) / sizeof(uintptr_t), emit->prelude_offset, REG_ARG_1);
+        #endif
 
         // put address of code_state into first arg
         ASM_MOV_REG_LOCAL_ADDR(emit->as, REG_ARG_1, 0);
@@ -349,7 +451,7 @@ STATIC void emit_native_start_pass(emit_t *emit, pass_kind_t pass, scope_t *scop
         #elif N_ARM
         asm_arm_bl_ind(emit->as, mp_fun_table[MP_F_SETUP_CODE_STATE], MP_F_SETUP_CODE_STATE, ASM_ARM_REG_R4);
         #else
-        ASM_CALL_IND(emit->as, mp_fun_table[MP_F_SETUP_CODE_STATE], MP_F_SETUP_CODE_STATE);
+        emit_native_call_ind(emit, MP_F_SETUP_CODE_STATE);
         #endif
 
         // cache some locals in registers
@@ -392,6 +494,10 @@ STATIC void emit_native_end_pass(emit_t *emit) {
         // write code info
         #if MICROPY_PERSISTENT_CODE
         mp_asm_base_data(&emit->as->base, 1, 5);
+        #if N_LINK
+        emit_native_link(emit, mp_asm_base_get_code_pos(&emit->as->base), MP_NATIVE_LINK_QSTR16, emit->scope->simple_name);
+        emit_native_link(emit, mp_asm_base_get_code_pos(&emit->as->base) + 2, MP_NATIVE_LINK_QSTR16, emit->scope->source_file);
+        #endif
         mp_asm_base_data(&emit->as->base, 1, emit->scope->simple_name);
         mp_asm_base_data(&emit->as->base, 1, emit->scope->simple_name >> 8);
         mp_asm_base_data(&emit->as->base, 1, emit->scope->source_file);
@@ -424,6 +530,9 @@ STATIC void emit_native_end_pass(emit_t *emit) {
                     break;
                 }
             }
+            #if N_LINK
+            emit_native_link(emit, mp_asm_base_get_code_pos(&emit->as->base), MP_NATIVE_LINK_QSTR_OBJ, qst);
+            #endif
             mp_asm_base_data(&emit->as->base, ASM_WORD_SIZE, (mp_uint_t)MP_OBJ_NEW_QSTR(qst));
         }
 
@@ -445,9 +554,25 @@ STATIC void emit_native_end_pass(emit_t *emit) {
             type_sig |= (emit->local_vtype[i] & 0xf) << (i * 4 + 4);
         }
 
+        #if MICROPY_PERSISTENT_CODE_SAVE
+        // keep the values to link with the raw code
+        mp_native_link_t *link = NULL;
+        size_t n_link = 0;
+        #if N_LINK
+        if (emit->do_link) {
+            n_link = emit->link_len;
+            link = m_new(mp_native_link_t, n_link);
+            memcpy(link, emit->link, n_link * sizeof(mp_native_link_t));
+        }
+        #endif
+        #endif
+
         mp_emit_glue_assign_native(emit->scope->raw_code,
             emit->do_viper_types ? MP_CODE_NATIVE_VIPER : MP_CODE_NATIVE_PY,
             f, f_len, (mp_uint_t*)((byte*)f + emit->const_table_offset),
+            #if MICROPY_PERSISTENT_CODE_SAVE
+            link, n_link,
+            #endif
             emit->scope->num_pos_args, emit->scope->scope_flags, type_sig);
     }
 }
@@ -674,38 +799,88 @@ STATIC void emit_post_push_reg_reg_reg_reg(emit_t *emit, vtype_kind_t vtypea, in
     emit_post_push_reg(emit, vtyped, regd);
 }
 
+// Load a value which depends on the running firmware into a register.  When
+// the code can be saved to a .mpy file the value is stored as a full word and
+// recorded so it can be linked when the code is loaded.
+STATIC void emit_native_mov_reg_linked(emit_t *emit, int reg_dest, mp_native_link_kind_t kind, mp_uint_t arg, mp_uint_t val) {
+    #if N_LINK
+    if (emit->do_link) {
+        emit_native_link(emit, ASM_MOV_REG_IMM_FIX_WORD(emit->as, reg_dest, val), kind, arg);
+        return;
+    }
+    #endif
+    (void)arg;
+    if (kind == MP_NATIVE_LINK_OBJ || kind == MP_NATIVE_LINK_RAW_CODE) {
+        // the value is stored in the code aligned on a mp_uint_t boundary
+        ASM_MOV_REG_ALIGNED_IMM(emit->as, reg_dest, val);
+    } else {
+        ASM_MOV_REG_IMM(emit->as, reg_dest, val);
+    }
+}
+
+STATIC mp_uint_t native_const_obj(mp_native_const_t c) {
+    switch (c) {
+        case MP_NATIVE_CONST_NONE: return (mp_uint_t)mp_const_none;
+        case MP_NATIVE_CONST_FALSE: return (mp_uint_t)mp_const_false;
+        case MP_NATIVE_CONST_TRUE: return (mp_uint_t)mp_const_true;
+        case MP_NATIVE_CONST_STOP_ITERATION: return (mp_uint_t)MP_OBJ_STOP_ITERATION;
+        case MP_NATIVE_CONST_SENTINEL: return (mp_uint_t)MP_OBJ_SENTINEL;
+        default: return (mp_uint_t)&mp_const_ellipsis_obj;
+    }
+}
+
+STATIC void emit_native_mov_reg_const(emit_t *emit, int reg_dest, mp_native_const_t c) {
+    emit_native_mov_reg_linked(emit, reg_dest, MP_NATIVE_LINK_CONST, c, native_const_obj(c));
+}
+
+STATIC void emit_native_mov_reg_qstr(emit_t *emit, int reg_dest, qstr qst) {
+    emit_native_mov_reg_linked(emit, reg_dest, MP_NATIVE_LINK_QSTR, qst, qst);
+}
+
+// push a constant object; if it must be linked it is loaded into a register
+STATIC void emit_post_push_const(emit_t *emit, mp_native_link_kind_t kind, mp_uint_t arg, mp_uint_t val) {
+    #if N_LINK
+    need_reg_single(emit, REG_RET, 0);
+    emit_native_mov_reg_linked(emit, REG_RET, kind, arg, val);
+    emit_post_push_reg(emit, VTYPE_PYOBJ, REG_RET);
+    #else
+    (void)kind;
+    (void)arg;
+    emit_post_push_imm(emit, VTYPE_PYOBJ, val);
+    #endif
+}
+
+STATIC void emit_native_call_ind(emit_t *emit, mp_fun_kind_t fun_kind) {
+    #if N_LINK
+    emit_native_mov_reg_linked(emit, REG_CALL, MP_NATIVE_LINK_FUN, fun_kind, (mp_uint_t)mp_fun_table[fun_kind]);
+    ASM_CALL_REG(emit->as, REG_CALL);
+    #else
+    ASM_CALL_IND(emit->as, mp_fun_table[fun_kind], fun_kind);
+    #endif
+}
+
 STATIC void emit_call(emit_t *emit, mp_fun_kind_t fun_kind) {
     need_reg_all(emit);
-    ASM_CALL_IND(emit->as, mp_fun_table[fun_kind], fun_kind);
+    emit_native_call_ind(emit, fun_kind);
 }
 
 STATIC void emit_call_with_imm_arg(emit_t *emit, mp_fun_kind_t fun_kind, mp_int_t arg_val, int arg_reg) {
     need_reg_all(emit);
     ASM_MOV_REG_IMM(emit->as, arg_reg, arg_val);
-    ASM_CALL_IND(emit->as, mp_fun_table[fun_kind], fun_kind);
+    emit_native_call_ind(emit, fun_kind);
 }
 
-// the first arg is stored in the code aligned on a mp_uint_t boundary
-STATIC void emit_call_with_imm_arg_aligned(emit_t *emit, mp_fun_kind_t fun_kind, mp_int_t arg_val, int arg_reg) {
+STATIC void emit_call_with_qstr_arg(emit_t *emit, mp_fun_kind_t fun_kind, qstr qst, int arg_reg) {
     need_reg_all(emit);
-    ASM_MOV_REG_ALIGNED_IMM(emit->as, arg_reg, arg_val);
-    ASM_CALL_IND(emit->as, mp_fun_table[fun_kind], fun_kind);
+    emit_native_mov_reg_qstr(emit, arg_reg, qst);
+    emit_native_call_ind(emit, fun_kind);
 }
 
 STATIC void emit_call_with_2_imm_args(emit_t *emit, mp_fun_kind_t fun_kind, mp_int_t arg_val1, int arg_reg1, mp_int_t arg_val2, int arg_reg2) {
     need_reg_all(emit);
     ASM_MOV_REG_IMM(emit->as, arg_reg1, arg_val1);
     ASM_MOV_REG_IMM(emit->as, arg_reg2, arg_val2);
-    ASM_CALL_IND(emit->as, mp_fun_table[fun_kind], fun_kind);
-}
-
-// the first arg is stored in the code aligned on a mp_uint_t boundary
-STATIC void emit_call_with_3_imm_args_and_first_aligned(emit_t *emit, mp_fun_kind_t fun_kind, mp_int_t arg_val1, int arg_reg1, mp_int_t arg_val2, int arg_reg2, mp_int_t arg_val3, int arg_reg3) {
-    need_reg_all(emit);
-    ASM_MOV_REG_ALIGNED_IMM(emit->as, arg_reg1, arg_val1);
-    ASM_MOV_REG_IMM(emit->as, arg_reg2, arg_val2);
-    ASM_MOV_REG_IMM(emit->as, arg_reg3, arg_val3);
-    ASM_CALL_IND(emit->as, mp_fun_table[fun_kind], fun_kind);
+    emit_native_call_ind(emit, fun_kind);
 }
 
 // vtype of all n_pop objects is VTYPE_PYOBJ
@@ -727,11 +902,8 @@ STATIC void emit_get_stack_pointer_to_reg_for_pop(emit_t *emit, mp_uint_t reg_de
                     ASM_MOV_LOCAL_IMM_VIA(emit->as, emit->stack_start + emit->stack_size - 1 - i, si->data.u_imm, reg_dest);
                     break;
                 case VTYPE_BOOL:
-                    if (si->data.u_imm == 0) {
-                        ASM_MOV_LOCAL_IMM_VIA(emit->as, emit->stack_start + emit->stack_size - 1 - i, (mp_uint_t)mp_const_false, reg_dest);
-                    } else {
-                        ASM_MOV_LOCAL_IMM_VIA(emit->as, emit->stack_start + emit->stack_size - 1 - i, (mp_uint_t)mp_const_true, reg_dest);
-                    }
+                    emit_native_mov_reg_const(emit, reg_dest, si->data.u_imm == 0 ? MP_NATIVE_CONST_FALSE : MP_NATIVE_CONST_TRUE);
+                    ASM_MOV_LOCAL_REG(emit->as, emit->stack_start + emit->stack_size - 1 - i, reg_dest);
                     si->vtype = VTYPE_PYOBJ;
                     break;
                 case VTYPE_INT:
@@ -797,7 +969,7 @@ STATIC void emit_native_import_name(emit_t *emit, qstr qst) {
         stack_info_t *top = peek_stack(emit, 0);
         if (top->vtype == VTYPE_PTR_NONE) {
             emit_pre_pop_discard(emit);
-            ASM_MOV_REG_IMM(emit->as, REG_ARG_2, (mp_uint_t)mp_const_none);
+            emit_native_mov_reg_const(emit, REG_ARG_2, MP_NATIVE_CONST_NONE);
         } else {
             vtype_kind_t vtype_fromlist;
             emit_pre_pop_reg(emit, &vtype_fromlist, REG_ARG_2);
@@ -818,7 +990,7 @@ STATIC void emit_native_import_name(emit_t *emit, qstr qst) {
         assert(vtype_level == VTYPE_PYOBJ);
     }
 
-    emit_call_with_imm_arg(emit, MP_F_IMPORT_NAME, qst, REG_ARG_1); // arg1 = import name
+    emit_call_with_qstr_arg(emit, MP_F_IMPORT_NAME, qst, REG_ARG_1); // arg1 = import name
     emit_post_push_reg(emit, VTYPE_PYOBJ, REG_RET);
 }
 
@@ -828,7 +1000,7 @@ STATIC void emit_native_import_from(emit_t *emit, qstr qst) {
     vtype_kind_t vtype_module;
     emit_access_stack(emit, 1, &vtype_module, REG_ARG_1); // arg1 = module
     assert(vtype_module == VTYPE_PYOBJ);
-    emit_call_with_imm_arg(emit, MP_F_IMPORT_FROM, qst, REG_ARG_2); // arg2 = import name
+    emit_call_with_qstr_arg(emit, MP_F_IMPORT_FROM, qst, REG_ARG_2); // arg2 = import name
     emit_post_push_reg(emit, VTYPE_PYOBJ, REG_RET);
 }
 
@@ -844,29 +1016,26 @@ STATIC void emit_native_import_star(emit_t *emit) {
 STATIC void emit_native_load_const_tok(emit_t *emit, mp_token_kind_t tok) {
     DEBUG_printf("load_const_tok(tok=%u)\n", tok);
     emit_native_pre(emit);
-    vtype_kind_t vtype;
-    mp_uint_t val;
-    if (emit->do_viper_types) {
+    if (emit->do_viper_types && tok != MP_TOKEN_ELLIPSIS) {
         switch (tok) {
-            case MP_TOKEN_KW_NONE: vtype = VTYPE_PTR_NONE; val = 0; break;
-            case MP_TOKEN_KW_FALSE: vtype = VTYPE_BOOL; val = 0; break;
-            case MP_TOKEN_KW_TRUE: vtype = VTYPE_BOOL; val = 1; break;
+            case MP_TOKEN_KW_NONE: emit_post_push_imm(emit, VTYPE_PTR_NONE, 0); break;
+            case MP_TOKEN_KW_FALSE: emit_post_push_imm(emit, VTYPE_BOOL, 0); break;
             default:
-                assert(tok == MP_TOKEN_ELLIPSIS);
-                vtype = VTYPE_PYOBJ; val = (mp_uint_t)&mp_const_ellipsis_obj; break;
+                assert(tok == MP_TOKEN_KW_TRUE);
+                emit_post_push_imm(emit, VTYPE_BOOL, 1); break;
         }
     } else {
-        vtype = VTYPE_PYOBJ;
+        mp_native_const_t c;
         switch (tok) {
-            case MP_TOKEN_KW_NONE: val = (mp_uint_t)mp_const_none; break;
-            case MP_TOKEN_KW_FALSE: val = (mp_uint_t)mp_const_false; break;
-            case MP_TOKEN_KW_TRUE: val = (mp_uint_t)mp_const_true; break;
+            case MP_TOKEN_KW_NONE: c = MP_NATIVE_CONST_NONE; break;
+            case MP_TOKEN_KW_FALSE: c = MP_NATIVE_CONST_FALSE; break;
+            case MP_TOKEN_KW_TRUE: c = MP_NATIVE_CONST_TRUE; break;
             default:
                 assert(tok == MP_TOKEN_ELLIPSIS);
-                val = (mp_uint_t)&mp_const_ellipsis_obj; break;
+                c = MP_NATIVE_CONST_ELLIPSIS; break;
         }
+        emit_post_push_const(emit, MP_NATIVE_LINK_CONST, c, native_const_obj(c));
     }
-    emit_post_push_imm(emit, vtype, val);
 }
 
 STATIC void emit_native_load_const_small_int(emit_t *emit, mp_int_t arg) {
@@ -890,14 +1059,14 @@ STATIC void emit_native_load_const_str(emit_t *emit, qstr qst) {
     } else
     */
     {
-        emit_post_push_imm(emit, VTYPE_PYOBJ, (mp_uint_t)MP_OBJ_NEW_QSTR(qst));
+        emit_post_push_const(emit, MP_NATIVE_LINK_QSTR_OBJ, qst, (mp_uint_t)MP_OBJ_NEW_QSTR(qst));
     }
 }
 
 STATIC void emit_native_load_const_obj(emit_t *emit, mp_obj_t obj) {
     emit_native_pre(emit);
     need_reg_single(emit, REG_RET, 0);
-    ASM_MOV_REG_ALIGNED_IMM(emit->as, REG_RET, (mp_uint_t)obj);
+    emit_native_mov_reg_linked(emit, REG_RET, MP_NATIVE_LINK_OBJ, (mp_uint_t)obj, (mp_uint_t)obj);
     emit_post_push_reg(emit, VTYPE_PYOBJ, REG_RET);
 }
 
@@ -945,7 +1114,7 @@ STATIC void emit_native_load_deref(emit_t *emit, qstr qst, mp_uint_t local_num)
 STATIC void emit_native_load_name(emit_t *emit, qstr qst) {
     DEBUG_printf("load_name(%s)\n", qstr_str(qst));
     emit_native_pre(emit);
-    emit_call_with_imm_arg(emit, MP_F_LOAD_NAME, qst, REG_ARG_1);
+    emit_call_with_qstr_arg(emit, MP_F_LOAD_NAME, qst, REG_ARG_1);
     emit_post_push_reg(emit, VTYPE_PYOBJ, REG_RET);
 }
 
@@ -966,7 +1135,7 @@ STATIC void emit_native_load_global(emit_t *emit, qstr qst) {
     } else if (emit->do_viper_types && qst == MP_QSTR_ptr32) {
         emit_post_push_imm(emit, VTYPE_BUILTIN_CAST, VTYPE_PTR32);
     } else {
-        emit_call_with_imm_arg(emit, MP_F_LOAD_GLOBAL, qst, REG_ARG_1);
+        emit_call_with_qstr_arg(emit, MP_F_LOAD_GLOBAL, qst, REG_ARG_1);
         emit_post_push_reg(emit, VTYPE_PYOBJ, REG_RET);
     }
 }
@@ -979,7 +1148,7 @@ STATIC void emit_native_load_attr(emit_t *emit, qstr qst) {
     vtype_kind_t vtype_base;
     emit_pre_pop_reg(emit, &vtype_base, REG_ARG_1); // arg1 = base
     assert(vtype_base == VTYPE_PYOBJ);
-    emit_call_with_imm_arg(emit, MP_F_LOAD_ATTR, qst, REG_ARG_2); // arg2 = attribute name
+    emit_call_with_qstr_arg(emit, MP_F_LOAD_ATTR, qst, REG_ARG_2); // arg2 = attribute name
     emit_post_push_reg(emit, VTYPE_PYOBJ, REG_RET);
 }
 
@@ -987,13 +1156,13 @@ STATIC void emit_native_load_method(emit_t *emit, qstr qst, bool is_super) {
     if (is_super) {
         emit_get_stack_pointer_to_reg_for_pop(emit, REG_ARG_2, 3); // arg2 = dest ptr
         emit_get_stack_pointer_to_reg_for_push(emit, REG_ARG_2, 2); // arg2 = dest ptr
-        emit_call_with_imm_arg(emit, MP_F_LOAD_SUPER_METHOD, qst, REG_ARG_1); // arg1 = method name
+        emit_call_with_qstr_arg(emit, MP_F_LOAD_SUPER_METHOD, qst, REG_ARG_1); // arg1 = method name
     } else {
         vtype_kind_t vtype_base;
         emit_pre_pop_reg(emit, &vtype_base, REG_ARG_1); // arg1 = base
         assert(vtype_base == VTYPE_PYOBJ);
         emit_get_stack_pointer_to_reg_for_push(emit, REG_ARG_3, 2); // arg3 = dest ptr
-        emit_call_with_imm_arg(emit, MP_F_LOAD_METHOD, qst, REG_ARG_2); // arg2 = method name
+        emit_call_with_qstr_arg(emit, MP_F_LOAD_METHOD, qst, REG_ARG_2); // arg2 = method name
     }
 }
 
@@ -1023,7 +1192,9 @@ STATIC void emit_native_load_subscr(emit_t *emit) {
             ASM_MOV_REG_REG(emit->as, REG_ARG_2, REG_RET);
         }
         emit_pre_pop_reg(emit, &vtype_base, REG_ARG_1);
-        emit_call_with_imm_arg(emit, MP_F_OBJ_SUBSCR, (mp_uint_t)MP_OBJ_SENTINEL, REG_ARG_3);
+        need_reg_all(emit);
+        emit_native_mov_reg_const(emit, REG_ARG_3, MP_NATIVE_CONST_SENTINEL);
+        emit_native_call_ind(emit, MP_F_OBJ_SUBSCR);
         emit_post_push_reg(emit, VTYPE_PYOBJ, REG_RET);
     } else {
         // viper load
@@ -1187,7 +1358,7 @@ STATIC void emit_native_store_name(emit_t *emit, qstr qst) {
     vtype_kind_t vtype;
     emit_pre_pop_reg(emit, &vtype, REG_ARG_2);
     assert(vtype == VTYPE_PYOBJ);
-    emit_call_with_imm_arg(emit, MP_F_STORE_NAME, qst, REG_ARG_1); // arg1 = name
+    emit_call_with_qstr_arg(emit, MP_F_STORE_NAME, qst, REG_ARG_1); // arg1 = name
     emit_post(emit);
 }
 
@@ -1200,7 +1371,7 @@ STATIC void emit_native_store_global(emit_t *emit, qstr qst) {
         emit_call_with_imm_arg(emit, MP_F_CONVERT_NATIVE_TO_OBJ, vtype, REG_ARG_2); // arg2 = type
         ASM_MOV_REG_REG(emit->as, REG_ARG_2, REG_RET);
     }
-    emit_call_with_imm_arg(emit, MP_F_STORE_GLOBAL, qst, REG_ARG_1); // arg1 = name
+    emit_call_with_qstr_arg(emit, MP_F_STORE_GLOBAL, qst, REG_ARG_1); // arg1 = name
     emit_post(emit);
 }
 
@@ -1209,7 +1380,7 @@ STATIC void emit_native_store_attr(emit_t *emit, qstr qst) {
     emit_pre_pop_reg_reg(emit, &vtype_base, REG_ARG_1, &vtype_val, REG_ARG_3); // arg1 = base, arg3 = value
     assert(vtype_base == VTYPE_PYOBJ);
     assert(vtype_val == VTYPE_PYOBJ);
-    emit_call_with_imm_arg(emit, MP_F_STORE_ATTR, qst, REG_ARG_2); // arg2 = attribute name
+    emit_call_with_qstr_arg(emit, MP_F_STORE_ATTR, qst, REG_ARG_2); // arg2 = attribute name
     emit_post(emit);
 }
 
@@ -1410,13 +1581,13 @@ STATIC void emit_native_delete_deref(emit_t *emit, qstr qst, mp_uint_t local_num
 
 STATIC void emit_native_delete_name(emit_t *emit, qstr qst) {
     emit_native_pre(emit);
-    emit_call_with_imm_arg(emit, MP_F_DELETE_NAME, qst, REG_ARG_1);
+    emit_call_with_qstr_arg(emit, MP_F_DELETE_NAME, qst, REG_ARG_1);
     emit_post(emit);
 }
 
 STATIC void emit_native_delete_global(emit_t *emit, qstr qst) {
     emit_native_pre(emit);
-    emit_call_with_imm_arg(emit, MP_F_DELETE_GLOBAL, qst, REG_ARG_1);
+    emit_call_with_qstr_arg(emit, MP_F_DELETE_GLOBAL, qst, REG_ARG_1);
     emit_post(emit);
 }
 
@@ -1424,7 +1595,9 @@ STATIC void emit_native_delete_attr(emit_t *emit, qstr qst) {
     vtype_kind_t vtype_base;
     emit_pre_pop_reg(emit, &vtype_base, REG_ARG_1); // arg1 = base
     assert(vtype_base == VTYPE_PYOBJ);
-    emit_call_with_2_imm_args(emit, MP_F_STORE_ATTR, qst, REG_ARG_2, (mp_uint_t)MP_OBJ_NULL, REG_ARG_3); // arg2 = attribute name, arg3 = value (null for delete)
+    need_reg_all(emit);
+    emit_native_mov_reg_qstr(emit, REG_ARG_2, qst); // arg2 = attribute name
+    emit_call_with_imm_arg(emit, MP_F_STORE_ATTR, (mp_uint_t)MP_OBJ_NULL, REG_ARG_3); // arg3 = value (null for delete)
     emit_post(emit);
 }
 
@@ -1539,6 +1712,18 @@ STATIC void emit_native_continue_loop(emit_t *emit, mp_uint_t label, mp_uint_t e
     emit_native_jump(emit, label); // TODO properly
 }
 
+// push an nlr buffer on the stack and jump to label when an exception is raised
+STATIC void emit_native_nlr_push(emit_t *emit, mp_uint_t label) {
+    emit_get_stack_pointer_to_reg_for_push(emit, REG_ARG_1, NLR_BUF_NSLOTS); // arg1 = pointer to nlr buf
+    emit_call(emit, MP_F_NLR_PUSH);
+    #if N_NLR_SETJMP
+    // arg1 = pointer to nlr_buf.jmpbuf, after prev and ret_val
+    ASM_MOV_REG_LOCAL_ADDR(emit->as, REG_ARG_1, emit->stack_start + emit->stack_size - NLR_BUF_NSLOTS + 2);
+    emit_call(emit, MP_F_SETJMP);
+    #endif
+    ASM_JUMP_IF_REG_NONZERO(emit->as, REG_RET, label);
+}
+
 STATIC void emit_native_setup_with(emit_t *emit, mp_uint_t label) {
     // the context manager is on the top of the stack
     // stack: (..., ctx_mgr)
@@ -1548,7 +1733,7 @@ STATIC void emit_native_setup_with(emit_t *emit, mp_uint_t label) {
     emit_access_stack(emit, 1, &vtype, REG_ARG_1); // arg1 = ctx_mgr
     assert(vtype == VTYPE_PYOBJ);
     emit_get_stack_pointer_to_reg_for_push(emit, REG_ARG_3, 2); // arg3 = dest ptr
-    emit_call_with_imm_arg(emit, MP_F_LOAD_METHOD, MP_QSTR___exit__, REG_ARG_2);
+    emit_call_with_qstr_arg(emit, MP_F_LOAD_METHOD, MP_QSTR___exit__, REG_ARG_2);
     // stack: (..., ctx_mgr, __exit__, self)
 
     emit_pre_pop_reg(emit, &vtype, REG_ARG_3); // self
@@ -1561,7 +1746,7 @@ STATIC void emit_native_setup_with(emit_t *emit, mp_uint_t label) {
 
     // get __enter__ method
     emit_get_stack_pointer_to_reg_for_push(emit, REG_ARG_3, 2); // arg3 = dest ptr
-    emit_call_with_imm_arg(emit, MP_F_LOAD_METHOD, MP_QSTR___enter__, REG_ARG_2); // arg2 = method name
+    emit_call_with_qstr_arg(emit, MP_F_LOAD_METHOD, MP_QSTR___enter__, REG_ARG_2); // arg2 = method name
     // stack: (..., __exit__, self, __enter__, self)
 
     // call __enter__ method
@@ -1572,11 +1757,9 @@ STATIC void emit_native_setup_with(emit_t *emit, mp_uint_t label) {
 
     // need to commit stack because we may jump elsewhere
     need_stack_settled(emit);
-    emit_get_stack_pointer_to_reg_for_push(emit, REG_ARG_1, sizeof(nlr_buf_t) / sizeof(mp_uint_t)); // arg1 = pointer to nlr buf
-    emit_call(emit, MP_F_NLR_PUSH);
-    ASM_JUMP_IF_REG_NONZERO(emit->as, REG_RET, label);
+    emit_native_nlr_push(emit, label);
 
-    emit_access_stack(emit, sizeof(nlr_buf_t) / sizeof(mp_uint_t) + 1, &vtype, REG_RET); // access return value of __enter__
+    emit_access_stack(emit, NLR_BUF_NSLOTS + 1, &vtype, REG_RET); // access return value of __enter__
     emit_post_push_reg(emit, VTYPE_PYOBJ, REG_RET); // push return value of __enter__
     // stack: (..., __exit__, self, as_value, nlr_buf, as_value)
 }
@@ -1587,13 +1770,13 @@ STATIC void emit_native_with_cleanup(emit_t *emit, mp_uint_t label) {
     // stack: (..., __exit__, self, as_value, nlr_buf)
     emit_native_pre(emit);
     emit_call(emit, MP_F_NLR_POP);
-    adjust_stack(emit, -(mp_int_t)(sizeof(nlr_buf_t) / sizeof(mp_uint_t)) - 1);
+    adjust_stack(emit, -(mp_int_t)NLR_BUF_NSLOTS - 1);
     // stack: (..., __exit__, self)
 
     // call __exit__
-    emit_post_push_imm(emit, VTYPE_PYOBJ, (mp_uint_t)mp_const_none);
-    emit_post_push_imm(emit, VTYPE_PYOBJ, (mp_uint_t)mp_const_none);
-    emit_post_push_imm(emit, VTYPE_PYOBJ, (mp_uint_t)mp_const_none);
+    emit_post_push_const(emit, MP_NATIVE_LINK_CONST, MP_NATIVE_CONST_NONE, (mp_uint_t)mp_const_none);
+    emit_post_push_const(emit, MP_NATIVE_LINK_CONST, MP_NATIVE_CONST_NONE, (mp_uint_t)mp_const_none);
+    emit_post_push_const(emit, MP_NATIVE_LINK_CONST, MP_NATIVE_CONST_NONE, (mp_uint_t)mp_const_none);
     emit_get_stack_pointer_to_reg_for_pop(emit, REG_ARG_3, 5);
     emit_call_with_2_imm_args(emit, MP_F_CALL_METHOD_N_KW, 3, REG_ARG_1, 0, REG_ARG_2);
 
@@ -1627,7 +1810,7 @@ STATIC void emit_native_with_cleanup(emit_t *emit, mp_uint_t label) {
     ASM_LOAD_REG_REG_OFFSET(emit->as, REG_ARG_2, REG_ARG_1, 0); // get type(exc)
     emit_post_push_reg(emit, VTYPE_PYOBJ, REG_ARG_2); // push type(exc)
     emit_post_push_reg(emit, VTYPE_PYOBJ, REG_ARG_1); // push exc value
-    emit_post_push_imm(emit, VTYPE_PYOBJ, (mp_uint_t)mp_const_none); // traceback info
+    emit_post_push_const(emit, MP_NATIVE_LINK_CONST, MP_NATIVE_CONST_NONE, (mp_uint_t)mp_const_none); // traceback info
     // stack: (..., exc, __exit__, self, type(exc), exc, traceback)
 
     // call __exit__ method
@@ -1644,7 +1827,7 @@ STATIC void emit_native_with_cleanup(emit_t *emit, mp_uint_t label) {
 
     // replace exc with None
     emit_pre_pop_discard(emit);
-    emit_post_push_imm(emit, VTYPE_PYOBJ, (mp_uint_t)mp_const_none);
+    emit_post_push_const(emit, MP_NATIVE_LINK_CONST, MP_NATIVE_CONST_NONE, (mp_uint_t)mp_const_none);
 
     // end of with cleanup nlr_catch block
     emit_native_label_assign(emit, label + 1);
@@ -1654,9 +1837,7 @@ STATIC void emit_native_setup_except(emit_t *emit, mp_uint_t label) {
     emit_native_pre(emit);
     // need to commit stack because we may jump elsewhere
     need_stack_settled(emit);
-    emit_get_stack_pointer_to_reg_for_push(emit, REG_ARG_1, sizeof(nlr_buf_t) / sizeof(mp_uint_t)); // arg1 = pointer to nlr buf
-    emit_call(emit, MP_F_NLR_PUSH);
-    ASM_JUMP_IF_REG_NONZERO(emit->as, REG_RET, label);
+    emit_native_nlr_push(emit, label);
     emit_post(emit);
 }
 
@@ -1700,7 +1881,7 @@ STATIC void emit_native_for_iter(emit_t *emit, mp_uint_t label) {
     emit_get_stack_pointer_to_reg_for_pop(emit, REG_ARG_1, MP_OBJ_ITER_BUF_NSLOTS);
     adjust_stack(emit, MP_OBJ_ITER_BUF_NSLOTS);
     emit_call(emit, MP_F_NATIVE_ITERNEXT);
-    ASM_MOV_REG_IMM(emit->as, REG_TEMP1, (mp_uint_t)MP_OBJ_STOP_ITERATION);
+    emit_native_mov_reg_const(emit, REG_TEMP1, MP_NATIVE_CONST_STOP_ITERATION);
     ASM_JUMP_IF_REG_EQ(emit->as, REG_RET, REG_TEMP1, label);
     emit_post_push_reg(emit, VTYPE_PYOBJ, REG_RET);
 }
@@ -1715,7 +1896,7 @@ STATIC void emit_native_for_iter_end(emit_t *emit) {
 STATIC void emit_native_pop_block(emit_t *emit) {
     emit_native_pre(emit);
     emit_call(emit, MP_F_NLR_POP);
-    adjust_stack(emit, -(mp_int_t)(sizeof(nlr_buf_t) / sizeof(mp_uint_t)) + 1);
+    adjust_stack(emit, -(mp_int_t)NLR_BUF_NSLOTS + 1);
     emit_post(emit);
 }
 
@@ -1865,7 +2046,7 @@ STATIC void emit_native_binary_op(emit_t *emit, mp_binary_op_t op) {
                 ASM_ARM_CC_NE,
             };
             asm_arm_setcc_reg(emit->as, REG_RET, ccs[op - MP_BINARY_OP_LESS]);
-            #elif N_XTENSA
+            #elif N_XTENSA || N_XTENSAWIN
             static uint8_t ccs[6] = {
                 ASM_XTENSA_CC_LT,
                 0x80 | ASM_XTENSA_CC_LT, // for GT we'll swap args
@@ -1963,7 +2144,9 @@ STATIC void emit_native_build_slice(emit_t *emit, mp_uint_t n_args) {
         emit_pre_pop_reg_reg(emit, &vtype_stop, REG_ARG_2, &vtype_start, REG_ARG_1); // arg1 = start, arg2 = stop
         assert(vtype_start == VTYPE_PYOBJ);
         assert(vtype_stop == VTYPE_PYOBJ);
-        emit_call_with_imm_arg(emit, MP_F_NEW_SLICE, (mp_uint_t)mp_const_none, REG_ARG_3); // arg3 = step
+        need_reg_all(emit);
+        emit_native_mov_reg_const(emit, REG_ARG_3, MP_NATIVE_CONST_NONE); // arg3 = step
+        emit_call(emit, MP_F_NEW_SLICE);
         emit_post_push_reg(emit, VTYPE_PYOBJ, REG_RET);
     } else {
         assert(n_args == 3);
@@ -2029,14 +2212,18 @@ STATIC void emit_native_make_function(emit_t *emit, scope_t *scope, mp_uint_t n_
     // call runtime, with type info for args, or don't support dict/default params, or only support Python objects for them
     emit_native_pre(emit);
     if (n_pos_defaults == 0 && n_kw_defaults == 0) {
-        emit_call_with_3_imm_args_and_first_aligned(emit, MP_F_MAKE_FUNCTION_FROM_RAW_CODE, (mp_uint_t)scope->raw_code, REG_ARG_1, (mp_uint_t)MP_OBJ_NULL, REG_ARG_2, (mp_uint_t)MP_OBJ_NULL, REG_ARG_3);
+        need_reg_all(emit);
+        ASM_MOV_REG_IMM(emit->as, REG_ARG_2, (mp_uint_t)MP_OBJ_NULL);
+        ASM_MOV_REG_IMM(emit->as, REG_ARG_3, (mp_uint_t)MP_OBJ_NULL);
     } else {
         vtype_kind_t vtype_def_tuple, vtype_def_dict;
         emit_pre_pop_reg_reg(emit, &vtype_def_dict, REG_ARG_3, &vtype_def_tuple, REG_ARG_2);
         assert(vtype_def_tuple == VTYPE_PYOBJ);
         assert(vtype_def_dict == VTYPE_PYOBJ);
-        emit_call_with_imm_arg_aligned(emit, MP_F_MAKE_FUNCTION_FROM_RAW_CODE, (mp_uint_t)scope->raw_code, REG_ARG_1);
+        need_reg_all(emit);
     }
+    emit_native_mov_reg_linked(emit, REG_ARG_1, MP_NATIVE_LINK_RAW_CODE, (mp_uint_t)scope->raw_code, (mp_uint_t)scope->raw_code);
+    emit_native_call_ind(emit, MP_F_MAKE_FUNCTION_FROM_RAW_CODE);
     emit_post_push_reg(emit, VTYPE_PYOBJ, REG_RET);
 }
 
@@ -2049,8 +2236,8 @@ STATIC void emit_native_make_closure(emit_t *emit, scope_t *scope, mp_uint_t n_c
         emit_get_stack_pointer_to_reg_for_pop(emit, REG_ARG_3, n_closed_over + 2);
         ASM_MOV_REG_IMM(emit->as, REG_ARG_2, 0x100 | n_closed_over);
     }
-    ASM_MOV_REG_ALIGNED_IMM(emit->as, REG_ARG_1, (mp_uint_t)scope->raw_code);
-    ASM_CALL_IND(emit->as, mp_fun_table[MP_F_MAKE_CLOSURE_FROM_RAW_CODE], MP_F_MAKE_CLOSURE_FROM_RAW_CODE);
+    emit_native_mov_reg_linked(emit, REG_ARG_1, MP_NATIVE_LINK_RAW_CODE, (mp_uint_t)scope->raw_code, (mp_uint_t)scope->raw_code);
+    emit_native_call_ind(emit, MP_F_MAKE_CLOSURE_FROM_RAW_CODE);
     emit_post_push_reg(emit, VTYPE_PYOBJ, REG_RET);
 }
 
@@ -2128,7 +2315,7 @@ STATIC void emit_native_return_value(emit_t *emit) {
         if (peek_vtype(emit, 0) == VTYPE_PTR_NONE) {
             emit_pre_pop_discard(emit);
             if (emit->return_vtype == VTYPE_PYOBJ) {
-                ASM_MOV_REG_IMM(emit->as, REG_RET, (mp_uint_t)mp_const_none);
+                emit_native_mov_reg_const(emit, REG_RET, MP_NATIVE_CONST_NONE);
             } else {
                 ASM_MOV_REG_IMM(emit->as, REG_RET, 0);
             }
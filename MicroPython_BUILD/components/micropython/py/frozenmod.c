@@ -82,16 +82,79 @@ STATIC mp_lexer_t *mp_lexer_frozen_str(const char *str, size_t len) {
 extern const char mp_frozen_mpy_names[];
 extern const mp_raw_code_t *const mp_frozen_mpy_content[];
 
-STATIC const mp_raw_code_t *mp_find_frozen_mpy(const char *str, size_t len) {
+STATIC int mp_find_frozen_mpy_index(const char *str, size_t len) {
     const char *name = mp_frozen_mpy_names;
-    for (size_t i = 0; *name != 0; i++) {
+    for (int i = 0; *name != 0; i++) {
         size_t l = strlen(name);
         if (l == len && !memcmp(str, name, l)) {
-            return mp_frozen_mpy_content[i];
+            return i;
         }
         name += l + 1;
     }
-    return NULL;
+    return -1;
+}
+
+STATIC const mp_raw_code_t *mp_find_frozen_mpy(const char *str, size_t len) {
+    int i = mp_find_frozen_mpy_index(str, len);
+    if (i < 0) {
+        return NULL;
+    }
+    return mp_frozen_mpy_content[i];
+}
+
+#endif
+
+#if MICROPY_MODULE_FROZEN_ROM
+
+#include "py/runtime.h"
+
+// entries are NULL for frozen modules that must run their code on import
+extern const mp_frozen_rom_module_t *const mp_frozen_rom_content[];
+
+mp_obj_t mp_frozen_rom_import(qstr name, const char *str, size_t len) {
+    int i = mp_find_frozen_mpy_index(str, len);
+    if (i < 0 || mp_frozen_rom_content[i] == NULL) {
+        return MP_OBJ_NULL;
+    }
+    const mp_frozen_rom_module_t *rom = mp_frozen_rom_content[i];
+
+    // each namespace starts from a fresh copy of its table, as if the module
+    // code had just been executed
+    for (size_t j = 0; j < rom->n_dicts; j++) {
+        const mp_frozen_rom_dict_t *d = &rom->dicts[j];
+        mp_map_elem_t *table = m_new(mp_map_elem_t, d->alloc);
+        memcpy(table, d->table, d->alloc * sizeof(mp_map_elem_t));
+        mp_obj_dict_t *dict = d->dict;
+        dict->base.type = &mp_type_dict;
+        dict->map.all_keys_are_qstrs = 1;
+        dict->map.is_fixed = 0;
+        dict->map.is_ordered = 0;
+        dict->map.used = d->used;
+        dict->map.alloc = d->alloc;
+        dict->map.table = table;
+    }
+
+    // register the module before importing its dependencies, like a module
+    // that executes its code does
+    mp_obj_t module_obj = MP_OBJ_FROM_PTR(rom->module);
+    mp_map_lookup(&MP_STATE_VM(mp_loaded_modules_dict).map, MP_OBJ_NEW_QSTR(name),
+        MP_MAP_LOOKUP_ADD_IF_NOT_FOUND)->value = module_obj;
+
+    mp_obj_t globals = MP_OBJ_FROM_PTR(rom->dicts[0].dict);
+    for (size_t j = 0; j < rom->n_imports; j++) {
+        const mp_frozen_rom_import_t *imp = &rom->imports[j];
+        // a fromlist makes the import return the module itself, not its top-level package
+        mp_obj_t obj = mp_import_name(imp->module, imp->attr == MP_QSTR_NULL ? mp_const_none : mp_const_true,
+            MP_OBJ_NEW_SMALL_INT(0));
+        if (imp->attr != MP_QSTR_NULL) {
+            obj = mp_import_from(obj, imp->attr);
+        }
+        if (imp->store != MP_QSTR_NULL) {
+            mp_obj_dict_store(globals, MP_OBJ_NEW_QSTR(imp->store), obj);
+        }
+    }
+
+    return module_obj;
 }
 
 #endif
@@ -38,4 +38,42 @@ int mp_find_frozen_module(const char *str, size_t len, void **data);
 const char *mp_find_frozen_str(const char *str, size_t *len);
 mp_import_stat_t mp_frozen_stat(const char *str);
 
+#if MICROPY_MODULE_FROZEN_ROM
+
+#include "py/obj.h"
+
+// A namespace of a frozen module laid out in ROM.  The dict objects live in
+// RAM so the module and its classes stay writable; on import each gets a heap
+// copy of its table, which mpy-tool has already laid out by qstr hash.
+typedef struct _mp_frozen_rom_dict_t {
+    mp_obj_dict_t *dict;
+    const mp_rom_map_elem_t *table;
+    uint16_t alloc;
+    uint16_t used;
+} mp_frozen_rom_dict_t;
+
+// An import statement of a frozen module: attr is MP_QSTR_NULL for "import
+// module", and store is MP_QSTR_NULL if a later statement rebinds the name.
+typedef struct _mp_frozen_rom_import_t {
+    uint16_t module;
+    uint16_t attr;
+    uint16_t store;
+} mp_frozen_rom_import_t;
+
+typedef struct _mp_frozen_rom_module_t {
+    const mp_obj_module_t *module;
+    const mp_frozen_rom_dict_t *dicts; // the module globals come first
+    const mp_frozen_rom_import_t *imports;
+    uint16_t n_dicts;
+    uint16_t n_imports;
+} mp_frozen_rom_module_t;
+
+// the dict objects of all ROM modules, generated by mpy-tool
+extern mp_obj_dict_t mp_frozen_rom_dicts[];
+extern const size_t mp_frozen_rom_dicts_len;
+
+mp_obj_t mp_frozen_rom_import(qstr name, const char *str, size_t len);
+
+#endif
+
 #endif // MICROPY_INCLUDED_PY_FROZENMOD_H
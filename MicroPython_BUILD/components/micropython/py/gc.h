@@ -31,8 +31,27 @@
 #include "py/mpconfig.h"
 #include "py/misc.h"
 
+// Allocation placement hints
+#define GC_PLACE_AUTO (0)   // by size, see gc_fast_limit()
+#define GC_PLACE_FAST (1)   // prefer the fast heap area
+#define GC_PLACE_SLOW (2)   // prefer the slow heap area
+
+// Heap area flags
+#define GC_AREA_FAST (0x0001) // fast memory, eg. internal SRAM
+
 void gc_init(void *start, void *end);
 
+#if MICROPY_GC_MULTI_HEAP
+// Add another memory region to the heap, all areas are collected together.
+// 'cost' is the relative access cost of the memory, used for statistics only.
+bool gc_add_area(void *start, void *end, unsigned int flags, unsigned int cost);
+// Set the flags and access cost of the heap area
+void gc_set_area(size_t area, unsigned int flags, unsigned int cost);
+// Set the maximal size of the allocation placed into the fast area by default,
+// returns the previous value; (size_t)-1 only returns the current value
+size_t gc_fast_limit(size_t n_bytes);
+#endif
+
 // These lock/unlock functions can be nested.
 // They can be used to prevent the GC from allocating/freeing.
 void gc_lock(void);
@@ -43,9 +62,13 @@ bool gc_is_locked(void);
 void gc_collect(int flag);
 void gc_collect_start(void);
 void gc_collect_root(void **ptrs, size_t len);
+bool gc_collect_is_marked(const void *ptr);
 void gc_collect_end(void);
 
 void *gc_alloc(size_t n_bytes, bool has_finaliser);
+// Allocate with the placement hint (GC_PLACE_xxx), the allocation is
+// placed into the other areas if the preferred areas have no free space
+void *gc_alloc_place(size_t n_bytes, bool has_finaliser, unsigned int place);
 void gc_free(void *ptr); // does not call finaliser
 size_t gc_nbytes(const void *ptr);
 void *gc_realloc(void *ptr, size_t n_bytes, bool allow_move);
@@ -61,6 +84,21 @@ typedef struct _gc_info_t {
 } gc_info_t;
 
 void gc_info(gc_info_t *info);
+
+#if MICROPY_GC_MULTI_HEAP
+typedef struct _gc_area_info_t {
+    gc_info_t info;
+    void *start;
+    unsigned int flags;
+    unsigned int cost;
+    size_t n_alloc;         // allocations placed into this area
+    size_t n_fallback;      // of which placed here because the preferred area was full
+    size_t scan_words;      // words scanned by the last collection
+} gc_area_info_t;
+
+size_t gc_area_count(void);
+bool gc_area_info(size_t area, gc_area_info_t *info);
+#endif
 void gc_dump_info(void);
 void gc_dump_alloc_table(void);
 
@@ -31,6 +31,7 @@
 #include "py/mpconfig.h"
 #include "py/misc.h"
 #include "py/mpstate.h"
+#include "py/alloctrace.h"
 
 #if MICROPY_DEBUG_VERBOSE // print debugging info
 #define DEBUG_printf DEBUG_printf
@@ -74,6 +75,15 @@ STATIC void *realloc_ext(void *ptr, size_t n_bytes, bool allow_move) {
 }
 #endif // MICROPY_ENABLE_GC
 
+#if MICROPY_PY_MICROPYTHON_ALLOC_TRACE
+#define ALLOC_TRACE(ptr, n) \
+    if (MP_STATE_MEM(alloc_trace_enabled) && (ptr) != NULL) { \
+        mp_alloc_trace((ptr), (n), MP_ALLOC_TRACE_CALLER()); \
+    }
+#else
+#define ALLOC_TRACE(ptr, n)
+#endif
+
 void *m_malloc(size_t num_bytes) {
     void *ptr = malloc(num_bytes);
     if (ptr == NULL && num_bytes != 0) {
@@ -84,6 +94,7 @@ void *m_malloc(size_t num_bytes) {
     MP_STATE_MEM(current_bytes_allocated) += num_bytes;
     UPDATE_PEAK();
 #endif
+    ALLOC_TRACE(ptr, num_bytes);
     DEBUG_printf("malloc %d : %p\n", num_bytes, ptr);
     return ptr;
 }
@@ -95,6 +106,7 @@ void *m_malloc_maybe(size_t num_bytes) {
     MP_STATE_MEM(current_bytes_allocated) += num_bytes;
     UPDATE_PEAK();
 #endif
+    ALLOC_TRACE(ptr, num_bytes);
     DEBUG_printf("malloc %d : %p\n", num_bytes, ptr);
     return ptr;
 }
@@ -110,6 +122,7 @@ void *m_malloc_with_finaliser(size_t num_bytes) {
     MP_STATE_MEM(current_bytes_allocated) += num_bytes;
     UPDATE_PEAK();
 #endif
+    ALLOC_TRACE(ptr, num_bytes);
     DEBUG_printf("malloc %d : %p\n", num_bytes, ptr);
     return ptr;
 }
@@ -117,6 +130,12 @@ void *m_malloc_with_finaliser(size_t num_bytes) {
 
 void *m_malloc0(size_t num_bytes) {
     void *ptr = m_malloc(num_bytes);
+    #if MICROPY_PY_MICROPYTHON_ALLOC_TRACE
+    // count the allocation for the caller of this function
+    if (MP_STATE_MEM(alloc_trace_enabled)) {
+        mp_alloc_trace_set_caller(MP_ALLOC_TRACE_CALLER());
+    }
+    #endif
     // If this config is set then the GC clears all memory, so we don't need to.
     #if !MICROPY_GC_CONSERVATIVE_CLEAR
     memset(ptr, 0, num_bytes);
@@ -133,6 +152,10 @@ void *m_realloc(void *ptr, size_t new_num_bytes) {
     if (new_ptr == NULL && new_num_bytes != 0) {
         m_malloc_fail(new_num_bytes);
     }
+    // a block that grows in place is not a new allocation
+    if (new_ptr != ptr) {
+        ALLOC_TRACE(new_ptr, new_num_bytes);
+    }
 #if MICROPY_MEM_STATS
     // At first thought, "Total bytes allocated" should only grow,
     // after all, it's *total*. But consider for example 2K block
@@ -158,6 +181,9 @@ void *m_realloc_maybe(void *ptr, size_t old_num_bytes, size_t new_num_bytes, boo
 void *m_realloc_maybe(void *ptr, size_t new_num_bytes, bool allow_move) {
 #endif
     void *new_ptr = realloc_ext(ptr, new_num_bytes, allow_move);
+    if (new_ptr != ptr) {
+        ALLOC_TRACE(new_ptr, new_num_bytes);
+    }
 #if MICROPY_MEM_STATS
     // At first thought, "Total bytes allocated" should only grow,
     // after all, it's *total*. But consider for example 2K block
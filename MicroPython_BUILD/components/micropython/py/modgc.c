@@ -27,6 +27,7 @@
 
 #include "py/mpstate.h"
 #include "py/obj.h"
+#include "py/runtime.h"
 #include "py/gc.h"
 
 #if MICROPY_PY_GC && MICROPY_ENABLE_GC
@@ -125,6 +126,48 @@ STATIC mp_obj_t gc_threshold(size_t n_args, const mp_obj_t *args) {
 MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(gc_threshold_obj, 0, 2, gc_threshold);
 #endif
 
+#if MICROPY_GC_MULTI_HEAP
+// heap_info(): return the tuple of heap areas statistics
+// (start, flags, cost, total, used, free, max_free, allocations, fallbacks, scanned_words)
+STATIC mp_obj_t gc_heap_info(void) {
+    size_t n_areas = gc_area_count();
+    mp_obj_t areas = mp_obj_new_tuple(n_areas, NULL);
+    mp_obj_tuple_t *t = MP_OBJ_TO_PTR(areas);
+    gc_area_info_t info;
+    for (size_t n = 0; n < n_areas; n++) {
+        gc_area_info(n, &info);
+        mp_obj_t tuple[10];
+        tuple[0] = mp_obj_new_int_from_uint((uintptr_t)info.start);
+        tuple[1] = MP_OBJ_NEW_SMALL_INT(info.flags);
+        tuple[2] = MP_OBJ_NEW_SMALL_INT(info.cost);
+        tuple[3] = mp_obj_new_int_from_uint(info.info.total);
+        tuple[4] = mp_obj_new_int_from_uint(info.info.used);
+        tuple[5] = mp_obj_new_int_from_uint(info.info.free);
+        tuple[6] = mp_obj_new_int_from_uint(info.info.max_free * MICROPY_BYTES_PER_GC_BLOCK);
+        tuple[7] = mp_obj_new_int_from_uint(info.n_alloc);
+        tuple[8] = mp_obj_new_int_from_uint(info.n_fallback);
+        tuple[9] = mp_obj_new_int_from_uint(info.scan_words);
+        t->items[n] = mp_obj_new_tuple(10, tuple);
+    }
+    return areas;
+}
+MP_DEFINE_CONST_FUN_OBJ_0(gc_heap_info_obj, gc_heap_info);
+
+// fast_limit([size]): get or set the maximal size of the allocation placed into the fast heap area
+STATIC mp_obj_t gc_fast_limit_func(size_t n_args, const mp_obj_t *args) {
+    if (n_args == 0) {
+        return mp_obj_new_int_from_uint(gc_fast_limit((size_t)-1));
+    }
+    mp_int_t val = mp_obj_get_int(args[0]);
+    if (val < 0) {
+        mp_raise_ValueError("size must be >= 0");
+    }
+    gc_fast_limit(val);
+    return mp_const_none;
+}
+MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(gc_fast_limit_obj, 0, 1, gc_fast_limit_func);
+#endif
+
 STATIC const mp_rom_map_elem_t mp_module_gc_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR___name__),	MP_ROM_QSTR(MP_QSTR_gc) },
     { MP_ROM_QSTR(MP_QSTR_collect),		MP_ROM_PTR(&gc_collect_obj) },
@@ -137,6 +180,11 @@ STATIC const mp_rom_map_elem_t mp_module_gc_globals_table[] = {
     #if MICROPY_GC_ALLOC_THRESHOLD
     { MP_ROM_QSTR(MP_QSTR_threshold),	MP_ROM_PTR(&gc_threshold_obj) },
     #endif
+    #if MICROPY_GC_MULTI_HEAP
+    { MP_ROM_QSTR(MP_QSTR_heap_info),	MP_ROM_PTR(&gc_heap_info_obj) },
+    { MP_ROM_QSTR(MP_QSTR_fast_limit),	MP_ROM_PTR(&gc_fast_limit_obj) },
+    { MP_ROM_QSTR(MP_QSTR_AREA_FAST),	MP_ROM_INT(GC_AREA_FAST) },
+    #endif
 };
 
 STATIC MP_DEFINE_CONST_DICT(mp_module_gc_globals, mp_module_gc_globals_table);
@@ -32,6 +32,10 @@
 #include "py/runtime.h"
 #include "py/gc.h"
 #include "py/mphal.h"
+#include "py/stream.h"
+#include "py/boottrace.h"
+#include "py/profile.h"
+#include "py/alloctrace.h"
 
 // Various builtins specific to MicroPython runtime,
 // living in micropython module
@@ -122,6 +126,62 @@ STATIC mp_obj_t mp_micropython_pystack_use(void) {
 STATIC MP_DEFINE_CONST_FUN_OBJ_0(mp_micropython_pystack_use_obj, mp_micropython_pystack_use);
 #endif
 
+#if MICROPY_BOOT_TRACE
+STATIC mp_obj_t mp_micropython_boottrace(size_t n_args, const mp_obj_t *args) {
+    if (n_args == 0) {
+        mp_boot_trace_print(&mp_plat_print);
+    } else if (MP_OBJ_IS_TYPE(args[0], &mp_type_bool)) {
+        // True clears the trace and starts recording, False stops recording
+        mp_boot_trace_enable(mp_obj_is_true(args[0]));
+    } else {
+        // write the trace to a stream, eg an open file
+        mp_get_stream_raise(args[0], MP_STREAM_OP_WRITE);
+        mp_print_t print = {MP_OBJ_TO_PTR(args[0]), mp_stream_write_adaptor};
+        mp_boot_trace_print(&print);
+    }
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(mp_micropython_boottrace_obj, 0, 1, mp_micropython_boottrace);
+#endif
+
+#if MICROPY_PY_MICROPYTHON_PROFILE
+STATIC mp_obj_t mp_micropython_profile_start(size_t n_args, const mp_obj_t *args) {
+    mp_int_t hz = 100;
+    if (n_args > 0) {
+        hz = mp_obj_get_int(args[0]);
+        if (hz <= 0) {
+            mp_raise_ValueError("hz must be positive");
+        }
+    }
+    mp_profile_start(hz);
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(mp_micropython_profile_start_obj, 0, 1, mp_micropython_profile_start);
+
+STATIC mp_obj_t mp_micropython_profile_stop(void) {
+    return mp_profile_stop();
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_0(mp_micropython_profile_stop_obj, mp_micropython_profile_stop);
+#endif
+
+#if MICROPY_PY_MICROPYTHON_ALLOC_TRACE
+STATIC mp_obj_t mp_micropython_alloc_trace(size_t n_args, const mp_obj_t *args) {
+    if (n_args == 0) {
+        return mp_alloc_trace_get((size_t)-1);
+    }
+    if (MP_OBJ_IS_TYPE(args[0], &mp_type_bool)) {
+        mp_alloc_trace_enable(mp_obj_is_true(args[0]));
+        return mp_const_none;
+    }
+    mp_int_t n = mp_obj_get_int(args[0]);
+    if (n < 0) {
+        mp_raise_ValueError("n must not be negative");
+    }
+    return mp_alloc_trace_get(n);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(mp_micropython_alloc_trace_obj, 0, 1, mp_micropython_alloc_trace);
+#endif
+
 #if MICROPY_ENABLE_GC
 STATIC mp_obj_t mp_micropython_heap_lock(void) {
     gc_lock();
@@ -182,6 +242,16 @@ STATIC const mp_rom_map_elem_t mp_module_micropython_globals_table[] = {
     #if MICROPY_ENABLE_PYSTACK
     { MP_ROM_QSTR(MP_QSTR_pystack_use), MP_ROM_PTR(&mp_micropython_pystack_use_obj) },
     #endif
+    #if MICROPY_BOOT_TRACE
+    { MP_ROM_QSTR(MP_QSTR_boottrace), MP_ROM_PTR(&mp_micropython_boottrace_obj) },
+    #endif
+    #if MICROPY_PY_MICROPYTHON_PROFILE
+    { MP_ROM_QSTR(MP_QSTR_profile_start), MP_ROM_PTR(&mp_micropython_profile_start_obj) },
+    { MP_ROM_QSTR(MP_QSTR_profile_stop), MP_ROM_PTR(&mp_micropython_profile_stop_obj) },
+    #endif
+    #if MICROPY_PY_MICROPYTHON_ALLOC_TRACE
+    { MP_ROM_QSTR(MP_QSTR_alloc_trace), MP_ROM_PTR(&mp_micropython_alloc_trace_obj) },
+    #endif
     #if MICROPY_ENABLE_GC
     { MP_ROM_QSTR(MP_QSTR_heap_lock), MP_ROM_PTR(&mp_micropython_heap_lock_obj) },
     { MP_ROM_QSTR(MP_QSTR_heap_unlock), MP_ROM_PTR(&mp_micropython_heap_unlock_obj) },
@@ -38,6 +38,7 @@
 #include "py/stream.h"
 #include "py/smallint.h"
 #include "py/runtime.h"
+#include "py/mperrno.h"
 #include "lib/utils/pyexec.h"
 #include "modmachine.h"
 #include "machine_rtc.h"
@@ -155,6 +156,31 @@ STATIC mp_obj_t mp_sys_getsizeof(mp_obj_t obj) {
 STATIC MP_DEFINE_CONST_FUN_OBJ_1(mp_sys_getsizeof_obj, mp_sys_getsizeof);
 #endif
 
+#if MICROPY_MODULE_IMPORT_CACHE
+// importcache(): return the directory of the import cache, None if disabled
+// importcache(dir): enable the import cache, dir must exist
+// importcache(None): disable the import cache
+//--------------------------------------------------------------
+STATIC mp_obj_t mp_sys_importcache(size_t n_args, const mp_obj_t *args) {
+	if (n_args == 0) {
+		mp_obj_t dir = MP_STATE_VM(import_cache_dir);
+		return (dir == MP_OBJ_NULL) ? mp_const_none : dir;
+	}
+	if (args[0] == mp_const_none) {
+		MP_STATE_VM(import_cache_dir) = MP_OBJ_NULL;
+	}
+	else {
+		const char *dir = mp_obj_str_get_str(args[0]);
+		if (mp_import_stat(dir) != MP_IMPORT_STAT_DIR) {
+			mp_raise_OSError(MP_ENOENT);
+		}
+		MP_STATE_VM(import_cache_dir) = args[0];
+	}
+	return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(mp_sys_importcache_obj, 0, 1, mp_sys_importcache);
+#endif
+
 //--------------------------------
 STATIC mp_obj_t mp_sys_mpycore() {
 	mp_obj_t tuple[2];
@@ -272,6 +298,9 @@ STATIC const mp_rom_map_elem_t mp_module_sys_globals_table[] = {
      */
 
     { MP_ROM_QSTR(MP_QSTR_print_exception),	MP_ROM_PTR(&mp_sys_print_exception_obj) },
+    #if MICROPY_MODULE_IMPORT_CACHE
+    { MP_ROM_QSTR(MP_QSTR_importcache),		MP_ROM_PTR(&mp_sys_importcache_obj) },
+    #endif
 };
 
 STATIC MP_DEFINE_CONST_DICT(mp_module_sys_globals, mp_module_sys_globals_table);
@@ -90,6 +90,10 @@ void *thread_entry(void *args_in)
     mp_stack_set_top(&ts + 1); // need to include ts in root-pointer scan
     mp_stack_set_limit(args->stack_size);
 
+    #if MICROPY_CODE_STATE_CHAIN
+    ts.current_code_state = NULL;
+    #endif
+
     // set locals and globals from the calling context
     mp_locals_set(args->dict_locals);
     mp_globals_set(args->dict_globals);
@@ -122,6 +122,21 @@
 #define MICROPY_GC_ALLOC_THRESHOLD (1)
 #endif
 
+// Maximum number of separate memory areas the GC heap can consist of.
+// With more than one area, gc_add_area() can add memory regions (eg. internal
+// SRAM and external psRAM) which are all collected in the same GC cycle, and
+// the allocations are placed into the fast or slow areas by size or hint.
+#ifndef MICROPY_GC_MAX_AREAS
+#define MICROPY_GC_MAX_AREAS (1)
+#endif
+#define MICROPY_GC_MULTI_HEAP (MICROPY_GC_MAX_AREAS > 1)
+
+// Allocations up to this size are placed into the fast heap area by default,
+// configurable by gc.fast_limit().
+#ifndef MICROPY_GC_FAST_MAX_BYTES
+#define MICROPY_GC_FAST_MAX_BYTES (256)
+#endif
+
 // Number of bytes to allocate initially when creating new chunks to store
 // interned string data.  Smaller numbers lead to more chunks being needed
 // and more wastage at the end of the chunk.  Larger numbers lead to wasted
@@ -292,13 +307,18 @@
 #define MICROPY_EMIT_XTENSA (0)
 #endif
 
+// Whether to emit Xtensa-Windowed native code (as used by the ESP32)
+#ifndef MICROPY_EMIT_XTENSAWIN
+#define MICROPY_EMIT_XTENSAWIN (0)
+#endif
+
 // Whether to enable the Xtensa inline assembler
 #ifndef MICROPY_EMIT_INLINE_XTENSA
 #define MICROPY_EMIT_INLINE_XTENSA (0)
 #endif
 
 // Convenience definition for whether any native emitter is enabled
-#define MICROPY_EMIT_NATIVE (MICROPY_EMIT_X64 || MICROPY_EMIT_X86 || MICROPY_EMIT_THUMB || MICROPY_EMIT_ARM || MICROPY_EMIT_XTENSA)
+#define MICROPY_EMIT_NATIVE (MICROPY_EMIT_X64 || MICROPY_EMIT_X86 || MICROPY_EMIT_THUMB || MICROPY_EMIT_ARM || MICROPY_EMIT_XTENSA || MICROPY_EMIT_XTENSAWIN)
 
 // Convenience definition for whether any inline assembler emitter is enabled
 #define MICROPY_EMIT_INLINE_ASM (MICROPY_EMIT_INLINE_THUMB || MICROPY_EMIT_INLINE_XTENSA)
@@ -358,6 +378,14 @@
 #define MICROPY_COMP_RETURN_IF_EXPR (0)
 #endif
 
+// Whether scripts run by pyexec (boot.py, main.py) are compiled and executed one
+// top-level statement at a time, so only the parse tree of the current statement
+// is held in memory.  Statements before a syntax error are executed before the
+// error is raised.  exec(), eval() and imports still compile the whole input.
+#ifndef MICROPY_COMP_STREAM
+#define MICROPY_COMP_STREAM (0)
+#endif
+
 /*****************************************************************************/
 /* Internal debugging stuff                                                  */
 
@@ -366,6 +394,18 @@
 #define MICROPY_MEM_STATS (0)
 #endif
 
+// Whether to record a trace of the boot sequence (port init steps, scripts,
+// imports, GC collections) with microsecond timestamps in a static ring buffer,
+// printed with micropython.boottrace(); requires mp_hal_ticks_us
+#ifndef MICROPY_BOOT_TRACE
+#define MICROPY_BOOT_TRACE (0)
+#endif
+
+// Number of events kept by the boot trace, the oldest are dropped first
+#ifndef MICROPY_BOOT_TRACE_ENTRIES
+#define MICROPY_BOOT_TRACE_ENTRIES (64)
+#endif
+
 // Whether to build functions that print debugging info:
 //   mp_bytecode_print
 //   mp_parse_node_print
@@ -396,6 +436,14 @@
 #define MICROPY_OPT_CACHE_MAP_LOOKUP_IN_BYTECODE (0)
 #endif
 
+// Whether the bytecode emitter runs a peephole pass which removes jumps to
+// the next instruction and merges common instruction sequences into
+// superinstructions (LOAD_FAST_ATTR, LOAD_FAST_CONST_BINARY_OP and
+// BINARY_OP_POP_JUMP_IF_*).  The VM always supports the superinstructions.
+#ifndef MICROPY_OPT_BC_PEEPHOLE
+#define MICROPY_OPT_BC_PEEPHOLE (1)
+#endif
+
 // Whether to use fast versions of bitwise operations (and, or, xor) when the
 // arguments are both positive.  Increases Thumb2 code size by about 250 bytes.
 #ifndef MICROPY_OPT_MPZ_BITWISE
@@ -412,6 +460,13 @@
 #define MICROPY_ENABLE_EXTERNAL_IMPORT (1)
 #endif
 
+// Whether imported .py files are compiled once and kept as .mpy in the directory
+// set with sys.importcache(), to be loaded on the next import of the unchanged source
+// Requires MICROPY_PERSISTENT_CODE_LOAD, MICROPY_PERSISTENT_CODE_SAVE and the compiler
+#ifndef MICROPY_MODULE_IMPORT_CACHE
+#define MICROPY_MODULE_IMPORT_CACHE (0)
+#endif
+
 // Whether to use the POSIX reader for importing files
 #ifndef MICROPY_READER_POSIX
 #define MICROPY_READER_POSIX (0)
@@ -637,6 +692,13 @@ typedef double mp_float_t;
 #define MICROPY_MODULE_FROZEN_MPY (0)
 #endif
 
+// Whether frozen .mpy modules that only define functions, classes, constants
+// and imports are laid out in ROM by mpy-tool, so importing them runs no code
+// and only the namespace tables are allocated on the heap
+#ifndef MICROPY_MODULE_FROZEN_ROM
+#define MICROPY_MODULE_FROZEN_ROM (0)
+#endif
+
 // Convenience macro for whether frozen modules are supported
 #ifndef MICROPY_MODULE_FROZEN
 #define MICROPY_MODULE_FROZEN (MICROPY_MODULE_FROZEN_STR || MICROPY_MODULE_FROZEN_MPY)
@@ -912,6 +974,37 @@ typedef double mp_float_t;
 #define MICROPY_PY_MICROPYTHON_STACK_USE (MICROPY_PY_MICROPYTHON_MEM_INFO)
 #endif
 
+// Whether to provide "micropython.profile_start" and "profile_stop", a
+// sampling profiler of Python code driven by a port timer; the port must
+// provide mp_hal_profile_timer() and enable the scheduler
+#ifndef MICROPY_PY_MICROPYTHON_PROFILE
+#define MICROPY_PY_MICROPYTHON_PROFILE (0)
+#endif
+
+// Number of distinct call stacks the profiler can count, and the number of
+// innermost frames of each stack that are kept
+#ifndef MICROPY_PY_MICROPYTHON_PROFILE_ENTRIES
+#define MICROPY_PY_MICROPYTHON_PROFILE_ENTRIES (64)
+#endif
+#ifndef MICROPY_PY_MICROPYTHON_PROFILE_DEPTH
+#define MICROPY_PY_MICROPYTHON_PROFILE_DEPTH (8)
+#endif
+
+// Whether to provide "micropython.alloc_trace", which counts heap allocations
+// by Python source line, C caller and object type
+#ifndef MICROPY_PY_MICROPYTHON_ALLOC_TRACE
+#define MICROPY_PY_MICROPYTHON_ALLOC_TRACE (0)
+#endif
+
+// Number of distinct allocation sites the allocation tracer can count
+#ifndef MICROPY_PY_MICROPYTHON_ALLOC_TRACE_ENTRIES
+#define MICROPY_PY_MICROPYTHON_ALLOC_TRACE_ENTRIES (64)
+#endif
+
+// Whether the VM links the running code states, so the profiler and the
+// allocation tracer can find the Python code that is running
+#define MICROPY_CODE_STATE_CHAIN (MICROPY_PY_MICROPYTHON_PROFILE || MICROPY_PY_MICROPYTHON_ALLOC_TRACE)
+
 // Whether to provide "array" module. Note that large chunk of the
 // underlying code is shared with "bytearray" builtin type, so to
 // get real savings, it should be disabled too.
@@ -941,6 +1034,11 @@ typedef double mp_float_t;
 #define MICROPY_PY_COLLECTIONS_DEQUE (0)
 #endif
 
+// Whether "ucollections.deque" can store numeric items as array values (typecode argument)
+#ifndef MICROPY_PY_COLLECTIONS_DEQUE_TYPED
+#define MICROPY_PY_COLLECTIONS_DEQUE_TYPED (0)
+#endif
+
 // Whether to provide "collections.OrderedDict" type
 #ifndef MICROPY_PY_COLLECTIONS_ORDEREDDICT
 #define MICROPY_PY_COLLECTIONS_ORDEREDDICT (0)
@@ -1120,10 +1218,38 @@ typedef double mp_float_t;
 #define MICROPY_PY_URE (0)
 #endif
 
+// Whether ure provides the Pike VM matcher, which takes linear time whatever
+// the pattern, selected per pattern with the ure.PIKEVM flag
+#ifndef MICROPY_PY_URE_PIKEVM
+#define MICROPY_PY_URE_PIKEVM (0)
+#endif
+
+// Whether ure provides sub()
+#ifndef MICROPY_PY_URE_SUB
+#define MICROPY_PY_URE_SUB (0)
+#endif
+
+// Whether ure provides finditer()
+#ifndef MICROPY_PY_URE_FINDITER
+#define MICROPY_PY_URE_FINDITER (0)
+#endif
+
+// Number of patterns compiled by the ure module-level functions that are kept
+// for reuse, 0 to compile the pattern at every call
+#ifndef MICROPY_PY_URE_CACHE_SIZE
+#define MICROPY_PY_URE_CACHE_SIZE (0)
+#endif
+
 #ifndef MICROPY_PY_UHEAPQ
 #define MICROPY_PY_UHEAPQ (0)
 #endif
 
+// Iterator building blocks: count, cycle, chain, islice, takewhile,
+// accumulate, groupby, tee, batched
+#ifndef MICROPY_PY_UITERTOOLS
+#define MICROPY_PY_UITERTOOLS (0)
+#endif
+
 // Optimized heap queue for relative timestamps
 #ifndef MICROPY_PY_UTIMEQ
 #define MICROPY_PY_UTIMEQ (0)
@@ -1300,6 +1426,11 @@ typedef double mp_float_t;
 #define MP_PLAT_FREE_EXEC(ptr, size) m_del(byte, ptr, size)
 #endif
 
+// If MP_PLAT_COMMIT_EXEC(buf, len) is defined it is given the finished machine code
+// and returns the address the code is executed from.  The raw code and the function
+// objects keep both pointers, the data embedded in the code (the prelude) is read
+// from buf, so a port can execute a copy of the code from other memory.
+
 // This macro is used to do all output (except when MICROPY_PY_IO is defined)
 #ifndef MP_PLAT_PRINT_STRN
 #define MP_PLAT_PRINT_STRN(str, len) mp_hal_stdout_tx_strn_cooked(str, len)
@@ -47,6 +47,7 @@ typedef struct mp_dynamic_compiler_t {
     uint8_t small_int_bits; // must be <= host small_int_bits
     bool opt_cache_map_lookup_in_bytecode;
     bool py_builtins_str_unicode;
+    uint8_t native_arch; // MP_NATIVE_ARCH_xxx of the emitted machine code
 } mp_dynamic_compiler_t;
 extern mp_dynamic_compiler_t mp_dynamic_compiler;
 #endif
@@ -62,6 +63,27 @@ typedef struct _mp_sched_item_t {
     void     *carg;
 } mp_sched_item_t;
 
+// This structure holds the layout of one GC heap area.
+typedef struct _mp_state_mem_area_t {
+    byte *gc_alloc_table_start;
+    size_t gc_alloc_table_byte_len;
+    #if MICROPY_ENABLE_FINALISER
+    byte *gc_finaliser_table_start;
+    #endif
+    byte *gc_pool_start;
+    byte *gc_pool_end;
+
+    size_t gc_last_free_atb_index;
+
+    #if MICROPY_GC_MULTI_HEAP
+    uint16_t flags;             // GC_AREA_xxx
+    uint16_t cost;              // relative access cost of the memory
+    size_t n_alloc;             // number of allocations placed in this area
+    size_t n_fallback;          // allocations placed here because the preferred area was full
+    size_t scan_words;          // words scanned in this area by the last collection
+    #endif
+} mp_state_mem_area_t;
+
 // This structure hold information about the memory allocation system.
 typedef struct _mp_state_mem_t {
     #if MICROPY_MEM_STATS
@@ -70,16 +92,20 @@ typedef struct _mp_state_mem_t {
     size_t peak_bytes_allocated;
     #endif
 
-    byte *gc_alloc_table_start;
-    size_t gc_alloc_table_byte_len;
-    #if MICROPY_ENABLE_FINALISER
-    byte *gc_finaliser_table_start;
+    mp_state_mem_area_t gc_area[MICROPY_GC_MAX_AREAS];
+    #if MICROPY_GC_MULTI_HEAP
+    size_t gc_n_areas;
+    // lowest and highest address of all areas, for fast pointer rejection
+    byte *gc_heap_lo;
+    byte *gc_heap_hi;
+    size_t gc_fast_max_bytes;
     #endif
-    byte *gc_pool_start;
-    byte *gc_pool_end;
 
     int gc_stack_overflow;
     size_t gc_stack[MICROPY_ALLOC_GC_STACK_SIZE];
+    #if MICROPY_GC_MULTI_HEAP
+    uint8_t gc_area_stack[MICROPY_ALLOC_GC_STACK_SIZE];
+    #endif
     uint16_t gc_lock_depth;
 
     // This variable controls auto garbage collection.  If set to 0 then the
@@ -93,11 +119,19 @@ typedef struct _mp_state_mem_t {
     size_t gc_alloc_threshold;
     #endif
 
-    size_t gc_last_free_atb_index;
-
     size_t gc_collected;
     size_t gc_marked;
 
+    #if MICROPY_BOOT_TRACE
+    // total bytes allocated, to attribute heap use to traced events
+    size_t gc_alloc_total;
+    #endif
+
+    #if MICROPY_PY_MICROPYTHON_ALLOC_TRACE
+    // whether allocations are counted by the allocation tracer
+    bool alloc_trace_enabled;
+    #endif
+
     #if MICROPY_PY_THREAD
     // This is a global mutex used to make the GC thread-safe.
     mp_thread_mutex_t gc_mutex;
@@ -157,6 +191,11 @@ typedef struct _mp_state_vm_t {
     mp_obj_list_t mp_sys_path_obj;
     mp_obj_list_t mp_sys_argv_obj;
 
+    // directory of the compiled modules, MP_OBJ_NULL if the import cache is disabled
+    #if MICROPY_MODULE_IMPORT_CACHE
+    mp_obj_t import_cache_dir;
+    #endif
+
     // dictionary for overridden builtins
     #if MICROPY_CAN_OVERRIDE_BUILTINS
     mp_obj_dict_t *mp_module_builtins_override_dict;
@@ -180,6 +219,11 @@ typedef struct _mp_state_vm_t {
     mp_obj_t lwip_slip_stream;
     #endif
 
+    #if MICROPY_PY_URE && MICROPY_PY_URE_CACHE_SIZE
+    // patterns compiled by the ure module-level functions, most recently used first
+    mp_obj_t ure_cache[MICROPY_PY_URE_CACHE_SIZE];
+    #endif
+
     #if MICROPY_VFS
     struct _mp_vfs_mount_t *vfs_cur;
     struct _mp_vfs_mount_t *vfs_mount_table;
@@ -237,6 +281,11 @@ typedef struct _mp_state_thread_t {
     uint8_t *pystack_cur;
     #endif
 
+    #if MICROPY_CODE_STATE_CHAIN
+    // innermost bytecode function being executed, linked to its callers
+    struct _mp_code_state_t *current_code_state;
+    #endif
+
     ////////////////////////////////////////////////////////////
     // START ROOT POINTER SECTION
     // Everything that needs GC scanning must start here, and
@@ -34,6 +34,7 @@
 #include "py/binary.h"
 #include "py/objstr.h"
 #include "py/objarray.h"
+#include "py/gc.h"
 
 #if MICROPY_PY_ARRAY || MICROPY_PY_BUILTINS_BYTEARRAY || MICROPY_PY_BUILTINS_MEMORYVIEW
 
@@ -217,9 +218,44 @@ STATIC mp_obj_t array_make_new(const mp_obj_type_t *type_in, size_t n_args, size
 #endif
 
 #if MICROPY_PY_BUILTINS_BYTEARRAY
+#if MICROPY_GC_MULTI_HEAP
+// Allocate the bytearray data with the heap placement hint
+STATIC void bytearray_place(mp_obj_array_t *o, size_t len, unsigned int place) {
+    byte *items = gc_alloc_place(len, false, place);
+    if (items == NULL) {
+        m_malloc_fail(len);
+    }
+    if (o->items != NULL) {
+        memcpy(items, o->items, len);
+        m_del(byte, o->items, len);
+    }
+    o->items = items;
+    o->len = len;
+    o->free = 0;
+}
+#endif
+
 STATIC mp_obj_t bytearray_make_new(const mp_obj_type_t *type_in, size_t n_args, size_t n_kw, const mp_obj_t *args) {
     (void)type_in;
+    #if MICROPY_GC_MULTI_HEAP
+    // bytearray(n, fast=True) places the data into the fast heap area,
+    // fast=False into the slow area, by default it is placed by size
+    unsigned int place = GC_PLACE_AUTO;
+    if (n_kw > 0) {
+        enum { ARG_source, ARG_fast };
+        static const mp_arg_t allowed_args[] = {
+            { MP_QSTR_source, MP_ARG_OBJ, {.u_obj = MP_OBJ_NULL} },
+            { MP_QSTR_fast, MP_ARG_KW_ONLY | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+        };
+        mp_arg_val_t vals[MP_ARRAY_SIZE(allowed_args)];
+        mp_arg_parse_all_kw_array(n_args, n_kw, args, MP_ARRAY_SIZE(allowed_args), allowed_args, vals);
+        if (vals[ARG_fast].u_obj != mp_const_none) {
+            place = mp_obj_is_true(vals[ARG_fast].u_obj) ? GC_PLACE_FAST : GC_PLACE_SLOW;
+        }
+    }
+    #else
     mp_arg_check_num(n_args, n_kw, 0, 1, false);
+    #endif
 
     if (n_args == 0) {
         // no args: construct an empty bytearray
@@ -227,11 +263,28 @@ STATIC mp_obj_t bytearray_make_new(const mp_obj_type_t *type_in, size_t n_args,
     } else if (MP_OBJ_IS_INT(args[0])) {
         // 1 arg, an integer: construct a blank bytearray of that length
         mp_uint_t len = mp_obj_get_int(args[0]);
+        #if MICROPY_GC_MULTI_HEAP
+        if ((place != GC_PLACE_AUTO) && (len > 0)) {
+            mp_obj_array_t *o = array_new(BYTEARRAY_TYPECODE, 0, NULL);
+            bytearray_place(o, len, place);
+            memset(o->items, 0, len);
+            return MP_OBJ_FROM_PTR(o);
+        }
+        #endif
         mp_obj_array_t *o = array_new(BYTEARRAY_TYPECODE, len, NULL);
         memset(o->items, 0, len);
         return MP_OBJ_FROM_PTR(o);
     } else {
         // 1 arg: construct the bytearray from that
+        #if MICROPY_GC_MULTI_HEAP
+        if (place != GC_PLACE_AUTO) {
+            mp_obj_array_t *o = MP_OBJ_TO_PTR(array_construct(BYTEARRAY_TYPECODE, args[0]));
+            if (o->len > 0) {
+                bytearray_place(o, o->len, place);
+            }
+            return MP_OBJ_FROM_PTR(o);
+        }
+        #endif
         return array_construct(BYTEARRAY_TYPECODE, args[0]);
     }
 }
@@ -4,6 +4,7 @@
  * The MIT License (MIT)
  *
  * Copyright (c) 2018 Paul Sokolovsky
+ * Copyright (c) 2018 LoBo (https://github.com/loboris)
  *
  * Permission is hereby granted, free of charge, to any person obtaining a copy
  * of this software and associated documentation files (the "Software"), to deal
@@ -24,67 +25,229 @@
  * THE SOFTWARE.
  */
 
-#include <unistd.h> // for ssize_t
 #include <string.h>
 
 #include "py/mpconfig.h"
 #if MICROPY_PY_COLLECTIONS_DEQUE
 
 #include "py/runtime.h"
+#include "py/binary.h"
+
+// The items are kept in a ring buffer of 'alloc' slots starting at slot 'i_get'.
+// The buffer grows on demand, up to 'maxlen' slots for a bounded deque.
+// A typed deque stores the items as array values of the given typecode,
+// so numeric samples are kept without creating an object for each of them.
+
+#define DEQUE_UNBOUNDED ((size_t)-1)
+#define DEQUE_NO_SLOT   ((size_t)-1)
+#define DEQUE_MIN_ALLOC (4)
+
+#if MICROPY_PY_COLLECTIONS_DEQUE_TYPED
+#define DEQUE_IS_TYPED(self) ((self)->typecode != 0)
+#else
+#define DEQUE_IS_TYPED(self) (0)
+#endif
 
 typedef struct _mp_obj_deque_t {
     mp_obj_base_t base;
     size_t alloc;
     size_t i_get;
-    size_t i_put;
-    mp_obj_t *items;
-    uint32_t flags;
+    size_t len;
+    size_t maxlen;
+    byte *items;
+    uint16_t flags;
     #define FLAG_CHECK_OVERFLOW 1
+    char typecode;      // 0 for a deque of objects
+    uint8_t item_sz;
 } mp_obj_deque_t;
 
-STATIC mp_obj_t deque_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *args) {
-    mp_arg_check_num(n_args, n_kw, 2, 3, false);
+STATIC mp_obj_t deque_extend(mp_obj_t self_in, mp_obj_t arg_in);
+
+static inline size_t deque_slot(const mp_obj_deque_t *self, size_t i) {
+    i += self->i_get;
+    if (i >= self->alloc) {
+        i -= self->alloc;
+    }
+    return i;
+}
+
+STATIC mp_obj_t deque_get(const mp_obj_deque_t *self, size_t slot) {
+    #if MICROPY_PY_COLLECTIONS_DEQUE_TYPED
+    if (DEQUE_IS_TYPED(self)) {
+        return mp_binary_get_val_array(self->typecode, self->items, slot);
+    }
+    #endif
+    return ((mp_obj_t*)self->items)[slot];
+}
+
+STATIC void deque_set(mp_obj_deque_t *self, size_t slot, mp_obj_t item) {
+    #if MICROPY_PY_COLLECTIONS_DEQUE_TYPED
+    if (DEQUE_IS_TYPED(self)) {
+        mp_binary_set_val_array(self->typecode, self->items, slot, item);
+        return;
+    }
+    #endif
+    ((mp_obj_t*)self->items)[slot] = item;
+}
+
+STATIC void deque_grow(mp_obj_deque_t *self) {
+    size_t new_alloc = (self->alloc) ? self->alloc * 2 : DEQUE_MIN_ALLOC;
+    if (new_alloc > self->maxlen) {
+        new_alloc = self->maxlen;
+    }
+    self->items = m_renew(byte, self->items, self->alloc * self->item_sz, new_alloc * self->item_sz);
+    if (self->i_get > 0) {
+        // the buffer is full and wraps around, move the items
+        // from i_get to the end of the old buffer to the new end
+        size_t n = self->alloc - self->i_get;
+        memmove(self->items + (new_alloc - n) * self->item_sz, self->items + self->i_get * self->item_sz, n * self->item_sz);
+        memset(self->items + self->i_get * self->item_sz, 0, (new_alloc - self->alloc < n ? new_alloc - self->alloc : n) * self->item_sz);
+        self->i_get = new_alloc - n;
+    }
+    self->alloc = new_alloc;
+}
+
+// Make room for an item at the right end and return its slot, or DEQUE_NO_SLOT
+// if maxlen is 0.  A full bounded deque drops its leftmost item.
+STATIC size_t deque_push_slot(mp_obj_deque_t *self) {
+    if (self->len == self->maxlen) {
+        if (self->flags & FLAG_CHECK_OVERFLOW) {
+            mp_raise_msg(&mp_type_IndexError, "full");
+        }
+        if (self->len == 0) {
+            return DEQUE_NO_SLOT;
+        }
+        // the freed slot is the one used below
+        self->i_get = deque_slot(self, 1);
+        self->len--;
+    } else if (self->len == self->alloc) {
+        deque_grow(self);
+    }
+    return deque_slot(self, self->len++);
+}
 
-    /* Initialization from existing sequence is not supported, so an empty
-       tuple must be passed as such. */
-    if (args[0] != mp_const_empty_tuple) {
-        mp_raise_ValueError(NULL);
+// Same as deque_push_slot for the left end, a full bounded deque drops its rightmost item
+STATIC size_t deque_pushleft_slot(mp_obj_deque_t *self) {
+    if (self->len == self->maxlen) {
+        if (self->flags & FLAG_CHECK_OVERFLOW) {
+            mp_raise_msg(&mp_type_IndexError, "full");
+        }
+        if (self->len == 0) {
+            return DEQUE_NO_SLOT;
+        }
+        self->len--;
+    } else if (self->len == self->alloc) {
+        deque_grow(self);
     }
+    self->i_get = ((self->i_get) ? self->i_get : self->alloc) - 1;
+    self->len++;
+    return self->i_get;
+}
 
-    // Protect against -1 leading to zero-length allocation and bad array access
-    mp_int_t maxlen = mp_obj_get_int(args[1]);
-    if (maxlen < 0) {
-        mp_raise_ValueError(NULL);
+STATIC void deque_push(mp_obj_deque_t *self, mp_obj_t item, bool left) {
+    #if MICROPY_PY_COLLECTIONS_DEQUE_TYPED
+    // convert the value first, so that a bad value leaves the deque unchanged
+    uint64_t val;
+    if (DEQUE_IS_TYPED(self)) {
+        mp_binary_set_val_array(self->typecode, &val, 0, item);
     }
+    #endif
+    size_t slot = (left) ? deque_pushleft_slot(self) : deque_push_slot(self);
+    if (slot == DEQUE_NO_SLOT) {
+        return;
+    }
+    #if MICROPY_PY_COLLECTIONS_DEQUE_TYPED
+    if (DEQUE_IS_TYPED(self)) {
+        memcpy(self->items + slot * self->item_sz, &val, self->item_sz);
+        return;
+    }
+    #endif
+    ((mp_obj_t*)self->items)[slot] = item;
+}
+
+STATIC mp_obj_t deque_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *args) {
+    enum { ARG_iterable, ARG_maxlen, ARG_flags, ARG_typecode };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_iterable, MP_ARG_OBJ, {.u_obj = MP_OBJ_NULL} },
+        { MP_QSTR_maxlen, MP_ARG_OBJ, {.u_obj = mp_const_none} },
+        { MP_QSTR_flags, MP_ARG_INT, {.u_int = 0} },
+        #if MICROPY_PY_COLLECTIONS_DEQUE_TYPED
+        { MP_QSTR_typecode, MP_ARG_KW_ONLY | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+        #endif
+    };
+    mp_arg_val_t vals[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all_kw_array(n_args, n_kw, args, MP_ARRAY_SIZE(allowed_args), allowed_args, vals);
 
     mp_obj_deque_t *o = m_new_obj(mp_obj_deque_t);
     o->base.type = type;
-    o->alloc = maxlen + 1;
-    o->i_get = o->i_put = 0;
-    o->items = m_new0(mp_obj_t, o->alloc);
+    o->alloc = 0;
+    o->i_get = 0;
+    o->len = 0;
+    o->maxlen = DEQUE_UNBOUNDED;
+    o->items = NULL;
+    o->flags = vals[ARG_flags].u_int;
+    o->typecode = 0;
+    o->item_sz = sizeof(mp_obj_t);
+
+    if (vals[ARG_maxlen].u_obj != mp_const_none) {
+        mp_int_t maxlen = mp_obj_get_int(vals[ARG_maxlen].u_obj);
+        if (maxlen < 0) {
+            mp_raise_ValueError("maxlen must be non-negative");
+        }
+        o->maxlen = maxlen;
+    }
+
+    #if MICROPY_PY_COLLECTIONS_DEQUE_TYPED
+    if (vals[ARG_typecode].u_obj != mp_const_none) {
+        size_t len;
+        const char *typecode = mp_obj_str_get_data(vals[ARG_typecode].u_obj, &len);
+        if ((len != 1) || (strchr("bBhHiIlLqQfd", *typecode) == NULL)) {
+            mp_raise_ValueError("bad typecode");
+        }
+        o->typecode = *typecode;
+        o->item_sz = mp_binary_get_size('@', o->typecode, NULL);
+    }
+    #endif
 
-    if (n_args > 2) {
-        o->flags = mp_obj_get_int(args[2]);
+    if (vals[ARG_iterable].u_obj != MP_OBJ_NULL) {
+        deque_extend(MP_OBJ_FROM_PTR(o), vals[ARG_iterable].u_obj);
     }
 
     return MP_OBJ_FROM_PTR(o);
 }
 
+STATIC void deque_print(const mp_print_t *print, mp_obj_t self_in, mp_print_kind_t kind) {
+    (void)kind;
+    mp_obj_deque_t *self = MP_OBJ_TO_PTR(self_in);
+    mp_print_str(print, "deque([");
+    for (size_t i = 0; i < self->len; i++) {
+        if (i > 0) {
+            mp_print_str(print, ", ");
+        }
+        mp_obj_print_helper(print, deque_get(self, deque_slot(self, i)), PRINT_REPR);
+    }
+    mp_print_str(print, "]");
+    if (self->maxlen != DEQUE_UNBOUNDED) {
+        mp_printf(print, ", maxlen=%u", (uint)self->maxlen);
+    }
+    #if MICROPY_PY_COLLECTIONS_DEQUE_TYPED
+    if (DEQUE_IS_TYPED(self)) {
+        mp_printf(print, ", typecode='%c'", self->typecode);
+    }
+    #endif
+    mp_print_str(print, ")");
+}
+
 STATIC mp_obj_t deque_unary_op(mp_unary_op_t op, mp_obj_t self_in) {
     mp_obj_deque_t *self = MP_OBJ_TO_PTR(self_in);
     switch (op) {
         case MP_UNARY_OP_BOOL:
-            return mp_obj_new_bool(self->i_get != self->i_put);
-        case MP_UNARY_OP_LEN: {
-            ssize_t len = self->i_put - self->i_get;
-            if (len < 0) {
-                len += self->alloc;
-            }
-            return MP_OBJ_NEW_SMALL_INT(len);
-        }
+            return mp_obj_new_bool(self->len != 0);
+        case MP_UNARY_OP_LEN:
+            return MP_OBJ_NEW_SMALL_INT(self->len);
         #if MICROPY_PY_SYS_GETSIZEOF
         case MP_UNARY_OP_SIZEOF: {
-            size_t sz = sizeof(*self) + sizeof(mp_obj_t) * self->alloc;
+            size_t sz = sizeof(*self) + self->item_sz * self->alloc;
             return MP_OBJ_NEW_SMALL_INT(sz);
         }
         #endif
@@ -93,65 +256,202 @@ STATIC mp_obj_t deque_unary_op(mp_unary_op_t op, mp_obj_t self_in) {
     }
 }
 
-STATIC mp_obj_t mp_obj_deque_append(mp_obj_t self_in, mp_obj_t arg) {
+STATIC mp_obj_t deque_subscr(mp_obj_t self_in, mp_obj_t index, mp_obj_t value) {
     mp_obj_deque_t *self = MP_OBJ_TO_PTR(self_in);
-
-    size_t new_i_put = self->i_put + 1;
-    if (new_i_put == self->alloc) {
-        new_i_put = 0;
+    if (value == MP_OBJ_NULL) {
+        // delete not supported
+        return MP_OBJ_NULL;
     }
-
-    if (self->flags & FLAG_CHECK_OVERFLOW && new_i_put == self->i_get) {
-        mp_raise_msg(&mp_type_IndexError, "full");
+    size_t slot = deque_slot(self, mp_get_index(self->base.type, self->len, index, false));
+    if (value == MP_OBJ_SENTINEL) {
+        // load
+        return deque_get(self, slot);
     }
+    // store
+    deque_set(self, slot, value);
+    return mp_const_none;
+}
 
-    self->items[self->i_put] = arg;
-    self->i_put = new_i_put;
+typedef struct _mp_obj_deque_it_t {
+    mp_obj_base_t base;
+    mp_fun_1_t iternext;
+    mp_obj_t deque;
+    size_t cur;
+} mp_obj_deque_it_t;
 
-    if (self->i_get == new_i_put) {
-        if (++self->i_get == self->alloc) {
-            self->i_get = 0;
-        }
+STATIC mp_obj_t deque_it_iternext(mp_obj_t self_in) {
+    mp_obj_deque_it_t *self = MP_OBJ_TO_PTR(self_in);
+    mp_obj_deque_t *deque = MP_OBJ_TO_PTR(self->deque);
+    if (self->cur < deque->len) {
+        return deque_get(deque, deque_slot(deque, self->cur++));
     }
+    return MP_OBJ_STOP_ITERATION;
+}
+
+STATIC mp_obj_t deque_getiter(mp_obj_t self_in, mp_obj_iter_buf_t *iter_buf) {
+    assert(sizeof(mp_obj_deque_it_t) <= sizeof(mp_obj_iter_buf_t));
+    mp_obj_deque_it_t *o = (mp_obj_deque_it_t*)iter_buf;
+    o->base.type = &mp_type_polymorph_iter;
+    o->iternext = deque_it_iternext;
+    o->deque = self_in;
+    o->cur = 0;
+    return MP_OBJ_FROM_PTR(o);
+}
 
+STATIC mp_obj_t mp_obj_deque_append(mp_obj_t self_in, mp_obj_t arg) {
+    deque_push(MP_OBJ_TO_PTR(self_in), arg, false);
     return mp_const_none;
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_2(deque_append_obj, mp_obj_deque_append);
 
-STATIC mp_obj_t deque_popleft(mp_obj_t self_in) {
+STATIC mp_obj_t deque_appendleft(mp_obj_t self_in, mp_obj_t arg) {
+    deque_push(MP_OBJ_TO_PTR(self_in), arg, true);
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(deque_appendleft_obj, deque_appendleft);
+
+STATIC mp_obj_t deque_pop(mp_obj_t self_in) {
     mp_obj_deque_t *self = MP_OBJ_TO_PTR(self_in);
 
-    if (self->i_get == self->i_put) {
+    if (self->len == 0) {
         mp_raise_msg(&mp_type_IndexError, "empty");
     }
 
-    mp_obj_t ret = self->items[self->i_get];
-    self->items[self->i_get] = MP_OBJ_NULL;
+    size_t slot = deque_slot(self, self->len - 1);
+    mp_obj_t ret = deque_get(self, slot);
+    if (!DEQUE_IS_TYPED(self)) {
+        ((mp_obj_t*)self->items)[slot] = MP_OBJ_NULL;
+    }
+    self->len--;
+
+    return ret;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(deque_pop_obj, deque_pop);
+
+STATIC mp_obj_t deque_popleft(mp_obj_t self_in) {
+    mp_obj_deque_t *self = MP_OBJ_TO_PTR(self_in);
+
+    if (self->len == 0) {
+        mp_raise_msg(&mp_type_IndexError, "empty");
+    }
 
-    if (++self->i_get == self->alloc) {
-        self->i_get = 0;
+    mp_obj_t ret = deque_get(self, self->i_get);
+    if (!DEQUE_IS_TYPED(self)) {
+        ((mp_obj_t*)self->items)[self->i_get] = MP_OBJ_NULL;
     }
+    self->i_get = deque_slot(self, 1);
+    self->len--;
 
     return ret;
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_1(deque_popleft_obj, deque_popleft);
 
-#if 0
+STATIC void deque_extend_helper(mp_obj_t self_in, mp_obj_t arg_in, bool left) {
+    mp_obj_deque_t *self = MP_OBJ_TO_PTR(self_in);
+
+    #if MICROPY_PY_COLLECTIONS_DEQUE_TYPED
+    mp_buffer_info_t bufinfo;
+    if (DEQUE_IS_TYPED(self) && mp_get_buffer(arg_in, &bufinfo, MP_BUFFER_READ)
+        && ((bufinfo.typecode == self->typecode) || ((bufinfo.typecode == BYTEARRAY_TYPECODE) && (self->typecode == 'B')))) {
+        // array of the same type, copy the values without creating objects for them
+        const byte *src = bufinfo.buf;
+        for (size_t n = bufinfo.len / self->item_sz; n > 0; n--, src += self->item_sz) {
+            size_t slot = (left) ? deque_pushleft_slot(self) : deque_push_slot(self);
+            if (slot != DEQUE_NO_SLOT) {
+                memcpy(self->items + slot * self->item_sz, src, self->item_sz);
+            }
+        }
+        return;
+    }
+    #endif
+
+    if (arg_in == self_in) {
+        // iterate over a copy, the deque changes while it is extended
+        arg_in = mp_call_function_1(MP_OBJ_FROM_PTR(&mp_type_list), arg_in);
+    }
+    mp_obj_iter_buf_t iter_buf;
+    mp_obj_t iterable = mp_getiter(arg_in, &iter_buf);
+    mp_obj_t item;
+    while ((item = mp_iternext(iterable)) != MP_OBJ_STOP_ITERATION) {
+        deque_push(self, item, left);
+    }
+}
+
+STATIC mp_obj_t deque_extend(mp_obj_t self_in, mp_obj_t arg_in) {
+    deque_extend_helper(self_in, arg_in, false);
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(deque_extend_obj, deque_extend);
+
+STATIC mp_obj_t deque_extendleft(mp_obj_t self_in, mp_obj_t arg_in) {
+    deque_extend_helper(self_in, arg_in, true);
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(deque_extendleft_obj, deque_extendleft);
+
+// Rotate n steps to the right, to the left if n is negative
+STATIC mp_obj_t deque_rotate(size_t n_args, const mp_obj_t *args) {
+    mp_obj_deque_t *self = MP_OBJ_TO_PTR(args[0]);
+    mp_int_t len = self->len;
+    mp_int_t n = (n_args > 1) ? mp_obj_get_int(args[1]) : 1;
+
+    if (len <= 1) {
+        return mp_const_none;
+    }
+    n %= len;
+    if (n < 0) {
+        n += len;
+    }
+    if (n == 0) {
+        return mp_const_none;
+    }
+
+    size_t sz = self->item_sz;
+    if (self->len == self->alloc) {
+        // no free slot, only the start of the ring moves
+        self->i_get = deque_slot(self, len - n);
+    } else if (n <= len / 2) {
+        // move n items from the right end to the left end
+        while (n--) {
+            size_t src = deque_slot(self, len - 1);
+            self->i_get = ((self->i_get) ? self->i_get : self->alloc) - 1;
+            memcpy(self->items + self->i_get * sz, self->items + src * sz, sz);
+            memset(self->items + src * sz, 0, sz);
+        }
+    } else {
+        // move len - n items from the left end to the right end
+        for (n = len - n; n > 0; n--) {
+            size_t dst = deque_slot(self, len);
+            memcpy(self->items + dst * sz, self->items + self->i_get * sz, sz);
+            memset(self->items + self->i_get * sz, 0, sz);
+            self->i_get = deque_slot(self, 1);
+        }
+    }
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(deque_rotate_obj, 1, 2, deque_rotate);
+
 STATIC mp_obj_t deque_clear(mp_obj_t self_in) {
     mp_obj_deque_t *self = MP_OBJ_TO_PTR(self_in);
-    self->i_get = self->i_put = 0;
-    mp_seq_clear(self->items, 0, self->alloc, sizeof(*self->items));
+    // release the buffer, it grows again on demand
+    m_del(byte, self->items, self->alloc * self->item_sz);
+    self->items = NULL;
+    self->alloc = 0;
+    self->i_get = 0;
+    self->len = 0;
     return mp_const_none;
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_1(deque_clear_obj, deque_clear);
-#endif
 
 STATIC const mp_rom_map_elem_t deque_locals_dict_table[] = {
     { MP_ROM_QSTR(MP_QSTR_append), MP_ROM_PTR(&deque_append_obj) },
-    #if 0
-    { MP_ROM_QSTR(MP_QSTR_clear), MP_ROM_PTR(&deque_clear_obj) },
-    #endif
+    { MP_ROM_QSTR(MP_QSTR_appendleft), MP_ROM_PTR(&deque_appendleft_obj) },
+    { MP_ROM_QSTR(MP_QSTR_pop), MP_ROM_PTR(&deque_pop_obj) },
     { MP_ROM_QSTR(MP_QSTR_popleft), MP_ROM_PTR(&deque_popleft_obj) },
+    { MP_ROM_QSTR(MP_QSTR_extend), MP_ROM_PTR(&deque_extend_obj) },
+    { MP_ROM_QSTR(MP_QSTR_extendleft), MP_ROM_PTR(&deque_extendleft_obj) },
+    { MP_ROM_QSTR(MP_QSTR_rotate), MP_ROM_PTR(&deque_rotate_obj) },
+    { MP_ROM_QSTR(MP_QSTR_clear), MP_ROM_PTR(&deque_clear_obj) },
 };
 
 STATIC MP_DEFINE_CONST_DICT(deque_locals_dict, deque_locals_dict_table);
@@ -159,8 +459,11 @@ STATIC MP_DEFINE_CONST_DICT(deque_locals_dict, deque_locals_dict_table);
 const mp_obj_type_t mp_type_deque = {
     { &mp_type_type },
     .name = MP_QSTR_deque,
+    .print = deque_print,
     .make_new = deque_make_new,
     .unary_op = deque_unary_op,
+    .subscr = deque_subscr,
+    .getiter = deque_getiter,
     .locals_dict = (mp_obj_dict_t*)&deque_locals_dict,
 };
 
@@ -5,6 +5,7 @@
  *
  * Copyright (c) 2013, 2014 Damien P. George
  * Copyright (c) 2014-2017 Paul Sokolovsky
+ * Copyright (c) 2018 LoBo (https://github.com/loboris)
  *
  * Permission is hereby granted, free of charge, to any person obtaining a copy
  * of this software and associated documentation files (the "Software"), to deal
@@ -86,6 +87,20 @@ mp_obj_t mp_obj_new_gen_wrap(mp_obj_t fun) {
 /******************************************************************************/
 /* generator instance                                                         */
 
+// Give the frame (locals, value stack and exception stack) of a finished
+// generator back to the heap, only the object header stays allocated.  The
+// generator never runs again, so the next allocation can reuse the blocks
+// instead of waiting for the generator object to be collected.
+STATIC void gen_release_frame(mp_obj_gen_instance_t *self) {
+    const byte *bytecode = self->code_state.fun_bc->bytecode;
+    size_t n_state = mp_decode_uint_value(bytecode);
+    size_t n_exc_stack = mp_decode_uint_value(mp_decode_uint_skip(bytecode));
+    size_t frame_size = n_state * sizeof(mp_obj_t) + n_exc_stack * sizeof(mp_exc_stack_t);
+    (void)m_renew_maybe(byte, self, sizeof(mp_obj_gen_instance_t) + frame_size, sizeof(mp_obj_gen_instance_t), false);
+    self->code_state.sp = NULL;
+    self->code_state.exc_sp = NULL;
+}
+
 STATIC void gen_instance_print(const mp_print_t *print, mp_obj_t self_in, mp_print_kind_t kind) {
     (void)kind;
     mp_obj_gen_instance_t *self = MP_OBJ_TO_PTR(self_in);
@@ -101,6 +116,9 @@ mp_vm_return_kind_t mp_obj_gen_resume(mp_obj_t self_in, mp_obj_t send_value, mp_
         *ret_val = MP_OBJ_STOP_ITERATION;
         return MP_VM_RETURN_NORMAL;
     }
+    if (self->globals == NULL) {
+        mp_raise_ValueError("generator already executing");
+    }
     if (self->code_state.sp == self->code_state.state - 1) {
         if (send_value != mp_const_none) {
             mp_raise_TypeError("can't send non-None value to a just-started generator");
@@ -117,10 +135,15 @@ mp_vm_return_kind_t mp_obj_gen_resume(mp_obj_t self_in, mp_obj_t send_value, mp_
             *self->code_state.sp = send_value;
         }
     }
+    // the globals of a running generator are cleared, so it can't be resumed
+    // from its own code
     mp_obj_dict_t *old_globals = mp_globals_get();
-    mp_globals_set(self->globals);
+    mp_obj_dict_t *gen_globals = self->globals;
+    self->globals = NULL;
+    mp_globals_set(gen_globals);
     mp_vm_return_kind_t ret_kind = mp_execute_bytecode(&self->code_state, throw_value);
     mp_globals_set(old_globals);
+    self->globals = gen_globals;
 
     switch (ret_kind) {
         case MP_VM_RETURN_NORMAL:
@@ -132,6 +155,7 @@ mp_vm_return_kind_t mp_obj_gen_resume(mp_obj_t self_in, mp_obj_t send_value, mp_
             // in CPython.
             self->code_state.ip = 0;
             *ret_val = *self->code_state.sp;
+            gen_release_frame(self);
             break;
 
         case MP_VM_RETURN_YIELD:
@@ -145,6 +169,7 @@ mp_vm_return_kind_t mp_obj_gen_resume(mp_obj_t self_in, mp_obj_t send_value, mp_
             size_t n_state = mp_decode_uint_value(self->code_state.fun_bc->bytecode);
             self->code_state.ip = 0;
             *ret_val = self->code_state.state[n_state - 1];
+            gen_release_frame(self);
             break;
         }
     }
@@ -235,6 +260,10 @@ STATIC MP_DEFINE_CONST_FUN_OBJ_1(gen_instance_close_obj, gen_instance_close);
 
 STATIC mp_obj_t gen_instance_pend_throw(mp_obj_t self_in, mp_obj_t exc_in) {
     mp_obj_gen_instance_t *self = MP_OBJ_TO_PTR(self_in);
+    if (self->code_state.ip == 0) {
+        // finished, its frame may be released already
+        return mp_const_none;
+    }
     if (self->code_state.sp == self->code_state.state - 1) {
         mp_raise_TypeError("can't pend throw to just-started generator");
     }
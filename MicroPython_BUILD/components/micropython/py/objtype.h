@@ -54,4 +54,24 @@ mp_obj_t mp_obj_instance_call(mp_obj_t self_in, size_t n_args, size_t n_kw, cons
 // this needs to be exposed for the above macros to work correctly
 mp_obj_t mp_obj_instance_make_new(const mp_obj_type_t *self_in, size_t n_args, size_t n_kw, const mp_obj_t *args);
 
+// these are exposed so classes of frozen modules can be defined in ROM
+void mp_obj_instance_print(const mp_print_t *print, mp_obj_t self_in, mp_print_kind_t kind);
+mp_obj_t mp_obj_instance_unary_op(mp_unary_op_t op, mp_obj_t self_in);
+mp_obj_t mp_obj_instance_binary_op(mp_binary_op_t op, mp_obj_t lhs_in, mp_obj_t rhs_in);
+mp_obj_t mp_obj_instance_subscr(mp_obj_t self_in, mp_obj_t index, mp_obj_t value);
+mp_obj_t mp_obj_instance_getiter(mp_obj_t self_in, mp_obj_iter_buf_t *iter_buf);
+mp_int_t mp_obj_instance_get_buffer(mp_obj_t self_in, mp_buffer_info_t *bufinfo, mp_uint_t flags);
+
+// the slots that mp_obj_new_type sets for a class defined in Python
+#define MP_OBJ_INSTANCE_TYPE_SLOTS \
+    .print = mp_obj_instance_print, \
+    .make_new = mp_obj_instance_make_new, \
+    .call = mp_obj_instance_call, \
+    .unary_op = mp_obj_instance_unary_op, \
+    .binary_op = mp_obj_instance_binary_op, \
+    .attr = mp_obj_instance_attr, \
+    .subscr = mp_obj_instance_subscr, \
+    .getiter = mp_obj_instance_getiter, \
+    .buffer_p = { .get_buffer = mp_obj_instance_get_buffer }
+
 #endif // MICROPY_INCLUDED_PY_OBJTYPE_H
@@ -829,60 +829,68 @@ STATIC void push_result_rule(parser_t *parser, size_t src_line, uint8_t rule_id,
     push_result_node(parser, (mp_parse_node_t)pn);
 }
 
-mp_parse_tree_t mp_parse(mp_lexer_t *lex, mp_parse_input_kind_t input_kind) {
-
-    // initialise parser and allocate memory for its stacks
-
-    parser_t parser;
+STATIC NORETURN void parse_syntax_error(mp_lexer_t *lex) {
+    mp_obj_t exc;
+    if (lex->tok_kind == MP_TOKEN_INDENT) {
+        exc = mp_obj_new_exception_msg(&mp_type_IndentationError,
+            "unexpected indent");
+    } else if (lex->tok_kind == MP_TOKEN_DEDENT_MISMATCH) {
+        exc = mp_obj_new_exception_msg(&mp_type_IndentationError,
+            "unindent does not match any outer indentation level");
+    } else {
+        exc = mp_obj_new_exception_msg(&mp_type_SyntaxError,
+            "invalid syntax");
+    }
+    // add traceback to give info about file name and location
+    // we don't have a 'block' name, so just pass the NULL qstr to indicate this
+    mp_obj_exception_add_traceback(exc, lex->source_name, lex->tok_line, MP_QSTR_NULL);
+    nlr_raise(exc);
+}
 
-    parser.rule_stack_alloc = MICROPY_ALLOC_PARSE_RULE_INIT;
-    parser.rule_stack_top = 0;
-    parser.rule_stack = m_new(rule_stack_t, parser.rule_stack_alloc);
+STATIC void parser_init(parser_t *parser, mp_lexer_t *lex) {
+    parser->rule_stack_alloc = MICROPY_ALLOC_PARSE_RULE_INIT;
+    parser->rule_stack_top = 0;
+    parser->rule_stack = m_new(rule_stack_t, parser->rule_stack_alloc);
 
-    parser.result_stack_alloc = MICROPY_ALLOC_PARSE_RESULT_INIT;
-    parser.result_stack_top = 0;
-    parser.result_stack = m_new(mp_parse_node_t, parser.result_stack_alloc);
+    parser->result_stack_alloc = MICROPY_ALLOC_PARSE_RESULT_INIT;
+    parser->result_stack_top = 0;
+    parser->result_stack = m_new(mp_parse_node_t, parser->result_stack_alloc);
 
-    parser.lexer = lex;
+    parser->lexer = lex;
 
-    parser.tree.chunk = NULL;
-    parser.cur_chunk = NULL;
+    parser->tree.chunk = NULL;
+    parser->cur_chunk = NULL;
 
     #if MICROPY_COMP_CONST
-    mp_map_init(&parser.consts, 0);
+    mp_map_init(&parser->consts, 0);
     #endif
+}
 
-    // work out the top-level rule to use, and push it on the stack
-    size_t top_level_rule;
-    switch (input_kind) {
-        case MP_PARSE_SINGLE_INPUT: top_level_rule = RULE_single_input; break;
-        case MP_PARSE_EVAL_INPUT: top_level_rule = RULE_eval_input; break;
-        default: top_level_rule = RULE_file_input;
-    }
-    push_rule(&parser, lex->tok_line, top_level_rule, 0);
-
-    // parse!
+// parse the input matching the given rule, the result is left on the result stack
+STATIC void parse_rule(parser_t *parser, size_t top_level_rule, mp_parse_input_kind_t input_kind) {
+    mp_lexer_t *lex = parser->lexer;
+    push_rule(parser, lex->tok_line, top_level_rule, 0);
 
     bool backtrack = false;
 
     for (;;) {
         next_rule:
-        if (parser.rule_stack_top == 0) {
+        if (parser->rule_stack_top == 0) {
             break;
         }
 
         // Pop the next rule to process it
         size_t i; // state for the current rule
         size_t rule_src_line; // source line for the first token matched by the current rule
-        uint8_t rule_id = pop_rule(&parser, &i, &rule_src_line);
+        uint8_t rule_id = pop_rule(parser, &i, &rule_src_line);
         uint8_t rule_act = rule_act_table[rule_id];
         const uint16_t *rule_arg = get_rule_arg(rule_id);
         size_t n = rule_act & RULE_ACT_ARG_MASK;
 
         #if 0
         // debugging
-        printf("depth=" UINT_FMT " ", parser.rule_stack_top);
-        for (int j = 0; j < parser.rule_stack_top; ++j) {
+        printf("depth=" UINT_FMT " ", parser->rule_stack_top);
+        for (int j = 0; j < parser->rule_stack_top; ++j) {
             printf(" ");
         }
         printf("%s n=" UINT_FMT " i=" UINT_FMT " bt=%d\n", rule_name_table[rule_id], n, i, backtrack);
@@ -899,16 +907,16 @@ mp_parse_tree_t mp_parse(mp_lexer_t *lex, mp_parse_input_kind_t input_kind) {
                     uint16_t kind = rule_arg[i] & RULE_ARG_KIND_MASK;
                     if (kind == RULE_ARG_TOK) {
                         if (lex->tok_kind == (rule_arg[i] & RULE_ARG_ARG_MASK)) {
-                            push_result_token(&parser, rule_id);
+                            push_result_token(parser, rule_id);
                             mp_lexer_to_next(lex);
                             goto next_rule;
                         }
                     } else {
                         assert(kind == RULE_ARG_RULE);
                         if (i + 1 < n) {
-                            push_rule(&parser, rule_src_line, rule_id, i + 1); // save this or-rule
+                            push_rule(parser, rule_src_line, rule_id, i + 1); // save this or-rule
                         }
-                        push_rule_from_arg(&parser, rule_arg[i]); // push child of or-rule
+                        push_rule_from_arg(parser, rule_arg[i]); // push child of or-rule
                         goto next_rule;
                     }
                 }
@@ -922,7 +930,7 @@ mp_parse_tree_t mp_parse(mp_lexer_t *lex, mp_parse_input_kind_t input_kind) {
                     assert(i > 0);
                     if ((rule_arg[i - 1] & RULE_ARG_KIND_MASK) == RULE_ARG_OPT_RULE) {
                         // an optional rule that failed, so continue with next arg
-                        push_result_node(&parser, MP_PARSE_NODE_NULL);
+                        push_result_node(parser, MP_PARSE_NODE_NULL);
                         backtrack = false;
                     } else {
                         // a mandatory rule that failed, so propagate backtrack
@@ -943,7 +951,7 @@ mp_parse_tree_t mp_parse(mp_lexer_t *lex, mp_parse_input_kind_t input_kind) {
                         if (lex->tok_kind == tok_kind) {
                             // matched token
                             if (tok_kind == MP_TOKEN_NAME) {
-                                push_result_token(&parser, rule_id);
+                                push_result_token(parser, rule_id);
                             }
                             mp_lexer_to_next(lex);
                         } else {
@@ -958,8 +966,8 @@ mp_parse_tree_t mp_parse(mp_lexer_t *lex, mp_parse_input_kind_t input_kind) {
                             }
                         }
                     } else {
-                        push_rule(&parser, rule_src_line, rule_id, i + 1); // save this and-rule
-                        push_rule_from_arg(&parser, rule_arg[i]); // push child of and-rule
+                        push_rule(parser, rule_src_line, rule_id, i + 1); // save this and-rule
+                        push_rule_from_arg(parser, rule_arg[i]); // push child of and-rule
                         goto next_rule;
                     }
                 }
@@ -970,16 +978,16 @@ mp_parse_tree_t mp_parse(mp_lexer_t *lex, mp_parse_input_kind_t input_kind) {
 
                 #if !MICROPY_ENABLE_DOC_STRING
                 // this code discards lonely statements, such as doc strings
-                if (input_kind != MP_PARSE_SINGLE_INPUT && rule_id == RULE_expr_stmt && peek_result(&parser, 0) == MP_PARSE_NODE_NULL) {
-                    mp_parse_node_t p = peek_result(&parser, 1);
+                if (input_kind != MP_PARSE_SINGLE_INPUT && rule_id == RULE_expr_stmt && peek_result(parser, 0) == MP_PARSE_NODE_NULL) {
+                    mp_parse_node_t p = peek_result(parser, 1);
                     if ((MP_PARSE_NODE_IS_LEAF(p) && !MP_PARSE_NODE_IS_ID(p))
                         || MP_PARSE_NODE_IS_STRUCT_KIND(p, RULE_const_object)) {
-                        pop_result(&parser); // MP_PARSE_NODE_NULL
-                        pop_result(&parser); // const expression (leaf or RULE_const_object)
+                        pop_result(parser); // MP_PARSE_NODE_NULL
+                        pop_result(parser); // const expression (leaf or RULE_const_object)
                         // Pushing the "pass" rule here will overwrite any RULE_const_object
                         // entry that was on the result stack, allowing the GC to reclaim
                         // the memory from the const object when needed.
-                        push_result_rule(&parser, rule_src_line, RULE_pass_stmt, 0);
+                        push_result_rule(parser, rule_src_line, RULE_pass_stmt, 0);
                         break;
                     }
                 }
@@ -999,7 +1007,7 @@ mp_parse_tree_t mp_parse(mp_lexer_t *lex, mp_parse_input_kind_t input_kind) {
                         }
                     } else {
                         // rules are always pushed
-                        if (peek_result(&parser, i) != MP_PARSE_NODE_NULL) {
+                        if (peek_result(parser, i) != MP_PARSE_NODE_NULL) {
                             num_not_nil += 1;
                         }
                         i += 1;
@@ -1010,22 +1018,22 @@ mp_parse_tree_t mp_parse(mp_lexer_t *lex, mp_parse_input_kind_t input_kind) {
                     // this rule has only 1 argument and should not be emitted
                     mp_parse_node_t pn = MP_PARSE_NODE_NULL;
                     for (size_t x = 0; x < i; ++x) {
-                        mp_parse_node_t pn2 = pop_result(&parser);
+                        mp_parse_node_t pn2 = pop_result(parser);
                         if (pn2 != MP_PARSE_NODE_NULL) {
                             pn = pn2;
                         }
                     }
-                    push_result_node(&parser, pn);
+                    push_result_node(parser, pn);
                 } else {
                     // this rule must be emitted
 
                     if (rule_act & RULE_ACT_ADD_BLANK) {
                         // and add an extra blank node at the end (used by the compiler to store data)
-                        push_result_node(&parser, MP_PARSE_NODE_NULL);
+                        push_result_node(parser, MP_PARSE_NODE_NULL);
                         i += 1;
                     }
 
-                    push_result_rule(&parser, rule_src_line, rule_id, i);
+                    push_result_rule(parser, rule_src_line, rule_id, i);
                 }
                 break;
             }
@@ -1075,7 +1083,7 @@ mp_parse_tree_t mp_parse(mp_lexer_t *lex, mp_parse_input_kind_t input_kind) {
                                 if (i & 1 & n) {
                                     // separators which are tokens are not pushed to result stack
                                 } else {
-                                    push_result_token(&parser, rule_id);
+                                    push_result_token(parser, rule_id);
                                 }
                                 mp_lexer_to_next(lex);
                                 // got element of list, so continue parsing list
@@ -1088,8 +1096,8 @@ mp_parse_tree_t mp_parse(mp_lexer_t *lex, mp_parse_input_kind_t input_kind) {
                             }
                         } else {
                             assert((arg & RULE_ARG_KIND_MASK) == RULE_ARG_RULE);
-                            push_rule(&parser, rule_src_line, rule_id, i + 1); // save this list-rule
-                            push_rule_from_arg(&parser, arg); // push child of list-rule
+                            push_rule(parser, rule_src_line, rule_id, i + 1); // save this list-rule
+                            push_rule_from_arg(parser, arg); // push child of list-rule
                             goto next_rule;
                         }
                     }
@@ -1107,17 +1115,40 @@ mp_parse_tree_t mp_parse(mp_lexer_t *lex, mp_parse_input_kind_t input_kind) {
                     // list matched single item
                     if (had_trailing_sep) {
                         // if there was a trailing separator, make a list of a single item
-                        push_result_rule(&parser, rule_src_line, rule_id, i);
+                        push_result_rule(parser, rule_src_line, rule_id, i);
                     } else {
                         // just leave single item on stack (ie don't wrap in a list)
                     }
                 } else {
-                    push_result_rule(&parser, rule_src_line, rule_id, i);
+                    push_result_rule(parser, rule_src_line, rule_id, i);
                 }
                 break;
             }
         }
     }
+    return;
+
+syntax_error:
+    parse_syntax_error(lex);
+}
+
+mp_parse_tree_t mp_parse(mp_lexer_t *lex, mp_parse_input_kind_t input_kind) {
+
+    // initialise parser and allocate memory for its stacks
+
+    parser_t parser;
+    parser_init(&parser, lex);
+
+    // work out the top-level rule to use
+    size_t top_level_rule;
+    switch (input_kind) {
+        case MP_PARSE_SINGLE_INPUT: top_level_rule = RULE_single_input; break;
+        case MP_PARSE_EVAL_INPUT: top_level_rule = RULE_eval_input; break;
+        default: top_level_rule = RULE_file_input;
+    }
+
+    // parse!
+    parse_rule(&parser, top_level_rule, input_kind);
 
     #if MICROPY_COMP_CONST
     mp_map_deinit(&parser.consts);
@@ -1138,22 +1169,7 @@ mp_parse_tree_t mp_parse(mp_lexer_t *lex, mp_parse_input_kind_t input_kind) {
         lex->tok_kind != MP_TOKEN_END // check we are at the end of the token stream
         || parser.result_stack_top == 0 // check that we got a node (can fail on empty input)
         ) {
-    syntax_error:;
-        mp_obj_t exc;
-        if (lex->tok_kind == MP_TOKEN_INDENT) {
-            exc = mp_obj_new_exception_msg(&mp_type_IndentationError,
-                "unexpected indent");
-        } else if (lex->tok_kind == MP_TOKEN_DEDENT_MISMATCH) {
-            exc = mp_obj_new_exception_msg(&mp_type_IndentationError,
-                "unindent does not match any outer indentation level");
-        } else {
-            exc = mp_obj_new_exception_msg(&mp_type_SyntaxError,
-                "invalid syntax");
-        }
-        // add traceback to give info about file name and location
-        // we don't have a 'block' name, so just pass the NULL qstr to indicate this
-        mp_obj_exception_add_traceback(exc, lex->source_name, lex->tok_line, MP_QSTR_NULL);
-        nlr_raise(exc);
+        parse_syntax_error(lex);
     }
 
     // get the root parse node that we created
@@ -1170,6 +1186,80 @@ mp_parse_tree_t mp_parse(mp_lexer_t *lex, mp_parse_input_kind_t input_kind) {
     return parser.tree;
 }
 
+#if MICROPY_COMP_STREAM
+
+STATIC void parser_free_chunks(mp_parse_chunk_t *chunk) {
+    while (chunk != NULL) {
+        mp_parse_chunk_t *next = chunk->union_.next;
+        m_del(byte, chunk, sizeof(mp_parse_chunk_t) + chunk->alloc);
+        chunk = next;
+    }
+}
+
+mp_parse_stream_t *mp_parse_stream_new(mp_lexer_t *lex) {
+    parser_t *parser = m_new_obj(parser_t);
+    parser_init(parser, lex);
+    parser->tree.root = MP_PARSE_NODE_NULL; // no statement parsed yet
+    return (mp_parse_stream_t*)parser;
+}
+
+bool mp_parse_stream_next(mp_parse_stream_t *ps, mp_parse_tree_t *tree) {
+    parser_t *parser = (parser_t*)ps;
+    mp_lexer_t *lex = parser->lexer;
+
+    // the nodes of the previous statement are no longer needed; the filled
+    // chunks are freed and the current one is reused for the next statement
+    parser_free_chunks(parser->tree.chunk);
+    parser->tree.chunk = NULL;
+    if (parser->cur_chunk != NULL) {
+        parser->cur_chunk->union_.used = 0;
+    }
+
+    // skip blank lines until a statement is found
+    mp_parse_node_t pn;
+    size_t src_line;
+    do {
+        if (lex->tok_kind == MP_TOKEN_END) {
+            return false;
+        }
+        src_line = lex->tok_line;
+        parse_rule(parser, RULE_file_input_3, MP_PARSE_FILE_INPUT);
+        if (parser->result_stack_top != 1) {
+            parse_syntax_error(lex);
+        }
+        pn = pop_result(parser);
+    } while (MP_PARSE_NODE_IS_TOKEN_KIND(pn, MP_TOKEN_NEWLINE));
+
+    // wrap the statement in a node the compiler takes as module input; only the
+    // first statement of the file is checked for a doc string
+    push_result_node(parser, pn);
+    bool first = parser->tree.root == MP_PARSE_NODE_NULL;
+    push_result_rule(parser, src_line, first ? RULE_file_input_2 : RULE_file_input, 1);
+    parser->tree.root = pop_result(parser);
+
+    // the chunks stay owned by the stream so the compiler doesn't free them
+    tree->root = parser->tree.root;
+    tree->chunk = NULL;
+    return true;
+}
+
+void mp_parse_stream_free(mp_parse_stream_t *ps) {
+    parser_t *parser = (parser_t*)ps;
+    parser_free_chunks(parser->tree.chunk);
+    if (parser->cur_chunk != NULL) {
+        m_del(byte, parser->cur_chunk, sizeof(mp_parse_chunk_t) + parser->cur_chunk->alloc);
+    }
+    #if MICROPY_COMP_CONST
+    mp_map_deinit(&parser->consts);
+    #endif
+    m_del(rule_stack_t, parser->rule_stack, parser->rule_stack_alloc);
+    m_del(mp_parse_node_t, parser->result_stack, parser->result_stack_alloc);
+    mp_lexer_free(parser->lexer);
+    m_del_obj(parser_t, parser);
+}
+
+#endif // MICROPY_COMP_STREAM
+
 void mp_parse_tree_clear(mp_parse_tree_t *tree) {
     mp_parse_chunk_t *chunk = tree->chunk;
     while (chunk != NULL) {
@@ -104,4 +104,13 @@ typedef struct _mp_parse_t {
 mp_parse_tree_t mp_parse(struct _mp_lexer_t *lex, mp_parse_input_kind_t input_kind);
 void mp_parse_tree_clear(mp_parse_tree_t *tree);
 
+#if MICROPY_COMP_STREAM
+// the file input is parsed one top-level statement at a time; the tree returned by
+// mp_parse_stream_next is valid until the next call, the stream frees the lexer
+typedef struct _mp_parse_stream_t mp_parse_stream_t;
+mp_parse_stream_t *mp_parse_stream_new(struct _mp_lexer_t *lex);
+bool mp_parse_stream_next(mp_parse_stream_t *ps, mp_parse_tree_t *tree);
+void mp_parse_stream_free(mp_parse_stream_t *ps);
+#endif
+
 #endif // MICROPY_INCLUDED_PY_PARSE_H
@@ -0,0 +1,151 @@
+/*
+ * This file is part of the MicroPython ESP32 project, https://github.com/loboris/MicroPython_ESP32_psRAM_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <string.h>
+
+#include "py/runtime.h"
+#include "py/bc.h"
+#include "py/profile.h"
+
+#if MICROPY_PY_MICROPYTHON_PROFILE
+
+#if !MICROPY_ENABLE_SCHEDULER
+#error "MICROPY_PY_MICROPYTHON_PROFILE requires MICROPY_ENABLE_SCHEDULER"
+#endif
+
+typedef struct _profile_frame_t {
+    uint16_t block;     // qstr of the function name
+    uint16_t file;      // qstr of the source file
+    uint16_t line;
+} profile_frame_t;
+
+typedef struct _profile_entry_t {
+    uint32_t count;     // ticks counted against this stack, 0 if the entry is free
+    uint16_t depth;
+    profile_frame_t frame[MICROPY_PY_MICROPYTHON_PROFILE_DEPTH]; // innermost first
+} profile_entry_t;
+
+// The histogram is static so taking a sample never allocates.  The timer only
+// writes profile_ticks and the VM only writes profile_taken, so no lock is
+// needed between them.
+STATIC profile_entry_t profile_hist[MICROPY_PY_MICROPYTHON_PROFILE_ENTRIES];
+STATIC volatile uint32_t profile_ticks;
+STATIC uint32_t profile_taken;
+STATIC uint32_t profile_dropped; // ticks of stacks that did not fit in the histogram
+
+void mp_profile_tick(void) {
+    profile_ticks++;
+    // make the VM take the sample at its next pending check
+    mp_uint_t atomic_state = MICROPY_BEGIN_ATOMIC_SECTION();
+    if (MP_STATE_VM(sched_state) == MP_SCHED_IDLE) {
+        MP_STATE_VM(sched_state) = MP_SCHED_PENDING;
+    }
+    MICROPY_END_ATOMIC_SECTION(atomic_state);
+}
+
+STATIC void profile_get_frame(const mp_code_state_t *code_state, profile_frame_t *frame) {
+    qstr block, file;
+    size_t line = mp_code_state_get_location(code_state, &block, &file);
+    frame->block = block;
+    frame->file = file;
+    frame->line = line > 0xffff ? 0xffff : line;
+}
+
+void mp_profile_sample(void) {
+    uint32_t ticks = profile_ticks;
+    uint32_t n = ticks - profile_taken;
+    if (n == 0) {
+        return;
+    }
+    profile_taken = ticks;
+
+    // the ticks since the last sample are counted against the current stack,
+    // an empty stack when no Python code is running
+    profile_entry_t sample;
+    memset(&sample, 0, sizeof(sample));
+    for (const mp_code_state_t *code_state = MP_STATE_THREAD(current_code_state);
+        code_state != NULL && sample.depth < MICROPY_PY_MICROPYTHON_PROFILE_DEPTH;
+        code_state = code_state->prev_state) {
+        profile_get_frame(code_state, &sample.frame[sample.depth++]);
+    }
+
+    size_t frames_len = sample.depth * sizeof(profile_frame_t);
+    size_t h = qstr_compute_hash((const byte*)sample.frame, frames_len);
+    for (size_t i = 0; i < MICROPY_PY_MICROPYTHON_PROFILE_ENTRIES; i++) {
+        profile_entry_t *e = &profile_hist[(h + i) % MICROPY_PY_MICROPYTHON_PROFILE_ENTRIES];
+        if (e->count == 0) {
+            *e = sample;
+            e->count = n;
+            return;
+        }
+        if (e->depth == sample.depth && memcmp(e->frame, sample.frame, frames_len) == 0) {
+            e->count += n;
+            return;
+        }
+    }
+    profile_dropped += n;
+}
+
+void mp_profile_start(mp_uint_t hz) {
+    mp_hal_profile_timer(0);
+    memset(profile_hist, 0, sizeof(profile_hist));
+    profile_dropped = 0;
+    profile_taken = profile_ticks;
+    mp_hal_profile_timer(hz);
+}
+
+// Return a dict mapping each sampled stack, a tuple of (function, file, line)
+// tuples with the outermost call first, to the number of ticks counted for it.
+// The ticks of stacks that did not fit in the histogram are under None.
+mp_obj_t mp_profile_stop(void) {
+    mp_hal_profile_timer(0);
+    profile_taken = profile_ticks;
+
+    mp_obj_t dict = mp_obj_new_dict(0);
+    for (size_t i = 0; i < MICROPY_PY_MICROPYTHON_PROFILE_ENTRIES; i++) {
+        const profile_entry_t *e = &profile_hist[i];
+        if (e->count == 0) {
+            continue;
+        }
+        mp_obj_tuple_t *stack = MP_OBJ_TO_PTR(mp_obj_new_tuple(e->depth, NULL));
+        for (size_t j = 0; j < e->depth; j++) {
+            const profile_frame_t *f = &e->frame[e->depth - 1 - j];
+            mp_obj_t items[3] = {
+                MP_OBJ_NEW_QSTR(f->block),
+                MP_OBJ_NEW_QSTR(f->file),
+                MP_OBJ_NEW_SMALL_INT(f->line),
+            };
+            stack->items[j] = mp_obj_new_tuple(3, items);
+        }
+        mp_obj_dict_store(dict, MP_OBJ_FROM_PTR(stack), mp_obj_new_int_from_uint(e->count));
+    }
+    if (profile_dropped != 0) {
+        mp_obj_dict_store(dict, mp_const_none, mp_obj_new_int_from_uint(profile_dropped));
+    }
+    return dict;
+}
+
+#endif // MICROPY_PY_MICROPYTHON_PROFILE
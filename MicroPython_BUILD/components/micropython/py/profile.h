@@ -0,0 +1,49 @@
+/*
+ * This file is part of the MicroPython ESP32 project, https://github.com/loboris/MicroPython_ESP32_psRAM_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef MICROPY_INCLUDED_PY_PROFILE_H
+#define MICROPY_INCLUDED_PY_PROFILE_H
+
+#include "py/obj.h"
+
+#if MICROPY_PY_MICROPYTHON_PROFILE
+
+// Called by the port timer at the sampling rate, may be called from an ISR.
+void mp_profile_tick(void);
+
+// Record the ticks since the last sample against the running Python code;
+// called at the VM's pending check and from mp_handle_pending.
+void mp_profile_sample(void);
+
+void mp_profile_start(mp_uint_t hz);
+mp_obj_t mp_profile_stop(void);
+
+// Provided by the port: call mp_profile_tick() hz times per second, or stop
+// calling it if hz is 0.
+void mp_hal_profile_timer(mp_uint_t hz);
+
+#endif // MICROPY_PY_MICROPYTHON_PROFILE
+
+#endif // MICROPY_INCLUDED_PY_PROFILE_H
@@ -40,6 +40,7 @@
 #include "py/builtin.h"
 #include "py/stackctrl.h"
 #include "py/gc.h"
+#include "py/frozenmod.h"
 
 #if MICROPY_DEBUG_VERBOSE // print debugging info
 #define DEBUG_PRINT (1)
@@ -65,6 +66,10 @@ void mp_init(void) {
     MP_STATE_VM(sched_sp) = 0;
     #endif
 
+    #if MICROPY_CODE_STATE_CHAIN
+    MP_STATE_THREAD(current_code_state) = NULL;
+    #endif
+
 #if MICROPY_ENABLE_EMERGENCY_EXCEPTION_BUF
     mp_init_emergency_exception_buf();
 #endif
@@ -91,6 +96,16 @@ void mp_init(void) {
     // init global module dict
     mp_obj_dict_init(&MP_STATE_VM(mp_loaded_modules_dict), 3);
 
+    #if MICROPY_MODULE_IMPORT_CACHE
+    // import cache is disabled until a directory is set
+    MP_STATE_VM(import_cache_dir) = MP_OBJ_NULL;
+    #endif
+
+    #if MICROPY_MODULE_FROZEN_ROM
+    // frozen ROM modules lose their tables with the heap, they are set up again on import
+    memset(mp_frozen_rom_dicts, 0, mp_frozen_rom_dicts_len * sizeof(mp_obj_dict_t));
+    #endif
+
     // initialise the __main__ module
     mp_obj_dict_init(&MP_STATE_VM(dict_main), 1);
     mp_obj_dict_store(MP_OBJ_FROM_PTR(&MP_STATE_VM(dict_main)), MP_OBJ_NEW_QSTR(MP_QSTR___name__), MP_OBJ_NEW_QSTR(MP_QSTR___main__));
@@ -111,6 +126,10 @@ void mp_init(void) {
     MP_STATE_VM(dupterm_arr_obj) = MP_OBJ_NULL;
     #endif
 
+    #if MICROPY_PY_URE && MICROPY_PY_URE_CACHE_SIZE
+    memset(MP_STATE_VM(ure_cache), 0, sizeof(MP_STATE_VM(ure_cache)));
+    #endif
+
     #if MICROPY_FSUSERMOUNT
     // zero out the pointers to the user-mounted devices
     memset(MP_STATE_VM(fs_user_mount), 0, sizeof(MP_STATE_VM(fs_user_mount)));
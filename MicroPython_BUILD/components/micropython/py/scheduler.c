@@ -30,6 +30,7 @@
 
 #include "py/runtime.h"
 #include "py/objstr.h"
+#include "py/profile.h"
 
 #if MICROPY_ENABLE_SCHEDULER
 
@@ -44,6 +45,9 @@ static mp_obj_t cb_objects[MAX_CB_OBJECTS];
 // A variant of this is inlined in the VM at the pending exception check
 void mp_handle_pending(void) {
     if (MP_STATE_VM(sched_state) == MP_SCHED_PENDING) {
+        #if MICROPY_PY_MICROPYTHON_PROFILE
+        mp_profile_sample();
+        #endif
         mp_uint_t atomic_state = MICROPY_BEGIN_ATOMIC_SECTION();
         mp_obj_t obj = MP_STATE_VM(mp_pending_exception);
         if (obj != MP_OBJ_NULL) {
@@ -36,7 +36,9 @@
 #include "py/objtype.h"
 #include "py/runtime.h"
 #include "py/bc0.h"
+#include "py/smallint.h"
 #include "py/bc.h"
+#include "py/profile.h"
 
 #if 0 && MICROPY_DEBUG_PRINTERS
 #define TRACE(ip) printf("sp=%d ", (int)(sp - &code_state->state[0] + 1)); mp_bytecode_print2(ip, 1, code_state->fun_bc->const_table);
@@ -113,6 +115,35 @@
     exc_sp--; /* pop back to previous exception handler */ \
     CLEAR_SYS_EXC_INFO() /* just clear sys.exc_info(), not compliant, but it shouldn't be used in 1st place */
 
+// Fast path of the superinstructions which have a binary op with both operands
+// small ints.  Returns MP_OBJ_NULL if the op has to go through mp_binary_op.
+STATIC inline mp_obj_t vm_small_int_binary_op(mp_binary_op_t op, mp_int_t lhs, mp_int_t rhs) {
+    switch (op) {
+        case MP_BINARY_OP_LESS: return mp_obj_new_bool(lhs < rhs);
+        case MP_BINARY_OP_MORE: return mp_obj_new_bool(lhs > rhs);
+        case MP_BINARY_OP_EQUAL: return mp_obj_new_bool(lhs == rhs);
+        case MP_BINARY_OP_LESS_EQUAL: return mp_obj_new_bool(lhs <= rhs);
+        case MP_BINARY_OP_MORE_EQUAL: return mp_obj_new_bool(lhs >= rhs);
+        case MP_BINARY_OP_NOT_EQUAL: return mp_obj_new_bool(lhs != rhs);
+        case MP_BINARY_OP_OR:
+        case MP_BINARY_OP_INPLACE_OR: return MP_OBJ_NEW_SMALL_INT(lhs | rhs);
+        case MP_BINARY_OP_XOR:
+        case MP_BINARY_OP_INPLACE_XOR: return MP_OBJ_NEW_SMALL_INT(lhs ^ rhs);
+        case MP_BINARY_OP_AND:
+        case MP_BINARY_OP_INPLACE_AND: return MP_OBJ_NEW_SMALL_INT(lhs & rhs);
+        case MP_BINARY_OP_ADD:
+        case MP_BINARY_OP_INPLACE_ADD: lhs += rhs; break;
+        case MP_BINARY_OP_SUBTRACT:
+        case MP_BINARY_OP_INPLACE_SUBTRACT: lhs -= rhs; break;
+        default: return MP_OBJ_NULL;
+    }
+    // sum or difference of two small ints can't overflow mp_int_t
+    if (MP_SMALL_INT_FITS(lhs)) {
+        return MP_OBJ_NEW_SMALL_INT(lhs);
+    }
+    return MP_OBJ_NULL;
+}
+
 // fastn has items in reverse order (fastn[0] is local[0], fastn[-1] is local[1], etc)
 // sp points to bottom of stack which grows up
 // returns:
@@ -154,6 +185,20 @@ mp_vm_return_kind_t mp_execute_bytecode(mp_code_state_t *code_state, volatile mp
     // loop and the exception handler, leading to very obscure bugs.
     #define RAISE(o) do { nlr_pop(); nlr.ret_val = MP_OBJ_TO_PTR(o); goto exception_handler; } while (0)
 
+    #if MICROPY_CODE_STATE_CHAIN
+    // keep the chain of running code states for the profiler and allocation tracer
+    #define FRAME_ENTER(state) do { \
+        (state)->prev_state = MP_STATE_THREAD(current_code_state); \
+        MP_STATE_THREAD(current_code_state) = (state); \
+    } while (0)
+    #define FRAME_LEAVE() (MP_STATE_THREAD(current_code_state) = code_state->prev_state)
+    #else
+    #define FRAME_ENTER(state)
+    #define FRAME_LEAVE()
+    #endif
+
+    FRAME_ENTER(code_state);
+
 #if MICROPY_STACKLESS
 run_code_state: ;
 #endif
@@ -368,6 +413,37 @@ dispatch_loop:
                 }
                 #endif
 
+                ENTRY(MP_BC_LOAD_FAST_ATTR): {
+                    MARK_EXC_IP_SELECTIVE();
+                    DECODE_QSTR;
+                    obj_shared = fastn[-(mp_int_t)*ip++];
+                    if (obj_shared == MP_OBJ_NULL) {
+                        goto local_name_error;
+                    }
+                    PUSH(mp_load_attr(obj_shared, qst));
+                    DISPATCH();
+                }
+
+                ENTRY(MP_BC_LOAD_FAST_CONST_BINARY_OP): {
+                    MARK_EXC_IP_SELECTIVE();
+                    obj_shared = fastn[-(mp_int_t)ip[0]];
+                    mp_int_t rhs = (int8_t)ip[1];
+                    mp_binary_op_t op = ip[2];
+                    ip += 3;
+                    if (obj_shared == MP_OBJ_NULL) {
+                        goto local_name_error;
+                    }
+                    mp_obj_t res = MP_OBJ_NULL;
+                    if (MP_OBJ_IS_SMALL_INT(obj_shared)) {
+                        res = vm_small_int_binary_op(op, MP_OBJ_SMALL_INT_VALUE(obj_shared), rhs);
+                    }
+                    if (res == MP_OBJ_NULL) {
+                        res = mp_binary_op(op, obj_shared, MP_OBJ_NEW_SMALL_INT(rhs));
+                    }
+                    PUSH(res);
+                    DISPATCH();
+                }
+
                 ENTRY(MP_BC_LOAD_METHOD): {
                     MARK_EXC_IP_SELECTIVE();
                     DECODE_QSTR;
@@ -561,6 +637,27 @@ dispatch_loop:
                     DISPATCH_WITH_PEND_EXC_CHECK();
                 }
 
+                ENTRY(MP_BC_BINARY_OP_POP_JUMP_IF_TRUE):
+                ENTRY(MP_BC_BINARY_OP_POP_JUMP_IF_FALSE): {
+                    MARK_EXC_IP_SELECTIVE();
+                    bool jump_if = (ip[-1] == MP_BC_BINARY_OP_POP_JUMP_IF_TRUE);
+                    DECODE_SLABEL;
+                    mp_binary_op_t op = *ip++;
+                    mp_obj_t rhs = POP();
+                    mp_obj_t lhs = POP();
+                    mp_obj_t res = MP_OBJ_NULL;
+                    if (MP_OBJ_IS_SMALL_INT(lhs) && MP_OBJ_IS_SMALL_INT(rhs)) {
+                        res = vm_small_int_binary_op(op, MP_OBJ_SMALL_INT_VALUE(lhs), MP_OBJ_SMALL_INT_VALUE(rhs));
+                    }
+                    if (res == MP_OBJ_NULL) {
+                        res = mp_binary_op(op, lhs, rhs);
+                    }
+                    if (mp_obj_is_true(res) == jump_if) {
+                        ip += slab;
+                    }
+                    DISPATCH_WITH_PEND_EXC_CHECK();
+                }
+
                 ENTRY(MP_BC_JUMP_IF_TRUE_OR_POP): {
                     DECODE_SLABEL;
                     if (mp_obj_is_true(TOP())) {
@@ -929,6 +1026,7 @@ unwind_jump:;
                         #endif
                         {
                             new_state->prev = code_state;
+                            FRAME_ENTER(new_state);
                             code_state = new_state;
                             nlr_pop();
                             goto run_code_state;
@@ -974,6 +1072,7 @@ unwind_jump:;
                         #endif
                         {
                             new_state->prev = code_state;
+                            FRAME_ENTER(new_state);
                             code_state = new_state;
                             nlr_pop();
                             goto run_code_state;
@@ -1012,6 +1111,7 @@ unwind_jump:;
                         #endif
                         {
                             new_state->prev = code_state;
+                            FRAME_ENTER(new_state);
                             code_state = new_state;
                             nlr_pop();
                             goto run_code_state;
@@ -1057,6 +1157,7 @@ unwind_jump:;
                         #endif
                         {
                             new_state->prev = code_state;
+                            FRAME_ENTER(new_state);
                             code_state = new_state;
                             nlr_pop();
                             goto run_code_state;
@@ -1112,6 +1213,7 @@ unwind_return:
                         mp_obj_t res = *sp;
                         mp_globals_set(code_state->old_globals);
                         mp_code_state_t *new_code_state = code_state->prev;
+                        FRAME_LEAVE();
                         #if MICROPY_ENABLE_PYSTACK
                         // Free code_state, and args allocated by mp_call_prepare_args_n_kw_var
                         // (The latter is implicitly freed when using pystack due to its LIFO nature.)
@@ -1124,6 +1226,7 @@ unwind_return:
                         goto run_code_state;
                     }
                     #endif
+                    FRAME_LEAVE();
                     return MP_VM_RETURN_NORMAL;
 
                 ENTRY(MP_BC_RAISE_VARARGS): {
@@ -1161,6 +1264,7 @@ yield:
                     code_state->ip = ip;
                     code_state->sp = sp;
                     code_state->exc_sp = MP_TAGPTR_MAKE(exc_sp, currently_in_except_block);
+                    FRAME_LEAVE();
                     return MP_VM_RETURN_YIELD;
 
                 ENTRY(MP_BC_YIELD_FROM): {
@@ -1290,6 +1394,7 @@ yield:
                     mp_obj_t obj = mp_obj_new_exception_msg(&mp_type_NotImplementedError, "byte code not implemented");
                     nlr_pop();
                     fastn[0] = obj;
+                    FRAME_LEAVE();
                     return MP_VM_RETURN_EXCEPTION;
                 }
 
@@ -1304,6 +1409,9 @@ pending_exception_check:
                 // This is an inlined variant of mp_handle_pending
                 if (MP_STATE_VM(sched_state) == MP_SCHED_PENDING) {
                     MARK_EXC_IP_SELECTIVE();
+                    #if MICROPY_PY_MICROPYTHON_PROFILE
+                    mp_profile_sample();
+                    #endif
                     mp_uint_t atomic_state = MICROPY_BEGIN_ATOMIC_SECTION();
                     mp_obj_t obj = MP_STATE_VM(mp_pending_exception);
                     if (obj != MP_OBJ_NULL) {
@@ -1417,29 +1525,7 @@ unwind_loop:
                 qstr source_file = mp_decode_uint_value(ip);
                 ip = mp_decode_uint_skip(ip);
                 #endif
-                size_t source_line = 1;
-                size_t c;
-                while ((c = *ip)) {
-                    size_t b, l;
-                    if ((c & 0x80) == 0) {
-                        // 0b0LLBBBBB encoding
-                        b = c & 0x1f;
-                        l = c >> 5;
-                        ip += 1;
-                    } else {
-                        // 0b1LLLBBBB 0bLLLLLLLL encoding (l's LSB in second byte)
-                        b = c & 0xf;
-                        l = ((c << 4) & 0x700) | ip[1];
-                        ip += 2;
-                    }
-                    if (bc >= b) {
-                        bc -= b;
-                        source_line += l;
-                    } else {
-                        // found source line corresponding to bytecode offset
-                        break;
-                    }
-                }
+                size_t source_line = mp_bytecode_get_source_line(ip, bc);
                 mp_obj_exception_add_traceback(MP_OBJ_FROM_PTR(nlr.ret_val), source_file, source_line, block_name);
             }
 
@@ -1472,6 +1558,7 @@ unwind_loop:
             } else if (code_state->prev != NULL) {
                 mp_globals_set(code_state->old_globals);
                 mp_code_state_t *new_code_state = code_state->prev;
+                FRAME_LEAVE();
                 #if MICROPY_ENABLE_PYSTACK
                 // Free code_state, and args allocated by mp_call_prepare_args_n_kw_var
                 // (The latter is implicitly freed when using pystack due to its LIFO nature.)
@@ -1493,6 +1580,7 @@ unwind_loop:
                 // propagate exception to higher level
                 // TODO what to do about ip and sp? they don't really make sense at this point
                 fastn[0] = MP_OBJ_FROM_PTR(nlr.ret_val); // must put exception here because sp is invalid
+                FRAME_LEAVE();
                 return MP_VM_RETURN_EXCEPTION;
             }
         }
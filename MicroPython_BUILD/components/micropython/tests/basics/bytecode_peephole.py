@@ -0,0 +1,133 @@
+# Bytecode sequences rewritten by the peephole pass (MICROPY_OPT_BC_PEEPHOLE)
+# and the superinstructions, the output must not depend on the option.
+class P:
+    def __init__(self, x, y):
+        self.x = x
+        self.y = y
+def attrs(p, q):
+    return p.x + q.y, p.y - q.x
+print(attrs(P(1, 2), P(3, 4)))
+def arith(n):
+    r = []
+    for v in (n, -n, 2**40, 1073741823, -1073741824, 3.5, True):
+        r.append((v + 1, v - 1, v + 127, v - 128, v * 3, v // 7, v % 5, v < 3, v > -3, v == 1, v != 1, v <= 0, v >= 0))
+        if type(v) is not float: r.append((v & 15, v | 8, v ^ 3))
+    return r
+for t in arith(5):
+    print(t)
+for t in arith(2**35):
+    print(t)
+def strs(s):
+    return s + 'x', s * 2, s < 'm', s == 'abc'
+print(strs('abc'))
+def loop(n):
+    i = 0
+    total = 0
+    while i < n:
+        if i % 3 == 0:
+            total += i
+        elif i > 50:
+            pass
+        else:
+            total -= 1
+        i += 1
+    else:
+        total += 1000
+    return total
+print(loop(100))
+def cmpjump(a, b):
+    out = []
+    for x in range(-3, 4):
+        if x < a: out.append('lt')
+        if x > b: out.append('gt')
+        if x == a: out.append('eq')
+        if x != b: out.append('ne')
+        if not x <= a: out.append('nle')
+        if x >= b or x == 0: out.append('ge|0')
+        if x in (1, 2): out.append('in')
+        if x not in (1, 2): out.append('notin')
+        if x is None: out.append('none')
+        if x is not None: out.append('notnone')
+    while a < b:
+        a += 1
+    return out, a
+print(cmpjump(0, 2))
+print(cmpjump(0.5, 1.5))
+def unbound():
+    try:
+        y = z.x
+    except NameError as e:
+        print('NameError')
+    try:
+        y = w + 1
+    except NameError as e:
+        print('NameError')
+    z = P(1, 0)
+    w = 2
+    return z.x, w + 1
+print(unbound())
+def deadjumps(x):
+    if x:
+        r = 1
+    else:
+        pass
+    for i in range(3):
+        if i == 1:
+            continue
+        else:
+            pass
+    try:
+        r = r + 1
+    except:
+        pass
+    else:
+        pass
+    while x > 0:
+        x -= 1
+        if x == 2:
+            break
+    else:
+        r = -1
+    return r, x
+print(deadjumps(1), deadjumps(5))
+def gen(n):
+    i = 0
+    while i < n:
+        yield i + 1
+        i += 1
+print(list(gen(5)))
+def closure():
+    a = 5
+    def inner(b):
+        return a + 1 + b
+    return inner(3)
+print(closure())
+def many_locals():
+    a0=a1=a2=a3=a4=a5=a6=a7=a8=a9=a10=a11=a12=a13=a14=a15=a16=a17=a18=a19=1
+    a19 += 3
+    return a19 - 2, a18 < 5, a17 + 0
+print(many_locals())
+def exc_lines():
+    x = None
+    try:
+        return x.foo
+    except AttributeError as e:
+        return 'attr'
+print(exc_lines())
+try:
+    def bad(a):
+        return a + 1
+    bad('s')
+except TypeError as e:
+    print('TypeError')
+x = 10
+print(x + 1, x < 20)
+lst = [1, 2, 3]
+print(lst[0] + 1, len(lst) - 1)
+# jumps over more than 1 kB of bytecode
+src = 'def big_jump(n):\n    s = 0\n    while n < 100:\n'
+for k in range(200):
+    src += '        s += n * %d\n' % (k % 7)
+src += '        n += 1\n    return s\n'
+exec(src)
+print(big_jump(0))
@@ -0,0 +1,134 @@
+# deque ring buffer: rotate, extendleft, indexing, bounded deques dropping
+# items at the other end, growing while the ring wraps around the end of
+# the buffer, and random operations against a list
+try:
+    from collections import deque
+except ImportError:
+    from ucollections import deque
+
+# growing with a wrapped ring: the first buffer has 4 slots
+d = deque()
+d.extend((1, 2, 3, 4))
+d.popleft()
+d.popleft()
+d.append(5)
+d.append(6)
+d.append(7)
+print(list(d), d[0], d[-1], len(d))
+d = deque()
+d.extend((1, 2, 3))
+d.appendleft(0)
+d.appendleft(-1)
+print(list(d))
+for i in range(20):
+    d.appendleft(-2 - i)
+    d.append(4 + i)
+print(list(d) == list(range(-21, 24)))
+
+# the buffer of a bounded deque grows up to maxlen
+d = deque((), 6)
+d.extend((1, 2, 3, 4))
+d.popleft()
+d.append(5)
+d.append(6)
+d.append(7)
+d.append(8)
+print(list(d))
+
+# bounded overflow
+d = deque((), 3)
+for i in range(5):
+    d.append(i)
+print(list(d))
+d.appendleft(10)
+print(list(d))
+d.extend(range(20, 25))
+print(list(d))
+d.extendleft(range(30, 32))
+print(list(d))
+d = deque((1, 2), 0)
+d.append(3)
+d.appendleft(4)
+print(list(d), len(d))
+
+# extendleft reverses, extending with itself
+d = deque((1, 2))
+d.extendleft((3, 4, 5))
+print(list(d))
+d.extend(d)
+print(list(d))
+d.extendleft(d)
+print(list(d))
+
+# rotate a full ring and one with free slots, in both directions
+for maxlen in (5, None):
+    d = deque(range(5), maxlen)
+    for n in (1, 2, -1, -3, 5, 7, -12, 0):
+        d.rotate(n)
+        print(n, list(d))
+    d.rotate()
+    print(list(d))
+d = deque()
+d.rotate(3)
+d.append(1)
+d.rotate(-3)
+print(list(d))
+
+# indexing
+d = deque(range(10))
+d.rotate(3)
+d[0] = 'a'
+d[-1] = 'z'
+print(list(d), d[1], d[-2])
+for i in (10, -11):
+    try:
+        d[i]
+    except IndexError:
+        print('IndexError', i)
+
+# random operations against a list
+seed = 73
+def rnd(n):
+    global seed
+    seed = (seed * 1103515245 + 12345) & 0x7fffffff
+    return (seed >> 8) % n
+
+for maxlen in (None, 7):
+    d = deque((), maxlen)
+    l = []
+    ok = True
+    for i in range(3000):
+        op = rnd(8)
+        if op == 0:
+            d.append(i)
+            l.append(i)
+        elif op == 1:
+            d.appendleft(i)
+            l.insert(0, i)
+        elif op == 2 and l:
+            ok = ok and d.pop() == l.pop()
+        elif op == 3 and l:
+            ok = ok and d.popleft() == l.pop(0)
+        elif op == 4:
+            k = rnd(5)
+            d.extend(range(i, i + k))
+            l.extend(range(i, i + k))
+        elif op == 5:
+            k = rnd(5)
+            d.extendleft(range(i, i + k))
+            l[0:0] = list(range(i + k - 1, i - 1, -1))
+        elif op == 6 and l:
+            k = rnd(2 * len(l) + 1) - len(l)
+            d.rotate(k)
+            l = l[len(l) - k:] + l[:len(l) - k] if k >= 0 else l[-k:] + l[:-k]
+        elif op == 7 and l:
+            k = rnd(len(l))
+            ok = ok and d[k] == l[k] and d[-1 - k] == l[-1 - k]
+        if maxlen is not None and len(l) > maxlen:
+            # the bounded deque drops items at the end opposite to the added ones
+            if op in (1, 5):
+                l = l[:maxlen]
+            else:
+                l = l[len(l) - maxlen:]
+        ok = ok and len(d) == len(l)
+    print(maxlen, ok, list(d) == l)
@@ -0,0 +1,68 @@
+# typed deque: values stored in array storage, extend() from arrays of the
+# same typecode copies the values, the full flag, a wrapped ring growing
+try:
+    from ucollections import deque
+    import array
+    deque((), None, 0, typecode='h')
+except (ImportError, TypeError):
+    print("SKIP")
+    raise SystemExit
+
+d = deque((), None, 0, typecode='h')
+d.extend(array.array('h', (1, -2, 3)))
+d.extendleft(array.array('h', (4, 5)))
+print(d, len(d))
+# another typecode, each value is converted
+d.extend(array.array('b', (6, -7)))
+d.extend([8, 9])
+print(d)
+d = deque((), None, 0, typecode='B')
+d.extend(bytearray(b'abc'))
+d.extend(b'de')
+print(d)
+
+# a wrapped ring grows, from the array copy and from items
+d = deque((), None, 0, typecode='i')
+d.extend(array.array('i', (1, 2, 3, 4)))
+d.popleft()
+d.popleft()
+d.extend(array.array('i', (5, 6, 7, 8, 9)))
+print(list(d), d[0], d[-1])
+d.appendleft(0)
+d.rotate(2)
+print(list(d))
+
+# bounded, an array longer than maxlen keeps its last values
+d = deque((), 4, 0, typecode='f')
+d.extend(array.array('f', (0.5, 1.5, 2.5, 3.5, 4.5, 5.5)))
+print(d)
+d.extendleft(array.array('f', (10.0,)))
+d.rotate(-1)
+print(list(d))
+d = deque((), 3, 1, typecode='H')
+d.extend(array.array('H', (1, 2, 3)))
+try:
+    d.extend(array.array('H', (4,)))
+except IndexError:
+    print('IndexError')
+try:
+    d.appendleft(5)
+except IndexError:
+    print('IndexError')
+print(d)
+
+# a value of the wrong type leaves the deque unchanged
+d = deque((1, 2), None, 0, typecode='l')
+try:
+    d.append('x')
+except TypeError:
+    print('TypeError')
+print(d)
+d[1] = -5
+print(d.pop(), d.pop(), len(d))
+
+for tc in ('x', 'hh', 'O'):
+    try:
+        deque((), None, 0, typecode=tc)
+    except ValueError:
+        print('ValueError', tc)
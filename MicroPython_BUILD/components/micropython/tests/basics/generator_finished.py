@@ -0,0 +1,84 @@
+# send/throw/close of finished generators, whose frames have been given back
+# to the heap, and resuming a generator from its own code.
+# Unlike CPython, throw() into a finished generator raises StopIteration.
+import gc
+
+def gen():
+    yield 1
+    yield 2
+
+def gen_ret():
+    yield 1
+    return 'done'
+
+def gen_exc():
+    yield 1
+    raise KeyError('k')
+
+def after(g):
+    # the freed blocks are reused before g is used again
+    gc.collect()
+    l = [[i] * 8 for i in range(20)]
+    try:
+        g.send(None)
+    except StopIteration as e:
+        print('send StopIteration', e.args)
+    try:
+        next(g)
+    except StopIteration as e:
+        print('next StopIteration', e.args)
+    try:
+        g.throw(ValueError)
+    except StopIteration:
+        print('throw StopIteration')
+    except ValueError:
+        print('throw ValueError')
+    print('close', g.close(), g.close())
+    print(list(g), l[19][0])
+
+g = gen()
+print(list(g))
+after(g)
+
+g = gen_ret()
+print(next(g))
+try:
+    next(g)
+except StopIteration as e:
+    print('StopIteration', e.args)
+after(g)
+
+g = gen_exc()
+print(next(g))
+try:
+    next(g)
+except KeyError as e:
+    print('KeyError', e.args)
+after(g)
+
+# closed before it finished
+g = gen()
+print(next(g), g.close())
+after(g)
+
+# re-entering a running generator
+def reenter(how):
+    yield 1
+    try:
+        if how == 'next':
+            next(g)
+        elif how == 'send':
+            g.send(None)
+        elif how == 'throw':
+            g.throw(KeyError)
+        else:
+            g.close()
+    except ValueError as e:
+        print(how, 'ValueError', e)
+    yield 2
+    yield 3
+
+for how in ('next', 'send', 'throw', 'close'):
+    g = reenter(how)
+    print(list(g))
+after(g)
@@ -0,0 +1,34 @@
+# pend_throw() on finished generators, whose frames have been given back to
+# the heap, does nothing
+def gen():
+    yield 1
+
+g = gen()
+if not hasattr(g, 'pend_throw'):
+    print('SKIP')
+    raise SystemExit
+
+print(list(g))
+print(g.pend_throw(ValueError()))
+print(list(g), g.close())
+
+def gen_exc():
+    yield 1
+    raise KeyError
+
+g = gen_exc()
+next(g)
+g.pend_throw(OSError())
+try:
+    next(g)
+except OSError:
+    print('OSError')
+print(g.pend_throw(ValueError()), list(g))
+
+# a just-started generator still refuses it
+g = gen()
+try:
+    g.pend_throw(ValueError())
+except TypeError:
+    print('TypeError')
+print(list(g))
@@ -0,0 +1,82 @@
+# uheapq against CPython's heapq: random heappush/heappop/heapify/
+# heapreplace/heappushpop sequences, nsmallest/nlargest/merge with keys.
+# The items mix ints and floats with equal values and (priority, name) tuples
+# whose priorities are equal as int and float, where the fast path of heap_lt
+# must leave the decision to the names.
+try:
+    import uheapq as heapq
+except ImportError:
+    import heapq
+
+seed = 74
+def rnd(n):
+    global seed
+    seed = (seed * 1103515245 + 12345) & 0x7fffffff
+    return (seed >> 8) % n
+
+BIG = (2**24, 2.0**24, 2**24 - 1, 2**30, 2.0**30, -2**30, -2.0**30)
+
+def item(kind):
+    if kind == 0:
+        return rnd(20) - 10
+    if kind == 1:
+        v = rnd(10)
+        return v / 2 if rnd(2) else v
+    if kind == 2:
+        v = rnd(6)
+        return (v / 2 if rnd(2) else v, 'abcdefgh'[rnd(8)])
+    if kind == 3:
+        return BIG[rnd(len(BIG))]
+    return [rnd(4), rnd(4) + 0.5]
+
+# floats are shown with their type, 1 and 1.0 must come out where CPython puts them
+def canon(v):
+    if isinstance(v, float):
+        return 'f%d' % int(v * 2)
+    if isinstance(v, (tuple, list)):
+        return [canon(x) for x in v]
+    return v
+
+for kind in range(5):
+    h = []
+    out = []
+    for i in range(400):
+        op = rnd(6)
+        if op < 2 or not h:
+            heapq.heappush(h, item(kind))
+        elif op == 2:
+            out.append(heapq.heappop(h))
+        elif op == 3:
+            out.append(heapq.heapreplace(h, item(kind)))
+        elif op == 4:
+            out.append(heapq.heappushpop(h, item(kind)))
+        else:
+            h.append(item(kind))
+            heapq.heapify(h)
+    while h:
+        out.append(heapq.heappop(h))
+    print(kind, len(out), canon(out))
+
+for kind in range(5):
+    l = [item(kind) for i in range(60)]
+    for n in (0, 1, 5, 60, 100):
+        print(kind, n, canon(heapq.nsmallest(n, l)), canon(heapq.nlargest(n, l)))
+    key = lambda v: v[0] if isinstance(v, (tuple, list)) else -abs(v)
+    print(canon(heapq.nsmallest(7, l, key=key)), canon(heapq.nlargest(7, l, key=key)))
+    # sorted() of MicroPython is not stable, equal items are ordered by their repr
+    total = lambda v: (v, repr(v))
+    parts = [sorted(l[i::3], key=total) for i in range(3)]
+    print(canon(list(heapq.merge(*parts))))
+    parts = [sorted(l[i::4], key=total, reverse=True) for i in range(4)]
+    print(canon(list(heapq.merge(*parts, reverse=True))))
+
+# ints next to the floats they round to (2**24 + 1 with single precision
+# floats, 2**53 + 1 with double) are equal for MicroPython's '<', the fast
+# path must decide the same as '<' does
+ROUND = (2**24, 2**24 + 1, 2.0**24, 2**53, 2**53 + 1, 2.0**53, 1.5)
+ok = True
+for a in ROUND:
+    for b in ROUND:
+        for x, y in ((a, b), ((a, 'x'), (b, 'y')), ([a, 'y'], [b, 'x'])):
+            ok = ok and heapq.heappushpop([x], y) is (x if x < y else y)
+print(ok)
@@ -0,0 +1,29 @@
+# Common runner of the benchmarks: run(f, n) calls f(n) 'repeat' times and
+# prints the result and the best time.
+# Without a clock (a bare host VM build) only the result is printed, the
+# caller then times the whole script.
+
+try:
+    import utime
+    ticks_us, ticks_diff = utime.ticks_us, utime.ticks_diff
+except ImportError:
+    try:
+        import time
+        ticks_us = lambda: int(time.perf_counter() * 1000000)
+        ticks_diff = lambda a, b: a - b
+    except ImportError:
+        ticks_us = None
+
+
+def run(f, n, repeat=5):
+    if ticks_us is None:
+        print(f(n))
+        return
+    best = None
+    for i in range(repeat):
+        t = ticks_us()
+        res = f(n)
+        t = ticks_diff(ticks_us(), t)
+        if best is None or t < best:
+            best = t
+    print(res, '%d us' % best)
@@ -0,0 +1,99 @@
+# Bytecode benchmark, sensor filtering loops: fixed point IIR, moving average,
+# median-of-3, threshold detection, calibration object
+import bench
+
+def gen(n):
+    x = 12345
+    out = []
+    i = 0
+    while i < n:
+        x = (x * 1103 + 12345) & 0xffff
+        out.append((x >> 4) - 2048)
+        i += 1
+    return out
+
+def iir(samples):
+    y = 0
+    for s in samples:
+        y = y + ((s - y) >> 3)
+    return y
+
+def moving_avg(samples, w):
+    acc = 0
+    n = len(samples)
+    out = [0] * n
+    i = 0
+    while i < n:
+        acc += samples[i]
+        if i >= w:
+            acc -= samples[i - w]
+        out[i] = acc // w
+        i += 1
+    return out
+
+def median3(samples):
+    out = []
+    prev2 = 0
+    prev1 = 0
+    for s in samples:
+        if prev1 < s:
+            if s < prev2:
+                m = s
+            elif prev1 < prev2:
+                m = prev2
+            else:
+                m = prev1
+        else:
+            if prev1 < prev2:
+                m = prev1
+            elif s < prev2:
+                m = prev2
+            else:
+                m = s
+        out.append(m)
+        prev2 = prev1
+        prev1 = s
+    return out
+
+def crossings(samples, lo, hi):
+    state = 0
+    count = 0
+    for s in samples:
+        if state == 0 and s > hi:
+            state = 1
+            count += 1
+        elif state == 1 and s < lo:
+            state = 0
+    return count
+
+class Sensor:
+    def __init__(self):
+        self.offset = 17
+        self.scale = 3
+        self.last = 0
+    def read(self, raw):
+        v = (raw - self.offset) * self.scale
+        self.last = v
+        return v
+
+def calibrate(samples):
+    s = Sensor()
+    tot = 0
+    for r in samples:
+        tot += s.read(r) - s.last + s.offset
+    return tot
+
+def main(n):
+    data = gen(n)
+    r = 0
+    k = 0
+    while k < 5:
+        r += iir(data)
+        r += sum(moving_avg(data, 8)) & 0xff
+        r += sum(median3(data)) & 0xff
+        r += crossings(data, -500, 500)
+        r += calibrate(data) & 0xff
+        k += 1
+    return r
+
+bench.run(main, 4000)
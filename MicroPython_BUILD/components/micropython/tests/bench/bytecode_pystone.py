@@ -0,0 +1,67 @@
+# Bytecode benchmark, pystone-like: records, attribute access, integer loops
+# and branches
+import bench
+
+class Record:
+    def __init__(self, ptr=None, discr=0, enum=0, intc=0, strc=''):
+        self.ptr = ptr
+        self.discr = discr
+        self.enum = enum
+        self.intc = intc
+        self.strc = strc
+    def copy(self):
+        return Record(self.ptr, self.discr, self.enum, self.intc, self.strc)
+
+def proc7(a, b):
+    return a + 2 + b
+
+def proc3(rec, glob):
+    if rec.ptr is not None:
+        rec.ptr.intc = glob.intc
+    rec.intc = proc7(10, glob.intc)
+    return rec
+
+def func1(c1, c2):
+    if c1 != c2:
+        return 0
+    return 1
+
+def proc1(p, glob):
+    n = p.ptr
+    n.intc = p.intc
+    n.intc = 5
+    n = proc3(n, glob)
+    if n.discr == 0:
+        n.intc = 6
+        n.enum = p.enum
+        n.intc = proc7(n.intc, 10)
+    else:
+        p.intc = n.intc + 1
+    return p
+
+def main(loops):
+    glob = Record(None, 0, 2, 40, 'DHRYSTONE')
+    p = Record(glob, 0, 2, 40, 'SOME STRING')
+    arr = [0] * 51
+    total = 0
+    i = 0
+    while i < loops:
+        a = 2
+        b = 3
+        c = 0
+        if func1(a, b) == 0:
+            c = a * b
+        j = 0
+        while j < 3:
+            a = a + 1
+            j += 1
+        arr[8] = a
+        arr[i % 51] = b + 7
+        p = proc1(p, glob)
+        total += p.intc + c - b
+        if total > 1000000:
+            total -= 1000000
+        i += 1
+    return total
+
+bench.run(main, 20000)
@@ -0,0 +1,73 @@
+# deque benchmark, queue workloads: a FIFO against a list with pop(0), a
+# bounded sliding window of samples, typed storage filled from arrays, and
+# a round robin with rotate()
+import bench
+try:
+    from ucollections import deque
+except ImportError:
+    from collections import deque
+try:
+    import array
+except ImportError:
+    array = None
+
+QLEN = 1000
+
+def fifo_deque(n):
+    q = deque()
+    for i in range(QLEN):
+        q.append(i)
+    s = 0
+    for i in range(n):
+        q.append(i)
+        s += q.popleft()
+    return s
+
+def fifo_list(n):
+    q = list(range(QLEN))
+    s = 0
+    for i in range(n):
+        q.append(i)
+        s += q.pop(0)
+    return s
+
+def window(n):
+    # moving average over the last 64 samples
+    w = deque((), 64)
+    s = 0
+    for i in range(n):
+        if len(w) == 64:
+            s -= w[0]
+        w.append(i & 0xff)
+        s += i & 0xff
+    return s
+
+def typed(n):
+    # blocks of ADC samples stored without an object per value
+    try:
+        q = deque((), 4096, 0, typecode='h')
+    except TypeError:
+        q = deque((), 4096)
+    block = array.array('h', range(256))
+    s = 0
+    for i in range(n // 256):
+        q.extend(block)
+        while len(q) > 1024:
+            s += q.popleft()
+    return s
+
+def round_robin(n):
+    q = deque(range(16))
+    s = 0
+    for i in range(n):
+        s += q[0]
+        q.rotate(-1)
+    return s
+
+N = 20000
+bench.run(fifo_deque, N)
+bench.run(fifo_list, N)
+bench.run(window, N)
+if array:
+    bench.run(typed, N * 4)
+bench.run(round_robin, N)
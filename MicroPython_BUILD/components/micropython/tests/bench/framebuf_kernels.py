@@ -0,0 +1,86 @@
+# FrameBuffer benchmark, the drawing kernels of each format on a 128x64
+# buffer: fill_rect, hline, line, text, scroll by pixels and by whole bytes,
+# filled ellipse and poly, blit with a colour key
+import bench
+import framebuf
+
+W, H = 128, 64
+FORMATS = (
+    ('MONO_VLSB', framebuf.MONO_VLSB),
+    ('MONO_HLSB', framebuf.MONO_HLSB),
+    ('GS2_HMSB', framebuf.GS2_HMSB),
+    ('GS4_HMSB', framebuf.GS4_HMSB),
+    ('GS8', framebuf.GS8),
+    ('RGB565', framebuf.RGB565),
+    ('RGB888', getattr(framebuf, 'RGB888', None)),
+)
+STAR = bytearray((10, 0, 13, 7, 20, 7, 14, 12, 16, 19, 10, 15, 4, 19, 6, 12, 0, 7, 7, 7))
+
+def fill_rect(fb, n):
+    for i in range(n):
+        fb.fill_rect(i & 31, i & 15, 90, 40, i & 1)
+    return n
+
+def hline(fb, n):
+    for i in range(n):
+        fb.hline(i & 7, i & 63, 120, i & 1)
+    return n
+
+def line(fb, n):
+    for i in range(n):
+        fb.line(0, i & 63, W - 1, 63 - (i & 63), i & 1)
+        fb.line(i & 127, 0, 127 - (i & 127), H - 1, i & 1)
+    return n
+
+def text(fb, n):
+    for i in range(n):
+        fb.text('Hello World!', i & 7, i & 31, i & 1)
+    return n
+
+def scroll(fb, n):
+    for i in range(n):
+        fb.scroll(1, 1)
+        fb.scroll(-1, -1)
+    return n
+
+def scroll_bytes(fb, n):
+    for i in range(n):
+        fb.scroll(8, 8)
+        fb.scroll(-8, -8)
+    return n
+
+def ellipse(fb, n):
+    for i in range(n):
+        fb.ellipse(64, 32, 40 + (i & 15), 24, i & 1, True)
+    return n
+
+def poly(fb, n):
+    for i in range(n):
+        fb.poly(i & 63, i & 31, STAR, i & 1, True)
+    return n
+
+def blit(fb, n):
+    for i in range(n):
+        fb.blit(spr, i & 63, i & 31, 0)
+    return n
+
+# the name, the FrameBuffer method and the number of the calls
+KERNELS = (
+    ('fill_rect', 'fill_rect', fill_rect, 200), ('hline', 'hline', hline, 2000),
+    ('line', 'line', line, 200), ('text', 'text', text, 200),
+    ('scroll', 'scroll', scroll, 20), ('scroll_bytes', 'scroll', scroll_bytes, 20),
+    ('ellipse', 'ellipse', ellipse, 100), ('poly', 'poly', poly, 100),
+    ('blit', 'blit', blit, 100),
+)
+
+for name, fmt in FORMATS:
+    if fmt is None:
+        continue
+    fb = framebuf.FrameBuffer(bytearray(W * H * 3), W, H, fmt)
+    spr = framebuf.FrameBuffer(bytearray(32 * 32 * 3), 32, 32, fmt)
+    spr.fill_rect(4, 4, 24, 24, 1)
+    for kname, method, kernel, n in KERNELS:
+        if not hasattr(fb, method):
+            continue
+        print(name, kname, end=' ')
+        bench.run(lambda n: kernel(fb, n), n)
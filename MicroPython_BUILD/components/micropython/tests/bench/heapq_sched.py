@@ -0,0 +1,76 @@
+# uheapq benchmark, job scheduler workloads: a priority queue of
+# (priority, id, job) tuples with int and float priorities, heapreplace of
+# the running job, nsmallest/nlargest against sorted() and merge of sorted
+# streams against sorting their concatenation
+import bench
+try:
+    import uheapq as heapq
+except ImportError:
+    import heapq
+
+N = 5000
+
+def prios(n, scale):
+    p = []
+    seed = 1
+    for i in range(n):
+        seed = (seed * 1103515245 + 12345) & 0x7fffffff
+        p.append((seed >> 16) * scale)
+    return p
+
+P_INT = prios(N, 1)
+P_FLOAT = prios(N, 0.25)
+
+def queue(p):
+    def f(n):
+        h = []
+        for i in range(n):
+            heapq.heappush(h, (p[i], i, None))
+        s = 0
+        while h:
+            s += heapq.heappop(h)[1]
+        return s
+    return f
+
+def replace(n):
+    h = [(P_INT[i], i, None) for i in range(64)]
+    heapq.heapify(h)
+    s = 0
+    for i in range(n):
+        s += heapq.heapreplace(h, (h[0][0] + P_INT[i] % 100, i, None))[1]
+    return s
+
+def nbest(n):
+    l = P_INT[:n]
+    a = heapq.nsmallest(10, l)
+    b = heapq.nlargest(10, l, key=lambda v: -v)
+    return a == b
+
+def nbest_sorted(n):
+    l = P_INT[:n]
+    return sorted(l)[:10] == sorted(l, key=lambda v: -v, reverse=True)[:10]
+
+PARTS = [sorted(P_INT[i::8]) for i in range(8)]
+
+def merge(n):
+    s = 0
+    for v in heapq.merge(*PARTS):
+        s += v
+    return s
+
+def merge_sorted(n):
+    l = []
+    for p in PARTS:
+        l.extend(p)
+    s = 0
+    for v in sorted(l):
+        s += v
+    return s
+
+bench.run(queue(P_INT), N)
+bench.run(queue(P_FLOAT), N)
+bench.run(replace, N)
+bench.run(nbest, N)
+bench.run(nbest_sorted, N)
+bench.run(merge, N)
+bench.run(merge_sorted, N)
@@ -0,0 +1,79 @@
+# uitertools benchmark, a streaming sensor pipeline: samples are averaged in
+# blocks of 16, the running total and the runs above a threshold are
+# counted, once with the native iterators and once with the same stages
+# written as Python generators
+import bench
+try:
+    import uitertools as it
+except ImportError:
+    import itertools as it
+
+def samples():
+    seed = 1
+    while True:
+        seed = (seed * 1103515245 + 12345) & 0x7fffffff
+        yield (seed >> 16) & 0x3ff
+
+def native(n):
+    blocks = it.batched(it.islice(samples(), n), 16)
+    avgs = it.accumulate(sum(b) >> 4 for b in blocks)
+    runs = 0
+    total = 0
+    for high, g in it.groupby(avgs, lambda v: (v >> 9) & 1):
+        for v in g:
+            total = v
+        runs += high
+    return total, runs
+
+def py_islice(src, n):
+    for v in src:
+        if n == 0:
+            return
+        n -= 1
+        yield v
+
+def py_batched(src, n):
+    b = []
+    for v in src:
+        b.append(v)
+        if len(b) == n:
+            yield tuple(b)
+            b = []
+    if b:
+        yield tuple(b)
+
+def py_accumulate(src):
+    total = 0
+    for v in src:
+        total += v
+        yield total
+
+def py_groupby(src, key):
+    # the groups are lists, the native groupby() doesn't build them
+    group = []
+    k = None
+    for v in src:
+        kv = key(v)
+        if group and kv != k:
+            yield k, group
+            group = []
+        k = kv
+        group.append(v)
+    if group:
+        yield k, group
+
+def generators(n):
+    blocks = py_batched(py_islice(samples(), n), 16)
+    avgs = py_accumulate(sum(b) >> 4 for b in blocks)
+    runs = 0
+    total = 0
+    for high, g in py_groupby(avgs, lambda v: (v >> 9) & 1):
+        for v in g:
+            total = v
+        runs += high
+    return total, runs
+
+N = 32000
+if hasattr(it, 'batched'):
+    bench.run(native, N)
+bench.run(generators, N)
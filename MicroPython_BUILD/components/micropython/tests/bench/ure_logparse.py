@@ -0,0 +1,79 @@
+# ure benchmark, log parsing: module-level calls with cached patterns,
+# compiled patterns, sub() with a template and a function, finditer()
+import bench
+try:
+    import ure
+except ImportError:
+    import re as ure
+
+# the Pike VM matcher, when it is built in
+PIKEVM = getattr(ure, 'PIKEVM', 0)
+
+def gen(n):
+    lines = []
+    i = 0
+    while i < n:
+        lines.append('2018-05-%02d 12:%02d:%02d INFO [wifi] connected to ap%d rssi=-%d' % (i % 28 + 1, i % 60, i % 60, i, 40 + i % 30))
+        lines.append('2018-05-%02d 12:%02d:%02d ERROR [http] request /api/v%d failed code=%d' % (i % 28 + 1, i % 60, i % 60, i % 3, 500 + i % 4))
+        i += 1
+    return lines
+
+def parse_module(lines):
+    # the module functions compile each pattern once, it is then cached
+    n = 0
+    for l in lines:
+        if ure.search('ERROR|WARN', l):
+            n += 1
+        m = ure.search(r'code=(\d+)', l)
+        if m:
+            n += int(m.group(1))
+        m = ure.match(r'(\d+)-(\d+)-(\d+) ', l)
+        if m:
+            n += int(m.group(3))
+    return n
+
+def parse_compiled(lines, flags):
+    r1 = ure.compile('ERROR|WARN', flags)
+    r2 = ure.compile(r'code=(\d+)', flags)
+    r3 = ure.compile(r'(\d+)-(\d+)-(\d+) ', flags)
+    n = 0
+    for l in lines:
+        if r1.search(l):
+            n += 1
+        m = r2.search(l)
+        if m:
+            n += int(m.group(1))
+        m = r3.match(l)
+        if m:
+            n += int(m.group(3))
+    return n
+
+def rewrite(lines):
+    r = ure.compile(r'(\d+)-(\d+)-(\d+)')
+    n = 0
+    for l in lines:
+        l = r.sub(r'\3.\2.\1', l)
+        l = ure.sub(r'rssi=-(\d+)', lambda m: 'q=%d' % (100 - int(m.group(1))), l)
+        n += len(l)
+    return n
+
+def fields(lines):
+    n = 0
+    for l in lines:
+        for m in ure.finditer(r'[a-z]+=(\w+)', l):
+            n += len(m.group(1))
+    return n
+
+def main(n):
+    lines = gen(n)
+    r = parse_module(lines)
+    r += parse_compiled(lines, 0)
+    if PIKEVM:
+        r += parse_compiled(lines, PIKEVM)
+    else:
+        r += parse_compiled(lines, 0)
+    r += rewrite(lines)
+    r += fields(lines)
+    return r
+
+bench.run(main, 200)
@@ -0,0 +1,57 @@
+# utimeq benchmark with 10K entries: fill and drain the queue, a scheduler
+# loop which pops one entry and pushes its next run, cancelling a third of
+# the entries by their handles
+import bench
+from utimeq import utimeq
+
+N = 10000
+
+def times(n):
+    t = []
+    seed = 1
+    for i in range(n):
+        seed = (seed * 1103515245 + 12345) & 0x7fffffff
+        t.append(seed >> 12)
+    return t
+
+T = times(N)
+
+def fill_drain(n):
+    q = utimeq(16)
+    for i in range(n):
+        q.push(T[i], i, None)
+    res = [0, 0, 0]
+    s = 0
+    while q:
+        q.pop(res)
+        s += res[1]
+    return s
+
+def schedule(n):
+    q = utimeq(n)
+    for i in range(n):
+        q.push(T[i], i, None)
+    res = [0, 0, 0]
+    s = 0
+    for i in range(n):
+        q.pop(res)
+        s += res[1]
+        q.push(res[0] + T[i] % 1000, res[1], None)
+    return s + len(q)
+
+def cancel(n):
+    q = utimeq(n)
+    h = []
+    for i in range(n):
+        h.append(q.push(T[i], i, None))
+    c = 0
+    for i in range(0, n, 3):
+        c += q.cancel(h[i])
+    res = [0, 0, 0]
+    while q:
+        q.pop(res)
+    return c
+
+bench.run(fill_drain, N)
+bench.run(schedule, N)
+bench.run(cancel, N)
@@ -0,0 +1,270 @@
+# FrameBuffer drawing kernels of all formats, pixel for pixel.
+# The hashes of fill/fill_rect/hline/vline/rect/line/text/scroll/blit in the
+# .exp file were recorded with the per-pixel modframebuf.c which the format
+# specialised kernels replaced. RGB888 has no recorded hashes, it is drawn
+# with the random sequence of RGB565 and 16-bit colours, so its hashes must
+# be the RGB565 ones. ellipse() and poly() are compared with the per-pixel
+# reference below.
+try:
+    import framebuf
+except ImportError:
+    print("SKIP")
+    raise SystemExit
+
+FORMATS = (
+    ('MONO_VLSB', framebuf.MONO_VLSB),
+    ('MONO_HLSB', framebuf.MONO_HLSB),
+    ('MONO_HMSB', framebuf.MONO_HMSB),
+    ('GS2_HMSB', framebuf.GS2_HMSB),
+    ('GS4_HMSB', framebuf.GS4_HMSB),
+    ('GS8', framebuf.GS8),
+    ('RGB565', framebuf.RGB565),
+    ('RGB888', getattr(framebuf, 'RGB888', None)),
+)
+
+seed = 1
+
+def rnd(n):
+    global seed
+    seed = (seed * 1103515245 + 12345) & 0x7fffffff
+    return (seed >> 8) % n
+
+def colour():
+    return rnd(2) if rnd(4) else rnd(0x10000)
+
+def new_fb(fmt, w, h, random=True):
+    fb = framebuf.FrameBuffer(bytearray((w + 8) * (h + 8) * 3), w, h, fmt)
+    if random:
+        for y in range(h):
+            for x in range(w):
+                fb.pixel(x, y, colour())
+    return fb
+
+def fb_hash(fb, w, h, hsh):
+    for y in range(h):
+        for x in range(w):
+            hsh = ((hsh * 31) ^ fb.pixel(x, y)) & 0x3fffffff
+    return hsh
+
+TEXT = 'Hello, World! ~{|}\x7f\x01'
+
+def op_fill(fb, w, h, fmt):
+    fb.fill(colour())
+
+def op_fill_rect(fb, w, h, fmt):
+    fb.fill_rect(rnd(w + 20) - 10, rnd(h + 20) - 10, rnd(50) - 5, rnd(50) - 5, colour())
+
+def op_hline(fb, w, h, fmt):
+    fb.hline(rnd(w + 20) - 10, rnd(h + 20) - 10, rnd(60), colour())
+
+def op_vline(fb, w, h, fmt):
+    fb.vline(rnd(w + 20) - 10, rnd(h + 20) - 10, rnd(60), colour())
+
+def op_rect(fb, w, h, fmt):
+    fb.rect(rnd(w + 20) - 10, rnd(h + 20) - 10, rnd(50), rnd(50), colour())
+
+def op_line(fb, w, h, fmt):
+    x1, y1 = rnd(w + 20) - 10, rnd(h + 20) - 10
+    x2, y2 = rnd(w + 20) - 10, rnd(h + 20) - 10
+    if rnd(4) == 0:
+        y2 = y1
+    if rnd(4) == 0:
+        x2 = x1
+    fb.line(x1, y1, x2, y2, colour())
+
+def op_text(fb, w, h, fmt):
+    fb.text(TEXT[rnd(len(TEXT)):], rnd(w + 20) - 30, rnd(h + 20) - 10, colour())
+
+def op_scroll(fb, w, h, fmt):
+    xs, ys = rnd(2 * w - 1) - (w - 1), rnd(2 * h - 1) - (h - 1)
+    # the steps of whole bytes and bands have their own paths, the
+    # per-pixel scroll needs the steps within the size
+    if rnd(3) == 0:
+        xs = xs - xs % 8 if xs >= 0 else -(-xs - -xs % 8)
+    if rnd(3) == 0:
+        ys = ys - ys % 8 if ys >= 0 else -(-ys - -ys % 8)
+    if rnd(4) == 0:
+        xs = 0
+    if rnd(4) == 0:
+        ys = 0
+    fb.scroll(xs, ys)
+
+def op_blit(fb, w, h, fmt):
+    sw, sh = 1 + rnd(30), 1 + rnd(30)
+    src = new_fb(fmt, sw, sh)
+    key = -1 if rnd(2) else colour()
+    fb.blit(src, rnd(w + 20) - 15, rnd(h + 20) - 15, key)
+
+def op_blit_format(fb, w, h, fmt):
+    # the raw pixel values are copied between the formats
+    sw, sh = 1 + rnd(30), 1 + rnd(30)
+    src = new_fb(FORMATS[rnd(7)][1], sw, sh)
+    key = -1 if rnd(2) else colour()
+    fb.blit(src, rnd(w + 20) - 15, rnd(h + 20) - 15, key)
+
+OPS = (
+    ('fill', op_fill), ('fill_rect', op_fill_rect), ('hline', op_hline),
+    ('vline', op_vline), ('rect', op_rect), ('line', op_line), ('text', op_text),
+    ('scroll', op_scroll), ('blit', op_blit), ('blit_format', op_blit_format),
+)
+
+N = 100
+for name, fmt in FORMATS:
+    if fmt is None:
+        continue
+    for oi, (op_name, op) in enumerate(OPS):
+        seed = oi + 1
+        hsh = 0
+        for i in range(N):
+            w, h = 1 + rnd(24), 1 + rnd(24)
+            fb = new_fb(fmt, w, h)
+            op(fb, w, h, fmt)
+            hsh = fb_hash(fb, w, h, hsh)
+        print(name, op_name, hsh)
+
+if not hasattr(framebuf.FrameBuffer, 'ellipse'):
+    raise SystemExit
+
+# per-pixel references of ellipse and poly, the outline of poly is the
+# line of the per-pixel modframebuf.c
+
+def ref_pixel(fb, w, h, x, y, c):
+    if 0 <= x < w and 0 <= y < h:
+        fb.pixel(x, y, c)
+
+def ref_span(fb, w, h, x1, x2, y, c):
+    for x in range(x1, x2 + 1):
+        ref_pixel(fb, w, h, x, y, c)
+
+def ref_ellipse_points(fb, w, h, cx, cy, x, y, c, f, m):
+    quads = ((1, x, -y), (2, -x, -y), (4, -x, y), (8, x, y))
+    for q, dx, dy in quads:
+        if m & q:
+            if f:
+                ref_span(fb, w, h, min(cx, cx + dx), max(cx, cx + dx), cy + dy, c)
+            else:
+                ref_pixel(fb, w, h, cx + dx, cy + dy, c)
+
+def ref_ellipse(fb, w, h, cx, cy, xr, yr, c, f, m):
+    if xr < 0 or yr < 0:
+        return
+    if xr == 0 and yr == 0:
+        ref_ellipse_points(fb, w, h, cx, cy, 0, 0, c, f, m)
+        return
+    a2, b2 = 2 * xr * xr, 2 * yr * yr
+    x, y = xr, 0
+    xch, ych, err = yr * yr * (1 - 2 * xr), xr * xr, 0
+    sx, sy = b2 * xr, 0
+    while sx >= sy:
+        ref_ellipse_points(fb, w, h, cx, cy, x, y, c, f, m)
+        y += 1
+        sy += a2
+        err += ych
+        ych += a2
+        if 2 * err + xch > 0:
+            x -= 1
+            sx -= b2
+            err += xch
+            xch += b2
+    x, y = 0, yr
+    xch, ych, err = yr * yr, xr * xr * (1 - 2 * yr), 0
+    sx, sy = 0, a2 * yr
+    while sx <= sy:
+        ref_ellipse_points(fb, w, h, cx, cy, x, y, c, f, m)
+        x += 1
+        sx += b2
+        err += xch
+        xch += b2
+        if 2 * err + ych > 0:
+            y -= 1
+            sy -= a2
+            err += ych
+            ych += a2
+
+def ref_line(fb, w, h, x1, y1, x2, y2, c):
+    dx, sx = (x2 - x1, 1) if x2 > x1 else (x1 - x2, -1)
+    dy, sy = (y2 - y1, 1) if y2 > y1 else (y1 - y2, -1)
+    steep = dy > dx
+    if steep:
+        x1, y1, dx, dy, sx, sy = y1, x1, dy, dx, sy, sx
+    e = 2 * dy - dx
+    for i in range(dx):
+        if steep:
+            ref_pixel(fb, w, h, y1, x1, c)
+        else:
+            ref_pixel(fb, w, h, x1, y1, c)
+        while e >= 0:
+            y1 += sy
+            e -= 2 * dx
+        x1 += sx
+        e += 2 * dy
+    ref_pixel(fb, w, h, x2, y2, c)
+
+def ref_poly(fb, w, h, x, y, coords, c, f):
+    n = len(coords) // 2
+    pts = [(x + coords[2 * i], y + coords[2 * i + 1]) for i in range(n)]
+    if n == 0:
+        return
+    if f:
+        for row in range(max(0, min(p[1] for p in pts)), min(h - 1, max(p[1] for p in pts)) + 1):
+            nodes = []
+            for i in range(n):
+                (x1, y1), (x2, y2) = pts[i], pts[(i + 1) % n]
+                if y1 > y2:
+                    x1, y1, x2, y2 = x2, y2, x1, y1
+                if y1 <= row < y2:
+                    # nearest x, rounded up at .5
+                    nodes.append(x1 + (2 * (x2 - x1) * (row - y1) + (y2 - y1)) // (2 * (y2 - y1)))
+            nodes.sort()
+            for i in range(0, len(nodes) - 1, 2):
+                ref_span(fb, w, h, nodes[i], nodes[i + 1], row, c)
+    for i in range(n):
+        (x1, y1), (x2, y2) = pts[i], pts[(i + 1) % n]
+        ref_line(fb, w, h, x1, y1, x2, y2, c)
+
+def same(a, b, w, h):
+    for y in range(h):
+        for x in range(w):
+            if a.pixel(x, y) != b.pixel(x, y):
+                return False
+    return True
+
+def copy(fmt, fb, w, h):
+    c = new_fb(fmt, w, h, False)
+    c.blit(fb, 0, 0)
+    return c
+
+for name, fmt in FORMATS:
+    seed = 100
+    ok_ellipse = ok_poly = ok_rect = True
+    for i in range(N):
+        w, h = 1 + rnd(30), 1 + rnd(30)
+        fb = new_fb(fmt, w, h)
+        ref = copy(fmt, fb, w, h)
+        cx, cy = rnd(w + 20) - 10, rnd(h + 20) - 10
+        xr, yr = rnd(20) - 1, rnd(20) - 1
+        c, f, m = colour(), rnd(2), rnd(16)
+        if rnd(3):
+            fb.ellipse(cx, cy, xr, yr, c, f, m)
+        else:
+            m = 15
+            fb.ellipse(cx, cy, xr, yr, c, f)
+        ref_ellipse(ref, w, h, cx, cy, xr, yr, c, f, m)
+        ok_ellipse = ok_ellipse and same(fb, ref, w, h)
+
+        fb = new_fb(fmt, w, h)
+        ref = copy(fmt, fb, w, h)
+        coords = [rnd(50) - 25 for j in range(2 * rnd(7))]
+        x, y, c, f = rnd(w + 10) - 5, rnd(h + 10) - 5, colour(), rnd(2)
+        fb.poly(x, y, coords, c, f)
+        ref_poly(ref, w, h, x, y, coords, c, f)
+        ok_poly = ok_poly and same(fb, ref, w, h)
+
+        # a filled rectangle polygon is fill_rect
+        fb = new_fb(fmt, w, h)
+        ref = copy(fmt, fb, w, h)
+        x, y, rw, rh = rnd(w + 10) - 5, rnd(h + 10) - 5, 1 + rnd(20), 1 + rnd(20)
+        fb.poly(x, y, bytearray((0, 0, rw - 1, 0, rw - 1, rh - 1, 0, rh - 1)), c, True)
+        ref.fill_rect(x, y, rw, rh, c)
+        ok_rect = ok_rect and same(fb, ref, w, h)
+    print(name, 'ellipse', ok_ellipse, 'poly', ok_poly, 'rect', ok_rect)
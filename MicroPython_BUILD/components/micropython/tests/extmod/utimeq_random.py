@@ -0,0 +1,83 @@
+# utimeq against a sorted list model: random push/pop/cancel sequences,
+# entries with equal times come out in push order (in reverse push order
+# when the queue is descending), cancel() of a popped or cancelled entry
+# returns False, also when its slot was reused by a later push.
+try:
+    from utimeq import utimeq
+except ImportError:
+    print("SKIP")
+    raise SystemExit
+
+seed = 71
+def rnd(n):
+    global seed
+    seed = (seed * 1103515245 + 12345) & 0x7fffffff
+    return (seed >> 8) % n
+
+def run(asc, nops, span, size):
+    q = utimeq(size, asc=asc)
+    model = []      # [key, time, callback, args, handle], kept sorted by key
+    dead = []       # handles of popped and cancelled entries
+    res = [0, 0, 0]
+    ok = True
+    pushes = 0
+    for i in range(nops):
+        op = rnd(10)
+        if op < 5 or not model:
+            t = rnd(span)
+            h = q.push(t, i, (t, i))
+            key = (t, pushes) if asc else (-t, -pushes)
+            pushes += 1
+            j = len(model)
+            while j > 0 and model[j - 1][0] > key:
+                j -= 1
+            model.insert(j, [key, t, i, (t, i), h])
+        elif op < 8:
+            q.pop(res)
+            e = model.pop(0)
+            ok = ok and res == [e[1], e[2], e[3]]
+            dead.append(e[4])
+        elif op < 9 or not dead:
+            e = model.pop(rnd(len(model)))
+            ok = ok and q.cancel(e[4]) is True
+            dead.append(e[4])
+        else:
+            ok = ok and q.cancel(dead[rnd(len(dead))]) is False
+        ok = ok and len(q) == len(model)
+        if model and rnd(4) == 0:
+            ok = ok and q.peektime() == model[0][1]
+    # the handles of live entries are all different
+    live = [e[4] for e in model]
+    ok = ok and len(set(live)) == len(live)
+    # drain the queue
+    while model:
+        q.pop(res)
+        e = model.pop(0)
+        ok = ok and res == [e[1], e[2], e[3]]
+    print(asc, nops, span, size, ok, len(q), bool(q))
+
+# few distinct times, so that many entries are equal
+run(True, 2000, 8, 1)
+run(True, 2000, 1000, 4)
+run(False, 2000, 8, 16)
+run(False, 2000, 1000, 0)
+
+# a stale handle does not cancel the entry that reuses its slot
+q = utimeq(1)
+h1 = q.push(10, 'a', None)
+res = [0, 0, 0]
+q.pop(res)
+h2 = q.push(20, 'b', None)
+print(h1 != h2, q.cancel(h1), len(q), q.cancel(h2), q.cancel(h2), len(q))
+
+# the queue grows on demand
+q = utimeq(0)
+for i in range(100):
+    q.push(100 - i, i, None)
+print(q.len()[0], q.len()[1] >= 100, q.peektime(), q.peektime(99))
+
+try:
+    q = utimeq(1)
+    q.pop([0, 0, 0])
+except IndexError:
+    print('IndexError')
@@ -0,0 +1,237 @@
+/*
+ * This file is part of the MicroPython ESP32 project, https://github.com/loboris/MicroPython_ESP32_psRAM_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+// Throughput benchmark of extmod/framebuf_blit.c against the getpixel/setpixel
+// loop of the original FrameBuffer.blit, which called the format functions
+// through the function pointer table for every pixel. Run with 'make bench'.
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "test.h"
+#include "framebuf_blit.h"
+
+#define DST_W 320
+#define DST_H 240
+#define BLIT_PIXELS (20 * 1000 * 1000)
+
+static double now_us(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e6 + t.tv_nsec / 1e3;
+}
+
+// The format functions of the original modframebuf.c
+typedef void (*setpixel_t)(const fb_surface_t *, int, int, uint32_t);
+typedef uint32_t (*getpixel_t)(const fb_surface_t *, int, int);
+
+static void mono_horiz_setpixel(const fb_surface_t *fb, int x, int y, uint32_t col) {
+    size_t index = (x + y * fb->stride) >> 3;
+    int offset = fb->format == FRAMEBUF_MHMSB ? x & 0x07 : 7 - (x & 0x07);
+    fb->buf[index] = (fb->buf[index] & ~(0x01 << offset)) | ((col != 0) << offset);
+}
+
+static uint32_t mono_horiz_getpixel(const fb_surface_t *fb, int x, int y) {
+    size_t index = (x + y * fb->stride) >> 3;
+    int offset = fb->format == FRAMEBUF_MHMSB ? x & 0x07 : 7 - (x & 0x07);
+    return (fb->buf[index] >> (offset)) & 0x01;
+}
+
+static void mvlsb_setpixel(const fb_surface_t *fb, int x, int y, uint32_t col) {
+    size_t index = (y >> 3) * fb->stride + x;
+    uint8_t offset = y & 0x07;
+    fb->buf[index] = (fb->buf[index] & ~(0x01 << offset)) | ((col != 0) << offset);
+}
+
+static uint32_t mvlsb_getpixel(const fb_surface_t *fb, int x, int y) {
+    return (fb->buf[(y >> 3) * fb->stride + x] >> (y & 0x07)) & 0x01;
+}
+
+static void rgb565_setpixel(const fb_surface_t *fb, int x, int y, uint32_t col) {
+    ((uint16_t*)fb->buf)[x + y * fb->stride] = col;
+}
+
+static uint32_t rgb565_getpixel(const fb_surface_t *fb, int x, int y) {
+    return ((uint16_t*)fb->buf)[x + y * fb->stride];
+}
+
+static void gs4_hmsb_setpixel(const fb_surface_t *fb, int x, int y, uint32_t col) {
+    uint8_t *pixel = &fb->buf[(x + y * fb->stride) >> 1];
+    if (x % 2) {
+        *pixel = ((uint8_t)col & 0x0f) | (*pixel & 0xf0);
+    } else {
+        *pixel = ((uint8_t)col << 4) | (*pixel & 0x0f);
+    }
+}
+
+static uint32_t gs4_hmsb_getpixel(const fb_surface_t *fb, int x, int y) {
+    if (x % 2) {
+        return fb->buf[(x + y * fb->stride) >> 1] & 0x0f;
+    }
+    return fb->buf[(x + y * fb->stride) >> 1] >> 4;
+}
+
+static void gs8_setpixel(const fb_surface_t *fb, int x, int y, uint32_t col) {
+    fb->buf[x + y * fb->stride] = col & 0xff;
+}
+
+static uint32_t gs8_getpixel(const fb_surface_t *fb, int x, int y) {
+    return fb->buf[x + y * fb->stride];
+}
+
+static const struct {
+    setpixel_t setpixel;
+    getpixel_t getpixel;
+} formats[] = {
+    [FRAMEBUF_MVLSB] = {mvlsb_setpixel, mvlsb_getpixel},
+    [FRAMEBUF_RGB565] = {rgb565_setpixel, rgb565_getpixel},
+    [FRAMEBUF_GS4_HMSB] = {gs4_hmsb_setpixel, gs4_hmsb_getpixel},
+    [FRAMEBUF_MHLSB] = {mono_horiz_setpixel, mono_horiz_getpixel},
+    [FRAMEBUF_MHMSB] = {mono_horiz_setpixel, mono_horiz_getpixel},
+    [FRAMEBUF_GS8] = {gs8_setpixel, gs8_getpixel},
+};
+
+// The blit loop of the original FrameBuffer.blit
+static void old_blit(const fb_surface_t *self, const fb_surface_t *source, int x, int y, int32_t key) {
+    if ((x >= self->width) || (y >= self->height) || (-x >= source->width) || (-y >= source->height)) {
+        return;
+    }
+    int x0 = (x > 0) ? x : 0;
+    int y0 = (y > 0) ? y : 0;
+    int x1 = (-x > 0) ? -x : 0;
+    int y1 = (-y > 0) ? -y : 0;
+    int x0end = (self->width < x + source->width) ? self->width : x + source->width;
+    int y0end = (self->height < y + source->height) ? self->height : y + source->height;
+    for (; y0 < y0end; ++y0) {
+        int cx1 = x1;
+        for (int cx0 = x0; cx0 < x0end; ++cx0) {
+            uint32_t col = formats[source->format].getpixel(source, cx1, y1);
+            if (col != (uint32_t)key) {
+                formats[self->format].setpixel(self, cx0, y0, col);
+            }
+            ++cx1;
+        }
+        ++y1;
+    }
+}
+
+static size_t buf_size(int f, int stride, int h) {
+    if (f == FRAMEBUF_RGB565) return stride * h * 2;
+    if (f == FRAMEBUF_RGB888) return stride * h * 3;
+    if (f == FRAMEBUF_MVLSB) return stride * ((h + 7) / 8);
+    if ((f == FRAMEBUF_MHLSB) || (f == FRAMEBUF_MHMSB)) return stride * h / 8;
+    if (f == FRAMEBUF_GS4_HMSB) return stride * h / 2;
+    return stride * h;
+}
+
+static void make_surface(fb_surface_t *s, int f, int w, int h) {
+    s->format = f;
+    s->width = w;
+    s->height = h;
+    s->stride = (w + 7) & ~7;
+    size_t n = buf_size(f, s->stride, h);
+    s->buf = malloc(n);
+    for (size_t i = 0; i < n; i++) s->buf[i] = rand();
+}
+
+typedef struct _blit_case_t {
+    const char *name;
+    int src_format, dst_format;
+    int w, h;
+    int key, alpha, scale, palette, convert;
+} blit_case_t;
+
+static const blit_case_t cases[] = {
+    // the original blit can do these
+    {"RGB565 -> RGB565 copy",       FRAMEBUF_RGB565, FRAMEBUF_RGB565, 64, 64, -1, 255, 1, 0, 0},
+    {"RGB565 -> RGB565 key",        FRAMEBUF_RGB565, FRAMEBUF_RGB565, 64, 64, 0, 255, 1, 0, 0},
+    {"GS8 -> GS8 key",              FRAMEBUF_GS8, FRAMEBUF_GS8, 64, 64, 0, 255, 1, 0, 0},
+    {"MONO_HLSB -> RGB565 key",     FRAMEBUF_MHLSB, FRAMEBUF_RGB565, 64, 64, 0, 255, 1, 0, 0},
+    {"MONO_VLSB -> MONO_VLSB copy", FRAMEBUF_MVLSB, FRAMEBUF_MVLSB, 128, 64, -1, 255, 1, 0, 0},
+    {"GS4_HMSB -> RGB565 copy",     FRAMEBUF_GS4_HMSB, FRAMEBUF_RGB565, 64, 64, -1, 255, 1, 0, 0},
+    // the new options
+    {"GS4_HMSB -> RGB565 palette",  FRAMEBUF_GS4_HMSB, FRAMEBUF_RGB565, 64, 64, -1, 255, 1, 1, 0},
+    {"RGB565 -> RGB888 convert",    FRAMEBUF_RGB565, FRAMEBUF_RGB888, 64, 64, -1, 255, 1, 0, 1},
+    {"RGB565 -> RGB565 alpha",      FRAMEBUF_RGB565, FRAMEBUF_RGB565, 64, 64, -1, 128, 1, 0, 0},
+    {"RGB565 -> RGB565 scale 2",    FRAMEBUF_RGB565, FRAMEBUF_RGB565, 32, 32, -1, 255, 2, 0, 0},
+};
+
+static void bench_case(const blit_case_t *c) {
+    fb_surface_t src, dst1, dst2, pal;
+    make_surface(&src, c->src_format, c->w, c->h);
+    make_surface(&dst1, c->dst_format, DST_W, DST_H);
+    make_surface(&pal, c->dst_format, 16, 1);
+    dst2 = dst1;
+    size_t n = buf_size(c->dst_format, dst1.stride, DST_H);
+    dst2.buf = malloc(n);
+    memcpy(dst2.buf, dst1.buf, n);
+    // a quarter of the source is transparent
+    if (c->key >= 0) {
+        for (int y = 0; y < c->h; y += 2) {
+            for (int x = (y & 2); x < c->w; x += 4) {
+                formats[src.format].setpixel(&src, x, y, c->key);
+            }
+        }
+    }
+
+    int per_blit = c->w * c->h * c->scale * c->scale;
+    int n_blits = BLIT_PIXELS / per_blit;
+    int old_able = (c->alpha == 255) && (c->scale == 1) && !c->palette && !c->convert;
+    double t_old = 0, t_new;
+
+    // the positions step over the destination, some blits are clipped
+    double t = now_us();
+    for (int i = 0; i < n_blits; i++) {
+        fb_blit(&dst1, &src, (c->palette) ? &pal : NULL, (i * 37) % (DST_W + 16) - 32, (i * 17) % (DST_H + 16) - 32,
+                c->key, c->alpha, c->scale, c->convert);
+    }
+    t_new = now_us() - t;
+    if (old_able) {
+        t = now_us();
+        for (int i = 0; i < n_blits; i++) {
+            old_blit(&dst2, &src, (i * 37) % (DST_W + 16) - 32, (i * 17) % (DST_H + 16) - 32, c->key);
+        }
+        t_old = now_us() - t;
+        CHECK(memcmp(dst1.buf, dst2.buf, n) == 0);
+        printf("%-28s %8.1f Mpix/s, original blit %6.1f Mpix/s\n", c->name,
+            (double)n_blits * per_blit / t_new, (double)n_blits * per_blit / t_old);
+    } else {
+        printf("%-28s %8.1f Mpix/s\n", c->name, (double)n_blits * per_blit / t_new);
+    }
+    free(src.buf);
+    free(dst1.buf);
+    free(dst2.buf);
+    free(pal.buf);
+}
+
+int main(void) {
+    srand(59);
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        bench_case(&cases[i]);
+    }
+    return test_result("framebuf_blit");
+}
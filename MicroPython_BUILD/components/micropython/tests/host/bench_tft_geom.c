@@ -0,0 +1,265 @@
+/*
+ * This file is part of the MicroPython ESP32 project, https://github.com/loboris/MicroPython_ESP32_psRAM_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+// Benchmark of esp32/libs/tft/tft_geom.c against the float geometry of the
+// previous tft.c: the arcs are rendered into memory images by both and
+// compared, the line and polygon end points and the HSB colours are
+// compared for all angles. Run with 'make bench'.
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "test.h"
+#include "tft/tft_geom.h"
+
+#define DEG_TO_RAD 0.01745329252
+#define IMG_SIZE 256
+#define IMG_C (IMG_SIZE / 2)
+
+static uint8_t img_old[IMG_SIZE * IMG_SIZE];
+static uint8_t img_new[IMG_SIZE * IMG_SIZE];
+
+static double now_us(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e6 + t.tv_nsec / 1e3;
+}
+
+// The per-pixel arc of the previous tft.c (_fillArcOffsetted), _arcAngleMax is 360
+static void old_arc(uint8_t *img, int radius, int thickness, float start, float end) {
+    float sslope = (cos(start / 360 * 2 * M_PI) * 360) / (sin(start / 360 * 2 * M_PI) * 360);
+    float eslope = (cos(end / 360 * 2 * M_PI) * 360) / (sin(end / 360 * 2 * M_PI) * 360);
+    if (end == 360) eslope = -1000000;
+    int ir2 = (radius - thickness) * (radius - thickness);
+    int or2 = radius * radius;
+    for (int x = -radius; x <= radius; x++) {
+        for (int y = -radius; y <= radius; y++) {
+            int x2 = x * x;
+            int y2 = y * y;
+            if ((x2 + y2 < or2 && x2 + y2 >= ir2) &&
+                ((y > 0 && start < 180 && x <= y * sslope) ||
+                 (y < 0 && start > 180 && x >= y * sslope) ||
+                 (y < 0 && start <= 180) ||
+                 (y == 0 && start <= 180 && x < 0) ||
+                 (y == 0 && start == 0 && x > 0)) &&
+                ((y > 0 && end < 180 && x >= y * eslope) ||
+                 (y < 0 && end > 180 && x <= y * eslope) ||
+                 (y > 0 && end >= 180) ||
+                 (y == 0 && end >= 180 && x < 0) ||
+                 (y == 0 && start == 0 && x > 0))) {
+                img[(IMG_C + y) * IMG_SIZE + IMG_C + x] = 1;
+            }
+        }
+    }
+}
+
+static void new_arc(uint8_t *img, int radius, int thickness, int32_t start, int32_t end) {
+    tft_arc_t arc;
+    int spans[4];
+    tft_arc_init(&arc, radius, thickness, start, end);
+    for (int y = -radius; y <= radius; y++) {
+        int n = tft_arc_row(&arc, y, spans);
+        for (int i = 0; i < n; i++) {
+            memset(&img[(IMG_C + y) * IMG_SIZE + IMG_C + spans[i * 2]], 1, spans[i * 2 + 1] - spans[i * 2] + 1);
+        }
+    }
+}
+
+// The arc angles as TFT_drawArc prepares them, the arc over 0 degrees is drawn in two parts
+static void draw_arcs(int old, int r, int th, float astart, float aend) {
+    if (old) {
+        if (astart > aend) {
+            old_arc(img_old, r, th, astart, 360);
+            old_arc(img_old, r, th, 0, aend);
+        } else {
+            old_arc(img_old, r, th, astart, aend);
+        }
+    } else {
+        int32_t as = tft_angle(astart), ae = tft_angle(aend);
+        if (astart > aend) {
+            new_arc(img_new, r, th, as, TFT_ANGLE_FULL);
+            new_arc(img_new, r, th, 0, ae);
+        } else {
+            new_arc(img_new, r, th, as, ae);
+        }
+    }
+}
+
+static void bench_arc(void) {
+    size_t pixels = 0, diff = 0;
+    double t_old = 0, t_new = 0;
+    srand(58);
+    for (int i = 0; i < 400; i++) {
+        int r = 1 + rand() % (IMG_C - 8);
+        int th = 1 + rand() % r;
+        // whole degrees, as most scripts use, and fractions
+        float astart = rand() % 360, aend = rand() % 360;
+        if (i & 1) {
+            astart += (rand() % 100) / 100.0f;
+            aend += (rand() % 100) / 100.0f;
+        }
+        if (aend == 0) aend = 360;
+        memset(img_old, 0, sizeof(img_old));
+        memset(img_new, 0, sizeof(img_new));
+        double t = now_us();
+        draw_arcs(1, r, th, astart, aend);
+        t_old += now_us() - t;
+        t = now_us();
+        draw_arcs(0, r, th, astart, aend);
+        t_new += now_us() - t;
+        for (size_t p = 0; p < sizeof(img_old); p++) {
+            pixels += img_old[p];
+            diff += img_old[p] != img_new[p];
+        }
+    }
+    printf("arc: %zu pixels, %zu differ (%.4f%%), old %.0f us, new %.0f us\n",
+        pixels, diff, diff * 100.0 / pixels, t_old, t_new);
+    // the differences are single pixels at the span ends, where the float slope rounds
+    CHECK(diff * 1000 < pixels);
+}
+
+// End points of the lines by angle and the arc end lines: 'pos + v * cos(a)' converted to integer
+static void bench_points(void) {
+    size_t n = 0, diff = 0;
+    int max_diff = 0;
+    for (int angle = -360; angle <= 720; angle++) {
+        for (int len = 0; len < 200; len += 3) {
+            for (int pos = 0; pos < 3; pos++) {
+                int x = (pos == 0) ? 0 : (pos == 1) ? 5 : 160;
+                int xo = (int16_t)(x + len * cos(angle * DEG_TO_RAD));
+                int yo = (int16_t)(x + len * sin(angle * DEG_TO_RAD));
+                int32_t a = angle * TFT_ANGLE_ONE;
+                int xn = tft_fix_pos(x, len, tft_cos(a));
+                int yn = tft_fix_pos(x, len, tft_sin(a));
+                int d = abs(xo - xn) > abs(yo - yn) ? abs(xo - xn) : abs(yo - yn);
+                n++;
+                diff += d != 0;
+                max_diff = (d > max_diff) ? d : max_diff;
+            }
+        }
+    }
+    printf("points: %zu, %zu differ, max %d px\n", n, diff, max_diff);
+    CHECK(max_diff <= 1);
+    CHECK(diff * 50 < n);
+
+    // the polygon vertices, rotated by 180 degrees
+    n = diff = 0;
+    max_diff = 0;
+    for (int deg = -90; deg < 270; deg++) {
+        for (int d = 1; d < 120; d++) {
+            int xo = 128 + sin(deg * (DEG_TO_RAD) + M_PI) * d;
+            int yo = 128 + cos(deg * (DEG_TO_RAD) + M_PI) * d;
+            int xn = tft_fix_pos(128, d, tft_sin((deg + 180) * TFT_ANGLE_ONE));
+            int yn = tft_fix_pos(128, d, tft_cos((deg + 180) * TFT_ANGLE_ONE));
+            int dd = abs(xo - xn) > abs(yo - yn) ? abs(xo - xn) : abs(yo - yn);
+            n++;
+            diff += dd != 0;
+            max_diff = (dd > max_diff) ? dd : max_diff;
+        }
+    }
+    printf("polygon: %zu vertices, %zu differ, max %d px\n", n, diff, max_diff);
+    CHECK(max_diff <= 1);
+    CHECK(diff * 50 < n);
+}
+
+static void bench_sin(void) {
+    volatile double sink = 0;
+    double t = now_us();
+    for (int32_t a = 0; a < TFT_ANGLE_FULL; a++) {
+        sink += sin(a * M_PI / (180.0 * TFT_ANGLE_ONE));
+    }
+    double t_old = now_us() - t;
+    t = now_us();
+    for (int32_t a = 0; a < TFT_ANGLE_FULL; a++) {
+        sink += tft_sin(a);
+    }
+    double t_new = now_us() - t;
+    double max_err = 0;
+    for (int32_t a = -TFT_ANGLE_FULL; a <= 2 * TFT_ANGLE_FULL; a++) {
+        double r = a * M_PI / (180.0 * TFT_ANGLE_ONE);
+        double es = fabs(tft_sin(a) / 65536.0 - sin(r));
+        double ec = fabs(tft_cos(a) / 65536.0 - cos(r));
+        max_err = (es > max_err) ? es : max_err;
+        max_err = (ec > max_err) ? ec : max_err;
+    }
+    printf("sin/cos: max error %.7f, sin() %.0f us, tft_sin() %.0f us\n", max_err, t_old, t_new);
+    // linear interpolation between whole degrees, the steps are rounded down
+    CHECK(max_err < 0.0001);
+}
+
+// HSBtoRGB of the previous tft.c
+static void old_hsb(float hue, float sat, float bri, uint8_t *rgb) {
+    float c[3] = {bri, bri, bri};
+    if (sat != 0.0f) {
+        if (hue == 360.0f) hue = 0;
+        int slice = (int)(hue / 60.0);
+        float frac = (hue / 60.0) - slice;
+        float aa = bri * (1.0 - sat);
+        float bb = bri * (1.0 - sat * frac);
+        float cc = bri * (1.0 - sat * (1.0 - frac));
+        float v[6][3] = {{bri, cc, aa}, {bb, bri, aa}, {aa, bri, cc}, {aa, bb, bri}, {cc, aa, bri}, {bri, aa, bb}};
+        for (int i = 0; i < 3; i++) {
+            c[i] = (slice >= 0 && slice < 6) ? v[slice][i] : 0;
+        }
+    }
+    for (int i = 0; i < 3; i++) {
+        rgb[i] = ((uint8_t)(c[i] * 255.0)) & 0xFC;
+    }
+}
+
+static void bench_hsb(void) {
+    size_t n = 0, diff = 0;
+    int max_diff = 0;
+    for (int hue = 0; hue <= 360; hue++) {
+        for (int s = 0; s <= 20; s++) {
+            for (int b = 0; b <= 20; b++) {
+                uint8_t ro[3], rn[3];
+                float sat = s / 20.0f, bri = b / 20.0f;
+                old_hsb(hue, sat, bri, ro);
+                tft_hsb_to_rgb(tft_angle(hue), (int32_t)(sat * TFT_FIX_ONE), (int32_t)(bri * TFT_FIX_ONE), rn);
+                for (int i = 0; i < 3; i++) {
+                    int d = abs(ro[i] - rn[i]);
+                    n++;
+                    diff += d != 0;
+                    max_diff = (d > max_diff) ? d : max_diff;
+                }
+            }
+        }
+    }
+    printf("hsb: %zu components, %zu differ, max %d\n", n, diff, max_diff);
+    // one step of the 6-bit components
+    CHECK(max_diff <= 4);
+}
+
+int main(void) {
+    bench_sin();
+    bench_points();
+    bench_hsb();
+    bench_arc();
+    return test_result("tft_geom");
+}
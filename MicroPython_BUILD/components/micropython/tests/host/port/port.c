@@ -0,0 +1,103 @@
+/*
+ * This file is part of the MicroPython ESP32 project, https://github.com/loboris/MicroPython_ESP32_psRAM_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "py/mpstate.h"
+#include "py/mphal.h"
+#include "py/mpprint.h"
+#include "py/qstr.h"
+
+mp_state_ctx_t mp_state_ctx;
+uint64_t port_ticks_us;
+const char *const *port_qstr_names;
+
+uint64_t mp_hal_ticks_us(void) {
+    return port_ticks_us;
+}
+
+const char *qstr_str(qstr q) {
+    return port_qstr_names[q];
+}
+
+int mp_print_str(const mp_print_t *print, const char *str) {
+    size_t len = strlen(str);
+    print->print_strn(print->data, str, len);
+    return len;
+}
+
+int mp_printf(const mp_print_t *print, const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    char spec[16];
+    char buf[64];
+    int chrs = 0;
+    while (*fmt != '\0') {
+        const char *f = fmt;
+        while (*f != '\0' && *f != '%') {
+            f++;
+        }
+        if (f > fmt) {
+            print->print_strn(print->data, fmt, f - fmt);
+            chrs += f - fmt;
+        }
+        if (*f == '\0') {
+            break;
+        }
+        // copy the conversion spec, the printf one is used for the value
+        size_t n = strspn(f + 1, "-0123456789") + 2;
+        if (n >= sizeof(spec)) {
+            break;
+        }
+        memcpy(spec, f, n);
+        spec[n] = '\0';
+        fmt = f + n;
+        switch (spec[n - 1]) {
+            case 'd':
+                snprintf(buf, sizeof(buf), spec, va_arg(ap, int));
+                break;
+            case 'u':
+            case 'x':
+                snprintf(buf, sizeof(buf), spec, va_arg(ap, unsigned int));
+                break;
+            case 's':
+                snprintf(buf, sizeof(buf), spec, va_arg(ap, const char*));
+                break;
+            case 'q':
+                spec[n - 1] = 's';
+                snprintf(buf, sizeof(buf), spec, qstr_str(va_arg(ap, qstr)));
+                break;
+            default:
+                snprintf(buf, sizeof(buf), "%s", spec);
+                break;
+        }
+        chrs += mp_print_str(print, buf);
+    }
+    va_end(ap);
+    return chrs;
+}
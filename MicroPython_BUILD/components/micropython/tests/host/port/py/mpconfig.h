@@ -0,0 +1,63 @@
+/*
+ * This file is part of the MicroPython ESP32 project, https://github.com/loboris/MicroPython_ESP32_psRAM_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Stub port for the host tests of the py modules that only need the
+ * configuration, the memory state, the HAL clock, printing and qstrs.
+ * The headers here are found before the py headers of the firmware.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define STATIC static
+
+#define MICROPY_BOOT_TRACE (1)
+#define MICROPY_BOOT_TRACE_ENTRIES (8)
+
+// GC with the fast and the slow heap area
+#define MICROPY_ENABLE_GC (1)
+#define MICROPY_ENABLE_FINALISER (1)
+#define MICROPY_GC_MAX_AREAS (2)
+#define MICROPY_GC_MULTI_HEAP (MICROPY_GC_MAX_AREAS > 1)
+#define MICROPY_GC_FAST_MAX_BYTES (256)
+#define MICROPY_GC_CONSERVATIVE_CLEAR (1)
+#define MICROPY_GC_ALLOC_THRESHOLD (1)
+#define MICROPY_ALLOC_GC_STACK_SIZE (64)
+#define MICROPY_BYTES_PER_GC_BLOCK (4 * BYTES_PER_WORD)
+
+typedef uintptr_t mp_uint_t;
+typedef intptr_t mp_int_t;
+
+#define BYTES_PER_WORD (__SIZEOF_POINTER__)
+#define NORETURN __attribute__((noreturn))
+#define BITS_PER_BYTE (8)
+
+// from py/misc.h
+typedef unsigned int uint;
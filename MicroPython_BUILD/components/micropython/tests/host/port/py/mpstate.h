@@ -0,0 +1,81 @@
+/*
+ * This file is part of the MicroPython ESP32 project, https://github.com/loboris/MicroPython_ESP32_psRAM_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "py/mpconfig.h"
+#include "py/misc.h"
+
+// The memory state has the layout of the firmware's mp_state_mem_t
+typedef struct _mp_state_mem_area_t {
+    byte *gc_alloc_table_start;
+    size_t gc_alloc_table_byte_len;
+    byte *gc_finaliser_table_start;
+    byte *gc_pool_start;
+    byte *gc_pool_end;
+    size_t gc_last_free_atb_index;
+    uint16_t flags;
+    uint16_t cost;
+    size_t n_alloc;
+    size_t n_fallback;
+    size_t scan_words;
+} mp_state_mem_area_t;
+
+typedef struct _mp_state_mem_t {
+    mp_state_mem_area_t gc_area[MICROPY_GC_MAX_AREAS];
+    size_t gc_n_areas;
+    byte *gc_heap_lo;
+    byte *gc_heap_hi;
+    size_t gc_fast_max_bytes;
+    int gc_stack_overflow;
+    size_t gc_stack[MICROPY_ALLOC_GC_STACK_SIZE];
+    uint8_t gc_area_stack[MICROPY_ALLOC_GC_STACK_SIZE];
+    uint16_t gc_lock_depth;
+    uint16_t gc_auto_collect_enabled;
+    uint16_t gc_auto_collect_debug;
+    size_t gc_alloc_amount;
+    size_t gc_alloc_threshold;
+    size_t gc_collected;
+    size_t gc_marked;
+    size_t gc_alloc_total;
+} mp_state_mem_t;
+
+// The root pointers traced by gc_collect_start() are set by the test
+typedef struct _mp_state_vm_t {
+    void *port_roots[8];
+    char *qstr_last_chunk;
+    struct _qstr_pool_t *last_pool;
+} mp_state_vm_t;
+
+typedef struct _mp_state_ctx_t {
+    mp_state_vm_t vm;
+    mp_state_mem_t mem;
+} mp_state_ctx_t;
+
+extern mp_state_ctx_t mp_state_ctx;
+
+#define MP_STATE_VM(x) (mp_state_ctx.vm.x)
+#define MP_STATE_MEM(x) (mp_state_ctx.mem.x)
@@ -0,0 +1,69 @@
+/*
+ * This file is part of the MicroPython ESP32 project, https://github.com/loboris/MicroPython_ESP32_psRAM_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "py/mpstate.h"
+#include "py/mpprint.h"
+#include "py/qstr.h"
+
+// The object model used by py/gc.c: the type of an object is only compared,
+// a finaliser is looked up with mp_load_method_maybe(), provided by the test
+typedef void *mp_obj_t;
+
+typedef struct _mp_obj_type_t {
+    const char *name;
+} mp_obj_type_t;
+
+typedef struct _mp_obj_base_t {
+    const mp_obj_type_t *type;
+} mp_obj_base_t;
+
+typedef struct _mp_obj_dict_t {
+    mp_obj_base_t base;
+} mp_obj_dict_t;
+
+typedef struct _qstr_pool_t {
+    struct _qstr_pool_t *prev;
+    size_t len;
+    const byte *qstrs[];
+} qstr_pool_t;
+
+#define MP_OBJ_NULL (NULL)
+#define MP_OBJ_FROM_PTR(p) ((mp_obj_t)(p))
+
+// the qstrs used by py/gc.c follow the test's qstr names
+#define MP_QSTR___del__ (port_qstr_del)
+#define MP_QSTR_gc (port_qstr_del + 1)
+extern qstr port_qstr_del;
+
+extern const mp_print_t mp_plat_print;
+
+extern const mp_obj_type_t mp_type_tuple, mp_type_list, mp_type_dict, mp_type_str, mp_type_bytes;
+extern const mp_obj_type_t mp_type_fun_bc, mp_type_module;
+
+void mp_load_method_maybe(mp_obj_t base, qstr attr, mp_obj_t *dest);
+mp_obj_t mp_call_function_1_protected(mp_obj_t fun, mp_obj_t arg);
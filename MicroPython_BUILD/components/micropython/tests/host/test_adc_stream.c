@@ -0,0 +1,184 @@
+/*
+ * This file is part of the MicroPython ESP32 project, https://github.com/loboris/MicroPython_ESP32_psRAM_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+// Test of esp32/libs/adc_stream.c with a synthetic sample source.
+// The source produces a ramp with the bits above the 12-bit ADC value set,
+// so every stored sample tells which raw sample it was made from.
+
+#include <string.h>
+
+#include "test.h"
+#include "adc_stream.h"
+
+#define PERIOD_NS   (10000)     // 100 kHz
+
+typedef struct _source_t {
+    uint32_t k;                 // next raw sample number
+    uint64_t t0;
+} source_t;
+
+static uint16_t raw_val(uint32_t k) {
+    return 0xf000 | (k & 0x0fff);
+}
+
+// Generate 'n' raw samples and put them into the stream
+static int source_put(source_t *src, adc_stream_t *st, uint32_t n) {
+    uint16_t raw[64];
+    uint64_t ts = src->t0 + ((uint64_t)src->k * PERIOD_NS) / 1000;
+    for (uint32_t i = 0; i < n; i++) raw[i] = raw_val(src->k + i);
+    src->k += n;
+    return adc_stream_put(st, raw, n, ts, PERIOD_NS);
+}
+
+static adc_stream_t st;
+static uint8_t mem[4096];
+static adc_block_info_t info[8];
+
+static void test_init(void) {
+    CHECK_EQ(adc_stream_init(&st, mem, info, 1, 8, 2, 0, 1, 0), -1);
+    CHECK_EQ(adc_stream_init(&st, mem, info, 2, 0, 2, 0, 1, 0), -1);
+    CHECK_EQ(adc_stream_init(&st, mem, info, 2, 8, 3, 0, 1, 0), -1);
+    CHECK_EQ(adc_stream_init(&st, NULL, info, 2, 8, 2, 0, 1, 0), -1);
+    CHECK_EQ(adc_stream_init(&st, mem, info, 2, 8, 2, 0, 0, 1), 0);
+    CHECK_EQ(st.decimate, 1);
+    CHECK_EQ(st.average, 0);
+    CHECK(adc_stream_get(&st, NULL) == NULL);
+}
+
+static void test_stream(void) {
+    // 3 blocks (not a power of two), chunks of varying size,
+    // the consumer runs after every chunk, the ring wraps many times
+    source_t src = {0, 1000000};
+    adc_block_info_t bi;
+    uint32_t next_k = 0, seq = 0, max_pending = 0;
+    int errors = 0;
+    CHECK_EQ(adc_stream_init(&st, mem, info, 3, 16, 2, 0, 1, 0), 0);
+    for (int chunk = 0; chunk < 5000; chunk++) {
+        source_put(&src, &st, 1 + (chunk * 13) % 20);
+        uint32_t pending = adc_stream_pending(&st);
+        if (pending > max_pending) max_pending = pending;
+        // consume only every other chunk, to keep some blocks pending
+        if (chunk & 1) continue;
+        uint16_t *block;
+        while ((block = (uint16_t *)adc_stream_get(&st, &bi)) != NULL) {
+            if ((bi.seq != seq) || (bi.len != 16)) errors++;
+            if (bi.timestamp != src.t0 + ((uint64_t)next_k * PERIOD_NS) / 1000) errors++;
+            for (int i = 0; i < 16; i++) {
+                if (block[i] != (raw_val(next_k + i) & 0x0fff)) errors++;
+            }
+            next_k += 16;
+            seq++;
+            adc_stream_release(&st);
+        }
+        if ((st.iput >= 6) || (st.iget >= 6)) errors++;
+    }
+    CHECK_EQ(errors, 0);
+    CHECK_EQ(st.overruns, 0);
+    CHECK(seq > 3000);
+    CHECK_EQ(st.blocks, seq + adc_stream_pending(&st));
+    CHECK(max_pending >= 2);
+    CHECK(max_pending <= 3);
+}
+
+static void test_overrun(void) {
+    // the consumer doesn't run, the block after the full ring is dropped
+    source_t src = {0, 0};
+    adc_block_info_t bi;
+    CHECK_EQ(adc_stream_init(&st, mem, info, 3, 4, 2, 0, 1, 0), 0);
+    CHECK_EQ(source_put(&src, &st, 12), 3);
+    CHECK_EQ(adc_stream_pending(&st), 3);
+    CHECK_EQ(source_put(&src, &st, 4), 0);
+    CHECK_EQ(st.overruns, 1);
+    CHECK_EQ(st.dropped, 4);
+    CHECK_EQ(adc_stream_pending(&st), 3);
+
+    // free one block, the stream continues with the next block, the gap is in 'seq'
+    CHECK(adc_stream_get(&st, &bi) != NULL);
+    CHECK_EQ(bi.seq, 0);
+    adc_stream_release(&st);
+    CHECK_EQ(source_put(&src, &st, 4), 1);
+    for (uint32_t n = 1; n < 3; n++) {
+        CHECK(adc_stream_get(&st, &bi) != NULL);
+        CHECK_EQ(bi.seq, n);
+        adc_stream_release(&st);
+    }
+    uint16_t *block = (uint16_t *)adc_stream_get(&st, &bi);
+    CHECK(block != NULL);
+    CHECK_EQ(bi.seq, 4);
+    CHECK_EQ(block[0], 16);
+    CHECK_EQ(block[3], 19);
+    CHECK_EQ(bi.timestamp, (16ULL * PERIOD_NS) / 1000);
+    adc_stream_release(&st);
+    CHECK(adc_stream_get(&st, NULL) == NULL);
+    adc_stream_release(&st);    // nothing to release
+    CHECK_EQ(adc_stream_pending(&st), 0);
+}
+
+static void test_decimate(void) {
+    // 8-bit samples, averaging of 4 raw samples, shifted by 4 bits
+    source_t src = {0, 0};
+    adc_block_info_t bi;
+    CHECK_EQ(adc_stream_init(&st, mem, info, 2, 5, 1, 4, 4, 1), 0);
+    CHECK_EQ(source_put(&src, &st, 3), 0);
+    CHECK_EQ(source_put(&src, &st, 17), 1);
+    uint8_t *block = adc_stream_get(&st, &bi);
+    CHECK(block != NULL);
+    for (int i = 0; i < 5; i++) {
+        // average of 4i ... 4i+3
+        CHECK_EQ(block[i], ((4 * i * 4 + 6) / 4) >> 4);
+    }
+    CHECK_EQ(bi.timestamp, 0);
+    adc_stream_release(&st);
+
+    // no averaging, the first sample of each group is taken
+    src.k = 0x100;
+    CHECK_EQ(adc_stream_init(&st, mem, info, 2, 5, 2, 0, 3, 0), 0);
+    CHECK_EQ(source_put(&src, &st, 15), 1);
+    uint16_t *b16 = (uint16_t *)adc_stream_get(&st, &bi);
+    CHECK(b16 != NULL);
+    CHECK_EQ(b16[0], 0x100);
+    CHECK_EQ(b16[4], 0x10c);
+    CHECK_EQ(bi.timestamp, (0x100ULL * PERIOD_NS) / 1000);
+    adc_stream_release(&st);
+
+    // the partial block is completed on finish
+    CHECK_EQ(source_put(&src, &st, 8), 0);
+    CHECK_EQ(adc_stream_finish(&st), 1);
+    CHECK_EQ(adc_stream_finish(&st), 0);
+    b16 = (uint16_t *)adc_stream_get(&st, &bi);
+    CHECK(b16 != NULL);
+    CHECK_EQ(bi.len, 2);
+    CHECK_EQ(bi.seq, 1);
+    CHECK_EQ(b16[1], 0x112);
+}
+
+int main(void) {
+    test_init();
+    test_stream();
+    test_overrun();
+    test_decimate();
+    return test_result("adc_stream");
+}
@@ -0,0 +1,161 @@
+/*
+ * This file is part of the MicroPython ESP32 project, https://github.com/loboris/MicroPython_ESP32_psRAM_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+// Test of py/boottrace.c on the stub port: nesting of the spans, spans begun
+// while recording is stopped, spans cancelled by an exception and the ring
+
+#include <string.h>
+
+#include "test.h"
+#include "py/mpstate.h"
+#include "py/mphal.h"
+#include "py/boottrace.h"
+
+enum { Q_mark, Q_mp_init, Q_mod, Q_other, Q_repl };
+
+static const char *const qstr_names[] = {
+    [Q_mark] = "mark",
+    [Q_mp_init] = "mp_init",
+    [Q_mod] = "mod",
+    [Q_other] = "other",
+    [Q_repl] = "repl",
+};
+
+static char out[2048];
+static size_t out_len;
+
+static void out_strn(void *data, const char *str, size_t len) {
+    if (out_len + len < sizeof(out)) {
+        memcpy(out + out_len, str, len);
+        out_len += len;
+        out[out_len] = '\0';
+    }
+}
+
+static const mp_print_t out_print = {NULL, out_strn};
+
+// the trace printed without the header lines
+static const char *trace(void) {
+    out_len = 0;
+    out[0] = '\0';
+    mp_boot_trace_print(&out_print);
+    const char *p = strchr(out, '\n');
+    p = (p != NULL) ? strchr(p + 1, '\n') : NULL;
+    return (p != NULL) ? p + 1 : "";
+}
+
+static void test_nesting(void) {
+    mp_boot_trace_span_t outer, inner;
+    mp_boot_trace_enable(true);
+    port_ticks_us = 1000;
+    mp_boot_trace_begin(&outer);
+    port_ticks_us = 1010;
+    mp_boot_trace_begin(&inner);
+    MP_STATE_MEM(gc_alloc_total) += 100;
+    port_ticks_us = 1030;
+    mp_boot_trace_end(&inner, MP_BOOT_TRACE_IMPORT_PY, Q_mod);
+    MP_STATE_MEM(gc_alloc_total) += 20;
+    port_ticks_us = 1050;
+    mp_boot_trace_end(&outer, MP_BOOT_TRACE_INIT, Q_mp_init);
+    mp_boot_trace_mark(Q_repl);
+    CHECK(strcmp(trace(),
+        "      1000          50     120  init   mp_init\n"
+        "      1010          20     100    py     mod\n"
+        "      1050           0          mark   repl\n") == 0);
+}
+
+static void test_disabled(void) {
+    // a span begun while recording is stopped is ignored when it ends,
+    // even if recording was started again in between
+    mp_boot_trace_span_t span;
+    mp_boot_trace_enable(false);
+    port_ticks_us = 2000;
+    mp_boot_trace_begin(&span);
+    mp_boot_trace_begin(&span);
+    mp_boot_trace_begin(&span);
+    mp_boot_trace_enable(true);
+    mp_boot_trace_mark(Q_mark);
+    port_ticks_us = 2010;
+    mp_boot_trace_end(&span, MP_BOOT_TRACE_IMPORT_PY, Q_mod);
+    mp_boot_trace_mark(Q_other);
+    CHECK(strcmp(trace(),
+        "      2000           0          mark   mark\n"
+        "      2010           0          mark   other\n") == 0);
+
+    // nothing is recorded while stopped
+    mp_boot_trace_enable(false);
+    CHECK(!mp_boot_trace_enabled());
+    mp_boot_trace_begin(&span);
+    mp_boot_trace_end(&span, MP_BOOT_TRACE_IMPORT_PY, Q_mod);
+    mp_boot_trace_mark(Q_mark);
+    CHECK(strstr(out, "2 events, 0 dropped") != NULL);
+    trace();
+    CHECK(strstr(out, "2 events, 0 dropped") != NULL);
+}
+
+static void test_cancel(void) {
+    // an import that raises cancels its span, the events that follow it are
+    // nested in the enclosing span only
+    mp_boot_trace_span_t outer, failed;
+    mp_boot_trace_enable(true);
+    port_ticks_us = 3000;
+    mp_boot_trace_begin(&outer);
+    port_ticks_us = 3010;
+    mp_boot_trace_begin(&failed);
+    port_ticks_us = 3020;
+    mp_boot_trace_cancel(&failed);
+    mp_boot_trace_mark(Q_other);
+    port_ticks_us = 3030;
+    mp_boot_trace_end(&outer, MP_BOOT_TRACE_SCRIPT, Q_mod);
+    mp_boot_trace_mark(Q_repl);
+    CHECK(strcmp(trace(),
+        "      3000          30       0  script mod\n"
+        "      3020           0            mark   other\n"
+        "      3030           0          mark   repl\n") == 0);
+}
+
+static void test_ring(void) {
+    // the oldest events are dropped when the ring is full
+    mp_boot_trace_enable(true);
+    for (int i = 0; i < MICROPY_BOOT_TRACE_ENTRIES + 3; i++) {
+        port_ticks_us = 4000 + i;
+        mp_boot_trace_mark(Q_mark);
+    }
+    const char *t = trace();
+    CHECK(strstr(out, "8 events, 3 dropped") != NULL);
+    CHECK(strncmp(t, "      4003", 10) == 0);
+    CHECK(strstr(t, "      4010") != NULL);
+    CHECK(strstr(t, "      4002") == NULL);
+}
+
+int main(void) {
+    port_qstr_names = qstr_names;
+    test_nesting();
+    test_disabled();
+    test_cancel();
+    test_ring();
+    return test_result("boottrace");
+}
@@ -0,0 +1,259 @@
+/*
+ * This file is part of the MicroPython ESP32 project, https://github.com/loboris/MicroPython_ESP32_psRAM_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+// Test of the display list builder and decoder, esp32/libs/eve/eve_dlist.c.
+// The streams are encoded word by word as the FT8xx command FIFO expects them,
+// independently of the builder, so the decoder's command table is checked.
+
+#include <string.h>
+
+#include "test.h"
+#include "eve/eve_dlist.h"
+
+#define CMD(code)           (0xFFFFFF00UL | (code))
+#define CMD_DLSTART         CMD(0x00)
+#define CMD_SWAP            CMD(0x01)
+#define CMD_TEXT            CMD(0x0C)
+#define CMD_BUTTON          CMD(0x0D)
+#define CMD_MEMWRITE        CMD(0x1A)
+#define CMD_LOADIMAGE       CMD(0x24)
+#define CMD_SKETCH          CMD(0x30)
+#define CMD_GETMATRIX       CMD(0x33)
+#define CMD_CSKETCH         CMD(0x35)
+#define CMD_SETBITMAP       CMD(0x43)
+
+#define DL_CLEAR_RGB(r,g,b) ((2UL << 24) | ((r) << 16) | ((g) << 8) | (b))
+#define DL_CLEAR            ((38UL << 24) | 7)
+#define DL_DISPLAY          (0)
+
+#define XY(x, y)            (((uint32_t)(y) << 16) | (x))
+
+static uint8_t stream[256];
+static uint32_t slen;
+
+static void put(uint32_t w) {
+    stream[slen++] = w & 0xFF;
+    stream[slen++] = (w >> 8) & 0xFF;
+    stream[slen++] = (w >> 16) & 0xFF;
+    stream[slen++] = (w >> 24) & 0xFF;
+}
+
+static void put_bytes(const char *s, uint32_t len) {
+    memcpy(stream + slen, s, len);
+    slen += len;
+}
+
+static void test_decode(void) {
+    eve_dlist_item_t item;
+    uint32_t pos = 0;
+    slen = 0;
+    put(CMD_DLSTART);
+    put(DL_CLEAR_RGB(0, 0, 64));
+    put(DL_CLEAR);
+    put(CMD_TEXT); put(XY(10, 20)); put(XY(28, 0));
+    put_bytes("Hello\0\0\0", 8);
+    put(CMD_BUTTON); put(XY(5, 6)); put(XY(100, 40)); put(XY(27, 0));
+    put_bytes("OK\0\0", 4);
+    put(CMD_MEMWRITE); put(0x1000); put(5);
+    put_bytes("\1\2\3\4\5\0\0\0", 8);
+    put(CMD_SKETCH); put(XY(0, 0)); put(XY(480, 272)); put(0x2000); put(1);
+    put(CMD_CSKETCH); put(XY(0, 0)); put(XY(480, 272)); put(0x2000); put(XY(1, 1500));
+    put(CMD_SETBITMAP); put(0x3000); put(XY(7, 64)); put(32);
+    put(DL_DISPLAY);
+    put(CMD_SWAP);
+
+    static const struct {
+        uint32_t cmd;
+        uint8_t type;
+        uint8_t nparams;
+        uint32_t size;
+        uint32_t data_len;
+    } expected[] = {
+        {CMD_DLSTART, EVE_DLIST_ITEM_CMD, 0, 4, 0},
+        {DL_CLEAR_RGB(0, 0, 64), EVE_DLIST_ITEM_DL, 0, 4, 0},
+        {DL_CLEAR, EVE_DLIST_ITEM_DL, 0, 4, 0},
+        {CMD_TEXT, EVE_DLIST_ITEM_STR, 2, 20, 6},
+        {CMD_BUTTON, EVE_DLIST_ITEM_STR, 3, 20, 3},
+        {CMD_MEMWRITE, EVE_DLIST_ITEM_DATA, 2, 20, 5},
+        {CMD_SKETCH, EVE_DLIST_ITEM_CMD, 4, 20, 0},
+        {CMD_CSKETCH, EVE_DLIST_ITEM_CMD, 4, 20, 0},
+        {CMD_SETBITMAP, EVE_DLIST_ITEM_CMD, 3, 16, 0},
+        {DL_DISPLAY, EVE_DLIST_ITEM_DL, 0, 4, 0},
+        {CMD_SWAP, EVE_DLIST_ITEM_CMD, 0, 4, 0},
+    };
+    int n = sizeof(expected) / sizeof(expected[0]);
+    uint32_t offset = 0;
+    for (int i = 0; i < n; i++) {
+        CHECK_EQ(eve_dlist_next(stream, slen, &pos, &item), 1);
+        CHECK_EQ(item.cmd, expected[i].cmd);
+        CHECK_EQ(item.offset, offset);
+        CHECK_EQ(item.type, expected[i].type);
+        CHECK_EQ(item.nparams, expected[i].nparams);
+        CHECK_EQ(item.size, expected[i].size);
+        CHECK_EQ(item.data_len, expected[i].data_len);
+        offset += expected[i].size;
+    }
+    CHECK_EQ(pos, slen);
+    CHECK_EQ(eve_dlist_next(stream, slen, &pos, &item), 0);
+    CHECK_EQ(eve_dlist_count(stream, slen), n);
+
+    // parameters and data of the decoded commands
+    pos = 12;
+    eve_dlist_next(stream, slen, &pos, &item);
+    CHECK_EQ(item.params[0], XY(10, 20));
+    CHECK_EQ(item.params[1], XY(28, 0));
+    CHECK(strcmp((const char *)item.data, "Hello") == 0);
+    pos = 52;
+    eve_dlist_next(stream, slen, &pos, &item);
+    CHECK_EQ(item.params[0], 0x1000);
+    CHECK(memcmp(item.data, "\1\2\3\4\5", 5) == 0);
+    pos = 92;
+    eve_dlist_next(stream, slen, &pos, &item);
+    CHECK_EQ(item.cmd, CMD_CSKETCH);
+    CHECK_EQ(item.params[3], XY(1, 1500));
+}
+
+static void test_errors(void) {
+    eve_dlist_item_t item;
+    uint32_t pos;
+
+    // unknown command
+    slen = 0;
+    put(CMD(0x03));
+    pos = 0;
+    CHECK_EQ(eve_dlist_next(stream, slen, &pos, &item), EVE_DLIST_ERR_CMD);
+    slen = 0;
+    put(CMD(0x44));
+    CHECK_EQ(eve_dlist_count(stream, slen), EVE_DLIST_ERR_CMD);
+
+    // missing parameters
+    slen = 0;
+    put(CMD_GETMATRIX); put(1); put(2); put(3); put(4); put(5);
+    CHECK_EQ(eve_dlist_count(stream, slen), EVE_DLIST_ERR_TRUNC);
+    put(6);
+    CHECK_EQ(eve_dlist_count(stream, slen), 1);
+
+    // string without the terminating zero
+    slen = 0;
+    put(CMD_TEXT); put(0); put(0);
+    put_bytes("abcd", 4);
+    CHECK_EQ(eve_dlist_count(stream, slen), EVE_DLIST_ERR_TRUNC);
+
+    // data shorter than its length, non zero padding
+    slen = 0;
+    put(CMD_MEMWRITE); put(0); put(9);
+    put_bytes("12345678", 8);
+    CHECK_EQ(eve_dlist_count(stream, slen), EVE_DLIST_ERR_TRUNC);
+    slen = 0;
+    put(CMD_MEMWRITE); put(0); put(3);
+    put_bytes("123x", 4);
+    CHECK_EQ(eve_dlist_count(stream, slen), EVE_DLIST_ERR_ALIGN);
+
+    // unaligned stream
+    slen = 0;
+    put(CMD_SWAP);
+    CHECK_EQ(eve_dlist_count(stream, slen - 1), EVE_DLIST_ERR_ALIGN);
+    pos = 2;
+    CHECK_EQ(eve_dlist_next(stream, slen, &pos, &item), EVE_DLIST_ERR_ALIGN);
+
+    // image data has known length only when taken from the media fifo
+    slen = 0;
+    put(CMD_LOADIMAGE); put(0); put(0);
+    CHECK_EQ(eve_dlist_count(stream, slen), EVE_DLIST_ERR_CMD);
+    slen = 0;
+    put(CMD_LOADIMAGE); put(0); put(16);
+    put(CMD_SWAP);
+    CHECK_EQ(eve_dlist_count(stream, slen), 2);
+}
+
+static void test_builder(void) {
+    static uint8_t buf[128];
+    eve_dlist_t dl;
+    eve_dlist_init(&dl, buf, sizeof(buf) + 3);
+    CHECK_EQ(dl.size, sizeof(buf));
+
+    // the builder output is the same as the hand encoded stream
+    slen = 0;
+    put(CMD_TEXT); put(XY(10, 20)); put(XY(28, 0));
+    put_bytes("Hello\0\0\0", 8);
+    eve_dlist_word(&dl, CMD_TEXT);
+    static const uint16_t p16[4] = {10, 20, 28, 0};
+    eve_dlist_params16(&dl, p16, 4);
+    eve_dlist_string(&dl, "Hello");
+    CHECK_EQ(dl.len, slen);
+    CHECK(memcmp(buf, stream, slen) == 0);
+
+    // segments
+    eve_dlist_clear(&dl);
+    eve_dlist_word(&dl, CMD_DLSTART);
+    CHECK_EQ(eve_dlist_mark(&dl, 7), 0);
+    eve_dlist_word(&dl, DL_CLEAR_RGB(1, 2, 3));
+    eve_dlist_word(&dl, DL_CLEAR);
+    CHECK_EQ(eve_dlist_mark(&dl, 8), 1);
+    eve_dlist_word(&dl, CMD_TEXT);
+    eve_dlist_params16(&dl, p16, 4);
+    eve_dlist_string(&dl, "Hi");
+    CHECK_EQ(eve_dlist_mark(&dl, 7), -1);
+    eve_dlist_word(&dl, DL_DISPLAY);
+    eve_dlist_word(&dl, CMD_SWAP);
+    CHECK_EQ(dl.seg[0].len, 8);
+    CHECK_EQ(dl.seg[1].len, 16);
+    CHECK_EQ(eve_dlist_count(dl.buf, dl.len), 6);
+
+    // replacing the segment moves the rest of the list
+    slen = 0;
+    put(CMD_TEXT); put(XY(1, 2)); put(XY(28, 0));
+    put_bytes("Longer text\0", 12);
+    CHECK_EQ(eve_dlist_replace(&dl, eve_dlist_find(&dl, 8), stream, slen), 0);
+    CHECK_EQ(dl.seg[1].len, 24);
+    CHECK_EQ(eve_dlist_count(dl.buf, dl.len), 6);
+    CHECK_EQ(eve_dlist_replace(&dl, 1, stream, 5), -1);
+
+    // the cached segment is replaced by CMD_APPEND
+    CHECK_EQ(eve_dlist_cache(&dl, 0, 0x4000, 8), 0);
+    CHECK(dl.seg[0].cached);
+    CHECK_EQ(dl.seg[1].start, 16);
+    eve_dlist_item_t item;
+    uint32_t pos = 4;
+    CHECK_EQ(eve_dlist_next(dl.buf, dl.len, &pos, &item), 1);
+    CHECK_EQ(item.cmd, EVE_DLIST_CMD_APPEND);
+    CHECK_EQ(item.params[0], 0x4000);
+    CHECK_EQ(item.params[1], 8);
+    CHECK_EQ(eve_dlist_count(dl.buf, dl.len), 5);
+
+    // overflow
+    while (eve_dlist_word(&dl, DL_DISPLAY) == 0);
+    CHECK_EQ(dl.len, sizeof(buf));
+    CHECK(dl.overflow);
+    CHECK_EQ(eve_dlist_string(&dl, "x"), -1);
+}
+
+int main(void) {
+    test_decode();
+    test_errors();
+    test_builder();
+    return test_result("eve_dlist");
+}
@@ -0,0 +1,218 @@
+/*
+ * This file is part of the MicroPython ESP32 project, https://github.com/loboris/MicroPython_ESP32_psRAM_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+// Pixel exact test of extmod/framebuf_blit.c against a per pixel reference
+// (the getpixel/setpixel loop of the original FrameBuffer.blit)
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "test.h"
+#include "framebuf_blit.h"
+
+static void setpx(const fb_surface_t *fb, int x, int y, uint32_t col) {
+    uint8_t *b = fb->buf;
+    switch (fb->format) {
+        case FRAMEBUF_MVLSB: {
+            size_t i = (y >> 3) * fb->stride + x;
+            int o = y & 7;
+            b[i] = (b[i] & ~(1 << o)) | ((col != 0) << o);
+            break;
+        }
+        case FRAMEBUF_MHLSB:
+        case FRAMEBUF_MHMSB: {
+            size_t i = (x + y * fb->stride) >> 3;
+            int o = (fb->format == FRAMEBUF_MHMSB) ? x & 7 : 7 - (x & 7);
+            b[i] = (b[i] & ~(1 << o)) | ((col != 0) << o);
+            break;
+        }
+        case FRAMEBUF_RGB565:
+            ((uint16_t *)b)[x + y * fb->stride] = col;
+            break;
+        case FRAMEBUF_GS2_HMSB: {
+            uint8_t *p = &b[(x + y * fb->stride) >> 2];
+            int sh = (x & 3) << 1;
+            *p = ((col & 3) << sh) | (*p & ~(3 << sh));
+            break;
+        }
+        case FRAMEBUF_GS4_HMSB: {
+            uint8_t *p = &b[(x + y * fb->stride) >> 1];
+            if (x % 2) *p = (col & 0x0f) | (*p & 0xf0);
+            else *p = ((uint8_t)col << 4) | (*p & 0x0f);
+            break;
+        }
+        case FRAMEBUF_GS8:
+            b[x + y * fb->stride] = col;
+            break;
+        case FRAMEBUF_RGB888: {
+            uint8_t *p = &b[(x + y * fb->stride) * 3];
+            p[0] = col >> 16;
+            p[1] = col >> 8;
+            p[2] = col;
+            break;
+        }
+    }
+}
+
+static uint32_t getpx(const fb_surface_t *fb, int x, int y) {
+    uint8_t *b = fb->buf;
+    switch (fb->format) {
+        case FRAMEBUF_MVLSB:
+            return (b[(y >> 3) * fb->stride + x] >> (y & 7)) & 1;
+        case FRAMEBUF_MHLSB:
+        case FRAMEBUF_MHMSB: {
+            int o = (fb->format == FRAMEBUF_MHMSB) ? x & 7 : 7 - (x & 7);
+            return (b[(x + y * fb->stride) >> 3] >> o) & 1;
+        }
+        case FRAMEBUF_RGB565:
+            return ((uint16_t *)b)[x + y * fb->stride];
+        case FRAMEBUF_GS2_HMSB:
+            return (b[(x + y * fb->stride) >> 2] >> ((x & 3) << 1)) & 3;
+        case FRAMEBUF_GS4_HMSB:
+            return (x % 2) ? b[(x + y * fb->stride) >> 1] & 0x0f : b[(x + y * fb->stride) >> 1] >> 4;
+        case FRAMEBUF_GS8:
+            return b[x + y * fb->stride];
+        case FRAMEBUF_RGB888: {
+            uint8_t *p = &b[(x + y * fb->stride) * 3];
+            return (p[0] << 16) | (p[1] << 8) | p[2];
+        }
+    }
+    return 0;
+}
+
+static int is_mono(int f) {
+    return (f == FRAMEBUF_MVLSB) || (f == FRAMEBUF_MHLSB) || (f == FRAMEBUF_MHMSB);
+}
+
+static void ref_blit(const fb_surface_t *d, const fb_surface_t *s, const fb_surface_t *pal,
+                     int x, int y, int32_t key, int alpha, int scale, int convert) {
+    if (alpha <= 0) return;
+    int sf = (pal) ? pal->format : s->format;
+    if (!convert) sf = d->format;
+    for (int dy = 0; dy < d->height; dy++) {
+        for (int dx = 0; dx < d->width; dx++) {
+            int sx = dx - x, sy = dy - y;
+            if ((sx < 0) || (sy < 0) || (sx >= s->width * scale) || (sy >= s->height * scale)) continue;
+            uint32_t c = getpx(s, sx / scale, sy / scale);
+            if ((pal) && (c < (uint32_t)pal->width)) c = getpx(pal, c, 0);
+            if ((key >= 0) && (c == (uint32_t)key)) continue;
+            int same = (sf == d->format) || (is_mono(sf) && is_mono(d->format));
+            if (alpha < 255) {
+                uint32_t a = fb_color_to_rgb(sf, c), b = fb_color_to_rgb(d->format, getpx(d, dx, dy)), r = 0;
+                for (int sh = 0; sh < 24; sh += 8) {
+                    double v = ((((a >> sh) & 255) * alpha) + (((b >> sh) & 255) * (255 - alpha))) / 255.0;
+                    r |= ((uint32_t)(v + 0.5)) << sh;
+                }
+                c = fb_color_from_rgb(d->format, r);
+            }
+            else if (!same) c = fb_color_from_rgb(d->format, fb_color_to_rgb(sf, c));
+            setpx(d, dx, dy, c);
+        }
+    }
+}
+
+static size_t buf_size(int f, int stride, int h) {
+    if (f == FRAMEBUF_RGB565) return stride * h * 2;
+    if (f == FRAMEBUF_RGB888) return stride * h * 3;
+    if (f == FRAMEBUF_MVLSB) return stride * ((h + 7) / 8);
+    return stride * h;
+}
+
+static void make_surface(fb_surface_t *s, int f, int w, int h) {
+    int stride = w + rand() % 3;
+    if ((f == FRAMEBUF_MHLSB) || (f == FRAMEBUF_MHMSB)) stride = (stride + 7) & ~7;
+    else if (f == FRAMEBUF_GS2_HMSB) stride = (stride + 3) & ~3;
+    else if (f == FRAMEBUF_GS4_HMSB) stride = (stride + 1) & ~1;
+    s->format = f;
+    s->width = w;
+    s->height = h;
+    s->stride = stride;
+    size_t n = buf_size(f, stride, h);
+    s->buf = malloc(n + 1);
+    for (size_t i = 0; i < n; i++) s->buf[i] = rand();
+}
+
+// random blits, all format pairs, clipping, key, alpha, scale, palette, with and without conversion
+static void test_random(void) {
+    for (int iter = 0; iter < 20000; iter++) {
+        fb_surface_t s, d1, d2, pal;
+        int sf = rand() % FRAMEBUF_FORMATS, df = rand() % FRAMEBUF_FORMATS;
+        make_surface(&s, sf, 1 + rand() % 40, 1 + rand() % 20);
+        make_surface(&d1, df, 1 + rand() % 70, 1 + rand() % 30);
+        int use_pal = (rand() % 4 == 0);
+        if (use_pal) make_surface(&pal, rand() % FRAMEBUF_FORMATS, 1 + rand() % 8, 1);
+        d2 = d1;
+        size_t n = buf_size(df, d1.stride, d1.height);
+        d2.buf = malloc(n + 1);
+        memcpy(d2.buf, d1.buf, n);
+
+        int scale = (rand() % 2) ? 1 : 1 + rand() % 3;
+        int x = rand() % (d1.width + 20) - 10 - s.width;
+        int y = rand() % (d1.height + 10) - 5 - s.height / 2;
+        int32_t key = -1;
+        if (rand() % 3 == 0) {
+            key = getpx(&s, rand() % s.width, rand() % s.height);
+            if ((use_pal) && (key < pal.width)) key = getpx(&pal, key, 0);
+        }
+        int alpha = (rand() % 3) ? 255 : rand() % 300 - 20;
+        int convert = rand() % 2;
+
+        fb_blit(&d1, &s, (use_pal) ? &pal : NULL, x, y, key, alpha, scale, convert);
+        ref_blit(&d2, &s, (use_pal) ? &pal : NULL, x, y, key, alpha, scale, convert);
+        if (memcmp(d1.buf, d2.buf, n) != 0) {
+            printf("blit differs: src %d dst %d pal %d x %d y %d key %d alpha %d scale %d convert %d\n",
+                sf, df, (use_pal) ? pal.format : -1, x, y, key, alpha, scale, convert);
+            test_failed++;
+        }
+        free(s.buf);
+        free(d1.buf);
+        free(d2.buf);
+        if (use_pal) free(pal.buf);
+        if (test_failed > 10) break;
+    }
+}
+
+// a MONO sprite blitted to RGB565 keeps its raw values unless converted
+static void test_raw_values(void) {
+    uint8_t sbuf[1] = {0x80};
+    uint16_t dbuf[8];
+    fb_surface_t s = {sbuf, 8, 1, 8, FRAMEBUF_MHLSB};
+    fb_surface_t d = {(uint8_t *)dbuf, 8, 1, 8, FRAMEBUF_RGB565};
+    memset(dbuf, 0x55, sizeof(dbuf));
+    fb_blit(&d, &s, NULL, 0, 0, -1, 255, 1, 0);
+    CHECK_EQ(dbuf[0], 1);
+    CHECK_EQ(dbuf[1], 0);
+    fb_blit(&d, &s, NULL, 0, 0, -1, 255, 1, 1);
+    CHECK_EQ(dbuf[0], 0xffff);
+    CHECK_EQ(dbuf[1], 0);
+}
+
+int main(void) {
+    srand(59);
+    test_raw_values();
+    test_random();
+    return test_result("framebuf_blit");
+}
@@ -0,0 +1,294 @@
+/*
+ * This file is part of the MicroPython ESP32 project, https://github.com/loboris/MicroPython_ESP32_psRAM_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+// Test of the multi-area heap of py/gc.c on the stub port: placement of the
+// allocations by size and by hint, fallback to the other area when the
+// preferred one is full, the sweep and the finalisers of both areas and
+// the per area statistics
+
+#include <string.h>
+
+#include "test.h"
+#include "py/gc.h"
+#include "py/runtime.h"
+
+#define SLOW_SIZE (8 * 1024)
+#define FAST_SIZE (2 * 1024)
+
+static uintptr_t slow_heap[SLOW_SIZE / sizeof(uintptr_t)];
+static uintptr_t fast_heap[FAST_SIZE / sizeof(uintptr_t)];
+
+qstr port_qstr_del = 0;
+static const char *const qstr_names[] = {"__del__", "gc"};
+
+const mp_print_t mp_plat_print = {NULL, NULL};
+const mp_obj_type_t mp_type_tuple = {"tuple"}, mp_type_list = {"list"}, mp_type_dict = {"dict"};
+const mp_obj_type_t mp_type_str = {"str"}, mp_type_bytes = {"bytes"};
+const mp_obj_type_t mp_type_fun_bc = {"function"}, mp_type_module = {"module"};
+
+// objects of this type have a __del__ method which records the object
+static const mp_obj_type_t fin_type = {"fin"};
+static const mp_obj_type_t fin_del = {"__del__"};
+
+static void *finalised[64];
+static size_t n_finalised;
+
+void mp_load_method_maybe(mp_obj_t base, qstr attr, mp_obj_t *dest) {
+    const mp_obj_base_t *obj = base;
+    dest[0] = MP_OBJ_NULL;
+    if ((attr == MP_QSTR___del__) && (obj->type == &fin_type)) {
+        dest[0] = (mp_obj_t)&fin_del;
+        dest[1] = base;
+    }
+}
+
+mp_obj_t mp_call_function_1_protected(mp_obj_t fun, mp_obj_t arg) {
+    if ((fun == &fin_del) && (n_finalised < MP_ARRAY_SIZE(finalised))) {
+        finalised[n_finalised++] = arg;
+    }
+    return MP_OBJ_NULL;
+}
+
+static bool was_finalised(void *p) {
+    for (size_t i = 0; i < n_finalised; i++) {
+        if (finalised[i] == p) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// the roots are the port_roots set by the test, the C stack is not scanned
+void gc_collect(int flag) {
+    gc_collect_start();
+    gc_collect_end();
+}
+
+static bool in_slow(const void *p) {
+    return ((const byte*)p >= (const byte*)slow_heap) && ((const byte*)p < (const byte*)slow_heap + SLOW_SIZE);
+}
+
+static bool in_fast(const void *p) {
+    return ((const byte*)p >= (const byte*)fast_heap) && ((const byte*)p < (const byte*)fast_heap + FAST_SIZE);
+}
+
+// area 0 is the slow heap, area 1 the fast heap
+static void heap_init(void) {
+    memset(&mp_state_ctx, 0, sizeof(mp_state_ctx));
+    gc_init(slow_heap, (byte*)slow_heap + SLOW_SIZE);
+    gc_set_area(0, 0, 4);
+    CHECK(gc_add_area(fast_heap, (byte*)fast_heap + FAST_SIZE, GC_AREA_FAST, 1));
+    n_finalised = 0;
+}
+
+static gc_area_info_t area_info(size_t n) {
+    gc_area_info_t info;
+    memset(&info, 0, sizeof(info));
+    CHECK(gc_area_info(n, &info));
+    return info;
+}
+
+static void test_placement(void) {
+    heap_init();
+    CHECK_EQ(gc_area_count(), 2);
+    CHECK_EQ(gc_fast_limit((size_t)-1), MICROPY_GC_FAST_MAX_BYTES);
+
+    // by size
+    CHECK(in_fast(gc_alloc(16, false)));
+    CHECK(in_fast(gc_alloc(MICROPY_GC_FAST_MAX_BYTES, false)));
+    CHECK(in_slow(gc_alloc(MICROPY_GC_FAST_MAX_BYTES + 1, false)));
+
+    // by hint
+    CHECK(in_fast(gc_alloc_place(512, false, GC_PLACE_FAST)));
+    CHECK(in_slow(gc_alloc_place(16, false, GC_PLACE_SLOW)));
+    CHECK(in_fast(gc_alloc_place(16, true, GC_PLACE_AUTO)));
+
+    // the limit of the automatic placement
+    CHECK_EQ(gc_fast_limit(32), MICROPY_GC_FAST_MAX_BYTES);
+    CHECK(in_fast(gc_alloc(32, false)));
+    CHECK(in_slow(gc_alloc(33, false)));
+    CHECK_EQ(gc_fast_limit(MICROPY_GC_FAST_MAX_BYTES), 32);
+
+    // zero size and locked heap
+    CHECK(gc_alloc_place(0, false, GC_PLACE_FAST) == NULL);
+    gc_lock();
+    CHECK(gc_alloc(16, false) == NULL);
+    gc_unlock();
+
+    gc_area_info_t slow = area_info(0), fast = area_info(1);
+    CHECK_EQ(slow.n_alloc, 3);
+    CHECK_EQ(fast.n_alloc, 5);
+    CHECK_EQ(slow.n_fallback, 0);
+    CHECK_EQ(fast.n_fallback, 0);
+}
+
+static void test_fallback(void) {
+    heap_init();
+
+    // fill the fast area with small allocations, the next one goes to the slow area
+    size_t n = 0;
+    void *p;
+    while (in_fast(p = gc_alloc(BYTES_PER_WORD, false))) {
+        n++;
+    }
+    CHECK(in_slow(p));
+    gc_area_info_t fast = area_info(1), slow = area_info(0);
+    CHECK_EQ(fast.n_alloc, n);
+    CHECK_EQ(fast.info.free, 0);
+    CHECK_EQ(fast.info.used, n * MICROPY_BYTES_PER_GC_BLOCK);
+    CHECK_EQ(slow.n_alloc, 1);
+    CHECK_EQ(slow.n_fallback, 1);
+    // the explicit hint falls back too
+    CHECK(in_slow(gc_alloc_place(16, false, GC_PLACE_FAST)));
+    CHECK_EQ(area_info(0).n_fallback, 2);
+
+    // large allocation with no room in the slow area goes to the fast area
+    heap_init();
+    CHECK(in_slow(p = gc_alloc(area_info(0).info.max_free * MICROPY_BYTES_PER_GC_BLOCK, false)));
+    CHECK_EQ(area_info(0).info.free, 0);
+    CHECK(in_fast(p = gc_alloc(MICROPY_GC_FAST_MAX_BYTES + 1, false)));
+    fast = area_info(1);
+    CHECK_EQ(fast.n_alloc, 1);
+    CHECK_EQ(fast.n_fallback, 1);
+
+    // no room in any area: collected, nothing is rooted so only the new
+    // allocation is left
+    CHECK(in_slow(p = gc_alloc(FAST_SIZE, false)));
+    CHECK_EQ(area_info(0).info.used + area_info(1).info.used, FAST_SIZE);
+}
+
+static void test_sweep(void) {
+    heap_init();
+
+    // finalised objects in both areas, a holder in the slow area points
+    // to the kept objects, so the marking crosses the areas
+    mp_obj_base_t *obj[8];
+    for (size_t i = 0; i < MP_ARRAY_SIZE(obj); i++) {
+        obj[i] = gc_alloc_place(3 * BYTES_PER_WORD, true, (i & 1) ? GC_PLACE_SLOW : GC_PLACE_FAST);
+        CHECK((i & 1) ? in_slow(obj[i]) : in_fast(obj[i]));
+        obj[i]->type = &fin_type;
+    }
+    // a finaliser object with no type is not finalised
+    mp_obj_base_t *untyped = gc_alloc_place(16, true, GC_PLACE_FAST);
+    void **holder = gc_alloc_place(64 * BYTES_PER_WORD, false, GC_PLACE_SLOW);
+    void *chunk = gc_alloc_place(64, false, GC_PLACE_FAST);
+    CHECK(in_slow(holder));
+    holder[10] = obj[0];
+    holder[20] = obj[1];
+    holder[63] = chunk;
+    MP_STATE_VM(port_roots)[0] = holder;
+    MP_STATE_VM(port_roots)[7] = obj[2];
+    // an interior pointer doesn't keep the object
+    MP_STATE_VM(port_roots)[3] = (byte*)obj[3] + BYTES_PER_WORD;
+
+    size_t fast_used = area_info(1).info.used;
+    size_t slow_used = area_info(0).info.used;
+    gc_collect(0);
+
+    CHECK_EQ(n_finalised, 5);
+    for (size_t i = 0; i < MP_ARRAY_SIZE(obj); i++) {
+        bool kept = (i < 3);
+        CHECK_EQ(was_finalised(obj[i]), !kept);
+        CHECK_EQ(gc_nbytes(obj[i]), kept ? MICROPY_BYTES_PER_GC_BLOCK : 0);
+    }
+    CHECK(!was_finalised(untyped));
+    CHECK_EQ(gc_nbytes(untyped), 0);
+    CHECK_EQ(gc_nbytes(chunk), 64);
+    CHECK_EQ(MP_STATE_MEM(gc_collected), 6);
+    CHECK_EQ(area_info(1).info.used, fast_used - 3 * MICROPY_BYTES_PER_GC_BLOCK);
+    CHECK_EQ(area_info(0).info.used, slow_used - 3 * MICROPY_BYTES_PER_GC_BLOCK);
+
+    // the kept objects keep their finaliser, the freed blocks are reused
+    // without it
+    MP_STATE_VM(port_roots)[0] = NULL;
+    MP_STATE_VM(port_roots)[3] = NULL;
+    void *reused = gc_alloc_place(16, false, GC_PLACE_FAST);
+    CHECK(reused == obj[4] || reused == obj[6] || reused == untyped);
+    gc_collect(0);
+    CHECK_EQ(n_finalised, 7);
+    CHECK(was_finalised(obj[0]));
+    CHECK(was_finalised(obj[1]));
+    CHECK(!was_finalised(obj[2]));
+    CHECK_EQ(gc_nbytes(holder), 0);
+    CHECK_EQ(gc_nbytes(chunk), 0);
+}
+
+static void test_area_info(void) {
+    heap_init();
+    gc_area_info_t info;
+    CHECK(!gc_area_info(2, &info));
+    CHECK(!gc_area_info((size_t)-1, &info));
+
+    gc_area_info_t slow = area_info(0), fast = area_info(1);
+    CHECK_EQ(slow.flags, 0);
+    CHECK_EQ(slow.cost, 4);
+    CHECK_EQ(fast.flags, GC_AREA_FAST);
+    CHECK_EQ(fast.cost, 1);
+    CHECK(in_slow(slow.start));
+    CHECK(in_fast(fast.start));
+    CHECK(slow.info.total <= SLOW_SIZE && slow.info.total > SLOW_SIZE * 9 / 10);
+    CHECK(fast.info.total <= FAST_SIZE && fast.info.total > FAST_SIZE * 9 / 10);
+    CHECK_EQ(slow.info.used, 0);
+    CHECK_EQ(fast.info.free, fast.info.total);
+
+    // gc_info() sums the areas
+    gc_info_t all;
+    gc_alloc(100, false);
+    gc_info(&all);
+    CHECK_EQ(all.total, slow.info.total + fast.info.total);
+    CHECK_EQ(all.used, area_info(1).info.used);
+    CHECK_EQ(all.used, 4 * MICROPY_BYTES_PER_GC_BLOCK);
+
+    // the words scanned by the collection are counted in the area of the block
+    void **holder = gc_alloc_place(8 * BYTES_PER_WORD, false, GC_PLACE_SLOW);
+    MP_STATE_VM(port_roots)[0] = holder;
+    gc_collect(0);
+    CHECK_EQ(area_info(0).scan_words, 8);
+    CHECK_EQ(area_info(1).scan_words, 0);
+    MP_STATE_VM(port_roots)[0] = NULL;
+
+    // the fast area swapped, the placement follows the flags
+    gc_set_area(0, GC_AREA_FAST, 1);
+    gc_set_area(1, 0, 4);
+    gc_set_area(2, GC_AREA_FAST, 1);
+    CHECK_EQ(area_info(0).flags, GC_AREA_FAST);
+    CHECK(in_slow(gc_alloc(16, false)));
+    CHECK(in_fast(gc_alloc(512, false)));
+
+    // no more areas than MICROPY_GC_MAX_AREAS
+    static uintptr_t extra[256];
+    CHECK(!gc_add_area(extra, (byte*)extra + sizeof(extra), 0, 1));
+    CHECK_EQ(gc_area_count(), 2);
+}
+
+int main(void) {
+    port_qstr_names = qstr_names;
+    test_placement();
+    test_fallback();
+    test_sweep();
+    test_area_info();
+    return test_result("gc_areas");
+}
@@ -0,0 +1,238 @@
+/*
+ * This file is part of the MicroPython ESP32 project, https://github.com/loboris/MicroPython_ESP32_psRAM_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+// Unit test of libnmea/src/nmea/nmea_stream.c using NMEA logs of a
+// multi-constellation receiver at 10 Hz:
+//  data/nmea_gnss_10hz.log: NMEA 4.10, GSA with system id, GSV with signal id
+//  data/nmea_gn23_10hz.log: NMEA 2.3, GN talker GSA without system id
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "test.h"
+#include "nmea_stream.h"
+
+#define CHECK_NEAR(a, b, eps) CHECK(fabs((double)(a) - (double)(b)) < (eps))
+
+static uint8_t *load(const char *name, size_t *len) {
+    FILE *f = fopen(name, "rb");
+    if (f == NULL) {
+        printf("can't open %s\n", name);
+        exit(1);
+    }
+    fseek(f, 0, SEEK_END);
+    *len = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t *buf = malloc(*len);
+    if (fread(buf, 1, *len, f) != *len) *len = 0;
+    fclose(f);
+    return buf;
+}
+
+static int count_lines(const uint8_t *buf, size_t len, const char *prefix) {
+    int n = 0;
+    for (size_t i = 0; i < len; i++) {
+        if ((buf[i] == '$') && (strncmp((const char *)buf + i, prefix, strlen(prefix)) == 0)) n++;
+    }
+    return n;
+}
+
+// values of the last epoch in both logs
+static void check_last_epoch(gps_data_t *d) {
+    CHECK_NEAR(d->latitude, 46.0513335, 1e-5);
+    CHECK_NEAR(d->longitude, 14.5069276, 1e-5);
+    CHECK_NEAR(d->altitude, 295.4, 1e-3);
+    CHECK_NEAR(d->geoid_sep, 45.6, 1e-3);
+    CHECK_NEAR(d->speed, 5.4, 1e-3);
+    CHECK_NEAR(d->course, 45.0, 1e-3);
+    CHECK_NEAR(d->dop, 0.92, 1e-3);
+    CHECK_NEAR(d->pdop, 1.65, 1e-3);
+    CHECK_NEAR(d->vdop, 1.37, 1e-3);
+    CHECK_EQ(d->quality, 1);
+    CHECK_EQ(d->nsat, 17);
+    CHECK_EQ(d->fix_type, 3);
+    CHECK_EQ(d->valid, 1);
+    CHECK_EQ(d->datetime.tm_year, 118);
+    CHECK_EQ(d->datetime.tm_mon, 2);
+    CHECK_EQ(d->datetime.tm_mday, 17);
+    CHECK_EQ(d->datetime.tm_hour, 12);
+    CHECK_EQ(d->datetime.tm_min, 35);
+    CHECK_EQ(d->datetime.tm_sec, 9);
+    CHECK_NEAR(d->rms, 12.0, 1e-3);
+    CHECK_NEAR(d->sd_major, 1.8, 1e-3);
+    CHECK_NEAR(d->sd_minor, 1.2, 1e-3);
+    CHECK_NEAR(d->orient, 67.5, 1e-3);
+    CHECK_NEAR(d->lat_sd, 1.4, 1e-3);
+    CHECK_NEAR(d->lon_sd, 1.6, 1e-3);
+    CHECK_NEAR(d->alt_sd, 2.9, 1e-3);
+    CHECK_EQ(d->updated, (1 << NMEA_GGA) | (1 << NMEA_GLL) | (1 << NMEA_RMC) | (1 << NMEA_GST) |
+        (1 << NMEA_VTG) | (1 << NMEA_GSA) | (1 << NMEA_GSV));
+}
+
+// Feed the log in chunks of 1..max_chunk bytes
+static void feed(nmea_stream_t *st, const uint8_t *buf, size_t len, int max_chunk) {
+    size_t pos = 0;
+    while (pos < len) {
+        size_t n = 1 + rand() % max_chunk;
+        if (n > len - pos) n = len - pos;
+        nmea_stream_feed(st, buf + pos, n);
+        pos += n;
+    }
+}
+
+static void test_nmea410(void) {
+    size_t len;
+    uint8_t *log = load("data/nmea_gnss_10hz.log", &len);
+    int lines = count_lines(log, len, "$");
+    int txt = count_lines(log, len, "$GPTXT");
+
+    for (int max_chunk = 1; max_chunk <= 256; max_chunk *= 4) {
+        gps_data_t d;
+        nmea_stream_t st;
+        memset(&d, 0, sizeof(d));
+        nmea_stream_init(&st, &d, 1);
+        feed(&st, log, len, max_chunk);
+
+        CHECK_EQ(st.sentences, lines - txt);
+        CHECK_EQ(st.ignored, txt);
+        CHECK_EQ(st.chk_errors, 0);
+        CHECK_EQ(st.errors, 0);
+        check_last_epoch(&d);
+
+        // GSA per system
+        CHECK_EQ(d.n_used[NMEA_SYSTEM_GPS], 8);
+        CHECK_EQ(d.n_used[NMEA_SYSTEM_GLONASS], 5);
+        CHECK_EQ(d.n_used[NMEA_SYSTEM_GALILEO], 4);
+        CHECK_EQ(d.n_used[NMEA_SYSTEM_BEIDOU], 0);
+        CHECK_EQ(d.n_used_unknown, 0);
+        CHECK_EQ(d.used[NMEA_SYSTEM_GLONASS][4], 80);
+        CHECK_EQ(d.used[NMEA_SYSTEM_GALILEO][0], 3);
+
+        // GSV, the trailing signal id is not a satellite
+        CHECK_EQ(d.in_view[NMEA_SYSTEM_GPS], 10);
+        CHECK_EQ(d.n_sats[NMEA_SYSTEM_GPS], 10);
+        CHECK_EQ(d.n_sats[NMEA_SYSTEM_GLONASS], 7);
+        CHECK_EQ(d.n_sats[NMEA_SYSTEM_GALILEO], 6);
+        CHECK_EQ(d.n_sats[NMEA_SYSTEM_BEIDOU], 0);
+        nmea_sat_t *s = &d.sats[NMEA_SYSTEM_GPS][9];
+        CHECK_EQ(s->prn, 29);
+        CHECK_EQ(s->elevation, 57);
+        CHECK_EQ(s->azimuth, 11);
+        CHECK_EQ(s->snr, 24);
+        CHECK_EQ(d.sats[NMEA_SYSTEM_GPS][1].snr, -1);
+        CHECK_EQ(d.sats[NMEA_SYSTEM_GLONASS][6].prn, 81);
+    }
+    free(log);
+}
+
+static void test_nmea23(void) {
+    size_t len;
+    uint8_t *log = load("data/nmea_gn23_10hz.log", &len);
+    gps_data_t d;
+    nmea_stream_t st;
+    memset(&d, 0, sizeof(d));
+    nmea_stream_init(&st, &d, 1);
+
+    // feed line by line, check the type returned for each sentence
+    int lines = 0, epochs = 0;
+    size_t start = 0;
+    for (size_t i = 0; i < len; i++) {
+        if (log[i] != '\n') continue;
+        uint32_t mask = nmea_stream_feed(&st, log + start, i + 1 - start);
+        const char *type = (const char *)log + start + 3;
+        if (strncmp(type, "GGA", 3) == 0) {
+            CHECK_EQ(mask, 1 << NMEA_GGA);
+            epochs++;
+        }
+        else if (strncmp(type, "GSA", 3) == 0) CHECK_EQ(mask, 1 << NMEA_GSA);
+        else if (strncmp(type, "TXT", 3) == 0) CHECK_EQ(mask, 0);
+        start = i + 1;
+        lines++;
+    }
+    CHECK_EQ(lines, count_lines(log, len, "$"));
+    CHECK_EQ(epochs, 100);
+    CHECK_EQ(st.chk_errors, 0);
+    CHECK_EQ(st.errors, 0);
+    check_last_epoch(&d);
+
+    // the system of a GN talker GSA without system id is not known
+    for (int sys = 0; sys < NMEA_SYSTEMS; sys++) CHECK_EQ(d.n_used[sys], 0);
+    CHECK_EQ(d.n_used_unknown, 5);
+    CHECK_EQ(d.used_unknown[0], 65);
+    CHECK_EQ(d.n_sats[NMEA_SYSTEM_GPS], 10);
+    CHECK_EQ(d.n_sats[NMEA_SYSTEM_GLONASS], 7);
+    CHECK_EQ(d.n_sats[NMEA_SYSTEM_GALILEO], 0);
+    free(log);
+}
+
+// Damaged data: bad checksums, lost bytes, noise
+static void test_errors(void) {
+    size_t len;
+    uint8_t *log = load("data/nmea_gnss_10hz.log", &len);
+    gps_data_t d;
+    nmea_stream_t st;
+    memset(&d, 0, sizeof(d));
+    nmea_stream_init(&st, &d, 1);
+
+    // change one character in 20 sentences: the checksum doesn't match
+    int changed = 0;
+    for (size_t i = 0; (i < len) && (changed < 20); i += 1000) {
+        while ((i < len) && (log[i] != ',')) i++;
+        log[i + 1] ^= 0x01;
+        changed++;
+    }
+    nmea_stream_feed(&st, log, len);
+    CHECK_EQ(st.chk_errors, 20);
+    CHECK_EQ(st.errors, 0);
+    check_last_epoch(&d);
+
+    // sentence cut by the next one
+    const char *cut = "$GNGGA,123510.00,4603.08";
+    nmea_stream_feed(&st, (const uint8_t *)cut, strlen(cut));
+    nmea_stream_feed(&st, log, 200);
+    CHECK_EQ(st.errors, 1);
+
+    // binary noise between sentences is skipped
+    uint8_t noise[64];
+    for (size_t i = 0; i < sizeof(noise); i++) noise[i] = (uint8_t)(i * 37 + 11) & 0x7f;
+    noise[7] = '$';
+    uint32_t sentences = st.sentences;
+    nmea_stream_feed(&st, noise, sizeof(noise));
+    CHECK_EQ(nmea_stream_feed(&st, (const uint8_t *)"\r\n", 2), 0);
+    nmea_stream_feed(&st, log, len);
+    CHECK(st.sentences > sentences);
+    check_last_epoch(&d);
+    free(log);
+}
+
+int main(void) {
+    srand(52);
+    test_nmea410();
+    test_nmea23();
+    test_errors();
+    return test_result("nmea_stream");
+}
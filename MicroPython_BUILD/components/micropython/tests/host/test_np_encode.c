@@ -0,0 +1,193 @@
+/*
+ * This file is part of the MicroPython ESP32 project, https://github.com/loboris/MicroPython_ESP32_psRAM_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+// Test of the Neopixel RMT encoder, esp32/libs/np_encode.c.
+// The expected RMT items are the values of the WS2812 and SK6812 timings used by
+// machine.Neopixel (50 ns ticks), the encoded bit stream is decoded back
+// from the high pulse widths and compared with the expected byte order.
+
+#include <string.h>
+
+#include "test.h"
+#include "np_encode.h"
+
+#define TICK_NS         50
+
+// WS2812: T1H 600, T1L 700, T0H 350, T0L 800, reset 2 * 30 us
+#define WS_MARK         0x000E800CUL
+#define WS_SPACE        0x00108007UL
+#define WS_RESET        0x02580258UL
+// SK6812: T1H 600, T1L 600, T0H 300, T0L 900
+#define SK_MARK         0x000C800CUL
+#define SK_SPACE        0x00128006UL
+
+static np_encoder_t enc;
+static uint32_t items[64];
+
+// Decode the RMT items to a string of bits, '?' if the item is not a high pulse followed by low
+static void decode(const uint32_t *it, int n, char *bits) {
+    for (int i = 0; i < n; i++) {
+        uint32_t high = it[i] & 0x7FFF, low = (it[i] >> 16) & 0x7FFF;
+        int ok = ((it[i] & 0x8000) != 0) && ((it[i] & 0x80000000) == 0) && (high > 0) && (low > 0);
+        bits[i] = (!ok) ? '?' : ((high * TICK_NS) > 500) ? '1' : '0';
+    }
+    bits[n] = '\0';
+}
+
+// High and low time of the RMT item in ns
+static uint32_t high_ns(uint32_t item) {
+    return (item & 0x7FFF) * TICK_NS;
+}
+
+static uint32_t low_ns(uint32_t item) {
+    return ((item >> 16) & 0x7FFF) * TICK_NS;
+}
+
+static void test_items(void) {
+    CHECK_EQ(np_rmt_item(1, 12, 0, 14), WS_MARK);
+    CHECK_EQ(np_rmt_item(1, 7, 0, 16), WS_SPACE);
+    CHECK_EQ(np_rmt_item(0, 600, 0, 600), WS_RESET);
+    CHECK_EQ(np_rmt_item(1, 12, 0, 12), SK_MARK);
+    CHECK_EQ(np_rmt_item(1, 6, 0, 18), SK_SPACE);
+    CHECK_EQ(np_rmt_item(3, 0x8001, 1, 0xFFFF), 0xFFFF8001UL);
+    CHECK(high_ns(WS_MARK) == 600 && low_ns(WS_MARK) == 700);
+    CHECK(high_ns(WS_SPACE) == 350 && low_ns(WS_SPACE) == 800);
+    CHECK(high_ns(SK_MARK) == 600 && low_ns(SK_MARK) == 600);
+    CHECK(high_ns(SK_SPACE) == 300 && low_ns(SK_SPACE) == 900);
+    CHECK_EQ(high_ns(WS_RESET) + low_ns(WS_RESET), 60000);
+
+    np_encode_init(&enc, WS_MARK, WS_SPACE, WS_RESET);
+    CHECK_EQ(enc.reset, WS_RESET);
+    for (int n = 0; n < 16; n++) {
+        for (int b = 0; b < 4; b++) {
+            CHECK_EQ(enc.nibble[n][b], (n & (8 >> b)) ? WS_MARK : WS_SPACE);
+        }
+    }
+}
+
+static void test_bits(void) {
+    char bits[65];
+    static const uint8_t bytes[3] = {0xA5, 0x01, 0x80};
+    np_encode_init(&enc, WS_MARK, WS_SPACE, WS_RESET);
+    np_encode_lut(&enc, 1.0, 255);
+    np_encode_bytes(&enc, bytes, items, 3);
+    decode(items, 24, bits);
+    CHECK(strcmp(bits, "101001010000000110000000") == 0);
+    CHECK_EQ(items[0], WS_MARK);
+    CHECK_EQ(items[1], WS_SPACE);
+
+    np_encode_init(&enc, SK_MARK, SK_SPACE, WS_RESET);
+    np_encode_bytes(&enc, bytes, items, 1);
+    decode(items, 8, bits);
+    CHECK(strcmp(bits, "10100101") == 0);
+    CHECK_EQ(items[2], SK_MARK);
+    CHECK_EQ(items[3], SK_SPACE);
+}
+
+static void test_order(void) {
+    uint8_t map[4], dev[12];
+    char bits[65];
+    // pure red, pure green, blue + white
+    static const uint8_t rgb[6] = {0xFF, 0x00, 0x00, 0x00, 0xFF, 0x00};
+    static const uint8_t rgbw[8] = {0x00, 0x00, 0x0F, 0xF0, 0x01, 0x02, 0x03, 0x04};
+
+    CHECK_EQ(np_order_map("RGB", 3, map), 0);
+    np_reorder(dev, rgb, 2, 3, map);
+    CHECK(memcmp(dev, rgb, 6) == 0);
+
+    CHECK_EQ(np_order_map("GRB", 3, map), 0);
+    CHECK(map[0] == 1 && map[1] == 0 && map[2] == 2);
+    np_reorder(dev, rgb, 2, 3, map);
+    static const uint8_t grb[6] = {0x00, 0xFF, 0x00, 0xFF, 0x00, 0x00};
+    CHECK(memcmp(dev, grb, 6) == 0);
+
+    // the whole red pixel on the wire, green byte first
+    np_encode_init(&enc, WS_MARK, WS_SPACE, WS_RESET);
+    np_encode_lut(&enc, 1.0, 255);
+    np_encode_bytes(&enc, dev, items, 3);
+    decode(items, 24, bits);
+    CHECK(strcmp(bits, "000000001111111100000000") == 0);
+
+    CHECK_EQ(np_order_map("GRBW", 4, map), 0);
+    np_reorder(dev, rgbw, 2, 4, map);
+    static const uint8_t grbw[8] = {0x00, 0x00, 0x0F, 0xF0, 0x02, 0x01, 0x03, 0x04};
+    CHECK(memcmp(dev, grbw, 8) == 0);
+    np_encode_init(&enc, SK_MARK, SK_SPACE, WS_RESET);
+    np_encode_bytes(&enc, dev, items, 4);
+    decode(items, 32, bits);
+    CHECK(strcmp(bits, "00000000000000000000111111110000") == 0);
+
+    CHECK_EQ(np_order_map("WBGR", 4, map), 0);
+    np_reorder(dev, rgbw + 4, 1, 4, map);
+    CHECK(dev[0] == 4 && dev[1] == 3 && dev[2] == 2 && dev[3] == 1);
+
+    CHECK_EQ(np_order_map("RGBW", 3, map), 0);
+    CHECK_EQ(np_order_map("RGW", 3, map), -1);
+    CHECK_EQ(np_order_map("RG", 3, map), -1);
+    CHECK_EQ(np_order_map("RGBX", 4, map), -1);
+    CHECK_EQ(np_order_map("RGB", 2, map), -1);
+}
+
+static void test_lut(void) {
+    char bits[9];
+    uint8_t v = 0xFF;
+    memset(&enc, 0, sizeof(enc));
+    np_encode_init(&enc, WS_MARK, WS_SPACE, WS_RESET);
+    np_encode_lut(&enc, 1.0, 128);
+    CHECK_EQ(enc.lut[255], 128);
+    CHECK_EQ(enc.lut[100], 50);
+    np_encode_bytes(&enc, &v, items, 1);
+    decode(items, 8, bits);
+    CHECK(strcmp(bits, "10000000") == 0);
+
+    // the table is rebuilt only when gamma or brightness changes
+    enc.lut[1] = 77;
+    np_encode_lut(&enc, 1.0, 128);
+    CHECK_EQ(enc.lut[1], 77);
+    np_encode_lut(&enc, 2.2, 255);
+    CHECK_EQ(enc.lut[0], 0);
+    CHECK_EQ(enc.lut[1], 0);
+    CHECK_EQ(enc.lut[128], 56);
+    CHECK_EQ(enc.lut[255], 255);
+}
+
+static void test_hsv(void) {
+    CHECK_EQ(np_hsv_to_rgb(0, 255, 255), 0xFF0000);
+    CHECK_EQ(np_hsv_to_rgb(512, 255, 255), 0x00FF00);
+    CHECK_EQ(np_hsv_to_rgb(1024, 255, 255), 0x0000FF);
+    CHECK_EQ(np_hsv_to_rgb(1536 + 256, 255, 255), np_hsv_to_rgb(256, 255, 255));
+    CHECK_EQ(np_hsv_to_rgb(300, 0, 200), 0xC8C8C8);
+    CHECK_EQ(np_hsv_to_rgb(700, 255, 0), 0);
+}
+
+int main(void) {
+    test_items();
+    test_bits();
+    test_order();
+    test_lut();
+    test_hsv();
+    return test_result("np_encode");
+}
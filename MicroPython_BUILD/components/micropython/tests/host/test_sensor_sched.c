@@ -0,0 +1,282 @@
+/*
+ * This file is part of the MicroPython ESP32 project, https://github.com/loboris/MicroPython_ESP32_psRAM_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+// Test of esp32/libs/sensor_sched.c on a simulated bus with a virtual clock.
+// A simulated device starts its conversion when its start command is executed
+// and returns its value only when read after the conversion time, so the test
+// can check that the devices are read as soon as, but not before, they are ready.
+
+#include <string.h>
+
+#include "test.h"
+#include "sensor_sched.h"
+
+#define XFER_US     (100)   // duration of one executed transaction
+
+static uint64_t sim_now;
+
+static uint64_t sim_now_us(void) {
+    return sim_now;
+}
+
+static void sim_delay_us(uint32_t us) {
+    sim_now += us;
+}
+
+typedef struct _sim_dev_t {
+    uint32_t conv_us;
+    uint8_t value;
+    uint8_t fail_read;
+    uint64_t started;       // 0: no conversion started
+    int early_reads;        // reads before the conversion was completed
+} sim_dev_t;
+
+// the transactions of a batch are executed at 'end'
+typedef struct _sim_xfer_t {
+    sensor_dev_t *dev;
+    const uint8_t *wbuf;
+    uint8_t wlen;
+    uint8_t *rbuf;
+    uint8_t rlen;
+} sim_xfer_t;
+
+typedef struct _sim_bus_t {
+    int batching;           // the bus supports batches
+    int in_batch;
+    sim_xfer_t batch[16];
+    int nbatch;
+    int batches;
+    int broadcasts;
+    int fail_end;
+    int fail_broadcast;
+    sim_dev_t *bcast_devs[4];   // devices converting on the broadcast
+    int nbcast;
+} sim_bus_t;
+
+static int sim_exec(sim_xfer_t *x) {
+    sim_dev_t *sd = x->dev->dev;
+    sim_now += XFER_US;
+    if ((x->rlen == 0) && (x->wlen > 0) && (x->wbuf == x->dev->start)) {
+        sd->started = sim_now;
+        return 0;
+    }
+    if (sd->fail_read) return -2;
+    if ((sd->started == 0) || (sim_now < sd->started + sd->conv_us)) sd->early_reads++;
+    for (int i = 0; i < x->rlen; i++) x->rbuf[i] = sd->value + i;
+    sd->started = 0;
+    return 0;
+}
+
+static int sim_begin(void *b) {
+    sim_bus_t *bus = b;
+    if (!bus->batching) return -1;
+    bus->in_batch = 1;
+    bus->nbatch = 0;
+    return 0;
+}
+
+static int sim_xfer(void *b, sensor_dev_t *dev, const uint8_t *wbuf, uint8_t wlen, uint8_t *rbuf, uint8_t rlen) {
+    sim_bus_t *bus = b;
+    sim_xfer_t x = {dev, wbuf, wlen, rbuf, rlen};
+    if (bus->in_batch) {
+        bus->batch[bus->nbatch++] = x;
+        return 0;
+    }
+    return sim_exec(&x);
+}
+
+static int sim_end(void *b) {
+    sim_bus_t *bus = b;
+    int res = 0;
+    bus->in_batch = 0;
+    bus->batches++;
+    for (int i = 0; i < bus->nbatch; i++) {
+        if (sim_exec(&bus->batch[i]) != 0) res = -3;
+    }
+    return (bus->fail_end) ? -4 : res;
+}
+
+static int sim_broadcast(void *b) {
+    sim_bus_t *bus = b;
+    sim_now += XFER_US;
+    bus->broadcasts++;
+    if (bus->fail_broadcast) return -1;
+    for (int i = 0; i < bus->nbcast; i++) bus->bcast_devs[i]->started = sim_now;
+    return 0;
+}
+
+static const sensor_bus_ops_t sim_ops = {
+    .begin = sim_begin,
+    .xfer = sim_xfer,
+    .end = sim_end,
+    .broadcast = sim_broadcast,
+};
+
+static sensor_sched_t sched;
+static sensor_dev_t devs[8];
+static uint8_t result[64];
+
+static void setup(void) {
+    sim_now = 1000;
+    sensor_sched_init(&sched, devs, 8, sim_now_us, sim_delay_us);
+    memset(result, 0, sizeof(result));
+}
+
+static int add_dev(sim_bus_t *bus, sim_dev_t *sd, uint8_t read_len, uint8_t flags) {
+    sensor_dev_t t;
+    memset(&t, 0, sizeof(t));
+    t.ops = &sim_ops;
+    t.bus = bus;
+    t.dev = sd;
+    t.wait_us = sd->conv_us;
+    t.flags = flags;
+    if (!(flags & SENSOR_FLAG_BROADCAST)) {
+        t.start[0] = 0x30;
+        t.start_len = 1;
+    }
+    t.rcmd[0] = 0x10;
+    t.rcmd_len = 1;
+    t.read_len = read_len;
+    return sensor_sched_add(&sched, &t);
+}
+
+static void test_interleave(void) {
+    // two batched buses and a bus without batching, the cycle takes about the
+    // longest conversion time, not the sum of all of them
+    sim_bus_t i2c = {.batching = 1}, spi = {0};
+    sim_dev_t a = {.conv_us = 20000, .value = 0x10};
+    sim_dev_t b = {.conv_us = 5000, .value = 0x20};
+    sim_dev_t c = {.conv_us = 12000, .value = 0x30};
+    sim_dev_t d = {.conv_us = 5000, .value = 0x40};
+    setup();
+    CHECK_EQ(add_dev(&i2c, &a, 2, 0), 0);
+    CHECK_EQ(add_dev(&spi, &c, 3, 0), 2);
+    CHECK_EQ(add_dev(&i2c, &b, 1, 0), 5);
+    CHECK_EQ(add_dev(&i2c, &d, 2, 0), 6);
+    CHECK_EQ(sched.size, 8);
+
+    CHECK_EQ(sensor_sched_run(&sched, result), 0);
+    CHECK_EQ(a.early_reads + b.early_reads + c.early_reads + d.early_reads, 0);
+    static const uint8_t expected[8] = {0x10, 0x11, 0x30, 0x31, 0x32, 0x20, 0x40, 0x41};
+    CHECK(memcmp(result, expected, 8) == 0);
+    CHECK(sched.last_us < 20000 + 10 * XFER_US);
+    CHECK(sched.last_us >= 20000);
+    // i2c: one start batch and read batches for b+d together, then a
+    CHECK_EQ(i2c.batches, 3);
+    CHECK_EQ(sched.batches, 3);
+    CHECK_EQ(sched.cycles, 1);
+    CHECK_EQ(sched.errors, 0);
+
+    // the next cycle gives the same results
+    memset(result, 0, sizeof(result));
+    CHECK_EQ(sensor_sched_run(&sched, result), 0);
+    CHECK(memcmp(result, expected, 8) == 0);
+    CHECK_EQ(sched.cycles, 2);
+}
+
+static void test_broadcast(void) {
+    // the devices flagged for broadcast share one conversion start per bus
+    sim_bus_t ow1 = {0}, ow2 = {0};
+    sim_dev_t t1 = {.conv_us = 750000, .value = 1};
+    sim_dev_t t2 = {.conv_us = 750000, .value = 2};
+    sim_dev_t t3 = {.conv_us = 750000, .value = 3};
+    ow1.bcast_devs[0] = &t1;
+    ow1.bcast_devs[1] = &t2;
+    ow1.nbcast = 2;
+    ow2.bcast_devs[0] = &t3;
+    ow2.nbcast = 1;
+    setup();
+    add_dev(&ow1, &t1, 2, SENSOR_FLAG_BROADCAST);
+    add_dev(&ow1, &t2, 2, SENSOR_FLAG_BROADCAST);
+    add_dev(&ow2, &t3, 2, SENSOR_FLAG_BROADCAST);
+    CHECK_EQ(sensor_sched_run(&sched, result), 0);
+    CHECK_EQ(ow1.broadcasts, 1);
+    CHECK_EQ(ow2.broadcasts, 1);
+    CHECK_EQ(t1.early_reads + t2.early_reads + t3.early_reads, 0);
+    CHECK(result[0] == 1 && result[2] == 2 && result[4] == 3);
+    CHECK(sched.last_us < 750000 + 10 * XFER_US);
+
+    // a failed broadcast fails all the devices converting on it
+    ow1.fail_broadcast = 1;
+    memset(result, 0, sizeof(result));
+    CHECK_EQ(sensor_sched_run(&sched, result), 2);
+    CHECK_EQ(devs[0].status, -1);
+    CHECK_EQ(devs[1].status, -1);
+    CHECK_EQ(devs[2].status, 0);
+    CHECK(result[0] == 0 && result[4] == 3);
+    CHECK_EQ(ow1.broadcasts, 2);
+    CHECK_EQ(sched.errors, 2);
+}
+
+static void test_errors(void) {
+    sim_bus_t i2c = {.batching = 1}, spi = {0};
+    sim_dev_t a = {.conv_us = 1000, .value = 0x10};
+    sim_dev_t b = {.conv_us = 2000, .value = 0x20, .fail_read = 1};
+    sim_dev_t c = {.conv_us = 3000, .value = 0x30};
+    setup();
+    add_dev(&i2c, &a, 1, 0);
+    add_dev(&spi, &b, 1, 0);
+    add_dev(&spi, &c, 1, 0);
+    // a failed read only fails its device
+    CHECK_EQ(sensor_sched_run(&sched, result), 1);
+    CHECK_EQ(devs[0].status, 0);
+    CHECK_EQ(devs[1].status, -2);
+    CHECK_EQ(devs[2].status, 0);
+    CHECK(result[0] == 0x10 && result[2] == 0x30);
+
+    // a failed batch fails all its devices, they are not read
+    b.fail_read = 0;
+    i2c.fail_end = 1;
+    CHECK_EQ(sensor_sched_run(&sched, result), 1);
+    CHECK_EQ(devs[0].status, -4);
+    CHECK_EQ(i2c.batches, 3);
+
+    // the template is checked when added
+    sensor_dev_t t;
+    memset(&t, 0, sizeof(t));
+    CHECK_EQ(sensor_sched_add(&sched, &t), -1);
+    static const sensor_bus_ops_t no_bcast = {.xfer = sim_xfer};
+    t.ops = &no_bcast;
+    t.flags = SENSOR_FLAG_BROADCAST;
+    CHECK_EQ(sensor_sched_add(&sched, &t), -1);
+    t.flags = 0;
+    t.start_len = SENSOR_CMD_MAX + 1;
+    CHECK_EQ(sensor_sched_add(&sched, &t), -1);
+    t.start_len = 0;
+    t.bus = &spi;
+    t.dev = &c;
+    for (int i = 3; i < 8; i++) {
+        CHECK(sensor_sched_add(&sched, &t) >= 0);
+    }
+    CHECK_EQ(sensor_sched_add(&sched, &t), -1);
+}
+
+int main(void) {
+    test_interleave();
+    test_broadcast();
+    test_errors();
+    return test_result("sensor_sched");
+}
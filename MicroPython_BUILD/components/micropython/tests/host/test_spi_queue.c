@@ -0,0 +1,250 @@
+/*
+ * This file is part of the MicroPython ESP32 project, https://github.com/loboris/MicroPython_ESP32_psRAM_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+// Test of esp32/libs/spi_queue.c on a simulated bus: the mock ops record the
+// bus operations as text, so the framing, merging and ordering can be checked
+
+#include <string.h>
+
+#include "test.h"
+#include "spi_queue.h"
+
+typedef struct _mock_bus_t {
+    char log[512];
+    int started;        // started, not yet waited transfers
+    int max_started;
+    int fail_start;     // the start call which fails, counted from 1
+    int n_start;
+    uint64_t now;
+} mock_bus_t;
+
+static void mock_log(mock_bus_t *bus, const char *s) {
+    strncat(bus->log, s, sizeof(bus->log) - strlen(bus->log) - 1);
+}
+
+static int mock_select(void *b, int cs) {
+    char s[16];
+    snprintf(s, sizeof(s), "S%d ", cs);
+    mock_log(b, s);
+    return 0;
+}
+
+static int mock_deselect(void *b, int cs) {
+    char s[16];
+    snprintf(s, sizeof(s), "D%d ", cs);
+    mock_log(b, s);
+    return 0;
+}
+
+static int mock_start(void *b, const uint8_t *tx, uint32_t txlen, uint8_t *rx, uint32_t rxlen) {
+    mock_bus_t *bus = b;
+    char s[32];
+    if (++bus->n_start == bus->fail_start) {
+        mock_log(bus, "T! ");
+        return -1;
+    }
+    // the sent bytes are summed so the merged data can be checked
+    unsigned sum = 0;
+    for (uint32_t i = 0; i < txlen; i++) sum += tx[i];
+    for (uint32_t i = 0; i < rxlen; i++) rx[i] = 0xa0 + i;
+    snprintf(s, sizeof(s), "T%u/%u/%u ", (unsigned)txlen, sum, (unsigned)rxlen);
+    mock_log(bus, s);
+    if (++bus->started > bus->max_started) bus->max_started = bus->started;
+    bus->now += 10 + txlen + rxlen;
+    return 0;
+}
+
+static int mock_wait(void *b) {
+    mock_bus_t *bus = b;
+    mock_log(bus, "W ");
+    bus->started--;
+    return 0;
+}
+
+static mock_bus_t *time_bus;
+
+static uint64_t mock_time_us(void) {
+    return time_bus->now;
+}
+
+static const spi_queue_ops_t mock_ops = {
+    .select = mock_select,
+    .deselect = mock_deselect,
+    .start = mock_start,
+    .wait = mock_wait,
+    .time_us = mock_time_us,
+};
+
+static mock_bus_t bus;
+static spi_queue_t q;
+static spi_queue_desc_t desc[8];
+static uint8_t mem[256];
+static spi_queue_stats_t stats;
+
+static void setup(uint8_t depth) {
+    memset(&bus, 0, sizeof(bus));
+    memset(&stats, 0, sizeof(stats));
+    time_bus = &bus;
+    spi_queue_init(&q, &mock_ops, &bus, desc, 8, mem, sizeof(mem), 64, depth);
+    q.stats = &stats;
+}
+
+static const uint8_t data[] = {1, 2, 3, 4, 5, 6, 7, 8};
+
+static void test_frames(void) {
+    // each transaction is framed by its own CS activation by default
+    setup(2);
+    CHECK_EQ(spi_queue_add(&q, SPI_QUEUE_CS_DEFAULT, data, 2, 0, 0), 0);
+    CHECK_EQ(spi_queue_add(&q, 5, data, 1, 3, 0), 1);
+    CHECK_EQ(spi_queue_run(&q), 0);
+    CHECK(strcmp(bus.log, "S-1 T2/3/0 W D-1 S5 T1/1/3 W D5 ") == 0);
+    CHECK_EQ(q.completed, 2);
+    CHECK_EQ(q.state, SPI_QUEUE_DONE);
+
+    uint32_t len;
+    uint8_t *rx = spi_queue_rx(&q, 1, &len);
+    CHECK_EQ(len, 3);
+    CHECK(rx != NULL && rx[0] == 0xa0 && rx[2] == 0xa2);
+    CHECK(((rx - mem) & 3) == 0);
+    CHECK(spi_queue_rx(&q, 0, &len) == NULL);
+    CHECK_EQ(len, 0);
+
+    CHECK_EQ(stats.transactions, 2);
+    CHECK_EQ(stats.batches, 1);
+    CHECK_EQ(stats.bytes_tx, 3);
+    CHECK_EQ(stats.bytes_rx, 3);
+    CHECK_EQ(q.run_us, 10 + 2 + 10 + 4);
+}
+
+static void test_keep_cs(void) {
+    // KEEP_CS continues the frame with the next transaction on the same CS
+    setup(4);
+    CHECK_EQ(spi_queue_add(&q, 3, data, 1, 2, SPI_QUEUE_KEEP_CS), 0);
+    CHECK_EQ(spi_queue_add(&q, 3, NULL, 0, 4, SPI_QUEUE_KEEP_CS), 1);
+    CHECK_EQ(spi_queue_add(&q, 3, data, 2, 1, 0), 2);
+    // KEEP_CS followed by another CS ends the frame
+    CHECK_EQ(spi_queue_add(&q, 4, data, 1, 1, SPI_QUEUE_KEEP_CS), 3);
+    CHECK_EQ(spi_queue_add(&q, 3, data, 1, 1, 0), 4);
+    CHECK_EQ(spi_queue_run(&q), 0);
+    CHECK(strcmp(bus.log, "S3 T1/1/2 T0/0/4 T2/3/1 W W W D3 S4 T1/1/1 W D4 S3 T1/1/1 W D3 ") == 0);
+    CHECK_EQ(q.completed, 5);
+}
+
+static void test_merge(void) {
+    // consecutive send-only writes in a frame are merged into one transfer
+    setup(4);
+    CHECK_EQ(spi_queue_add(&q, 2, data, 3, 0, SPI_QUEUE_KEEP_CS), 0);
+    CHECK_EQ(spi_queue_add(&q, 2, data + 3, 2, 0, SPI_QUEUE_KEEP_CS), 0);
+    CHECK_EQ(spi_queue_add(&q, 2, data + 5, 3, 0, 0), 0);
+    CHECK_EQ(q.desc[0].tx_len, 8);
+    CHECK_EQ(q.desc[0].merged, 2);
+    CHECK_EQ(q.desc[0].flags, 0);
+    // the frame was closed by the last write, nothing more is merged
+    CHECK_EQ(spi_queue_add(&q, 2, data, 1, 0, 0), 1);
+    // not merged: a receiving transaction, another CS, a write after a receive
+    CHECK_EQ(spi_queue_add(&q, 2, data, 1, 0, SPI_QUEUE_KEEP_CS), 2);
+    CHECK_EQ(spi_queue_add(&q, 2, data, 1, 1, SPI_QUEUE_KEEP_CS), 3);
+    CHECK_EQ(spi_queue_add(&q, 2, data, 1, 0, SPI_QUEUE_KEEP_CS), 4);
+    CHECK_EQ(spi_queue_add(&q, 6, data, 1, 0, 0), 5);
+    CHECK_EQ(spi_queue_run(&q), 0);
+    CHECK(strcmp(bus.log, "S2 T8/36/0 W D2 S2 T1/1/0 W D2 S2 T1/1/0 T1/1/1 T1/1/0 W W W D2 S6 T1/1/0 W D6 ") == 0);
+
+    // merging is limited by the maximal transfer length
+    setup(4);
+    static uint8_t big[64];
+    CHECK_EQ(spi_queue_add(&q, 1, big, 60, 0, SPI_QUEUE_KEEP_CS), 0);
+    CHECK_EQ(spi_queue_add(&q, 1, big, 4, 0, SPI_QUEUE_KEEP_CS), 0);
+    CHECK_EQ(spi_queue_add(&q, 1, big, 1, 0, 0), 1);
+    CHECK_EQ(q.desc[0].tx_len, 64);
+}
+
+static void test_depth(void) {
+    // no more than 'depth' transfers are started without waiting
+    setup(2);
+    for (int i = 0; i < 6; i++) {
+        CHECK_EQ(spi_queue_add(&q, 1, data, 1, 1, SPI_QUEUE_KEEP_CS), i);
+    }
+    CHECK_EQ(spi_queue_run(&q), 0);
+    CHECK_EQ(bus.max_started, 2);
+    CHECK(strcmp(bus.log, "S1 T1/1/1 T1/1/1 W T1/1/1 W T1/1/1 W T1/1/1 W T1/1/1 W W D1 ") == 0);
+    CHECK_EQ(q.completed, 6);
+
+    setup(1);
+    CHECK_EQ(spi_queue_add(&q, 1, data, 1, 1, SPI_QUEUE_KEEP_CS), 0);
+    CHECK_EQ(spi_queue_add(&q, 1, data, 1, 1, 0), 1);
+    CHECK_EQ(spi_queue_run(&q), 0);
+    CHECK_EQ(bus.max_started, 1);
+}
+
+static void test_error(void) {
+    // a failed start completes the started transfers and deselects
+    setup(4);
+    CHECK_EQ(spi_queue_add(&q, 7, data, 1, 1, SPI_QUEUE_KEEP_CS), 0);
+    CHECK_EQ(spi_queue_add(&q, 7, data, 1, 1, SPI_QUEUE_KEEP_CS), 1);
+    CHECK_EQ(spi_queue_add(&q, 7, data, 1, 1, 0), 2);
+    CHECK_EQ(spi_queue_add(&q, 8, data, 1, 1, 0), 3);
+    bus.fail_start = 3;
+    CHECK_EQ(spi_queue_run(&q), SPI_QUEUE_ERR_BUS);
+    CHECK(strcmp(bus.log, "S7 T1/1/1 T1/1/1 T! W W D7 ") == 0);
+    CHECK_EQ(q.completed, 2);
+    CHECK_EQ(q.result, SPI_QUEUE_ERR_BUS);
+    CHECK_EQ(stats.errors, 1);
+    CHECK_EQ(bus.started, 0);
+}
+
+static void test_limits(void) {
+    setup(2);
+    CHECK_EQ(spi_queue_add(&q, 1, NULL, 0, 0, 0), SPI_QUEUE_ERR_ARG);
+    CHECK_EQ(spi_queue_add(&q, 1, NULL, 1, 0, 0), SPI_QUEUE_ERR_ARG);
+    CHECK_EQ(spi_queue_add(&q, 1, data, 65, 0, 0), SPI_QUEUE_ERR_ARG);
+    CHECK_EQ(spi_queue_add(&q, -2, data, 1, 0, 0), SPI_QUEUE_ERR_ARG);
+    for (int i = 0; i < 8; i++) {
+        CHECK_EQ(spi_queue_add(&q, 1, data, 1, 0, 0), i);
+    }
+    CHECK_EQ(spi_queue_add(&q, 1, data, 1, 0, 0), SPI_QUEUE_ERR_FULL);
+    CHECK_EQ(spi_queue_clear(&q), 0);
+    CHECK_EQ(q.ndesc, 0);
+    // the data buffer: 4 x (64 + 0) = 256 bytes, the 5th does not fit
+    static uint8_t big[64];
+    for (int i = 0; i < 4; i++) {
+        CHECK_EQ(spi_queue_add(&q, i, big, 64, 0, 0), i);
+    }
+    CHECK_EQ(spi_queue_add(&q, 9, big, 1, 0, 0), SPI_QUEUE_ERR_NOMEM);
+    q.state = SPI_QUEUE_RUNNING;
+    CHECK_EQ(spi_queue_add(&q, 1, data, 1, 0, 0), SPI_QUEUE_ERR_BUSY);
+    CHECK_EQ(spi_queue_run(&q), SPI_QUEUE_ERR_BUSY);
+    CHECK_EQ(spi_queue_clear(&q), SPI_QUEUE_ERR_BUSY);
+}
+
+int main(void) {
+    test_frames();
+    test_keep_cs();
+    test_merge();
+    test_depth();
+    test_error();
+    test_limits();
+    return test_result("spi_queue");
+}
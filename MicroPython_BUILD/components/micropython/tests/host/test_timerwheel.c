@@ -0,0 +1,183 @@
+/*
+ * This file is part of the MicroPython ESP32 project, https://github.com/loboris/MicroPython_ESP32_psRAM_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+// Test of extmod/timerwheel.c on a virtual clock: random one-shot and periodic
+// timers, added and removed also from the expire function, must fire exactly
+// at their tick, including across the wrap of the 32-bit tick counter
+
+#include <string.h>
+
+#include "test.h"
+#include "timerwheel.h"
+
+#define N_TIMERS    (2000)
+#define N_STEPS     (1000000)
+
+typedef struct _vtimer_t {
+    tw_node_t node;
+    uint32_t want;      // tick at which the timer must fire
+    uint32_t period;    // 0 for a one-shot timer
+    int active;
+    int fired;
+} vtimer_t;
+
+static vtimer_t timers[N_TIMERS];
+static tw_wheel_t wheel;
+static uint32_t cur_tick;
+static int late_fired;
+
+static uint64_t rnd_state;
+
+static uint32_t rnd(void) {
+    rnd_state = rnd_state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return rnd_state >> 33;
+}
+
+// timer distances at all the levels of the wheel and beyond
+static uint32_t rnd_delta(void) {
+    switch (rnd() % 4) {
+        case 0: return rnd() % 70;
+        case 1: return rnd() % 5000;
+        case 2: return rnd() % 300000;
+        default: return rnd() % (1u << 25);
+    }
+}
+
+static void expire(tw_node_t *node, void *arg) {
+    vtimer_t *t = (vtimer_t *)node;
+    CHECK(t->active);
+    if (cur_tick != t->want) {
+        if (late_fired++ < 10) {
+            printf("timer %d fired at %u, wanted %u\n", (int)(t - timers), cur_tick, t->want);
+        }
+    }
+    t->fired++;
+    if (t->period) {
+        t->want += t->period;
+        tw_add(&wheel, node, t->want);
+    } else {
+        t->active = 0;
+    }
+    // sometimes remove another timer from the expire function
+    if ((rnd() & 15) == 0) {
+        vtimer_t *o = &timers[rnd() % N_TIMERS];
+        if (o != t && o->active) {
+            tw_del(&wheel, &o->node);
+            o->active = 0;
+        }
+    }
+}
+
+static void test_random(uint32_t start) {
+    memset(timers, 0, sizeof(timers));
+    late_fired = 0;
+    rnd_state = 12345 + start;
+    tw_init(&wheel, start);
+    for (long step = 0; step < N_STEPS; step++) {
+        cur_tick = wheel.now;
+        int r = rnd() % 100;
+        if (r < 3) {
+            // (re)start a timer
+            vtimer_t *t = &timers[rnd() % N_TIMERS];
+            if (t->active) {
+                tw_del(&wheel, &t->node);
+            }
+            t->active = 1;
+            t->period = (rnd() & 1) ? 1 + rnd() % 3000 : 0;
+            t->want = cur_tick + rnd_delta();
+            tw_add(&wheel, &t->node, t->want);
+        } else if (r < 4) {
+            // stop a timer
+            vtimer_t *t = &timers[rnd() % N_TIMERS];
+            if (t->active) {
+                tw_del(&wheel, &t->node);
+                t->active = 0;
+            }
+        }
+        tw_tick(&wheel, expire, NULL);
+    }
+    CHECK_EQ(late_fired, 0);
+
+    uint32_t active = 0;
+    long fired = 0;
+    for (int i = 0; i < N_TIMERS; i++) {
+        CHECK_EQ(tw_pending(&timers[i].node), timers[i].active);
+        active += timers[i].active;
+        fired += timers[i].fired;
+    }
+    CHECK_EQ(wheel.count, active);
+    CHECK(fired > N_STEPS / 100);
+    CHECK(wheel.cascaded > 0);
+}
+
+static void test_advance(void) {
+    // the virtual clock skips the ticks when the wheel is empty
+    vtimer_t *t = &timers[0];
+    memset(timers, 0, sizeof(timers));
+    tw_init(&wheel, 0xfffffff0);
+    CHECK_EQ(tw_advance(&wheel, 1000, expire, NULL), 0);
+    CHECK_EQ(wheel.now, 0xfffffff0 + 1000);
+
+    t->active = 1;
+    t->want = wheel.now + 100000;
+    tw_add(&wheel, &t->node, t->want);
+    late_fired = 0;
+    rnd_state = 1;
+    for (cur_tick = wheel.now; cur_tick != t->want; cur_tick++) {
+        CHECK_EQ(tw_advance(&wheel, 1, expire, NULL), 0);
+    }
+    CHECK_EQ(tw_advance(&wheel, 1, expire, NULL), 1);
+    CHECK_EQ(t->fired, 1);
+    CHECK(!tw_pending(&t->node));
+    CHECK_EQ(late_fired, 0);
+    CHECK_EQ(wheel.count, 0);
+}
+
+static void test_coalesce(void) {
+    CHECK_EQ(tw_coalesce(1234, 0), 1234);
+    CHECK_EQ(tw_coalesce(1000, 64), 1024);
+    CHECK_EQ(tw_coalesce(1024, 100), 1024);
+    rnd_state = 7;
+    for (uint32_t e = 0; e < 100000; e++) {
+        uint32_t s = rnd() % 100;
+        uint32_t c = tw_coalesce(e, s);
+        if ((c < e) || (c - e > s)) {
+            CHECK(0);
+            printf("coalesce %u, slack %u -> %u\n", e, s, c);
+            break;
+        }
+    }
+}
+
+int main(void) {
+    test_random(0);
+    // the tick counter wraps around during the test
+    test_random(0xffff0000);
+    test_random(0x7fffff00);
+    test_advance();
+    test_coalesce();
+    return test_result("timerwheel");
+}
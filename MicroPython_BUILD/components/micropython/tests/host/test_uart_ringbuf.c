@@ -0,0 +1,167 @@
+/*
+ * This file is part of the MicroPython ESP32 project, https://github.com/loboris/MicroPython_ESP32_psRAM_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+// Unit test of esp32/libs/uart_ringbuf.c
+
+#include <string.h>
+
+#include "test.h"
+#include "uart_ringbuf.h"
+
+static uint8_t mem[16];
+static uart_ringbuf_t r;
+
+static void put_str(const char *s) {
+    CHECK_EQ(uart_buf_put(&r, (const uint8_t *)s, strlen(s)), 0);
+}
+
+static int find_str(const char *s) {
+    return uart_buf_find(&r, (const uint8_t *)s, strlen(s));
+}
+
+static void test_init(void) {
+    CHECK_EQ(uart_buf_size_pow2(1), 1);
+    CHECK_EQ(uart_buf_size_pow2(600), 1024);
+    CHECK_EQ(uart_buf_size_pow2(1024), 1024);
+    CHECK_EQ(uart_buf_init(&r, mem, 24), -1);
+    CHECK_EQ(uart_buf_init(&r, mem, sizeof(mem)), 0);
+    CHECK_EQ(uart_buf_count(&r), 0);
+    CHECK_EQ(uart_buf_free(&r), 16);
+}
+
+// lines split across puts, wrapping around the buffer end many times
+static void test_lines(void) {
+    uint8_t out[32];
+    uart_buf_init(&r, mem, sizeof(mem));
+    for (int i = 0; i < 1000; i++) {
+        char s[16];
+        int n = sprintf(s, "ab%dX\r\n", i % 7);
+        CHECK_EQ(uart_buf_put(&r, (uint8_t *)s, 3), 0);
+        CHECK_EQ(find_str("\r\n"), -1);
+        CHECK_EQ(uart_buf_put(&r, (uint8_t *)s + 3, n - 3), 0);
+        int f = find_str("\r\n");
+        CHECK_EQ(f, n - 2);
+        CHECK_EQ(uart_buf_get(&r, out, f + 2), n);
+        CHECK(memcmp(out, s, n) == 0);
+    }
+    CHECK_EQ(uart_buf_get(&r, out, 4), -1);
+}
+
+static void test_overflow(void) {
+    uint8_t big[40];
+    uart_buf_init(&r, mem, sizeof(mem));
+    memset(big, 'z', sizeof(big));
+    CHECK_EQ(uart_buf_put(&r, big, 40), 24);
+    CHECK_EQ(r.received, 40);
+    CHECK_EQ(r.dropped, 24);
+    CHECK_EQ(r.overflows, 1);
+    CHECK_EQ(uart_buf_count(&r), 16);
+    CHECK_EQ(uart_buf_free(&r), 0);
+    uart_buf_flush(&r);
+    CHECK_EQ(uart_buf_count(&r), 0);
+}
+
+static void test_put_ptr(void) {
+    uint8_t out[16];
+    uint32_t len;
+    uart_buf_init(&r, mem, sizeof(mem));
+    put_str("0123456789");
+    uart_buf_drop(&r, 10);
+    // contiguous space ends at the buffer end
+    uint8_t *p = uart_buf_put_ptr(&r, &len);
+    CHECK_EQ(len, 6);
+    memcpy(p, "hello\n", 6);
+    uart_buf_put_commit(&r, 6);
+    p = uart_buf_put_ptr(&r, &len);
+    CHECK_EQ(len, 10);
+    memcpy(p, "ab", 2);
+    uart_buf_put_commit(&r, 2);
+    CHECK_EQ(find_str("\n"), 5);
+    CHECK_EQ(find_str("o\nab"), 4);
+    CHECK_EQ(uart_buf_peek(&r, out, 5, 16), 3);
+    CHECK(memcmp(out, "\nab", 3) == 0);
+    CHECK_EQ(r.received, 18);
+}
+
+// searches for different patterns don't share the resume position
+static void test_patterns(void) {
+    uart_buf_init(&r, mem, sizeof(mem));
+    put_str("ab\ncdef");
+    CHECK_EQ(find_str("XYZ"), -1);
+    CHECK_EQ(find_str("\n"), 2);
+    CHECK_EQ(find_str("XYZ"), -1);
+    put_str("XYZ");
+    CHECK_EQ(find_str("XYZ"), 7);
+    CHECK_EQ(find_str("\n"), 2);
+    CHECK_EQ(find_str("cd"), 3);
+
+    // more patterns than slots
+    uart_buf_flush(&r);
+    put_str("1a2b3c4d5e6f");
+    const char *pats[] = {"a", "b", "c", "d", "e", "f", "zz"};
+    for (int k = 0; k < 3; k++) {
+        for (int i = 0; i < 6; i++) {
+            CHECK_EQ(find_str(pats[i]), 2 * i + 1);
+            CHECK_EQ(find_str(pats[6]), -1);
+        }
+    }
+
+    // consumed data is not searched, positions past the read position are kept
+    uart_buf_drop(&r, 4);
+    CHECK_EQ(find_str("a"), -1);
+    CHECK_EQ(find_str("c"), 1);
+    CHECK_EQ(find_str("zz"), -1);
+    put_str("zz");
+    CHECK_EQ(find_str("zz"), 8);
+
+    // patterns too long to be remembered are searched from the read position
+    uart_buf_flush(&r);
+    put_str("0123456789abcdef");
+    CHECK_EQ(find_str("123456789abcdef"), 1);
+    CHECK_EQ(find_str("0123456789abcdefg"), -1);
+}
+
+// pattern across the buffer end
+static void test_wrap(void) {
+    uart_buf_init(&r, mem, sizeof(mem));
+    put_str("xxxxxxxxxxxxxx");
+    uart_buf_drop(&r, 14);
+    put_str("ab\r");
+    CHECK_EQ(find_str("\r\n"), -1);
+    put_str("\nc");
+    CHECK_EQ(find_str("\r\n"), 2);
+    CHECK_EQ(find_str("b\r\nc"), 1);
+}
+
+int main(void) {
+    test_init();
+    test_lines();
+    test_overflow();
+    test_put_ptr();
+    test_patterns();
+    test_wrap();
+    return test_result("uart_ringbuf");
+}
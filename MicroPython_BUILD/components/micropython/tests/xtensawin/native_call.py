@@ -0,0 +1,4 @@
+# native function calling the runtime, the entry/callx8/retw.n frame
+@micropython.native
+def add(a, b):
+    return a + b
@@ -0,0 +1,6 @@
+# nested function, linked as a raw code, with a closed over variable
+@micropython.native
+def make(n):
+    def f(x):
+        return x * n
+    return f
@@ -0,0 +1,8 @@
+# exception handler, nlr_push with setjmp called from the native code
+@micropython.native
+def safe_div(a, b):
+    try:
+        r = a // b
+    except ZeroDivisionError:
+        r = None
+    return r
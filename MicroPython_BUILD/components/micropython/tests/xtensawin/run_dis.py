@@ -0,0 +1,206 @@
+# Golden disassembly tests of the xtensawin native emitter.
+# Each *.py file here is compiled with 'mpy-cross -march=xtensawin', the machine
+# code of its native functions is disassembled and compared with the *.py.exp file.
+#
+#   python3 run_dis.py [--update] [test.py ...]
+#
+# --update rewrites the .exp files.  The mpy-cross executable is taken from the
+# MPY_CROSS environment variable, by default from components/mpy_cross_build.
+# The words linked by the loader are printed by their link, not by their value,
+# as mpy-cross stores there the addresses of its own build.
+
+import os
+import re
+import sys
+import subprocess
+import tempfile
+import importlib.util
+
+TESTS_DIR = os.path.dirname(os.path.abspath(__file__))
+TOP = os.path.normpath(os.path.join(TESTS_DIR, '../..'))
+MPY_CROSS = os.getenv('MPY_CROSS', os.path.join(TOP, '../mpy_cross_build/mpy-cross/mpy-cross'))
+
+sys.path.insert(0, os.path.join(TOP, 'py'))
+spec = importlib.util.spec_from_file_location('mpy_tool', os.path.join(TOP, 'tools/mpy-tool.py'))
+mt = importlib.util.module_from_spec(spec)
+spec.loader.exec_module(mt)
+
+# entries of mp_fun_table, mpy-cross has all the optional ones enabled
+with open(os.path.join(TOP, 'py/runtime0.h')) as f:
+    FUN_NAMES = re.findall(r'^\s*MP_F_(\w+)', f.read(), re.M)
+
+LINK_NAMES = ('fun', 'const', 'qstr', 'qstr_obj', 'qstr16', 'obj', 'raw_code')
+CONST_NAMES = ('None', 'False', 'True', 'Ellipsis', 'StopIteration', 'sentinel')
+
+
+def sext(v, bits):
+    return v - (1 << bits) if v & (1 << (bits - 1)) else v
+
+
+# Decoder of the Xtensa instructions used by asmxtensa.c, written from the
+# ISA reference and independent of the emitter.
+def decode(code, pc):
+    op0 = code[pc] & 0xf
+    if op0 >= 8:
+        if pc + 2 > len(code):
+            return None, 0
+        w = code[pc] | code[pc + 1] << 8
+        n = 2
+    else:
+        if pc + 3 > len(code):
+            return None, 0
+        w = code[pc] | code[pc + 1] << 8 | code[pc + 2] << 16
+        n = 3
+    t = (w >> 4) & 0xf
+    s = (w >> 8) & 0xf
+    r = (w >> 12) & 0xf
+    op1 = (w >> 16) & 0xf
+    op2 = (w >> 20) & 0xf
+    imm8 = (w >> 16) & 0xff
+    txt = '.word 0x%06x' % w
+    if op0 == 0:
+        if op1 == 0 and op2 == 0 and r == 0:
+            m, nn = t >> 2, t & 3
+            if m == 2:
+                txt = {0: 'ret', 1: 'retw', 2: 'jx a%d' % s}.get(nn, txt)
+            elif m == 3:
+                txt = {0: 'callx0 a%d' % s, 1: 'callx4 a%d' % s, 2: 'callx8 a%d' % s}.get(nn, txt)
+        elif op1 == 0 and op2 in (1, 2, 3, 8, 12):
+            txt = '%s a%d, a%d, a%d' % ({1: 'and', 2: 'or', 3: 'xor', 8: 'add', 12: 'sub'}[op2], r, s, t)
+        elif op1 == 0 and op2 == 4 and r in (0, 1) and t == 0:
+            txt = '%s a%d' % (('ssr', 'ssl')[r], s)
+        elif op1 == 1 and op2 == 10:
+            txt = 'sll a%d, a%d' % (r, s)
+        elif op1 == 1 and op2 == 11:
+            txt = 'sra a%d, a%d' % (r, t)
+        elif op1 == 2 and op2 == 8:
+            txt = 'mull a%d, a%d, a%d' % (r, s, t)
+    elif op0 == 1:
+        imm16 = (w >> 8) & 0xffff
+        addr = ((pc + 3) & ~3) + ((imm16 | ~0xffff) << 2)
+        txt = 'l32r a%d, [%d]' % (t, addr)
+    elif op0 == 2:
+        txt = {
+            0: 'l8ui a%d, a%d, %d' % (t, s, imm8),
+            1: 'l16ui a%d, a%d, %d' % (t, s, imm8 * 2),
+            2: 'l32i a%d, a%d, %d' % (t, s, imm8 * 4),
+            4: 's8i a%d, a%d, %d' % (t, s, imm8),
+            5: 's16i a%d, a%d, %d' % (t, s, imm8 * 2),
+            6: 's32i a%d, a%d, %d' % (t, s, imm8 * 4),
+            10: 'movi a%d, %d' % (t, sext(s << 8 | imm8, 12)),
+            12: 'addi a%d, a%d, %d' % (t, s, sext(imm8, 8)),
+        }.get(r, txt)
+    elif op0 == 6:
+        nn = (w >> 4) & 3
+        m = (w >> 6) & 3
+        if nn == 0:
+            txt = 'j %d' % (pc + 4 + sext(w >> 6, 18))
+        elif nn == 1:
+            txt = '%s a%d, %d' % (('beqz', 'bnez', 'bltz', 'bgez')[m], s, pc + 4 + sext(w >> 12, 12))
+        elif nn == 3 and m == 0:
+            txt = 'entry a%d, %d' % (s, (w >> 12) * 8)
+    elif op0 == 7:
+        cc = {1: 'beq', 9: 'bne', 2: 'blt', 10: 'bge', 3: 'bltu', 11: 'bgeu'}.get(r)
+        if cc:
+            txt = '%s a%d, a%d, %d' % (cc, s, t, pc + 4 + sext(imm8, 8))
+    elif op0 == 8:
+        txt = 'l32i.n a%d, a%d, %d' % (t, s, r * 4)
+    elif op0 == 9:
+        txt = 's32i.n a%d, a%d, %d' % (t, s, r * 4)
+    elif op0 == 12 and not (w & 0x80):
+        v = r | ((w >> 4) & 7) << 4
+        if v >= 96:
+            v -= 128
+        txt = 'movi.n a%d, %d' % (s, v)
+    elif op0 == 13:
+        if r == 0:
+            txt = 'mov.n a%d, a%d' % (t, s)
+        elif r == 15 and s == 0:
+            txt = {0: 'ret.n', 1: 'retw.n'}.get(t, txt)
+    return txt, n
+
+
+def link_desc(link):
+    kind, arg = link[1], link[2]
+    if kind in (mt.MP_NATIVE_LINK_QSTR, mt.MP_NATIVE_LINK_QSTR_OBJ, mt.MP_NATIVE_LINK_QSTR16):
+        arg = mt.global_qstrs[arg].str
+    elif kind == mt.MP_NATIVE_LINK_FUN:
+        return 'fun %s' % FUN_NAMES[arg].lower()
+    elif kind == mt.MP_NATIVE_LINK_CONST:
+        arg = CONST_NAMES[arg]
+    elif kind == mt.MP_NATIVE_LINK_RAW_CODE:
+        arg = '<raw code>'
+    return '%s %r' % (LINK_NAMES[kind], arg)
+
+
+def dis_raw_code(rc, out):
+    if not isinstance(rc, mt.RawCodeNative):
+        for child in rc.raw_codes:
+            dis_raw_code(child, out)
+        return
+    code = rc.fun_data
+    links = {l[0]: l for l in rc.links}
+    out.append('native kind %d, %d bytes, scope flags 0x%02x, %d args' % (rc.kind, len(code), rc.prelude[0], rc.prelude[1]))
+    # the literal pool is at the start, jumped over by the first instruction
+    start = 0
+    txt, n = decode(code, 0)
+    if txt.startswith('j '):
+        start = int(txt[2:])
+        for off in range(4, start, 4):
+            if off in links:
+                out.append('  [%d] %s' % (off, link_desc(links[off])))
+            else:
+                out.append('  [%d] 0x%08x' % (off, int.from_bytes(code[off:off + 4], 'little')))
+    # the code ends with the last return, the prelude and the constant table follow it
+    lines = []
+    pc = start
+    while pc < len(code):
+        txt, n = decode(code, pc)
+        if txt is None:
+            break
+        lines.append((pc, txt))
+        pc += n
+    last = max(i for i, l in enumerate(lines) if l[1] == 'retw.n')
+    for pc, txt in lines[:last + 1]:
+        out.append('  %4d: %s' % (pc, txt))
+    for link in rc.links:
+        if link[0] >= lines[last][0]:
+            out.append('  link %d: %s' % (link[0], link_desc(link)))
+    for link in rc.links:
+        if link[1] == mt.MP_NATIVE_LINK_RAW_CODE:
+            dis_raw_code(link[2], out)
+
+
+def run_test(test, update):
+    with tempfile.TemporaryDirectory() as tmp:
+        mpy = os.path.join(tmp, 'test.mpy')
+        subprocess.check_call([MPY_CROSS, '-march=xtensawin', '-o', mpy, '-s', os.path.basename(test), test])
+        del mt.global_qstrs[:]
+        out = []
+        dis_raw_code(mt.read_mpy(mpy), out)
+    out = '\n'.join(out) + '\n'
+    exp_file = test + '.exp'
+    if update:
+        with open(exp_file, 'w') as f:
+            f.write(out)
+        return True
+    with open(exp_file) as f:
+        return f.read() == out
+
+
+def main():
+    update = '--update' in sys.argv
+    tests = [a for a in sys.argv[1:] if a != '--update']
+    if not tests:
+        tests = sorted(os.path.join(TESTS_DIR, f) for f in os.listdir(TESTS_DIR)
+            if f.endswith('.py') and f != os.path.basename(__file__))
+    failed = 0
+    for test in tests:
+        ok = run_test(test, update)
+        print('%s: %s' % (os.path.basename(test), 'OK' if ok else 'FAIL'))
+        failed += not ok
+    return 1 if failed else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
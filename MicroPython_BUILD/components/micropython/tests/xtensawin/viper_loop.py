@@ -0,0 +1,8 @@
+# viper loop over a buffer, pointer loads and integer compares
+@micropython.viper
+def sum8(buf, n: int) -> int:
+    p = ptr8(buf)
+    s = 0
+    for i in range(n):
+        s += p[i]
+    return s
@@ -0,0 +1,191 @@
+#!/usr/bin/env python3
+#
+# This file is part of the MicroPython ESP32 project, https://github.com/loboris/MicroPython_ESP32_psRAM_LoBo
+#
+# The MIT License (MIT)
+#
+# Copyright (c) 2018 LoBo (https://github.com/loboris)
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+# THE SOFTWARE.
+
+# Render the result of micropython.profile_stop() as a flame graph.
+#
+# On the board:
+#   micropython.profile_start(200)
+#   ...
+#   print(micropython.profile_stop())
+# and copy the printed dict to a file, then:
+#   flamegraph.py profile.txt -o profile.svg
+#   flamegraph.py --collapsed profile.txt    (folded stacks for other viewers)
+#   flamegraph.py --top 20 profile.txt       (lines that take most time)
+
+from __future__ import print_function
+import ast
+import sys
+
+FRAME_HEIGHT = 16
+WIDTH = 1200
+FONT_SIZE = 12
+CHAR_WIDTH = FONT_SIZE * 0.6
+
+
+def read_profile(filename):
+    with open(filename) as f:
+        text = f.read()
+    # allow the dict to be surrounded by other output of the REPL
+    start = text.find('{')
+    end = text.rfind('}')
+    if start < 0 or end < start:
+        raise ValueError('%s: no profile found' % filename)
+    profile = ast.literal_eval(text[start:end + 1])
+    if not isinstance(profile, dict):
+        raise ValueError('%s: no profile found' % filename)
+    return profile
+
+
+def frame_name(frame):
+    block, source, line = frame
+    return '%s (%s:%d)' % (block, source, line)
+
+
+def stack_names(stack):
+    if stack is None:
+        return ['[dropped]']
+    if not stack:
+        return ['[not in Python code]']
+    return [frame_name(f) for f in stack]
+
+
+def write_collapsed(profile, out):
+    for stack, count in sorted(profile.items(), key=lambda i: -i[1]):
+        print(';'.join(n.replace(';', ':') for n in stack_names(stack)), count, file=out)
+
+
+def write_top(profile, n, out):
+    total = sum(profile.values())
+    own = {}
+    for stack, count in profile.items():
+        name = stack_names(stack)[-1]
+        own[name] = own.get(name, 0) + count
+    for name, count in sorted(own.items(), key=lambda i: -i[1])[:n]:
+        print('%6d %5.1f%%  %s' % (count, 100.0 * count / total, name), file=out)
+
+
+class Node:
+    def __init__(self, name):
+        self.name = name
+        self.count = 0
+        self.children = {}
+
+    def add(self, names, count):
+        self.count += count
+        if names:
+            child = self.children.get(names[0])
+            if child is None:
+                child = self.children[names[0]] = Node(names[0])
+            child.add(names[1:], count)
+
+    def depth(self):
+        return 1 + max([c.depth() for c in self.children.values()] + [0])
+
+
+def color(name):
+    # a stable warm color for each function
+    h = 0
+    for c in name.split(' ')[0]:
+        h = (h * 31 + ord(c)) & 0xffff
+    return 'rgb(%d,%d,%d)' % (205 + h % 50, 80 + (h >> 4) % 130, 30 + (h >> 8) % 40)
+
+
+def escape(s):
+    return s.replace('&', '&amp;').replace('<', '&lt;').replace('>', '&gt;')
+
+
+def write_svg(profile, title, out):
+    root = Node('all')
+    for stack, count in profile.items():
+        root.add(stack_names(stack), count)
+    height = (root.depth() + 2) * FRAME_HEIGHT
+    scale = float(WIDTH - 20) / max(root.count, 1)
+
+    print('<?xml version="1.0" standalone="no"?>', file=out)
+    print('<svg version="1.1" width="%d" height="%d" xmlns="http://www.w3.org/2000/svg">' % (WIDTH, height), file=out)
+    print('<rect x="0" y="0" width="%d" height="%d" fill="#f8f8f8"/>' % (WIDTH, height), file=out)
+    print('<text x="%d" y="%d" font-size="%d" font-family="Verdana" text-anchor="middle">%s</text>'
+        % (WIDTH // 2, FRAME_HEIGHT, FONT_SIZE + 2, escape(title)), file=out)
+
+    def draw(node, x, level):
+        w = node.count * scale
+        if w < 0.5:
+            return
+        y = height - (level + 1) * FRAME_HEIGHT
+        label = '%s: %d samples, %.1f%%' % (node.name, node.count, 100.0 * node.count / root.count)
+        print('<g><title>%s</title>' % escape(label), file=out)
+        print('<rect x="%.1f" y="%d" width="%.1f" height="%d" fill="%s" rx="2"/>'
+            % (x, y, w, FRAME_HEIGHT - 1, color(node.name)), file=out)
+        n_chars = int((w - 4) / CHAR_WIDTH)
+        if n_chars >= 3:
+            text = node.name if len(node.name) <= n_chars else node.name[:n_chars - 2] + '..'
+            print('<text x="%.1f" y="%d" font-size="%d" font-family="Verdana">%s</text>'
+                % (x + 2, y + FRAME_HEIGHT - 4, FONT_SIZE, escape(text)), file=out)
+        print('</g>', file=out)
+        for child in sorted(node.children.values(), key=lambda c: c.name):
+            draw(child, x, level + 1)
+            x += child.count * scale
+
+    draw(root, 10, 0)
+    print('</svg>', file=out)
+
+
+def main():
+    import argparse
+    cmd_parser = argparse.ArgumentParser(description='Render a micropython.profile_stop() result as a flame graph.')
+    cmd_parser.add_argument('-o', '--output',
+        help='output file (default stdout)')
+    cmd_parser.add_argument('-c', '--collapsed', action='store_true',
+        help='write folded stacks instead of an SVG')
+    cmd_parser.add_argument('-t', '--top', metavar='N', type=int,
+        help='list the N lines with the most samples instead of an SVG')
+    cmd_parser.add_argument('--title', default='MicroPython profile',
+        help='title of the SVG')
+    cmd_parser.add_argument('files', nargs='+',
+        help='files with the printed result of profile_stop(), their counts are added')
+    args = cmd_parser.parse_args()
+
+    profile = {}
+    for filename in args.files:
+        try:
+            for stack, count in read_profile(filename).items():
+                profile[stack] = profile.get(stack, 0) + count
+        except (IOError, ValueError, SyntaxError) as er:
+            print(er, file=sys.stderr)
+            sys.exit(1)
+
+    out = open(args.output, 'w') if args.output else sys.stdout
+    if args.collapsed:
+        write_collapsed(profile, out)
+    elif args.top:
+        write_top(profile, args.top, out)
+    else:
+        write_svg(profile, args.title, out)
+    if args.output:
+        out.close()
+
+if __name__ == '__main__':
+    main()
@@ -57,12 +57,26 @@ class FreezeError(Exception):
         return 'error while freezing %s: %s' % (self.rawcode.source_file, self.msg)
 
 class Config:
-    MPY_VERSION = 3
+    MPY_VERSION = 5
+    MPY_VERSION_MIN = 3
+    MPY_VERSION_NATIVE = 5
     MICROPY_LONGINT_IMPL_NONE = 0
     MICROPY_LONGINT_IMPL_LONGLONG = 1
     MICROPY_LONGINT_IMPL_MPZ = 2
 config = Config()
 
+MP_RAW_CODE_BYTECODE = 0
+MP_RAW_CODE_NATIVE_PY = 1
+MP_RAW_CODE_NATIVE_VIPER = 2
+
+MP_NATIVE_LINK_FUN = 0
+MP_NATIVE_LINK_CONST = 1
+MP_NATIVE_LINK_QSTR = 2
+MP_NATIVE_LINK_QSTR_OBJ = 3
+MP_NATIVE_LINK_QSTR16 = 4
+MP_NATIVE_LINK_OBJ = 5
+MP_NATIVE_LINK_RAW_CODE = 6
+
 MP_OPCODE_BYTE = 0
 MP_OPCODE_QSTR = 1
 MP_OPCODE_VAR_UINT = 2
@@ -73,10 +87,37 @@ MP_BC_MAKE_CLOSURE = 0x62
 MP_BC_MAKE_CLOSURE_DEFARGS = 0x63
 MP_BC_RAISE_VARARGS = 0x5c
 # extra byte if caching enabled:
-MP_BC_LOAD_NAME = 0x1c
-MP_BC_LOAD_GLOBAL = 0x1d
-MP_BC_LOAD_ATTR = 0x1e
+MP_BC_LOAD_NAME = 0x1b
+MP_BC_LOAD_GLOBAL = 0x1c
+MP_BC_LOAD_ATTR = 0x1d
 MP_BC_STORE_ATTR = 0x26
+# superinstructions with extra bytes:
+MP_BC_LOAD_FAST_ATTR = 0x2c
+MP_BC_LOAD_FAST_CONST_BINARY_OP = 0x2d
+MP_BC_BINARY_OP_POP_JUMP_IF_TRUE = 0x3a
+MP_BC_BINARY_OP_POP_JUMP_IF_FALSE = 0x3b
+# evaluated when laying out a module in ROM:
+MP_BC_LOAD_CONST_FALSE = 0x10
+MP_BC_LOAD_CONST_NONE = 0x11
+MP_BC_LOAD_CONST_TRUE = 0x12
+MP_BC_LOAD_CONST_SMALL_INT = 0x14
+MP_BC_LOAD_CONST_STRING = 0x16
+MP_BC_LOAD_CONST_OBJ = 0x17
+MP_BC_LOAD_NULL = 0x18
+MP_BC_LOAD_FAST_N = 0x19
+MP_BC_LOAD_BUILD_CLASS = 0x20
+MP_BC_STORE_NAME = 0x24
+MP_BC_DUP_TOP = 0x30
+MP_BC_POP_TOP = 0x32
+MP_BC_BUILD_TUPLE = 0x50
+MP_BC_RETURN_VALUE = 0x5b
+MP_BC_MAKE_FUNCTION = 0x60
+MP_BC_MAKE_FUNCTION_DEFARGS = 0x61
+MP_BC_CALL_FUNCTION = 0x64
+MP_BC_IMPORT_NAME = 0x68
+MP_BC_IMPORT_FROM = 0x69
+MP_BC_LOAD_CONST_SMALL_INT_MULTI = 0x70
+MP_BC_LOAD_FAST_MULTI = 0xb0
 
 def make_opcode_format():
     def OC4(a, b, c, d):
@@ -99,10 +140,10 @@ def make_opcode_format():
     OC4(B, B, V, V), # 0x20-0x23
     OC4(Q, Q, Q, B), # 0x24-0x27
     OC4(V, V, Q, Q), # 0x28-0x2b
-    OC4(U, U, U, U), # 0x2c-0x2f
+    OC4(Q, B, U, U), # 0x2c-0x2f
     OC4(B, B, B, B), # 0x30-0x33
     OC4(B, O, O, O), # 0x34-0x37
-    OC4(O, O, U, U), # 0x38-0x3b
+    OC4(O, O, O, O), # 0x38-0x3b
     OC4(U, O, B, O), # 0x3c-0x3f
     OC4(O, B, B, O), # 0x40-0x43
     OC4(B, B, O, B), # 0x44-0x47
@@ -166,12 +207,14 @@ def mp_opcode_format(bytecode, ip, opcode_format=make_opcode_format()):
     ip_start = ip
     f = (opcode_format[opcode >> 2] >> (2 * (opcode & 3))) & 3
     if f == MP_OPCODE_QSTR:
-        ip += 3
+        ip += 3 + (opcode == MP_BC_LOAD_FAST_ATTR)
     else:
         extra_byte = (
             opcode == MP_BC_RAISE_VARARGS
             or opcode == MP_BC_MAKE_CLOSURE
             or opcode == MP_BC_MAKE_CLOSURE_DEFARGS
+            or opcode == MP_BC_BINARY_OP_POP_JUMP_IF_TRUE
+            or opcode == MP_BC_BINARY_OP_POP_JUMP_IF_FALSE
             or config.MICROPY_OPT_CACHE_MAP_LOOKUP_IN_BYTECODE and (
                 opcode == MP_BC_LOAD_NAME
                 or opcode == MP_BC_LOAD_GLOBAL
@@ -179,6 +222,8 @@ def mp_opcode_format(bytecode, ip, opcode_format=make_opcode_format()):
                 or opcode == MP_BC_STORE_ATTR
             )
         )
+        if opcode == MP_BC_LOAD_FAST_CONST_BINARY_OP:
+            extra_byte = 3
         ip += 1
         if f == MP_OPCODE_VAR_UINT:
             while bytecode[ip] & 0x80 != 0:
@@ -239,7 +284,10 @@ class RawCode:
     def dump(self):
         # dump children first
         for rc in self.raw_codes:
-            rc.freeze('')
+            if isinstance(rc, RawCodeNative):
+                rc.dump()
+            else:
+                rc.freeze('')
         # TODO
 
     def freeze(self, parent_name):
@@ -254,6 +302,8 @@ class RawCode:
 
         # emit children first
         for rc in self.raw_codes:
+            if isinstance(rc, RawCodeNative):
+                raise FreezeError(self, 'can not freeze native code')
             rc.freeze(self.escaped_name + '_')
 
         # generate bytecode data
@@ -278,7 +328,8 @@ class RawCode:
             f, sz = mp_opcode_format(self.bytecode, ip)
             if f == 1:
                 qst = self._unpack_qstr(ip + 1).qstr_id
-                print('   ', '0x%02x,' % self.bytecode[ip], qst, '& 0xff,', qst, '>> 8,')
+                print('   ', '0x%02x,' % self.bytecode[ip], qst, '& 0xff,', qst, '>> 8,',
+                    ''.join('0x%02x, ' % self.bytecode[ip + i] for i in range(3, sz)))
             else:
                 print('   ', ''.join('0x%02x, ' % self.bytecode[ip + i] for i in range(sz)))
             ip += sz
@@ -377,6 +428,580 @@ class RawCode:
         print('    },')
         print('};')
 
+class RawCodeNative:
+    # machine code with the values that are linked when it's loaded,
+    # it's only read so it can be reported, it can't be frozen
+    def __init__(self, kind, fun_data, prelude, links):
+        self.kind = kind
+        self.fun_data = fun_data
+        self.prelude = prelude
+        self.links = links
+
+    def dump(self):
+        pass
+
+# A frozen module whose top-level code only binds constants, functions,
+# classes and imported modules is evaluated here, at freeze time, and emitted
+# as ROM objects: importing it then runs no bytecode.  The module and class
+# dicts are RAM objects (so they stay writable) whose tables are copied from
+# ROM on import; functions and classes refer to those dicts.
+
+MP_SCOPE_FLAG_GENERATOR = 0x04
+
+# builtins that a ROM class may derive from; none of them has a protocol to inherit
+ROM_BASE_TYPES = (
+    'object', 'BaseException', 'Exception', 'ArithmeticError', 'AssertionError',
+    'AttributeError', 'EOFError', 'ImportError', 'IndexError', 'KeyError',
+    'KeyboardInterrupt', 'LookupError', 'MemoryError', 'NameError',
+    'NotImplementedError', 'OSError', 'OverflowError', 'RuntimeError',
+    'StopIteration', 'SyntaxError', 'SystemExit', 'TypeError', 'ValueError',
+    'ZeroDivisionError',
+)
+ROM_DECORATORS = ('staticmethod', 'classmethod', 'property')
+
+# taken from py/map.c
+hash_allocation_sizes = (
+    0, 2, 4, 6, 8, 10, 12,
+    17, 23, 29, 37, 47, 59, 73,
+    97, 127, 167, 223, 293, 389, 521, 691, 919, 1223, 1627, 2161,
+    3229, 4831, 7243, 10861, 16273, 24407, 36607, 54907,
+)
+
+class NotRomable(Exception):
+    pass
+
+def qstr_id(s):
+    return 'MP_QSTR_' + qstrutil.qstr_escape(s)
+
+def add_qstr(s):
+    for q in global_qstrs:
+        if q.str == s:
+            return
+    global_qstrs.append(qstr_type(s, qstrutil.qstr_escape(s), qstr_id(s)))
+
+class RomValue:
+    # a value computed at freeze time; ref() emits its definition on first use
+    def __init__(self, rom):
+        self.rom = rom
+        self.c_ref = None
+
+    def ref(self):
+        if self.c_ref is None:
+            self.c_ref = self.emit()
+        return self.c_ref
+
+    def emit(self):
+        raise NotRomable('%s can not be frozen into ROM' % self.what())
+
+    def what(self):
+        return type(self).__name__
+
+class RomConst(RomValue):
+    def __init__(self, rom, c_ref, value):
+        RomValue.__init__(self, rom)
+        self.c_ref = c_ref
+        self.value = value
+
+class RomObj(RomValue):
+    # an entry of the constant table of a RawCode
+    def __init__(self, rom, rc, i):
+        RomValue.__init__(self, rom)
+        self.rc = rc
+        self.i = i
+        self.value = rc.objs[i]
+
+    def emit(self):
+        obj_name = 'const_obj_%s_%u' % (self.rc.escaped_name, self.i)
+        if type(self.value) is not float:
+            return 'MP_ROM_PTR(&%s)' % obj_name
+        # a float is an object or an immediate value depending on the target
+        name = self.rom.new_name('float')
+        n = struct.unpack('<I', struct.pack('<f', self.value))[0]
+        n = ((n & ~0x3) | 2) + 0x80800000
+        self.rom.lines.extend((
+            '#if MICROPY_OBJ_REPR == MICROPY_OBJ_REPR_A || MICROPY_OBJ_REPR == MICROPY_OBJ_REPR_B',
+            '#define %s MP_ROM_PTR(&%s)' % (name, obj_name),
+            '#elif MICROPY_OBJ_REPR == MICROPY_OBJ_REPR_C',
+            '#define %s ((mp_rom_obj_t)(0x%08x))' % (name, n),
+            '#else',
+            '#error "MICROPY_OBJ_REPR_D not supported with floats in frozen mpy files"',
+            '#endif',
+        ))
+        return name
+
+class RomMarker(RomValue):
+    # values that only exist on the stack: NULL, __build_class__, builtins, imports
+    def __init__(self, rom, kind, arg=None):
+        RomValue.__init__(self, rom)
+        self.kind = kind
+        self.arg = arg
+
+    def what(self):
+        return self.kind
+
+class RomTuple(RomValue):
+    def __init__(self, rom, items):
+        RomValue.__init__(self, rom)
+        self.items = items
+
+    def emit(self):
+        items = [item.ref() for item in self.items]
+        name = self.rom.new_name('tuple')
+        self.rom.lines.append('STATIC const mp_rom_obj_tuple_t %s = {{&mp_type_tuple}, %u, {%s}};'
+            % (name, len(items), ', '.join(items)))
+        return 'MP_ROM_PTR(&%s)' % name
+
+class RomFun(RomValue):
+    def __init__(self, rom, rc, defaults):
+        RomValue.__init__(self, rom)
+        self.rc = rc
+        self.defaults = defaults
+
+    def emit(self):
+        extra = [item.ref() for item in self.defaults.items] if self.defaults else []
+        rc = self.rc
+        if len(rc.qstrs) + len(rc.objs) + len(rc.raw_codes):
+            const_table = '(const mp_uint_t*)const_table_data_%s' % rc.escaped_name
+        else:
+            const_table = 'NULL'
+        name = self.rom.new_name('fun')
+        self.rom.lines.append('STATIC const mp_rom_obj_fun_bc_t %s = {{&mp_type_fun_bc}, %s, bytecode_data_%s, %s, {%s}};'
+            % (name, self.rom.globals_dict.c_dict, rc.escaped_name, const_table, ', '.join(extra)))
+        if rc.prelude[2] & MP_SCOPE_FLAG_GENERATOR:
+            fun = name
+            name = self.rom.new_name('gen')
+            self.rom.lines.append('STATIC const mp_rom_obj_wrap_t %s = {{&mp_type_gen_wrap}, MP_ROM_PTR(&%s)};'
+                % (name, fun))
+        return 'MP_ROM_PTR(&%s)' % name
+
+class RomClosure(RomValue):
+    def __init__(self, rom, fun, closed):
+        RomValue.__init__(self, rom)
+        self.fun = fun
+        self.closed = closed
+
+    def emit(self):
+        fun = self.fun.ref()
+        closed = [c.ref() for c in self.closed]
+        name = self.rom.new_name('closure')
+        self.rom.lines.append('STATIC const mp_rom_obj_closure_t %s = {{&mp_type_closure}, %s, %u, {%s}};'
+            % (name, fun, len(closed), ', '.join(closed)))
+        return 'MP_ROM_PTR(&%s)' % name
+
+class RomCell(RomValue):
+    # the __class__ cell of a class body; it is only ever read once the class exists
+    def __init__(self, rom, cls):
+        RomValue.__init__(self, rom)
+        self.cls = cls
+
+    def emit(self):
+        cls = self.cls.ref()
+        name = self.rom.new_name('cell')
+        self.rom.lines.append('STATIC const mp_rom_obj_wrap_t %s = {{&mp_type_cell}, %s};' % (name, cls))
+        return 'MP_ROM_PTR(&%s)' % name
+
+class RomMethod(RomValue):
+    # staticmethod or classmethod
+    def __init__(self, rom, kind, fun):
+        RomValue.__init__(self, rom)
+        self.kind = kind
+        self.fun = fun
+
+    def emit(self):
+        fun = self.fun.ref()
+        name = self.rom.new_name(self.kind)
+        self.rom.lines.append('STATIC const mp_rom_obj_static_class_method_t %s = {{&mp_type_%s}, %s};'
+            % (name, self.kind, fun))
+        return 'MP_ROM_PTR(&%s)' % name
+
+class RomProperty(RomValue):
+    def __init__(self, rom, proxy):
+        RomValue.__init__(self, rom)
+        self.proxy = proxy
+
+    def emit(self):
+        proxy = [p.ref() if p else 'MP_ROM_PTR(&mp_const_none_obj)' for p in self.proxy]
+        name = self.rom.new_name('property')
+        self.rom.lines.append('STATIC const mp_rom_obj_property_t %s = {{&mp_type_property}, {%s}};'
+            % (name, ', '.join(proxy)))
+        return 'MP_ROM_PTR(&%s)' % name
+
+class RomDict:
+    def __init__(self, rom):
+        self.rom = rom
+        self.index = len(RomModule.all_dicts)
+        self.c_dict = '&mp_frozen_rom_dicts[%u]' % self.index
+        self.namespace = {}
+        self.order = []
+        RomModule.all_dicts.append(self)
+
+    def store(self, name, value):
+        if name not in self.namespace:
+            self.order.append(name)
+        self.namespace[name] = value
+
+    def emit(self):
+        # lay the table out the way mp_map_lookup probes it, leaving
+        # at least a quarter of the slots free so misses stay short
+        used = len(self.order)
+        alloc = used + (used + 2) // 3
+        alloc = min(a for a in hash_allocation_sizes if a >= alloc)
+        slots = [None] * alloc
+        for key in self.order:
+            value = self.namespace[key]
+            value = value.ref() if value is not None else 'MP_ROM_PTR(&mp_const_none_obj)'
+            pos = qstrutil.compute_hash(bytes_cons(key, 'utf8'), config.MICROPY_QSTR_BYTES_IN_HASH) % alloc
+            while slots[pos] is not None:
+                pos = (pos + 1) % alloc
+            slots[pos] = (key, value)
+        name = self.rom.new_name('table')
+        self.rom.lines.append('STATIC const mp_rom_map_elem_t %s[%u] = {' % (name, alloc))
+        for pos, slot in enumerate(slots):
+            if slot is not None:
+                self.rom.lines.append('    [%u] = { MP_ROM_QSTR(%s), %s },' % (pos, qstr_id(slot[0]), slot[1]))
+        self.rom.lines.append('};')
+        return '{%s, %s, %u, %u},' % (self.c_dict, name, alloc, used)
+
+class RomType(RomValue):
+    def __init__(self, rom, name, base):
+        RomValue.__init__(self, rom)
+        self.name = name
+        self.base = base
+        self.dict = RomDict(rom)
+        self.cell = RomCell(rom, self)
+
+    def emit(self):
+        if isinstance(self.base, RomType):
+            self.base.ref()
+            parent = '&' + self.base.c_name
+        else:
+            parent = self.base
+        name = self.rom.new_name('type_' + qstrutil.qstr_escape(self.name))
+        self.c_name = name
+        self.rom.lines.append('STATIC const mp_obj_type_t %s = {' % name)
+        self.rom.lines.append('    { &mp_type_type },')
+        self.rom.lines.append('    .name = %s,' % qstr_id(self.name))
+        self.rom.lines.append('    MP_OBJ_INSTANCE_TYPE_SLOTS,')
+        if parent:
+            self.rom.lines.append('    .parent = %s,' % parent)
+        self.rom.lines.append('    .locals_dict = %s,' % self.dict.c_dict)
+        self.rom.lines.append('};')
+        return 'MP_ROM_PTR(&%s)' % name
+
+class RomModule:
+    all_dicts = []
+
+    def __init__(self, rc):
+        self.rc = rc
+        path = rc.source_file.str
+        self.module_name = path[:-3].replace('/', '.')
+        self.lines = []
+        self.n_names = 0
+        self.imports = []
+        self.reason = None
+        self.c_prefix = 'rom_' + path.replace('/', '_')[:-3] + '_'
+        if not path.endswith('.py') or path.endswith('__init__.py'):
+            self.reason = 'packages run their code on import'
+            return
+        n_dicts = len(RomModule.all_dicts)
+        try:
+            self.globals_dict = RomDict(self)
+            self.globals_dict.store('__name__', self.const_qstr(self.module_name))
+            ret = self.run(rc, self.globals_dict, None)
+            if not (isinstance(ret, RomConst) and ret.value is None):
+                raise NotRomable('module returns a value')
+        except NotRomable as er:
+            self.reason = str(er)
+            del RomModule.all_dicts[n_dicts:]
+            return
+        add_qstr(self.module_name)
+
+    def new_name(self, kind):
+        self.n_names += 1
+        return '%s%s_%u' % (self.c_prefix, kind, self.n_names)
+
+    def const_qstr(self, s):
+        return RomConst(self, 'MP_ROM_QSTR(%s)' % qstr_id(s), s)
+
+    def load_name(self, name, namespaces):
+        for ns in namespaces:
+            if name in ns.namespace:
+                value = ns.namespace[name]
+                if value is None:
+                    raise NotRomable('%s is imported at run time' % name)
+                return value
+        if name in ROM_BASE_TYPES:
+            return RomMarker(self, 'builtin', name)
+        if name in ROM_DECORATORS:
+            return RomMarker(self, name)
+        raise NotRomable('%s is not known at freeze time' % name)
+
+    def store_name(self, ns, name, value):
+        if isinstance(value, RomMarker):
+            if value.kind == 'import':
+                if ns is not self.globals_dict:
+                    raise NotRomable('import in a class body')
+                module, attr = value.arg
+                self.unbind_import(name)
+                self.imports.append([module, attr, name])
+                ns.store(name, None)
+                return
+            if value.kind == 'builtin':
+                value = RomConst(self, 'MP_ROM_PTR(&mp_type_%s)' % value.arg, None)
+            else:
+                raise NotRomable('%s can not be stored' % value.kind)
+        if ns is self.globals_dict:
+            self.unbind_import(name)
+        ns.store(name, value)
+
+    def unbind_import(self, name):
+        # the import still runs, but a later statement owns the name
+        for imp in self.imports:
+            if imp[2] == name:
+                imp[2] = None
+
+    def call(self, fun, args):
+        if isinstance(fun, RomMarker) and fun.kind == 'build_class':
+            return self.build_class(args)
+        if len(args) == 1 and isinstance(args[0], (RomFun, RomClosure)):
+            if isinstance(fun, RomMarker) and fun.kind in ('staticmethod', 'classmethod'):
+                return RomMethod(self, fun.kind, args[0])
+            if isinstance(fun, RomMarker) and fun.kind == 'property':
+                return RomProperty(self, [args[0], None, None])
+            if isinstance(fun, RomMarker) and fun.kind == 'property_attr':
+                prop, i = fun.arg
+                proxy = list(prop.proxy)
+                proxy[i] = args[0]
+                return RomProperty(self, proxy)
+        raise NotRomable('call of %s' % fun.what())
+
+    def build_class(self, args):
+        if len(args) < 2 or not isinstance(args[0], RomFun) or args[0].defaults:
+            raise NotRomable('unsupported class definition')
+        body, name, bases = args[0].rc, args[1], args[2:]
+        if not isinstance(name, RomConst) or not isinstance(name.value, str):
+            raise NotRomable('class name is not a string')
+        if len(bases) > 1:
+            raise NotRomable('class %s has more than one base' % name.value)
+        base = None
+        if bases:
+            base = bases[0]
+            if isinstance(base, RomMarker) and base.kind == 'builtin':
+                base = '&mp_type_' + base.arg
+            elif not isinstance(base, RomType):
+                raise NotRomable('base of class %s is not known at freeze time' % name.value)
+        cls = RomType(self, name.value, base)
+        ret = self.run(body, cls.dict, cls)
+        if not (isinstance(ret, RomConst) and ret.value is None or isinstance(ret, RomCell)):
+            raise NotRomable('class %s returns a value' % name.value)
+        new = cls.dict.namespace.get('__new__')
+        if isinstance(new, (RomFun, RomClosure)):
+            # mp_obj_new_type does the same
+            cls.dict.namespace['__new__'] = RomMethod(self, 'staticmethod', new)
+        return cls
+
+    def run(self, rc, ns, cls):
+        # execute the module or class body code symbolically
+        bc = rc.bytecode
+        n_args = len(rc.qstrs)
+        n_objs = len(rc.objs)
+        ip, _ = decode_uint(bc, 0)
+        ip, _ = decode_uint(bc, ip)
+        ip += 4 + rc.prelude[6]
+        cells = bc[ip:rc.ip - 1]
+        ip = rc.ip
+        stack = []
+        while True:
+            op = bc[ip]
+            f, sz = mp_opcode_format(bc, ip)
+            if f == MP_OPCODE_QSTR:
+                qst = rc._unpack_qstr(ip + 1).str
+            elif f == MP_OPCODE_VAR_UINT:
+                _, arg = decode_uint(bc, ip + 1)
+            ip += sz
+            if op == MP_BC_LOAD_CONST_FALSE:
+                stack.append(RomConst(self, 'MP_ROM_PTR(&mp_const_false_obj)', False))
+            elif op == MP_BC_LOAD_CONST_NONE:
+                stack.append(RomConst(self, 'MP_ROM_PTR(&mp_const_none_obj)', None))
+            elif op == MP_BC_LOAD_CONST_TRUE:
+                stack.append(RomConst(self, 'MP_ROM_PTR(&mp_const_true_obj)', True))
+            elif op == MP_BC_LOAD_CONST_SMALL_INT or MP_BC_LOAD_CONST_SMALL_INT_MULTI <= op < MP_BC_LOAD_CONST_SMALL_INT_MULTI + 64:
+                if op == MP_BC_LOAD_CONST_SMALL_INT:
+                    i = ip - sz + 1
+                    num = -1 if bc[i] & 0x40 else 0
+                    while True:
+                        num = (num << 7) | (bc[i] & 0x7f)
+                        if not bc[i] & 0x80:
+                            break
+                        i += 1
+                else:
+                    num = op - MP_BC_LOAD_CONST_SMALL_INT_MULTI - 16
+                stack.append(RomConst(self, 'MP_ROM_INT(%d)' % num, num))
+            elif op == MP_BC_LOAD_CONST_STRING:
+                stack.append(self.const_qstr(qst))
+            elif op == MP_BC_LOAD_CONST_OBJ:
+                stack.append(RomObj(self, rc, arg - n_args))
+            elif op == MP_BC_LOAD_NULL:
+                stack.append(RomMarker(self, 'null'))
+            elif op == MP_BC_LOAD_FAST_N or MP_BC_LOAD_FAST_MULTI <= op < MP_BC_LOAD_FAST_MULTI + 16:
+                local = arg if op == MP_BC_LOAD_FAST_N else op - MP_BC_LOAD_FAST_MULTI
+                if cls is None or local not in cells:
+                    raise NotRomable('local variable in module code')
+                stack.append(cls.cell)
+            elif op == MP_BC_LOAD_NAME:
+                namespaces = [ns, self.globals_dict] if cls else [ns]
+                stack.append(self.load_name(qst, namespaces))
+            elif op == MP_BC_LOAD_ATTR:
+                obj = stack.pop()
+                attrs = ('getter', 'setter', 'deleter')
+                if not isinstance(obj, RomProperty) or qst not in attrs:
+                    raise NotRomable('attribute %s of %s' % (qst, obj.what()))
+                stack.append(RomMarker(self, 'property_attr', (obj, attrs.index(qst))))
+            elif op == MP_BC_LOAD_BUILD_CLASS:
+                stack.append(RomMarker(self, 'build_class'))
+            elif op == MP_BC_STORE_NAME:
+                self.store_name(ns, qst, stack.pop())
+            elif op == MP_BC_DUP_TOP:
+                stack.append(stack[-1])
+            elif op == MP_BC_POP_TOP:
+                stack.pop()
+            elif op == MP_BC_BUILD_TUPLE:
+                items = stack[len(stack) - arg:]
+                del stack[len(stack) - arg:]
+                for item in items:
+                    if isinstance(item, RomMarker):
+                        raise NotRomable('tuple of %s' % item.what())
+                stack.append(RomTuple(self, items))
+            elif op == MP_BC_RETURN_VALUE:
+                return stack.pop()
+            elif MP_BC_MAKE_FUNCTION <= op <= MP_BC_MAKE_CLOSURE_DEFARGS:
+                closed = []
+                if op in (MP_BC_MAKE_CLOSURE, MP_BC_MAKE_CLOSURE_DEFARGS):
+                    n_closed = bc[ip - 1]
+                    closed = stack[len(stack) - n_closed:]
+                    del stack[len(stack) - n_closed:]
+                    if not all(isinstance(c, RomCell) for c in closed):
+                        raise NotRomable('closure over a local variable')
+                defaults = None
+                if op in (MP_BC_MAKE_FUNCTION_DEFARGS, MP_BC_MAKE_CLOSURE_DEFARGS):
+                    kw_defaults = stack.pop()
+                    defaults = stack.pop()
+                    if not (isinstance(kw_defaults, RomMarker) and kw_defaults.kind == 'null'):
+                        raise NotRomable('keyword-only default arguments')
+                    if not isinstance(defaults, RomTuple):
+                        raise NotRomable('unsupported default arguments')
+                fun_rc = rc.raw_codes[arg - n_args - n_objs]
+                if isinstance(fun_rc, RawCodeNative):
+                    raise NotRomable('native code')
+                fun = RomFun(self, fun_rc, defaults)
+                if closed:
+                    fun = RomClosure(self, fun, closed)
+                stack.append(fun)
+            elif op == MP_BC_CALL_FUNCTION:
+                if arg >> 8:
+                    raise NotRomable('call with keyword arguments')
+                args = stack[len(stack) - arg:]
+                del stack[len(stack) - arg:]
+                stack.append(self.call(stack.pop(), args))
+            elif op == MP_BC_IMPORT_NAME:
+                fromlist = stack.pop()
+                level = stack.pop()
+                if not (isinstance(level, RomConst) and level.value == 0):
+                    raise NotRomable('relative import')
+                if isinstance(fromlist, RomConst) and fromlist.value is None:
+                    stack.append(RomMarker(self, 'import', (qst, None)))
+                elif isinstance(fromlist, RomTuple):
+                    stack.append(RomMarker(self, 'module', qst))
+                else:
+                    raise NotRomable('unsupported import')
+            elif op == MP_BC_IMPORT_FROM:
+                module = stack[-1]
+                stack.append(RomMarker(self, 'import', (module.arg, qst)))
+            else:
+                raise NotRomable('opcode 0x%02x in %s' % (op, rc.simple_name.str))
+
+    def freeze(self):
+        # emit the objects, then the tables which refer to them
+        dicts = [d for d in RomModule.all_dicts if d.rom is self]
+        entries = [d.emit() for d in dicts]
+        print()
+        print('// module %s, laid out in ROM' % self.module_name)
+        for line in self.lines:
+            print(line)
+        print('STATIC const mp_frozen_rom_dict_t %sdicts[%u] = {' % (self.c_prefix, len(entries)))
+        for entry in entries:
+            print('    %s' % entry)
+        print('};')
+        if self.imports:
+            print('STATIC const mp_frozen_rom_import_t %simports[%u] = {' % (self.c_prefix, len(self.imports)))
+            for module, attr, store in self.imports:
+                print('    {%s, %s, %s},' % (qstr_id(module), qstr_id(attr) if attr else 'MP_QSTR_NULL',
+                    qstr_id(store) if store else 'MP_QSTR_NULL'))
+            print('};')
+        print('STATIC const mp_obj_module_t %smodule = {{&mp_type_module}, %s};'
+            % (self.c_prefix, self.globals_dict.c_dict))
+        print('STATIC const mp_frozen_rom_module_t %srom = {&%smodule, %sdicts, %s, %u, %u};'
+            % (self.c_prefix, self.c_prefix, self.c_prefix,
+                self.c_prefix + 'imports' if self.imports else 'NULL', len(entries), len(self.imports)))
+
+def freeze_rom(rom_modules):
+    print()
+    print('#if MICROPY_MODULE_FROZEN_ROM')
+    print()
+    print('#include "py/objtype.h"')
+    print('#include "py/objtuple.h"')
+    print('#include "py/frozenmod.h"')
+    print()
+    print('#if MICROPY_QSTR_BYTES_IN_HASH != %u' % config.MICROPY_QSTR_BYTES_IN_HASH)
+    print('#error "incompatible MICROPY_QSTR_BYTES_IN_HASH"')
+    print('#endif')
+    print()
+    print('// layouts of objects private to the runtime')
+    print('typedef struct _mp_rom_obj_fun_bc_t {')
+    print('    mp_obj_base_t base;')
+    print('    mp_obj_dict_t *globals;')
+    print('    const byte *bytecode;')
+    print('    const mp_uint_t *const_table;')
+    print('    mp_rom_obj_t extra_args[];')
+    print('} mp_rom_obj_fun_bc_t;')
+    print('typedef struct _mp_rom_obj_closure_t {')
+    print('    mp_obj_base_t base;')
+    print('    mp_rom_obj_t fun;')
+    print('    size_t n_closed;')
+    print('    mp_rom_obj_t closed[];')
+    print('} mp_rom_obj_closure_t;')
+    print('typedef struct _mp_rom_obj_wrap_t {')
+    print('    mp_obj_base_t base;')
+    print('    mp_rom_obj_t obj;')
+    print('} mp_rom_obj_wrap_t;')
+    print('typedef struct _mp_rom_obj_property_t {')
+    print('    mp_obj_base_t base;')
+    print('    mp_rom_obj_t proxy[3];')
+    print('} mp_rom_obj_property_t;')
+
+    for rom in rom_modules:
+        if rom.reason:
+            print()
+            print('// module %s runs its code on import: %s' % (rom.module_name, rom.reason))
+        else:
+            try:
+                rom.freeze()
+            except NotRomable as er:
+                raise FreezeError(rom.rc, str(er))
+
+    print()
+    print('mp_obj_dict_t mp_frozen_rom_dicts[%u];' % max(1, len(RomModule.all_dicts)))
+    print('const size_t mp_frozen_rom_dicts_len = %u;' % len(RomModule.all_dicts))
+    print('const mp_frozen_rom_module_t *const mp_frozen_rom_content[] = {')
+    for rom in rom_modules:
+        if rom.reason:
+            print('    NULL,')
+        else:
+            print('    &%srom,' % rom.c_prefix)
+    print('};')
+    print()
+    print('#endif // MICROPY_MODULE_FROZEN_ROM')
+
 def read_uint(f):
     i = 0
     while True:
@@ -426,8 +1051,33 @@ def read_bytecode_qstrs(file, bytecode, ip):
             read_qstr_and_pack(file, bytecode, ip + 1)
         ip += sz
 
+def read_raw_code_native(f, kind, fun_len):
+    fun_data = bytearray(f.read(fun_len))
+    prelude = (read_uint(f), read_uint(f), read_uint(f)) # scope_flags, n_pos_args, type_sig or const table
+    links = []
+    for _ in range(read_uint(f)):
+        offset = read_uint(f)
+        link_kind = bytes_cons(f.read(1))[0]
+        if link_kind in (MP_NATIVE_LINK_FUN, MP_NATIVE_LINK_CONST):
+            arg = read_uint(f)
+        elif link_kind in (MP_NATIVE_LINK_QSTR, MP_NATIVE_LINK_QSTR_OBJ, MP_NATIVE_LINK_QSTR16):
+            arg = read_qstr(f)
+        elif link_kind == MP_NATIVE_LINK_OBJ:
+            arg = read_obj(f)
+        elif link_kind == MP_NATIVE_LINK_RAW_CODE:
+            arg = read_raw_code(f)
+        else:
+            raise Exception('invalid native link kind')
+        links.append((offset, link_kind, arg))
+    return RawCodeNative(kind, fun_data, prelude, links)
+
 def read_raw_code(f):
     bc_len = read_uint(f)
+    if config.mpy_version >= config.MPY_VERSION_NATIVE:
+        kind = bc_len & 3
+        bc_len >>= 2
+        if kind != MP_RAW_CODE_BYTECODE:
+            return read_raw_code_native(f, kind, bc_len)
     bytecode = bytearray(f.read(bc_len))
     ip, ip2, prelude = extract_prelude(bytecode)
     read_qstr_and_pack(f, bytecode, ip2) # simple_name
@@ -445,9 +1095,11 @@ def read_mpy(filename):
         header = bytes_cons(f.read(4))
         if header[0] != ord('M'):
             raise Exception('not a valid .mpy file')
-        if header[1] != config.MPY_VERSION:
+        if not config.MPY_VERSION_MIN <= header[1] <= config.MPY_VERSION:
             raise Exception('incompatible .mpy version')
+        config.mpy_version = header[1]
         feature_flags = header[2]
+        config.mpy_native_arch = feature_flags >> 2
         config.MICROPY_OPT_CACHE_MAP_LOOKUP_IN_BYTECODE = (feature_flags & 1) != 0
         config.MICROPY_PY_BUILTINS_STR_UNICODE = (feature_flags & 2) != 0
         config.mp_small_int_bits = header[3]
@@ -458,6 +1110,9 @@ def dump_mpy(raw_codes):
         rc.dump()
 
 def freeze_mpy(base_qstrs, raw_codes):
+    # evaluate the modules first, laying them out may need extra qstrs
+    rom_modules = [RomModule(rc) for rc in raw_codes]
+
     # add to qstrs
     new = {}
     for q in global_qstrs:
@@ -544,6 +1199,8 @@ def freeze_mpy(base_qstrs, raw_codes):
         print('    &raw_code_%s,' % rc.escaped_name)
     print('};')
 
+    freeze_rom(rom_modules)
+
 def main():
     import argparse
     cmd_parser = argparse.ArgumentParser(description='A tool to work with MicroPython .mpy files.')
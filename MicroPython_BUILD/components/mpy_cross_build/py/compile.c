@@ -35,6 +35,7 @@
 #include "py/compile.h"
 #include "py/runtime.h"
 #include "py/asmbase.h"
+#include "py/persistentcode.h"
 
 #if MICROPY_ENABLE_COMPILER
 
@@ -78,8 +79,48 @@ typedef enum {
 
 #endif
 
-#if MICROPY_EMIT_NATIVE
+#if MICROPY_EMIT_NATIVE && MICROPY_DYNAMIC_COMPILER
+// the native emitter is selected at runtime from the target architecture
+
+typedef struct _emit_native_table_t {
+    emit_t *(*emit_new)(mp_obj_t *error_slot, mp_uint_t max_num_labels);
+    void (*emit_free)(emit_t *emit);
+    const emit_method_table_t *emit_method_table;
+} emit_native_table_t;
+
+#define NATIVE_EMITTER_ENTRY(arch) { emit_native_##arch##_new, emit_native_##arch##_free, &emit_native_##arch##_method_table }
+
+STATIC const emit_native_table_t emit_native_table[] = {
+    [MP_NATIVE_ARCH_NONE] = { NULL, NULL, NULL },
+    #if MICROPY_EMIT_X86
+    [MP_NATIVE_ARCH_X86] = NATIVE_EMITTER_ENTRY(x86),
+    #endif
+    #if MICROPY_EMIT_X64
+    [MP_NATIVE_ARCH_X64] = NATIVE_EMITTER_ENTRY(x64),
+    #endif
+    #if MICROPY_EMIT_ARM
+    [MP_NATIVE_ARCH_ARM] = NATIVE_EMITTER_ENTRY(arm),
+    #endif
+    #if MICROPY_EMIT_THUMB
+    [MP_NATIVE_ARCH_THUMB] = NATIVE_EMITTER_ENTRY(thumb),
+    #endif
+    #if MICROPY_EMIT_XTENSA
+    [MP_NATIVE_ARCH_XTENSA] = NATIVE_EMITTER_ENTRY(xtensa),
+    #endif
+    #if MICROPY_EMIT_XTENSAWIN
+    [MP_NATIVE_ARCH_XTENSAWIN] = NATIVE_EMITTER_ENTRY(xtensawin),
+    #endif
+};
+
+#define NATIVE_EMITTER_AVAILABLE (mp_dynamic_compiler.native_arch < MP_ARRAY_SIZE(emit_native_table) \
+    && emit_native_table[mp_dynamic_compiler.native_arch].emit_new != NULL)
+#define NATIVE_EMITTER(f) emit_native_table[mp_dynamic_compiler.native_arch].emit_##f
+#define NATIVE_EMITTER_TABLE (emit_native_table[mp_dynamic_compiler.native_arch].emit_method_table)
+
+#elif MICROPY_EMIT_NATIVE
 // define a macro to access external native emitter
+#define NATIVE_EMITTER_AVAILABLE (1)
+#define NATIVE_EMITTER_TABLE (&NATIVE_EMITTER(method_table))
 #if MICROPY_EMIT_X64
 #define NATIVE_EMITTER(f) emit_native_x64_##f
 #elif MICROPY_EMIT_X86
@@ -90,6 +131,8 @@ typedef enum {
 #define NATIVE_EMITTER(f) emit_native_arm_##f
 #elif MICROPY_EMIT_XTENSA
 #define NATIVE_EMITTER(f) emit_native_xtensa_##f
+#elif MICROPY_EMIT_XTENSAWIN
+#define NATIVE_EMITTER(f) emit_native_xtensawin_##f
 #else
 #error "unknown native emitter"
 #endif
@@ -3257,7 +3300,11 @@ STATIC void compile_scope_inline_asm(compiler_t *comp, scope_t *scope, pass_kind
             void *f = mp_asm_base_get_code((mp_asm_base_t*)comp->emit_inline_asm);
             mp_emit_glue_assign_native(comp->scope_cur->raw_code, MP_CODE_NATIVE_ASM,
                 f, mp_asm_base_get_code_size((mp_asm_base_t*)comp->emit_inline_asm),
-                NULL, comp->scope_cur->num_pos_args, 0, type_sig);
+                NULL,
+                #if MICROPY_PERSISTENT_CODE_SAVE
+                NULL, 0,
+                #endif
+                comp->scope_cur->num_pos_args, 0, type_sig);
         }
     }
 
@@ -3435,10 +3482,16 @@ mp_raw_code_t *mp_compile_to_raw_code(mp_parse_tree_t *parse_tree, qstr source_f
 #if MICROPY_EMIT_NATIVE
                 case MP_EMIT_OPT_NATIVE_PYTHON:
                 case MP_EMIT_OPT_VIPER:
+                    if (!NATIVE_EMITTER_AVAILABLE) {
+                        // no native emitter for the selected architecture
+                        comp->scope_cur = s;
+                        compile_syntax_error(comp, s->pn, "invalid arch");
+                        continue;
+                    }
                     if (emit_native == NULL) {
                         emit_native = NATIVE_EMITTER(new)(&comp->compile_error, max_num_labels);
                     }
-                    comp->emit_method_table = &NATIVE_EMITTER(method_table);
+                    comp->emit_method_table = NATIVE_EMITTER_TABLE;
                     comp->emit = emit_native;
                     EMIT_ARG(set_native_type, MP_EMIT_NATIVE_TYPE_ENABLE, s->emit_options == MP_EMIT_OPT_VIPER, 0);
                     break;
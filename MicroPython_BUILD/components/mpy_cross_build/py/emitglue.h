@@ -39,6 +39,34 @@ typedef enum {
     MP_CODE_NATIVE_ASM,
 } mp_raw_code_kind_t;
 
+// Kinds of the values in native code which depend on the running firmware
+// and are linked when the code is loaded from a .mpy file
+typedef enum {
+    MP_NATIVE_LINK_FUN,         // entry of mp_fun_table, arg is the index
+    MP_NATIVE_LINK_CONST,       // a constant object, arg is MP_NATIVE_CONST_xxx
+    MP_NATIVE_LINK_QSTR,        // a qstr, arg is the qstr
+    MP_NATIVE_LINK_QSTR_OBJ,    // a qstr object, arg is the qstr
+    MP_NATIVE_LINK_QSTR16,      // a 16-bit qstr in the prelude, arg is the qstr
+    MP_NATIVE_LINK_OBJ,         // a constant object, arg is the object
+    MP_NATIVE_LINK_RAW_CODE,    // a child raw code, arg is the raw code
+} mp_native_link_kind_t;
+
+// Constant objects referenced by native code
+typedef enum {
+    MP_NATIVE_CONST_NONE,
+    MP_NATIVE_CONST_FALSE,
+    MP_NATIVE_CONST_TRUE,
+    MP_NATIVE_CONST_ELLIPSIS,
+    MP_NATIVE_CONST_STOP_ITERATION, // these special objects depend on NDEBUG
+    MP_NATIVE_CONST_SENTINEL,
+} mp_native_const_t;
+
+typedef struct _mp_native_link_t {
+    uint32_t offset; // offset of the value in the machine code
+    uint32_t kind; // of type mp_native_link_kind_t
+    mp_uint_t arg;
+} mp_native_link_t;
+
 typedef struct _mp_raw_code_t {
     mp_raw_code_kind_t kind : 3;
     mp_uint_t scope_flags : 7;
@@ -55,8 +83,16 @@ typedef struct _mp_raw_code_t {
         } u_byte;
         struct {
             void *fun_data;
+            #if defined(MP_PLAT_COMMIT_EXEC)
+            void *fun_exec; // address the code is executed from
+            #endif
             const mp_uint_t *const_table;
             mp_uint_t type_sig; // for viper, compressed as 2-bit types; ret is MSB, then arg0, arg1, etc
+            #if MICROPY_PERSISTENT_CODE_SAVE
+            mp_uint_t fun_len;
+            const mp_native_link_t *link;
+            size_t n_link;
+            #endif
         } u_native;
     } data;
 } mp_raw_code_t;
@@ -69,7 +105,11 @@ void mp_emit_glue_assign_bytecode(mp_raw_code_t *rc, const byte *code, mp_uint_t
     uint16_t n_obj, uint16_t n_raw_code,
     #endif
     mp_uint_t scope_flags);
-void mp_emit_glue_assign_native(mp_raw_code_t *rc, mp_raw_code_kind_t kind, void *fun_data, mp_uint_t fun_len, const mp_uint_t *const_table, mp_uint_t n_pos_args, mp_uint_t scope_flags, mp_uint_t type_sig);
+void mp_emit_glue_assign_native(mp_raw_code_t *rc, mp_raw_code_kind_t kind, void *fun_data, mp_uint_t fun_len, const mp_uint_t *const_table,
+    #if MICROPY_PERSISTENT_CODE_SAVE
+    const mp_native_link_t *link, size_t n_link,
+    #endif
+    mp_uint_t n_pos_args, mp_uint_t scope_flags, mp_uint_t type_sig);
 
 mp_obj_t mp_make_function_from_raw_code(const mp_raw_code_t *rc, mp_obj_t def_args, mp_obj_t def_kw_args);
 mp_obj_t mp_make_closure_from_raw_code(const mp_raw_code_t *rc, mp_uint_t n_closed_over, const mp_obj_t *args);
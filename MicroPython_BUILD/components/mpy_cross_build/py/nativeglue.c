@@ -173,6 +173,7 @@ void *const mp_fun_table[MP_F_NUMBER_OF] = {
     mp_setup_code_state,
     mp_small_int_floor_divide,
     mp_small_int_modulo,
+    NULL, // setjmp, only called by code running on the target
 };
 
 /*
@@ -370,12 +370,21 @@ mp_obj_t mp_obj_new_fun_bc(mp_obj_t def_args_in, mp_obj_t def_kw_args, const byt
 /******************************************************************************/
 /* native functions                                                           */
 
+#if MICROPY_EMIT_NATIVE || MICROPY_EMIT_INLINE_ASM
+// The port may execute a copy of the code, made when the code was committed
+#if defined(MP_PLAT_COMMIT_EXEC)
+#define FUN_EXEC(self, data) ((void*)(self)->fun_exec)
+#else
+#define FUN_EXEC(self, data) ((void*)(data))
+#endif
+#endif
+
 #if MICROPY_EMIT_NATIVE
 
 STATIC mp_obj_t fun_native_call(mp_obj_t self_in, size_t n_args, size_t n_kw, const mp_obj_t *args) {
     MP_STACK_CHECK();
     mp_obj_fun_bc_t *self = self_in;
-    mp_call_fun_t fun = MICROPY_MAKE_POINTER_CALLABLE((void*)self->bytecode);
+    mp_call_fun_t fun = MICROPY_MAKE_POINTER_CALLABLE(FUN_EXEC(self, self->bytecode));
     return fun(self_in, n_args, n_kw, args);
 }
 
@@ -386,8 +395,13 @@ STATIC const mp_obj_type_t mp_type_fun_native = {
     .unary_op = mp_generic_unary_op,
 };
 
-mp_obj_t mp_obj_new_fun_native(mp_obj_t def_args_in, mp_obj_t def_kw_args, const void *fun_data, const mp_uint_t *const_table) {
+mp_obj_t mp_obj_new_fun_native(mp_obj_t def_args_in, mp_obj_t def_kw_args, const void *fun_data, const void *fun_exec, const mp_uint_t *const_table) {
     mp_obj_fun_bc_t *o = mp_obj_new_fun_bc(def_args_in, def_kw_args, (const byte*)fun_data, const_table);
+    #if defined(MP_PLAT_COMMIT_EXEC)
+    o->fun_exec = fun_exec;
+    #else
+    (void)fun_exec;
+    #endif
     o->base.type = &mp_type_fun_native;
     return o;
 }
@@ -403,6 +417,9 @@ typedef struct _mp_obj_fun_viper_t {
     mp_obj_base_t base;
     size_t n_args;
     void *fun_data; // GC must be able to trace this pointer
+    #if defined(MP_PLAT_COMMIT_EXEC)
+    const void *fun_exec;
+    #endif
     mp_uint_t type_sig;
 } mp_obj_fun_viper_t;
 
@@ -417,7 +434,7 @@ STATIC mp_obj_t fun_viper_call(mp_obj_t self_in, size_t n_args, size_t n_kw, con
 
     mp_arg_check_num(n_args, n_kw, self->n_args, self->n_args, false);
 
-    void *fun = MICROPY_MAKE_POINTER_CALLABLE(self->fun_data);
+    void *fun = MICROPY_MAKE_POINTER_CALLABLE(FUN_EXEC(self, self->fun_data));
 
     mp_uint_t ret;
     if (n_args == 0) {
@@ -449,11 +466,16 @@ STATIC const mp_obj_type_t mp_type_fun_viper = {
     .unary_op = mp_generic_unary_op,
 };
 
-mp_obj_t mp_obj_new_fun_viper(size_t n_args, void *fun_data, mp_uint_t type_sig) {
+mp_obj_t mp_obj_new_fun_viper(size_t n_args, void *fun_data, const void *fun_exec, mp_uint_t type_sig) {
     mp_obj_fun_viper_t *o = m_new_obj(mp_obj_fun_viper_t);
     o->base.type = &mp_type_fun_viper;
     o->n_args = n_args;
     o->fun_data = fun_data;
+    #if defined(MP_PLAT_COMMIT_EXEC)
+    o->fun_exec = fun_exec;
+    #else
+    (void)fun_exec;
+    #endif
     o->type_sig = type_sig;
     return o;
 }
@@ -469,6 +491,9 @@ typedef struct _mp_obj_fun_asm_t {
     mp_obj_base_t base;
     size_t n_args;
     void *fun_data; // GC must be able to trace this pointer
+    #if defined(MP_PLAT_COMMIT_EXEC)
+    const void *fun_exec;
+    #endif
     mp_uint_t type_sig;
 } mp_obj_fun_asm_t;
 
@@ -527,7 +552,7 @@ STATIC mp_obj_t fun_asm_call(mp_obj_t self_in, size_t n_args, size_t n_kw, const
 
     mp_arg_check_num(n_args, n_kw, self->n_args, self->n_args, false);
 
-    void *fun = MICROPY_MAKE_POINTER_CALLABLE(self->fun_data);
+    void *fun = MICROPY_MAKE_POINTER_CALLABLE(FUN_EXEC(self, self->fun_data));
 
     mp_uint_t ret;
     if (n_args == 0) {
@@ -559,11 +584,16 @@ STATIC const mp_obj_type_t mp_type_fun_asm = {
     .unary_op = mp_generic_unary_op,
 };
 
-mp_obj_t mp_obj_new_fun_asm(size_t n_args, void *fun_data, mp_uint_t type_sig) {
+mp_obj_t mp_obj_new_fun_asm(size_t n_args, void *fun_data, const void *fun_exec, mp_uint_t type_sig) {
     mp_obj_fun_asm_t *o = m_new_obj(mp_obj_fun_asm_t);
     o->base.type = &mp_type_fun_asm;
     o->n_args = n_args;
     o->fun_data = fun_data;
+    #if defined(MP_PLAT_COMMIT_EXEC)
+    o->fun_exec = fun_exec;
+    #else
+    (void)fun_exec;
+    #endif
     o->type_sig = type_sig;
     return o;
 }
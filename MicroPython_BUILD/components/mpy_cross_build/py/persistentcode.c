@@ -33,13 +33,25 @@
 #include "py/emitglue.h"
 #include "py/persistentcode.h"
 #include "py/bc.h"
+#include "py/runtime0.h"
 
 #if MICROPY_PERSISTENT_CODE_LOAD || MICROPY_PERSISTENT_CODE_SAVE
 
 #include "py/smallint.h"
 
 // The current version of .mpy files
-#define MPY_VERSION (3)
+#define MPY_VERSION (5)
+// The oldest version which can still be loaded, version 3 files only lack
+// the superinstructions emitted by the bytecode peephole optimiser and
+// version 4 files lack the kind of each raw code
+#define MPY_VERSION_MIN (3)
+// The first version that can contain native code
+#define MPY_VERSION_NATIVE (5)
+
+// Kind of the raw code, stored in the low bits of its length
+#define MPY_RAW_CODE_BYTECODE (0)
+#define MPY_RAW_CODE_NATIVE_PY (1)
+#define MPY_RAW_CODE_NATIVE_VIPER (2)
 
 // The feature flags byte encodes the compile-time config options that
 // affect the generate bytecode.
@@ -52,6 +64,26 @@
     ((MICROPY_OPT_CACHE_MAP_LOOKUP_IN_BYTECODE_DYNAMIC) << 0) \
     | ((MICROPY_PY_BUILTINS_STR_UNICODE_DYNAMIC) << 1) \
     )
+#define MPY_FEATURE_FLAGS_MASK (0x03)
+
+// The native architecture is stored in the feature flags byte above the flags
+// and is non-zero only if the file contains machine code.  Only the emitters
+// which can generate linkable code (see emitnative.c) are supported.
+#define MPY_FEATURE_ARCH_SHIFT (2)
+#if MICROPY_EMIT_X64
+#define MPY_FEATURE_ARCH (MP_NATIVE_ARCH_X64)
+#elif MICROPY_EMIT_XTENSAWIN
+#define MPY_FEATURE_ARCH (MP_NATIVE_ARCH_XTENSAWIN)
+#elif MICROPY_EMIT_XTENSA
+#define MPY_FEATURE_ARCH (MP_NATIVE_ARCH_XTENSA)
+#else
+#define MPY_FEATURE_ARCH (MP_NATIVE_ARCH_NONE)
+#endif
+#if MICROPY_DYNAMIC_COMPILER
+#define MPY_FEATURE_ARCH_DYNAMIC (mp_dynamic_compiler.native_arch)
+#else
+#define MPY_FEATURE_ARCH_DYNAMIC (MPY_FEATURE_ARCH)
+#endif
 
 #if MICROPY_PERSISTENT_CODE_LOAD || (MICROPY_PERSISTENT_CODE_SAVE && !MICROPY_DYNAMIC_COMPILER)
 // The bytecode will depend on the number of bits in a small-int, and
@@ -164,9 +196,117 @@ STATIC void load_bytecode_qstrs(mp_reader_t *reader, byte *ip, byte *ip_top) {
     }
 }
 
-STATIC mp_raw_code_t *load_raw_code(mp_reader_t *reader) {
-    // load bytecode
+STATIC mp_raw_code_t *load_raw_code(mp_reader_t *reader, byte version);
+
+#if MPY_FEATURE_ARCH != MP_NATIVE_ARCH_NONE
+
+STATIC mp_uint_t load_native_const(size_t c) {
+    switch (c) {
+        case MP_NATIVE_CONST_NONE: return (mp_uint_t)mp_const_none;
+        case MP_NATIVE_CONST_FALSE: return (mp_uint_t)mp_const_false;
+        case MP_NATIVE_CONST_TRUE: return (mp_uint_t)mp_const_true;
+        case MP_NATIVE_CONST_ELLIPSIS: return (mp_uint_t)&mp_const_ellipsis_obj;
+        case MP_NATIVE_CONST_STOP_ITERATION: return (mp_uint_t)MP_OBJ_STOP_ITERATION;
+        case MP_NATIVE_CONST_SENTINEL: return (mp_uint_t)MP_OBJ_SENTINEL;
+        default: mp_raise_ValueError("incompatible .mpy file");
+    }
+}
+
+STATIC mp_raw_code_t *load_raw_code_native(mp_reader_t *reader, byte version, mp_raw_code_kind_t kind, size_t fun_len) {
+    // load the machine code into memory where it can be linked
+    byte *fun_data;
+    size_t fun_alloc;
+    MP_PLAT_ALLOC_EXEC(fun_len, (void**)&fun_data, &fun_alloc);
+    read_bytes(reader, fun_data, fun_len);
+
+    size_t scope_flags = read_uint(reader);
+    size_t n_pos_args = read_uint(reader);
+    size_t type_sig = 0;
+    size_t const_table_offset = 0;
+    if (kind == MP_CODE_NATIVE_VIPER) {
+        type_sig = read_uint(reader);
+    } else {
+        const_table_offset = read_uint(reader);
+    }
+
+    // link the values which depend on the running firmware
+    size_t n_link = read_uint(reader);
+    for (size_t i = 0; i < n_link; ++i) {
+        size_t offset = read_uint(reader);
+        byte link_kind = read_byte(reader);
+        if (offset + (link_kind == MP_NATIVE_LINK_QSTR16 ? 2 : sizeof(mp_uint_t)) > fun_len) {
+            mp_raise_ValueError("incompatible .mpy file");
+        }
+        mp_uint_t val;
+        switch (link_kind) {
+            case MP_NATIVE_LINK_FUN: {
+                size_t f = read_uint(reader);
+                if (f >= MP_F_NUMBER_OF) {
+                    mp_raise_ValueError("incompatible .mpy file");
+                }
+                val = (mp_uint_t)mp_fun_table[f];
+                break;
+            }
+            case MP_NATIVE_LINK_CONST:
+                val = load_native_const(read_uint(reader));
+                break;
+            case MP_NATIVE_LINK_QSTR:
+                val = load_qstr(reader);
+                break;
+            case MP_NATIVE_LINK_QSTR_OBJ:
+                val = (mp_uint_t)MP_OBJ_NEW_QSTR(load_qstr(reader));
+                break;
+            case MP_NATIVE_LINK_QSTR16: {
+                qstr qst = load_qstr(reader);
+                fun_data[offset] = qst;
+                fun_data[offset + 1] = qst >> 8;
+                continue;
+            }
+            case MP_NATIVE_LINK_OBJ:
+                val = (mp_uint_t)load_obj(reader);
+                break;
+            case MP_NATIVE_LINK_RAW_CODE:
+                val = (mp_uint_t)(uintptr_t)load_raw_code(reader, version);
+                break;
+            default:
+                mp_raise_ValueError("incompatible .mpy file");
+        }
+        // the words may be unaligned (eg in x64 instructions), store a byte at a time
+        for (size_t j = 0; j < sizeof(mp_uint_t); ++j) {
+            fun_data[offset + j] = val;
+            val >>= 8;
+        }
+    }
+
+    // the code is complete, it is made executable when assigned to the raw code
+    mp_raw_code_t *rc = mp_emit_glue_new_raw_code();
+    mp_emit_glue_assign_native(rc, kind, fun_data, fun_len, (mp_uint_t*)(fun_data + const_table_offset),
+        #if MICROPY_PERSISTENT_CODE_SAVE
+        NULL, 0,
+        #endif
+        n_pos_args, scope_flags, type_sig);
+    return rc;
+}
+
+#endif
+
+STATIC mp_raw_code_t *load_raw_code(mp_reader_t *reader, byte version) {
+    // the kind of the raw code is stored with its length since version 5
     size_t bc_len = read_uint(reader);
+    if (version >= MPY_VERSION_NATIVE) {
+        uint kind = bc_len & 3;
+        bc_len >>= 2;
+        if (kind != MPY_RAW_CODE_BYTECODE) {
+            #if MPY_FEATURE_ARCH != MP_NATIVE_ARCH_NONE
+            return load_raw_code_native(reader, version,
+                kind == MPY_RAW_CODE_NATIVE_PY ? MP_CODE_NATIVE_PY : MP_CODE_NATIVE_VIPER, bc_len);
+            #else
+            mp_raise_ValueError("incompatible .mpy arch");
+            #endif
+        }
+    }
+
+    // load bytecode
     byte *bytecode = m_new(byte, bc_len);
     read_bytes(reader, bytecode, bc_len);
 
@@ -195,7 +335,7 @@ STATIC mp_raw_code_t *load_raw_code(mp_reader_t *reader) {
         *ct++ = (mp_uint_t)load_obj(reader);
     }
     for (size_t i = 0; i < n_raw_code; ++i) {
-        *ct++ = (mp_uint_t)(uintptr_t)load_raw_code(reader);
+        *ct++ = (mp_uint_t)(uintptr_t)load_raw_code(reader, version);
     }
 
     // create raw_code and return it
@@ -212,12 +352,17 @@ mp_raw_code_t *mp_raw_code_load(mp_reader_t *reader) {
     byte header[4];
     read_bytes(reader, header, sizeof(header));
     if (header[0] != 'M'
-        || header[1] != MPY_VERSION
-        || header[2] != MPY_FEATURE_FLAGS
+        || header[1] < MPY_VERSION_MIN
+        || header[1] > MPY_VERSION
+        || (header[2] & MPY_FEATURE_FLAGS_MASK) != MPY_FEATURE_FLAGS
         || header[3] > mp_small_int_bits()) {
         mp_raise_ValueError("incompatible .mpy file");
     }
-    mp_raw_code_t *rc = load_raw_code(reader);
+    byte arch = header[2] >> MPY_FEATURE_ARCH_SHIFT;
+    if (arch != MP_NATIVE_ARCH_NONE && arch != MPY_FEATURE_ARCH) {
+        mp_raise_ValueError("incompatible .mpy arch");
+    }
+    mp_raw_code_t *rc = load_raw_code(reader, header[1]);
     reader->close(reader->data);
     return rc;
 }
@@ -316,13 +461,65 @@ STATIC void save_bytecode_qstrs(mp_print_t *print, const byte *ip, const byte *i
     }
 }
 
+STATIC void save_raw_code(mp_print_t *print, mp_raw_code_t *rc);
+
+#if MICROPY_EMIT_NATIVE
+STATIC void save_raw_code_native(mp_print_t *print, mp_raw_code_t *rc) {
+    // save machine code
+    mp_print_uint(print, (rc->data.u_native.fun_len << 2)
+        | (rc->kind == MP_CODE_NATIVE_PY ? MPY_RAW_CODE_NATIVE_PY : MPY_RAW_CODE_NATIVE_VIPER));
+    mp_print_bytes(print, rc->data.u_native.fun_data, rc->data.u_native.fun_len);
+
+    mp_print_uint(print, rc->scope_flags);
+    mp_print_uint(print, rc->n_pos_args);
+    if (rc->kind == MP_CODE_NATIVE_VIPER) {
+        mp_print_uint(print, rc->data.u_native.type_sig);
+    } else {
+        mp_print_uint(print, (const byte*)rc->data.u_native.const_table - (const byte*)rc->data.u_native.fun_data);
+    }
+
+    // save the values to be linked by the loader
+    mp_print_uint(print, rc->data.u_native.n_link);
+    for (size_t i = 0; i < rc->data.u_native.n_link; ++i) {
+        const mp_native_link_t *link = &rc->data.u_native.link[i];
+        byte kind = link->kind;
+        mp_print_uint(print, link->offset);
+        mp_print_bytes(print, &kind, 1);
+        switch (link->kind) {
+            case MP_NATIVE_LINK_FUN:
+            case MP_NATIVE_LINK_CONST:
+                mp_print_uint(print, link->arg);
+                break;
+            case MP_NATIVE_LINK_QSTR:
+            case MP_NATIVE_LINK_QSTR_OBJ:
+            case MP_NATIVE_LINK_QSTR16:
+                save_qstr(print, link->arg);
+                break;
+            case MP_NATIVE_LINK_OBJ:
+                save_obj(print, (mp_obj_t)link->arg);
+                break;
+            default:
+                assert(link->kind == MP_NATIVE_LINK_RAW_CODE);
+                save_raw_code(print, (mp_raw_code_t*)(uintptr_t)link->arg);
+                break;
+        }
+    }
+}
+#endif
+
 STATIC void save_raw_code(mp_print_t *print, mp_raw_code_t *rc) {
+    #if MICROPY_EMIT_NATIVE
+    if (rc->kind == MP_CODE_NATIVE_PY || rc->kind == MP_CODE_NATIVE_VIPER) {
+        save_raw_code_native(print, rc);
+        return;
+    }
+    #endif
     if (rc->kind != MP_CODE_BYTECODE) {
         mp_raise_ValueError("can only save bytecode");
     }
 
     // save bytecode
-    mp_print_uint(print, rc->data.u_byte.bc_len);
+    mp_print_uint(print, (rc->data.u_byte.bc_len << 2) | MPY_RAW_CODE_BYTECODE);
     mp_print_bytes(print, rc->data.u_byte.bytecode, rc->data.u_byte.bc_len);
 
     // extract prelude
@@ -352,13 +549,41 @@ STATIC void save_raw_code(mp_print_t *print, mp_raw_code_t *rc) {
     }
 }
 
+// check if the raw code or any of its children is machine code
+STATIC bool raw_code_has_native(const mp_raw_code_t *rc) {
+    if (rc->kind == MP_CODE_BYTECODE) {
+        const byte *ip = rc->data.u_byte.bytecode;
+        const byte *ip2;
+        bytecode_prelude_t prelude;
+        extract_prelude(&ip, &ip2, &prelude);
+        const mp_uint_t *ct = rc->data.u_byte.const_table
+            + prelude.n_pos_args + prelude.n_kwonly_args + rc->data.u_byte.n_obj;
+        for (uint i = 0; i < rc->data.u_byte.n_raw_code; ++i) {
+            if (raw_code_has_native((const mp_raw_code_t*)(uintptr_t)ct[i])) {
+                return true;
+            }
+        }
+        return false;
+    }
+    return true;
+}
+
 void mp_raw_code_save(mp_raw_code_t *rc, mp_print_t *print) {
+    // machine code can only be saved if the emitter records what to link
+    byte arch = MP_NATIVE_ARCH_NONE;
+    if (raw_code_has_native(rc)) {
+        arch = MPY_FEATURE_ARCH_DYNAMIC;
+        if (arch != MP_NATIVE_ARCH_X64 && arch != MP_NATIVE_ARCH_XTENSA && arch != MP_NATIVE_ARCH_XTENSAWIN) {
+            mp_raise_ValueError("can't save native code for this arch");
+        }
+    }
+
     // header contains:
     //  byte  'M'
     //  byte  version
-    //  byte  feature flags
+    //  byte  feature flags, native arch in the upper bits
     //  byte  number of bits in a small int
-    byte header[4] = {'M', MPY_VERSION, MPY_FEATURE_FLAGS_DYNAMIC,
+    byte header[4] = {'M', MPY_VERSION, MPY_FEATURE_FLAGS_DYNAMIC | (arch << MPY_FEATURE_ARCH_SHIFT),
         #if MICROPY_DYNAMIC_COMPILER
         mp_dynamic_compiler.small_int_bits,
         #else
@@ -370,11 +595,12 @@ void mp_raw_code_save(mp_raw_code_t *rc, mp_print_t *print) {
     save_raw_code(print, rc);
 }
 
-// here we define mp_raw_code_save_file depending on the port
+// here we define mp_raw_code_save_file_with_header depending on the port
 // TODO abstract this away properly
 
 #if defined(__i386__) || defined(__x86_64__) || defined(__unix__)
 
+#include <errno.h>
 #include <unistd.h>
 #include <sys/stat.h>
 #include <fcntl.h>
@@ -385,15 +611,51 @@ STATIC void fd_print_strn(void *env, const char *str, size_t len) {
     (void)ret;
 }
 
-void mp_raw_code_save_file(mp_raw_code_t *rc, const char *filename) {
+void mp_raw_code_save_file_with_header(mp_raw_code_t *rc, const char *filename, const byte *header, size_t header_len) {
     int fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        mp_raise_OSError(errno);
+    }
     mp_print_t fd_print = {(void*)(intptr_t)fd, fd_print_strn};
-    mp_raw_code_save(rc, &fd_print);
-    close(fd);
+    nlr_buf_t nlr;
+    if (nlr_push(&nlr) == 0) {
+        mp_print_bytes(&fd_print, header, header_len);
+        mp_raw_code_save(rc, &fd_print);
+        nlr_pop();
+        close(fd);
+    } else {
+        close(fd);
+        nlr_jump(nlr.ret_val);
+    }
+}
+
+#elif MICROPY_VFS
+
+#include "py/stream.h"
+#include "extmod/vfs.h"
+
+void mp_raw_code_save_file_with_header(mp_raw_code_t *rc, const char *filename, const byte *header, size_t header_len) {
+    mp_obj_t args[2] = {mp_obj_new_str(filename, strlen(filename)), MP_OBJ_NEW_QSTR(MP_QSTR_wb)};
+    mp_obj_t file = mp_vfs_open(2, args, (mp_map_t*)&mp_const_empty_map);
+    mp_print_t file_print = {MP_OBJ_TO_PTR(file), mp_stream_write_adaptor};
+    nlr_buf_t nlr;
+    if (nlr_push(&nlr) == 0) {
+        mp_print_bytes(&file_print, header, header_len);
+        mp_raw_code_save(rc, &file_print);
+        nlr_pop();
+        mp_stream_close(file);
+    } else {
+        mp_stream_close(file);
+        nlr_jump(nlr.ret_val);
+    }
 }
 
 #else
 #error mp_raw_code_save_file not implemented for this platform
 #endif
 
+void mp_raw_code_save_file(mp_raw_code_t *rc, const char *filename) {
+    mp_raw_code_save_file_with_header(rc, filename, NULL, 0);
+}
+
 #endif // MICROPY_PERSISTENT_CODE_SAVE
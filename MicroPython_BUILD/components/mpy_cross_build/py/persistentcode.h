@@ -30,11 +30,22 @@
 #include "py/reader.h"
 #include "py/emitglue.h"
 
+// The native architecture of the machine code stored in a .mpy file
+#define MP_NATIVE_ARCH_NONE         (0)
+#define MP_NATIVE_ARCH_X86          (1)
+#define MP_NATIVE_ARCH_X64          (2)
+#define MP_NATIVE_ARCH_ARM          (3)
+#define MP_NATIVE_ARCH_THUMB        (4)
+#define MP_NATIVE_ARCH_XTENSA       (5)
+#define MP_NATIVE_ARCH_XTENSAWIN    (6)
+
 mp_raw_code_t *mp_raw_code_load(mp_reader_t *reader);
 mp_raw_code_t *mp_raw_code_load_mem(const byte *buf, size_t len);
 mp_raw_code_t *mp_raw_code_load_file(const char *filename);
 
 void mp_raw_code_save(mp_raw_code_t *rc, mp_print_t *print);
 void mp_raw_code_save_file(mp_raw_code_t *rc, const char *filename);
+// the header bytes are written to the file in front of the .mpy data
+void mp_raw_code_save_file_with_header(mp_raw_code_t *rc, const char *filename, const byte *header, size_t header_len);
 
 #endif // MICROPY_INCLUDED_PY_PERSISTENTCODE_H
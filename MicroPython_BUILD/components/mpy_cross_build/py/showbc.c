@@ -310,6 +310,18 @@ const byte *mp_bytecode_print_str(const byte *ip) {
             printf("DELETE_GLOBAL %s", qstr_str(qst));
             break;
 
+        case MP_BC_LOAD_FAST_ATTR:
+            DECODE_QSTR;
+            printf("LOAD_FAST_ATTR %u %s", *ip++, qstr_str(qst));
+            break;
+
+        case MP_BC_LOAD_FAST_CONST_BINARY_OP: {
+            mp_uint_t op = ip[2];
+            printf("LOAD_FAST_CONST_BINARY_OP %u %d " UINT_FMT " %s", ip[0], (int8_t)ip[1], op, qstr_str(mp_binary_op_method_name[op]));
+            ip += 3;
+            break;
+        }
+
         case MP_BC_DUP_TOP:
             printf("DUP_TOP");
             break;
@@ -345,6 +357,16 @@ const byte *mp_bytecode_print_str(const byte *ip) {
             printf("POP_JUMP_IF_FALSE " UINT_FMT, (mp_uint_t)(ip + unum - mp_showbc_code_start));
             break;
 
+        case MP_BC_BINARY_OP_POP_JUMP_IF_TRUE:
+        case MP_BC_BINARY_OP_POP_JUMP_IF_FALSE: {
+            DECODE_SLABEL;
+            mp_uint_t op = *ip++;
+            printf("BINARY_OP_POP_JUMP_IF_%s " UINT_FMT " " UINT_FMT " %s",
+                ip[-4] == MP_BC_BINARY_OP_POP_JUMP_IF_TRUE ? "TRUE" : "FALSE",
+                (mp_uint_t)(ip + unum - mp_showbc_code_start), op, qstr_str(mp_binary_op_method_name[op]));
+            break;
+        }
+
         case MP_BC_JUMP_IF_TRUE_OR_POP:
             DECODE_SLABEL;
             printf("JUMP_IF_TRUE_OR_POP " UINT_FMT, (mp_uint_t)(ip + unum - mp_showbc_code_start));
@@ -33,6 +33,7 @@
 #include "py/objtype.h"
 #include "py/runtime.h"
 #include "py/bc0.h"
+#include "py/smallint.h"
 #include "py/bc.h"
 
 #if 0
@@ -118,6 +119,35 @@ typedef enum {
     exc_sp--; /* pop back to previous exception handler */ \
     CLEAR_SYS_EXC_INFO() /* just clear sys.exc_info(), not compliant, but it shouldn't be used in 1st place */
 
+// Fast path of the superinstructions which have a binary op with both operands
+// small ints.  Returns MP_OBJ_NULL if the op has to go through mp_binary_op.
+STATIC inline mp_obj_t vm_small_int_binary_op(mp_binary_op_t op, mp_int_t lhs, mp_int_t rhs) {
+    switch (op) {
+        case MP_BINARY_OP_LESS: return mp_obj_new_bool(lhs < rhs);
+        case MP_BINARY_OP_MORE: return mp_obj_new_bool(lhs > rhs);
+        case MP_BINARY_OP_EQUAL: return mp_obj_new_bool(lhs == rhs);
+        case MP_BINARY_OP_LESS_EQUAL: return mp_obj_new_bool(lhs <= rhs);
+        case MP_BINARY_OP_MORE_EQUAL: return mp_obj_new_bool(lhs >= rhs);
+        case MP_BINARY_OP_NOT_EQUAL: return mp_obj_new_bool(lhs != rhs);
+        case MP_BINARY_OP_OR:
+        case MP_BINARY_OP_INPLACE_OR: return MP_OBJ_NEW_SMALL_INT(lhs | rhs);
+        case MP_BINARY_OP_XOR:
+        case MP_BINARY_OP_INPLACE_XOR: return MP_OBJ_NEW_SMALL_INT(lhs ^ rhs);
+        case MP_BINARY_OP_AND:
+        case MP_BINARY_OP_INPLACE_AND: return MP_OBJ_NEW_SMALL_INT(lhs & rhs);
+        case MP_BINARY_OP_ADD:
+        case MP_BINARY_OP_INPLACE_ADD: lhs += rhs; break;
+        case MP_BINARY_OP_SUBTRACT:
+        case MP_BINARY_OP_INPLACE_SUBTRACT: lhs -= rhs; break;
+        default: return MP_OBJ_NULL;
+    }
+    // sum or difference of two small ints can't overflow mp_int_t
+    if (MP_SMALL_INT_FITS(lhs)) {
+        return MP_OBJ_NEW_SMALL_INT(lhs);
+    }
+    return MP_OBJ_NULL;
+}
+
 // fastn has items in reverse order (fastn[0] is local[0], fastn[-1] is local[1], etc)
 // sp points to bottom of stack which grows up
 // returns:
@@ -370,6 +400,37 @@ dispatch_loop:
                 }
                 #endif
 
+                ENTRY(MP_BC_LOAD_FAST_ATTR): {
+                    MARK_EXC_IP_SELECTIVE();
+                    DECODE_QSTR;
+                    obj_shared = fastn[-(mp_int_t)*ip++];
+                    if (obj_shared == MP_OBJ_NULL) {
+                        goto local_name_error;
+                    }
+                    PUSH(mp_load_attr(obj_shared, qst));
+                    DISPATCH();
+                }
+
+                ENTRY(MP_BC_LOAD_FAST_CONST_BINARY_OP): {
+                    MARK_EXC_IP_SELECTIVE();
+                    obj_shared = fastn[-(mp_int_t)ip[0]];
+                    mp_int_t rhs = (int8_t)ip[1];
+                    mp_binary_op_t op = ip[2];
+                    ip += 3;
+                    if (obj_shared == MP_OBJ_NULL) {
+                        goto local_name_error;
+                    }
+                    mp_obj_t res = MP_OBJ_NULL;
+                    if (MP_OBJ_IS_SMALL_INT(obj_shared)) {
+                        res = vm_small_int_binary_op(op, MP_OBJ_SMALL_INT_VALUE(obj_shared), rhs);
+                    }
+                    if (res == MP_OBJ_NULL) {
+                        res = mp_binary_op(op, obj_shared, MP_OBJ_NEW_SMALL_INT(rhs));
+                    }
+                    PUSH(res);
+                    DISPATCH();
+                }
+
                 ENTRY(MP_BC_LOAD_METHOD): {
                     MARK_EXC_IP_SELECTIVE();
                     DECODE_QSTR;
@@ -563,6 +624,27 @@ dispatch_loop:
                     DISPATCH_WITH_PEND_EXC_CHECK();
                 }
 
+                ENTRY(MP_BC_BINARY_OP_POP_JUMP_IF_TRUE):
+                ENTRY(MP_BC_BINARY_OP_POP_JUMP_IF_FALSE): {
+                    MARK_EXC_IP_SELECTIVE();
+                    bool jump_if = (ip[-1] == MP_BC_BINARY_OP_POP_JUMP_IF_TRUE);
+                    DECODE_SLABEL;
+                    mp_binary_op_t op = *ip++;
+                    mp_obj_t rhs = POP();
+                    mp_obj_t lhs = POP();
+                    mp_obj_t res = MP_OBJ_NULL;
+                    if (MP_OBJ_IS_SMALL_INT(lhs) && MP_OBJ_IS_SMALL_INT(rhs)) {
+                        res = vm_small_int_binary_op(op, MP_OBJ_SMALL_INT_VALUE(lhs), MP_OBJ_SMALL_INT_VALUE(rhs));
+                    }
+                    if (res == MP_OBJ_NULL) {
+                        res = mp_binary_op(op, lhs, rhs);
+                    }
+                    if (mp_obj_is_true(res) == jump_if) {
+                        ip += slab;
+                    }
+                    DISPATCH_WITH_PEND_EXC_CHECK();
+                }
+
                 ENTRY(MP_BC_JUMP_IF_TRUE_OR_POP): {
                     DECODE_SLABEL;
                     if (mp_obj_is_true(TOP())) {